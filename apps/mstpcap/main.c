@@ -135,6 +135,57 @@ struct mstp_statistics {
 static struct mstp_statistics MSTP_Statistics[MAX_MSTP_DEVICES];
 static uint32_t Invalid_Frame_Count;
 
+/* streaming analysis of the token loop, enabled with --analyze */
+#define MSTP_HISTOGRAM_BINS 11
+/* upper limit of each histogram bin in milliseconds; last bin is open */
+static const uint32_t MSTP_Histogram_Limit[MSTP_HISTOGRAM_BINS - 1] = { 1, 2,
+    5, 10, 20, 50, 100, 200, 500, 1000 };
+/* Tno_token: silence after which the token is considered lost */
+#define MSTP_ANALYSIS_TNO_TOKEN_MS 500
+
+struct mstp_histogram {
+    uint32_t bin[MSTP_HISTOGRAM_BINS];
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t total_us;
+};
+
+struct mstp_analysis {
+    /* time the node last received the token */
+    struct timeval token_tv;
+    bool token_held;
+    bool token_seen;
+    /* time between receiving the token and passing it on */
+    struct mstp_histogram hold;
+    /* time between successive tokens received by the node */
+    struct mstp_histogram rotation;
+    /* time for the node to answer a Data-Expecting-Reply */
+    struct mstp_histogram reply;
+    /* Data-Expecting-Reply frames to the node that got no answer */
+    uint32_t der_unanswered;
+};
+
+static bool Analysis_Enabled;
+static long Analysis_Baud = 38400;
+static struct mstp_analysis MSTP_Analysis[MAX_MSTP_DEVICES];
+static struct mstp_histogram Rotation_Histogram;
+static struct mstp_histogram Reply_Histogram;
+static struct {
+    struct timeval first_tv;
+    struct timeval last_tv;
+    uint32_t frames;
+    /* time the wire carried octets */
+    uint64_t busy_us;
+    /* time from each PFM until the next frame */
+    uint64_t pfm_us;
+    uint32_t token_retries;
+    uint32_t lost_token;
+    uint8_t last_frame;
+    uint8_t last_src;
+    uint8_t last_dst;
+    bool der_pending;
+} Bus_Analysis;
+
 static uint32_t timeval_diff_ms(struct timeval *old, struct timeval *now)
 {
     uint32_t ms = 0;
@@ -146,6 +197,219 @@ static uint32_t timeval_diff_ms(struct timeval *old, struct timeval *now)
     return ms;
 }
 
+static uint32_t timeval_diff_us(struct timeval *old, struct timeval *now)
+{
+    int64_t us = 0;
+
+    us = ((int64_t)now->tv_sec - (int64_t)old->tv_sec) * 1000000 +
+        ((int64_t)now->tv_usec - (int64_t)old->tv_usec);
+    if (us < 0) {
+        us = 0;
+    } else if (us > UINT32_MAX) {
+        us = UINT32_MAX;
+    }
+
+    return (uint32_t)us;
+}
+
+static void histogram_add(struct mstp_histogram *histogram, uint32_t us)
+{
+    unsigned i;
+
+    for (i = 0; i < (MSTP_HISTOGRAM_BINS - 1); i++) {
+        if (us < (MSTP_Histogram_Limit[i] * 1000UL)) {
+            break;
+        }
+    }
+    histogram->bin[i]++;
+    histogram->count++;
+    histogram->total_us += us;
+    if (us > histogram->max_us) {
+        histogram->max_us = us;
+    }
+}
+
+static unsigned long histogram_average_ms(struct mstp_histogram *histogram)
+{
+    if (histogram->count == 0) {
+        return 0;
+    }
+
+    return (unsigned long)((histogram->total_us / histogram->count) / 1000);
+}
+
+static void
+histogram_print(const char *title, struct mstp_histogram *histogram)
+{
+    unsigned i;
+    char label[24];
+
+    fprintf(stdout, "%s (%lu samples, avg %lums, max %lums)\n", title,
+        (unsigned long)histogram->count, histogram_average_ms(histogram),
+        (unsigned long)(histogram->max_us / 1000));
+    for (i = 0; i < MSTP_HISTOGRAM_BINS; i++) {
+        if (i == 0) {
+            snprintf(label, sizeof(label), "<%lums",
+                (unsigned long)MSTP_Histogram_Limit[i]);
+        } else if (i < (MSTP_HISTOGRAM_BINS - 1)) {
+            snprintf(label, sizeof(label), "%lu-%lums",
+                (unsigned long)MSTP_Histogram_Limit[i - 1],
+                (unsigned long)MSTP_Histogram_Limit[i]);
+        } else {
+            snprintf(label, sizeof(label), ">=%lums",
+                (unsigned long)MSTP_Histogram_Limit[i - 1]);
+        }
+        fprintf(
+            stdout, "  %-12s%lu\n", label, (unsigned long)histogram->bin[i]);
+    }
+}
+
+/* time on the wire for a frame: 10 bits per octet */
+static uint32_t frame_wire_time_us(uint16_t data_len)
+{
+    uint32_t octets = 8;
+
+    if (data_len) {
+        octets += data_len + 2;
+    }
+    if (Analysis_Baud <= 0) {
+        return 0;
+    }
+
+    return (uint32_t)(((uint64_t)octets * 10 * 1000000) / Analysis_Baud);
+}
+
+static void packet_analysis(
+    struct timeval *tv, volatile struct mstp_port_struct_t *mstp_port)
+{
+    uint8_t frame, src, dst;
+    uint32_t delta;
+
+    dst = mstp_port->DestinationAddress;
+    src = mstp_port->SourceAddress;
+    frame = mstp_port->FrameType;
+    if (Bus_Analysis.frames == 0) {
+        Bus_Analysis.first_tv = *tv;
+        Bus_Analysis.last_tv = *tv;
+        Bus_Analysis.last_frame = FRAME_TYPE_PROPRIETARY_MAX;
+    }
+    delta = timeval_diff_us(&Bus_Analysis.last_tv, tv);
+    Bus_Analysis.frames++;
+    Bus_Analysis.busy_us += frame_wire_time_us(mstp_port->DataLength);
+    if ((Bus_Analysis.frames > 1) &&
+        (delta >= (MSTP_ANALYSIS_TNO_TOKEN_MS * 1000UL))) {
+        /* silence long enough for the masters to regenerate the token */
+        Bus_Analysis.lost_token++;
+        for (src = 0; src < (MAX_MSTP_DEVICES - 1); src++) {
+            MSTP_Analysis[src].token_held = false;
+            MSTP_Analysis[src].token_seen = false;
+        }
+        src = mstp_port->SourceAddress;
+    }
+    if (Bus_Analysis.last_frame == FRAME_TYPE_POLL_FOR_MASTER) {
+        Bus_Analysis.pfm_us += delta;
+    }
+    if (Bus_Analysis.der_pending) {
+        Bus_Analysis.der_pending = false;
+        if ((src == Bus_Analysis.last_dst) &&
+            ((frame == FRAME_TYPE_BACNET_DATA_NOT_EXPECTING_REPLY) ||
+                (frame == FRAME_TYPE_REPLY_POSTPONED) ||
+                (frame == FRAME_TYPE_TEST_RESPONSE))) {
+            histogram_add(&MSTP_Analysis[src].reply, delta);
+            histogram_add(&Reply_Histogram, delta);
+        } else {
+            MSTP_Analysis[Bus_Analysis.last_dst].der_unanswered++;
+        }
+    }
+    switch (frame) {
+        case FRAME_TYPE_TOKEN:
+            if ((Bus_Analysis.last_frame == FRAME_TYPE_TOKEN) &&
+                (Bus_Analysis.last_src == src) &&
+                (Bus_Analysis.last_dst == dst)) {
+                /* repeated token - the first was not used */
+                Bus_Analysis.token_retries++;
+                break;
+            }
+            if (MSTP_Analysis[src].token_held) {
+                delta = timeval_diff_us(&MSTP_Analysis[src].token_tv, tv);
+                histogram_add(&MSTP_Analysis[src].hold, delta);
+                MSTP_Analysis[src].token_held = false;
+            }
+            if (MSTP_Analysis[dst].token_seen) {
+                delta = timeval_diff_us(&MSTP_Analysis[dst].token_tv, tv);
+                histogram_add(&MSTP_Analysis[dst].rotation, delta);
+                histogram_add(&Rotation_Histogram, delta);
+            }
+            MSTP_Analysis[dst].token_tv = *tv;
+            MSTP_Analysis[dst].token_held = true;
+            MSTP_Analysis[dst].token_seen = true;
+            break;
+        case FRAME_TYPE_BACNET_DATA_EXPECTING_REPLY:
+        case FRAME_TYPE_TEST_REQUEST:
+            if (dst != MSTP_BROADCAST_ADDRESS) {
+                Bus_Analysis.der_pending = true;
+            }
+            break;
+        default:
+            break;
+    }
+    Bus_Analysis.last_tv = *tv;
+    Bus_Analysis.last_frame = frame;
+    Bus_Analysis.last_src = src;
+    Bus_Analysis.last_dst = dst;
+}
+
+static void packet_analysis_print(void)
+{
+    unsigned i;
+    uint32_t duration_us;
+    struct mstp_analysis *node;
+
+    if (Bus_Analysis.frames == 0) {
+        return;
+    }
+    duration_us =
+        timeval_diff_us(&Bus_Analysis.first_tv, &Bus_Analysis.last_tv);
+    fprintf(stdout, "\n");
+    fprintf(stdout, "==== MS/TP Token Loop Analysis ====\n");
+    fprintf(stdout, "%-6s%-10s%-10s%-10s%-10s%-10s%-10s%-8s\n", "MAC",
+        "HoldAvg", "HoldMax", "RotAvg", "RotMax", "ReplyAvg", "ReplyMax",
+        "NoReply");
+    for (i = 0; i < MAX_MSTP_DEVICES; i++) {
+        node = &MSTP_Analysis[i];
+        if ((node->hold.count == 0) && (node->reply.count == 0) &&
+            (node->der_unanswered == 0)) {
+            continue;
+        }
+        fprintf(stdout, "%-6u%-10lu%-10lu%-10lu%-10lu%-10lu%-10lu%-8lu\n", i,
+            histogram_average_ms(&node->hold),
+            (unsigned long)(node->hold.max_us / 1000),
+            histogram_average_ms(&node->rotation),
+            (unsigned long)(node->rotation.max_us / 1000),
+            histogram_average_ms(&node->reply),
+            (unsigned long)(node->reply.max_us / 1000),
+            (unsigned long)node->der_unanswered);
+    }
+    fprintf(stdout, "(times in milliseconds)\n\n");
+    histogram_print("Token Rotation Time", &Rotation_Histogram);
+    histogram_print("Data-Expecting-Reply Latency", &Reply_Histogram);
+    fprintf(stdout, "\n");
+    fprintf(stdout, "Duration: %lu.%03lus at %ld bps, %lu frames\n",
+        (unsigned long)(duration_us / 1000000),
+        (unsigned long)((duration_us / 1000) % 1000), Analysis_Baud,
+        (unsigned long)Bus_Analysis.frames);
+    if (duration_us) {
+        fprintf(stdout, "Bus Utilization: %.1f%%\n",
+            (100.0 * (double)Bus_Analysis.busy_us) / (double)duration_us);
+        fprintf(stdout, "PFM Overhead: %.1f%%\n",
+            (100.0 * (double)Bus_Analysis.pfm_us) / (double)duration_us);
+    }
+    fprintf(stdout, "Token Retries: %lu\n",
+        (unsigned long)Bus_Analysis.token_retries);
+    fprintf(stdout, "Lost Token Events: %lu\n",
+        (unsigned long)Bus_Analysis.lost_token);
+}
+
 static void mstp_monitor_i_am(uint8_t mac, uint8_t *pdu, uint16_t pdu_len)
 {
     BACNET_ADDRESS src = { 0 };
@@ -196,6 +460,9 @@ static void packet_statistics(
     uint32_t delta;
     uint32_t npoll;
 
+    if (Analysis_Enabled) {
+        packet_analysis(tv, mstp_port);
+    }
     dst = mstp_port->DestinationAddress;
     src = mstp_port->SourceAddress;
     frame = mstp_port->FrameType;
@@ -386,6 +653,9 @@ static void packet_statistics_print(void)
     fprintf(stdout, "Node Count: %u\n", node_count);
     fprintf(stdout, "Invalid Frame Count: %lu\n",
         (long unsigned int)Invalid_Frame_Count);
+    if (Analysis_Enabled) {
+        packet_analysis_print();
+    }
 }
 
 static void packet_statistics_clear(void)
@@ -397,6 +667,10 @@ static void packet_statistics_clear(void)
         MSTP_Statistics[i].device_id = 0xFFFFFFFF;
     }
     Invalid_Frame_Count = 0;
+    memset(&MSTP_Analysis[0], 0, sizeof(MSTP_Analysis));
+    memset(&Rotation_Histogram, 0, sizeof(Rotation_Histogram));
+    memset(&Reply_Histogram, 0, sizeof(Reply_Histogram));
+    memset(&Bus_Analysis, 0, sizeof(Bus_Analysis));
 }
 
 static uint32_t Timer_Silence(void *pArg)
@@ -674,6 +948,8 @@ static bool test_global_header(const char *filename)
     /* open existing file. */
     pFile = fopen(filename, "rb");
     if (pFile) {
+        /* large reads - the file is processed sequentially */
+        (void)setvbuf(pFile, NULL, _IOFBF, 1UL << 20);
         count = fread(&magic_number, sizeof(magic_number), 1, pFile);
         if ((count != 1) || (magic_number != 0xa1b2c3d4)) {
             fprintf(stderr, "mstpcap: invalid magic number\n");
@@ -917,7 +1193,7 @@ static void filename_create_new(void)
 static void print_usage(char *filename)
 {
     printf("Usage: %s", filename);
-    printf(" [--scan <filename>]\n");
+    printf(" [--analyze][--scan <filename>]\n");
     printf(" [--extcap-interface port]\n");
     printf(" [--extcap-interfaces][--extcap-dlts][--extcap-config]\n");
     printf(" [--capture][--baud baud][--fifo pipe]\n");
@@ -930,6 +1206,12 @@ static void print_help(char *filename)
            "perform statistic analysis on MS/TP capture file.\n",
         filename);
     printf("\n");
+    printf("--analyze\n"
+           "also report token hold and rotation times, reply latency,\n"
+           "PFM overhead, bus utilization, retries and lost tokens,\n"
+           "for a capture file or while capturing. Uses --baud to\n"
+           "compute the time on the wire.\n");
+    printf("\n");
     printf("Captures MS/TP packets from a serial interface\n"
            "and saves them to a file. Saves packets in a\n"
            "filename mstp_20090123091200.cap that has data and time.\n"
@@ -987,6 +1269,7 @@ int main(int argc, char *argv[])
     uint32_t header_len = 0;
     int argi = 0;
     char *filename = NULL;
+    char *scan_filename = NULL;
 
     MSTP_Port.InputBuffer = &RxBuffer[0];
     MSTP_Port.InputBufferSize = sizeof(RxBuffer);
@@ -1024,21 +1307,11 @@ int main(int argc, char *argv[])
                 printf("An file name must be provided.\n");
                 return 1;
             }
-            printf("Scanning %s\n", argv[argi]);
-            /* perform statistics on the file */
-            if (test_global_header(argv[argi])) {
-                while (read_received_packet(mstp_port)) {
-                    packet_count++;
-                    fprintf(stderr, "\r%u packets", (unsigned)packet_count);
-                }
-                if (packet_count) {
-                    packet_statistics_print();
-                }
-                Exit_Requested = true;
-            } else {
-                fprintf(stderr, "File header does not match.\n");
-                return 1;
-            }
+            /* scanned once all the options are known */
+            scan_filename = argv[argi];
+        }
+        if (strcmp(argv[argi], "--analyze") == 0) {
+            Analysis_Enabled = true;
         }
         if (strcmp(argv[argi], "--extcap-interfaces") == 0) {
             RS485_Print_Ports();
@@ -1092,6 +1365,7 @@ int main(int argc, char *argv[])
                 argi++;
                 my_baud = strtol(argv[argi], NULL, 0);
                 RS485_Set_Baud_Rate(my_baud);
+                Analysis_Baud = my_baud;
             }
         }
 #else
@@ -1102,6 +1376,7 @@ int main(int argc, char *argv[])
                 argi++;
                 my_baud = strtol(argv[argi], NULL, 0);
                 RS485_Set_Baud_Rate(my_baud);
+                Analysis_Baud = my_baud;
             }
         }
 #endif
@@ -1113,6 +1388,7 @@ int main(int argc, char *argv[])
             }
             my_baud = strtol(argv[argi], NULL, 0);
             RS485_Set_Baud_Rate(my_baud);
+            Analysis_Baud = my_baud;
         }
         if (strcmp(argv[argi], "--fifo") == 0) {
             argi++;
@@ -1123,6 +1399,26 @@ int main(int argc, char *argv[])
             named_pipe_create(argv[argi]);
         }
     }
+    if (scan_filename) {
+        printf("Scanning %s\n", scan_filename);
+        /* perform statistics on the file */
+        if (test_global_header(scan_filename)) {
+            while (read_received_packet(mstp_port)) {
+                packet_count++;
+                if (!(packet_count % 10000)) {
+                    fprintf(stderr, "\r%u packets", (unsigned)packet_count);
+                }
+            }
+            fprintf(stderr, "\r%u packets", (unsigned)packet_count);
+            if (packet_count) {
+                packet_statistics_print();
+            }
+            Exit_Requested = true;
+        } else {
+            fprintf(stderr, "File header does not match.\n");
+            return 1;
+        }
+    }
     if (Exit_Requested) {
         return 0;
     }
@@ -518,6 +518,119 @@ sub WriteProperty {
     return ($answer, $isFailure);
 }
 
+=head2 Batch
+
+This function sends a batch of reads and writes to any number of devices at
+once. The requests to each device are grouped into ReadPropertyMultiple and
+WritePropertyMultiple requests, and several requests are kept in flight to each
+device. A device that does not accept a grouped request is sent ReadProperty or
+WriteProperty for each of its properties. There are no built in retry
+mechanisms. NOTE: all enumerations are defined in F<bacenum.h>
+
+=head3 Inputs to Batch
+
+=begin html
+<ul>
+  <li><b>r_answerList</b>   - reference to a list where to store the answers</li>
+  <li><b>list</b>           - a list of requests, in any order, each one a reference to a list of</li>
+  <ul>
+    <li><b>deviceInstance</b> - the instance number of the device</li>
+    <li><b>objectName</b>     - the enumeration for the object name</li>
+    <li><b>objectInstance</b> - the instance number of the object</li>
+    <li><b>propertyName</b>   - the enumeration for the property name</li>
+    <li><b>index</b>          - the index number. Use -1 if not applicable</li>
+    <li><b>tagName</b>        - Writes only: the enumeration for the type of value we are writing. To specify context tags, prepend the tag name with "Cn:" where 'n' is the context number.</li>
+    <li><b>value</b>          - Writes only: the value we are writing</li>
+    <li><b>priority</b>       - Writes only, optional (default 0): the priority within Priority Array to write at, 0 to not specify priority.</li>
+  </ul>
+</ul>
+
+=end html
+
+=head3 Outputs from Batch
+
+=begin html
+<ul>
+  <li><b>isFailure</b> - the number of requests that failed. The answer to each request is stored in r_answerList, in the order of the requests, as a reference to a list of the string result (value or error) and isFailure for that request</li>
+</ul>
+
+=end html
+
+=head3 Example of Batch
+
+The following example will read AV0.PresentValue from devices 1234 and 1235,
+and write 1.0 to AV1.PresentValue at priority 8 in device 1234
+
+    my @requests = ();
+    my @answers = ();
+    push @requests, [1234, 'OBJECT_ANALOG_VALUE', 0, 'PROP_PRESENT_VALUE', -1];
+    push @requests, [1235, 'OBJECT_ANALOG_VALUE', 0, 'PROP_PRESENT_VALUE', -1];
+    push @requests, [1234, 'OBJECT_ANALOG_VALUE', 1, 'PROP_PRESENT_VALUE', -1, 'BACNET_APPLICATION_TAG_REAL', 1.0, 8];
+    my $failed = Batch(\@answers, @requests);
+    my ($res, $isFailure) = @{$answers[0]};
+
+=cut
+
+sub Batch
+{
+    my $r_answerList = shift;
+    my @list = @ARG;
+    my @modifiedList = ();
+    my $isFailure = 0;
+
+    foreach my $r_req (@list)
+    {
+        my @tmpList = ();
+        push @tmpList, $$r_req[$_] for (0 .. 4);
+        (undef, $tmpList[1]) = LookupEnumValue('BACNET_OBJECT_TYPE', $$r_req[1]);
+        (undef, $tmpList[3]) = LookupEnumValue('BACNET_PROPERTY_ID', $$r_req[3]);
+        $tmpList[4] = -1 unless defined($tmpList[4]);
+        if (defined($$r_req[5]))
+        {
+            my $tagName = $$r_req[5];
+            my $tagValue = '';
+            if ($tagName =~ /^(C\d+):(.*)$/)
+            {
+                $tagName = $2;
+                $tagValue = "$1 ";
+            }
+            my (undef, $tagNewValue) = LookupEnumValue('BACNET_APPLICATION_TAG', $tagName);
+            $tagValue .= $tagNewValue;
+
+            # a priority of 0 means we are not writing to a priority array
+            push @tmpList, (defined($$r_req[7]) ? $$r_req[7] : 0);
+            push @tmpList, $tagValue, $$r_req[6];
+        }
+        push @modifiedList, \@tmpList;
+    }
+
+    Log("Batch of " . scalar(@list) . " requests:");
+    $logIndent += 4;
+
+    @{$r_answerList} = ();
+    my $i = 0;
+    foreach my $r_result (@{BacnetBatch(\@modifiedList)})
+    {
+        my ($failed, $result) = @{$r_result};
+        my $r_req = $list[$i++];
+        my ($objectPrintName, undef) = LookupEnumValue('BACNET_OBJECT_TYPE', $$r_req[1]);
+        my ($propertyPrintName, undef) = LookupEnumValue('BACNET_PROPERTY_ID', $$r_req[3]);
+        my $msg = 'Device[' . $$r_req[0] . "].$objectPrintName" . '[' . $$r_req[2] . "].$propertyPrintName";
+        if (defined($$r_req[4]) && ($$r_req[4] != -1))
+        {
+            $msg .= '[' . $$r_req[4] . ']';
+        }
+        $msg .= $failed ? " ==> Problem: $result" : " ==> $result";
+        Log($msg);
+        push @{$r_answerList}, [$result, $failed];
+        $isFailure++ if $failed;
+    }
+
+    $logIndent -= 4;
+
+    return $isFailure;
+}
+
 =head2 TimeSync
 
 This function implements the TimeSync and UTCTimeSync services
@@ -0,0 +1,58 @@
+use warnings;
+use strict;
+
+my (
+    @devices,    # device instance numbers
+    $objectName, # object type name
+    $count,      # number of objects in each device
+    $propName,   # property name
+);
+
+GetOptions(
+    'device=i'   => \@devices,
+    'objName=s'  => \$objectName,
+    'count=i'    => \$count,
+    'property=s' => \$propName,
+);
+
+Help() unless ( @devices             &&
+                defined($objectName) &&
+                defined($count)      &&
+                defined($propName)
+);
+
+my @requests = ();
+my @answers = ();
+foreach my $device (@devices)
+{
+    push @requests, [$device, $objectName, $_, $propName, -1] for (0 .. $count - 1);
+}
+my $failed = Batch(\@answers, @requests);
+print "read " . scalar(@requests) . " properties and $failed failed\n";
+
+sub Help {
+    print <<END;
+
+This script demonstrates reading many properties from many devices at once
+using the Batch function of the Perl bindings. To run this script, you must
+specify the following arguments to it:
+  * device   This is a device instance number (i.e. 1234). Give it once for
+             each device to read from
+  * objName  This is the object type name (i.e. OBJECT_ANALOG_VALUE). See
+             include/bacenum.h for complete list
+  * count    This is the number of objects to read in each device, starting
+             from instance 0
+  * property This is the name of the property you want to read (i.e.
+             PROP_PRESENT_VALUE). See include/bacenum.h for complete list
+
+  As a complete example, to run this script using the main bacnet tool to read
+  the PresentValue of AnalogValue0 to AnalogValue99 from devices 1234 and 1235,
+  use
+
+perl bacnet.pl --script example_batch.pl -- --device=1234 --device=1235 --objName=OBJECT_ANALOG_VALUE --count=100 --property=PROP_PRESENT_VALUE
+
+END
+    exit 1;
+}
+
+1;
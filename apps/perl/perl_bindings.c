@@ -5,6 +5,8 @@
 #include "bacnet/basic/object/device.h"
 #include <time.h>
 #include "bacnet/arf.h"
+#include "bacnet/bactext.h"
+#include "bacnet/basic/sys/mstimer.h"
 
 /* Free is redefined as a macro, but Perl does not like that. */
 #undef free
@@ -478,6 +480,7 @@ void BacnetPrepareComm()
     address_init();
     Init_Service_Handlers();
     dlenv_init();
+    mstimer_init();
 }
 
 /****************************************************/
@@ -665,6 +668,41 @@ int BacnetReadPropertyMultiple(int deviceInstanceNumber, ...)
     return isFailure;
 }
 
+/****************************************************/
+/* Parse the tag/value pair of a write. If it fails, return false and */
+/* give the reason in msg */
+/****************************************************/
+static bool Parse_Tag_Value(const char *tag,
+    const char *value,
+    BACNET_APPLICATION_DATA_VALUE *propertyValue,
+    char *msg)
+{
+    uint8_t context_tag = 0;
+    BACNET_APPLICATION_TAG property_tag;
+
+    if (toupper(tag[0]) == 'C') {
+        context_tag = strtol(&tag[1], NULL, 0);
+        propertyValue->context_tag = context_tag;
+        propertyValue->context_specific = true;
+    } else {
+        propertyValue->context_specific = false;
+    }
+    property_tag = strtol(tag, NULL, 0);
+
+    if (property_tag >= MAX_BACNET_APPLICATION_TAG) {
+        sprintf(msg, "Error: tag=%u - it must be less than %u", property_tag,
+            MAX_BACNET_APPLICATION_TAG);
+        return false;
+    }
+    if (!bacapp_parse_application_data(property_tag, value, propertyValue)) {
+        sprintf(msg, "Error: unable to parse the tag value");
+        return false;
+    }
+    propertyValue->next = NULL;
+
+    return true;
+}
+
 /****************************************************/
 /* This is the interface to WriteProperty */
 /****************************************************/
@@ -699,32 +737,12 @@ int BacnetWriteProperty(int deviceInstanceNumber,
     /* Loop for eary exit; */
     do {
         /* Handle the tag/value pair */
-        uint8_t context_tag = 0;
-        BACNET_APPLICATION_TAG property_tag;
         BACNET_APPLICATION_DATA_VALUE propertyValue;
 
-        if (toupper(tag[0]) == 'C') {
-            context_tag = strtol(&tag[1], NULL, 0);
-            propertyValue.context_tag = context_tag;
-            propertyValue.context_specific = true;
-        } else {
-            propertyValue.context_specific = false;
-        }
-        property_tag = strtol(tag, NULL, 0);
-
-        if (property_tag >= MAX_BACNET_APPLICATION_TAG) {
-            sprintf(msg, "Error: tag=%u - it must be less than %u",
-                property_tag, MAX_BACNET_APPLICATION_TAG);
+        if (!Parse_Tag_Value(tag, value, &propertyValue, msg)) {
             LogError(msg);
             break;
         }
-        if (!bacapp_parse_application_data(
-                property_tag, value, &propertyValue)) {
-            sprintf(msg, "Error: unable to parse the tag value");
-            LogError(msg);
-            break;
-        }
-        propertyValue.next = NULL;
 
         /* Send out the message */
         Request_Invoke_ID = Send_Write_Property_Request(deviceInstanceNumber,
@@ -931,3 +949,721 @@ int BacnetAtomicReadFile(int deviceInstanceNumber,
     Error_Detected = 0;
     return isFailure;
 }
+
+/****************************************************/
+/* This is the interface to batches of reads and writes. The requests */
+/* to each device are grouped into ReadPropertyMultiple and */
+/* WritePropertyMultiple requests that fill the APDU of the device, and */
+/* several requests are kept in flight to each device at once. A request */
+/* that the device rejects is sent again one property at a time. */
+/****************************************************/
+/* requests kept in flight to each device */
+#ifndef BATCH_WINDOW
+#define BATCH_WINDOW 8
+#endif
+/* octets expected in a ReadPropertyMultiple-ACK for each property, */
+/* which limits the reads in one request so that the reply fits */
+#ifndef BATCH_READ_OCTETS
+#define BATCH_READ_OCTETS 20
+#endif
+/* time given to the devices to answer Who-Is */
+#ifndef BATCH_BIND_MS
+#define BATCH_BIND_MS 3000
+#endif
+
+typedef enum { batchPending, batchSent, batchDone } batchState;
+
+typedef struct batch_item {
+    uint32_t device_id;
+    BACNET_OBJECT_TYPE object_type;
+    uint32_t object_instance;
+    BACNET_PROPERTY_ID object_property;
+    BACNET_ARRAY_INDEX array_index;
+    /* the encoded value of a write, or NULL for a read */
+    uint8_t *application_data;
+    int application_data_len;
+    uint8_t priority;
+    /* send with ReadProperty or WriteProperty */
+    bool single;
+    batchState state;
+    bool failed;
+    char *answer;
+} BATCH_ITEM;
+
+struct batch_device;
+
+typedef struct batch_request {
+    struct batch_device *device;
+    uint8_t service;
+    /* the items of the request, in the item list of the device */
+    unsigned first;
+    unsigned count;
+    bool in_use;
+} BATCH_REQUEST;
+
+typedef struct batch_device {
+    uint32_t device_id;
+    BACNET_ADDRESS address;
+    unsigned max_apdu;
+    bool bound;
+    /* the items for this device, in the order given */
+    BATCH_ITEM **item;
+    unsigned item_count;
+    /* the items before this one are done */
+    unsigned next;
+    /* reads in one ReadPropertyMultiple */
+    unsigned read_limit;
+    BATCH_REQUEST request[BATCH_WINDOW];
+} BATCH_DEVICE;
+
+/* items that are not done */
+static unsigned Batch_Remaining;
+
+static void Batch_Item_Done(BATCH_ITEM *item, bool failed, const char *answer)
+{
+    item->answer = malloc(strlen(answer) + 1);
+    if (item->answer) {
+        strcpy(item->answer, answer);
+    }
+    item->failed = failed;
+    item->state = batchDone;
+    Batch_Remaining--;
+}
+
+/* Print a value, or a list of values in braces, as the answer */
+static void Batch_Answer_Value(char *answer,
+    size_t size,
+    BACNET_OBJECT_PROPERTY_VALUE *object_value,
+    BACNET_APPLICATION_DATA_VALUE *value)
+{
+    bool list = (value && value->next);
+    size_t len = 0;
+    int n;
+
+    if (list) {
+        answer[len++] = '{';
+    }
+    while (value && (len < (size - 2))) {
+        object_value->value = value;
+        n = bacapp_snprintf_value(&answer[len], size - len - 1, object_value);
+        if (n < 0) {
+            break;
+        }
+        len += n;
+        if (len > (size - 2)) {
+            len = size - 2;
+        }
+        value = value->next;
+        if (value && (len < (size - 2))) {
+            answer[len++] = ',';
+        }
+    }
+    if (list) {
+        answer[len++] = '}';
+    }
+    answer[len] = 0;
+}
+
+static void Batch_Answer_Free(BACNET_APPLICATION_DATA_VALUE *value)
+{
+    BACNET_APPLICATION_DATA_VALUE *old_value;
+
+    while (value) {
+        old_value = value;
+        value = value->next;
+        free(old_value);
+    }
+}
+
+static void Batch_Read_Property_Ack(
+    BATCH_ITEM *item, BACNET_TSM_COMPLETION *completion)
+{
+    BACNET_READ_PROPERTY_DATA data;
+    BACNET_OBJECT_PROPERTY_VALUE object_value;
+    BACNET_APPLICATION_DATA_VALUE *value_list = NULL;
+    BACNET_APPLICATION_DATA_VALUE **next_value = &value_list;
+    char answer[MAX_ACK_STRING];
+    uint8_t *application_data;
+    int application_data_len;
+    int len;
+
+    len = rp_ack_decode_service_request(
+        completion->service_data, completion->service_data_len, &data);
+    if (len <= 0) {
+        Batch_Item_Done(item, true, "ReadProperty Ack Malformed!");
+        return;
+    }
+    application_data = data.application_data;
+    application_data_len = data.application_data_len;
+    while (application_data_len > 0) {
+        *next_value = calloc(1, sizeof(BACNET_APPLICATION_DATA_VALUE));
+        if (!*next_value) {
+            break;
+        }
+        len = bacapp_decode_application_data(
+            application_data, (unsigned)application_data_len, *next_value);
+        if (len <= 0) {
+            free(*next_value);
+            *next_value = NULL;
+            break;
+        }
+        next_value = &(*next_value)->next;
+        application_data += len;
+        application_data_len -= len;
+    }
+    object_value.object_type = data.object_type;
+    object_value.object_instance = data.object_instance;
+    object_value.object_property = data.object_property;
+    object_value.array_index = data.array_index;
+    Batch_Answer_Value(answer, sizeof(answer), &object_value, value_list);
+    Batch_Answer_Free(value_list);
+    Batch_Item_Done(item, false, answer);
+}
+
+static void Batch_Read_Property_Multiple_Ack(
+    BATCH_REQUEST *request, BACNET_TSM_COMPLETION *completion)
+{
+    BATCH_ITEM **item = &request->device->item[request->first];
+    BACNET_READ_ACCESS_DATA *rpm_data;
+    BACNET_READ_ACCESS_DATA *rpm_object;
+    BACNET_PROPERTY_REFERENCE *rpm_property;
+    BACNET_OBJECT_PROPERTY_VALUE object_value;
+    char answer[MAX_ACK_STRING];
+    unsigned i = 0;
+    int len = 0;
+
+    rpm_data = calloc(1, sizeof(BACNET_READ_ACCESS_DATA));
+    if (rpm_data) {
+        len = rpm_ack_decode_service_request(
+            completion->service_data, completion->service_data_len, rpm_data);
+    }
+    /* the reply is in the order of the request */
+    rpm_object = (len > 0) ? rpm_data : NULL;
+    for (; rpm_object; rpm_object = rpm_object->next) {
+        rpm_property = rpm_object->listOfProperties;
+        for (; rpm_property; rpm_property = rpm_property->next) {
+            if ((i >= request->count) ||
+                (rpm_object->object_type != item[i]->object_type) ||
+                (rpm_object->object_instance != item[i]->object_instance) ||
+                (rpm_property->propertyIdentifier !=
+                    item[i]->object_property)) {
+                break;
+            }
+            if (rpm_property->value) {
+                object_value.object_type = rpm_object->object_type;
+                object_value.object_instance = rpm_object->object_instance;
+                object_value.object_property =
+                    rpm_property->propertyIdentifier;
+                object_value.array_index = rpm_property->propertyArrayIndex;
+                Batch_Answer_Value(
+                    answer, sizeof(answer), &object_value, rpm_property->value);
+                Batch_Item_Done(item[i], false, answer);
+            } else {
+                sprintf(answer, "BACnet Error: %s: %s",
+                    bactext_error_class_name(
+                        (int)rpm_property->error.error_class),
+                    bactext_error_code_name(
+                        (int)rpm_property->error.error_code));
+                Batch_Item_Done(item[i], true, answer);
+            }
+            i++;
+        }
+        if (rpm_property) {
+            break;
+        }
+    }
+    while (rpm_data) {
+        rpm_data = rpm_data_free(rpm_data);
+    }
+    /* read anything missing from the reply on its own */
+    for (; i < request->count; i++) {
+        item[i]->single = true;
+        item[i]->state = batchPending;
+    }
+}
+
+/* Completion of a request, called by the transaction state machine */
+static void Batch_Complete(BACNET_TSM_COMPLETION *completion, void *context)
+{
+    BATCH_REQUEST *request = context;
+    BATCH_DEVICE *device = request->device;
+    BATCH_ITEM **item = &device->item[request->first];
+    bool multiple;
+    char msg[MAX_ERROR_STRING];
+    unsigned i;
+
+    request->in_use = false;
+    multiple = (request->service == SERVICE_CONFIRMED_READ_PROP_MULTIPLE) ||
+        (request->service == SERVICE_CONFIRMED_WRITE_PROP_MULTIPLE);
+    switch (completion->result) {
+        case TSM_RESULT_ACK:
+            if (request->service == SERVICE_CONFIRMED_READ_PROP_MULTIPLE) {
+                Batch_Read_Property_Multiple_Ack(request, completion);
+            } else if (request->service == SERVICE_CONFIRMED_READ_PROPERTY) {
+                Batch_Read_Property_Ack(item[0], completion);
+            } else {
+                for (i = 0; i < request->count; i++) {
+                    Batch_Item_Done(
+                        item[i], false, "WriteProperty Acknowledged!");
+                }
+            }
+            return;
+        case TSM_RESULT_TIMEOUT:
+            strcpy(msg, "TSM Timeout!");
+            break;
+        case TSM_RESULT_ERROR:
+            sprintf(msg, "BACnet Error: %s: %s",
+                bactext_error_class_name((int)completion->error_class),
+                bactext_error_code_name((int)completion->error_code));
+            break;
+        case TSM_RESULT_REJECT:
+            sprintf(msg, "BACnet Reject: %s",
+                bactext_reject_reason_name((int)completion->reason));
+            break;
+        case TSM_RESULT_ABORT:
+        default:
+            if ((request->service == SERVICE_CONFIRMED_READ_PROP_MULTIPLE) &&
+                (request->count > 1) &&
+                ((completion->reason ==
+                     ABORT_REASON_SEGMENTATION_NOT_SUPPORTED) ||
+                    (completion->reason == ABORT_REASON_BUFFER_OVERFLOW) ||
+                    (completion->reason == ABORT_REASON_APDU_TOO_LONG))) {
+                /* the reply did not fit: read fewer at a time */
+                device->read_limit = request->count / 2;
+                for (i = 0; i < request->count; i++) {
+                    item[i]->state = batchPending;
+                }
+                return;
+            }
+            sprintf(msg, "BACnet Abort: %s",
+                bactext_abort_reason_name((int)completion->reason));
+            break;
+    }
+    if (multiple && (completion->result != TSM_RESULT_TIMEOUT)) {
+        /* the device may not support the service, or it stopped at the */
+        /* first error, so send each property on its own */
+        for (i = 0; i < request->count; i++) {
+            item[i]->single = true;
+            item[i]->state = batchPending;
+        }
+    } else {
+        for (i = 0; i < request->count; i++) {
+            Batch_Item_Done(item[i], true, msg);
+        }
+    }
+}
+
+/* Encode the reads that are next in line, up to the read limit */
+static int Batch_Read_Property_Multiple_Encode(uint8_t *apdu,
+    unsigned max_apdu,
+    uint8_t invoke_id,
+    BATCH_DEVICE *device,
+    BATCH_REQUEST *request)
+{
+    BATCH_ITEM *item;
+    BATCH_ITEM *prior = NULL;
+    uint8_t buffer[32];
+    unsigned i;
+    int apdu_len;
+    int len;
+
+    apdu_len = rpm_encode_apdu_init(apdu, invoke_id);
+    for (i = request->first; (i < device->item_count) &&
+         (request->count < device->read_limit);
+         i++) {
+        item = device->item[i];
+        if ((item->state != batchPending) || item->single ||
+            item->application_data) {
+            break;
+        }
+        len = 0;
+        if (!prior || (prior->object_type != item->object_type) ||
+            (prior->object_instance != item->object_instance)) {
+            if (prior) {
+                len += rpm_encode_apdu_object_end(&buffer[len]);
+            }
+            len += rpm_encode_apdu_object_begin(
+                &buffer[len], item->object_type, item->object_instance);
+        }
+        len += rpm_encode_apdu_object_property(
+            &buffer[len], item->object_property, item->array_index);
+        /* leave room for the end of the object */
+        if ((apdu_len + len + 1) > (int)max_apdu) {
+            break;
+        }
+        memcpy(&apdu[apdu_len], buffer, len);
+        apdu_len += len;
+        request->count++;
+        prior = item;
+    }
+    if (request->count == 0) {
+        return 0;
+    }
+    apdu_len += rpm_encode_apdu_object_end(&apdu[apdu_len]);
+
+    return apdu_len;
+}
+
+/* Encode the writes that are next in line */
+static int Batch_Write_Property_Multiple_Encode(uint8_t *apdu,
+    unsigned max_apdu,
+    uint8_t invoke_id,
+    BATCH_DEVICE *device,
+    BATCH_REQUEST *request)
+{
+    static BACNET_WRITE_PROPERTY_DATA wp_data;
+    static uint8_t buffer[MAX_APDU + 32];
+    BATCH_ITEM *item;
+    BATCH_ITEM *prior = NULL;
+    unsigned i;
+    int apdu_len;
+    int len;
+
+    apdu_len = wpm_encode_apdu_init(apdu, invoke_id);
+    for (i = request->first; i < device->item_count; i++) {
+        item = device->item[i];
+        if ((item->state != batchPending) || item->single ||
+            !item->application_data) {
+            break;
+        }
+        len = 0;
+        if (!prior || (prior->object_type != item->object_type) ||
+            (prior->object_instance != item->object_instance)) {
+            if (prior) {
+                len += wpm_encode_apdu_object_end(&buffer[len]);
+            }
+            len += wpm_encode_apdu_object_begin(
+                &buffer[len], item->object_type, item->object_instance);
+        }
+        wp_data.object_property = item->object_property;
+        wp_data.array_index = item->array_index;
+        wp_data.priority = item->priority;
+        memcpy(wp_data.application_data, item->application_data,
+            item->application_data_len);
+        wp_data.application_data_len = item->application_data_len;
+        len += wpm_encode_apdu_object_property(&buffer[len], &wp_data);
+        if ((apdu_len + len + 1) > (int)max_apdu) {
+            break;
+        }
+        memcpy(&apdu[apdu_len], buffer, len);
+        apdu_len += len;
+        request->count++;
+        prior = item;
+    }
+    if (request->count == 0) {
+        return 0;
+    }
+    apdu_len += wpm_encode_apdu_object_end(&apdu[apdu_len]);
+
+    return apdu_len;
+}
+
+/* Send the next request to a device. Return false if there is nothing */
+/* to send, or no room to send it */
+static bool Batch_Send(BATCH_DEVICE *device)
+{
+    BATCH_REQUEST *request = NULL;
+    BATCH_ITEM *item;
+    BACNET_READ_PROPERTY_DATA rp_data;
+    static BACNET_WRITE_PROPERTY_DATA wp_data;
+    BACNET_NPDU_DATA npdu_data;
+    BACNET_ADDRESS my_address;
+    uint8_t pdu[MAX_PDU];
+    unsigned max_apdu;
+    unsigned first;
+    unsigned i;
+    uint8_t invoke_id;
+    int pdu_len;
+    int len = 0;
+
+    while ((device->next < device->item_count) &&
+        (device->item[device->next]->state == batchDone)) {
+        device->next++;
+    }
+    for (first = device->next; first < device->item_count; first++) {
+        if (device->item[first]->state == batchPending) {
+            break;
+        }
+    }
+    if (first >= device->item_count) {
+        return false;
+    }
+    for (i = 0; i < BATCH_WINDOW; i++) {
+        if (!device->request[i].in_use) {
+            request = &device->request[i];
+            break;
+        }
+    }
+    if (!request) {
+        return false;
+    }
+    request->device = device;
+    request->first = first;
+    request->count = 0;
+    invoke_id = tsm_next_free_invokeID_async(
+        &device->address, Batch_Complete, request);
+    if (invoke_id == 0) {
+        return false;
+    }
+    max_apdu = device->max_apdu;
+    if (max_apdu > MAX_APDU) {
+        max_apdu = MAX_APDU;
+    }
+    datalink_get_my_address(&my_address);
+    npdu_encode_npdu_data(&npdu_data, true, MESSAGE_PRIORITY_NORMAL);
+    pdu_len =
+        npdu_encode_pdu(&pdu[0], &device->address, &my_address, &npdu_data);
+    item = device->item[first];
+    if (item->single && item->application_data) {
+        request->service = SERVICE_CONFIRMED_WRITE_PROPERTY;
+        request->count = 1;
+        wp_data.object_type = item->object_type;
+        wp_data.object_instance = item->object_instance;
+        wp_data.object_property = item->object_property;
+        wp_data.array_index = item->array_index;
+        wp_data.priority = item->priority;
+        memcpy(wp_data.application_data, item->application_data,
+            item->application_data_len);
+        wp_data.application_data_len = item->application_data_len;
+        len = wp_encode_apdu(&pdu[pdu_len], invoke_id, &wp_data);
+    } else if (item->single) {
+        request->service = SERVICE_CONFIRMED_READ_PROPERTY;
+        request->count = 1;
+        rp_data.object_type = item->object_type;
+        rp_data.object_instance = item->object_instance;
+        rp_data.object_property = item->object_property;
+        rp_data.array_index = item->array_index;
+        len = rp_encode_apdu(&pdu[pdu_len], invoke_id, &rp_data);
+    } else if (item->application_data) {
+        request->service = SERVICE_CONFIRMED_WRITE_PROP_MULTIPLE;
+        len = Batch_Write_Property_Multiple_Encode(
+            &pdu[pdu_len], max_apdu, invoke_id, device, request);
+    } else {
+        request->service = SERVICE_CONFIRMED_READ_PROP_MULTIPLE;
+        len = Batch_Read_Property_Multiple_Encode(
+            &pdu[pdu_len], max_apdu, invoke_id, device, request);
+    }
+    if ((len <= 0) || ((unsigned)len > max_apdu)) {
+        tsm_cancel_invoke_id(invoke_id, &device->address, NULL);
+        if (item->single) {
+            Batch_Item_Done(item, true, "Request is too long for the device");
+        } else {
+            item->single = true;
+        }
+        return true;
+    }
+    pdu_len += len;
+    for (i = 0; i < request->count; i++) {
+        device->item[first + i]->state = batchSent;
+    }
+    request->in_use = true;
+    tsm_set_confirmed_unsegmented_transaction(
+        invoke_id, &device->address, &npdu_data, &pdu[0], (uint16_t)pdu_len);
+    datalink_send_pdu(&device->address, &npdu_data, &pdu[0], pdu_len);
+
+    return true;
+}
+
+static int Batch_Item_Compare(const void *a, const void *b)
+{
+    const BATCH_ITEM *item_a = *(const BATCH_ITEM *const *)a;
+    const BATCH_ITEM *item_b = *(const BATCH_ITEM *const *)b;
+
+    if (item_a->device_id != item_b->device_id) {
+        return (item_a->device_id < item_b->device_id) ? -1 : 1;
+    }
+    /* keep the order given */
+    if (item_a != item_b) {
+        return (item_a < item_b) ? -1 : 1;
+    }
+
+    return 0;
+}
+
+/* Parse one request: [device, type, instance, property, index] to read, */
+/* or [device, type, instance, property, index, priority, tag, value] */
+/* to write. If it fails, return false and give the reason in msg */
+static bool Batch_Item_Parse(SV *pSV, BATCH_ITEM *item, char *msg)
+{
+    BACNET_APPLICATION_DATA_VALUE propertyValue;
+    uint8_t application_data[MAX_APDU];
+    SV **ppSV[8];
+    AV *pAV;
+    int count;
+    int len;
+    int i;
+
+    if (!SvROK(pSV) || (SvTYPE(SvRV(pSV)) != SVt_PVAV)) {
+        strcpy(msg, "Argument is not an Array reference");
+        return false;
+    }
+    pAV = (AV *)SvRV(pSV);
+    count = av_len(pAV) + 1;
+    if ((count != 5) && (count != 8)) {
+        strcpy(msg, "Problem parsing the Array of arguments");
+        return false;
+    }
+    for (i = 0; i < count; i++) {
+        ppSV[i] = av_fetch(pAV, i, 0);
+        if (!ppSV[i]) {
+            strcpy(msg, "Problem parsing the Array of arguments");
+            return false;
+        }
+    }
+    item->device_id = SvIV(*ppSV[0]);
+    item->object_type = SvIV(*ppSV[1]);
+    item->object_instance = SvIV(*ppSV[2]);
+    item->object_property = SvIV(*ppSV[3]);
+    item->array_index = SvIV(*ppSV[4]);
+    if (SvIV(*ppSV[4]) == -1) {
+        item->array_index = BACNET_ARRAY_ALL;
+    }
+    if (count == 8) {
+        item->priority = SvIV(*ppSV[5]);
+        if (item->priority == 0) {
+            item->priority = BACNET_NO_PRIORITY;
+        }
+        if (!Parse_Tag_Value(SvPV_nolen(*ppSV[6]), SvPV_nolen(*ppSV[7]),
+                &propertyValue, msg)) {
+            return false;
+        }
+        len = bacapp_encode_data(&application_data[0], &propertyValue);
+        item->application_data = malloc(len);
+        if (!item->application_data) {
+            strcpy(msg, "Memory allocation error");
+            return false;
+        }
+        memcpy(item->application_data, application_data, len);
+        item->application_data_len = len;
+    }
+
+    return true;
+}
+
+/****************************************************/
+/* This is the interface to a batch of ReadProperty and WriteProperty */
+/* requests to any number of devices. Returns a reference to an array */
+/* that holds [isFailure, answer] for each request, in the order given */
+/****************************************************/
+SV *BacnetBatch(SV *requests)
+{
+    AV *results = newAV();
+    AV *pAV;
+    AV *result;
+    BATCH_ITEM *items = NULL;
+    BATCH_ITEM **order = NULL;
+    BATCH_DEVICE *devices = NULL;
+    BATCH_DEVICE *device = NULL;
+    unsigned item_count = 0;
+    unsigned device_count = 0;
+    struct mstimer bind_timer;
+    struct mstimer tsm_timer;
+    BACNET_ADDRESS src = { 0 };
+    uint8_t Rx_Buf[MAX_MPDU] = { 0 };
+    char msg[MAX_ERROR_STRING];
+    uint16_t pdu_len;
+    unsigned i;
+
+    /* Loop for early exit */
+    do {
+        if (!SvROK(requests) || (SvTYPE(SvRV(requests)) != SVt_PVAV)) {
+            LogError("Argument is not an Array reference");
+            break;
+        }
+        pAV = (AV *)SvRV(requests);
+        item_count = av_len(pAV) + 1;
+        if (item_count == 0) {
+            break;
+        }
+        items = calloc(item_count, sizeof(BATCH_ITEM));
+        order = calloc(item_count, sizeof(BATCH_ITEM *));
+        devices = calloc(item_count, sizeof(BATCH_DEVICE));
+        if (!items || !order || !devices) {
+            LogError("Memory allocation error");
+            item_count = 0;
+            break;
+        }
+        Batch_Remaining = item_count;
+        for (i = 0; i < item_count; i++) {
+            order[i] = &items[i];
+            if (!Batch_Item_Parse(*av_fetch(pAV, i, 0), &items[i], msg)) {
+                Batch_Item_Done(&items[i], true, msg);
+            }
+        }
+        /* group the requests by device */
+        qsort(order, item_count, sizeof(BATCH_ITEM *), Batch_Item_Compare);
+        for (i = 0; i < item_count; i++) {
+            if ((device_count == 0) ||
+                (device->device_id != order[i]->device_id)) {
+                device = &devices[device_count++];
+                device->device_id = order[i]->device_id;
+                device->item = &order[i];
+            }
+            device->item_count++;
+        }
+        for (i = 0; i < device_count; i++) {
+            device = &devices[i];
+            device->bound = address_bind_request(
+                device->device_id, &device->max_apdu, &device->address);
+            if (!device->bound) {
+                Send_WhoIs(device->device_id, device->device_id);
+            }
+        }
+        mstimer_set(&bind_timer, BATCH_BIND_MS);
+        mstimer_set(&tsm_timer, 10);
+        while (Batch_Remaining > 0) {
+            for (i = 0; i < device_count; i++) {
+                device = &devices[i];
+                if (!device->bound) {
+                    device->bound = address_bind_request(device->device_id,
+                        &device->max_apdu, &device->address);
+                    if (!device->bound && mstimer_expired(&bind_timer)) {
+                        /* give up on the device */
+                        for (; device->next < device->item_count;
+                             device->next++) {
+                            if (device->item[device->next]->state !=
+                                batchDone) {
+                                Batch_Item_Done(device->item[device->next],
+                                    true, "Unable to bind to the device");
+                            }
+                        }
+                    }
+                    continue;
+                }
+                if (device->read_limit == 0) {
+                    device->read_limit = device->max_apdu / BATCH_READ_OCTETS;
+                    if (device->read_limit == 0) {
+                        device->read_limit = 1;
+                    }
+                }
+                while (Batch_Send(device)) {
+                    /* fill the window */
+                }
+            }
+            /* Process PDU if one comes in */
+            pdu_len = datalink_receive(&src, &Rx_Buf[0], MAX_MPDU, 10);
+            if (pdu_len) {
+                npdu_handler(&src, &Rx_Buf[0], pdu_len);
+            }
+            if (mstimer_expired(&tsm_timer)) {
+                mstimer_reset(&tsm_timer);
+                tsm_timer_milliseconds(mstimer_interval(&tsm_timer));
+            }
+        }
+    } while (false);
+
+    for (i = 0; i < item_count; i++) {
+        result = newAV();
+        av_push(result, newSViv(items[i].failed));
+        av_push(result,
+            newSVpv(items[i].answer ? items[i].answer : NO_ERROR, 0));
+        av_push(results, newRV_noinc((SV *)result));
+        free(items[i].answer);
+        free(items[i].application_data);
+    }
+    free(devices);
+    free(order);
+    free(items);
+
+    return newRV_noinc((SV *)results);
+}
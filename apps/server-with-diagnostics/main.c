@@ -28,7 +28,6 @@
 #include <stdlib.h>
 #include <signal.h>
 #include <string.h>
-#include <time.h>
 #include "bacnet/config.h"
 #include "bacnet/bacdef.h"
 #include "bacnet/bacdcode.h"
@@ -41,12 +40,20 @@
 #include "bacnet/basic/services.h"
 #include "bacnet/datalink/dlenv.h"
 #include "bacnet/basic/sys/filename.h"
+#include "bacnet/basic/sys/mstimer.h"
+#include "bacnet/basic/sys/persist.h"
+#include "bacnet/basic/sys/process_image.h"
+#include "bacnet/basic/npdu/h_npdu_queue.h"
 #include "bacnet/basic/tsm/tsm.h"
 #include "bacnet/basic/tsm/tsm.h"
 #include "bacnet/datalink/datalink.h"
 #include "bacnet/basic/binding/address.h"
 /* include the device object */
 #include "bacnet/basic/object/device.h"
+#include "bacnet/basic/object/ai.h"
+#include "bacnet/basic/object/bi.h"
+#include "bacnet/basic/object/ms-input.h"
+#include "bacnet/basic/object/provision.h"
 #include "bacnet/basic/object/lc.h"
 #include "bacnet/basic/object/trendlog.h"
 #if defined(INTRINSIC_REPORTING)
@@ -71,6 +78,13 @@ static const char *BACnet_Version = BACNET_VERSION_TEXT;
 
 /** Buffer used for receiving */
 static uint8_t Rx_Buf[MAX_MPDU] = { 0 };
+/** Input values shared with I/O driver processes */
+static PROCESS_IMAGE Process_Image;
+static bool Process_Image_Enabled;
+/** How often the process image is checked for changes, in milliseconds */
+#ifndef PROCESS_IMAGE_POLL_MS
+#define PROCESS_IMAGE_POLL_MS 50
+#endif
 
 /** Initialize the handlers we will utilize.
  * @see Device_Init, apdu_set_unconfirmed_handler, apdu_set_confirmed_handler
@@ -125,6 +139,8 @@ static void Init_Service_Handlers(void)
         SERVICE_UNCONFIRMED_TIME_SYNCHRONIZATION, handler_timesync);
     apdu_set_confirmed_handler(
         SERVICE_CONFIRMED_SUBSCRIBE_COV, handler_cov_subscribe);
+    apdu_set_confirmed_handler(SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY,
+        handler_cov_subscribe_property);
     apdu_set_unconfirmed_handler(
         SERVICE_UNCONFIRMED_COV_NOTIFICATION, handler_ucov_notification);
     /* handle communication so we can shutup when asked */
@@ -150,6 +166,151 @@ static void Init_Service_Handlers(void)
         SERVICE_CONFIRMED_DELETE_OBJECT, handler_delete_object);
 }
 
+/** Updates an input object from a changed point of the process image.
+ * Objects that are Out_Of_Service keep the value written by clients.
+ * @param value [in] The changed point
+ * @param context [in] Not used
+ */
+static void Process_Image_Update(
+    const PROCESS_IMAGE_VALUE *value, void *context)
+{
+    (void)context;
+    switch (value->object_type) {
+        case OBJECT_ANALOG_INPUT:
+            if ((value->tag == BACNET_APPLICATION_TAG_REAL) &&
+                !Analog_Input_Out_Of_Service(value->object_instance)) {
+                Analog_Input_Present_Value_Set(
+                    value->object_instance, value->type.Real);
+            }
+            break;
+        case OBJECT_BINARY_INPUT:
+            if (!Binary_Input_Out_Of_Service(value->object_instance)) {
+                if (value->tag == BACNET_APPLICATION_TAG_BOOLEAN) {
+                    Binary_Input_Present_Value_Set(value->object_instance,
+                        value->type.Boolean ? BINARY_ACTIVE : BINARY_INACTIVE);
+                } else if (value->tag == BACNET_APPLICATION_TAG_ENUMERATED) {
+                    Binary_Input_Present_Value_Set(value->object_instance,
+                        (BACNET_BINARY_PV)value->type.Enumerated);
+                }
+            }
+            break;
+        case OBJECT_MULTI_STATE_INPUT:
+            if (!Multistate_Input_Out_Of_Service(value->object_instance)) {
+                if (value->tag == BACNET_APPLICATION_TAG_UNSIGNED_INT) {
+                    Multistate_Input_Present_Value_Set(
+                        value->object_instance, value->type.Unsigned_Int);
+                }
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/** Creates the process image named by the BACNET_PROCESS_IMAGE
+ * environment variable, with a point for each input object.
+ */
+static void Process_Image_Setup(void)
+{
+    const char *name;
+    void *memory;
+    size_t size;
+    unsigned count, i;
+
+    name = getenv("BACNET_PROCESS_IMAGE");
+    if (!name) {
+        return;
+    }
+    count = Analog_Input_Count() + Binary_Input_Count() +
+        Multistate_Input_Count();
+    if (count == 0) {
+        return;
+    }
+    size = Process_Image_Size(count);
+    memory = Process_Image_Map(name, &size, true);
+    if (!memory) {
+        return;
+    }
+    if (!Process_Image_Format(&Process_Image, memory, size, count)) {
+        Process_Image_Unmap(memory, size);
+        return;
+    }
+    for (i = 0; i < Analog_Input_Count(); i++) {
+        Process_Image_Point_Add(&Process_Image, OBJECT_ANALOG_INPUT,
+            Analog_Input_Index_To_Instance(i));
+    }
+    for (i = 0; i < Binary_Input_Count(); i++) {
+        Process_Image_Point_Add(&Process_Image, OBJECT_BINARY_INPUT,
+            Binary_Input_Index_To_Instance(i));
+    }
+    for (i = 0; i < Multistate_Input_Count(); i++) {
+        Process_Image_Point_Add(&Process_Image, OBJECT_MULTI_STATE_INPUT,
+            Multistate_Input_Index_To_Instance(i));
+    }
+    Process_Image_Enabled = true;
+    printf("BACnet Process Image: %s (%u points)\n", name, count);
+}
+
+/** Creates and configures the objects of the point list file named by
+ * the BACNET_PROVISION environment variable.
+ */
+static void Provision_Setup(void)
+{
+    const char *pathname;
+    unsigned line = 0;
+    int count;
+
+    pathname = getenv("BACNET_PROVISION");
+    if (!pathname) {
+        return;
+    }
+    count = Provision_Load_File(pathname, &line);
+    if (count < 0) {
+        fprintf(stderr, "BACnet Provision: %s error at line %u\n", pathname,
+            line);
+    } else {
+        printf("BACnet Provision: %s (%d points)\n", pathname, count);
+    }
+}
+
+/** Properties whose written values survive a restart */
+static const BACNET_PROPERTY_ID Persistent_Properties[] = {
+    PROP_OBJECT_NAME, PROP_DESCRIPTION, PROP_LOCATION, PROP_OUT_OF_SERVICE,
+    PROP_PRESENT_VALUE, PROP_RELINQUISH_DEFAULT, PROP_COV_INCREMENT,
+    PROP_HIGH_LIMIT, PROP_LOW_LIMIT, PROP_DEADBAND, PROP_LIMIT_ENABLE,
+    PROP_EVENT_ENABLE, PROP_NOTIFY_TYPE, PROP_TIME_DELAY,
+    PROP_NOTIFICATION_CLASS, PROP_RECIPIENT_LIST, PROP_PRIORITY,
+    PROP_ACK_REQUIRED, PROP_WEEKLY_SCHEDULE, PROP_EXCEPTION_SCHEDULE,
+    PROP_EFFECTIVE_PERIOD, PROP_SCHEDULE_DEFAULT, PROP_PRIORITY_FOR_WRITING,
+    PROP_LOG_INTERVAL, PROP_ENABLE, PROP_START_TIME, PROP_STOP_TIME
+};
+
+/** Opens the persistent store named by the BACNET_PERSIST environment
+ * variable, and writes the stored values back to the objects.
+ */
+static void Persist_Setup(void)
+{
+    const char *pathname;
+    unsigned i;
+
+    pathname = getenv("BACNET_PERSIST");
+    if (!pathname) {
+        return;
+    }
+    for (i = 0; i < sizeof(Persistent_Properties) /
+             sizeof(Persistent_Properties[0]);
+         i++) {
+        Persist_Property_Register(
+            MAX_BACNET_OBJECT_TYPE, Persistent_Properties[i]);
+    }
+    if (!Persist_Init(pathname)) {
+        fprintf(stderr, "BACnet Persist: unable to write %s\n", pathname);
+    }
+    atexit(Persist_Cleanup);
+    printf("BACnet Persist: %s (%u values restored)\n", pathname,
+        Device_Persist_Restore());
+}
+
 static void print_usage(const char *filename)
 {
     printf("Usage: %s [device-instance [device-name]]\n", filename);
@@ -164,6 +325,10 @@ static void print_help(const char *filename)
            "trying simulate.\n"
            "device-name:\n"
            "The Device object-name is the text name for the device.\n"
+           "\nSet BACNET_PROCESS_IMAGE to a shared memory name, such as\n"
+           "/bacnet, for I/O drivers to update the input objects.\n"
+           "Set BACNET_PERSIST to a pathname, such as /var/lib/bacnet/db,\n"
+           "to keep written values across restarts.\n"
            "\nExample:\n");
     printf("To simulate Device 123, use the following command:\n"
            "%s 123\n",
@@ -173,13 +338,46 @@ static void print_help(const char *filename)
         filename);
 }
 
+/** Gets the time to wait for a packet, which is until the next timer
+ * of the main loop is due.
+ *
+ * @param second_milliseconds [in] milliseconds counted into the
+ *  current second of the once a second timers
+ * @return milliseconds to wait
+ */
+static unsigned Receive_Timeout(uint32_t second_milliseconds)
+{
+    unsigned long timeout = 0;
+    unsigned long remaining = 0;
+
+    if (!npdu_queue_empty()) {
+        /* packets are waiting to be served */
+        return 0;
+    }
+    timeout = 1000 - second_milliseconds;
+    remaining = tsm_timer_milliseconds_remaining();
+    if (remaining < timeout) {
+        timeout = remaining;
+    }
+    remaining = Persist_Task_Remaining();
+    if (remaining < timeout) {
+        timeout = remaining;
+    }
+    if (Process_Image_Enabled && (PROCESS_IMAGE_POLL_MS < timeout)) {
+        timeout = PROCESS_IMAGE_POLL_MS;
+    }
+
+    return (unsigned)timeout;
+}
+
 /** Main function of server demo.
  *
  * @see Device_Set_Object_Instance_Number, dlenv_init, Send_I_Am,
- *      datalink_receive, npdu_handler,
+ *      datalink_receive, npdu_queue_add, npdu_queue_task,
  *      dcc_timer_seconds, datalink_maintenance_timer,
- *      Load_Control_State_Machine_Handler, handler_cov_task,
- *      tsm_timer_milliseconds
+ *      Load_Control_State_Machine_Handler, handler_cov_fsm,
+ *      tsm_timer_milliseconds, apdu_reply_cache_timer,
+ *      apdu_admission_timer
  *
  * @param argc [in] Arg count.
  * @param argv [in] Takes one argument: the Device Instance #.
@@ -189,11 +387,13 @@ int main(int argc, char *argv[])
 {
     BACNET_ADDRESS src = { 0 }; /* address where message came from */
     uint16_t pdu_len = 0;
-    unsigned timeout = 1; /* milliseconds */
-    time_t last_seconds = 0;
-    time_t current_seconds = 0;
+    unsigned received = 0;
+    unsigned timeout = 0; /* milliseconds */
+    unsigned long last_milliseconds = 0;
+    unsigned long current_milliseconds = 0;
     uint32_t elapsed_seconds = 0;
     uint32_t elapsed_milliseconds = 0;
+    uint32_t second_milliseconds = 0;
     uint32_t address_binding_tmr = 0;
     BACNET_CHARACTER_STRING DeviceName;
 #if defined(INTRINSIC_REPORTING)
@@ -209,6 +409,7 @@ int main(int argc, char *argv[])
     int argi = 0;
     const char *filename = NULL;
 
+    mstimer_init();
     filename = filename_remove_path(argv[0]);
     for (argi = 1; argi < argc; argi++) {
         if (strcmp(argv[argi], "--help") == 0) {
@@ -271,39 +472,65 @@ int main(int argc, char *argv[])
     }
     ucix_cleanup(ctx);
 #endif /* defined(BAC_UCI) */
+    Provision_Setup();
+    Persist_Setup();
     if (Device_Object_Name(Device_Object_Instance_Number(), &DeviceName)) {
         printf("BACnet Device Name: %s\n", DeviceName.value);
     }
 
     dlenv_init();
     atexit(datalink_cleanup);
+    Process_Image_Setup();
     /* configure the timeout values */
-    last_seconds = time(NULL);
+    last_milliseconds = mstimer_now();
     /* broadcast an I-Am on startup */
     Send_I_Am(&Handler_Transmit_Buffer[0]);
     /* loop forever */
     for (;;) {
         /* input */
-        current_seconds = time(NULL);
-
         /* returns 0 bytes on timeout */
         pdu_len = datalink_receive(&src, &Rx_Buf[0], MAX_MPDU, timeout);
+        /* take what else has arrived, then serve it by network priority */
+        received = 0;
+        while (pdu_len) {
+            npdu_queue_add(&src, &Rx_Buf[0], pdu_len);
+            if (++received >= NPDU_QUEUE_SIZE) {
+                break;
+            }
+            pdu_len = datalink_receive(&src, &Rx_Buf[0], MAX_MPDU, 0);
+        }
+        current_milliseconds = mstimer_now();
 
         /* process */
-        if (pdu_len) {
-            npdu_handler(&src, &Rx_Buf[0], pdu_len);
+        npdu_queue_task();
+        if (Process_Image_Enabled) {
+            Process_Image_Changes(
+                &Process_Image, Process_Image_Update, NULL);
         }
+        Persist_Task();
+        /* retries and timeouts run to the millisecond */
+        elapsed_milliseconds =
+            (uint32_t)(current_milliseconds - last_milliseconds);
+        last_milliseconds = current_milliseconds;
+        if (elapsed_milliseconds > UINT16_MAX) {
+            elapsed_milliseconds = UINT16_MAX;
+        }
+        if (elapsed_milliseconds) {
+            tsm_timer_milliseconds((uint16_t)elapsed_milliseconds);
+            apdu_reply_cache_timer((uint16_t)elapsed_milliseconds);
+            apdu_admission_timer((uint16_t)elapsed_milliseconds);
+        }
+        /* the seconds timers keep the fraction of a second left over */
+        second_milliseconds += elapsed_milliseconds;
+        elapsed_seconds = second_milliseconds / 1000;
+        second_milliseconds %= 1000;
         /* at least one second has passed */
-        elapsed_seconds = (uint32_t)(current_seconds - last_seconds);
         if (elapsed_seconds) {
-            last_seconds = current_seconds;
             dcc_timer_seconds(elapsed_seconds);
             datalink_maintenance_timer(elapsed_seconds);
             dlenv_maintenance_timer(elapsed_seconds);
             Load_Control_State_Machine_Handler();
-            elapsed_milliseconds = elapsed_seconds * 1000;
             handler_cov_timer_seconds(elapsed_seconds);
-            tsm_timer_milliseconds(elapsed_milliseconds);
             trend_log_timer(elapsed_seconds);
 #if defined(INTRINSIC_REPORTING)
             Device_local_reporting();
@@ -313,7 +540,13 @@ int main(int argc, char *argv[])
             handler_timesync_task(&bdatetime);
 #endif
         }
-        handler_cov_task();
+        /* a whole pass of the COV task, since the loop may sleep */
+        while (!handler_cov_fsm()) {
+            /* next subscription */
+        }
+#if defined(INTRINSIC_REPORTING)
+        Send_CEvent_Queue_Task(elapsed_milliseconds);
+#endif
         /* scan cache address */
         address_binding_tmr += elapsed_seconds;
         if (address_binding_tmr >= 60) {
@@ -331,6 +564,9 @@ int main(int argc, char *argv[])
         /* output */
 
         /* blink LEDs, Turn on or off outputs, etc */
+
+        /* sleep in the receive until the next timer is due */
+        timeout = Receive_Timeout(second_milliseconds);
     }
 
     return 0;
@@ -38,6 +38,7 @@
 #include <net/if.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <linux/netlink.h>
 #include <linux/rtnetlink.h>
 #include <sys/types.h>
@@ -59,6 +60,12 @@
 
 /** @file linux/bip-init.c  Initializes BACnet/IP interface (Linux). */
 
+/* hops a B/IP multicast may cross, so one send can reach every subnet
+   that the multicast routers join to the group */
+#ifndef BIP_MULTICAST_TTL
+#define BIP_MULTICAST_TTL 16
+#endif
+
 /* unix sockets */
 static int BIP_Socket = -1;
 static int BIP_Broadcast_Socket = -1;
@@ -73,6 +80,9 @@ static uint16_t BIP_Port;
 static struct in_addr BIP_Address;
 /* IP broadcast address - stored here in network byte order */
 static struct in_addr BIP_Broadcast_Addr;
+/* Annex J.8 IP multicast group used in place of the broadcast address,
+   or zero if B/IP broadcasts use the local broadcast address */
+static struct in_addr BIP_Multicast_Addr;
 /* enable debugging */
 static bool BIP_Debug = false;
 /* interface name */
@@ -172,6 +182,79 @@ void bip_get_my_address(BACNET_ADDRESS *addr)
     }
 }
 
+/**
+ * @brief Get the address that B/IP broadcasts are sent to: the
+ *  multicast group when one is configured, else the local broadcast
+ * @return IPv4 address in network byte order
+ */
+static struct in_addr *bip_broadcast_in_addr(void)
+{
+    if (BIP_Multicast_Addr.s_addr != 0) {
+        return &BIP_Multicast_Addr;
+    }
+
+    return &BIP_Broadcast_Addr;
+}
+
+/**
+ * @brief Join or leave the multicast group on the broadcast socket
+ * @param option - IP_ADD_MEMBERSHIP or IP_DROP_MEMBERSHIP
+ * @return true if the membership changed
+ */
+static bool bip_multicast_membership(int option)
+{
+    struct ip_mreq request = { 0 };
+    int status = 0;
+
+    if ((BIP_Broadcast_Socket < 0) || (BIP_Multicast_Addr.s_addr == 0)) {
+        return false;
+    }
+    request.imr_multiaddr.s_addr = BIP_Multicast_Addr.s_addr;
+    request.imr_interface.s_addr = BIP_Address.s_addr;
+    status = setsockopt(BIP_Broadcast_Socket, IPPROTO_IP, option, &request,
+        sizeof(request));
+    if (status < 0) {
+        perror("BIP: setsockopt(IP_MEMBERSHIP)");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Join the multicast group, and send multicasts from the
+ *  B/IP interface with enough hops to reach the other subnets
+ * @return true if the multicast group is ready to use
+ */
+static bool bip_multicast_init(void)
+{
+    unsigned char ttl = BIP_MULTICAST_TTL;
+    int status = 0;
+
+    status = setsockopt(BIP_Socket, IPPROTO_IP, IP_MULTICAST_IF,
+        &BIP_Address, sizeof(BIP_Address));
+    if (status < 0) {
+        perror("BIP: setsockopt(IP_MULTICAST_IF)");
+        return false;
+    }
+    status = setsockopt(
+        BIP_Socket, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+    if (status < 0) {
+        perror("BIP: setsockopt(IP_MULTICAST_TTL)");
+        return false;
+    }
+    if (!bip_multicast_membership(IP_ADD_MEMBERSHIP)) {
+        return false;
+    }
+    if (BIP_Debug) {
+        fprintf(stderr, "BIP: Multicast Address: %s\n",
+            inet_ntoa(BIP_Multicast_Addr));
+        fflush(stderr);
+    }
+
+    return true;
+}
+
 /**
  * Get the IPv4 broadcast address for my interface.
  *
@@ -183,7 +266,7 @@ void bip_get_broadcast_address(BACNET_ADDRESS *dest)
 
     if (dest) {
         dest->mac_len = 6;
-        memcpy(&dest->mac[0], &BIP_Broadcast_Addr.s_addr, 4);
+        memcpy(&dest->mac[0], &bip_broadcast_in_addr()->s_addr, 4);
         memcpy(&dest->mac[4], &BIP_Port, 2);
         dest->net = BACNET_BROADCAST_NETWORK;
         dest->len = 0; /* no SLEN */
@@ -224,15 +307,32 @@ bool bip_get_addr(BACNET_IP_ADDRESS *addr)
 }
 
 /**
- * @brief Set the BACnet/IP address
- * @param addr - network IPv4 address
+ * @brief Set an IP multicast group as the B/IP broadcast address
+ * @param addr - IPv4 multicast group address
  * @return true if the address was set
  */
 bool bip_set_broadcast_addr(BACNET_IP_ADDRESS *addr)
 {
-    /* not something we do within this driver */
-    (void)addr;
-    return false;
+    struct in_addr group;
+
+    /* the local broadcast address comes from the interface, but B/IP
+       broadcasts may go to an IP multicast group instead (Annex J.8) */
+    if (!addr) {
+        return false;
+    }
+    memcpy(&group.s_addr, &addr->address[0], 4);
+    if (!IN_MULTICAST(ntohl(group.s_addr))) {
+        return false;
+    }
+    if (group.s_addr != BIP_Multicast_Addr.s_addr) {
+        (void)bip_multicast_membership(IP_DROP_MEMBERSHIP);
+        BIP_Multicast_Addr = group;
+        if (BIP_Socket >= 0) {
+            (void)bip_multicast_init();
+        }
+    }
+
+    return true;
 }
 
 /**
@@ -243,7 +343,7 @@ bool bip_set_broadcast_addr(BACNET_IP_ADDRESS *addr)
 bool bip_get_broadcast_addr(BACNET_IP_ADDRESS *addr)
 {
     if (addr) {
-        memcpy(&addr->address[0], &BIP_Broadcast_Addr.s_addr, 4);
+        memcpy(&addr->address[0], &bip_broadcast_in_addr()->s_addr, 4);
         addr->port = ntohs(BIP_Port);
     }
 
@@ -270,18 +370,19 @@ uint8_t bip_get_subnet_prefix(void)
     uint32_t address = 0;
     uint32_t broadcast = 0;
     uint32_t test_broadcast = 0;
-    uint32_t mask = 0xFFFFFFFE;
+    uint32_t mask = 0;
     uint8_t prefix = 0;
 
-    address = BIP_Address.s_addr;
-    broadcast = BIP_Broadcast_Addr.s_addr;
-    /* calculate the subnet prefix from the broadcast address */
-    for (prefix = 1; prefix <= 32; prefix++) {
+    address = ntohl(BIP_Address.s_addr);
+    broadcast = ntohl(BIP_Broadcast_Addr.s_addr);
+    /* calculate the subnet prefix from the broadcast address, in host
+       byte order, trying the longest prefix first */
+    for (prefix = 32; prefix > 1; prefix--) {
+        mask = 0xFFFFFFFFUL << (32 - prefix);
         test_broadcast = (address & mask) | (~mask);
         if (test_broadcast == broadcast) {
             break;
         }
-        mask = mask << 1;
     }
 
     return prefix;
@@ -321,6 +422,59 @@ int bip_send_mpdu(BACNET_IP_ADDRESS *dest, uint8_t *mtu, uint16_t mtu_len)
         (struct sockaddr *)&bip_dest, sizeof(struct sockaddr));
 }
 
+/**
+ * The send function for BACnet/IP driver layer that sends the BVLC
+ * header and the NPDU from their own buffers, without copying them
+ * into one MTU buffer first.
+ *
+ * @param dest - Points to a BACNET_IP_ADDRESS structure containing the
+ *  destination address.
+ * @param header - the BVLC header to send
+ * @param header_len - the number of bytes of the BVLC header
+ * @param npdu - the NPDU to send after the BVLC header
+ * @param npdu_len - the number of bytes of the NPDU
+ *
+ * @return Upon successful completion, returns the number of bytes sent.
+ *  Otherwise, -1 shall be returned and errno set to indicate the error.
+ */
+int bip_send_mpdu_iov(BACNET_IP_ADDRESS *dest,
+    uint8_t *header,
+    uint16_t header_len,
+    uint8_t *npdu,
+    uint16_t npdu_len)
+{
+    struct sockaddr_in bip_dest = { 0 };
+    struct iovec iov[2];
+    struct msghdr msg;
+
+    /* assumes that the driver has already been initialized */
+    if (BIP_Socket < 0) {
+        if (BIP_Debug) {
+            fprintf(stderr, "BIP: driver not initialized!\n");
+            fflush(stderr);
+        }
+        return BIP_Socket;
+    }
+    /* load destination IP address */
+    bip_dest.sin_family = AF_INET;
+    memcpy(&bip_dest.sin_addr.s_addr, &dest->address[0], 4);
+    bip_dest.sin_port = htons(dest->port);
+    /* gather the header and the NPDU into one datagram */
+    iov[0].iov_base = header;
+    iov[0].iov_len = header_len;
+    iov[1].iov_base = npdu;
+    iov[1].iov_len = npdu_len;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &bip_dest;
+    msg.msg_namelen = sizeof(bip_dest);
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+    /* Send the packet */
+    debug_print_ipv4("Sending MPDU->", &bip_dest.sin_addr, bip_dest.sin_port,
+        header_len + npdu_len);
+    return sendmsg(BIP_Socket, &msg, 0);
+}
+
 /**
  * BACnet/IP Datalink Receive handler.
  *
@@ -838,6 +992,7 @@ static int createSocket(struct sockaddr_in *sin)
  * -# Opens a UDP socket
  * -# Configures the socket for sending and receiving
  * -# Configures the socket so it can send broadcasts
+ * -# Joins the multicast group, if one is used for broadcasts
  * -# Binds the socket to the local IP address at the specified port for
  *    BACnet/IP (by default, 0xBAC0 = 47808).
  *
@@ -883,6 +1038,11 @@ bool bip_init(char *ifname)
     if (sock_fd < 0) {
         return false;
     }
+    if (BIP_Multicast_Addr.s_addr != 0) {
+        if (!bip_multicast_init()) {
+            return false;
+        }
+    }
 
     bvlc_init();
 
@@ -29,7 +29,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <limits.h>
+#include <unistd.h>
 #include <sys/time.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 #include "bacnet/bacdef.h"
 #include "bacnet/bacaddr.h"
 #include "bacnet/datalink/mstp.h"
@@ -37,7 +41,7 @@
 #include "rs485.h"
 #include "bacnet/npdu.h"
 #include "bacnet/bits.h"
-#include "bacnet/basic/sys/ringbuf.h"
+#include "bacnet/basic/sys/mpsc_ringbuf.h"
 #include "bacnet/basic/sys/debug.h"
 /* OS Specific include */
 #include "bacport.h"
@@ -48,15 +52,19 @@
 /* Number of MS/TP Packets Rx/Tx */
 uint16_t MSTP_Packets = 0;
 
-/* packet queues */
-static DLMSTP_PACKET Receive_Packet;
-/* mechanism to wait for a packet */
-/*
-static RT_COND Receive_Packet_Flag;
-static RT_MUTEX Receive_Packet_Mutex;
-*/
-static pthread_cond_t Receive_Packet_Flag;
-static pthread_mutex_t Receive_Packet_Mutex;
+/* received packet queue - filled by the FSM thread, emptied by
+   dlmstp_receive(), so no mutex is needed on the hand-off */
+/* count must be a power of 2 for mpsc_ringbuf library */
+#ifndef MSTP_RECEIVE_PACKET_COUNT
+#define MSTP_RECEIVE_PACKET_COUNT 8
+#endif
+static DLMSTP_PACKET Receive_Buffer[MSTP_RECEIVE_PACKET_COUNT];
+static MPSC_RINGBUF_SEQUENCE_STORE(
+    Receive_Sequence, MSTP_RECEIVE_PACKET_COUNT);
+static MPSC_RING_BUFFER Receive_Queue;
+/* mechanism to wait for a packet: futex word bumped on every commit */
+static unsigned Receive_Futex;
+static unsigned Receive_Waiters;
 /* mechanism to wait for a frame in state machine */
 /*
 static RT_COND Received_Frame_Flag;
@@ -67,7 +75,6 @@ static pthread_cond_t Received_Frame_Flag;
 static pthread_mutex_t Received_Frame_Mutex;
 static pthread_cond_t Master_Done_Flag;
 static pthread_mutex_t Master_Done_Mutex;
-static pthread_mutex_t Ring_Buffer_Mutex;
 static pthread_mutex_t Thread_Mutex;
 
 static pthread_t hThread;
@@ -86,12 +93,14 @@ struct mstp_pdu_packet {
     uint16_t length;
     uint8_t buffer[DLMSTP_MPDU_MAX];
 };
-/* count must be a power of 2 for ringbuf library */
+/* count must be a power of 2 for mpsc_ringbuf library */
 #ifndef MSTP_PDU_PACKET_COUNT
 #define MSTP_PDU_PACKET_COUNT 8
 #endif
+/* any application thread may send; the FSM thread is the only consumer */
 static struct mstp_pdu_packet PDU_Buffer[MSTP_PDU_PACKET_COUNT];
-static RING_BUFFER PDU_Queue;
+static MPSC_RINGBUF_SEQUENCE_STORE(PDU_Sequence, MSTP_PDU_PACKET_COUNT);
+static MPSC_RING_BUFFER PDU_Queue;
 /* The minimum time without a DataAvailable or ReceiveError event */
 /* that a node must wait for a station to begin replying to a */
 /* confirmed request: 255 milliseconds. (Implementations may use */
@@ -140,25 +149,6 @@ static int timespec_subtract(
     return l->tv_sec < right.tv_sec;
 }
 
-/**
- * Add a certain number of nanoseconds to the specified time.
- *
- * @param ts - The time to which to add to.
- * @param ns - The number of nanoseconds to add.  Allowed range
- *		is -NS_PER_S..NS_PER_S (i.e., plus minus one second).
- */
-static void timespec_add_ns(struct timespec *ts, long ns)
-{
-    ts->tv_nsec += ns;
-    if (ts->tv_nsec > NS_PER_S) {
-        ts->tv_nsec -= NS_PER_S;
-        ts->tv_sec += 1;
-    } else if (ts->tv_nsec < 0) {
-        ts->tv_nsec += NS_PER_S;
-        ts->tv_sec -= 1;
-    }
-}
-
 static uint32_t Timer_Silence(void *pArg)
 {
     struct timespec now, diff;
@@ -176,15 +166,44 @@ static void Timer_Silence_Reset(void *pArg)
     clock_gettime(CLOCK_MONOTONIC, &start);
 }
 
-static void get_abstime(struct timespec *abstime, unsigned long milliseconds)
+/**
+ * Wakes a thread waiting in dlmstp_receive() after a packet is queued.
+ * The futex system call is skipped when nobody is waiting.
+ *
+ * @param context - unused
+ */
+static void dlmstp_receive_notify(void *context)
+{
+    (void)context;
+    __atomic_fetch_add(&Receive_Futex, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&Receive_Waiters, __ATOMIC_SEQ_CST)) {
+        syscall(SYS_futex, &Receive_Futex, FUTEX_WAKE_PRIVATE, INT_MAX, NULL,
+            NULL, 0);
+    }
+}
+
+/**
+ * Waits for dlmstp_receive_notify() or a timeout
+ *
+ * @param futex_value - futex word sampled before the queue was checked
+ * @param milliseconds - maximum time to wait
+ */
+static void dlmstp_receive_wait(unsigned futex_value, unsigned milliseconds)
 {
-    clock_gettime(CLOCK_MONOTONIC, abstime);
+    struct timespec timeout;
+
     if (milliseconds > 1000) {
-        fprintf(stderr, "DLMSTP: limited timeout of %lums to 1000ms\n",
+        fprintf(stderr, "DLMSTP: limited timeout of %ums to 1000ms\n",
             milliseconds);
         milliseconds = 1000;
     }
-    timespec_add_ns(abstime, 1000000 * milliseconds);
+    timeout.tv_sec = milliseconds / 1000;
+    timeout.tv_nsec = (milliseconds % 1000) * 1000000L;
+    __atomic_fetch_add(&Receive_Waiters, 1, __ATOMIC_SEQ_CST);
+    /* returns at once if a packet was committed after the sample */
+    syscall(SYS_futex, &Receive_Futex, FUTEX_WAIT_PRIVATE, futex_value,
+        &timeout, NULL, 0);
+    __atomic_fetch_sub(&Receive_Waiters, 1, __ATOMIC_SEQ_CST);
 }
 
 void dlmstp_cleanup(void)
@@ -194,12 +213,9 @@ void dlmstp_cleanup(void)
     pthread_mutex_unlock(&Thread_Mutex);
     pthread_join(hThread, NULL);
     pthread_cond_destroy(&Received_Frame_Flag);
-    pthread_cond_destroy(&Receive_Packet_Flag);
     pthread_cond_destroy(&Master_Done_Flag);
     pthread_mutex_destroy(&Received_Frame_Mutex);
-    pthread_mutex_destroy(&Receive_Packet_Mutex);
     pthread_mutex_destroy(&Master_Done_Mutex);
-    pthread_mutex_destroy(&Ring_Buffer_Mutex);
 }
 
 /* returns number of bytes sent on success, zero on failure */
@@ -210,14 +226,16 @@ int dlmstp_send_pdu(BACNET_ADDRESS *dest, /* destination address */
 { /* number of bytes of data */
     int bytes_sent = 0;
     struct mstp_pdu_packet *pkt;
-    unsigned i = 0;
-    pthread_mutex_lock(&Ring_Buffer_Mutex);
-    pkt = (struct mstp_pdu_packet *)Ringbuf_Data_Peek(&PDU_Queue);
+    unsigned ticket = 0;
+
+    if (pdu_len > sizeof(pkt->buffer)) {
+        return 0;
+    }
+    pkt = (struct mstp_pdu_packet *)MPSC_Ringbuf_Data_Reserve(
+        &PDU_Queue, &ticket);
     if (pkt) {
         pkt->data_expecting_reply = npdu_data->data_expecting_reply;
-        for (i = 0; i < pdu_len; i++) {
-            pkt->buffer[i] = pdu[i];
-        }
+        memcpy(pkt->buffer, pdu, pdu_len);
         pkt->length = pdu_len;
         if (dest && dest->mac_len) {
             pkt->destination_mac = dest->mac[0];
@@ -225,11 +243,9 @@ int dlmstp_send_pdu(BACNET_ADDRESS *dest, /* destination address */
             /* mac_len = 0 is a broadcast address */
             pkt->destination_mac = MSTP_BROADCAST_ADDRESS;
         }
-        if (Ringbuf_Data_Put(&PDU_Queue, (uint8_t *)pkt)) {
-            bytes_sent = pdu_len;
-        }
+        MPSC_Ringbuf_Data_Commit(&PDU_Queue, ticket);
+        bytes_sent = pdu_len;
     }
-    pthread_mutex_unlock(&Ring_Buffer_Mutex);
 
     return bytes_sent;
 }
@@ -240,30 +256,36 @@ uint16_t dlmstp_receive(BACNET_ADDRESS *src, /* source address */
     unsigned timeout)
 { /* milliseconds to wait for a packet */
     uint16_t pdu_len = 0;
-    struct timespec abstime;
+    unsigned futex_value;
+    DLMSTP_PACKET *pkt;
 
-    (void)max_pdu;
     /* see if there is a packet available, and a place
        to put the reply (if necessary) and process it */
-    pthread_mutex_lock(&Receive_Packet_Mutex);
-    get_abstime(&abstime, timeout);
-    pthread_cond_timedwait(
-        &Receive_Packet_Flag, &Receive_Packet_Mutex, &abstime);
-    if (Receive_Packet.ready) {
-        if (Receive_Packet.pdu_len) {
+    pkt = (DLMSTP_PACKET *)MPSC_Ringbuf_Peek(&Receive_Queue);
+    if (!pkt && timeout) {
+        futex_value = __atomic_load_n(&Receive_Futex, __ATOMIC_ACQUIRE);
+        pkt = (DLMSTP_PACKET *)MPSC_Ringbuf_Peek(&Receive_Queue);
+        if (!pkt) {
+            dlmstp_receive_wait(futex_value, timeout);
+            pkt = (DLMSTP_PACKET *)MPSC_Ringbuf_Peek(&Receive_Queue);
+        }
+    }
+    if (pkt) {
+        if (pkt->pdu_len) {
             MSTP_Packets++;
             if (src) {
-                memmove(src, &Receive_Packet.address,
-                    sizeof(Receive_Packet.address));
+                memmove(src, &pkt->address, sizeof(pkt->address));
+            }
+            pdu_len = pkt->pdu_len;
+            if (pdu_len > max_pdu) {
+                pdu_len = max_pdu;
             }
             if (pdu) {
-                memmove(pdu, &Receive_Packet.pdu, sizeof(Receive_Packet.pdu));
+                memmove(pdu, &pkt->pdu[0], pdu_len);
             }
-            pdu_len = Receive_Packet.pdu_len;
         }
-        Receive_Packet.ready = false;
+        (void)MPSC_Ringbuf_Pop(&Receive_Queue, NULL);
     }
-    pthread_mutex_unlock(&Receive_Packet_Mutex);
 
     return pdu_len;
 }
@@ -354,28 +376,28 @@ void dlmstp_fill_bacnet_address(BACNET_ADDRESS *src, uint8_t mstp_address)
 uint16_t MSTP_Put_Receive(volatile struct mstp_port_struct_t *mstp_port)
 {
     uint16_t pdu_len = 0;
+    unsigned ticket = 0;
+    DLMSTP_PACKET *pkt;
 
-    pthread_mutex_lock(&Receive_Packet_Mutex);
-    if (Receive_Packet.ready) {
+    pkt = (DLMSTP_PACKET *)MPSC_Ringbuf_Data_Reserve(&Receive_Queue, &ticket);
+    if (!pkt) {
         debug_printf("MS/TP: Dropped! Not Ready.\n");
     } else {
         /* bounds check - maybe this should send an abort? */
         pdu_len = mstp_port->DataLength;
-        if (pdu_len > sizeof(Receive_Packet.pdu)) {
-            pdu_len = sizeof(Receive_Packet.pdu);
+        if (pdu_len > sizeof(pkt->pdu)) {
+            pdu_len = sizeof(pkt->pdu);
         }
         if (pdu_len == 0) {
             debug_printf("MS/TP: PDU Length is 0!\n");
         }
-        memmove((void *)&Receive_Packet.pdu[0],
-            (void *)&mstp_port->InputBuffer[0], pdu_len);
-        dlmstp_fill_bacnet_address(
-            &Receive_Packet.address, mstp_port->SourceAddress);
-        Receive_Packet.pdu_len = mstp_port->DataLength;
-        Receive_Packet.ready = true;
-        pthread_cond_signal(&Receive_Packet_Flag);
+        memmove((void *)&pkt->pdu[0], (void *)&mstp_port->InputBuffer[0],
+            pdu_len);
+        dlmstp_fill_bacnet_address(&pkt->address, mstp_port->SourceAddress);
+        pkt->pdu_len = pdu_len;
+        pkt->ready = true;
+        MPSC_Ringbuf_Data_Commit(&Receive_Queue, ticket);
     }
-    pthread_mutex_unlock(&Receive_Packet_Mutex);
 
     return pdu_len;
 }
@@ -390,12 +412,10 @@ uint16_t MSTP_Get_Send(
     struct mstp_pdu_packet *pkt;
 
     (void)timeout;
-    pthread_mutex_lock(&Ring_Buffer_Mutex);
-    if (Ringbuf_Empty(&PDU_Queue)) {
-        pthread_mutex_unlock(&Ring_Buffer_Mutex);
+    pkt = (struct mstp_pdu_packet *)MPSC_Ringbuf_Peek(&PDU_Queue);
+    if (!pkt) {
         return 0;
     }
-    pkt = (struct mstp_pdu_packet *)Ringbuf_Peek(&PDU_Queue);
     if (pkt->data_expecting_reply) {
         frame_type = FRAME_TYPE_BACNET_DATA_EXPECTING_REPLY;
     } else {
@@ -406,8 +426,7 @@ uint16_t MSTP_Get_Send(
         MSTP_Create_Frame(&mstp_port->OutputBuffer[0], /* <-- loading this */
             mstp_port->OutputBufferSize, frame_type, pkt->destination_mac,
             mstp_port->This_Station, (uint8_t *)&pkt->buffer[0], pkt->length);
-    (void)Ringbuf_Pop(&PDU_Queue, NULL);
-    pthread_mutex_unlock(&Ring_Buffer_Mutex);
+    (void)MPSC_Ringbuf_Pop(&PDU_Queue, NULL);
 
     return pdu_len;
 }
@@ -577,10 +596,10 @@ uint16_t MSTP_Get_Reply(
     struct mstp_pdu_packet *pkt;
 
     (void)timeout;
-    if (Ringbuf_Empty(&PDU_Queue)) {
+    pkt = (struct mstp_pdu_packet *)MPSC_Ringbuf_Peek(&PDU_Queue);
+    if (!pkt) {
         return 0;
     }
-    pkt = (struct mstp_pdu_packet *)Ringbuf_Peek(&PDU_Queue);
     /* is this the reply to the DER? */
     matched = dlmstp_compare_data_expecting_reply(&mstp_port->InputBuffer[0],
         mstp_port->DataLength, mstp_port->SourceAddress,
@@ -598,7 +617,7 @@ uint16_t MSTP_Get_Reply(
         MSTP_Create_Frame(&mstp_port->OutputBuffer[0], /* <-- loading this */
             mstp_port->OutputBufferSize, frame_type, pkt->destination_mac,
             mstp_port->This_Station, (uint8_t *)&pkt->buffer[0], pkt->length);
-    (void)Ringbuf_Pop(&PDU_Queue, NULL);
+    (void)MPSC_Ringbuf_Pop(&PDU_Queue, NULL);
 
     return pdu_len;
 }
@@ -722,38 +741,17 @@ void dlmstp_get_broadcast_address(BACNET_ADDRESS *dest)
 
 bool dlmstp_init(char *ifname)
 {
-    pthread_condattr_t attr;
     int rv = 0;
 
-    pthread_condattr_init(&attr);
-    if ((rv = pthread_condattr_setclock(&attr, CLOCK_MONOTONIC)) != 0) {
-        fprintf(stderr, "MS/TP Interface: %s\n failed to set MONOTONIC clock\n",
-            ifname);
-        exit(1);
-    }
-
-    pthread_mutex_init(&Ring_Buffer_Mutex, NULL);
     pthread_mutex_init(&Thread_Mutex, NULL);
 
     /* initialize PDU queue */
-    Ringbuf_Init(&PDU_Queue, (uint8_t *)&PDU_Buffer,
+    MPSC_Ringbuf_Init(&PDU_Queue, (uint8_t *)&PDU_Buffer, PDU_Sequence,
         sizeof(struct mstp_pdu_packet), MSTP_PDU_PACKET_COUNT);
     /* initialize packet queue */
-    Receive_Packet.ready = false;
-    Receive_Packet.pdu_len = 0;
-    rv = pthread_cond_init(&Receive_Packet_Flag, &attr);
-    if (rv != 0) {
-        fprintf(stderr,
-            "MS/TP Interface: %s\n cannot allocate PThread Condition.\n",
-            ifname);
-        exit(1);
-    }
-    rv = pthread_mutex_init(&Receive_Packet_Mutex, NULL);
-    if (rv != 0) {
-        fprintf(stderr,
-            "MS/TP Interface: %s\n cannot allocate PThread Mutex.\n", ifname);
-        exit(1);
-    }
+    MPSC_Ringbuf_Init(&Receive_Queue, (uint8_t *)&Receive_Buffer,
+        Receive_Sequence, sizeof(DLMSTP_PACKET), MSTP_RECEIVE_PACKET_COUNT);
+    MPSC_Ringbuf_Notify_Set(&Receive_Queue, dlmstp_receive_notify, NULL);
     /* initialize hardware */
     if (ifname) {
         RS485_Set_Interface(ifname);
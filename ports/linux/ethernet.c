@@ -35,6 +35,9 @@
 #include <stdint.h> /* for standard integer types uint8_t etc. */
 #include <stdbool.h> /* for the standard bool type. */
 
+#include <poll.h>
+#include <sys/mman.h>
+#include <linux/filter.h>
 #include "bacport.h"
 #include "bacnet/bacdef.h"
 #include "bacnet/datalink/ethernet.h"
@@ -52,8 +55,39 @@ uint8_t Ethernet_Empty_MAC[MAX_MAC_LEN] = { 0, 0, 0, 0, 0, 0 };
 /* my local device data - MAC address */
 uint8_t Ethernet_MAC_Address[MAX_MAC_LEN] = { 0 };
 
+/* Frames are received from a TPACKET_V3 memory mapped ring, and sent
+   through a TPACKET_V2 memory mapped ring on a second socket. A BPF
+   filter lets the kernel discard everything except BACnet LLC frames
+   for us. If a ring cannot be set up, read() and sendto() are used. */
+#ifndef BACNET_ETHERNET_RX_BLOCK_SIZE
+#define BACNET_ETHERNET_RX_BLOCK_SIZE (1 << 16)
+#endif
+#ifndef BACNET_ETHERNET_RX_BLOCK_NR
+#define BACNET_ETHERNET_RX_BLOCK_NR 16
+#endif
+/* milliseconds before a partly filled block is handed to us */
+#ifndef BACNET_ETHERNET_RX_BLOCK_TIMEOUT
+#define BACNET_ETHERNET_RX_BLOCK_TIMEOUT 4
+#endif
+#ifndef BACNET_ETHERNET_TX_FRAME_NR
+#define BACNET_ETHERNET_TX_FRAME_NR 32
+#endif
+#define ETHERNET_RING_FRAME_SIZE 2048
+#define ETHERNET_TX_BLOCK_SIZE 4096
+
 static int eth802_sockfd = -1; /* 802.2 file handle */
-static struct sockaddr eth_addr = { 0 }; /* used for binding 802.2 */
+static int eth802_tx_sockfd = -1; /* 802.2 transmit ring handle */
+static struct sockaddr_ll eth_addr = { 0 }; /* used for binding 802.2 */
+/* receive ring */
+static uint8_t *Rx_Ring = NULL;
+static unsigned Rx_Block_Index = 0;
+static struct tpacket3_hdr *Rx_Packet = NULL;
+static uint32_t Rx_Packets_Left = 0;
+/* transmit ring */
+static uint8_t *Tx_Ring = NULL;
+static unsigned Tx_Frame_Index = 0;
+/* interface counters */
+static ETHERNET_STATISTICS Ethernet_Statistics;
 
 bool ethernet_valid(void)
 {
@@ -62,6 +96,22 @@ bool ethernet_valid(void)
 
 void ethernet_cleanup(void)
 {
+    if (Rx_Ring) {
+        munmap(Rx_Ring,
+            BACNET_ETHERNET_RX_BLOCK_SIZE * BACNET_ETHERNET_RX_BLOCK_NR);
+        Rx_Ring = NULL;
+        Rx_Packet = NULL;
+        Rx_Packets_Left = 0;
+        Rx_Block_Index = 0;
+    }
+    if (Tx_Ring) {
+        munmap(Tx_Ring, ETHERNET_RING_FRAME_SIZE * BACNET_ETHERNET_TX_FRAME_NR);
+        Tx_Ring = NULL;
+        Tx_Frame_Index = 0;
+    }
+    if (eth802_tx_sockfd >= 0)
+        close(eth802_tx_sockfd);
+    eth802_tx_sockfd = -1;
     if (ethernet_valid())
         close(eth802_sockfd);
     eth802_sockfd = -1;
@@ -69,35 +119,143 @@ void ethernet_cleanup(void)
     return;
 }
 
-#if 0
-/*----------------------------------------------------------------------
- Portable function to set a socket into nonblocking mode.
- Calling this on a socket causes all future read() and write() calls on
- that socket to do only as much as they can immediately, and return
- without waiting.
- If no data can be read or written, they return -1 and set errno
- to EAGAIN (or EWOULDBLOCK).
- Thanks to Bjorn Reese for this code.
-----------------------------------------------------------------------*/
-int setNonblocking(
-    int fd)
+/* attach a BPF program that accepts only BACnet LLC frames
+   addressed to us or to the broadcast address */
+static int ethernet_filter_attach(int sock_fd)
 {
-    int flags;
+    uint32_t mac_lo = 0;
+    uint16_t mac_hi = 0;
+    struct sock_fprog fprog;
+
+    mac_hi = ((uint16_t)Ethernet_MAC_Address[0] << 8) | Ethernet_MAC_Address[1];
+    mac_lo = ((uint32_t)Ethernet_MAC_Address[2] << 24) |
+        ((uint32_t)Ethernet_MAC_Address[3] << 16) |
+        ((uint32_t)Ethernet_MAC_Address[4] << 8) | Ethernet_MAC_Address[5];
+    {
+        struct sock_filter code[] = {
+            /* 802.3 length, not an Ethernet II type */
+            BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 12),
+            BPF_JUMP(BPF_JMP | BPF_JGT | BPF_K, 1500, 12, 0),
+            /* DSAP and SSAP for BACnet */
+            BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 14),
+            BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0x8282, 0, 10),
+            /* LLC control - UI */
+            BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 16),
+            BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0x03, 0, 8),
+            /* destination MAC: broadcast */
+            BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 2),
+            BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0xFFFFFFFF, 0, 2),
+            BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 0),
+            BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0xFFFF, 3, 4),
+            /* destination MAC: ours */
+            BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, mac_lo, 0, 3),
+            BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 0),
+            BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, mac_hi, 0, 1),
+            BPF_STMT(BPF_RET | BPF_K, 0xFFFF),
+            BPF_STMT(BPF_RET | BPF_K, 0),
+        };
+
+        if (memcmp(Ethernet_MAC_Address, Ethernet_Empty_MAC, 6) == 0) {
+            /* our MAC is unknown - accept any destination */
+            code[6] = (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JA, 6, 0, 0);
+        }
+        fprog.len = sizeof(code) / sizeof(code[0]);
+        fprog.filter = code;
 
-    if (-1 == (flags = fcntl(fd, F_GETFL, 0)))
-        flags = 0;
-    return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+        return setsockopt(
+            sock_fd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog));
+    }
+}
+
+/* set up and map the TPACKET_V3 receive ring */
+static bool ethernet_rx_ring_init(int sock_fd)
+{
+    int version = TPACKET_V3;
+    struct tpacket_req3 req = { 0 };
+    void *ring = NULL;
+
+    if (setsockopt(sock_fd, SOL_PACKET, PACKET_VERSION, &version,
+            sizeof(version)) < 0) {
+        return false;
+    }
+    req.tp_block_size = BACNET_ETHERNET_RX_BLOCK_SIZE;
+    req.tp_block_nr = BACNET_ETHERNET_RX_BLOCK_NR;
+    req.tp_frame_size = ETHERNET_RING_FRAME_SIZE;
+    req.tp_frame_nr = (BACNET_ETHERNET_RX_BLOCK_SIZE / ETHERNET_RING_FRAME_SIZE) *
+        BACNET_ETHERNET_RX_BLOCK_NR;
+    req.tp_retire_blk_tov = BACNET_ETHERNET_RX_BLOCK_TIMEOUT;
+    if (setsockopt(sock_fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) <
+        0) {
+        return false;
+    }
+    ring = mmap(NULL, BACNET_ETHERNET_RX_BLOCK_SIZE * BACNET_ETHERNET_RX_BLOCK_NR,
+        PROT_READ | PROT_WRITE, MAP_SHARED, sock_fd, 0);
+    if (ring == MAP_FAILED) {
+        return false;
+    }
+    Rx_Ring = ring;
+    Rx_Block_Index = 0;
+    Rx_Packet = NULL;
+    Rx_Packets_Left = 0;
+
+    return true;
+}
+
+/* open a send-only socket with a TPACKET_V2 transmit ring */
+static bool ethernet_tx_ring_init(int ifindex)
+{
+    int version = TPACKET_V2;
+    struct tpacket_req req = { 0 };
+    struct sockaddr_ll addr = { 0 };
+    void *ring = NULL;
+    int sock_fd = -1;
+
+    /* protocol zero: this socket never receives */
+    sock_fd = socket(PF_PACKET, SOCK_RAW, 0);
+    if (sock_fd < 0) {
+        return false;
+    }
+    req.tp_block_size = ETHERNET_TX_BLOCK_SIZE;
+    req.tp_frame_size = ETHERNET_RING_FRAME_SIZE;
+    req.tp_frame_nr = BACNET_ETHERNET_TX_FRAME_NR;
+    req.tp_block_nr = (ETHERNET_RING_FRAME_SIZE * BACNET_ETHERNET_TX_FRAME_NR) /
+        ETHERNET_TX_BLOCK_SIZE;
+    if ((setsockopt(sock_fd, SOL_PACKET, PACKET_VERSION, &version,
+             sizeof(version)) < 0) ||
+        (setsockopt(sock_fd, SOL_PACKET, PACKET_TX_RING, &req, sizeof(req)) <
+            0)) {
+        close(sock_fd);
+        return false;
+    }
+    ring = mmap(NULL, ETHERNET_RING_FRAME_SIZE * BACNET_ETHERNET_TX_FRAME_NR,
+        PROT_READ | PROT_WRITE, MAP_SHARED, sock_fd, 0);
+    if (ring == MAP_FAILED) {
+        close(sock_fd);
+        return false;
+    }
+    addr.sll_family = AF_PACKET;
+    addr.sll_ifindex = ifindex;
+    if (bind(sock_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        munmap(ring, ETHERNET_RING_FRAME_SIZE * BACNET_ETHERNET_TX_FRAME_NR);
+        close(sock_fd);
+        return false;
+    }
+    eth802_tx_sockfd = sock_fd;
+    Tx_Ring = ring;
+    Tx_Frame_Index = 0;
+
+    return true;
 }
-#endif
 
 /* opens an 802.2 socket to receive and send packets */
-static int ethernet_bind(struct sockaddr *eth_addr, char *interface_name)
+static int ethernet_bind(struct sockaddr_ll *eth_addr, char *interface_name)
 {
     int sock_fd = -1; /* return value */
-#if 0
-    int sockopt = 0;
-#endif
+    int ifindex = 0;
     int uid = 0;
+#if defined(PACKET_IGNORE_OUTGOING)
+    int sockopt = 1;
+#endif
 
     fprintf(stderr, "ethernet: opening \"%s\"\n", interface_name);
     /* check to see if we are being run as root */
@@ -112,11 +270,9 @@ static int ethernet_bind(struct sockaddr *eth_addr, char *interface_name)
     /* modules.conf (or in modutils/alias on Debian with update-modules) */
     /* alias net-pf-17 af_packet */
     /* Then follow it by: # modprobe af_packet */
-    /* Note: PF_INET/SOCK_PACKET has been replaced with
-       PF_PACKET/(SOCK_PACKET, SOCK_DGRAM, SOCK_RAW). */
 
     /* Attempt to open the socket for 802.2 ethernet frames */
-    if ((sock_fd = socket(PF_INET, SOCK_PACKET, htons(ETH_P_802_2))) < 0) {
+    if ((sock_fd = socket(PF_PACKET, SOCK_RAW, htons(ETH_P_802_2))) < 0) {
         /* Error occured */
         fprintf(
             stderr, "ethernet: Error opening socket: %s\n", strerror(errno));
@@ -129,24 +285,35 @@ static int ethernet_bind(struct sockaddr *eth_addr, char *interface_name)
             "# modprobe af_packet\n");
         exit(-1);
     }
-#if 0
-    /* It is very advisable to do a IP_HDRINCL call, to make sure
-       that the kernel knows the header is included in the data,
-       and doesn't insert its own header into the packet before our data */
-    if (setsockopt(sock_fd, IPPROTO_IP, IP_HDRINCL, &sockopt,
-            sizeof(sockopt)) < 0) {
-        printf("Warning: Cannot set HDRINCL!\n");
+    ifindex = (int)if_nametoindex(interface_name);
+    if (ifindex == 0) {
+        fprintf(stderr, "ethernet: Unknown interface \"%s\": %s\n",
+            interface_name, strerror(errno));
+        close(sock_fd);
+        exit(-1);
+    }
+    if (ethernet_filter_attach(sock_fd) < 0) {
+        fprintf(stderr, "ethernet: Unable to attach BPF filter: %s\n",
+            strerror(errno));
     }
+#if defined(PACKET_IGNORE_OUTGOING)
+    /* frames we send are not for us */
+    (void)setsockopt(sock_fd, SOL_PACKET, PACKET_IGNORE_OUTGOING, &sockopt,
+        sizeof(sockopt));
 #endif
+    if (!ethernet_rx_ring_init(sock_fd)) {
+        fprintf(stderr, "ethernet: receive ring unavailable: %s\n",
+            strerror(errno));
+    }
     /* Bind the socket to an address */
-    eth_addr->sa_family = PF_INET;
-    /* Clear the memory before copying */
-    memset(eth_addr->sa_data, '\0', sizeof(eth_addr->sa_data));
-    /* Strcpy the interface name into the address */
-    strncpy(eth_addr->sa_data, interface_name, sizeof(eth_addr->sa_data) - 1);
-    fprintf(stderr, "ethernet: binding \"%s\"\n", eth_addr->sa_data);
+    memset(eth_addr, 0, sizeof(*eth_addr));
+    eth_addr->sll_family = AF_PACKET;
+    eth_addr->sll_protocol = htons(ETH_P_802_2);
+    eth_addr->sll_ifindex = ifindex;
+    eth_addr->sll_halen = 6;
+    fprintf(stderr, "ethernet: binding \"%s\"\n", interface_name);
     /* Attempt to bind the socket to the interface */
-    if (bind(sock_fd, eth_addr, sizeof(struct sockaddr)) != 0) {
+    if (bind(sock_fd, (struct sockaddr *)eth_addr, sizeof(*eth_addr)) != 0) {
         /* Bind problem, close socket and return */
         fprintf(stderr, "ethernet: Unable to bind 802.2 socket : %s\n",
             strerror(errno));
@@ -161,6 +328,10 @@ static int ethernet_bind(struct sockaddr *eth_addr, char *interface_name)
         close(sock_fd);
         exit(-1);
     }
+    if (!ethernet_tx_ring_init(ifindex)) {
+        fprintf(stderr, "ethernet: transmit ring unavailable: %s\n",
+            strerror(errno));
+    }
 
     atexit(ethernet_cleanup);
 
@@ -183,6 +354,7 @@ static int get_local_hwaddr(const char *ifname, unsigned char *mac)
         rv = ioctl(fd, SIOCGIFHWADDR, &ifr);
         if (rv >= 0) /* worked okay */
             memcpy(mac, ifr.ifr_hwaddr.sa_data, IFHWADDRLEN);
+        close(fd);
     }
 
     return rv;
@@ -190,6 +362,7 @@ static int get_local_hwaddr(const char *ifname, unsigned char *mac)
 
 bool ethernet_init(char *interface_name)
 {
+    memset(&Ethernet_Statistics, 0, sizeof(Ethernet_Statistics));
     if (interface_name) {
         get_local_hwaddr(interface_name, Ethernet_MAC_Address);
         eth802_sockfd = ethernet_bind(&eth_addr, interface_name);
@@ -201,65 +374,61 @@ bool ethernet_init(char *interface_name)
     return ethernet_valid();
 }
 
+/* copy the interface counters, including kernel ring drops */
+void ethernet_statistics(ETHERNET_STATISTICS *stats)
+{
+    struct tpacket_stats_v3 kstats = { 0 };
+    socklen_t len = sizeof(kstats);
+
+    if (ethernet_valid() &&
+        (getsockopt(eth802_sockfd, SOL_PACKET, PACKET_STATISTICS, &kstats,
+             &len) == 0)) {
+        /* the kernel clears its counters on every read */
+        Ethernet_Statistics.rx_dropped += kstats.tp_drops;
+    }
+    if (stats) {
+        *stats = Ethernet_Statistics;
+    }
+}
+
 int ethernet_send(uint8_t *mtu, int mtu_len)
 {
     int bytes = 0;
 
     /* Send the packet */
-    bytes = sendto(eth802_sockfd, &mtu, mtu_len, 0,
-        (struct sockaddr *)&eth_addr, sizeof(struct sockaddr));
+    bytes = sendto(eth802_sockfd, mtu, mtu_len, 0,
+        (struct sockaddr *)&eth_addr, sizeof(eth_addr));
     /* did it get sent? */
-    if (bytes < 0)
+    if (bytes < 0) {
+        Ethernet_Statistics.tx_errors++;
         fprintf(
             stderr, "ethernet: Error sending packet: %s\n", strerror(errno));
+    } else {
+        Ethernet_Statistics.tx_frames++;
+        Ethernet_Statistics.tx_bytes += bytes;
+    }
 
     return bytes;
 }
 
-/* function to send a packet out the 802.2 socket */
-/* returns number of bytes sent on success, negative on failure */
-int ethernet_send_pdu(BACNET_ADDRESS *dest, /* destination address */
-    BACNET_NPDU_DATA *npdu_data, /* network information */
-    uint8_t *pdu, /* any data to be sent - may be null */
+/* encode the 802.3 and 802.2 LLC headers in front of the PDU */
+/* returns the frame length, or negative on failure */
+static int ethernet_frame_encode(uint8_t *mtu,
+    BACNET_ADDRESS *dest,
+    uint8_t *pdu,
     unsigned pdu_len)
-{ /* number of bytes of data */
-    int i = 0; /* counter */
-    int bytes = 0;
-    BACNET_ADDRESS src = { 0 }; /* source address for npdu */
-    uint8_t mtu[ETHERNET_MPDU_MAX] = { 0 }; /* our buffer */
+{
     int mtu_len = 0;
 
-    (void)npdu_data;
-    /* load the BACnet address for NPDU data */
-    for (i = 0; i < 6; i++) {
-        src.mac[i] = Ethernet_MAC_Address[i];
-        src.mac_len++;
-    }
-
-    /* don't waste time if the socket is not valid */
-    if (eth802_sockfd < 0) {
-        fprintf(stderr, "ethernet: 802.2 socket is invalid!\n");
-        return -1;
-    }
     /* load destination ethernet MAC address */
     if (dest->mac_len == 6) {
-        for (i = 0; i < 6; i++) {
-            mtu[i] = dest->mac[i];
-        }
+        memcpy(&mtu[0], dest->mac, 6);
     } else {
         fprintf(stderr, "ethernet: invalid destination MAC address!\n");
         return -2;
     }
-
     /* load source ethernet MAC address */
-    if (src.mac_len == 6) {
-        for (i = 0; i < 6; i++) {
-            mtu[6 + i] = src.mac[i];
-        }
-    } else {
-        fprintf(stderr, "ethernet: invalid source MAC address!\n");
-        return -3;
-    }
+    memcpy(&mtu[6], Ethernet_MAC_Address, 6);
     /* Logical PDU portion */
     mtu[14] = 0x82; /* DSAP for BACnet */
     mtu[15] = 0x82; /* SSAP for BACnet */
@@ -274,15 +443,185 @@ int ethernet_send_pdu(BACNET_ADDRESS *dest, /* destination address */
     /* packet length - only the logical portion, not the address */
     encode_unsigned16(&mtu[12], 3 + pdu_len);
 
-    /* Send the packet */
-    bytes = sendto(eth802_sockfd, &mtu, mtu_len, 0,
-        (struct sockaddr *)&eth_addr, sizeof(struct sockaddr));
-    /* did it get sent? */
-    if (bytes < 0)
+    return mtu_len;
+}
+
+/* build the frame in the next transmit ring slot and queue it */
+/* returns number of bytes sent on success, negative on failure */
+static int ethernet_tx_ring_send(
+    BACNET_ADDRESS *dest, uint8_t *pdu, unsigned pdu_len)
+{
+    struct tpacket2_hdr *hdr = NULL;
+    struct pollfd pfd;
+    uint8_t *mtu = NULL;
+    int mtu_len = 0;
+
+    hdr = (struct tpacket2_hdr *)(Tx_Ring +
+        (Tx_Frame_Index * ETHERNET_RING_FRAME_SIZE));
+    if (hdr->tp_status != TP_STATUS_AVAILABLE) {
+        /* ring is full - give the kernel a moment to drain it */
+        pfd.fd = eth802_tx_sockfd;
+        pfd.events = POLLOUT;
+        pfd.revents = 0;
+        (void)send(eth802_tx_sockfd, NULL, 0, MSG_DONTWAIT);
+        (void)poll(&pfd, 1, 1);
+        if (hdr->tp_status != TP_STATUS_AVAILABLE) {
+            Ethernet_Statistics.tx_ring_full++;
+            return -5;
+        }
+    }
+    mtu = (uint8_t *)hdr + TPACKET2_HDRLEN - sizeof(struct sockaddr_ll);
+    mtu_len = ethernet_frame_encode(mtu, dest, pdu, pdu_len);
+    if (mtu_len < 0) {
+        return mtu_len;
+    }
+    hdr->tp_len = mtu_len;
+    __sync_synchronize();
+    hdr->tp_status = TP_STATUS_SEND_REQUEST;
+    Tx_Frame_Index = (Tx_Frame_Index + 1) % BACNET_ETHERNET_TX_FRAME_NR;
+    if ((send(eth802_tx_sockfd, NULL, 0, MSG_DONTWAIT) < 0) &&
+        (errno != EAGAIN) && (errno != ENOBUFS)) {
+        Ethernet_Statistics.tx_errors++;
         fprintf(
             stderr, "ethernet: Error sending packet: %s\n", strerror(errno));
+        return -1;
+    }
+    Ethernet_Statistics.tx_frames++;
+    Ethernet_Statistics.tx_bytes += mtu_len;
 
-    return bytes;
+    return mtu_len;
+}
+
+/* function to send a packet out the 802.2 socket */
+/* returns number of bytes sent on success, negative on failure */
+int ethernet_send_pdu(BACNET_ADDRESS *dest, /* destination address */
+    BACNET_NPDU_DATA *npdu_data, /* network information */
+    uint8_t *pdu, /* any data to be sent - may be null */
+    unsigned pdu_len)
+{ /* number of bytes of data */
+    uint8_t mtu[ETHERNET_MPDU_MAX] = { 0 }; /* our buffer */
+    int mtu_len = 0;
+
+    (void)npdu_data;
+    /* don't waste time if the socket is not valid */
+    if (eth802_sockfd < 0) {
+        fprintf(stderr, "ethernet: 802.2 socket is invalid!\n");
+        return -1;
+    }
+    if (Tx_Ring) {
+        return ethernet_tx_ring_send(dest, pdu, pdu_len);
+    }
+    mtu_len = ethernet_frame_encode(mtu, dest, pdu, pdu_len);
+    if (mtu_len < 0) {
+        return mtu_len;
+    }
+
+    return ethernet_send(mtu, mtu_len);
+}
+
+/* validate a received frame and copy out its PDU */
+/* returns the number of octets in the PDU, or zero if not for us */
+static uint16_t ethernet_frame_decode(uint8_t *buf,
+    unsigned buf_len,
+    BACNET_ADDRESS *src,
+    uint8_t *pdu,
+    uint16_t max_pdu)
+{
+    uint16_t pdu_len = 0;
+
+    Ethernet_Statistics.rx_frames++;
+    Ethernet_Statistics.rx_bytes += buf_len;
+    /* the signature of an 802.2 BACnet packet */
+    if ((buf_len < ETHERNET_HEADER_MAX) || (buf[14] != 0x82) ||
+        (buf[15] != 0x82)) {
+        /*fprintf(stderr,"ethernet: Non-BACnet packet\n"); */
+        Ethernet_Statistics.rx_discarded++;
+        return 0;
+    }
+    /* check destination address for when */
+    /* the Ethernet card is in promiscious mode */
+    if ((memcmp(&buf[0], Ethernet_MAC_Address, 6) != 0) &&
+        (memcmp(&buf[0], Ethernet_Broadcast, 6) != 0)) {
+        /*fprintf(stderr, "ethernet: This packet isn't for us\n"); */
+        Ethernet_Statistics.rx_discarded++;
+        return 0;
+    }
+    /* copy the source address */
+    src->mac_len = 6;
+    memmove(src->mac, &buf[6], 6);
+
+    (void)decode_unsigned16(&buf[12], &pdu_len);
+    pdu_len -= 3 /* DSAP, SSAP, LLC Control */;
+    /* copy the buffer into the PDU */
+    if ((pdu_len < max_pdu) && ((17U + pdu_len) <= buf_len))
+        memmove(&pdu[0], &buf[17], pdu_len);
+    /* ignore packets that are too large */
+    else {
+        Ethernet_Statistics.rx_discarded++;
+        pdu_len = 0;
+    }
+
+    return pdu_len;
+}
+
+/* get the next frame from the receive ring, waiting for a block
+   to be handed over if needed */
+static struct tpacket3_hdr *ethernet_rx_ring_packet(unsigned timeout)
+{
+    struct tpacket_block_desc *block = NULL;
+    struct pollfd pfd;
+
+    if (Rx_Packet) {
+        return Rx_Packet;
+    }
+    block = (struct tpacket_block_desc *)(Rx_Ring +
+        (Rx_Block_Index * BACNET_ETHERNET_RX_BLOCK_SIZE));
+    if ((block->hdr.bh1.block_status & TP_STATUS_USER) == 0) {
+        pfd.fd = eth802_sockfd;
+        pfd.events = POLLIN | POLLERR;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, (int)timeout) <= 0) {
+            return NULL;
+        }
+        if ((block->hdr.bh1.block_status & TP_STATUS_USER) == 0) {
+            return NULL;
+        }
+    }
+    __sync_synchronize();
+    Ethernet_Statistics.rx_blocks++;
+    Rx_Packets_Left = block->hdr.bh1.num_pkts;
+    if (Rx_Packets_Left) {
+        Rx_Packet = (struct tpacket3_hdr *)((uint8_t *)block +
+            block->hdr.bh1.offset_to_first_pkt);
+    } else {
+        block->hdr.bh1.block_status = TP_STATUS_KERNEL;
+        Rx_Block_Index = (Rx_Block_Index + 1) % BACNET_ETHERNET_RX_BLOCK_NR;
+    }
+
+    return Rx_Packet;
+}
+
+/* done with the current ring frame; hand the block back when empty */
+static void ethernet_rx_ring_release(void)
+{
+    struct tpacket_block_desc *block = NULL;
+
+    if (!Rx_Packet) {
+        return;
+    }
+    Rx_Packets_Left--;
+    if (Rx_Packets_Left) {
+        Rx_Packet =
+            (struct tpacket3_hdr *)((uint8_t *)Rx_Packet +
+                Rx_Packet->tp_next_offset);
+    } else {
+        block = (struct tpacket_block_desc *)(Rx_Ring +
+            (Rx_Block_Index * BACNET_ETHERNET_RX_BLOCK_SIZE));
+        __sync_synchronize();
+        block->hdr.bh1.block_status = TP_STATUS_KERNEL;
+        Rx_Block_Index = (Rx_Block_Index + 1) % BACNET_ETHERNET_RX_BLOCK_NR;
+        Rx_Packet = NULL;
+    }
 }
 
 /* receives an 802.2 framed packet */
@@ -295,6 +634,8 @@ uint16_t ethernet_receive(BACNET_ADDRESS *src, /* source address */
     int received_bytes;
     uint8_t buf[ETHERNET_MPDU_MAX] = { 0 }; /* data */
     uint16_t pdu_len = 0; /* return value */
+    struct tpacket3_hdr *packet = NULL;
+    struct sockaddr_ll *sll = NULL;
     fd_set read_fds;
     int max;
     struct timeval select_timeout;
@@ -303,6 +644,22 @@ uint16_t ethernet_receive(BACNET_ADDRESS *src, /* source address */
     if (eth802_sockfd <= 0)
         return 0;
 
+    if (Rx_Ring) {
+        packet = ethernet_rx_ring_packet(timeout);
+        if (!packet) {
+            return 0;
+        }
+        sll = (struct sockaddr_ll *)((uint8_t *)packet +
+            TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+        if (sll->sll_pkttype != PACKET_OUTGOING) {
+            pdu_len = ethernet_frame_decode((uint8_t *)packet + packet->tp_mac,
+                packet->tp_snaplen, src, pdu, max_pdu);
+        }
+        ethernet_rx_ring_release();
+
+        return pdu_len;
+    }
+
     /* we could just use a non-blocking socket, but that consumes all
        the CPU time.  We can use a timeout; it is only supported as
        a select. */
@@ -337,33 +694,8 @@ uint16_t ethernet_receive(BACNET_ADDRESS *src, /* source address */
     if (received_bytes == 0)
         return 0;
 
-    /* the signature of an 802.2 BACnet packet */
-    if ((buf[14] != 0x82) && (buf[15] != 0x82)) {
-        /*fprintf(stderr,"ethernet: Non-BACnet packet\n"); */
-        return 0;
-    }
-    /* copy the source address */
-    src->mac_len = 6;
-    memmove(src->mac, &buf[6], 6);
-
-    /* check destination address for when */
-    /* the Ethernet card is in promiscious mode */
-    if ((memcmp(&buf[0], Ethernet_MAC_Address, 6) != 0) &&
-        (memcmp(&buf[0], Ethernet_Broadcast, 6) != 0)) {
-        /*fprintf(stderr, "ethernet: This packet isn't for us\n"); */
-        return 0;
-    }
-
-    (void)decode_unsigned16(&buf[12], &pdu_len);
-    pdu_len -= 3 /* DSAP, SSAP, LLC Control */;
-    /* copy the buffer into the PDU */
-    if (pdu_len < max_pdu)
-        memmove(&pdu[0], &buf[17], pdu_len);
-    /* ignore packets that are too large */
-    else
-        pdu_len = 0;
-
-    return pdu_len;
+    return ethernet_frame_decode(
+        &buf[0], (unsigned)received_bytes, src, pdu, max_pdu);
 }
 
 void ethernet_set_my_address(BACNET_ADDRESS *my_address)
@@ -0,0 +1,82 @@
+/**
+ * @file
+ * @brief Linux shared memory for the process image
+ *
+ * The process image is a POSIX shared memory object, for example
+ * /dev/shm/bacnet, mapped into the BACnet server and into each
+ * I/O driver process.
+ *
+ * @section LICENSE
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "bacnet/basic/sys/process_image.h"
+
+/**
+ * Maps a shared memory object for a process image
+ *
+ * @param name - shared memory object name, such as "/bacnet"
+ * @param size [in,out] - when creating, the size of the process image;
+ *  when attaching, set to the size of the existing object
+ * @param create - true to create (or resize) the object
+ * @return start of the mapped memory, or NULL on error
+ */
+void *Process_Image_Map(const char *name, size_t *size, bool create)
+{
+    struct stat st;
+    void *memory;
+    int fd;
+
+    if (!name || !size) {
+        return NULL;
+    }
+    fd = shm_open(name, create ? (O_RDWR | O_CREAT) : O_RDWR, 0660);
+    if (fd < 0) {
+        perror("process image: shm_open");
+        return NULL;
+    }
+    if (create) {
+        if (ftruncate(fd, (off_t)*size) < 0) {
+            perror("process image: ftruncate");
+            close(fd);
+            return NULL;
+        }
+    } else {
+        if (fstat(fd, &st) < 0) {
+            perror("process image: fstat");
+            close(fd);
+            return NULL;
+        }
+        *size = (size_t)st.st_size;
+    }
+    memory = mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    /* the mapping stays valid after the descriptor is closed */
+    close(fd);
+    if (memory == MAP_FAILED) {
+        perror("process image: mmap");
+        return NULL;
+    }
+
+    return memory;
+}
+
+/**
+ * Unmaps a process image mapped with Process_Image_Map()
+ *
+ * @param memory - start of the mapped memory
+ * @param size - size of the mapped memory
+ */
+void Process_Image_Unmap(void *memory, size_t size)
+{
+    if (memory) {
+        munmap(memory, size);
+    }
+}
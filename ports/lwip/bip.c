@@ -128,6 +128,33 @@ bool bip_get_broadcast_addr(BACNET_IP_ADDRESS *addr)
     return bvlc_address_copy(addr, &BIP_Broadcast_Address);
 }
 
+/**
+ * @brief Get the BACnet/IP subnet mask CIDR prefix
+ * @return subnet mask CIDR prefix 1..32
+ */
+uint8_t bip_get_subnet_prefix(void)
+{
+    uint32_t address = 0;
+    uint32_t broadcast = 0;
+    uint32_t test_broadcast = 0;
+    uint32_t mask = 0;
+    uint8_t prefix = 0;
+
+    decode_unsigned32(&BIP_Address.address[0], &address);
+    decode_unsigned32(&BIP_Broadcast_Address.address[0], &broadcast);
+    /* calculate the subnet prefix from the broadcast address, in host
+       byte order, trying the longest prefix first */
+    for (prefix = 32; prefix > 1; prefix--) {
+        mask = 0xFFFFFFFFUL << (32 - prefix);
+        test_broadcast = (address & mask) | (~mask);
+        if (test_broadcast == broadcast) {
+            break;
+        }
+    }
+
+    return prefix;
+}
+
 /**
  * @brief Set the BACnet IPv4 UDP port number
  * @param port - IPv4 UDP port number - in host byte order
@@ -266,6 +293,49 @@ int bip_send_mpdu(
     return mtu_len;
 }
 
+/** Function to send a packet out the BACnet/IP socket (Annex J), from
+ * a BVLC header and an NPDU in their own buffers.
+ * @ingroup DLBIP
+ *
+ * @param dest [in] Destination address and port
+ * @param header [in] BVLC header
+ * @param header_len [in] number of bytes of the BVLC header
+ * @param npdu [in] NPDU to send after the BVLC header
+ * @param npdu_len [in] number of bytes of the NPDU
+ * @return number of bytes sent, or 0 on failure.
+ */
+int bip_send_mpdu_iov(BACNET_IP_ADDRESS *dest,
+    uint8_t *header,
+    uint16_t header_len,
+    uint8_t *npdu,
+    uint16_t npdu_len)
+{
+    struct pbuf *pkt = NULL;
+    /* addr and port in host format */
+    ip_addr_t dst_ip;
+    uint16_t port = 0;
+    uint16_t mtu_len = header_len + npdu_len;
+    err_t status = ERR_OK;
+
+    pkt = pbuf_alloc(PBUF_TRANSPORT, mtu_len, PBUF_POOL);
+    if (pkt == NULL) {
+        return 0;
+    }
+    bip_decode_bip_address(dest, &dst_ip, &port);
+    /* the header and the NPDU are taken straight into the packet */
+    pbuf_take(pkt, header, header_len);
+    pbuf_take_at(pkt, npdu, npdu_len, header_len);
+    status = udp_sendto(Server_upcb, pkt, &dst_ip, port);
+    if (status == ERR_OK) {
+        BIP_STATS_INC(xmit);
+    } else {
+        mtu_len = 0;
+    }
+    pbuf_free(pkt);
+
+    return mtu_len;
+}
+
 /** Send the Original Broadcast or Unicast messages
  *
  * @param dest [in] Destination address (may encode an IP address and port #).
@@ -472,6 +472,62 @@ int bip_send_mpdu(BACNET_IP_ADDRESS *dest, uint8_t *mtu, uint16_t mtu_len)
     return rv;
 }
 
+/**
+ * The send function for BACnet/IP driver layer that sends the BVLC
+ * header and the NPDU from their own buffers, without copying them
+ * into one MTU buffer first.
+ *
+ * @param dest - Points to a BACNET_IP_ADDRESS structure containing the
+ *  destination address.
+ * @param header - the BVLC header to send
+ * @param header_len - the number of bytes of the BVLC header
+ * @param npdu - the NPDU to send after the BVLC header
+ * @param npdu_len - the number of bytes of the NPDU
+ *
+ * @return Upon successful completion, returns the number of bytes sent.
+ *  Otherwise, -1 shall be returned and errno set to indicate the error.
+ */
+int bip_send_mpdu_iov(BACNET_IP_ADDRESS *dest,
+    uint8_t *header,
+    uint16_t header_len,
+    uint8_t *npdu,
+    uint16_t npdu_len)
+{
+    struct sockaddr_in bip_dest = { 0 };
+    WSABUF buffers[2];
+    DWORD bytes_sent = 0;
+    int rv = 0;
+
+    /* assumes that the driver has already been initialized */
+    if (BIP_Socket == INVALID_SOCKET) {
+        if (BIP_Debug) {
+            fprintf(stderr, "BIP: driver not initialized!\n");
+            fflush(stderr);
+        }
+        return -1;
+    }
+    /* load destination IP address */
+    bip_dest.sin_family = AF_INET;
+    memcpy(&bip_dest.sin_addr.s_addr, &dest->address[0], 4);
+    bip_dest.sin_port = htons(dest->port);
+    /* gather the header and the NPDU into one datagram */
+    buffers[0].buf = (char *)header;
+    buffers[0].len = header_len;
+    buffers[1].buf = (char *)npdu;
+    buffers[1].len = npdu_len;
+    /* Send the packet */
+    debug_print_ipv4("Sending MPDU->", &bip_dest.sin_addr, bip_dest.sin_port,
+        header_len + npdu_len);
+    rv = WSASendTo(BIP_Socket, buffers, 2, &bytes_sent, 0,
+        (struct sockaddr *)&bip_dest, sizeof(struct sockaddr), NULL, NULL);
+    if (rv == SOCKET_ERROR) {
+        print_last_error("WSASendTo");
+        return -1;
+    }
+
+    return (int)bytes_sent;
+}
+
 /**
  * BACnet/IP Datalink Receive handler.
  *
@@ -0,0 +1,80 @@
+/**
+ * @file
+ * @brief Windows shared memory for the process image
+ *
+ * The process image is a named file mapping backed by the paging file,
+ * for example "Local\\bacnet", mapped into the BACnet server and into
+ * each I/O driver process.
+ *
+ * @section LICENSE
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "bacport.h"
+#include "bacnet/basic/sys/process_image.h"
+
+/**
+ * Maps a named file mapping for a process image
+ *
+ * @param name - file mapping name
+ * @param size [in,out] - when creating, the size of the process image;
+ *  when attaching, set to the size of the existing mapping
+ * @param create - true to create the mapping
+ * @return start of the mapped memory, or NULL on error
+ */
+void *Process_Image_Map(const char *name, size_t *size, bool create)
+{
+    MEMORY_BASIC_INFORMATION info;
+    HANDLE mapping;
+    void *memory;
+
+    if (!name || !size) {
+        return NULL;
+    }
+    if (create) {
+        mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL,
+            PAGE_READWRITE, 0, (DWORD)*size, name);
+    } else {
+        mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name);
+    }
+    if (!mapping) {
+        fprintf(stderr, "process image: mapping failed (%lu)\n",
+            (unsigned long)GetLastError());
+        return NULL;
+    }
+    memory = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    /* the view keeps the mapping open after the handle is closed */
+    CloseHandle(mapping);
+    if (!memory) {
+        fprintf(stderr, "process image: view failed (%lu)\n",
+            (unsigned long)GetLastError());
+        return NULL;
+    }
+    if (!create) {
+        if (VirtualQuery(memory, &info, sizeof(info)) == 0) {
+            UnmapViewOfFile(memory);
+            return NULL;
+        }
+        *size = info.RegionSize;
+    }
+
+    return memory;
+}
+
+/**
+ * Unmaps a process image mapped with Process_Image_Map()
+ *
+ * @param memory - start of the mapped memory
+ * @param size - size of the mapped memory
+ */
+void Process_Image_Unmap(void *memory, size_t size)
+{
+    (void)size;
+    if (memory) {
+        UnmapViewOfFile(memory);
+    }
+}
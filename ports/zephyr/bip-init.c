@@ -298,6 +298,58 @@ int bip_send_mpdu(BACNET_IP_ADDRESS *dest, uint8_t *mtu, uint16_t mtu_len)
         (struct sockaddr *)&bip_dest, sizeof(struct sockaddr));
 }
 
+/**
+ * The send function for BACnet/IP driver layer that sends the BVLC
+ * header and the NPDU from their own buffers, without copying them
+ * into one MTU buffer first.
+ *
+ * @param dest - Points to a BACNET_IP_ADDRESS structure containing the
+ *  destination address.
+ * @param header - the BVLC header to send
+ * @param header_len - the number of bytes of the BVLC header
+ * @param npdu - the NPDU to send after the BVLC header
+ * @param npdu_len - the number of bytes of the NPDU
+ *
+ * @return Upon successful completion, returns the number of bytes sent.
+ *  Otherwise, -1 shall be returned and errno set to indicate the error.
+ */
+int bip_send_mpdu_iov(BACNET_IP_ADDRESS *dest,
+    uint8_t *header,
+    uint16_t header_len,
+    uint8_t *npdu,
+    uint16_t npdu_len)
+{
+    struct sockaddr_in bip_dest = { 0 };
+    struct iovec iov[2];
+    struct msghdr msg = { 0 };
+
+    /* assumes that the driver has already been initialized */
+    if (BIP_Socket < 0) {
+        LOG_ERR("%s:%d - Socket not initialized!", THIS_FILE, __LINE__);
+        return BIP_Socket;
+    }
+
+    /* load destination IP address */
+    bip_dest.sin_family = AF_INET;
+    memcpy(&bip_dest.sin_addr.s_addr, &dest->address[0], IP_ADDRESS_MAX);
+    bip_dest.sin_port = htons(dest->port);
+
+    /* gather the header and the NPDU into one datagram */
+    iov[0].iov_base = header;
+    iov[0].iov_len = header_len;
+    iov[1].iov_base = npdu;
+    iov[1].iov_len = npdu_len;
+    msg.msg_name = &bip_dest;
+    msg.msg_namelen = sizeof(bip_dest);
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+
+    /* Send the packet */
+    debug_print_ipv4("Sending MPDU->", &bip_dest.sin_addr, bip_dest.sin_port,
+        header_len + npdu_len);
+    return zsock_sendmsg(BIP_Socket, &msg, 0);
+}
+
 /**
  * BACnet/IP Datalink Receive handler.
  *
@@ -203,6 +203,13 @@ bool bacnet_is_context_specific(uint8_t *apdu, uint32_t apdu_size);
         uint8_t * apdu,
         uint8_t tag_number,
         BACNET_BIT_STRING * bit_string);
+    BACNET_STACK_EXPORT
+    int encode_application_status_flags(
+        uint8_t * apdu,
+        bool in_alarm,
+        bool fault,
+        bool overridden,
+        bool out_of_service);
 
 /* from clause 20.2.6 Encoding of a Real Number Value */
 /* and 20.2.1 General Rules for Encoding BACnet Tags */
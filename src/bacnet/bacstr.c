@@ -72,13 +72,9 @@ size_t strnlen(const char *, size_t);
  */
 void bitstring_init(BACNET_BIT_STRING *bit_string)
 {
-    unsigned i;
-
     if (bit_string) {
         bit_string->bits_used = 0;
-        for (i = 0; i < MAX_BITSTRING_BYTES; i++) {
-            bit_string->value[i] = 0;
-        }
+        memset(bit_string->value, 0, sizeof(bit_string->value));
     }
 }
 
@@ -92,8 +88,8 @@ void bitstring_init(BACNET_BIT_STRING *bit_string)
 void bitstring_set_bit(
     BACNET_BIT_STRING *bit_string, uint8_t bit_number, bool value)
 {
-    unsigned byte_number = bit_number / 8;
-    uint8_t bit_mask = 1;
+    unsigned byte_number = bit_number >> 3;
+    uint8_t bit_mask;
 
     if (bit_string) {
         if (byte_number < MAX_BITSTRING_BYTES) {
@@ -101,7 +97,7 @@ void bitstring_set_bit(
             if (bit_string->bits_used < (bit_number + 1)) {
                 bit_string->bits_used = bit_number + 1;
             }
-            bit_mask = bit_mask << (bit_number - (byte_number * 8));
+            bit_mask = (uint8_t)(1 << (bit_number & 7));
             if (value) {
                 bit_string->value[byte_number] |= bit_mask;
             } else {
@@ -123,21 +119,71 @@ void bitstring_set_bit(
 bool bitstring_bit(BACNET_BIT_STRING *bit_string, uint8_t bit_number)
 {
     bool value = false;
-    unsigned byte_number = bit_number / 8;
-    uint8_t bit_mask = 1;
+    unsigned byte_number = bit_number >> 3;
 
     if (bit_string) {
-        if (bit_number < (MAX_BITSTRING_BYTES * 8)) {
-            bit_mask = bit_mask << (bit_number - (byte_number * 8));
-            if (bit_string->value[byte_number] & bit_mask) {
-                value = true;
-            }
+        if (byte_number < MAX_BITSTRING_BYTES) {
+            value = (bit_string->value[byte_number] >> (bit_number & 7)) & 1;
         }
     }
 
     return value;
 }
 
+/**
+ * Initialize a bit string from a word of up to 32 bits.
+ *
+ * @param bit_string  Pointer to the bit string structure.
+ * @param bits_used  Number of bits used [0..32]
+ * @param bits  Value of the bits, bit 0 of the word is bit 0
+ *
+ * @return true on success, false otherwise.
+ */
+bool bitstring_init_bits32(
+    BACNET_BIT_STRING *bit_string, uint8_t bits_used, uint32_t bits)
+{
+    unsigned i;
+
+    if (!bit_string || (bits_used > 32) ||
+        (bits_used > (MAX_BITSTRING_BYTES * 8))) {
+        return false;
+    }
+    bitstring_init(bit_string);
+    if (bits_used < 32) {
+        bits &= (1UL << bits_used) - 1UL;
+    }
+    for (i = 0; (i * 8) < bits_used; i++) {
+        bit_string->value[i] = (uint8_t)(bits >> (i * 8));
+    }
+    bit_string->bits_used = bits_used;
+
+    return true;
+}
+
+/**
+ * Return the first 32 bits of the bit string as a word.
+ *
+ * @param bit_string  Pointer to the bit string structure.
+ *
+ * @return Value of the bits, bit 0 of the word is bit 0
+ */
+uint32_t bitstring_bits32(BACNET_BIT_STRING *bit_string)
+{
+    uint32_t bits = 0;
+    unsigned i;
+
+    if (bit_string) {
+        for (i = 0; (i < 4) && (i < MAX_BITSTRING_BYTES); i++) {
+            bits |= (uint32_t)bit_string->value[i] << (i * 8);
+        }
+        if (bit_string->bits_used < 32) {
+            bits &= (1UL << bit_string->bits_used) - 1UL;
+        }
+    }
+
+    return bits;
+}
+
 /**
  * Return the number of bits used.
  *
@@ -274,14 +320,11 @@ unsigned bitstring_bits_capacity(BACNET_BIT_STRING *bit_string)
  */
 bool bitstring_copy(BACNET_BIT_STRING *dest, BACNET_BIT_STRING *src)
 {
-    unsigned i;
     bool status = false;
 
     if (dest && src) {
         dest->bits_used = src->bits_used;
-        for (i = 0; i < MAX_BITSTRING_BYTES; i++) {
-            dest->value[i] = src->value[i];
-        }
+        memcpy(dest->value, src->value, sizeof(dest->value));
         status = true;
     }
 
@@ -300,28 +343,28 @@ bool bitstring_copy(BACNET_BIT_STRING *dest, BACNET_BIT_STRING *src)
 bool bitstring_same(
     BACNET_BIT_STRING *bitstring1, BACNET_BIT_STRING *bitstring2)
 {
-    int i; /* loop counter */
-    int bytes_used = 0;
+    unsigned bytes_used = 0;
+    unsigned remaining_bits = 0;
     uint8_t compare_mask = 0;
 
     if (bitstring1 && bitstring2) {
-        bytes_used = (int)(bitstring1->bits_used / 8);
+        bytes_used = bitstring1->bits_used >> 3;
+        remaining_bits = bitstring1->bits_used & 7;
         if ((bitstring1->bits_used == bitstring2->bits_used) &&
             (bytes_used <= MAX_BITSTRING_BYTES)) {
             /* compare fully used bytes */
-            for (i = 0; i < bytes_used; i++) {
-                if (bitstring1->value[i] != bitstring2->value[i]) {
-                    return false;
-                }
+            if (memcmp(bitstring1->value, bitstring2->value, bytes_used)) {
+                return false;
             }
             /* compare only the relevant bits of last partly used byte */
-            compare_mask = 0xFF >> (8 - (bitstring1->bits_used % 8));
-            if ((bitstring1->value[bytes_used] & compare_mask) !=
-                (bitstring2->value[bytes_used] & compare_mask)) {
-                return false;
-            } else {
-                return true;
+            if (remaining_bits && (bytes_used < MAX_BITSTRING_BYTES)) {
+                compare_mask = (uint8_t)(0xFF >> (8 - remaining_bits));
+                if ((bitstring1->value[bytes_used] & compare_mask) !=
+                    (bitstring2->value[bytes_used] & compare_mask)) {
+                    return false;
+                }
             }
+            return true;
         }
     }
 
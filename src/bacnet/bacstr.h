@@ -70,6 +70,14 @@ extern "C" {
         BACNET_BIT_STRING * bit_string,
         uint8_t bit_number);
     BACNET_STACK_EXPORT
+    bool bitstring_init_bits32(
+        BACNET_BIT_STRING * bit_string,
+        uint8_t bits_used,
+        uint32_t bits);
+    BACNET_STACK_EXPORT
+    uint32_t bitstring_bits32(
+        BACNET_BIT_STRING * bit_string);
+    BACNET_STACK_EXPORT
     uint8_t bitstring_bits_used(
         BACNET_BIT_STRING * bit_string);
 /* returns the number of bytes that a bit string is using */
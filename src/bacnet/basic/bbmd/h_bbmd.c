@@ -92,6 +92,41 @@ static BACNET_IP_BROADCAST_DISTRIBUTION_TABLE_ENTRY
 #define MAX_FD_ENTRIES 128
 #endif
 static BACNET_IP_FOREIGN_DEVICE_TABLE_ENTRY FD_Table[MAX_FD_ENTRIES];
+/* number of table entries in use, set at run time up to the maximum */
+static uint16_t BBMD_Table_Size = MAX_BBMD_ENTRIES;
+static uint16_t FD_Table_Size = MAX_FD_ENTRIES;
+/* Hash index of the table entries by B/IPv4 address. Each bucket holds
+   the entry number plus one of the first entry in its chain, so that
+   zero ends a chain. */
+#ifndef BBMD_HASH_BUCKETS
+#define BBMD_HASH_BUCKETS MAX_BBMD_ENTRIES
+#endif
+#ifndef FD_HASH_BUCKETS
+#define FD_HASH_BUCKETS MAX_FD_ENTRIES
+#endif
+static uint16_t BDT_Hash[BBMD_HASH_BUCKETS];
+static uint16_t BDT_Hash_Next[MAX_BBMD_ENTRIES];
+/* the BDT is written as a whole, so its index is rebuilt when needed */
+static bool BDT_Hash_Stale = true;
+/* BDT peers heard on the multicast group, which the group already
+   reaches (Annex J.8); learned again when the BDT changes */
+static bool BDT_Multicast_Member[MAX_BBMD_ENTRIES];
+static uint16_t FDT_Hash[FD_HASH_BUCKETS];
+static uint16_t FDT_Hash_Next[MAX_FD_ENTRIES];
+/* min-heap of the valid FDT entries, ordered by the time they expire */
+static uint16_t FDT_Heap[MAX_FD_ENTRIES];
+static uint16_t FDT_Heap_Count;
+/* position of each valid FDT entry in the heap */
+static uint16_t FDT_Heap_Index[MAX_FD_ENTRIES];
+/* the time of the maintenance timer at which each FDT entry expires */
+static uint32_t FDT_Expires[MAX_FD_ENTRIES];
+/* free FDT entries */
+static uint16_t FDT_Free[MAX_FD_ENTRIES];
+static uint16_t FDT_Free_Count;
+/* seconds counted by the maintenance timer */
+static uint32_t FDT_Seconds;
+/* the message being handled came to the broadcast or multicast address */
+static bool BVLC_Broadcast_Received;
 #endif
 
 /**
@@ -234,6 +269,9 @@ void bvlc_bdt_restore_local(void)
             memcpy(BBMD_Table, BBMD_Table_tmp,
                 sizeof(BACNET_IP_BROADCAST_DISTRIBUTION_TABLE_ENTRY) *
                     MAX_BBMD_ENTRIES);
+            bvlc_broadcast_distribution_table_link_array(
+                &BBMD_Table[0], BBMD_Table_Size);
+            BDT_Hash_Stale = true;
         }
     }
 }
@@ -247,6 +285,232 @@ void bvlc_bdt_restore_local(void)
 #endif
 #endif
 
+#if BBMD_ENABLED
+/**
+ * @brief Hash a B/IPv4 address and port
+ * @param addr - B/IPv4 address
+ * @param buckets - number of hash buckets
+ * @return bucket of the address
+ */
+static unsigned bbmd_address_hash(
+    const BACNET_IP_ADDRESS *addr, unsigned buckets)
+{
+    uint32_t hash;
+
+    hash = ((uint32_t)addr->address[0] << 24) |
+        ((uint32_t)addr->address[1] << 16) |
+        ((uint32_t)addr->address[2] << 8) | (uint32_t)addr->address[3];
+    hash ^= (uint32_t)addr->port << 7;
+    /* Fibonacci hashing spreads addresses of the same subnet */
+    hash *= 2654435761UL;
+    hash ^= hash >> 16;
+
+    return (unsigned)(hash % buckets);
+}
+
+/**
+ * @brief Index the valid BDT entries by address, if the table changed
+ */
+static void bbmd_bdt_index(void)
+{
+    unsigned bucket;
+    uint16_t i;
+
+    if (!BDT_Hash_Stale) {
+        return;
+    }
+    memset(BDT_Hash, 0, sizeof(BDT_Hash));
+    memset(BDT_Multicast_Member, 0, sizeof(BDT_Multicast_Member));
+    for (i = 0; i < BBMD_Table_Size; i++) {
+        if (BBMD_Table[i].valid) {
+            bucket = bbmd_address_hash(
+                &BBMD_Table[i].dest_address, BBMD_HASH_BUCKETS);
+            BDT_Hash_Next[i] = BDT_Hash[bucket];
+            BDT_Hash[bucket] = i + 1;
+        }
+    }
+    BDT_Hash_Stale = false;
+}
+
+/**
+ * @brief Find the FDT entry of a foreign device
+ * @param addr - B/IPv4 address of the foreign device
+ * @return the FDT entry number, or FD_Table_Size if not found
+ */
+static uint16_t bbmd_fdt_find(const BACNET_IP_ADDRESS *addr)
+{
+    uint16_t entry;
+
+    entry = FDT_Hash[bbmd_address_hash(addr, FD_HASH_BUCKETS)];
+    while (entry) {
+        if (!bvlc_address_different(&FD_Table[entry - 1].dest_address, addr)) {
+            return entry - 1;
+        }
+        entry = FDT_Hash_Next[entry - 1];
+    }
+
+    return FD_Table_Size;
+}
+
+/**
+ * @brief Swap two FDT heap positions
+ * @param a - heap position
+ * @param b - heap position
+ */
+static void bbmd_fdt_heap_swap(uint16_t a, uint16_t b)
+{
+    uint16_t entry;
+
+    entry = FDT_Heap[a];
+    FDT_Heap[a] = FDT_Heap[b];
+    FDT_Heap[b] = entry;
+    FDT_Heap_Index[FDT_Heap[a]] = a;
+    FDT_Heap_Index[FDT_Heap[b]] = b;
+}
+
+/**
+ * @brief Restore the FDT heap order after the expiry time of the entry
+ *  at a heap position changed
+ * @param position - heap position
+ */
+static void bbmd_fdt_heap_fix(uint16_t position)
+{
+    uint16_t parent;
+    uint16_t child;
+
+    while (position > 0) {
+        parent = (position - 1) / 2;
+        if (FDT_Expires[FDT_Heap[parent]] <= FDT_Expires[FDT_Heap[position]]) {
+            break;
+        }
+        bbmd_fdt_heap_swap(parent, position);
+        position = parent;
+    }
+    for (;;) {
+        child = (2 * position) + 1;
+        if (child >= FDT_Heap_Count) {
+            break;
+        }
+        if (((child + 1) < FDT_Heap_Count) &&
+            (FDT_Expires[FDT_Heap[child + 1]] < FDT_Expires[FDT_Heap[child]])) {
+            child++;
+        }
+        if (FDT_Expires[FDT_Heap[position]] <= FDT_Expires[FDT_Heap[child]]) {
+            break;
+        }
+        bbmd_fdt_heap_swap(position, child);
+        position = child;
+    }
+}
+
+/**
+ * @brief Remove an FDT entry from the table, the index and the heap
+ * @param entry - FDT entry number
+ */
+static void bbmd_fdt_remove(uint16_t entry)
+{
+    uint16_t *link;
+    uint16_t position;
+
+    link = &FDT_Hash[bbmd_address_hash(
+        &FD_Table[entry].dest_address, FD_HASH_BUCKETS)];
+    while (*link) {
+        if (*link == (entry + 1)) {
+            *link = FDT_Hash_Next[entry];
+            break;
+        }
+        link = &FDT_Hash_Next[*link - 1];
+    }
+    position = FDT_Heap_Index[entry];
+    FDT_Heap_Count--;
+    if (position != FDT_Heap_Count) {
+        bbmd_fdt_heap_swap(position, FDT_Heap_Count);
+        bbmd_fdt_heap_fix(position);
+    }
+    FD_Table[entry].valid = false;
+    FD_Table[entry].ttl_seconds_remaining = 0;
+    FDT_Free[FDT_Free_Count++] = entry;
+}
+
+/**
+ * @brief Add or renew a foreign device in the FDT
+ * @param addr - B/IPv4 address of the foreign device
+ * @param ttl_seconds - Time-to-Live T, in seconds
+ * @return true if the foreign device was added or renewed
+ */
+static bool bbmd_fdt_add(const BACNET_IP_ADDRESS *addr, uint16_t ttl_seconds)
+{
+    uint16_t entry;
+    unsigned bucket;
+    uint16_t ttl_grace;
+
+    /* Upon receipt of a BVLL Register-Foreign-Device message,
+       a BBMD shall start a timer with a value equal to the
+       Time-to-Live parameter supplied plus a fixed grace
+       period of 30 seconds. */
+    if (ttl_seconds < (UINT16_MAX - 30)) {
+        ttl_grace = ttl_seconds + 30;
+    } else {
+        ttl_grace = UINT16_MAX;
+    }
+    entry = bbmd_fdt_find(addr);
+    if (entry == FD_Table_Size) {
+        if (FDT_Free_Count == 0) {
+            return false;
+        }
+        entry = FDT_Free[--FDT_Free_Count];
+        bvlc_address_copy(&FD_Table[entry].dest_address, addr);
+        FD_Table[entry].valid = true;
+        bucket = bbmd_address_hash(addr, FD_HASH_BUCKETS);
+        FDT_Hash_Next[entry] = FDT_Hash[bucket];
+        FDT_Hash[bucket] = entry + 1;
+        FDT_Heap[FDT_Heap_Count] = entry;
+        FDT_Heap_Index[entry] = FDT_Heap_Count;
+        FDT_Heap_Count++;
+    }
+    FD_Table[entry].ttl_seconds = ttl_seconds;
+    FD_Table[entry].ttl_seconds_remaining = ttl_grace;
+    FDT_Expires[entry] = FDT_Seconds + ttl_grace;
+    bbmd_fdt_heap_fix(FDT_Heap_Index[entry]);
+
+    return true;
+}
+
+/**
+ * @brief Update the seconds remaining of each valid FDT entry from
+ *  its expiry time, when the table is read rather than on every tick
+ */
+static void bbmd_fdt_remaining_update(void)
+{
+    uint16_t entry;
+    uint16_t i;
+
+    for (i = 0; i < FDT_Heap_Count; i++) {
+        entry = FDT_Heap[i];
+        FD_Table[entry].ttl_seconds_remaining =
+            (uint16_t)(FDT_Expires[entry] - FDT_Seconds);
+    }
+}
+
+/**
+ * @brief Empty the FDT, and link the entries in use
+ */
+static void bbmd_fdt_reset(void)
+{
+    uint16_t i;
+
+    memset(FD_Table, 0, sizeof(FD_Table));
+    memset(FDT_Hash, 0, sizeof(FDT_Hash));
+    bvlc_foreign_device_table_link_array(&FD_Table[0], FD_Table_Size);
+    FDT_Heap_Count = 0;
+    /* the lowest entries are used first */
+    FDT_Free_Count = 0;
+    for (i = FD_Table_Size; i > 0; i--) {
+        FDT_Free[FDT_Free_Count++] = i - 1;
+    }
+}
+#endif
+
 /** A timer function that is called about once a second.
  *
  * @param seconds - number of elapsed seconds since the last call
@@ -254,7 +518,12 @@ void bvlc_bdt_restore_local(void)
 void bvlc_maintenance_timer(uint16_t seconds)
 {
 #if BBMD_ENABLED
-    bvlc_foreign_device_table_maintenance_timer(&FD_Table[0], seconds);
+    FDT_Seconds += seconds;
+    /* the heap finds the entries that expired */
+    while ((FDT_Heap_Count > 0) &&
+        (FDT_Expires[FDT_Heap[0]] <= FDT_Seconds)) {
+        bbmd_fdt_remove(FDT_Heap[0]);
+    }
 #endif
 }
 
@@ -293,27 +562,113 @@ static bool bbmd_bdt_member_mask_is_unicast(BACNET_IP_ADDRESS *addr)
     BACNET_IP_BROADCAST_DISTRIBUTION_MASK unicast_mask = { 0 };
     BACNET_IP_ADDRESS *dest_address = NULL;
     BACNET_IP_BROADCAST_DISTRIBUTION_MASK *broadcast_mask = NULL;
-    unsigned i = 0; /* loop counter */
+    uint16_t entry;
 
+    bbmd_bdt_index();
+    entry = BDT_Hash[bbmd_address_hash(addr, BBMD_HASH_BUCKETS)];
+    if (entry == 0) {
+        return false;
+    }
     bip_get_addr(&my_addr);
     bvlc_broadcast_distribution_mask_from_host(&unicast_mask, 0xFFFFFFFFL);
-    for (i = 0; i < MAX_BBMD_ENTRIES; i++) {
-        if (BBMD_Table[i].valid) {
-            dest_address = &BBMD_Table[i].dest_address;
-            broadcast_mask = &BBMD_Table[i].broadcast_mask;
-            if (bvlc_address_different(&my_addr, dest_address) &&
-                !bvlc_address_different(addr, dest_address) &&
-                !bvlc_broadcast_distribution_mask_different(
-                    broadcast_mask, &unicast_mask)) {
-                unicast = true;
-                break;
-            }
+    while (entry) {
+        dest_address = &BBMD_Table[entry - 1].dest_address;
+        broadcast_mask = &BBMD_Table[entry - 1].broadcast_mask;
+        if (bvlc_address_different(&my_addr, dest_address) &&
+            !bvlc_address_different(addr, dest_address) &&
+            !bvlc_broadcast_distribution_mask_different(
+                broadcast_mask, &unicast_mask)) {
+            unicast = true;
+            break;
         }
+        entry = BDT_Hash_Next[entry - 1];
     }
 
     return unicast;
 }
 
+/**
+ * @brief Find the BDT entry of a peer BBMD
+ * @param addr - B/IPv4 address of the peer BBMD
+ * @return the BDT entry number, or BBMD_Table_Size if not found
+ */
+static uint16_t bbmd_bdt_find(const BACNET_IP_ADDRESS *addr)
+{
+    uint16_t entry;
+
+    bbmd_bdt_index();
+    entry = BDT_Hash[bbmd_address_hash(addr, BBMD_HASH_BUCKETS)];
+    while (entry) {
+        if (!bvlc_address_different(
+                addr, &BBMD_Table[entry - 1].dest_address)) {
+            return entry - 1;
+        }
+        entry = BDT_Hash_Next[entry - 1];
+    }
+
+    return BBMD_Table_Size;
+}
+
+/**
+ * @brief Determine if the B/IP broadcasts go to an IP multicast group
+ * @return true if the B/IP broadcast address is a multicast group
+ */
+static bool bbmd_multicast_enabled(void)
+{
+    BACNET_IP_ADDRESS broadcast_address = { 0 };
+
+    bip_get_broadcast_addr(&broadcast_address);
+
+    return (broadcast_address.address[0] & 0xF0) == 0xE0;
+}
+
+/**
+ * @brief Determine if a peer BBMD was heard on the multicast group
+ * @param addr - B/IPv4 address of the peer BBMD
+ * @return true if the multicast group reaches the peer
+ */
+static bool bbmd_bdt_multicast_member(const BACNET_IP_ADDRESS *addr)
+{
+    uint16_t entry;
+
+    if (!bbmd_multicast_enabled()) {
+        return false;
+    }
+    entry = bbmd_bdt_find(addr);
+
+    return (entry < BBMD_Table_Size) && BDT_Multicast_Member[entry];
+}
+
+/**
+ * @brief Determine if an address is on the IP subnet of this BBMD
+ * @param addr - B/IPv4 address
+ * @return true if the address is on our IP subnet
+ */
+static bool bbmd_address_on_subnet(const BACNET_IP_ADDRESS *addr)
+{
+    BACNET_IP_ADDRESS my_addr = { 0 };
+    uint8_t prefix;
+    uint8_t mask;
+    unsigned i;
+
+    bip_get_addr(&my_addr);
+    prefix = bip_get_subnet_prefix();
+    for (i = 0; i < IP_ADDRESS_MAX; i++) {
+        if (prefix >= 8) {
+            mask = 0xFF;
+            prefix -= 8;
+        } else {
+            mask = (uint8_t)(0xFF << (8 - prefix));
+            prefix = 0;
+        }
+        if ((addr->address[i] & mask) != (my_addr.address[i] & mask)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 /** Send a BVLL Forwarded-NPDU message on its local IP subnet using
  * the local B/IP broadcast address as the destination address.
  *
@@ -327,18 +682,20 @@ static uint16_t bbmd_forward_npdu(
     BACNET_IP_ADDRESS *bip_src, uint8_t *npdu, uint16_t npdu_length)
 {
     BACNET_IP_ADDRESS broadcast_address = { 0 };
-    uint8_t mtu[BIP_MPDU_MAX] = { 0 };
-    uint16_t mtu_len = 0;
+    uint8_t header[BVLC_NPDU_HEADER_MAX] = { 0 };
+    uint16_t header_len = 0;
 
-    mtu_len = (uint16_t)bvlc_encode_forwarded_npdu(
-        &mtu[0], (uint16_t)sizeof(mtu), bip_src, npdu, npdu_length);
-    if (mtu_len > 0) {
+    header_len = (uint16_t)bvlc_encode_forwarded_npdu_header(
+        &header[0], (uint16_t)sizeof(header), bip_src, npdu_length);
+    if ((header_len > 0) && ((header_len + npdu_length) <= BIP_MPDU_MAX)) {
         bip_get_broadcast_addr(&broadcast_address);
-        bip_send_mpdu(&broadcast_address, mtu, mtu_len);
+        bip_send_mpdu_iov(
+            &broadcast_address, header, header_len, npdu, npdu_length);
         debug_printf("BVLC: Sent Forwarded-NPDU as local broadcast.\n");
+        return header_len + npdu_length;
     }
 
-    return mtu_len;
+    return 0;
 }
 
 /** Sends all Broadcast Devices a Forwarded NPDU
@@ -355,13 +712,17 @@ static uint16_t bbmd_bdt_forward_npdu(BACNET_IP_ADDRESS *bip_src,
     uint16_t npdu_length,
     bool original)
 {
-    uint8_t mtu[BIP_MPDU_MAX] = { 0 };
-    uint16_t mtu_len = 0;
+    uint8_t header[BVLC_NPDU_HEADER_MAX] = { 0 };
+    uint16_t header_len = 0;
     unsigned i = 0; /* loop counter */
     BACNET_IP_ADDRESS bip_dest = { 0 };
     BACNET_IP_ADDRESS my_addr = { 0 };
+    BACNET_IP_ADDRESS broadcast_address = { 0 };
 
     bip_get_addr(&my_addr);
+    bip_get_broadcast_addr(&broadcast_address);
+    /* forget the multicast group members of a BDT that changed */
+    bbmd_bdt_index();
     /* If we are forwarding an original broadcast message and the NAT
      * handling is enabled, change the source address to NAT routers
      * global IP address so the recipient can reply (local IP address
@@ -371,14 +732,18 @@ static uint16_t bbmd_bdt_forward_npdu(BACNET_IP_ADDRESS *bip_src,
      * or the NAT handling is disabled, leave the source address as is.
      */
     if (BVLC_NAT_Handling && original) {
-        mtu_len = (uint16_t)bvlc_encode_forwarded_npdu(&mtu[0],
-            (uint16_t)sizeof(mtu), &BVLC_Global_Address, npdu, npdu_length);
+        header_len = (uint16_t)bvlc_encode_forwarded_npdu_header(&header[0],
+            (uint16_t)sizeof(header), &BVLC_Global_Address, npdu_length);
     } else {
-        mtu_len = (uint16_t)bvlc_encode_forwarded_npdu(
-            &mtu[0], (uint16_t)sizeof(mtu), bip_src, npdu, npdu_length);
+        header_len = (uint16_t)bvlc_encode_forwarded_npdu_header(
+            &header[0], (uint16_t)sizeof(header), bip_src, npdu_length);
+    }
+    if ((header_len == 0) || ((header_len + npdu_length) > BIP_MPDU_MAX)) {
+        /* the Forwarded-NPDU header does not leave room for the NPDU */
+        return 0;
     }
     /* loop through the BDT and send one to each entry */
-    for (i = 0; i < MAX_BBMD_ENTRIES; i++) {
+    for (i = 0; i < BBMD_Table_Size; i++) {
         if (BBMD_Table[i].valid) {
             bvlc_broadcast_distribution_table_entry_forward_address(
                 &bip_dest, &BBMD_Table[i]);
@@ -386,6 +751,16 @@ static uint16_t bbmd_bdt_forward_npdu(BACNET_IP_ADDRESS *bip_src,
                 /* don't forward to our selves */
                 continue;
             }
+            if (!bvlc_address_different(&bip_dest, &broadcast_address)) {
+                /* an entry for the multicast group we broadcast to
+                   already has the message (Annex J.8) */
+                continue;
+            }
+            if (bbmd_multicast_enabled() && BDT_Multicast_Member[i]) {
+                /* a peer heard on the multicast group gets the
+                   message from the group */
+                continue;
+            }
             if (!bvlc_address_different(&bip_dest, bip_src)) {
                 /* don't forward back to origin */
                 continue;
@@ -398,12 +773,13 @@ static uint16_t bbmd_bdt_forward_npdu(BACNET_IP_ADDRESS *bip_src,
                     continue;
                 }
             }
-            bip_send_mpdu(&bip_dest, mtu, mtu_len);
+            bip_send_mpdu_iov(
+                &bip_dest, header, header_len, npdu, npdu_length);
             debug_print_bip("BDT Send Forwarded-NPDU", &bip_dest);
         }
     }
 
-    return mtu_len;
+    return header_len + npdu_length;
 }
 
 /** Sends all Foreign Devices a Forwarded NPDU
@@ -420,8 +796,8 @@ static uint16_t bbmd_fdt_forward_npdu(BACNET_IP_ADDRESS *bip_src,
     uint16_t npdu_length,
     bool original)
 {
-    uint8_t mtu[BIP_MPDU_MAX] = { 0 };
-    uint16_t mtu_len = 0;
+    uint8_t header[BVLC_NPDU_HEADER_MAX] = { 0 };
+    uint16_t header_len = 0;
     unsigned i = 0; /* loop counter */
     BACNET_IP_ADDRESS bip_dest = { 0 };
     BACNET_IP_ADDRESS my_addr = { 0 };
@@ -436,39 +812,41 @@ static uint16_t bbmd_fdt_forward_npdu(BACNET_IP_ADDRESS *bip_src,
      * or the NAT handling is disabled, leave the source address as is.
      */
     if (BVLC_NAT_Handling && original) {
-        mtu_len = (uint16_t)bvlc_encode_forwarded_npdu(&mtu[0],
-            (uint16_t)sizeof(mtu), &BVLC_Global_Address, npdu, npdu_length);
+        header_len = (uint16_t)bvlc_encode_forwarded_npdu_header(&header[0],
+            (uint16_t)sizeof(header), &BVLC_Global_Address, npdu_length);
     } else {
-        mtu_len = (uint16_t)bvlc_encode_forwarded_npdu(
-            &mtu[0], (uint16_t)sizeof(mtu), bip_src, npdu, npdu_length);
+        header_len = (uint16_t)bvlc_encode_forwarded_npdu_header(
+            &header[0], (uint16_t)sizeof(header), bip_src, npdu_length);
+    }
+    if ((header_len == 0) || ((header_len + npdu_length) > BIP_MPDU_MAX)) {
+        /* the Forwarded-NPDU header does not leave room for the NPDU */
+        return 0;
     }
 
-    /* loop through the FDT and send one to each entry */
-    for (i = 0; i < MAX_FD_ENTRIES; i++) {
-        if (FD_Table[i].valid && FD_Table[i].ttl_seconds_remaining) {
-            bvlc_address_copy(&bip_dest, &FD_Table[i].dest_address);
-            if (!bvlc_address_different(&bip_dest, &my_addr)) {
-                /* don't forward to our selves */
-                continue;
-            }
-            if (!bvlc_address_different(&bip_dest, bip_src)) {
-                /* don't forward back to origin */
+    /* loop through the valid FDT entries and send one to each entry */
+    for (i = 0; i < FDT_Heap_Count; i++) {
+        bvlc_address_copy(&bip_dest, &FD_Table[FDT_Heap[i]].dest_address);
+        if (!bvlc_address_different(&bip_dest, &my_addr)) {
+            /* don't forward to our selves */
+            continue;
+        }
+        if (!bvlc_address_different(&bip_dest, bip_src)) {
+            /* don't forward back to origin */
+            continue;
+        }
+        if (BVLC_NAT_Handling) {
+            if (bvlc_address_different(&bip_dest, &BVLC_Global_Address)) {
+                /* NAT router port forwards BACnet packets from global IP.
+                   Packets sent to that global IP by us would end up back,
+                   creating a loop. */
                 continue;
             }
-            if (BVLC_NAT_Handling) {
-                if (bvlc_address_different(&bip_dest, &BVLC_Global_Address)) {
-                    /* NAT router port forwards BACnet packets from global IP.
-                       Packets sent to that global IP by us would end up back,
-                       creating a loop. */
-                    continue;
-                }
-            }
-            bip_send_mpdu(&bip_dest, mtu, mtu_len);
-            debug_print_bip("FDT Send Forwarded-NPDU", &bip_dest);
         }
+        bip_send_mpdu_iov(&bip_dest, header, header_len, npdu, npdu_length);
+        debug_print_bip("FDT Send Forwarded-NPDU", &bip_dest);
     }
 
-    return mtu_len;
+    return header_len + npdu_length;
 }
 
 /** Prints the Read-BDT-Ack NPDU
@@ -565,8 +943,8 @@ static void bbmd_read_fdt_ack_handler(
  *  destination address.
  * @param npdu_data - Points to a BACNET_NPDU_DATA structure containing the
  *  destination network layer control flags and data.
- * @param mtu - the bytes of data to send
- * @param mtu_len - the number of bytes of data to send
+ * @param pdu - the bytes of data to send
+ * @param pdu_len - the number of bytes of data to send
  * @return Upon successful completion, returns the number of bytes sent.
  *  Otherwise, -1 shall be returned and errno set to indicate the error.
  */
@@ -576,14 +954,18 @@ int bvlc_send_pdu(BACNET_ADDRESS *dest,
     unsigned pdu_len)
 {
     BACNET_IP_ADDRESS bvlc_dest = { 0 };
-    uint8_t mtu[BIP_MPDU_MAX] = { 0 };
-    uint16_t mtu_len = 0;
+    uint8_t header[BVLC_NPDU_HEADER_MAX] = { 0 };
+    uint16_t header_len = 0;
 #if BBMD_ENABLED
     BACNET_IP_ADDRESS bip_src = { 0 };
 #endif
 
     /* this datalink doesn't need to know the npdu data */
     (void)npdu_data;
+    if ((pdu_len + BIP_HEADER_MAX) > BIP_MPDU_MAX) {
+        debug_print_string("Send failure. NPDU too large.");
+        return -1;
+    }
     /* handle various broadcasts: */
     if ((dest->net == BACNET_BROADCAST_NETWORK) || (dest->mac_len == 0)) {
         /* mac_len = 0 is a broadcast address */
@@ -591,16 +973,16 @@ int bvlc_send_pdu(BACNET_ADDRESS *dest,
         if (Remote_BBMD.port) {
             /* we are a foreign device */
             bvlc_address_copy(&bvlc_dest, &Remote_BBMD);
-            mtu_len = bvlc_encode_distribute_broadcast_to_network(
-                mtu, sizeof(mtu), pdu, pdu_len);
+            header_len = bvlc_encode_distribute_broadcast_to_network_header(
+                header, sizeof(header), pdu_len);
             debug_print_bip("Send Distribute-Broadcast-to-Network", &bvlc_dest);
         } else {
             bip_get_broadcast_addr(&bvlc_dest);
-            mtu_len =
-                bvlc_encode_original_broadcast(mtu, sizeof(mtu), pdu, pdu_len);
+            header_len = bvlc_encode_original_broadcast_header(
+                header, sizeof(header), pdu_len);
             debug_print_bip("Send Original-Broadcast-NPDU", &bvlc_dest);
 #if BBMD_ENABLED
-            if (mtu_len > 0) {
+            if (header_len > 0) {
                 bip_get_addr(&bip_src);
                 (void)bbmd_fdt_forward_npdu(&bip_src, pdu, pdu_len, true);
                 (void)bbmd_bdt_forward_npdu(&bip_src, pdu, pdu_len, true);
@@ -615,20 +997,22 @@ int bvlc_send_pdu(BACNET_ADDRESS *dest,
         } else {
             bip_get_broadcast_addr(&bvlc_dest);
         }
-        mtu_len =
-            bvlc_encode_original_broadcast(mtu, sizeof(mtu), pdu, pdu_len);
+        header_len = bvlc_encode_original_broadcast_header(
+            header, sizeof(header), pdu_len);
         debug_print_bip("Send Original-Broadcast-NPDU", &bvlc_dest);
     } else if (dest->mac_len == 6) {
         /* valid unicast */
         bvlc_ip_address_from_bacnet_local(&bvlc_dest, dest);
-        mtu_len = bvlc_encode_original_unicast(mtu, sizeof(mtu), pdu, pdu_len);
+        header_len = bvlc_encode_original_unicast_header(
+            header, sizeof(header), pdu_len);
         debug_print_bip("Send Original-Unicast-NPDU", &bvlc_dest);
     } else {
         debug_print_string("Send failure. Invalid Address.");
         return -1;
     }
 
-    return bip_send_mpdu(&bvlc_dest, mtu, mtu_len);
+    return bip_send_mpdu_iov(
+        &bvlc_dest, header, header_len, pdu, (uint16_t)pdu_len);
 }
 
 /**
@@ -838,6 +1222,7 @@ int bvlc_bbmd_enabled_handler(BACNET_IP_ADDRESS *addr,
     bool send_result = false;
     uint16_t offset = 0;
     uint16_t ttl_seconds = 0;
+    uint16_t entry = 0;
     BACNET_IP_ADDRESS fwd_address = { 0 };
     BACNET_IP_ADDRESS broadcast_address = { 0 };
 
@@ -862,6 +1247,7 @@ int bvlc_bbmd_enabled_handler(BACNET_IP_ADDRESS *addr,
             debug_print_bip("Received Write-BDT", addr);
             function_len = bvlc_decode_write_broadcast_distribution_table(
                 pdu, pdu_len, &BBMD_Table[0]);
+            BDT_Hash_Stale = true;
             if (function_len > 0) {
                 /* BDT changed! Save backup to file */
                 bvlc_bdt_backup_local();
@@ -925,12 +1311,17 @@ int bvlc_bbmd_enabled_handler(BACNET_IP_ADDRESS *addr,
                     debug_print_string("Forwarded-NPDU is me!");
                     break;
                 }
-                if (bbmd_bdt_member_mask_is_unicast(addr)) {
+                if (!BVLC_Broadcast_Received &&
+                    !bbmd_bdt_multicast_member(addr) &&
+                    bbmd_bdt_member_mask_is_unicast(addr)) {
                     /*  Upon receipt of a BVLL Forwarded-NPDU message
                         from a BBMD which is in the receiving BBMD's BDT,
                         a BBMD shall construct a BVLL Forwarded-NPDU and
                         transmit it via broadcast to B/IPv4 devices in the
-                        local broadcast domain. */
+                        local broadcast domain.  One that came to the
+                        broadcast or multicast address is already there,
+                        as is one from a peer that also sends to the
+                        multicast group. */
                     bip_get_broadcast_addr(&broadcast_address);
                     bip_send_mpdu(&broadcast_address, mtu, mtu_len);
                 }
@@ -959,8 +1350,7 @@ int bvlc_bbmd_enabled_handler(BACNET_IP_ADDRESS *addr,
             function_len =
                 bvlc_decode_register_foreign_device(pdu, pdu_len, &ttl_seconds);
             if (function_len) {
-                if (bvlc_foreign_device_table_entry_add(
-                        &FD_Table[0], addr, ttl_seconds)) {
+                if (bbmd_fdt_add(addr, ttl_seconds)) {
                     result_code = BVLC_RESULT_SUCCESSFUL_COMPLETION;
                     send_result = true;
                 } else {
@@ -980,6 +1370,7 @@ int bvlc_bbmd_enabled_handler(BACNET_IP_ADDRESS *addr,
                it shall return a BVLC-Result message to the originating device
                with a result code of X'0040' indicating that the read attempt
                has failed. */
+            bbmd_fdt_remaining_update();
             BVLC_Buffer_Len = bvlc_encode_read_foreign_device_table_ack(
                 BVLC_Buffer, sizeof(BVLC_Buffer), &FD_Table[0]);
             if (BVLC_Buffer_Len > 0) {
@@ -1010,8 +1401,9 @@ int bvlc_bbmd_enabled_handler(BACNET_IP_ADDRESS *addr,
             function_len =
                 bvlc_decode_delete_foreign_device(pdu, pdu_len, &fwd_address);
             if (function_len > 0) {
-                if (bvlc_foreign_device_table_entry_delete(
-                        &FD_Table[0], &fwd_address)) {
+                entry = bbmd_fdt_find(&fwd_address);
+                if (entry < FD_Table_Size) {
+                    bbmd_fdt_remove(entry);
                     result_code = BVLC_RESULT_SUCCESSFUL_COMPLETION;
                     send_result = true;
                 } else {
@@ -1107,6 +1499,13 @@ int bvlc_bbmd_enabled_handler(BACNET_IP_ADDRESS *addr,
                     offset = 0;
                     debug_print_string("Original-Broadcast-NPDU: "
                                        "Confirmed Service! Discard!");
+                } else if (BVLC_Broadcast_Received &&
+                    bbmd_multicast_enabled() &&
+                    !bbmd_address_on_subnet(addr)) {
+                    /* heard on the multicast group from another subnet,
+                       whose BBMD forwards it */
+                    debug_print_npdu(
+                        "Original-Broadcast-NPDU", offset, npdu_len);
                 } else {
                     (void)bbmd_fdt_forward_npdu(addr, npdu, npdu_len, true);
                     (void)bbmd_bdt_forward_npdu(addr, npdu, npdu_len, true);
@@ -1167,7 +1566,14 @@ int bvlc_broadcast_handler(BACNET_IP_ADDRESS *addr,
     uint8_t message_type = 0;
     uint16_t message_length = 0;
     int header_len = 0;
+#if BBMD_ENABLED
+    uint16_t entry = 0;
+#endif
 
+    if (bbmd_address_match_self(addr)) {
+        /* drop our own broadcast or multicast, looped back to us */
+        return 0;
+    }
     header_len =
         bvlc_decode_header(npdu, npdu_len, &message_type, &message_length);
     if (header_len == 4) {
@@ -1176,7 +1582,20 @@ int bvlc_broadcast_handler(BACNET_IP_ADDRESS *addr,
                 /* drop unicast when sent as a broadcast */
                 break;
             default:
+#if BBMD_ENABLED
+                if (bbmd_multicast_enabled()) {
+                    /* the group reaches a peer BBMD that is heard on it */
+                    entry = bbmd_bdt_find(addr);
+                    if (entry < BBMD_Table_Size) {
+                        BDT_Multicast_Member[entry] = true;
+                    }
+                }
+                BVLC_Broadcast_Received = true;
                 offset = bvlc_handler(addr, src, npdu, npdu_len);
+                BVLC_Broadcast_Received = false;
+#else
+                offset = bvlc_handler(addr, src, npdu, npdu_len);
+#endif
                 break;
         }
     }
@@ -1316,19 +1735,28 @@ void bvlc_set_function_code(uint8_t function_code)
 #if BBMD_ENABLED
 /**
  * @brief Get handle to foreign device table (FDT).
+ * @note The seconds remaining of each entry are brought up to date by
+ *  this call and by a Read-FDT, so a reader that keeps the handle calls
+ *  this again before it reads the entries.
  * @return pointer to first entry of foreign device table
  */
 BACNET_IP_FOREIGN_DEVICE_TABLE_ENTRY *bvlc_fdt_list(void)
 {
+    bbmd_fdt_remaining_update();
+
     return &FD_Table[0];
 }
 
 /**
  * @brief Get handle to broadcast distribution table (BDT).
+ * @note The BDT may be changed through the handle, so the address
+ *  index of the BDT is rebuilt when it is next used.
  * @return pointer to first entry of broadcast distribution table
  */
 BACNET_IP_BROADCAST_DISTRIBUTION_TABLE_ENTRY *bvlc_bdt_list(void)
 {
+    BDT_Hash_Stale = true;
+
     return &BBMD_Table[0];
 }
 
@@ -1338,9 +1766,70 @@ BACNET_IP_BROADCAST_DISTRIBUTION_TABLE_ENTRY *bvlc_bdt_list(void)
 void bvlc_bdt_list_clear(void)
 {
     bvlc_broadcast_distribution_table_valid_clear(&BBMD_Table[0]);
+    BDT_Hash_Stale = true;
     /* BDT changed! Save backup to file */
     bvlc_bdt_backup_local();
 }
+
+/**
+ * @brief Set the number of entries of the broadcast distribution table.
+ *  Entries past the new size are invalidated.
+ * @param size - number of entries, from 1 to MAX_BBMD_ENTRIES
+ * @return true if the size was set
+ */
+bool bvlc_bdt_size_set(uint16_t size)
+{
+    uint16_t i;
+
+    if ((size == 0) || (size > MAX_BBMD_ENTRIES)) {
+        return false;
+    }
+    for (i = size; i < MAX_BBMD_ENTRIES; i++) {
+        BBMD_Table[i].valid = false;
+        BBMD_Table[i].next = NULL;
+    }
+    BBMD_Table_Size = size;
+    bvlc_broadcast_distribution_table_link_array(
+        &BBMD_Table[0], BBMD_Table_Size);
+    BDT_Hash_Stale = true;
+
+    return true;
+}
+
+/**
+ * @brief Get the number of entries of the broadcast distribution table.
+ * @return number of entries
+ */
+uint16_t bvlc_bdt_size(void)
+{
+    return BBMD_Table_Size;
+}
+
+/**
+ * @brief Set the number of entries of the foreign device table.
+ *  The foreign device table is emptied.
+ * @param size - number of entries, from 1 to MAX_FD_ENTRIES
+ * @return true if the size was set
+ */
+bool bvlc_fdt_size_set(uint16_t size)
+{
+    if ((size == 0) || (size > MAX_FD_ENTRIES)) {
+        return false;
+    }
+    FD_Table_Size = size;
+    bbmd_fdt_reset();
+
+    return true;
+}
+
+/**
+ * @brief Get the number of entries of the foreign device table.
+ * @return number of entries
+ */
+uint16_t bvlc_fdt_size(void)
+{
+    return FD_Table_Size;
+}
 #endif
 
 /**
@@ -1379,8 +1868,9 @@ void bvlc_init(void)
 #if BBMD_ENABLED
     debug_print_string("Initializing (BBMD Enabled).");
     bvlc_broadcast_distribution_table_link_array(
-        &BBMD_Table[0], MAX_BBMD_ENTRIES);
-    bvlc_foreign_device_table_link_array(&FD_Table[0], MAX_FD_ENTRIES);
+        &BBMD_Table[0], BBMD_Table_Size);
+    BDT_Hash_Stale = true;
+    bbmd_fdt_reset();
 #else
     debug_print_string("Initializing (BBMD Disabled).");
 #endif
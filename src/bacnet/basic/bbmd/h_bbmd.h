@@ -128,9 +128,22 @@ BACNET_IP_BROADCAST_DISTRIBUTION_TABLE_ENTRY *bvlc_bdt_list(void);
 BACNET_STACK_EXPORT
 void bvlc_bdt_list_clear(void);
 
-/* Get foreign device table list */
+/* Get foreign device table list. The seconds remaining of the entries
+ * are updated when the list is got or read by a Read-FDT. */
 BACNET_IP_FOREIGN_DEVICE_TABLE_ENTRY *bvlc_fdt_list(void);
 
+/* Set or get the number of entries in use of each table, up to
+ * MAX_BBMD_ENTRIES and MAX_FD_ENTRIES. Setting the FDT size empties
+ * the FDT. */
+BACNET_STACK_EXPORT
+bool bvlc_bdt_size_set(uint16_t size);
+BACNET_STACK_EXPORT
+uint16_t bvlc_bdt_size(void);
+BACNET_STACK_EXPORT
+bool bvlc_fdt_size_set(uint16_t size);
+BACNET_STACK_EXPORT
+uint16_t bvlc_fdt_size(void);
+
 /* Backup broadcast distribution table to a file.
  * Filename is the BBMD_BACKUP_FILE constant
  */
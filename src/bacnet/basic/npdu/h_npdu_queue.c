@@ -0,0 +1,235 @@
+/**
+ * @file
+ * @brief Inbound queue of NPDU, served by network priority
+ *
+ * @section DESCRIPTION
+ *
+ * There is a ring buffer of packets for each of the four network
+ * priorities.  A pass of npdu_queue_task() serves the priorities from
+ * life-safety down to normal, taking up to the quantum of packets of
+ * each, so every priority is served at least once a pass.  A packet is
+ * never dropped: when the ring of its priority is full, the oldest
+ * packet of that priority is handled first to make room.
+ *
+ * @section LICENSE
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "bacnet/config.h"
+#include "bacnet/bacaddr.h"
+#include "bacnet/bacdef.h"
+#include "bacnet/bacenum.h"
+#include "bacnet/npdu.h"
+#include "bacnet/datalink/datalink.h"
+#include "bacnet/basic/sys/mstimer.h"
+#include "bacnet/basic/sys/ringbuf.h"
+#include "bacnet/basic/npdu/h_npdu.h"
+#include "bacnet/basic/npdu/h_npdu_queue.h"
+
+#define NPDU_QUEUE_PRIORITIES 4
+
+typedef struct npdu_queue_packet {
+    BACNET_ADDRESS src;
+    /* mstimer_now() when the packet was queued */
+    unsigned long stamp;
+    uint16_t pdu_len;
+    uint8_t pdu[MAX_MPDU];
+} NPDU_QUEUE_PACKET;
+
+static NPDU_QUEUE_PACKET Queue_Packets[NPDU_QUEUE_PRIORITIES]
+                                      [NPDU_QUEUE_SIZE];
+static RING_BUFFER Queue_Ring[NPDU_QUEUE_PRIORITIES];
+static unsigned Queue_Quantum[NPDU_QUEUE_PRIORITIES];
+static NPDU_QUEUE_STATS Queue_Stats[NPDU_QUEUE_PRIORITIES];
+static bool Queue_Initialized;
+
+/**
+ * Sets up the rings and quanta the first time the queue is used
+ */
+static void npdu_queue_init(void)
+{
+    unsigned i;
+
+    if (!Queue_Initialized) {
+        for (i = 0; i < NPDU_QUEUE_PRIORITIES; i++) {
+            Ringbuf_Init(&Queue_Ring[i], (volatile uint8_t *)Queue_Packets[i],
+                sizeof(NPDU_QUEUE_PACKET), NPDU_QUEUE_SIZE);
+            Queue_Quantum[i] = NPDU_QUEUE_QUANTUM;
+        }
+        Queue_Initialized = true;
+    }
+}
+
+/**
+ * Gets the network priority of a packet
+ *
+ * @param pdu - the NPDU
+ * @param pdu_len - number of bytes in the NPDU
+ * @return the priority from the NPDU control octet, or normal if the
+ *  packet is not a BACnet NPDU
+ */
+static unsigned npdu_queue_priority(uint8_t *pdu, uint16_t pdu_len)
+{
+    unsigned priority = MESSAGE_PRIORITY_NORMAL;
+
+    if ((pdu_len >= 2) && (pdu[0] == BACNET_PROTOCOL_VERSION)) {
+        priority = pdu[1] & 0x03;
+    }
+
+    return priority;
+}
+
+/**
+ * Hands the oldest packet of a priority to the NPDU handler
+ *
+ * @param priority - the priority to serve
+ * @return true if a packet was handled
+ */
+static bool npdu_queue_serve(unsigned priority)
+{
+    NPDU_QUEUE_PACKET *packet;
+    NPDU_QUEUE_STATS *stats;
+    unsigned long delay;
+
+    packet = (NPDU_QUEUE_PACKET *)Ringbuf_Peek(&Queue_Ring[priority]);
+    if (!packet) {
+        return false;
+    }
+    delay = mstimer_now() - packet->stamp;
+    stats = &Queue_Stats[priority];
+    stats->count++;
+    stats->delay_total += delay;
+    if (delay > stats->delay_max) {
+        stats->delay_max = delay;
+    }
+    npdu_handler(&packet->src, &packet->pdu[0], packet->pdu_len);
+    (void)Ringbuf_Pop(&Queue_Ring[priority], NULL);
+
+    return true;
+}
+
+/**
+ * Queues a packet from the datalink, by its network priority
+ *
+ * @param src - source address of the packet
+ * @param pdu - the NPDU
+ * @param pdu_len - number of bytes in the NPDU
+ * @return true if the packet was queued
+ */
+bool npdu_queue_add(BACNET_ADDRESS *src, uint8_t *pdu, uint16_t pdu_len)
+{
+    NPDU_QUEUE_PACKET *packet;
+    unsigned priority;
+
+    if (!src || !pdu || (pdu_len == 0) || (pdu_len > MAX_MPDU)) {
+        return false;
+    }
+    npdu_queue_init();
+    priority = npdu_queue_priority(pdu, pdu_len);
+    if (Ringbuf_Full(&Queue_Ring[priority])) {
+        /* make room rather than drop the packet */
+        (void)npdu_queue_serve(priority);
+    }
+    packet = (NPDU_QUEUE_PACKET *)Ringbuf_Data_Peek(&Queue_Ring[priority]);
+    if (!packet) {
+        return false;
+    }
+    bacnet_address_copy(&packet->src, src);
+    packet->stamp = mstimer_now();
+    packet->pdu_len = pdu_len;
+    memcpy(&packet->pdu[0], pdu, pdu_len);
+
+    return Ringbuf_Data_Put(
+        &Queue_Ring[priority], (volatile uint8_t *)packet);
+}
+
+/**
+ * Serves one pass of the queue: from life-safety down to normal, up
+ * to the quantum of packets of each priority.
+ *
+ * @return number of packets handled
+ */
+unsigned npdu_queue_task(void)
+{
+    unsigned handled = 0;
+    unsigned priority;
+    unsigned i;
+
+    npdu_queue_init();
+    for (priority = NPDU_QUEUE_PRIORITIES; priority > 0; priority--) {
+        for (i = 0; i < Queue_Quantum[priority - 1]; i++) {
+            if (!npdu_queue_serve(priority - 1)) {
+                break;
+            }
+            handled++;
+        }
+    }
+
+    return handled;
+}
+
+/**
+ * Determines if any packets wait in the queue
+ *
+ * @return true if no packets are queued
+ */
+bool npdu_queue_empty(void)
+{
+    unsigned i;
+
+    npdu_queue_init();
+    for (i = 0; i < NPDU_QUEUE_PRIORITIES; i++) {
+        if (!Ringbuf_Empty(&Queue_Ring[i])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Sets the packets served from a priority in one pass
+ *
+ * @param priority - network priority
+ * @param quantum - packets served each pass, at least one
+ */
+void npdu_queue_quantum_set(BACNET_MESSAGE_PRIORITY priority, unsigned quantum)
+{
+    npdu_queue_init();
+    if ((unsigned)priority < NPDU_QUEUE_PRIORITIES) {
+        if (quantum == 0) {
+            quantum = 1;
+        }
+        Queue_Quantum[priority] = quantum;
+    }
+}
+
+/**
+ * Gets the time the packets of a priority waited in the queue
+ *
+ * @param priority - network priority
+ * @param stats - filled with the count and delays of that priority
+ * @return true if the priority is valid
+ */
+bool npdu_queue_stats(
+    BACNET_MESSAGE_PRIORITY priority, NPDU_QUEUE_STATS *stats)
+{
+    if (((unsigned)priority >= NPDU_QUEUE_PRIORITIES) || !stats) {
+        return false;
+    }
+    *stats = Queue_Stats[priority];
+
+    return true;
+}
+
+/**
+ * Clears the queueing delays of every priority
+ */
+void npdu_queue_stats_reset(void)
+{
+    memset(Queue_Stats, 0, sizeof(Queue_Stats));
+}
@@ -0,0 +1,72 @@
+/**
+ * @file
+ * @brief Inbound queue of NPDU, served by network priority
+ *
+ * Packets from the datalink are queued by the network priority of
+ * their NPDU, and handed to npdu_handler() from life-safety down to
+ * normal.  Each pass serves at most a quantum of packets from each
+ * priority, so a burst of high priority traffic can delay the normal
+ * traffic behind it but cannot starve it.  The time each packet
+ * waited in the queue is kept for every priority.
+ *
+ * @section LICENSE
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef NPDU_QUEUE_H
+#define NPDU_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "bacnet/bacnet_stack_exports.h"
+#include "bacnet/bacdef.h"
+#include "bacnet/bacenum.h"
+
+/* packets queued for each priority - must be a power of two */
+#ifndef NPDU_QUEUE_SIZE
+#define NPDU_QUEUE_SIZE 8
+#endif
+
+/* default packets served from each priority in one pass */
+#ifndef NPDU_QUEUE_QUANTUM
+#define NPDU_QUEUE_QUANTUM 4
+#endif
+
+/* time the packets of one priority waited in the queue */
+typedef struct npdu_queue_stats {
+    /* packets handled */
+    unsigned long count;
+    /* sum and maximum of the milliseconds each packet waited */
+    unsigned long delay_total;
+    unsigned long delay_max;
+} NPDU_QUEUE_STATS;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    BACNET_STACK_EXPORT
+    bool npdu_queue_add(
+        BACNET_ADDRESS * src,
+        uint8_t * pdu,
+        uint16_t pdu_len);
+    BACNET_STACK_EXPORT
+    unsigned npdu_queue_task(void);
+    BACNET_STACK_EXPORT
+    bool npdu_queue_empty(void);
+    BACNET_STACK_EXPORT
+    void npdu_queue_quantum_set(
+        BACNET_MESSAGE_PRIORITY priority,
+        unsigned quantum);
+    BACNET_STACK_EXPORT
+    bool npdu_queue_stats(
+        BACNET_MESSAGE_PRIORITY priority,
+        NPDU_QUEUE_STATS * stats);
+    BACNET_STACK_EXPORT
+    void npdu_queue_stats_reset(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif
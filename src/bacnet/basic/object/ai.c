@@ -366,13 +366,13 @@ void Analog_Input_Out_Of_Service_Set(uint32_t object_instance, bool value)
 int Analog_Input_Read_Property(BACNET_READ_PROPERTY_DATA *rpdata)
 {
     int apdu_len = 0; /* return value */
-    BACNET_BIT_STRING bit_string;
     BACNET_CHARACTER_STRING char_string;
     ANALOG_INPUT_DESCR *CurrentAI;
     unsigned object_index = 0;
 #if defined(INTRINSIC_REPORTING)
     unsigned i = 0;
     int len = 0;
+    BACNET_BIT_STRING bit_string;
 #endif
     uint8_t *apdu = NULL;
 
@@ -413,16 +413,10 @@ int Analog_Input_Read_Property(BACNET_READ_PROPERTY_DATA *rpdata)
             break;
 
         case PROP_STATUS_FLAGS:
-            bitstring_init(&bit_string);
-            bitstring_set_bit(&bit_string, STATUS_FLAG_IN_ALARM,
+            apdu_len = encode_application_status_flags(&apdu[0],
                 Analog_Input_Event_State(rpdata->object_instance) !=
-                    EVENT_STATE_NORMAL);
-            bitstring_set_bit(&bit_string, STATUS_FLAG_FAULT, false);
-            bitstring_set_bit(&bit_string, STATUS_FLAG_OVERRIDDEN, false);
-            bitstring_set_bit(&bit_string, STATUS_FLAG_OUT_OF_SERVICE,
-                CurrentAI->Out_Of_Service);
-
-            apdu_len = encode_application_bitstring(&apdu[0], &bit_string);
+                    EVENT_STATE_NORMAL,
+                false, false, CurrentAI->Out_Of_Service);
             break;
 
         case PROP_EVENT_STATE:
@@ -975,7 +975,6 @@ int Analog_Output_Read_Property(BACNET_READ_PROPERTY_DATA *rpdata)
 {
     int apdu_len = 0; /* return value */
     int apdu_size = 0;
-    BACNET_BIT_STRING bit_string;
     BACNET_CHARACTER_STRING char_string;
     uint8_t *apdu = NULL;
     uint32_t units = 0;
@@ -1016,15 +1015,10 @@ int Analog_Output_Read_Property(BACNET_READ_PROPERTY_DATA *rpdata)
             apdu_len = encode_application_real(&apdu[0], real_value);
             break;
         case PROP_STATUS_FLAGS:
-            bitstring_init(&bit_string);
-            bitstring_set_bit(&bit_string, STATUS_FLAG_IN_ALARM, false);
-            state = Analog_Output_Fault(rpdata->object_instance);
-            bitstring_set_bit(&bit_string, STATUS_FLAG_FAULT, state);
-            state = Analog_Output_Overridden(rpdata->object_instance);
-            bitstring_set_bit(&bit_string, STATUS_FLAG_OVERRIDDEN, state);
-            state = Analog_Output_Out_Of_Service(rpdata->object_instance);
-            bitstring_set_bit(&bit_string, STATUS_FLAG_OUT_OF_SERVICE, state);
-            apdu_len = encode_application_bitstring(&apdu[0], &bit_string);
+            apdu_len = encode_application_status_flags(&apdu[0], false,
+                Analog_Output_Fault(rpdata->object_instance),
+                Analog_Output_Overridden(rpdata->object_instance),
+                Analog_Output_Out_Of_Service(rpdata->object_instance));
             break;
         case PROP_RELIABILITY:
             apdu_len = encode_application_enumerated(
@@ -467,7 +467,6 @@ void Analog_Value_Out_Of_Service_Set(uint32_t object_instance, bool value)
 int Analog_Value_Read_Property(BACNET_READ_PROPERTY_DATA *rpdata)
 {
     int apdu_len = 0; /* return value */
-    BACNET_BIT_STRING bit_string;
     BACNET_CHARACTER_STRING char_string;
     float real_value = (float)1.414;
     unsigned object_index = 0;
@@ -477,6 +476,7 @@ int Analog_Value_Read_Property(BACNET_READ_PROPERTY_DATA *rpdata)
 #if defined(INTRINSIC_REPORTING)
     int len = 0;
     unsigned i = 0;
+    BACNET_BIT_STRING bit_string;
 #endif
 
     /* Valid data? */
@@ -525,16 +525,10 @@ int Analog_Value_Read_Property(BACNET_READ_PROPERTY_DATA *rpdata)
             break;
 
         case PROP_STATUS_FLAGS:
-            bitstring_init(&bit_string);
-            bitstring_set_bit(&bit_string, STATUS_FLAG_IN_ALARM,
+            apdu_len = encode_application_status_flags(&apdu[0],
                 Analog_Value_Event_State(rpdata->object_instance) !=
-                    EVENT_STATE_NORMAL);
-            bitstring_set_bit(&bit_string, STATUS_FLAG_FAULT, false);
-            bitstring_set_bit(&bit_string, STATUS_FLAG_OVERRIDDEN, false);
-            bitstring_set_bit(&bit_string, STATUS_FLAG_OUT_OF_SERVICE,
-                CurrentAV->Out_Of_Service);
-
-            apdu_len = encode_application_bitstring(&apdu[0], &bit_string);
+                    EVENT_STATE_NORMAL,
+                false, false, CurrentAV->Out_Of_Service);
             break;
 
         case PROP_EVENT_STATE:
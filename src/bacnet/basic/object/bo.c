@@ -951,7 +951,6 @@ bool Binary_Output_Encode_Value_List(
 int Binary_Output_Read_Property(BACNET_READ_PROPERTY_DATA *rpdata)
 {
     int apdu_len = 0; /* return value */
-    BACNET_BIT_STRING bit_string;
     BACNET_CHARACTER_STRING char_string;
     BACNET_BINARY_PV present_value = BINARY_INACTIVE;
     BACNET_POLARITY polarity = POLARITY_NORMAL;
@@ -986,14 +985,9 @@ int Binary_Output_Read_Property(BACNET_READ_PROPERTY_DATA *rpdata)
             break;
         case PROP_STATUS_FLAGS:
             /* note: see the details in the standard on how to use these */
-            bitstring_init(&bit_string);
-            bitstring_set_bit(&bit_string, STATUS_FLAG_IN_ALARM, false);
-            state = Binary_Output_Fault(rpdata->object_instance);
-            bitstring_set_bit(&bit_string, STATUS_FLAG_FAULT, state);
-            bitstring_set_bit(&bit_string, STATUS_FLAG_OVERRIDDEN, false);
-            state = Binary_Output_Out_Of_Service(rpdata->object_instance);
-            bitstring_set_bit(&bit_string, STATUS_FLAG_OUT_OF_SERVICE, state);
-            apdu_len = encode_application_bitstring(&apdu[0], &bit_string);
+            apdu_len = encode_application_status_flags(&apdu[0], false,
+                Binary_Output_Fault(rpdata->object_instance), false,
+                Binary_Output_Out_Of_Service(rpdata->object_instance));
             break;
         case PROP_RELIABILITY:
             apdu_len = encode_application_enumerated(
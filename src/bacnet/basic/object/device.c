@@ -44,6 +44,7 @@
 #include "bacnet/basic/services.h"
 #include "bacnet/datalink/datalink.h"
 #include "bacnet/basic/binding/address.h"
+#include "bacnet/basic/sys/persist.h"
 /* include the device object */
 #include "bacnet/basic/object/device.h"
 #include "bacnet/basic/object/acc.h"
@@ -528,6 +529,9 @@ static uint32_t Interval_Offset_Minutes;
 /* Max_Info_Frames - rely on MS/TP subsystem, if there is one */
 /* Device_Address_Binding - required, but relies on binding cache */
 static uint32_t Database_Revision = 0;
+/* bulk provisioning - see Device_Provisioning_Begin() */
+static bool Provisioning;
+static bool Provisioning_Changed;
 /* Configuration_Files */
 /* Last_Restore_Time */
 /* Backup_Failure_Timeout */
@@ -876,7 +880,36 @@ void Device_Set_Database_Revision(uint32_t revision)
  */
 void Device_Inc_Database_Revision(void)
 {
-    Database_Revision++;
+    if (Provisioning) {
+        Provisioning_Changed = true;
+    } else {
+        Database_Revision++;
+    }
+}
+
+/**
+ * @brief Starts a bulk load of objects. Until Device_Provisioning_End(),
+ *  database revision changes are folded into one, and object names are
+ *  not checked for uniqueness - the loader has already checked them all
+ *  in one sorted pass, instead of one scan of every object per name.
+ */
+void Device_Provisioning_Begin(void)
+{
+    Provisioning = true;
+    Provisioning_Changed = false;
+}
+
+/**
+ * @brief Ends a bulk load of objects, incrementing the database revision
+ *  once if any object was created or renamed during the load.
+ */
+void Device_Provisioning_End(void)
+{
+    Provisioning = false;
+    if (Provisioning_Changed) {
+        Provisioning_Changed = false;
+        Database_Revision++;
+    }
 }
 
 /** Get the total count of objects supported by this Device Object.
@@ -1014,6 +1047,10 @@ bool Device_Valid_Object_Name(BACNET_CHARACTER_STRING *object_name1,
     BACNET_CHARACTER_STRING object_name2;
     struct object_functions *pObject = NULL;
 
+    if (Provisioning) {
+        /* names were checked by the bulk loader */
+        return false;
+    }
     max_objects = Device_Object_List_Count();
     for (i = 1; i <= max_objects; i++) {
         check_id = Device_Object_List_Identifier(i, &type, &instance);
@@ -1743,6 +1780,112 @@ bool Device_Write_Property_Local(BACNET_WRITE_PROPERTY_DATA *wp_data)
     return status;
 }
 
+/**
+ * @brief Stores a written value if its property is registered as persistent.
+ *  A relinquished priority array slot is removed from the store.
+ * @param wp_data [in] The successful WriteProperty request
+ */
+static void Device_Write_Property_Persist(BACNET_WRITE_PROPERTY_DATA *wp_data)
+{
+    PERSIST_KEY key;
+
+    if (!Persist_Property_Enabled(
+            wp_data->object_type, wp_data->object_property)) {
+        return;
+    }
+    key.object_type = wp_data->object_type;
+    key.object_instance = wp_data->object_instance;
+    key.object_property = wp_data->object_property;
+    key.array_index = wp_data->array_index;
+    key.priority = wp_data->priority;
+    if ((wp_data->priority != BACNET_NO_PRIORITY) &&
+        (wp_data->application_data_len == 1) &&
+        (wp_data->application_data[0] == BACNET_APPLICATION_TAG_NULL)) {
+        Persist_Value_Delete(&key);
+    } else if (wp_data->application_data_len > 0) {
+        Persist_Value_Set(&key, wp_data->application_data,
+            (uint16_t)wp_data->application_data_len);
+    }
+}
+
+/**
+ * @brief Stores the whole value of a list property changed by
+ *  AddListElement or RemoveListElement, if it is registered as persistent
+ * @param list_element [in] The successful list element request
+ */
+static void Device_List_Element_Persist(
+    BACNET_LIST_ELEMENT_DATA *list_element)
+{
+    static uint8_t apdu[MAX_APDU];
+    BACNET_READ_PROPERTY_DATA rpdata = { 0 };
+    PERSIST_KEY key;
+    int apdu_len;
+
+    if (!Persist_Property_Enabled(
+            list_element->object_type, list_element->object_property)) {
+        return;
+    }
+    rpdata.object_type = list_element->object_type;
+    rpdata.object_instance = list_element->object_instance;
+    rpdata.object_property = list_element->object_property;
+    rpdata.array_index = BACNET_ARRAY_ALL;
+    rpdata.application_data = apdu;
+    rpdata.application_data_len = sizeof(apdu);
+    apdu_len = Device_Read_Property(&rpdata);
+    if (apdu_len > 0) {
+        key.object_type = list_element->object_type;
+        key.object_instance = list_element->object_instance;
+        key.object_property = list_element->object_property;
+        key.array_index = BACNET_ARRAY_ALL;
+        key.priority = BACNET_NO_PRIORITY;
+        Persist_Value_Set(&key, apdu, (uint16_t)apdu_len);
+    }
+}
+
+/**
+ * @brief Writes one stored value back to its object
+ * @param key [in] The property and priority of the value
+ * @param data [in] The application encoded value
+ * @param length [in] The number of octets of the value
+ * @param context [in] Counts the values that were written
+ */
+static void Device_Persist_Restore_Value(const PERSIST_KEY *key,
+    const uint8_t *data,
+    uint16_t length,
+    void *context)
+{
+    static BACNET_WRITE_PROPERTY_DATA wp_data;
+    unsigned *count = context;
+
+    if (length > sizeof(wp_data.application_data)) {
+        return;
+    }
+    wp_data.object_type = key->object_type;
+    wp_data.object_instance = key->object_instance;
+    wp_data.object_property = key->object_property;
+    wp_data.array_index = key->array_index;
+    wp_data.priority = key->priority;
+    memcpy(wp_data.application_data, data, length);
+    wp_data.application_data_len = length;
+    if (Device_Write_Property(&wp_data)) {
+        (*count)++;
+    }
+}
+
+/**
+ * @brief Writes the stored persistent values back to their objects,
+ *  usually after Persist_Init() and before the datalink starts
+ * @return The number of values written
+ */
+unsigned Device_Persist_Restore(void)
+{
+    unsigned count = 0;
+
+    Persist_Restore(Device_Persist_Restore_Value, &count);
+
+    return count;
+}
+
 /** Looks up the requested Object and Property, and set the new Value in it,
  *  if allowed.
  * If the Object or Property can't be found, sets the error class and code.
@@ -1774,6 +1917,9 @@ bool Device_Write_Property(BACNET_WRITE_PROPERTY_DATA *wp_data)
                 {
                     status = pObject->Object_Write_Property(wp_data);
                 }
+                if (status) {
+                    Device_Write_Property_Persist(wp_data);
+                }
             } else {
                 wp_data->error_class = ERROR_CLASS_PROPERTY;
                 wp_data->error_code = ERROR_CODE_WRITE_ACCESS_DENIED;
@@ -1809,6 +1955,9 @@ int Device_Add_List_Element(
             pObject->Object_Valid_Instance(list_element->object_instance)) {
             if (pObject->Object_Add_List_Element) {
                 status = pObject->Object_Add_List_Element(list_element);
+                if (status >= BACNET_STATUS_OK) {
+                    Device_List_Element_Persist(list_element);
+                }
             } else {
                 list_element->error_class = ERROR_CLASS_PROPERTY;
                 list_element->error_code = ERROR_CODE_WRITE_ACCESS_DENIED;
@@ -1844,6 +1993,9 @@ int Device_Remove_List_Element(
             pObject->Object_Valid_Instance(list_element->object_instance)) {
             if (pObject->Object_Remove_List_Element) {
                 status = pObject->Object_Remove_List_Element(list_element);
+                if (status >= BACNET_STATUS_OK) {
+                    Device_List_Element_Persist(list_element);
+                }
             } else {
                 list_element->error_class = ERROR_CLASS_PROPERTY;
                 list_element->error_code = ERROR_CODE_WRITE_ACCESS_DENIED;
@@ -427,6 +427,12 @@ extern "C" {
     BACNET_STACK_EXPORT
     void Device_Inc_Database_Revision(
         void);
+    BACNET_STACK_EXPORT
+    void Device_Provisioning_Begin(
+        void);
+    BACNET_STACK_EXPORT
+    void Device_Provisioning_End(
+        void);
 
     BACNET_STACK_EXPORT
     bool Device_Valid_Object_Name(
@@ -444,6 +450,9 @@ extern "C" {
     BACNET_STACK_EXPORT
     bool Device_Write_Property(
         BACNET_WRITE_PROPERTY_DATA * wp_data);
+    BACNET_STACK_EXPORT
+    unsigned Device_Persist_Restore(
+        void);
 
     BACNET_STACK_EXPORT
     int Device_Add_List_Element(
@@ -46,6 +46,7 @@
 //#include "bacnet/datalink/datalink.h"
 #include "bacnet/basic/object/device.h"
 #include "bacnet/basic/object/diagnostic.h"
+#include "bacnet/basic/service/h_apdu.h"
 #include "bacnet/readrange.h"
 
 
@@ -72,7 +73,11 @@ static const int Diagnostic_Properties_Required[] = {
 
 static const int Diagnostic_Properties_Optional[] = { -1 };
 
-static const int Diagnostic_Properties_Proprietary[] = { -1 };
+static const int Diagnostic_Properties_Proprietary[] = {
+    PROP_DIAGNOSTIC_REQUESTS_ADMITTED,
+    PROP_DIAGNOSTIC_REQUESTS_ABORTED,
+    PROP_DIAGNOSTIC_REQUESTS_DROPPED,
+    -1 };
 
 /**
  * Returns the list of required, optional, and proprietary properties.
@@ -367,10 +372,10 @@ int Diagnostic_Read_Property(BACNET_READ_PROPERTY_DATA *rpdata)
 {
     int apdu_len = 0;
     int apdu_size ;
-    BACNET_BIT_STRING bit_string;
 //    BACNET_OCTET_STRING octet_string;
     BACNET_CHARACTER_STRING char_string;
     uint8_t *apdu;
+    uint32_t admitted = 0, aborted = 0, dropped = 0;
     const int *pRequired = NULL;
     const int *pOptional = NULL;
     const int *pProprietary = NULL;
@@ -392,7 +397,7 @@ int Diagnostic_Read_Property(BACNET_READ_PROPERTY_DATA *rpdata)
     apdu = rpdata->application_data;
     apdu_size = rpdata->application_data_len;
 
-    switch (rpdata->object_property) {
+    switch ((int)rpdata->object_property) {
         case PROP_OBJECT_IDENTIFIER:
             apdu_len = encode_application_object_id(
                 &apdu[0], OBJECT_NETWORK_PORT, rpdata->object_instance);
@@ -407,23 +412,10 @@ int Diagnostic_Read_Property(BACNET_READ_PROPERTY_DATA *rpdata)
                 encode_application_enumerated(&apdu[0], OBJECT_NETWORK_PORT);
             break;
         case PROP_STATUS_FLAGS:
-            bitstring_init(&bit_string);
-            bitstring_set_bit(&bit_string, STATUS_FLAG_IN_ALARM, false);
-            if (Diagnostic_Reliability(rpdata->object_instance) ==
-                RELIABILITY_NO_FAULT_DETECTED) {
-                bitstring_set_bit(&bit_string, STATUS_FLAG_FAULT, false);
-            } else {
-                bitstring_set_bit(&bit_string, STATUS_FLAG_FAULT, true);
-            }
-            bitstring_set_bit(&bit_string, STATUS_FLAG_OVERRIDDEN, false);
-            if (Diagnostic_Out_Of_Service(rpdata->object_instance)) {
-                bitstring_set_bit(
-                    &bit_string, STATUS_FLAG_OUT_OF_SERVICE, true);
-            } else {
-                bitstring_set_bit(
-                    &bit_string, STATUS_FLAG_OUT_OF_SERVICE, false);
-            }
-            apdu_len = encode_application_bitstring(&apdu[0], &bit_string);
+            apdu_len = encode_application_status_flags(&apdu[0], false,
+                Diagnostic_Reliability(rpdata->object_instance) !=
+                    RELIABILITY_NO_FAULT_DETECTED,
+                false, Diagnostic_Out_Of_Service(rpdata->object_instance));
             break;
         case PROP_RELIABILITY:
             apdu_len = encode_application_enumerated(
@@ -433,6 +425,18 @@ int Diagnostic_Read_Property(BACNET_READ_PROPERTY_DATA *rpdata)
             apdu_len = encode_application_boolean(
                 &apdu[0], Diagnostic_Out_Of_Service(rpdata->object_instance));
             break;
+        case PROP_DIAGNOSTIC_REQUESTS_ADMITTED:
+            apdu_admission_counters(&admitted, NULL, NULL);
+            apdu_len = encode_application_unsigned(&apdu[0], admitted);
+            break;
+        case PROP_DIAGNOSTIC_REQUESTS_ABORTED:
+            apdu_admission_counters(NULL, &aborted, NULL);
+            apdu_len = encode_application_unsigned(&apdu[0], aborted);
+            break;
+        case PROP_DIAGNOSTIC_REQUESTS_DROPPED:
+            apdu_admission_counters(NULL, NULL, &dropped);
+            apdu_len = encode_application_unsigned(&apdu[0], dropped);
+            break;
 
         default:
             rpdata->error_class = ERROR_CLASS_PROPERTY;
@@ -487,7 +491,7 @@ bool Diagnostic_Write_Property(BACNET_WRITE_PROPERTY_DATA *wp_data)
         return false;
     }
     /* FIXME: len < application_data_len: more data? */
-    switch (wp_data->object_property) 
+    switch ((int)wp_data->object_property) 
     {
         case PROP_OBJECT_IDENTIFIER:
         case PROP_OBJECT_NAME:
@@ -495,6 +499,9 @@ bool Diagnostic_Write_Property(BACNET_WRITE_PROPERTY_DATA *wp_data)
         case PROP_STATUS_FLAGS:
         case PROP_RELIABILITY:
         case PROP_OUT_OF_SERVICE:
+        case PROP_DIAGNOSTIC_REQUESTS_ADMITTED:
+        case PROP_DIAGNOSTIC_REQUESTS_ABORTED:
+        case PROP_DIAGNOSTIC_REQUESTS_DROPPED:
             wp_data->error_class = ERROR_CLASS_PROPERTY;
             wp_data->error_code = ERROR_CODE_WRITE_ACCESS_DENIED;
             break;
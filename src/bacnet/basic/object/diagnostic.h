@@ -42,6 +42,12 @@
 #include "bacnet/rp.h"
 #include "bacnet/wp.h"
 
+/* proprietary properties with the counts of confirmed requests that
+   were run, or were over the limit of their source or of all sources */
+#define PROP_DIAGNOSTIC_REQUESTS_ADMITTED 512
+#define PROP_DIAGNOSTIC_REQUESTS_ABORTED 513
+#define PROP_DIAGNOSTIC_REQUESTS_DROPPED 514
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -444,7 +444,6 @@ int Multistate_Input_Read_Property(BACNET_READ_PROPERTY_DATA *rpdata)
 {
     int len = 0;
     int apdu_len = 0; /* return value */
-    BACNET_BIT_STRING bit_string;
     BACNET_CHARACTER_STRING char_string;
     uint32_t present_value = 0;
     unsigned i = 0;
@@ -486,18 +485,8 @@ int Multistate_Input_Read_Property(BACNET_READ_PROPERTY_DATA *rpdata)
             break;
         case PROP_STATUS_FLAGS:
             /* note: see the details in the standard on how to use these */
-            bitstring_init(&bit_string);
-            bitstring_set_bit(&bit_string, STATUS_FLAG_IN_ALARM, false);
-            bitstring_set_bit(&bit_string, STATUS_FLAG_FAULT, false);
-            bitstring_set_bit(&bit_string, STATUS_FLAG_OVERRIDDEN, false);
-            if (Multistate_Input_Out_Of_Service(rpdata->object_instance)) {
-                bitstring_set_bit(
-                    &bit_string, STATUS_FLAG_OUT_OF_SERVICE, true);
-            } else {
-                bitstring_set_bit(
-                    &bit_string, STATUS_FLAG_OUT_OF_SERVICE, false);
-            }
-            apdu_len = encode_application_bitstring(&apdu[0], &bit_string);
+            apdu_len = encode_application_status_flags(&apdu[0], false, false,
+                false, Multistate_Input_Out_Of_Service(rpdata->object_instance));
             break;
         case PROP_EVENT_STATE:
             /* note: see the details in the standard on how to use this */
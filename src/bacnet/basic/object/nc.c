@@ -613,7 +613,7 @@ void Notification_Class_common_reporting_function(
                 PRINTF("Notification Class[%u]: send notification to %u\n",
                     event_data->notificationClass, (unsigned)device_id);
                 if (pBacDest->ConfirmedNotify == true)
-                    Send_CEvent_Notify(device_id, event_data);
+                    Send_CEvent_Notify_Queue(device_id, event_data);
                 else if (address_get_by_device(device_id, &max_apdu, &dest))
                     Send_UEvent_Notify(Event_Buffer, event_data, &dest);
             } else if (pBacDest->Recipient.tag ==
@@ -621,11 +621,11 @@ void Notification_Class_common_reporting_function(
                 PRINTF("Notification Class[%u]: send notification to ADDR\n",
                     event_data->notificationClass);
                 /* send notification to the address indicated */
+                dest = pBacDest->Recipient.type.address;
                 if (pBacDest->ConfirmedNotify == true) {
                     if (address_get_device_id(&dest, &device_id))
-                        Send_CEvent_Notify(device_id, event_data);
+                        Send_CEvent_Notify_Queue(device_id, event_data);
                 } else {
-                    dest = pBacDest->Recipient.type.address;
                     Send_UEvent_Notify(Event_Buffer, event_data, &dest);
                 }
             }
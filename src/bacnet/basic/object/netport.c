@@ -2345,6 +2345,8 @@ int Network_Port_Read_Property(BACNET_READ_PROPERTY_DATA *rpdata)
                 Network_Port_BBMD_BD_Table(rpdata->object_instance));
             break;
         case PROP_BBMD_FOREIGN_DEVICE_TABLE:
+            /* brings the seconds remaining of the BBMD table up to date */
+            (void)bvlc_fdt_list();
             apdu_len = bvlc_foreign_device_table_encode(&apdu[0],
                 rpdata->application_data_len,
                 Network_Port_BBMD_FD_Table(rpdata->object_instance));
@@ -0,0 +1,1019 @@
+/**
+ * @file
+ * @brief Bulk provisioning of objects from a CSV or JSON point list
+ *
+ * @section DESCRIPTION
+ *
+ * The point list is parsed in place, so the object names and
+ * descriptions that the objects keep are pointers into the text, which
+ * must stay valid while the objects exist.  Every point is parsed and
+ * checked before any object is changed: the points are sorted once by
+ * object identifier to find duplicates, and the new names are sorted
+ * together with the names of the other objects in the Device to find
+ * duplicate names.  The objects are then created or updated in object
+ * identifier order, which appends to the sorted object lists, while
+ * the Device folds the changes into a single database revision.
+ *
+ * @section LICENSE
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "bacnet/bacdef.h"
+#include "bacnet/bacenum.h"
+#include "bacnet/bacstr.h"
+#include "bacnet/bactext.h"
+#include "bacnet/basic/object/device.h"
+#include "bacnet/basic/object/ai.h"
+#include "bacnet/basic/object/ao.h"
+#include "bacnet/basic/object/av.h"
+#include "bacnet/basic/object/bo.h"
+#include "bacnet/basic/object/ms-input.h"
+#include "bacnet/basic/object/mso.h"
+#include "bacnet/basic/object/msv.h"
+#include "bacnet/basic/object/provision.h"
+
+/* most CSV columns, including columns that are ignored */
+#ifndef PROVISION_COLUMN_MAX
+#define PROVISION_COLUMN_MAX 16
+#endif
+/* longest JSON number or keyword */
+#define PROVISION_TOKEN_MAX 32
+
+/* the fields of a point, in the default CSV column order */
+enum provision_field {
+    FIELD_TYPE,
+    FIELD_INSTANCE,
+    FIELD_NAME,
+    FIELD_UNITS,
+    FIELD_DESCRIPTION,
+    FIELD_COV_INCREMENT,
+    FIELD_MAX
+};
+#define FIELD_UNKNOWN FIELD_MAX
+
+static const char *Field_Names[FIELD_MAX] = { "type", "instance", "name",
+    "units", "description", "cov_increment" };
+
+typedef struct provision_point {
+    BACNET_OBJECT_TYPE object_type;
+    uint32_t object_instance;
+    char *object_name;
+    char *description;
+    uint16_t units;
+    float cov_increment;
+    /* bit for each field that was given */
+    unsigned fields;
+    /* line of the point list, for errors */
+    unsigned line;
+} PROVISION_POINT;
+
+typedef struct provision_list {
+    PROVISION_POINT *point;
+    size_t count;
+    size_t size;
+} PROVISION_LIST;
+
+/* an object name, and the point that gives it or NULL for the
+   name of another object in the Device */
+typedef struct provision_name {
+    char *name;
+    const PROVISION_POINT *point;
+} PROVISION_NAME;
+
+/* the object functions used to provision each type of object */
+struct provision_functions {
+    BACNET_OBJECT_TYPE object_type;
+    uint32_t (*Create)(uint32_t object_instance);
+    bool (*Valid_Instance)(uint32_t object_instance);
+    bool (*Name_Set)(uint32_t object_instance, char *new_name);
+    bool (*Description_Set)(uint32_t object_instance, char *new_name);
+    bool (*Units_Set)(uint32_t object_instance, uint16_t units);
+    void (*COV_Increment_Set)(uint32_t object_instance, float value);
+};
+
+/* objects without a Create function must already exist */
+static const struct provision_functions Object_Table[] = {
+    { OBJECT_ANALOG_INPUT, NULL, Analog_Input_Valid_Instance, NULL, NULL,
+        NULL, Analog_Input_COV_Increment_Set },
+    { OBJECT_ANALOG_OUTPUT, Analog_Output_Create,
+        Analog_Output_Valid_Instance, Analog_Output_Name_Set,
+        Analog_Output_Description_Set, Analog_Output_Units_Set,
+        Analog_Output_COV_Increment_Set },
+    { OBJECT_ANALOG_VALUE, NULL, Analog_Value_Valid_Instance, NULL, NULL,
+        NULL, Analog_Value_COV_Increment_Set },
+    { OBJECT_BINARY_OUTPUT, Binary_Output_Create,
+        Binary_Output_Valid_Instance, Binary_Output_Name_Set,
+        Binary_Output_Description_Set, NULL, NULL },
+    { OBJECT_MULTI_STATE_INPUT, NULL, Multistate_Input_Valid_Instance,
+        Multistate_Input_Name_Set, Multistate_Input_Description_Set, NULL,
+        NULL },
+    { OBJECT_MULTI_STATE_OUTPUT, Multistate_Output_Create,
+        Multistate_Output_Valid_Instance, Multistate_Output_Name_Set,
+        Multistate_Output_Description_Set, NULL, NULL },
+    { OBJECT_MULTI_STATE_VALUE, NULL, Multistate_Value_Valid_Instance,
+        Multistate_Value_Name_Set, Multistate_Value_Description_Set, NULL,
+        NULL },
+};
+
+/**
+ * Finds the provisioning functions for an object type
+ *
+ * @param object_type - type of object
+ * @return the functions, or NULL if the type is not supported
+ */
+static const struct provision_functions *provision_functions_find(
+    BACNET_OBJECT_TYPE object_type)
+{
+    size_t i;
+
+    for (i = 0; i < sizeof(Object_Table) / sizeof(Object_Table[0]); i++) {
+        if (Object_Table[i].object_type == object_type) {
+            return &Object_Table[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Finds a field by its name
+ *
+ * @param name - CSV column heading or JSON key
+ * @return the field, or FIELD_UNKNOWN
+ */
+static unsigned provision_field_index(const char *name)
+{
+    unsigned field;
+
+    for (field = 0; field < FIELD_MAX; field++) {
+        if (strcmp(name, Field_Names[field]) == 0) {
+            break;
+        }
+    }
+
+    return field;
+}
+
+/**
+ * Converts the text of a field into a point
+ *
+ * @param point - point being parsed
+ * @param field - which field
+ * @param value - text of the value, in place; empty if not given
+ * @param retained - true if the value text stays valid, so that it can
+ *  be used as an object name or description
+ * @return true if the value is valid
+ */
+static bool provision_field_set(
+    PROVISION_POINT *point, unsigned field, char *value, bool retained)
+{
+    unsigned index = 0;
+    unsigned long number;
+    double real;
+    char *end = NULL;
+
+    if ((field >= FIELD_MAX) || (value[0] == 0)) {
+        /* unknown fields are ignored, and empty fields are not set */
+        return true;
+    }
+    switch (field) {
+        case FIELD_TYPE:
+            if (!bactext_object_type_strtol(value, &index) ||
+                (index >= MAX_BACNET_OBJECT_TYPE)) {
+                return false;
+            }
+            point->object_type = (BACNET_OBJECT_TYPE)index;
+            break;
+        case FIELD_INSTANCE:
+            if (!isdigit((unsigned char)value[0])) {
+                return false;
+            }
+            number = strtoul(value, &end, 10);
+            if ((*end != 0) || (number >= BACNET_MAX_INSTANCE)) {
+                return false;
+            }
+            point->object_instance = (uint32_t)number;
+            break;
+        case FIELD_NAME:
+            if (!retained) {
+                return false;
+            }
+            point->object_name = value;
+            break;
+        case FIELD_DESCRIPTION:
+            if (!retained) {
+                return false;
+            }
+            point->description = value;
+            break;
+        case FIELD_UNITS:
+            if (bactext_engineering_unit_index(value, &index)) {
+                number = index;
+            } else if (isdigit((unsigned char)value[0])) {
+                number = strtoul(value, &end, 10);
+                if (*end != 0) {
+                    return false;
+                }
+            } else {
+                return false;
+            }
+            if (number > UINT16_MAX) {
+                return false;
+            }
+            point->units = (uint16_t)number;
+            break;
+        case FIELD_COV_INCREMENT:
+            real = strtod(value, &end);
+            if ((end == value) || (*end != 0) || !(real >= 0.0)) {
+                return false;
+            }
+            point->cov_increment = (float)real;
+            break;
+        default:
+            break;
+    }
+    point->fields |= (1U << field);
+
+    return true;
+}
+
+/**
+ * Adds a parsed point to the list
+ *
+ * @param list - list of points
+ * @param point - point to add
+ * @return true if added, false if out of memory
+ */
+static bool provision_point_add(PROVISION_LIST *list, const PROVISION_POINT *point)
+{
+    PROVISION_POINT *new_point;
+    size_t new_size;
+
+    if (list->count == list->size) {
+        new_size = list->size + (list->size / 2) + 64;
+        new_point = realloc(list->point, new_size * sizeof(PROVISION_POINT));
+        if (!new_point) {
+            return false;
+        }
+        list->point = new_point;
+        list->size = new_size;
+    }
+    list->point[list->count] = *point;
+    list->count++;
+
+    return true;
+}
+
+/**
+ * Splits one CSV record into fields, in place
+ *
+ * @param record - text of the record, without the line ending
+ * @param field - filled with the start of each field
+ * @param count - filled with the number of fields
+ * @return false if a quoted field is malformed
+ */
+static bool provision_csv_split(char *record, char **field, unsigned *count)
+{
+    char *r = record;
+    char *w;
+    char *start;
+    char delimiter;
+    unsigned n = 0;
+
+    for (;;) {
+        while ((*r == ' ') || (*r == '\t')) {
+            r++;
+        }
+        start = r;
+        if (*r == '"') {
+            /* a doubled quote is a quote */
+            r++;
+            w = start;
+            for (;;) {
+                if (*r == 0) {
+                    return false;
+                } else if (*r == '"') {
+                    r++;
+                    if (*r != '"') {
+                        break;
+                    }
+                }
+                *w++ = *r++;
+            }
+            while ((*r == ' ') || (*r == '\t')) {
+                r++;
+            }
+            if ((*r != ',') && (*r != 0)) {
+                return false;
+            }
+        } else {
+            while ((*r != ',') && (*r != 0)) {
+                r++;
+            }
+            w = r;
+            while ((w > start) && ((w[-1] == ' ') || (w[-1] == '\t'))) {
+                w--;
+            }
+        }
+        delimiter = *r;
+        *w = 0;
+        if (n < PROVISION_COLUMN_MAX) {
+            field[n] = start;
+            n++;
+        }
+        if (delimiter == 0) {
+            break;
+        }
+        r++;
+    }
+    *count = n;
+
+    return true;
+}
+
+/**
+ * Parses a CSV point list, in place
+ *
+ * @param list - list to add the points to
+ * @param text - the point list
+ * @param error_line - filled with the line of an error
+ * @return true if every point was parsed
+ */
+static bool provision_csv(PROVISION_LIST *list, char *text, unsigned *error_line)
+{
+    unsigned column_field[PROVISION_COLUMN_MAX];
+    char *field[PROVISION_COLUMN_MAX];
+    PROVISION_POINT point;
+    char *record;
+    char *next = text;
+    size_t length;
+    unsigned column, count;
+    unsigned line = 0;
+    bool first = true;
+
+    for (column = 0; column < PROVISION_COLUMN_MAX; column++) {
+        column_field[column] = (column < FIELD_MAX) ? column : FIELD_UNKNOWN;
+    }
+    while (next) {
+        record = next;
+        line++;
+        next = strchr(record, '\n');
+        if (next) {
+            *next = 0;
+            next++;
+        }
+        length = strlen(record);
+        if ((length > 0) && (record[length - 1] == '\r')) {
+            record[length - 1] = 0;
+        }
+        while (isspace((unsigned char)*record)) {
+            record++;
+        }
+        if ((*record == 0) || (*record == '#')) {
+            continue;
+        }
+        if (!provision_csv_split(record, field, &count)) {
+            *error_line = line;
+            return false;
+        }
+        if (first && (strcmp(field[0], Field_Names[FIELD_TYPE]) == 0)) {
+            /* a header line gives the column order */
+            for (column = 0; column < PROVISION_COLUMN_MAX; column++) {
+                column_field[column] = FIELD_UNKNOWN;
+                if (column < count) {
+                    column_field[column] = provision_field_index(field[column]);
+                }
+            }
+            first = false;
+            continue;
+        }
+        first = false;
+        memset(&point, 0, sizeof(point));
+        point.line = line;
+        for (column = 0; column < count; column++) {
+            if (!provision_field_set(
+                    &point, column_field[column], field[column], true)) {
+                *error_line = line;
+                return false;
+            }
+        }
+        if (!provision_point_add(list, &point)) {
+            *error_line = line;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Skips JSON white space, counting lines
+ *
+ * @param text - current position, advanced
+ * @param line - current line, advanced
+ */
+static void provision_json_space(char **text, unsigned *line)
+{
+    char *p = *text;
+
+    while (isspace((unsigned char)*p)) {
+        if (*p == '\n') {
+            (*line)++;
+        }
+        p++;
+    }
+    *text = p;
+}
+
+/**
+ * Decodes a JSON string in place, as UTF-8
+ *
+ * @param text - current position at the opening quote, advanced past
+ *  the closing quote
+ * @return the decoded string, or NULL if malformed
+ */
+static char *provision_json_string(char **text)
+{
+    char *r = *text;
+    char *w;
+    char *start;
+    unsigned long code;
+    unsigned i;
+    int digit;
+
+    if (*r != '"') {
+        return NULL;
+    }
+    r++;
+    start = w = r;
+    while (*r != '"') {
+        if ((unsigned char)*r < 0x20) {
+            /* the end of the text, or an unescaped control character */
+            return NULL;
+        }
+        if (*r != '\\') {
+            *w++ = *r++;
+            continue;
+        }
+        r++;
+        switch (*r) {
+            case '"':
+            case '\\':
+            case '/':
+                *w++ = *r;
+                break;
+            case 'b':
+                *w++ = '\b';
+                break;
+            case 'f':
+                *w++ = '\f';
+                break;
+            case 'n':
+                *w++ = '\n';
+                break;
+            case 'r':
+                *w++ = '\r';
+                break;
+            case 't':
+                *w++ = '\t';
+                break;
+            case 'u':
+                code = 0;
+                for (i = 0; i < 4; i++) {
+                    r++;
+                    if (!isxdigit((unsigned char)*r)) {
+                        return NULL;
+                    }
+                    digit = isdigit((unsigned char)*r)
+                        ? (*r - '0')
+                        : (tolower((unsigned char)*r) - 'a' + 10);
+                    code = (code << 4) | (unsigned long)digit;
+                }
+                /* six characters of escape hold the three octets */
+                if (code == 0) {
+                    return NULL;
+                } else if (code < 0x80) {
+                    *w++ = (char)code;
+                } else if (code < 0x800) {
+                    *w++ = (char)(0xC0 | (code >> 6));
+                    *w++ = (char)(0x80 | (code & 0x3F));
+                } else {
+                    *w++ = (char)(0xE0 | (code >> 12));
+                    *w++ = (char)(0x80 | ((code >> 6) & 0x3F));
+                    *w++ = (char)(0x80 | (code & 0x3F));
+                }
+                break;
+            default:
+                return NULL;
+        }
+        r++;
+    }
+    *w = 0;
+    *text = r + 1;
+
+    return start;
+}
+
+/**
+ * Copies a JSON number or keyword
+ *
+ * @param text - current position, advanced past the token
+ * @param token - filled with the token
+ * @param size - size of the token buffer
+ * @return true if a token was copied
+ */
+static bool provision_json_token(char **text, char *token, size_t size)
+{
+    char *p = *text;
+    size_t length = 0;
+
+    while (isalnum((unsigned char)*p) || (*p == '+') || (*p == '-') ||
+        (*p == '.')) {
+        if ((length + 1) >= size) {
+            return false;
+        }
+        token[length] = *p;
+        length++;
+        p++;
+    }
+    token[length] = 0;
+    *text = p;
+
+    return (length > 0);
+}
+
+/**
+ * Parses one JSON object of a point list, in place
+ *
+ * @param text - current position at the opening brace, advanced
+ * @param line - current line, advanced
+ * @param point - filled with the point
+ * @return true if the object was parsed
+ */
+static bool provision_json_object(
+    char **text, unsigned *line, PROVISION_POINT *point)
+{
+    char token[PROVISION_TOKEN_MAX];
+    char *p = *text;
+    char *key;
+    char *value;
+    bool retained;
+    bool status = false;
+
+    if (*p != '{') {
+        return false;
+    }
+    p++;
+    provision_json_space(&p, line);
+    if (*p == '}') {
+        *text = p + 1;
+        return true;
+    }
+    for (;;) {
+        key = provision_json_string(&p);
+        if (!key) {
+            break;
+        }
+        provision_json_space(&p, line);
+        if (*p != ':') {
+            break;
+        }
+        p++;
+        provision_json_space(&p, line);
+        if (*p == '"') {
+            value = provision_json_string(&p);
+            if (!value) {
+                break;
+            }
+            retained = true;
+        } else {
+            if (!provision_json_token(&p, token, sizeof(token))) {
+                break;
+            }
+            value = token;
+            if (strcmp(token, "null") == 0) {
+                token[0] = 0;
+            }
+            retained = false;
+        }
+        if (!provision_field_set(
+                point, provision_field_index(key), value, retained)) {
+            break;
+        }
+        provision_json_space(&p, line);
+        if (*p == ',') {
+            p++;
+            provision_json_space(&p, line);
+        } else {
+            if (*p == '}') {
+                p++;
+                status = true;
+            }
+            break;
+        }
+    }
+    *text = p;
+
+    return status;
+}
+
+/**
+ * Parses a JSON point list, in place
+ *
+ * @param list - list to add the points to
+ * @param text - the point list
+ * @param error_line - filled with the line of an error
+ * @return true if every point was parsed
+ */
+static bool provision_json(PROVISION_LIST *list, char *text, unsigned *error_line)
+{
+    PROVISION_POINT point;
+    char *p = text;
+    unsigned line = 1;
+    bool status = false;
+
+    provision_json_space(&p, &line);
+    if (*p == '[') {
+        p++;
+        provision_json_space(&p, &line);
+        if (*p == ']') {
+            p++;
+            status = true;
+        }
+        while (!status) {
+            memset(&point, 0, sizeof(point));
+            point.line = line;
+            if (!provision_json_object(&p, &line, &point) ||
+                !provision_point_add(list, &point)) {
+                break;
+            }
+            provision_json_space(&p, &line);
+            if (*p == ',') {
+                p++;
+                provision_json_space(&p, &line);
+            } else if (*p == ']') {
+                p++;
+                status = true;
+            } else {
+                break;
+            }
+        }
+    }
+    if (status) {
+        provision_json_space(&p, &line);
+        if (*p != 0) {
+            status = false;
+        }
+    }
+    if (!status) {
+        *error_line = line;
+    }
+
+    return status;
+}
+
+/**
+ * Orders points by object identifier
+ */
+static int provision_point_compare(const void *a, const void *b)
+{
+    const PROVISION_POINT *point_a = a;
+    const PROVISION_POINT *point_b = b;
+
+    if (point_a->object_type != point_b->object_type) {
+        return (point_a->object_type < point_b->object_type) ? -1 : 1;
+    }
+    if (point_a->object_instance != point_b->object_instance) {
+        return (point_a->object_instance < point_b->object_instance) ? -1
+                                                                     : 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Orders object names
+ */
+static int provision_name_compare(const void *a, const void *b)
+{
+    const PROVISION_NAME *name_a = a;
+    const PROVISION_NAME *name_b = b;
+
+    return strcmp(name_a->name, name_b->name);
+}
+
+/**
+ * Sorts the points, and checks each one can be provisioned
+ *
+ * @param list - list of points
+ * @param error_line - filled with the line of an error
+ * @return true if every point can be provisioned
+ */
+static bool provision_points_check(PROVISION_LIST *list, unsigned *error_line)
+{
+    const struct provision_functions *pFunctions;
+    const PROVISION_POINT *point;
+    const unsigned required = (1U << FIELD_TYPE) | (1U << FIELD_INSTANCE);
+    size_t i;
+
+    if (list->count > 1) {
+        qsort(list->point, list->count, sizeof(PROVISION_POINT),
+            provision_point_compare);
+    }
+    for (i = 0; i < list->count; i++) {
+        point = &list->point[i];
+        *error_line = point->line;
+        if ((point->fields & required) != required) {
+            return false;
+        }
+        if ((i > 0) && (provision_point_compare(point - 1, point) == 0)) {
+            /* the same object twice */
+            if (point[-1].line > point->line) {
+                *error_line = point[-1].line;
+            }
+            return false;
+        }
+        pFunctions = provision_functions_find(point->object_type);
+        if (!pFunctions) {
+            return false;
+        }
+        if (!pFunctions->Create &&
+            !pFunctions->Valid_Instance(point->object_instance)) {
+            return false;
+        }
+        if (((point->fields & (1U << FIELD_NAME)) && !pFunctions->Name_Set) ||
+            ((point->fields & (1U << FIELD_DESCRIPTION)) &&
+                !pFunctions->Description_Set) ||
+            ((point->fields & (1U << FIELD_UNITS)) && !pFunctions->Units_Set) ||
+            ((point->fields & (1U << FIELD_COV_INCREMENT)) &&
+                !pFunctions->COV_Increment_Set)) {
+            return false;
+        }
+    }
+    *error_line = 0;
+
+    return true;
+}
+
+/**
+ * Checks that the object names will be unique within the Device.
+ * The new names, and the names of the objects that are not renamed,
+ * are sorted once instead of searching every object for each name.
+ *
+ * @param list - sorted list of points
+ * @param error_line - filled with the line of an error
+ * @return true if the names are unique
+ */
+static bool provision_names_check(PROVISION_LIST *list, unsigned *error_line)
+{
+    BACNET_CHARACTER_STRING object_name;
+    PROVISION_POINT key;
+    const PROVISION_POINT *found;
+    PROVISION_NAME *names;
+    size_t i, count = 0;
+    unsigned object_count, object_index;
+    size_t length;
+    bool status = true;
+
+    object_count = Device_Object_List_Count();
+    names = malloc((list->count + object_count + 1) * sizeof(PROVISION_NAME));
+    if (!names) {
+        *error_line = 0;
+        return false;
+    }
+    for (i = 0; i < list->count; i++) {
+        if (list->point[i].fields & (1U << FIELD_NAME)) {
+            names[count].name = list->point[i].object_name;
+            names[count].point = &list->point[i];
+            count++;
+        }
+    }
+    memset(&key, 0, sizeof(key));
+    for (object_index = 1; object_index <= object_count; object_index++) {
+        if (!Device_Object_List_Identifier(
+                object_index, &key.object_type, &key.object_instance)) {
+            continue;
+        }
+        found = NULL;
+        if (list->count > 0) {
+            found = bsearch(&key, list->point, list->count,
+                sizeof(PROVISION_POINT), provision_point_compare);
+        }
+        if (found && (found->fields & (1U << FIELD_NAME))) {
+            /* renamed by the point list */
+            continue;
+        }
+        if (!Device_Object_Name_Copy(
+                key.object_type, key.object_instance, &object_name)) {
+            continue;
+        }
+        length = characterstring_length(&object_name);
+        names[count].name = malloc(length + 1);
+        if (!names[count].name) {
+            status = false;
+            break;
+        }
+        memcpy(names[count].name, characterstring_value(&object_name), length);
+        names[count].name[length] = 0;
+        names[count].point = NULL;
+        count++;
+    }
+    if (status && (count > 1)) {
+        qsort(names, count, sizeof(PROVISION_NAME), provision_name_compare);
+    }
+    *error_line = 0;
+    for (i = 1; status && (i < count); i++) {
+        if (strcmp(names[i - 1].name, names[i].name) != 0) {
+            continue;
+        }
+        /* a duplicate name that the point list gives */
+        if (names[i - 1].point) {
+            *error_line = names[i - 1].point->line;
+            status = false;
+        }
+        if (names[i].point && (names[i].point->line > *error_line)) {
+            *error_line = names[i].point->line;
+            status = false;
+        }
+    }
+    for (i = 0; i < count; i++) {
+        if (!names[i].point) {
+            free(names[i].name);
+        }
+    }
+    free(names);
+
+    return status;
+}
+
+/**
+ * Creates or updates the object of each point, in sorted order
+ *
+ * @param list - sorted and checked list of points
+ * @param error_line - filled with the line of an error
+ * @return true if every object was provisioned
+ */
+static bool provision_points_apply(PROVISION_LIST *list, unsigned *error_line)
+{
+    const struct provision_functions *pFunctions;
+    const PROVISION_POINT *point;
+    size_t i;
+    bool status = true;
+
+    Device_Provisioning_Begin();
+    for (i = 0; status && (i < list->count); i++) {
+        point = &list->point[i];
+        *error_line = point->line;
+        pFunctions = provision_functions_find(point->object_type);
+        if (!pFunctions->Valid_Instance(point->object_instance)) {
+            if (pFunctions->Create(point->object_instance) !=
+                point->object_instance) {
+                status = false;
+                break;
+            }
+            Device_Inc_Database_Revision();
+        }
+        if (point->fields & (1U << FIELD_NAME)) {
+            status =
+                pFunctions->Name_Set(point->object_instance, point->object_name);
+            Device_Inc_Database_Revision();
+        }
+        if (status && (point->fields & (1U << FIELD_DESCRIPTION))) {
+            status = pFunctions->Description_Set(
+                point->object_instance, point->description);
+        }
+        if (status && (point->fields & (1U << FIELD_UNITS))) {
+            status = pFunctions->Units_Set(point->object_instance, point->units);
+        }
+        if (status && (point->fields & (1U << FIELD_COV_INCREMENT))) {
+            pFunctions->COV_Increment_Set(
+                point->object_instance, point->cov_increment);
+        }
+    }
+    Device_Provisioning_End();
+    if (status) {
+        *error_line = 0;
+    }
+
+    return status;
+}
+
+/**
+ * Parses, checks and provisions a point list
+ *
+ * @param text - the point list, parsed in place
+ * @param error_line - filled with the line of an error, or 0
+ * @param applied - set true once objects may refer to the text
+ * @return number of points provisioned, or -1 on error
+ */
+static int provision_load(char *text, unsigned *error_line, bool *applied)
+{
+    PROVISION_LIST list = { NULL, 0, 0 };
+    const char *p = text;
+    unsigned line = 0;
+    bool status;
+    int count = -1;
+
+    while (isspace((unsigned char)*p)) {
+        p++;
+    }
+    if (*p == '[') {
+        status = provision_json(&list, text, &line);
+    } else {
+        status = provision_csv(&list, text, &line);
+    }
+    if (status) {
+        status = provision_points_check(&list, &line);
+    }
+    if (status) {
+        status = provision_names_check(&list, &line);
+    }
+    if (status) {
+        *applied = true;
+        status = provision_points_apply(&list, &line);
+    }
+    if (status) {
+        count = (int)list.count;
+    }
+    free(list.point);
+    if (error_line) {
+        *error_line = line;
+    }
+
+    return count;
+}
+
+/**
+ * Creates or updates the objects of a CSV or JSON point list.
+ * Every point is checked before any object is changed, so a point list
+ * with an error changes nothing, except when an object can not be
+ * created for lack of memory.
+ *
+ * @param text - the point list, which is parsed in place and must stay
+ *  valid while the objects exist, since they keep pointers to the
+ *  object names and descriptions
+ * @param error_line - filled with the line of the first error, or 0
+ * @return number of points provisioned, or -1 on error
+ */
+int Provision_Load(char *text, unsigned *error_line)
+{
+    bool applied = false;
+
+    if (!text) {
+        if (error_line) {
+            *error_line = 0;
+        }
+        return -1;
+    }
+
+    return provision_load(text, error_line, &applied);
+}
+
+/**
+ * Creates or updates the objects of a CSV or JSON point list file.
+ * The text of the file is kept for the object names and descriptions.
+ *
+ * @param pathname - name of the point list file
+ * @param error_line - filled with the line of the first error, or 0
+ * @return number of points provisioned, or -1 on error
+ */
+int Provision_Load_File(const char *pathname, unsigned *error_line)
+{
+    FILE *file;
+    char *text = NULL;
+    long size = -1;
+    bool applied = false;
+    int count = -1;
+
+    if (error_line) {
+        *error_line = 0;
+    }
+    file = fopen(pathname, "rb");
+    if (!file) {
+        return -1;
+    }
+    if (fseek(file, 0L, SEEK_END) == 0) {
+        size = ftell(file);
+        rewind(file);
+    }
+    if (size >= 0) {
+        text = malloc((size_t)size + 1);
+    }
+    if (text && (fread(text, 1, (size_t)size, file) == (size_t)size)) {
+        text[size] = 0;
+        count = provision_load(text, error_line, &applied);
+    }
+    fclose(file);
+    if (!applied) {
+        free(text);
+    }
+
+    return count;
+}
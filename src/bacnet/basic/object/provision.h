@@ -0,0 +1,50 @@
+/**
+ * @file
+ * @brief Bulk provisioning of objects from a CSV or JSON point list
+ *
+ * A point list gives the type, instance, name, units, description and
+ * COV increment of each object.  The list is sorted and checked once,
+ * then every object is created or updated in a single pass with one
+ * change of the Device database revision.
+ *
+ * CSV: one point per line, in the column order
+ *   type,instance,name,units,description,cov_increment
+ * or in the order given by a header line that starts with "type".
+ * Fields may be quoted, empty fields are not set, and lines that start
+ * with '#' are comments.
+ *
+ * JSON: an array of objects using the same names as keys, e.g.
+ *   [{"type":"analog-output","instance":1,"name":"AHU-1 Damper",
+ *     "units":"percent","cov_increment":0.5}]
+ *
+ * Types and units are given by name or by number.
+ *
+ * @section LICENSE
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef PROVISION_H
+#define PROVISION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "bacnet/bacnet_stack_exports.h"
+#include "bacnet/bacdef.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    BACNET_STACK_EXPORT
+    int Provision_Load(
+        char *text,
+        unsigned *error_line);
+    BACNET_STACK_EXPORT
+    int Provision_Load_File(
+        const char *pathname,
+        unsigned *error_line);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif
@@ -40,6 +40,7 @@
 #include "bacnet/basic/binding/address.h"
 #include "bacnet/bacdevobjpropref.h"
 #include "bacnet/basic/object/trendlog.h"
+#include "bacnet/basic/object/trendlog_block.h"
 #include "bacnet/datetime.h"
 #if defined(BACFILE)
 #include "bacnet/basic/object/bacfile.h" /* object list dependency */
@@ -50,9 +51,51 @@
 #define MAX_TREND_LOGS 8
 #endif
 
-static TL_DATA_REC Logs[MAX_TREND_LOGS][TL_MAX_ENTRIES];
+/* default seconds between COV subscriptions to a remote source */
+#ifndef TL_COV_RESUBSCRIPTION_INTERVAL
+#define TL_COV_RESUBSCRIPTION_INTERVAL 3600
+#endif
+/* seconds to wait before retrying a COV subscription that was not sent */
+#ifndef TL_COV_RETRY_INTERVAL
+#define TL_COV_RETRY_INTERVAL 10
+#endif
+
+/* Index entry for seeking to a block */
+typedef struct tl_block_info {
+    bacnet_time_t tFirst; /* Time stamp of the first record in the block */
+    uint16_t usCount; /* Records in the block */
+} TL_BLOCK_INFO;
+
+/* Block ring and read cursor of a log */
+typedef struct tl_log_store {
+    unsigned uFirstBlock; /* Oldest block in the ring */
+    unsigned uBlocks; /* Blocks in use */
+    TL_BLOCK_STATE Writer; /* Encoder state of the newest block */
+    uint32_t ulCursorEntry; /* Entry decoded last, 1 based, 0 for none */
+    uint32_t ulCursorBase; /* Entries before the cursor block */
+    unsigned uCursorBlock; /* Cursor block, counted from the oldest */
+    uint16_t usCursorRecs; /* Records decoded from the cursor block */
+    TL_BLOCK_STATE Reader; /* Decoder state of the cursor block */
+    TL_DATA_REC CursorRec; /* Entry decoded last */
+} TL_LOG_STORE;
+
+static uint8_t Log_Blocks[MAX_TREND_LOGS][TL_MAX_BLOCKS][TL_BLOCK_SIZE];
+static TL_BLOCK_INFO Log_Index[MAX_TREND_LOGS][TL_MAX_BLOCKS];
+static TL_LOG_STORE Log_Store[MAX_TREND_LOGS];
 static TL_LOG_INFO LogInfo[MAX_TREND_LOGS];
 
+static void TL_Clear_Log(int iLog);
+static bool TL_Is_Full(int iLog);
+static void TL_Insert_Data_Rec(int iLog, TL_DATA_REC *TempRec);
+
+static void TL_COV_Notification(BACNET_COV_DATA *cov_data);
+static void TL_COV_Unsubscribe(int iLog);
+/* COV notifications from local objects and from remote devices */
+static BACNET_COV_NOTIFICATION TL_Local_COV_Notification = { NULL,
+    TL_COV_Notification };
+static BACNET_COV_NOTIFICATION TL_Remote_COV_Notification = { NULL,
+    TL_COV_Notification };
+
 /* These three arrays are used by the ReadPropertyMultiple handler */
 static const int Trend_Log_Properties_Required[] = { PROP_OBJECT_IDENTIFIER,
     PROP_OBJECT_NAME, PROP_OBJECT_TYPE, PROP_ENABLE, PROP_STOP_WHEN_FULL,
@@ -64,9 +107,8 @@ static const int Trend_Log_Properties_Optional[] = { PROP_DESCRIPTION,
     PROP_START_TIME, PROP_STOP_TIME, PROP_LOG_DEVICE_OBJECT_PROPERTY,
     PROP_LOG_INTERVAL,
 
-    /* Required if COV logging supported
-        PROP_COV_RESUBSCRIPTION_INTERVAL,
-        PROP_CLIENT_COV_INCREMENT, */
+    /* Required if COV logging supported */
+    PROP_COV_RESUBSCRIPTION_INTERVAL, PROP_CLIENT_COV_INCREMENT,
 
     /* Required if intrinsic reporting supported
         PROP_NOTIFICATION_THRESHOLD,
@@ -151,6 +193,31 @@ static bacnet_time_t Trend_Log_Epoch_Seconds_Now(void)
     return datetime_seconds_since_epoch(&bdatetime);
 }
 
+/*
+ * Sources in other devices are logged by COV subscription only
+ */
+static bool TL_Source_Is_Remote(
+    BACNET_DEVICE_OBJECT_PROPERTY_REFERENCE *Source)
+{
+    return ((Source->deviceIdentifier.type == OBJECT_DEVICE) &&
+        (Source->deviceIdentifier.instance != Device_Object_Instance_Number()));
+}
+
+/*
+ * Local sources are logged by COV only when the COV change path of the
+ * object reports the logged property - Present_Value or Status_Flags.
+ * The COV_Increment of the object applies; Client_COV_Increment does
+ * not, since the object notifies no more often than its own increment.
+ */
+static bool TL_Source_Has_Local_COV(
+    BACNET_DEVICE_OBJECT_PROPERTY_REFERENCE *Source)
+{
+    return ((!TL_Source_Is_Remote(Source)) &&
+        ((Source->propertyIdentifier == PROP_PRESENT_VALUE) ||
+            (Source->propertyIdentifier == PROP_STATUS_FLAGS)) &&
+        (Source->arrayIndex == BACNET_ARRAY_ALL));
+}
+
 /*
  * Things to do when starting up the stack for Trend Logs.
  * Should be called whenever we reset the device or power it up
@@ -160,12 +227,15 @@ void Trend_Log_Init(void)
     static bool initialized = false;
     int iLog;
     int iEntry;
+    TL_DATA_REC TempRec = { 0 };
     BACNET_DATE_TIME bdatetime = { 0 };
     bacnet_time_t tClock;
     uint8_t month;
 
     if (!initialized) {
         initialized = true;
+        handler_cov_local_notification_add(&TL_Local_COV_Notification);
+        handler_ucov_notification_add(&TL_Remote_COV_Notification);
 
         /* initialize all the values */
 
@@ -189,17 +259,19 @@ void Trend_Log_Init(void)
             month = iLog + 1;
             datetime_set_values(&bdatetime, 2009, month, 1, 0, 0, 0, 0);
             tClock = datetime_seconds_since_epoch(&bdatetime);
-            for (iEntry = 0; iEntry < TL_MAX_ENTRIES; iEntry++) {
-                Logs[iLog][iEntry].tTimeStamp = tClock;
-                Logs[iLog][iEntry].ucRecType = TL_TYPE_REAL;
-                Logs[iLog][iEntry].Datum.fReal =
-                    (float)(iEntry + (iLog * TL_MAX_ENTRIES));
+            TL_Clear_Log(iLog);
+            LogInfo[iLog].ulTotalRecordCount = 0;
+            for (iEntry = 0; iEntry < (int)TL_MAX_ENTRIES; iEntry++) {
+                TempRec.tTimeStamp = tClock;
+                TempRec.ucRecType = TL_TYPE_REAL;
+                TempRec.Datum.fReal = (float)(iEntry + (iLog * TL_MAX_ENTRIES));
                 /* Put status flags with every second log */
                 if ((iLog & 1) == 0) {
-                    Logs[iLog][iEntry].ucStatus = 128;
+                    TempRec.ucStatus = 128;
                 } else {
-                    Logs[iLog][iEntry].ucStatus = 0;
+                    TempRec.ucStatus = 0;
                 }
+                TL_Insert_Data_Rec(iLog, &TempRec);
                 /* advance 15 minutes, in seconds */
                 tClock += 900;
             }
@@ -213,10 +285,13 @@ void Trend_Log_Init(void)
             LogInfo[iLog].Source.arrayIndex = 0;
             LogInfo[iLog].ucTimeFlags = 0;
             LogInfo[iLog].ulIntervalOffset = 0;
-            LogInfo[iLog].iIndex = 0;
             LogInfo[iLog].ulLogInterval = 900;
-            LogInfo[iLog].ulRecordCount = TL_MAX_ENTRIES;
-            LogInfo[iLog].ulTotalRecordCount = 10000;
+            LogInfo[iLog].ulCovResubscriptionInterval =
+                TL_COV_RESUBSCRIPTION_INTERVAL;
+            LogInfo[iLog].bClientCovIncrement = false;
+            LogInfo[iLog].fClientCovIncrement = 0.0f;
+            LogInfo[iLog].bCovSubscribed = false;
+            LogInfo[iLog].ulCovResubscribeTimer = 0;
 
             LogInfo[iLog].Source.deviceIdentifier.instance =
                 Device_Object_Instance_Number();
@@ -405,6 +480,25 @@ int Trend_Log_Read_Property(BACNET_READ_PROPERTY_DATA *rpdata)
                 encode_application_boolean(&apdu[0], CurrentLog->bTrigger);
             break;
 
+        case PROP_COV_RESUBSCRIPTION_INTERVAL:
+            apdu_len = encode_application_unsigned(
+                &apdu[0], CurrentLog->ulCovResubscriptionInterval);
+            break;
+
+        case PROP_CLIENT_COV_INCREMENT:
+            /* BACnetClientCOV ::= CHOICE {
+             *     real-increment    REAL,
+             *     default-increment NULL
+             * }
+             */
+            if (CurrentLog->bClientCovIncrement) {
+                apdu_len = encode_application_real(
+                    &apdu[0], CurrentLog->fClientCovIncrement);
+            } else {
+                apdu_len = encode_application_null(&apdu[0]);
+            }
+            break;
+
         default:
             rpdata->error_class = ERROR_CLASS_PROPERTY;
             rpdata->error_code = ERROR_CODE_UNKNOWN_PROPERTY;
@@ -465,7 +559,7 @@ bool Trend_Log_Write_Property(BACNET_WRITE_PROPERTY_DATA *wp_data)
                  * set */
                 if ((CurrentLog->bEnable == false) &&
                     (CurrentLog->bStopWhenFull == true) &&
-                    (CurrentLog->ulRecordCount == TL_MAX_ENTRIES) &&
+                    TL_Is_Full(log_index) &&
                     (value.type.Boolean == true)) {
                     status = false;
                     wp_data->error_class = ERROR_CLASS_OBJECT;
@@ -508,7 +602,7 @@ bool Trend_Log_Write_Property(BACNET_WRITE_PROPERTY_DATA *wp_data)
                     CurrentLog->bStopWhenFull = value.type.Boolean;
 
                     if ((value.type.Boolean == true) &&
-                        (CurrentLog->ulRecordCount == TL_MAX_ENTRIES) &&
+                        TL_Is_Full(log_index) &&
                         (CurrentLog->bEnable == true)) {
                         /* When full log is switched from normal to stop when
                          * full disable the log and record the fact - see
@@ -537,8 +631,7 @@ bool Trend_Log_Write_Property(BACNET_WRITE_PROPERTY_DATA *wp_data)
             if (status) {
                 if (value.type.Unsigned_Int == 0) {
                     /* Time to clear down the log */
-                    CurrentLog->ulRecordCount = 0;
-                    CurrentLog->iIndex = 0;
+                    TL_Clear_Log(log_index);
                     TL_Insert_Status_Rec(
                         log_index, LOG_STATUS_BUFFER_PURGED, true);
                 }
@@ -552,7 +645,22 @@ bool Trend_Log_Write_Property(BACNET_WRITE_PROPERTY_DATA *wp_data)
             status = write_property_type_valid(
                 wp_data, &value, BACNET_APPLICATION_TAG_ENUMERATED);
             if (status) {
-                if (value.type.Enumerated != LOGGING_TYPE_COV) {
+                if ((value.type.Enumerated != LOGGING_TYPE_COV) &&
+                    TL_Source_Is_Remote(&CurrentLog->Source)) {
+                    /* We only log remote sources by COV */
+                    status = false;
+                    wp_data->error_class = ERROR_CLASS_PROPERTY;
+                    wp_data->error_code =
+                        ERROR_CODE_OPTIONAL_FUNCTIONALITY_NOT_SUPPORTED;
+                } else if ((value.type.Enumerated == LOGGING_TYPE_COV) &&
+                    (!TL_Source_Is_Remote(&CurrentLog->Source)) &&
+                    (!TL_Source_Has_Local_COV(&CurrentLog->Source))) {
+                    /* the local COV path does not report this property */
+                    status = false;
+                    wp_data->error_class = ERROR_CLASS_PROPERTY;
+                    wp_data->error_code =
+                        ERROR_CODE_OPTIONAL_FUNCTIONALITY_NOT_SUPPORTED;
+                } else if (value.type.Enumerated != LOGGING_TYPE_COV) {
                     CurrentLog->LoggingType =
                         (BACNET_LOGGING_TYPE)value.type.Enumerated;
                     if (value.type.Enumerated == LOGGING_TYPE_POLLED) {
@@ -568,11 +676,10 @@ bool Trend_Log_Write_Property(BACNET_WRITE_PROPERTY_DATA *wp_data)
                         CurrentLog->ulLogInterval = 0;
                     }
                 } else {
-                    /* We don't currently support COV */
-                    status = false;
-                    wp_data->error_class = ERROR_CLASS_PROPERTY;
-                    wp_data->error_code =
-                        ERROR_CODE_OPTIONAL_FUNCTIONALITY_NOT_SUPPORTED;
+                    /* As per 12.25.27 the interval is 0 for COV logging.
+                     * The subscription is made by the trend log timer. */
+                    CurrentLog->LoggingType = LOGGING_TYPE_COV;
+                    CurrentLog->ulLogInterval = 0;
                 }
             }
             break;
@@ -691,10 +798,9 @@ bool Trend_Log_Write_Property(BACNET_WRITE_PROPERTY_DATA *wp_data)
                 break;
             }
 
-            /* We only support references to objects in ourself for now */
-            if ((TempSource.deviceIdentifier.type == OBJECT_DEVICE) &&
-                (TempSource.deviceIdentifier.instance !=
-                    Device_Object_Instance_Number())) {
+            /* We only log remote sources by COV */
+            if (TL_Source_Is_Remote(&TempSource) &&
+                (CurrentLog->LoggingType != LOGGING_TYPE_COV)) {
                 wp_data->error_class = ERROR_CLASS_PROPERTY;
                 wp_data->error_code =
                     ERROR_CODE_OPTIONAL_FUNCTIONALITY_NOT_SUPPORTED;
@@ -705,9 +811,10 @@ bool Trend_Log_Write_Property(BACNET_WRITE_PROPERTY_DATA *wp_data)
             if (memcmp(&TempSource, &CurrentLog->Source,
                     sizeof(BACNET_DEVICE_OBJECT_PROPERTY_REFERENCE)) != 0) {
                 /* Clear buffer if property being logged is changed */
-                CurrentLog->ulRecordCount = 0;
-                CurrentLog->iIndex = 0;
+                TL_Clear_Log(log_index);
                 TL_Insert_Status_Rec(log_index, LOG_STATUS_BUFFER_PURGED, true);
+                /* Drop any COV subscription to the old source */
+                TL_COV_Unsubscribe(log_index);
             }
             CurrentLog->Source = TempSource;
             status = true;
@@ -723,16 +830,33 @@ bool Trend_Log_Write_Property(BACNET_WRITE_PROPERTY_DATA *wp_data)
             status = write_property_type_valid(
                 wp_data, &value, BACNET_APPLICATION_TAG_UNSIGNED_INT);
             if (status) {
-                if ((CurrentLog->LoggingType == LOGGING_TYPE_POLLED) &&
-                    (value.type.Unsigned_Int == 0)) {
-                    /* We don't support COV at the moment so don't allow
-                     * switching to it by clearing interval whilst in polling
-                     * mode */
+                if ((value.type.Unsigned_Int == 0) &&
+                    (CurrentLog->LoggingType == LOGGING_TYPE_POLLED) &&
+                    (!TL_Source_Has_Local_COV(&CurrentLog->Source))) {
+                    /* the local COV path does not report this property */
+                    wp_data->error_class = ERROR_CLASS_PROPERTY;
+                    wp_data->error_code =
+                        ERROR_CODE_OPTIONAL_FUNCTIONALITY_NOT_SUPPORTED;
+                    status = false;
+                } else if (value.type.Unsigned_Int == 0) {
+                    /* As per 12.25.27 clearing the interval whilst in
+                     * polling mode switches to COV logging */
+                    if (CurrentLog->LoggingType == LOGGING_TYPE_POLLED) {
+                        CurrentLog->LoggingType = LOGGING_TYPE_COV;
+                    }
+                    CurrentLog->ulLogInterval = 0;
+                } else if ((CurrentLog->LoggingType == LOGGING_TYPE_COV) &&
+                    TL_Source_Is_Remote(&CurrentLog->Source)) {
+                    /* We only log remote sources by COV */
                     wp_data->error_class = ERROR_CLASS_PROPERTY;
                     wp_data->error_code =
                         ERROR_CODE_OPTIONAL_FUNCTIONALITY_NOT_SUPPORTED;
                     status = false;
                 } else {
+                    /* and setting it whilst in COV mode switches to polling */
+                    if (CurrentLog->LoggingType == LOGGING_TYPE_COV) {
+                        CurrentLog->LoggingType = LOGGING_TYPE_POLLED;
+                    }
                     /* We only log to 1 sec accuracy so must divide by 100
                      * before passing it on */
                     CurrentLog->ulLogInterval = value.type.Unsigned_Int / 100;
@@ -783,6 +907,39 @@ bool Trend_Log_Write_Property(BACNET_WRITE_PROPERTY_DATA *wp_data)
             }
             break;
 
+        case PROP_COV_RESUBSCRIPTION_INTERVAL:
+            status = write_property_type_valid(
+                wp_data, &value, BACNET_APPLICATION_TAG_UNSIGNED_INT);
+            if (status) {
+                CurrentLog->ulCovResubscriptionInterval =
+                    value.type.Unsigned_Int;
+                /* resubscribe now with the new lifetime */
+                CurrentLog->ulCovResubscribeTimer = 0;
+            }
+            break;
+
+        case PROP_CLIENT_COV_INCREMENT:
+            if (value.tag == BACNET_APPLICATION_TAG_NULL) {
+                CurrentLog->bClientCovIncrement = false;
+                status = true;
+            } else if (value.tag == BACNET_APPLICATION_TAG_REAL) {
+                if (value.type.Real < 0.0f) {
+                    wp_data->error_class = ERROR_CLASS_PROPERTY;
+                    wp_data->error_code = ERROR_CODE_VALUE_OUT_OF_RANGE;
+                    break;
+                }
+                CurrentLog->bClientCovIncrement = true;
+                CurrentLog->fClientCovIncrement = value.type.Real;
+                status = true;
+            } else {
+                wp_data->error_class = ERROR_CLASS_PROPERTY;
+                wp_data->error_code = ERROR_CODE_INVALID_DATA_TYPE;
+                break;
+            }
+            /* resubscribe now with the new increment */
+            CurrentLog->ulCovResubscribeTimer = 0;
+            break;
+
         default:
             wp_data->error_class = ERROR_CLASS_PROPERTY;
             wp_data->error_code = ERROR_CODE_WRITE_ACCESS_DENIED;
@@ -814,6 +971,196 @@ bool TrendLogGetRRInfo(
     return (false);
 }
 
+/*****************************************************************************
+ * Empty the log storage.                                                    *
+ *****************************************************************************/
+
+static void TL_Clear_Log(int iLog)
+{
+    Log_Store[iLog].uFirstBlock = 0;
+    Log_Store[iLog].uBlocks = 0;
+    Log_Store[iLog].ulCursorEntry = 0;
+    LogInfo[iLog].ulRecordCount = 0;
+}
+
+/*****************************************************************************
+ * The log is full when the next record may not fit without dropping the     *
+ * oldest block: a block holds up to TL_BLOCK_RECORDS records.               *
+ *****************************************************************************/
+
+static bool TL_Is_Full(int iLog)
+{
+    TL_LOG_STORE *Store;
+    unsigned uBlock;
+
+    Store = &Log_Store[iLog];
+    if (Store->uBlocks < TL_MAX_BLOCKS) {
+        return false;
+    }
+    uBlock = (Store->uFirstBlock + Store->uBlocks - 1) % TL_MAX_BLOCKS;
+
+    return ((Log_Index[iLog][uBlock].usCount >= TL_BLOCK_RECORDS) ||
+        ((Store->Writer.usBit + (TL_BLOCK_RECORD_MAX * 8)) >
+            (TL_BLOCK_SIZE * 8)));
+}
+
+/*****************************************************************************
+ * Discard the oldest block of records to make room for new ones.            *
+ *****************************************************************************/
+
+static void TL_Drop_Block(int iLog)
+{
+    TL_LOG_STORE *Store;
+
+    Store = &Log_Store[iLog];
+    if (Store->uBlocks > 0) {
+        LogInfo[iLog].ulRecordCount -=
+            Log_Index[iLog][Store->uFirstBlock].usCount;
+        Store->uFirstBlock = (Store->uFirstBlock + 1) % TL_MAX_BLOCKS;
+        Store->uBlocks--;
+        /* positions have moved */
+        Store->ulCursorEntry = 0;
+    }
+}
+
+/*****************************************************************************
+ * Append a record to the log, dropping the oldest block when it is full.    *
+ *****************************************************************************/
+
+static void TL_Insert_Data_Rec(int iLog, TL_DATA_REC *TempRec)
+{
+    TL_LOG_INFO *CurrentLog;
+    TL_LOG_STORE *Store;
+    unsigned uBlock = 0;
+
+    CurrentLog = &LogInfo[iLog];
+    Store = &Log_Store[iLog];
+    if (Store->uBlocks > 0) {
+        uBlock = (Store->uFirstBlock + Store->uBlocks - 1) % TL_MAX_BLOCKS;
+    }
+    if ((Store->uBlocks == 0) ||
+        (Log_Index[iLog][uBlock].usCount >= TL_BLOCK_RECORDS) ||
+        !TL_Block_Encode(Log_Blocks[iLog][uBlock], TL_BLOCK_SIZE,
+            &Store->Writer, TempRec)) {
+        /* Start a new block, making room for it if necessary */
+        if (Store->uBlocks == TL_MAX_BLOCKS) {
+            TL_Drop_Block(iLog);
+        }
+        uBlock = (Store->uFirstBlock + Store->uBlocks) % TL_MAX_BLOCKS;
+        TL_Block_Start(&Store->Writer, TempRec->tTimeStamp);
+        if (!TL_Block_Encode(Log_Blocks[iLog][uBlock], TL_BLOCK_SIZE,
+                &Store->Writer, TempRec)) {
+            /* Not a record we can store */
+            return;
+        }
+        Log_Index[iLog][uBlock].tFirst = TempRec->tTimeStamp;
+        Log_Index[iLog][uBlock].usCount = 0;
+        Store->uBlocks++;
+    }
+    Log_Index[iLog][uBlock].usCount++;
+
+    CurrentLog->ulTotalRecordCount++;
+    CurrentLog->ulRecordCount++;
+}
+
+/*****************************************************************************
+ * Fetch a record by its 1 based position in the log. Consecutive positions *
+ * are decoded sequentially from a cursor; other positions seek to their    *
+ * block with the block index and decode from the start of that block.      *
+ *****************************************************************************/
+
+static bool TL_Get_Rec(int iLog, uint32_t ulEntry, TL_DATA_REC *TempRec)
+{
+    TL_LOG_STORE *Store;
+    TL_BLOCK_INFO *Info;
+    unsigned uBlock;
+
+    Store = &Log_Store[iLog];
+    if ((ulEntry == 0) || (ulEntry > LogInfo[iLog].ulRecordCount)) {
+        return false;
+    }
+    if (ulEntry != Store->ulCursorEntry) {
+        if ((Store->ulCursorEntry == 0) || (ulEntry < Store->ulCursorEntry)) {
+            /* Rewind to the oldest block */
+            Store->uCursorBlock = 0;
+            Store->ulCursorBase = 0;
+            Store->usCursorRecs = 0;
+            Store->ulCursorEntry = 0;
+            uBlock = Store->uFirstBlock;
+            TL_Block_Start(&Store->Reader, Log_Index[iLog][uBlock].tFirst);
+        }
+        /* Skip whole blocks without decoding them */
+        uBlock = (Store->uFirstBlock + Store->uCursorBlock) % TL_MAX_BLOCKS;
+        Info = &Log_Index[iLog][uBlock];
+        while (ulEntry > (Store->ulCursorBase + Info->usCount)) {
+            Store->ulCursorBase += Info->usCount;
+            Store->uCursorBlock++;
+            Store->usCursorRecs = 0;
+            uBlock = (uBlock + 1) % TL_MAX_BLOCKS;
+            Info = &Log_Index[iLog][uBlock];
+            TL_Block_Start(&Store->Reader, Info->tFirst);
+        }
+        /* and decode up to the entry */
+        while ((Store->ulCursorBase + Store->usCursorRecs) < ulEntry) {
+            if (!TL_Block_Decode(Log_Blocks[iLog][uBlock], TL_BLOCK_SIZE,
+                    &Store->Reader, &Store->CursorRec)) {
+                Store->ulCursorEntry = 0;
+                return false;
+            }
+            Store->usCursorRecs++;
+        }
+        Store->ulCursorEntry = ulEntry;
+    }
+    *TempRec = Store->CursorRec;
+
+    return true;
+}
+
+/*****************************************************************************
+ * Find the position of the last record before a time, or of the first      *
+ * record after a time, using the block index to skip to the right block.   *
+ * Records are assumed to be in time order. Returns 0 if there is none.     *
+ *****************************************************************************/
+
+static uint32_t TL_Find_Time(int iLog, bacnet_time_t tRefTime, bool bAfter)
+{
+    TL_LOG_STORE *Store;
+    TL_BLOCK_INFO *Info;
+    TL_DATA_REC TempRec;
+    uint32_t ulEntry = 1;
+    uint32_t ulFound = 0;
+    unsigned uCount;
+
+    Store = &Log_Store[iLog];
+    /* Skip blocks that end before the reference time - the next block
+       starts before or at it */
+    for (uCount = 0; (uCount + 1) < Store->uBlocks; uCount++) {
+        Info =
+            &Log_Index[iLog][(Store->uFirstBlock + uCount + 1) % TL_MAX_BLOCKS];
+        if (bAfter ? (Info->tFirst > tRefTime) : (Info->tFirst >= tRefTime)) {
+            break;
+        }
+        ulEntry += Log_Index[iLog][(Store->uFirstBlock + uCount) %
+            TL_MAX_BLOCKS].usCount;
+    }
+    for (; ulEntry <= LogInfo[iLog].ulRecordCount; ulEntry++) {
+        if (!TL_Get_Rec(iLog, ulEntry, &TempRec)) {
+            break;
+        }
+        if (bAfter) {
+            if (TempRec.tTimeStamp > tRefTime) {
+                return ulEntry;
+            }
+        } else if (TempRec.tTimeStamp < tRefTime) {
+            ulFound = ulEntry;
+        } else {
+            break;
+        }
+    }
+
+    return ulFound;
+}
+
 /*****************************************************************************
  * Insert a status record into a trend log - does not check for enable/log   *
  * full, time slots and so on as these type of entries have to go in         *
@@ -823,11 +1170,8 @@ bool TrendLogGetRRInfo(
 
 void TL_Insert_Status_Rec(int iLog, BACNET_LOG_STATUS eStatus, bool bState)
 {
-    TL_LOG_INFO *CurrentLog;
     TL_DATA_REC TempRec;
 
-    CurrentLog = &LogInfo[iLog];
-
     TempRec.tTimeStamp = Trend_Log_Epoch_Seconds_Now();
     TempRec.ucRecType = TL_TYPE_STATUS;
     TempRec.ucStatus = 0;
@@ -852,16 +1196,7 @@ void TL_Insert_Status_Rec(int iLog, BACNET_LOG_STATUS eStatus, bool bState)
             break;
     }
 
-    Logs[iLog][CurrentLog->iIndex++] = TempRec;
-    if (CurrentLog->iIndex >= TL_MAX_ENTRIES) {
-        CurrentLog->iIndex = 0;
-    }
-
-    CurrentLog->ulTotalRecordCount++;
-
-    if (CurrentLog->ulRecordCount < TL_MAX_ENTRIES) {
-        CurrentLog->ulRecordCount++;
-    }
+    TL_Insert_Data_Rec(iLog, &TempRec);
 }
 
 /*****************************************************************************
@@ -1280,33 +1615,19 @@ int TL_encode_by_time(uint8_t *apdu, BACNET_READ_RANGE_DATA *pRequest)
     CurrentLog = &LogInfo[log_index];
 
     tRefTime = TL_BAC_Time_To_Local(&pRequest->Range.RefTime);
-    /* Find correct position for oldest entry in log */
-    if (CurrentLog->ulRecordCount < TL_MAX_ENTRIES) {
-        uiIndex = 0;
-    } else {
-        uiIndex = CurrentLog->iIndex;
-    }
 
     if (pRequest->Count < 0) {
-        /* Start at end of log and look for record which has
-         * timestamp greater than or equal to the reference.
+        /* Look for the last record which has a timestamp before
+         * the reference.
          */
-        iCount = CurrentLog->ulRecordCount - 1;
-        /* Start out with the sequence number for the last record */
-        uiFirstSeq = CurrentLog->ulTotalRecordCount;
-        for (;;) {
-            if (Logs[pRequest->object_instance]
-                    [(uiIndex + iCount) % TL_MAX_ENTRIES]
-                        .tTimeStamp < tRefTime) {
-                break;
-            }
-
-            uiFirstSeq--;
-            iCount--;
-            if (iCount < 0) {
-                return (0);
-            }
+        uiIndex = TL_Find_Time(log_index, tRefTime, false);
+        if (uiIndex == 0) {
+            return (0);
         }
+        iCount = uiIndex - 1;
+        /* and the sequence number for that record */
+        uiFirstSeq = CurrentLog->ulTotalRecordCount -
+            (CurrentLog->ulRecordCount - uiIndex);
 
         /* We have an and point for our request,
          * now work backwards to find where we should start from
@@ -1328,27 +1649,18 @@ int TL_encode_by_time(uint8_t *apdu, BACNET_READ_RANGE_DATA *pRequest)
             iCount -= iTemp;
         }
     } else {
-        /* Start at beginning of log and look for 1st record which has
-         * timestamp greater than the reference time.
+        /* Look for the 1st record which has a timestamp greater than
+         * the reference time.
          */
-        iCount = 0;
-        /* Figure out the sequence number for the first record, last is
-         * ulTotalRecordCount */
-        uiFirstSeq =
-            CurrentLog->ulTotalRecordCount - (CurrentLog->ulRecordCount - 1);
-        for (;;) {
-            if (Logs[pRequest->object_instance]
-                    [(uiIndex + iCount) % TL_MAX_ENTRIES]
-                        .tTimeStamp > tRefTime) {
-                break;
-            }
-
-            uiFirstSeq++;
-            iCount++;
-            if ((uint32_t)iCount == CurrentLog->ulRecordCount) {
-                return (0);
-            }
+        uiIndex = TL_Find_Time(log_index, tRefTime, true);
+        if (uiIndex == 0) {
+            return (0);
         }
+        iCount = uiIndex - 1;
+        /* Figure out the sequence number for that record, last is
+         * ulTotalRecordCount */
+        uiFirstSeq = CurrentLog->ulTotalRecordCount -
+            (CurrentLog->ulRecordCount - uiIndex);
     }
 
     /* We now have a starting point for the operation and a +ve count */
@@ -1400,19 +1712,15 @@ int TL_encode_by_time(uint8_t *apdu, BACNET_READ_RANGE_DATA *pRequest)
 int TL_encode_entry(uint8_t *apdu, int iLog, int iEntry)
 {
     int iLen = 0;
-    TL_DATA_REC *pSource = NULL;
+    TL_DATA_REC TempRec;
+    TL_DATA_REC *pSource = &TempRec;
     BACNET_BIT_STRING TempBits;
     uint8_t ucCount = 0;
     BACNET_DATE_TIME TempTime;
 
-    /* Convert from BACnet 1 based to 0 based array index and then
-     * handle wrap around of the circular buffer */
-
-    if (LogInfo[iLog].ulRecordCount < TL_MAX_ENTRIES) {
-        pSource = &Logs[iLog][(iEntry - 1) % TL_MAX_ENTRIES];
-    } else {
-        pSource =
-            &Logs[iLog][(LogInfo[iLog].iIndex + iEntry - 1) % TL_MAX_ENTRIES];
+    /* Decode the entry from the compressed log */
+    if (!TL_Get_Rec(iLog, (uint32_t)iEntry, &TempRec)) {
+        return 0;
     }
 
     iLen = 0;
@@ -1557,6 +1865,33 @@ static int local_read_property(uint8_t *value,
     return (len);
 }
 
+/****************************************************************************
+ * Store a bitstring in a log record, truncated at 32 bits                  *
+ ****************************************************************************/
+
+static void TL_Store_Bits(TL_BITS *Bits, BACNET_BIT_STRING *TempBits)
+{
+    uint8_t ucCount;
+
+    /* We truncate any bitstrings at 32 bits to conserve space */
+    if (bitstring_bits_used(TempBits) < 32) {
+        /* Store the bytes used and the bits free in the last byte */
+        Bits->ucLen = bitstring_bytes_used(TempBits) << 4;
+        Bits->ucLen |= (8 - (bitstring_bits_used(TempBits) % 8)) & 7;
+        /* Fetch the octets with the bits directly */
+        for (ucCount = 0; ucCount < bitstring_bytes_used(TempBits);
+             ucCount++) {
+            Bits->ucStore[ucCount] = bitstring_octet(TempBits, ucCount);
+        }
+    } else {
+        /* We will only use the first 4 octets to save space */
+        Bits->ucLen = 4 << 4;
+        for (ucCount = 0; ucCount < 4; ucCount++) {
+            Bits->ucStore[ucCount] = bitstring_octet(TempBits, ucCount);
+        }
+    }
+}
+
 /****************************************************************************
  * Attempt to fetch the logged property and store it in the Trend Log       *
  ****************************************************************************/
@@ -1570,7 +1905,6 @@ static void TL_fetch_property(int iLog)
     BACNET_ERROR_CLASS error_class = ERROR_CLASS_SERVICES;
     BACNET_ERROR_CODE error_code = ERROR_CODE_OTHER;
     int iLen;
-    uint8_t ucCount;
     TL_LOG_INFO *CurrentLog;
     TL_DATA_REC TempRec;
     uint8_t tag_number = 0;
@@ -1629,28 +1963,7 @@ static void TL_fetch_property(int iLog)
             case BACNET_APPLICATION_TAG_BIT_STRING:
                 TempRec.ucRecType = TL_TYPE_BITS;
                 decode_bitstring(&ValueBuf[iLen], len_value_type, &TempBits);
-                /* We truncate any bitstrings at 32 bits to conserve space */
-                if (bitstring_bits_used(&TempBits) < 32) {
-                    /* Store the bytes used and the bits free in the last byte
-                     */
-                    TempRec.Datum.Bits.ucLen = bitstring_bytes_used(&TempBits)
-                        << 4;
-                    TempRec.Datum.Bits.ucLen |=
-                        (8 - (bitstring_bits_used(&TempBits) % 8)) & 7;
-                    /* Fetch the octets with the bits directly */
-                    for (ucCount = 0; ucCount < bitstring_bytes_used(&TempBits);
-                         ucCount++) {
-                        TempRec.Datum.Bits.ucStore[ucCount] =
-                            bitstring_octet(&TempBits, ucCount);
-                    }
-                } else {
-                    /* We will only use the first 4 octets to save space */
-                    TempRec.Datum.Bits.ucLen = 4 << 4;
-                    for (ucCount = 0; ucCount < 4; ucCount++) {
-                        TempRec.Datum.Bits.ucStore[ucCount] =
-                            bitstring_octet(&TempBits, ucCount);
-                    }
-                }
+                TL_Store_Bits(&TempRec.Datum.Bits, &TempBits);
                 break;
 
             case BACNET_APPLICATION_TAG_ENUMERATED:
@@ -1673,15 +1986,250 @@ static void TL_fetch_property(int iLog)
         TempRec.ucStatus = 128 | bitstring_octet(&TempBits, 0);
     }
 
-    Logs[iLog][CurrentLog->iIndex++] = TempRec;
-    if (CurrentLog->iIndex >= TL_MAX_ENTRIES) {
-        CurrentLog->iIndex = 0;
+    TL_Insert_Data_Rec(iLog, &TempRec);
+}
+
+/****************************************************************************
+ * Store the logged property from a list of COV values in the Trend Log     *
+ ****************************************************************************/
+
+static void TL_Log_COV_Values(int iLog, BACNET_PROPERTY_VALUE *value_list)
+{
+    TL_LOG_INFO *CurrentLog;
+    TL_DATA_REC TempRec;
+    BACNET_PROPERTY_VALUE *pValue;
+    BACNET_PROPERTY_VALUE *pLogged = NULL;
+
+    CurrentLog = &LogInfo[iLog];
+    TempRec.ucStatus = 0;
+    for (pValue = value_list; pValue; pValue = pValue->next) {
+        if ((pValue->propertyIdentifier ==
+                CurrentLog->Source.propertyIdentifier) &&
+            ((CurrentLog->Source.arrayIndex == BACNET_ARRAY_ALL) ||
+                (pValue->propertyArrayIndex ==
+                    CurrentLog->Source.arrayIndex))) {
+            pLogged = pValue;
+        } else if ((pValue->propertyIdentifier == PROP_STATUS_FLAGS) &&
+            (pValue->value.tag == BACNET_APPLICATION_TAG_BIT_STRING)) {
+            TempRec.ucStatus =
+                128 | bitstring_octet(&pValue->value.type.Bit_String, 0);
+        }
+    }
+    if (!pLogged) {
+        /* a notification for some other property of the object */
+        return;
     }
+    TempRec.tTimeStamp = Trend_Log_Epoch_Seconds_Now();
+    CurrentLog->tLastDataTime = TempRec.tTimeStamp;
+    switch (pLogged->value.tag) {
+        case BACNET_APPLICATION_TAG_NULL:
+            TempRec.ucRecType = TL_TYPE_NULL;
+            break;
 
-    CurrentLog->ulTotalRecordCount++;
+        case BACNET_APPLICATION_TAG_BOOLEAN:
+            TempRec.ucRecType = TL_TYPE_BOOL;
+            TempRec.Datum.ucBoolean = pLogged->value.type.Boolean;
+            break;
+
+        case BACNET_APPLICATION_TAG_UNSIGNED_INT:
+            TempRec.ucRecType = TL_TYPE_UNSIGN;
+            TempRec.Datum.ulUValue = (uint32_t)pLogged->value.type.Unsigned_Int;
+            break;
+
+        case BACNET_APPLICATION_TAG_SIGNED_INT:
+            TempRec.ucRecType = TL_TYPE_SIGN;
+            TempRec.Datum.lSValue = pLogged->value.type.Signed_Int;
+            break;
+
+        case BACNET_APPLICATION_TAG_REAL:
+            TempRec.ucRecType = TL_TYPE_REAL;
+            TempRec.Datum.fReal = pLogged->value.type.Real;
+            break;
+
+        case BACNET_APPLICATION_TAG_BIT_STRING:
+            TempRec.ucRecType = TL_TYPE_BITS;
+            TL_Store_Bits(
+                &TempRec.Datum.Bits, &pLogged->value.type.Bit_String);
+            break;
+
+        case BACNET_APPLICATION_TAG_ENUMERATED:
+            TempRec.ucRecType = TL_TYPE_ENUM;
+            TempRec.Datum.ulEnum = pLogged->value.type.Enumerated;
+            break;
+
+        default:
+            /* Fake an error response for any types we cannot handle */
+            TempRec.Datum.Error.usClass = ERROR_CLASS_PROPERTY;
+            TempRec.Datum.Error.usCode = ERROR_CODE_DATATYPE_NOT_SUPPORTED;
+            TempRec.ucRecType = TL_TYPE_ERROR;
+            break;
+    }
+
+    TL_Insert_Data_Rec(iLog, &TempRec);
+}
 
-    if (CurrentLog->ulRecordCount < TL_MAX_ENTRIES) {
-        CurrentLog->ulRecordCount++;
+/****************************************************************************
+ * COV notification from a local object or a remote device. Each COV log    *
+ * with a matching subscription records the new value.                      *
+ ****************************************************************************/
+
+static void TL_COV_Notification(BACNET_COV_DATA *cov_data)
+{
+    TL_LOG_INFO *CurrentLog;
+    int iCount;
+
+    for (iCount = 0; iCount < MAX_TREND_LOGS; iCount++) {
+        CurrentLog = &LogInfo[iCount];
+        if ((CurrentLog->LoggingType != LOGGING_TYPE_COV) ||
+            (!CurrentLog->bCovSubscribed)) {
+            continue;
+        }
+        if ((cov_data->monitoredObjectIdentifier.type !=
+                CurrentLog->Source.objectIdentifier.type) ||
+            (cov_data->monitoredObjectIdentifier.instance !=
+                CurrentLog->Source.objectIdentifier.instance)) {
+            continue;
+        }
+        if (TL_Source_Is_Remote(&CurrentLog->Source)) {
+            if ((cov_data->initiatingDeviceIdentifier !=
+                    CurrentLog->Source.deviceIdentifier.instance) ||
+                (cov_data->subscriberProcessIdentifier !=
+                    Trend_Log_Index_To_Instance(iCount))) {
+                continue;
+            }
+        } else if (cov_data->initiatingDeviceIdentifier !=
+            Device_Object_Instance_Number()) {
+            continue;
+        }
+        if (TL_Is_Enabled(iCount)) {
+            TL_Log_COV_Values(iCount, cov_data->listOfValues);
+        }
+    }
+}
+
+/****************************************************************************
+ * Subscribe to, or cancel the subscription to, COV of the logged source.   *
+ * Local sources hook the COV change path of the object directly, for the  *
+ * properties that path reports - see TL_Source_Has_Local_COV(). Remote     *
+ * sources use SubscribeCOV, or SubscribeCOVProperty when a property other  *
+ * than Present_Value is logged or a client COV increment is set.           *
+ ****************************************************************************/
+
+static bool TL_COV_Subscribe(int iLog, bool bCancel)
+{
+    TL_LOG_INFO *CurrentLog;
+    BACNET_SUBSCRIBE_COV_DATA cov_data;
+    BACNET_ADDRESS dest;
+    unsigned max_apdu = 0;
+    uint32_t device_id;
+
+    CurrentLog = &LogInfo[iLog];
+    if (!TL_Source_Is_Remote(&CurrentLog->Source)) {
+        return handler_cov_local_subscribe(
+            (BACNET_OBJECT_TYPE)CurrentLog->Source.objectIdentifier.type,
+            CurrentLog->Source.objectIdentifier.instance, !bCancel);
+    }
+    device_id = CurrentLog->Source.deviceIdentifier.instance;
+    if (!address_bind_request(device_id, &max_apdu, &dest)) {
+        Send_WhoIs(device_id, device_id);
+        return false;
+    }
+    memset(&cov_data, 0, sizeof(cov_data));
+    cov_data.subscriberProcessIdentifier = Trend_Log_Index_To_Instance(iLog);
+    cov_data.monitoredObjectIdentifier.type =
+        CurrentLog->Source.objectIdentifier.type;
+    cov_data.monitoredObjectIdentifier.instance =
+        CurrentLog->Source.objectIdentifier.instance;
+    cov_data.cancellationRequest = bCancel;
+    cov_data.issueConfirmedNotifications = false;
+    /* the lifetime spans two intervals so that one lost subscription
+       request does not leave a gap in the log */
+    if (CurrentLog->ulCovResubscriptionInterval > (UINT32_MAX / 2)) {
+        cov_data.lifetime = UINT32_MAX;
+    } else {
+        cov_data.lifetime = CurrentLog->ulCovResubscriptionInterval * 2;
+    }
+    if ((CurrentLog->Source.propertyIdentifier != PROP_PRESENT_VALUE) ||
+        (CurrentLog->bClientCovIncrement)) {
+        cov_data.covSubscribeToProperty = true;
+        cov_data.monitoredProperty.propertyIdentifier =
+            CurrentLog->Source.propertyIdentifier;
+        cov_data.monitoredProperty.propertyArrayIndex =
+            CurrentLog->Source.arrayIndex;
+        cov_data.covIncrementPresent = CurrentLog->bClientCovIncrement;
+        cov_data.covIncrement = CurrentLog->fClientCovIncrement;
+    }
+
+    return (Send_COV_Subscribe(device_id, &cov_data) != 0);
+}
+
+/****************************************************************************
+ * Drop the COV subscription of a log, if it has one.                       *
+ ****************************************************************************/
+
+static void TL_COV_Unsubscribe(int iLog)
+{
+    TL_LOG_INFO *CurrentLog;
+
+    CurrentLog = &LogInfo[iLog];
+    if (CurrentLog->bCovSubscribed) {
+        (void)TL_COV_Subscribe(iLog, true);
+        CurrentLog->bCovSubscribed = false;
+    }
+    CurrentLog->ulCovResubscribeTimer = 0;
+}
+
+/****************************************************************************
+ * Keep the COV subscription of a log in place while it is enabled for COV  *
+ * logging, resubscribing to remote sources at the configured interval.     *
+ ****************************************************************************/
+
+static void TL_COV_Timer(int iLog, uint16_t uSeconds)
+{
+    TL_LOG_INFO *CurrentLog;
+
+    CurrentLog = &LogInfo[iLog];
+    if ((CurrentLog->LoggingType != LOGGING_TYPE_COV) ||
+        (!TL_Is_Enabled(iLog))) {
+        TL_COV_Unsubscribe(iLog);
+        return;
+    }
+    if (!TL_Source_Is_Remote(&CurrentLog->Source)) {
+        if (!TL_Source_Has_Local_COV(&CurrentLog->Source)) {
+            /* the local COV path does not report the logged property,
+               so poll it instead - 12.25.27 default interval */
+            TL_COV_Unsubscribe(iLog);
+            CurrentLog->LoggingType = LOGGING_TYPE_POLLED;
+            CurrentLog->ulLogInterval = 900;
+            return;
+        }
+        if (!CurrentLog->bCovSubscribed) {
+            CurrentLog->bCovSubscribed = TL_COV_Subscribe(iLog, false);
+            if (CurrentLog->bCovSubscribed) {
+                /* like a remote subscription, start with the current value */
+                TL_fetch_property(iLog);
+            }
+        }
+        return;
+    }
+    if (CurrentLog->ulCovResubscribeTimer == UINT32_MAX) {
+        /* one subscription with an indefinite lifetime */
+        return;
+    }
+    if (CurrentLog->ulCovResubscribeTimer > uSeconds) {
+        CurrentLog->ulCovResubscribeTimer -= uSeconds;
+        return;
+    }
+    if (TL_COV_Subscribe(iLog, false)) {
+        CurrentLog->bCovSubscribed = true;
+        if (CurrentLog->ulCovResubscriptionInterval) {
+            CurrentLog->ulCovResubscribeTimer =
+                CurrentLog->ulCovResubscriptionInterval;
+        } else {
+            CurrentLog->ulCovResubscribeTimer = UINT32_MAX;
+        }
+    } else {
+        CurrentLog->ulCovResubscribeTimer = TL_COV_RETRY_INTERVAL;
     }
 }
 
@@ -1695,11 +2243,11 @@ void trend_log_timer(uint16_t uSeconds)
     int iCount = 0;
     bacnet_time_t tNow = 0;
 
-    (void)uSeconds;
     /* use OS to get the current time */
     tNow = Trend_Log_Epoch_Seconds_Now();
     for (iCount = 0; iCount < MAX_TREND_LOGS; iCount++) {
         CurrentLog = &LogInfo[iCount];
+        TL_COV_Timer(iCount, uSeconds);
         if (TL_Is_Enabled(iCount)) {
             if (CurrentLog->LoggingType == LOGGING_TYPE_POLLED) {
                 /* For polled logs we first need to see if they are clock
@@ -1751,6 +2299,14 @@ void trend_log_timer(uint16_t uSeconds)
                     TL_fetch_property(iCount);
                     CurrentLog->bTrigger = false;
                 }
+            } else if (CurrentLog->LoggingType == LOGGING_TYPE_COV) {
+                /* COV logs record from the notifications, but a trigger
+                 * still takes a reading of a local source */
+                if ((CurrentLog->bTrigger == true) &&
+                    (!TL_Source_Is_Remote(&CurrentLog->Source))) {
+                    TL_fetch_property(iCount);
+                }
+                CurrentLog->bTrigger = false;
             }
         }
     }
@@ -31,6 +31,7 @@
 #include "bacnet/bacdef.h"
 #include "bacnet/cov.h"
 #include "bacnet/datetime.h"
+#include "bacnet/readrange.h"
 #include "bacnet/rp.h"
 #include "bacnet/wp.h"
 
@@ -81,7 +82,21 @@ extern "C" {
 #define TL_T_START_WILD 1       /* Start time is wild carded */
 #define TL_T_STOP_WILD  2       /* Stop Time is wild carded */
 
-#define TL_MAX_ENTRIES 1000     /* Entries per datalog */
+/* Records are stored compressed in a ring of blocks per log.  The default
+   of 93 blocks of 256 octets is about the RAM of 1000 uncompressed records.
+   A block holds TL_BLOCK_RECORDS records of a steadily sampled value, and
+   fewer of values that do not compress as well. */
+#ifndef TL_BLOCK_SIZE
+#define TL_BLOCK_SIZE 256
+#endif
+#ifndef TL_MAX_BLOCKS
+#define TL_MAX_BLOCKS 93
+#endif
+#ifndef TL_BLOCK_RECORDS
+#define TL_BLOCK_RECORDS 94
+#endif
+/* Entries per datalog, the Buffer_Size */
+#define TL_MAX_ENTRIES ((uint32_t)TL_MAX_BLOCKS * TL_BLOCK_RECORDS)
 
 /* Structure containing config and status info for a Trend Log */
 
@@ -101,8 +116,12 @@ extern "C" {
         bool bAlignIntervals;   /* If true align to the clock */
         uint32_t ulIntervalOffset;      /* Offset from start of period for taking reading in seconds */
         bool bTrigger;  /* Set to 1 to cause a reading to be taken */
-        int iIndex;     /* Current insertion point */
         bacnet_time_t tLastDataTime;
+        uint32_t ulCovResubscriptionInterval;   /* Seconds between COV subscriptions, 0 for no expiry */
+        bool bClientCovIncrement;       /* Client COV increment is REAL, not NULL */
+        float fClientCovIncrement;      /* Client COV increment requested */
+        bool bCovSubscribed;    /* COV subscription to the source is in place */
+        uint32_t ulCovResubscribeTimer; /* Seconds until next COV subscription */
     } TL_LOG_INFO;
 
 /*
@@ -0,0 +1,596 @@
+/**
+ * @file
+ * @brief Compressed block encoding of Trend Log records
+ *
+ * @section DESCRIPTION
+ *
+ * Each record is a sequence of bits, most significant bit first:
+ *
+ * Time stamp - the change in the seconds between records:
+ *   '0'                   same interval as the previous record
+ *   '10'   + 7 bits       signed change of -64..63
+ *   '110'  + 9 bits       signed change of -256..255
+ *   '1110' + 12 bits      signed change of -2048..2047
+ *   '1111' + 32 bits      any other change
+ *
+ * Record type and status flags:
+ *   '0'                   same as the previous record
+ *   '1' + 4 bits + 8 bits record type and status flags
+ *
+ * Datum, by record type:
+ *   REAL, DELTA, ENUM, UNSIGN, SIGN - XOR with the previous 32 bit datum:
+ *   '0'                   same as the previous datum
+ *   '10' + bits           changed bits fit the previous window
+ *   '11' + 5 bits leading zeros + 5 bits length-1 + bits
+ *   BOOL - 1 bit, STATUS - 8 bits, ERROR - 16 bits class + 16 bits code,
+ *   BITS - 8 bits length + up to 4 octets, NULL - nothing
+ *
+ * A periodically sampled, slowly changing value takes a few bits for the
+ * time stamp and flags, and from one bit to a few tens of bits for the
+ * datum, against 16 or more octets for a TL_DATA_REC.
+ *
+ * @section LICENSE
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "bacnet/basic/object/trendlog_block.h"
+
+/* No XOR window has been set in this block */
+#define TL_BLOCK_NO_WINDOW 0xFF
+/* Largest interval between two records in one block, in seconds */
+#define TL_BLOCK_DELTA_MAX 0x3FFFFFFFUL
+
+/**
+ * Writes bits to the block, most significant bit first
+ *
+ * @param block - block of octets
+ * @param block_size - size of the block in octets
+ * @param bit - [in,out] next bit position in the block
+ * @param value - bits to write, right aligned
+ * @param count - number of bits to write, 0..32
+ * @return true if the bits fit in the block
+ */
+static bool tl_block_put(uint8_t *block,
+    uint16_t block_size,
+    uint16_t *bit,
+    uint32_t value,
+    uint8_t count)
+{
+    uint8_t mask;
+
+    if (((unsigned long)*bit + count) > ((unsigned long)block_size * 8)) {
+        return false;
+    }
+    while (count > 0) {
+        count--;
+        mask = 0x80 >> (*bit & 7);
+        if ((value >> count) & 1) {
+            block[*bit >> 3] |= mask;
+        } else {
+            block[*bit >> 3] &= (uint8_t)~mask;
+        }
+        (*bit)++;
+    }
+
+    return true;
+}
+
+/**
+ * Reads bits from the block, most significant bit first
+ *
+ * @param block - block of octets
+ * @param block_size - size of the block in octets
+ * @param bit - [in,out] next bit position in the block
+ * @param count - number of bits to read, 0..32
+ * @param value - [out] bits read, right aligned
+ * @return true if the bits were in the block
+ */
+static bool tl_block_get(const uint8_t *block,
+    uint16_t block_size,
+    uint16_t *bit,
+    uint8_t count,
+    uint32_t *value)
+{
+    uint32_t bits = 0;
+
+    if (((unsigned long)*bit + count) > ((unsigned long)block_size * 8)) {
+        return false;
+    }
+    while (count > 0) {
+        count--;
+        bits <<= 1;
+        if (block[*bit >> 3] & (0x80 >> (*bit & 7))) {
+            bits |= 1;
+        }
+        (*bit)++;
+    }
+    *value = bits;
+
+    return true;
+}
+
+/**
+ * Extends the sign of a two's complement value
+ *
+ * @param value - right aligned value
+ * @param count - number of bits in the value, 1..32
+ * @return signed value
+ */
+static int32_t tl_block_sign_extend(uint32_t value, uint8_t count)
+{
+    if ((count < 32) && (value & (1UL << (count - 1)))) {
+        value |= ~((1UL << count) - 1);
+    }
+
+    return (int32_t)value;
+}
+
+/**
+ * Returns true for the record types with a 32 bit datum
+ *
+ * @param ucRecType - TL_TYPE_xxx
+ * @return true if the datum is XOR encoded
+ */
+static bool tl_block_datum32(uint8_t ucRecType)
+{
+    return ((ucRecType == TL_TYPE_REAL) || (ucRecType == TL_TYPE_DELTA) ||
+        (ucRecType == TL_TYPE_ENUM) || (ucRecType == TL_TYPE_UNSIGN) ||
+        (ucRecType == TL_TYPE_SIGN));
+}
+
+/**
+ * Gets the 32 bit datum of a record as raw bits
+ *
+ * @param rec - record with a 32 bit datum
+ * @return datum bits
+ */
+static uint32_t tl_block_datum_get(const TL_DATA_REC *rec)
+{
+    uint32_t value = 0;
+
+    switch (rec->ucRecType) {
+        case TL_TYPE_REAL:
+            memcpy(&value, &rec->Datum.fReal, sizeof(value));
+            break;
+        case TL_TYPE_DELTA:
+            memcpy(&value, &rec->Datum.fTime, sizeof(value));
+            break;
+        case TL_TYPE_ENUM:
+            value = rec->Datum.ulEnum;
+            break;
+        case TL_TYPE_UNSIGN:
+            value = rec->Datum.ulUValue;
+            break;
+        case TL_TYPE_SIGN:
+            value = (uint32_t)rec->Datum.lSValue;
+            break;
+        default:
+            break;
+    }
+
+    return value;
+}
+
+/**
+ * Sets the 32 bit datum of a record from raw bits
+ *
+ * @param rec - record with a 32 bit datum
+ * @param value - datum bits
+ */
+static void tl_block_datum_set(TL_DATA_REC *rec, uint32_t value)
+{
+    switch (rec->ucRecType) {
+        case TL_TYPE_REAL:
+            memcpy(&rec->Datum.fReal, &value, sizeof(value));
+            break;
+        case TL_TYPE_DELTA:
+            memcpy(&rec->Datum.fTime, &value, sizeof(value));
+            break;
+        case TL_TYPE_ENUM:
+            rec->Datum.ulEnum = value;
+            break;
+        case TL_TYPE_UNSIGN:
+            rec->Datum.ulUValue = value;
+            break;
+        case TL_TYPE_SIGN:
+            rec->Datum.lSValue = (int32_t)value;
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * Finds the seconds between two time stamps
+ *
+ * @param tLast - previous time stamp
+ * @param tNow - this time stamp
+ * @param delta - [out] signed seconds from tLast to tNow
+ * @return true if the interval can be stored in one block
+ */
+static bool tl_block_delta(
+    bacnet_time_t tLast, bacnet_time_t tNow, int32_t *delta)
+{
+    bacnet_time_t diff;
+
+    if (tNow >= tLast) {
+        diff = tNow - tLast;
+        if (diff > TL_BLOCK_DELTA_MAX) {
+            return false;
+        }
+        *delta = (int32_t)diff;
+    } else {
+        diff = tLast - tNow;
+        if (diff > TL_BLOCK_DELTA_MAX) {
+            return false;
+        }
+        *delta = -(int32_t)diff;
+    }
+
+    return true;
+}
+
+/**
+ * Writes the change in the interval between records
+ *
+ * @param block - block of octets
+ * @param block_size - size of the block in octets
+ * @param bit - [in,out] next bit position in the block
+ * @param dod - delta of delta in seconds
+ * @return true if the bits fit in the block
+ */
+static bool tl_block_put_dod(
+    uint8_t *block, uint16_t block_size, uint16_t *bit, int32_t dod)
+{
+    uint32_t value = (uint32_t)dod;
+
+    if (dod == 0) {
+        return tl_block_put(block, block_size, bit, 0, 1);
+    } else if ((dod >= -64) && (dod <= 63)) {
+        return tl_block_put(block, block_size, bit, 0x2, 2) &&
+            tl_block_put(block, block_size, bit, value & 0x7F, 7);
+    } else if ((dod >= -256) && (dod <= 255)) {
+        return tl_block_put(block, block_size, bit, 0x6, 3) &&
+            tl_block_put(block, block_size, bit, value & 0x1FF, 9);
+    } else if ((dod >= -2048) && (dod <= 2047)) {
+        return tl_block_put(block, block_size, bit, 0xE, 4) &&
+            tl_block_put(block, block_size, bit, value & 0xFFF, 12);
+    }
+
+    return tl_block_put(block, block_size, bit, 0xF, 4) &&
+        tl_block_put(block, block_size, bit, value, 32);
+}
+
+/**
+ * Reads the change in the interval between records
+ *
+ * @param block - block of octets
+ * @param block_size - size of the block in octets
+ * @param bit - [in,out] next bit position in the block
+ * @param dod - [out] delta of delta in seconds
+ * @return true if the bits were in the block
+ */
+static bool tl_block_get_dod(
+    const uint8_t *block, uint16_t block_size, uint16_t *bit, int32_t *dod)
+{
+    static const uint8_t value_bits[5] = { 0, 7, 9, 12, 32 };
+    uint32_t value = 0;
+    uint8_t prefix = 0;
+
+    /* count the leading ones of the prefix, up to 4 */
+    while (prefix < 4) {
+        if (!tl_block_get(block, block_size, bit, 1, &value)) {
+            return false;
+        }
+        if (value == 0) {
+            break;
+        }
+        prefix++;
+    }
+    if (prefix == 0) {
+        *dod = 0;
+        return true;
+    }
+    if (!tl_block_get(block, block_size, bit, value_bits[prefix], &value)) {
+        return false;
+    }
+    *dod = tl_block_sign_extend(value, value_bits[prefix]);
+
+    return true;
+}
+
+/**
+ * Writes a 32 bit datum as the XOR with the previous datum
+ *
+ * @param block - block of octets
+ * @param block_size - size of the block in octets
+ * @param state - [in,out] block state with the previous datum and window
+ * @param value - datum bits
+ * @return true if the bits fit in the block
+ */
+static bool tl_block_put_xor(uint8_t *block,
+    uint16_t block_size,
+    TL_BLOCK_STATE *state,
+    uint32_t value)
+{
+    uint32_t xor_value = value ^ state->ulValue;
+    uint8_t leading = 0;
+    uint8_t trailing = 0;
+    uint8_t length = 0;
+    bool status = false;
+
+    state->ulValue = value;
+    if (xor_value == 0) {
+        return tl_block_put(block, block_size, &state->usBit, 0, 1);
+    }
+    while (!(xor_value & (0x80000000UL >> leading))) {
+        leading++;
+    }
+    while (!(xor_value & (1UL << trailing))) {
+        trailing++;
+    }
+    if ((state->ucLeading != TL_BLOCK_NO_WINDOW) &&
+        (leading >= state->ucLeading) && (trailing >= state->ucTrailing)) {
+        /* the changed bits fit in the previous window */
+        length = 32 - state->ucLeading - state->ucTrailing;
+        status = tl_block_put(block, block_size, &state->usBit, 0x2, 2) &&
+            tl_block_put(block, block_size, &state->usBit,
+                xor_value >> state->ucTrailing, length);
+    } else {
+        length = 32 - leading - trailing;
+        status = tl_block_put(block, block_size, &state->usBit, 0x3, 2) &&
+            tl_block_put(block, block_size, &state->usBit, leading, 5) &&
+            tl_block_put(block, block_size, &state->usBit, length - 1, 5) &&
+            tl_block_put(block, block_size, &state->usBit,
+                xor_value >> trailing, length);
+        state->ucLeading = leading;
+        state->ucTrailing = trailing;
+    }
+
+    return status;
+}
+
+/**
+ * Reads a 32 bit datum stored as the XOR with the previous datum
+ *
+ * @param block - block of octets
+ * @param block_size - size of the block in octets
+ * @param state - [in,out] block state with the previous datum and window
+ * @param value - [out] datum bits
+ * @return true if the bits were in the block
+ */
+static bool tl_block_get_xor(const uint8_t *block,
+    uint16_t block_size,
+    TL_BLOCK_STATE *state,
+    uint32_t *value)
+{
+    uint32_t bits = 0;
+    uint32_t leading = 0;
+    uint32_t length = 0;
+
+    if (!tl_block_get(block, block_size, &state->usBit, 1, &bits)) {
+        return false;
+    }
+    if (bits == 0) {
+        *value = state->ulValue;
+        return true;
+    }
+    if (!tl_block_get(block, block_size, &state->usBit, 1, &bits)) {
+        return false;
+    }
+    if (bits) {
+        if (!tl_block_get(block, block_size, &state->usBit, 5, &leading) ||
+            !tl_block_get(block, block_size, &state->usBit, 5, &length)) {
+            return false;
+        }
+        length++;
+        if ((leading + length) > 32) {
+            return false;
+        }
+        state->ucLeading = (uint8_t)leading;
+        state->ucTrailing = (uint8_t)(32 - leading - length);
+    } else if (state->ucLeading == TL_BLOCK_NO_WINDOW) {
+        return false;
+    } else {
+        length = 32 - state->ucLeading - state->ucTrailing;
+    }
+    if (!tl_block_get(
+            block, block_size, &state->usBit, (uint8_t)length, &bits)) {
+        return false;
+    }
+    state->ulValue ^= bits << state->ucTrailing;
+    *value = state->ulValue;
+
+    return true;
+}
+
+/**
+ * Starts the encoding or decoding of a block
+ *
+ * @param state - block state to initialize
+ * @param tFirst - time stamp of the first record in the block, which
+ *  is kept in the block index rather than in the block
+ */
+void TL_Block_Start(TL_BLOCK_STATE *state, bacnet_time_t tFirst)
+{
+    if (state) {
+        state->tLast = tFirst;
+        state->lDelta = 0;
+        state->ulValue = 0;
+        state->usBit = 0;
+        state->ucRecType = 0xFF;
+        state->ucStatus = 0;
+        state->ucLeading = TL_BLOCK_NO_WINDOW;
+        state->ucTrailing = 0;
+    }
+}
+
+/**
+ * Appends a record to a block
+ *
+ * @param block - block of octets
+ * @param block_size - size of the block in octets
+ * @param state - [in,out] encoder state from TL_Block_Start()
+ * @param rec - record to append
+ * @return true if the record was appended, false if it did not fit, in
+ *  which case the state is unchanged and a new block is needed
+ */
+bool TL_Block_Encode(uint8_t *block,
+    uint16_t block_size,
+    TL_BLOCK_STATE *state,
+    const TL_DATA_REC *rec)
+{
+    TL_BLOCK_STATE next;
+    int32_t delta = 0;
+    uint8_t ucCount = 0;
+    uint8_t ucLen = 0;
+    bool status = false;
+
+    if (!block || !state || !rec || (rec->ucRecType > TL_TYPE_ANY)) {
+        return false;
+    }
+    next = *state;
+    if (!tl_block_delta(next.tLast, rec->tTimeStamp, &delta)) {
+        return false;
+    }
+    status = tl_block_put_dod(
+        block, block_size, &next.usBit, delta - next.lDelta);
+    next.tLast = rec->tTimeStamp;
+    next.lDelta = delta;
+    if (status) {
+        if ((rec->ucRecType == next.ucRecType) &&
+            (rec->ucStatus == next.ucStatus)) {
+            status = tl_block_put(block, block_size, &next.usBit, 0, 1);
+        } else {
+            status = tl_block_put(block, block_size, &next.usBit, 1, 1) &&
+                tl_block_put(
+                    block, block_size, &next.usBit, rec->ucRecType, 4) &&
+                tl_block_put(block, block_size, &next.usBit, rec->ucStatus, 8);
+            next.ucRecType = rec->ucRecType;
+            next.ucStatus = rec->ucStatus;
+        }
+    }
+    if (status) {
+        if (tl_block_datum32(rec->ucRecType)) {
+            status = tl_block_put_xor(
+                block, block_size, &next, tl_block_datum_get(rec));
+        } else if (rec->ucRecType == TL_TYPE_STATUS) {
+            status = tl_block_put(block, block_size, &next.usBit,
+                rec->Datum.ucLogStatus, 8);
+        } else if (rec->ucRecType == TL_TYPE_BOOL) {
+            status = tl_block_put(block, block_size, &next.usBit,
+                rec->Datum.ucBoolean ? 1 : 0, 1);
+        } else if (rec->ucRecType == TL_TYPE_BITS) {
+            ucLen = rec->Datum.Bits.ucLen;
+            status = tl_block_put(block, block_size, &next.usBit, ucLen, 8);
+            for (ucCount = 0; status && (ucCount < (ucLen >> 4)) &&
+                 (ucCount < sizeof(rec->Datum.Bits.ucStore));
+                 ucCount++) {
+                status = tl_block_put(block, block_size, &next.usBit,
+                    rec->Datum.Bits.ucStore[ucCount], 8);
+            }
+        } else if (rec->ucRecType == TL_TYPE_ERROR) {
+            status = tl_block_put(block, block_size, &next.usBit,
+                         rec->Datum.Error.usClass, 16) &&
+                tl_block_put(block, block_size, &next.usBit,
+                    rec->Datum.Error.usCode, 16);
+        }
+    }
+    if (status) {
+        *state = next;
+    }
+
+    return status;
+}
+
+/**
+ * Reads the next record from a block
+ *
+ * @param block - block of octets
+ * @param block_size - size of the block in octets
+ * @param state - [in,out] decoder state from TL_Block_Start()
+ * @param rec - [out] decoded record
+ * @return true if a record was decoded
+ */
+bool TL_Block_Decode(const uint8_t *block,
+    uint16_t block_size,
+    TL_BLOCK_STATE *state,
+    TL_DATA_REC *rec)
+{
+    int32_t dod = 0;
+    uint32_t value = 0;
+    uint8_t ucCount = 0;
+
+    if (!block || !state || !rec) {
+        return false;
+    }
+    if (!tl_block_get_dod(block, block_size, &state->usBit, &dod)) {
+        return false;
+    }
+    state->lDelta += dod;
+    if (state->lDelta >= 0) {
+        state->tLast += (bacnet_time_t)state->lDelta;
+    } else {
+        state->tLast -= (bacnet_time_t)(-state->lDelta);
+    }
+    if (!tl_block_get(block, block_size, &state->usBit, 1, &value)) {
+        return false;
+    }
+    if (value) {
+        if (!tl_block_get(block, block_size, &state->usBit, 4, &value)) {
+            return false;
+        }
+        state->ucRecType = (uint8_t)value;
+        if (!tl_block_get(block, block_size, &state->usBit, 8, &value)) {
+            return false;
+        }
+        state->ucStatus = (uint8_t)value;
+    }
+    memset(rec, 0, sizeof(TL_DATA_REC));
+    rec->tTimeStamp = state->tLast;
+    rec->ucRecType = state->ucRecType;
+    rec->ucStatus = state->ucStatus;
+    if (tl_block_datum32(rec->ucRecType)) {
+        if (!tl_block_get_xor(block, block_size, state, &value)) {
+            return false;
+        }
+        tl_block_datum_set(rec, value);
+    } else if (rec->ucRecType == TL_TYPE_STATUS) {
+        if (!tl_block_get(block, block_size, &state->usBit, 8, &value)) {
+            return false;
+        }
+        rec->Datum.ucLogStatus = (uint8_t)value;
+    } else if (rec->ucRecType == TL_TYPE_BOOL) {
+        if (!tl_block_get(block, block_size, &state->usBit, 1, &value)) {
+            return false;
+        }
+        rec->Datum.ucBoolean = (uint8_t)value;
+    } else if (rec->ucRecType == TL_TYPE_BITS) {
+        if (!tl_block_get(block, block_size, &state->usBit, 8, &value)) {
+            return false;
+        }
+        rec->Datum.Bits.ucLen = (uint8_t)value;
+        for (ucCount = 0; (ucCount < (rec->Datum.Bits.ucLen >> 4)) &&
+             (ucCount < sizeof(rec->Datum.Bits.ucStore));
+             ucCount++) {
+            if (!tl_block_get(block, block_size, &state->usBit, 8, &value)) {
+                return false;
+            }
+            rec->Datum.Bits.ucStore[ucCount] = (uint8_t)value;
+        }
+    } else if (rec->ucRecType == TL_TYPE_ERROR) {
+        if (!tl_block_get(block, block_size, &state->usBit, 16, &value)) {
+            return false;
+        }
+        rec->Datum.Error.usClass = (uint16_t)value;
+        if (!tl_block_get(block, block_size, &state->usBit, 16, &value)) {
+            return false;
+        }
+        rec->Datum.Error.usCode = (uint16_t)value;
+    }
+
+    return true;
+}
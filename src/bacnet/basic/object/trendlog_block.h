@@ -0,0 +1,67 @@
+/**
+ * @file
+ * @brief Compressed block encoding of Trend Log records
+ *
+ * @section DESCRIPTION
+ *
+ * Trend Log records are packed into fixed size blocks of bits:
+ * time stamps as delta-of-delta, 32 bit data as XOR with the previous
+ * datum, and the record type and status flags run-length encoded.
+ * A block is decoded sequentially from its first record, so a log
+ * keeps a small index of the first time stamp and the record count
+ * of each block for seeking.
+ *
+ * @section LICENSE
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef TRENDLOG_BLOCK_H
+#define TRENDLOG_BLOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "bacnet/bacnet_stack_exports.h"
+#include "bacnet/datetime.h"
+#include "bacnet/basic/object/trendlog.h"
+
+/* Worst case size of one encoded record in octets */
+#define TL_BLOCK_RECORD_MAX 12
+
+/* Encoder or decoder position and history within one block.
+   Block sizes are limited to 8191 octets by the bit position. */
+typedef struct tl_block_state {
+    bacnet_time_t tLast;        /* Time stamp of the previous record */
+    int32_t lDelta;     /* Seconds between the previous two records */
+    uint32_t ulValue;   /* Previous 32 bit datum, for XOR */
+    uint16_t usBit;     /* Next bit to be written or read */
+    uint8_t ucRecType;  /* Previous record type, 0xFF at the block start */
+    uint8_t ucStatus;   /* Previous status flags */
+    uint8_t ucLeading;  /* Leading zero bits of the previous XOR window */
+    uint8_t ucTrailing; /* Trailing zero bits of the previous XOR window */
+} TL_BLOCK_STATE;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    BACNET_STACK_EXPORT
+    void TL_Block_Start(
+        TL_BLOCK_STATE * state,
+        bacnet_time_t tFirst);
+    BACNET_STACK_EXPORT
+    bool TL_Block_Encode(
+        uint8_t * block,
+        uint16_t block_size,
+        TL_BLOCK_STATE * state,
+        const TL_DATA_REC * rec);
+    BACNET_STACK_EXPORT
+    bool TL_Block_Decode(
+        const uint8_t * block,
+        uint16_t block_size,
+        TL_BLOCK_STATE * state,
+        TL_DATA_REC * rec);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif
@@ -187,7 +187,7 @@ AA_ABORT:
 #if PRINT_ENABLED
     bytes_sent =
 #endif
-        datalink_send_pdu(
+        apdu_send_reply(
             src, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
 #if PRINT_ENABLED
     if (bytes_sent <= 0)
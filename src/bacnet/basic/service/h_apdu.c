@@ -34,14 +34,19 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
+#include <string.h>
 #include "bacnet/bits.h"
+#include "bacnet/abort.h"
 #include "bacnet/apdu.h"
+#include "bacnet/bacaddr.h"
 #include "bacnet/bacdef.h"
 #include "bacnet/bacdcode.h"
 #include "bacnet/bacenum.h"
 #include "bacnet/bacerror.h"
 #include "bacnet/dcc.h"
 #include "bacnet/iam.h"
+#include "bacnet/npdu.h"
+#include "bacnet/datalink/datalink.h"
 /* basic objects, services, TSM */
 #include "bacnet/basic/object/device.h"
 #include "bacnet/basic/tsm/tsm.h"
@@ -54,6 +59,58 @@ static uint16_t Timeout_Milliseconds = 3000;
 /* Number of APDU Retries */
 static uint8_t Number_Of_Retries = 3;
 
+#if MAX_APDU_REPLY_CACHE
+/* identifies a confirmed request and its retransmitted copies */
+typedef struct apdu_reply_key {
+    BACNET_ADDRESS src;
+    uint8_t invoke_id;
+    uint8_t service_choice;
+    uint16_t request_len;
+    uint32_t request_hash;
+} APDU_REPLY_KEY;
+
+/* the ACK sent for a confirmed request */
+typedef struct apdu_reply {
+    APDU_REPLY_KEY key;
+    /* milliseconds until the reply is dropped, or 0 if unused */
+    uint32_t timer;
+    BACNET_NPDU_DATA npdu_data;
+    uint16_t pdu_len;
+    uint8_t pdu[MAX_PDU];
+} APDU_REPLY;
+
+static APDU_REPLY Reply_Cache[MAX_APDU_REPLY_CACHE];
+/* the confirmed request being handled, whose ACK is kept */
+static APDU_REPLY_KEY Reply_Request;
+static bool Reply_Request_Active;
+/* replies are kept only once the timer runs, so that they expire */
+static bool Reply_Cache_Timer_Running;
+#endif
+
+/* Confirmed requests are admitted from token buckets that hold
+   thousandths of a request, and are refilled by the admission timer */
+#define APDU_TOKENS_PER_REQUEST 1000UL
+#if MAX_APDU_ADMISSION_SOURCES
+/* the bucket of one source */
+typedef struct apdu_source_bucket {
+    BACNET_ADDRESS src;
+    uint32_t tokens;
+    bool in_use;
+} APDU_SOURCE_BUCKET;
+
+static APDU_SOURCE_BUCKET Source_Bucket[MAX_APDU_ADMISSION_SOURCES];
+/* requests per second from each source, or 0 for no limit */
+static uint16_t Source_Rate;
+static uint32_t Source_Tokens_Max;
+#endif
+/* requests per second from all sources, or 0 for no limit */
+static uint16_t Request_Rate;
+static uint32_t Request_Tokens;
+/* overload counters */
+static uint32_t Requests_Admitted;
+static uint32_t Requests_Aborted;
+static uint32_t Requests_Dropped;
+
 /* a simple table for crossing the services supported */
 static BACNET_SERVICES_SUPPORTED
     confirmed_service_supported[MAX_BACNET_CONFIRMED_SERVICE] = {
@@ -485,6 +542,407 @@ void apdu_retries_set(uint8_t value)
     Number_Of_Retries = value;
 }
 
+#if MAX_APDU_REPLY_CACHE
+/**
+ * @brief Hash the service request of a confirmed request (FNV-1a)
+ * @param service_request - service request data, or NULL
+ * @param service_request_len - number of bytes of service request data
+ * @return hash of the service request data
+ */
+static uint32_t apdu_reply_hash(
+    uint8_t *service_request, uint16_t service_request_len)
+{
+    uint32_t hash = 2166136261UL;
+    uint16_t i;
+
+    if (service_request) {
+        for (i = 0; i < service_request_len; i++) {
+            hash ^= service_request[i];
+            hash *= 16777619UL;
+        }
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Compare the keys of two confirmed requests
+ * @param key1 - key of one request
+ * @param key2 - key of the other request
+ * @return true if the requests are copies of each other
+ */
+static bool apdu_reply_key_same(APDU_REPLY_KEY *key1, APDU_REPLY_KEY *key2)
+{
+    return (key1->invoke_id == key2->invoke_id) &&
+        (key1->service_choice == key2->service_choice) &&
+        (key1->request_len == key2->request_len) &&
+        (key1->request_hash == key2->request_hash) &&
+        bacnet_address_same(&key1->src, &key2->src);
+}
+
+/**
+ * @brief Determine if the reply to a confirmed service is kept.
+ *  Services that only read are run again for a copy of the request,
+ *  so that a client that polls with the same invoke ID always gets
+ *  the present value rather than a kept one.
+ * @param service_choice - the confirmed service
+ * @return true if the reply to the service is kept
+ */
+static bool apdu_reply_cacheable(uint8_t service_choice)
+{
+    switch (service_choice) {
+        case SERVICE_CONFIRMED_READ_PROPERTY:
+        case SERVICE_CONFIRMED_READ_PROP_MULTIPLE:
+        case SERVICE_CONFIRMED_READ_PROP_CONDITIONAL:
+        case SERVICE_CONFIRMED_READ_RANGE:
+        case SERVICE_CONFIRMED_ATOMIC_READ_FILE:
+        case SERVICE_CONFIRMED_GET_ALARM_SUMMARY:
+        case SERVICE_CONFIRMED_GET_ENROLLMENT_SUMMARY:
+        case SERVICE_CONFIRMED_GET_EVENT_INFORMATION:
+            return false;
+        default:
+            break;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Answer a retransmitted confirmed request with the kept ACK
+ *  of the first copy of the request.  A reply kept for another request
+ *  with the same invoke ID from the same client is dropped, since the
+ *  client has reused the invoke ID and is done with that request.
+ * @param key - the confirmed request
+ * @return true if the request was answered from the cache
+ */
+static bool apdu_reply_cache_send(APDU_REPLY_KEY *key)
+{
+    APDU_REPLY *reply;
+    unsigned i;
+
+    for (i = 0; i < MAX_APDU_REPLY_CACHE; i++) {
+        reply = &Reply_Cache[i];
+        if (reply->timer == 0) {
+            continue;
+        }
+        if (apdu_reply_key_same(&reply->key, key)) {
+            (void)datalink_send_pdu(&reply->key.src, &reply->npdu_data,
+                &reply->pdu[0], reply->pdu_len);
+            return true;
+        }
+        if ((reply->key.invoke_id == key->invoke_id) &&
+            bacnet_address_same(&reply->key.src, &key->src)) {
+            reply->timer = 0;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Keep the ACK to the confirmed request being handled, in an
+ *  unused entry or in place of the reply that expires first.  The ACK
+ *  is kept while the client may still retry the request, and the
+ *  copies of the request do not keep it any longer.
+ * @param npdu_data - network layer data of the ACK
+ * @param pdu - the ACK, with its NPDU header
+ * @param pdu_len - number of bytes in the ACK
+ */
+static void apdu_reply_cache_add(
+    BACNET_NPDU_DATA *npdu_data, uint8_t *pdu, unsigned pdu_len)
+{
+    APDU_REPLY *reply = &Reply_Cache[0];
+    unsigned i;
+
+    for (i = 1; i < MAX_APDU_REPLY_CACHE; i++) {
+        if (Reply_Cache[i].timer < reply->timer) {
+            reply = &Reply_Cache[i];
+        }
+    }
+    reply->key = Reply_Request;
+    npdu_copy_data(&reply->npdu_data, npdu_data);
+    memcpy(&reply->pdu[0], pdu, pdu_len);
+    reply->pdu_len = (uint16_t)pdu_len;
+    reply->timer = (uint32_t)apdu_timeout() * (apdu_retries() + 1UL);
+}
+#endif
+
+/**
+ * @brief Add tokens to a bucket, up to its size
+ * @param tokens - the tokens in the bucket
+ * @param rate - requests per second
+ * @param milliseconds - time since the last refill
+ * @param tokens_max - size of the bucket
+ */
+static void apdu_tokens_add(uint32_t *tokens,
+    uint16_t rate,
+    uint16_t milliseconds,
+    uint32_t tokens_max)
+{
+    uint32_t tokens_added;
+
+    /* a rate is requests per second: tokens per millisecond */
+    tokens_added = (uint32_t)rate * milliseconds;
+    if ((*tokens >= tokens_max) || (tokens_added >= (tokens_max - *tokens))) {
+        *tokens = tokens_max;
+    } else {
+        *tokens += tokens_added;
+    }
+}
+
+#if MAX_APDU_ADMISSION_SOURCES
+/**
+ * @brief Find the bucket of a source, or else take one for it.  A full
+ *  bucket is the same as a new one, so the bucket with the most tokens
+ *  is taken.
+ * @param src - the source of a confirmed request
+ * @return the bucket of the source
+ */
+static APDU_SOURCE_BUCKET *apdu_source_bucket(BACNET_ADDRESS *src)
+{
+    APDU_SOURCE_BUCKET *bucket = &Source_Bucket[0];
+    unsigned i;
+
+    for (i = 0; i < MAX_APDU_ADMISSION_SOURCES; i++) {
+        if (Source_Bucket[i].in_use &&
+            bacnet_address_same(&Source_Bucket[i].src, src)) {
+            return &Source_Bucket[i];
+        }
+    }
+    for (i = 0; i < MAX_APDU_ADMISSION_SOURCES; i++) {
+        if (!Source_Bucket[i].in_use) {
+            bucket = &Source_Bucket[i];
+            break;
+        }
+        if (Source_Bucket[i].tokens > bucket->tokens) {
+            bucket = &Source_Bucket[i];
+        }
+    }
+    bacnet_address_copy(&bucket->src, src);
+    bucket->tokens = Source_Tokens_Max;
+    bucket->in_use = true;
+
+    return bucket;
+}
+#endif
+
+/**
+ * @brief Send an Abort for a transaction with a peer
+ * @param src - the peer
+ * @param invoke_id - invoke ID of the transaction
+ * @param reason - abort reason
+ * @param server - true if this device is the server of the transaction
+ */
+static void apdu_abort_send(BACNET_ADDRESS *src,
+    uint8_t invoke_id,
+    BACNET_ABORT_REASON reason,
+    bool server)
+{
+    BACNET_ADDRESS my_address;
+    BACNET_NPDU_DATA npdu_data;
+    int pdu_len;
+
+    datalink_get_my_address(&my_address);
+    npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
+    pdu_len = npdu_encode_pdu(
+        &Handler_Transmit_Buffer[0], src, &my_address, &npdu_data);
+    pdu_len += abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+        invoke_id, reason, server);
+    (void)datalink_send_pdu(
+        src, &npdu_data, &Handler_Transmit_Buffer[0], (unsigned)pdu_len);
+}
+
+/**
+ * @brief Admit a confirmed request, before its service request is
+ *  decoded.  A request over the limit of all sources is dropped, since
+ *  the device has no time to spare, and a request over the limit of
+ *  its source is answered with an Abort, so that the client slows down.
+ * @param src - the source of the request
+ * @param invoke_id - invoke ID of the request
+ * @return true if the request is admitted
+ */
+static bool apdu_request_admitted(BACNET_ADDRESS *src, uint8_t invoke_id)
+{
+#if MAX_APDU_ADMISSION_SOURCES
+    APDU_SOURCE_BUCKET *bucket = NULL;
+#endif
+
+    if (Request_Rate && (Request_Tokens < APDU_TOKENS_PER_REQUEST)) {
+        Requests_Dropped++;
+        return false;
+    }
+#if MAX_APDU_ADMISSION_SOURCES
+    if (Source_Rate) {
+        bucket = apdu_source_bucket(src);
+        if (bucket->tokens < APDU_TOKENS_PER_REQUEST) {
+            Requests_Aborted++;
+            apdu_abort_send(
+                src, invoke_id, ABORT_REASON_OUT_OF_RESOURCES, true);
+            return false;
+        }
+        bucket->tokens -= APDU_TOKENS_PER_REQUEST;
+    }
+#else
+    (void)invoke_id;
+#endif
+    if (Request_Rate) {
+        Request_Tokens -= APDU_TOKENS_PER_REQUEST;
+    }
+    Requests_Admitted++;
+
+    return true;
+}
+
+/**
+ * @brief Limit the confirmed requests from each source
+ * @param requests_per_second - requests from each source, or 0 for
+ *  no limit
+ * @param burst - requests from each source that may come at once,
+ *  or 0 for one second of requests
+ */
+void apdu_source_limit_set(uint16_t requests_per_second, uint16_t burst)
+{
+#if MAX_APDU_ADMISSION_SOURCES
+    unsigned i;
+
+    if (burst == 0) {
+        burst = requests_per_second;
+    }
+    Source_Rate = requests_per_second;
+    Source_Tokens_Max = burst * APDU_TOKENS_PER_REQUEST;
+    for (i = 0; i < MAX_APDU_ADMISSION_SOURCES; i++) {
+        Source_Bucket[i].in_use = false;
+    }
+#else
+    (void)requests_per_second;
+    (void)burst;
+#endif
+}
+
+/**
+ * @brief Limit the confirmed requests from all sources, of which one
+ *  second may come at once
+ * @param requests_per_second - requests from all sources, or 0 for
+ *  no limit
+ */
+void apdu_request_limit_set(uint16_t requests_per_second)
+{
+    Request_Rate = requests_per_second;
+    Request_Tokens = requests_per_second * APDU_TOKENS_PER_REQUEST;
+}
+
+/**
+ * @brief Refill the buckets of the request limits.  The limits need
+ *  this to be called, like tsm_timer_milliseconds().
+ * @param milliseconds - number of milliseconds since the last call
+ */
+void apdu_admission_timer(uint16_t milliseconds)
+{
+#if MAX_APDU_ADMISSION_SOURCES
+    unsigned i;
+
+    if (Source_Rate) {
+        for (i = 0; i < MAX_APDU_ADMISSION_SOURCES; i++) {
+            if (Source_Bucket[i].in_use) {
+                apdu_tokens_add(&Source_Bucket[i].tokens, Source_Rate,
+                    milliseconds, Source_Tokens_Max);
+            }
+        }
+    }
+#endif
+    if (Request_Rate) {
+        apdu_tokens_add(&Request_Tokens, Request_Rate, milliseconds,
+            Request_Rate * APDU_TOKENS_PER_REQUEST);
+    }
+}
+
+/**
+ * @brief Get the counts of the confirmed requests, for diagnostics
+ * @param admitted - filled with the requests that were run, if not NULL
+ * @param aborted - filled with the requests over the limit of their
+ *  source, if not NULL
+ * @param dropped - filled with the requests over the limit of all
+ *  sources, if not NULL
+ */
+void apdu_admission_counters(
+    uint32_t *admitted, uint32_t *aborted, uint32_t *dropped)
+{
+    if (admitted) {
+        *admitted = Requests_Admitted;
+    }
+    if (aborted) {
+        *aborted = Requests_Aborted;
+    }
+    if (dropped) {
+        *dropped = Requests_Dropped;
+    }
+}
+
+/**
+ * @brief Send the reply to a confirmed request.  A Simple-ACK or
+ *  Complex-ACK to a request that is being handled, and that does more
+ *  than read, is kept for the APDU timeout of each try of the request,
+ *  and a copy of the request that arrives in that time is answered
+ *  with it, rather than running the service again.
+ * @param dest - the client that sent the request
+ * @param npdu_data - network layer data of the reply
+ * @param pdu - the reply, with its NPDU header
+ * @param pdu_len - number of bytes in the reply
+ * @return number of bytes sent, or -1 on error
+ */
+int apdu_send_reply(BACNET_ADDRESS *dest,
+    BACNET_NPDU_DATA *npdu_data,
+    uint8_t *pdu,
+    unsigned pdu_len)
+{
+#if MAX_APDU_REPLY_CACHE
+    BACNET_NPDU_DATA reply_npdu_data = { 0 };
+    uint8_t pdu_type;
+    int len;
+
+    if (Reply_Request_Active && Reply_Cache_Timer_Running && dest &&
+        npdu_data && pdu && (pdu_len <= MAX_PDU) &&
+        bacnet_address_same(dest, &Reply_Request.src)) {
+        len = bacnet_npdu_decode(
+            pdu, (uint16_t)pdu_len, NULL, NULL, &reply_npdu_data);
+        if ((len > 0) && ((unsigned)len + 2 < pdu_len) &&
+            (pdu[len + 1] == Reply_Request.invoke_id)) {
+            pdu_type = pdu[len] & 0xF0;
+            if ((pdu_type == PDU_TYPE_SIMPLE_ACK) ||
+                ((pdu_type == PDU_TYPE_COMPLEX_ACK) &&
+                    !(pdu[len] & BIT(3)))) {
+                apdu_reply_cache_add(npdu_data, pdu, pdu_len);
+            }
+        }
+    }
+#endif
+
+    return datalink_send_pdu(dest, npdu_data, pdu, pdu_len);
+}
+
+/**
+ * @brief Expire the kept replies to confirmed requests.  Replies are
+ *  only kept once this is called, like tsm_timer_milliseconds().
+ * @param milliseconds - number of milliseconds since the last call
+ */
+void apdu_reply_cache_timer(uint16_t milliseconds)
+{
+#if MAX_APDU_REPLY_CACHE
+    unsigned i;
+
+    Reply_Cache_Timer_Running = true;
+    for (i = 0; i < MAX_APDU_REPLY_CACHE; i++) {
+        if (Reply_Cache[i].timer > milliseconds) {
+            Reply_Cache[i].timer -= milliseconds;
+        } else {
+            Reply_Cache[i].timer = 0;
+        }
+    }
+#else
+    (void)milliseconds;
+#endif
+}
+
 /* When network communications are completely disabled,
    only DeviceCommunicationControl and ReinitializeDevice APDUs
    shall be processed and no messages shall be initiated.
@@ -568,7 +1026,9 @@ void apdu_handler(BACNET_ADDRESS *src,
     BACNET_ERROR_CLASS error_class = ERROR_CLASS_SERVICES;
     uint8_t reason = 0;
     bool server = false;
+    BACNET_TSM_COMPLETION completion = { 0 };
 
+    completion.src = src;
     if (apdu) {
         /* PDU Type */
         switch (apdu[0] & 0xF0) {
@@ -587,6 +1047,26 @@ void apdu_handler(BACNET_ADDRESS *src,
                        initiated. */
                     break;
                 }
+#if MAX_APDU_REPLY_CACHE
+                bacnet_address_copy(&Reply_Request.src, src);
+                Reply_Request.invoke_id = service_data.invoke_id;
+                Reply_Request.service_choice = service_choice;
+                Reply_Request.request_len = service_request_len;
+                Reply_Request.request_hash =
+                    apdu_reply_hash(service_request, service_request_len);
+                if (!service_data.segmented_message &&
+                    apdu_reply_cache_send(&Reply_Request)) {
+                    /* a copy of a request that was already answered */
+                    break;
+                }
+#endif
+                if (!apdu_request_admitted(src, service_data.invoke_id)) {
+                    break;
+                }
+#if MAX_APDU_REPLY_CACHE
+                Reply_Request_Active = !service_data.segmented_message &&
+                    apdu_reply_cacheable(service_choice);
+#endif
                 if ((service_choice < MAX_BACNET_CONFIRMED_SERVICE) &&
                     (Confirmed_Function[service_choice])) {
                     Confirmed_Function[service_choice](service_request,
@@ -595,6 +1075,9 @@ void apdu_handler(BACNET_ADDRESS *src,
                     Unrecognized_Service_Handler(service_request,
                         service_request_len, src, &service_data);
                 }
+#if MAX_APDU_REPLY_CACHE
+                Reply_Request_Active = false;
+#endif
                 break;
             case PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST:
                 if (apdu_len < 2) {
@@ -625,6 +1108,12 @@ void apdu_handler(BACNET_ADDRESS *src,
                 }
                 invoke_id = apdu[1];
                 service_choice = apdu[2];
+                completion.result = TSM_RESULT_ACK;
+                completion.invoke_id = invoke_id;
+                completion.service_choice = service_choice;
+                if (tsm_complete(&completion)) {
+                    break;
+                }
                 if (apdu_confirmed_simple_ack_service(service_choice)) {
                     if (Confirmed_ACK_Function[service_choice].simple !=
                         NULL) {
@@ -651,6 +1140,28 @@ void apdu_handler(BACNET_ADDRESS *src,
                 service_choice = apdu[len++];
                 service_request = &apdu[len];
                 service_request_len = apdu_len - (uint16_t)len;
+                completion.result = TSM_RESULT_ACK;
+                completion.invoke_id = invoke_id;
+                completion.service_choice = service_choice;
+                completion.service_data = service_request;
+                completion.service_data_len = service_request_len;
+                if (service_ack_data.segmented_message) {
+                    /* a segmented reply completes its request with an
+                       Abort, and the server is told to stop sending */
+                    completion.result = TSM_RESULT_ABORT;
+                    completion.reason =
+                        ABORT_REASON_SEGMENTATION_NOT_SUPPORTED;
+                    completion.service_data = NULL;
+                    completion.service_data_len = 0;
+                }
+                if (tsm_complete(&completion)) {
+                    if (service_ack_data.segmented_message) {
+                        /* the server waits for a SegmentACK - stop it */
+                        apdu_abort_send(src, invoke_id,
+                            ABORT_REASON_SEGMENTATION_NOT_SUPPORTED, false);
+                    }
+                    break;
+                }
                 if (!apdu_confirmed_simple_ack_service(service_choice)) {
                     if (service_choice < MAX_BACNET_CONFIRMED_SERVICE) {
                         if (Confirmed_ACK_Function[service_choice]
@@ -674,6 +1185,20 @@ void apdu_handler(BACNET_ADDRESS *src,
                 }
                 invoke_id = apdu[1];
                 service_choice = apdu[2];
+                completion.result = TSM_RESULT_ERROR;
+                completion.invoke_id = invoke_id;
+                completion.service_choice = service_choice;
+                if (apdu_complex_error(service_choice)) {
+                    completion.service_data = &apdu[3];
+                    completion.service_data_len = apdu_len - 3;
+                } else {
+                    (void)bacerror_decode_error_class_and_code(&apdu[3],
+                        apdu_len - 3, &completion.error_class,
+                        &completion.error_code);
+                }
+                if (tsm_complete(&completion)) {
+                    break;
+                }
                 if (apdu_complex_error(service_choice)) {
                     if (Error_Function[service_choice].complex) {
                         Error_Function[service_choice].complex(src,
@@ -698,6 +1223,12 @@ void apdu_handler(BACNET_ADDRESS *src,
                 }
                 invoke_id = apdu[1];
                 reason = apdu[2];
+                completion.result = TSM_RESULT_REJECT;
+                completion.invoke_id = invoke_id;
+                completion.reason = reason;
+                if (tsm_complete(&completion)) {
+                    break;
+                }
                 if (Reject_Function) {
                     Reject_Function(src, invoke_id, reason);
                 }
@@ -710,6 +1241,12 @@ void apdu_handler(BACNET_ADDRESS *src,
                 server = apdu[0] & 0x01;
                 invoke_id = apdu[1];
                 reason = apdu[2];
+                completion.result = TSM_RESULT_ABORT;
+                completion.invoke_id = invoke_id;
+                completion.reason = reason;
+                if (server && tsm_complete(&completion)) {
+                    break;
+                }
                 if (Abort_Function) {
                     Abort_Function(src, invoke_id, reason, server);
                 }
@@ -34,6 +34,7 @@
 #include "bacnet/bacdef.h"
 #include "bacnet/bacenum.h"
 #include "bacnet/apdu.h"
+#include "bacnet/npdu.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -207,6 +208,32 @@ extern "C" {
     void apdu_retries_set(
         uint8_t value);
 
+    BACNET_STACK_EXPORT
+    int apdu_send_reply(
+        BACNET_ADDRESS * dest,
+        BACNET_NPDU_DATA * npdu_data,
+        uint8_t * pdu,
+        unsigned pdu_len);
+    BACNET_STACK_EXPORT
+    void apdu_reply_cache_timer(
+        uint16_t milliseconds);
+
+    BACNET_STACK_EXPORT
+    void apdu_source_limit_set(
+        uint16_t requests_per_second,
+        uint16_t burst);
+    BACNET_STACK_EXPORT
+    void apdu_request_limit_set(
+        uint16_t requests_per_second);
+    BACNET_STACK_EXPORT
+    void apdu_admission_timer(
+        uint16_t milliseconds);
+    BACNET_STACK_EXPORT
+    void apdu_admission_counters(
+        uint32_t * admitted,
+        uint32_t * aborted,
+        uint32_t * dropped);
+
     BACNET_STACK_EXPORT
     void apdu_handler(
         BACNET_ADDRESS * src,   /* source address */
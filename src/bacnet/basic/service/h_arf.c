@@ -202,7 +202,7 @@ void handler_atomic_read_file(uint8_t *service_request,
     }
 ARF_ABORT:
     pdu_len += len;
-    bytes_sent = datalink_send_pdu(
+    bytes_sent = apdu_send_reply(
         src, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
 #if PRINT_ENABLED
     if (bytes_sent <= 0) {
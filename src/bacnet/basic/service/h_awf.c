@@ -170,7 +170,7 @@ void handler_atomic_write_file(uint8_t *service_request,
     }
 AWF_ABORT:
     pdu_len += len;
-    bytes_sent = datalink_send_pdu(
+    bytes_sent = apdu_send_reply(
         src, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
 #if PRINT_ENABLED
     if (bytes_sent <= 0) {
@@ -177,7 +177,7 @@ void handler_ccov_notification(uint8_t *service_request,
     }
 CCOV_ABORT:
     pdu_len += len;
-    bytes_sent = datalink_send_pdu(
+    bytes_sent = apdu_send_reply(
         src, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
     if (bytes_sent <= 0) {
         PRINTF("CCOV: Failed to send PDU (%s)!\n", strerror(errno));
@@ -64,6 +64,9 @@ typedef struct BACnet_COV_Subscription_Flags {
     bool valid : 1;
     bool issueConfirmedNotifications : 1; /* optional */
     bool send_requested : 1;
+    /* SubscribeCOVProperty - one property, with its own increment */
+    bool property : 1;
+    bool covIncrementPresent : 1;
 } BACNET_COV_SUBSCRIPTION_FLAGS;
 
 typedef struct BACnet_COV_Subscription {
@@ -73,6 +76,13 @@ typedef struct BACnet_COV_Subscription {
     uint32_t subscriberProcessIdentifier;
     uint32_t lifetime; /* optional */
     BACNET_OBJECT_ID monitoredObjectIdentifier;
+    /* SubscribeCOVProperty only */
+    BACNET_PROPERTY_REFERENCE monitoredProperty;
+    float covIncrement; /* optional */
+    /* the value last notified, if a REAL, and a hash of the value,
+       if not a REAL, and of the Status_Flags */
+    float lastValue;
+    uint32_t lastHash;
 } BACNET_COV_SUBSCRIPTION;
 
 #ifndef MAX_COV_SUBCRIPTIONS
@@ -84,6 +94,42 @@ static BACNET_COV_SUBSCRIPTION COV_Subscriptions[MAX_COV_SUBCRIPTIONS];
 #endif
 static BACNET_COV_ADDRESS COV_Addresses[MAX_COV_ADDRESSES];
 
+/* local subscriptions let objects in this device, such as a Trend Log,
+   follow the COV change path of another local object without polling */
+typedef struct BACnet_COV_Local_Subscription {
+    bool send_requested;
+    /* number of local subscribers to this object - zero when unused */
+    unsigned count;
+    BACNET_OBJECT_ID monitoredObjectIdentifier;
+} BACNET_COV_LOCAL_SUBSCRIPTION;
+
+#ifndef MAX_COV_LOCAL_SUBSCRIPTIONS
+#define MAX_COV_LOCAL_SUBSCRIPTIONS 8
+#endif
+static BACNET_COV_LOCAL_SUBSCRIPTION
+    COV_Local_Subscriptions[MAX_COV_LOCAL_SUBSCRIPTIONS];
+/* local COV notification callbacks list */
+static BACNET_COV_NOTIFICATION COV_Local_Notification_Head;
+
+/* the listOfValues of a changed object is encoded once in each pass
+   that sends notifications, and copied into the notification of each
+   subscription to that object */
+typedef struct BACnet_COV_Value_Cache {
+    bool valid;
+    BACNET_OBJECT_ID monitoredObjectIdentifier;
+    unsigned values_len;
+    uint8_t values[MAX_APDU];
+} BACNET_COV_VALUE_CACHE;
+
+#ifndef MAX_COV_VALUE_CACHE
+#define MAX_COV_VALUE_CACHE 2
+#endif
+static BACNET_COV_VALUE_CACHE COV_Value_Cache[MAX_COV_VALUE_CACHE];
+/* entry replaced by the next object encoded */
+static unsigned COV_Value_Cache_Next;
+/* listOfValues of a property subscription, which is its own */
+static BACNET_COV_VALUE_CACHE COV_Property_Value;
+
 /**
  * Gets the address from the list of COV addresses
  *
@@ -264,9 +310,22 @@ static int cov_encode_subscription(
         cov_subscription->monitoredObjectIdentifier.instance);
     apdu_len += len;
     /* propertyIdentifier [1] */
-    /* FIXME: we are monitoring 2 properties! How to encode? */
-    len = encode_context_enumerated(&apdu[apdu_len], 1, PROP_PRESENT_VALUE);
-    apdu_len += len;
+    if (cov_subscription->flag.property) {
+        len = encode_context_enumerated(&apdu[apdu_len], 1,
+            cov_subscription->monitoredProperty.propertyIdentifier);
+        apdu_len += len;
+        /* propertyArrayIndex [2] */
+        if (cov_subscription->monitoredProperty.propertyArrayIndex !=
+            BACNET_ARRAY_ALL) {
+            len = encode_context_unsigned(&apdu[apdu_len], 2,
+                cov_subscription->monitoredProperty.propertyArrayIndex);
+            apdu_len += len;
+        }
+    } else {
+        /* FIXME: we are monitoring 2 properties! How to encode? */
+        len = encode_context_enumerated(&apdu[apdu_len], 1, PROP_PRESENT_VALUE);
+        apdu_len += len;
+    }
     /* MonitoredPropertyReference [1] - closing */
     len = encode_closing_tag(&apdu[apdu_len], 1);
     apdu_len += len;
@@ -278,6 +337,13 @@ static int cov_encode_subscription(
     len =
         encode_context_unsigned(&apdu[apdu_len], 3, cov_subscription->lifetime);
     apdu_len += len;
+    /* COVIncrement [4] REAL OPTIONAL */
+    if (cov_subscription->flag.property &&
+        cov_subscription->flag.covIncrementPresent) {
+        len = encode_context_real(
+            &apdu[apdu_len], 4, cov_subscription->covIncrement);
+        apdu_len += len;
+    }
 
     return apdu_len;
 }
@@ -335,10 +401,175 @@ void handler_cov_init(void)
         COV_Subscriptions[index].invokeID = 0;
         COV_Subscriptions[index].lifetime = 0;
         COV_Subscriptions[index].flag.send_requested = false;
+        COV_Subscriptions[index].flag.property = false;
+        COV_Subscriptions[index].flag.covIncrementPresent = false;
     }
     for (index = 0; index < MAX_COV_ADDRESSES; index++) {
         COV_Addresses[index].valid = false;
     }
+    for (index = 0; index < MAX_COV_LOCAL_SUBSCRIPTIONS; index++) {
+        COV_Local_Subscriptions[index].count = 0;
+        COV_Local_Subscriptions[index].send_requested = false;
+    }
+}
+
+/**
+ * @brief Add or remove a local subscriber to the COV of an object in
+ *  this device.  Local subscriptions are reference counted and are
+ *  reported to the local COV notification callbacks.
+ * @param object_type - type of the monitored object
+ * @param object_instance - instance of the monitored object
+ * @param subscribe - true to add a subscriber, false to remove one
+ * @return true if the subscription was added or removed
+ */
+bool handler_cov_local_subscribe(BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    bool subscribe)
+{
+    BACNET_COV_LOCAL_SUBSCRIPTION *local = NULL;
+    unsigned index = 0;
+
+    for (index = 0; index < MAX_COV_LOCAL_SUBSCRIPTIONS; index++) {
+        if ((COV_Local_Subscriptions[index].count) &&
+            (COV_Local_Subscriptions[index].monitoredObjectIdentifier.type ==
+                object_type) &&
+            (COV_Local_Subscriptions[index]
+                    .monitoredObjectIdentifier.instance == object_instance)) {
+            local = &COV_Local_Subscriptions[index];
+            break;
+        }
+    }
+    if (!subscribe) {
+        if (!local) {
+            return false;
+        }
+        local->count--;
+        if (local->count == 0) {
+            local->send_requested = false;
+        }
+        return true;
+    }
+    if (!local) {
+        if (!Device_Value_List_Supported(object_type)) {
+            return false;
+        }
+        for (index = 0; index < MAX_COV_LOCAL_SUBSCRIPTIONS; index++) {
+            if (COV_Local_Subscriptions[index].count == 0) {
+                local = &COV_Local_Subscriptions[index];
+                local->monitoredObjectIdentifier.type = object_type;
+                local->monitoredObjectIdentifier.instance = object_instance;
+                local->send_requested = false;
+                break;
+            }
+        }
+        if (!local) {
+            return false;
+        }
+    }
+    local->count++;
+
+    return true;
+}
+
+/**
+ * @brief Add a local COV notification callback.  The callback is given
+ *  the values of a locally subscribed object each time the object
+ *  reports a change of value, with the subscriber process identifier
+ *  set to zero.
+ * @param cb - COV notification callback to be added
+ */
+void handler_cov_local_notification_add(BACNET_COV_NOTIFICATION *cb)
+{
+    BACNET_COV_NOTIFICATION *head;
+
+    head = &COV_Local_Notification_Head;
+    do {
+        if (head->next == cb) {
+            /* already here! */
+            break;
+        } else if (!head->next) {
+            /* first available free node */
+            head->next = cb;
+            break;
+        }
+        head = head->next;
+    } while (head);
+}
+
+/**
+ * @brief Mark the local subscriptions where the value has changed
+ */
+static void cov_local_mark(void)
+{
+    BACNET_COV_LOCAL_SUBSCRIPTION *local;
+    unsigned index = 0;
+
+    for (index = 0; index < MAX_COV_LOCAL_SUBSCRIPTIONS; index++) {
+        local = &COV_Local_Subscriptions[index];
+        if ((local->count) &&
+            Device_COV(
+                (BACNET_OBJECT_TYPE)local->monitoredObjectIdentifier.type,
+                local->monitoredObjectIdentifier.instance)) {
+            local->send_requested = true;
+        }
+    }
+}
+
+/**
+ * @brief Clear the COV flag of the marked local subscriptions
+ */
+static void cov_local_clear(void)
+{
+    BACNET_COV_LOCAL_SUBSCRIPTION *local;
+    unsigned index = 0;
+
+    for (index = 0; index < MAX_COV_LOCAL_SUBSCRIPTIONS; index++) {
+        local = &COV_Local_Subscriptions[index];
+        if ((local->count) && (local->send_requested)) {
+            Device_COV_Clear(
+                (BACNET_OBJECT_TYPE)local->monitoredObjectIdentifier.type,
+                local->monitoredObjectIdentifier.instance);
+        }
+    }
+}
+
+/**
+ * @brief Give the values of the marked local subscriptions to the
+ *  local COV notification callbacks
+ */
+static void cov_local_send(void)
+{
+    BACNET_COV_LOCAL_SUBSCRIPTION *local;
+    BACNET_PROPERTY_VALUE value_list[MAX_COV_PROPERTIES];
+    BACNET_COV_NOTIFICATION *head;
+    BACNET_COV_DATA cov_data;
+    unsigned index = 0;
+
+    for (index = 0; index < MAX_COV_LOCAL_SUBSCRIPTIONS; index++) {
+        local = &COV_Local_Subscriptions[index];
+        if ((local->count == 0) || (!local->send_requested)) {
+            continue;
+        }
+        local->send_requested = false;
+        bacapp_property_value_list_init(&value_list[0], MAX_COV_PROPERTIES);
+        if (!Device_Encode_Value_List(
+                (BACNET_OBJECT_TYPE)local->monitoredObjectIdentifier.type,
+                local->monitoredObjectIdentifier.instance, &value_list[0])) {
+            continue;
+        }
+        cov_data.subscriberProcessIdentifier = 0;
+        cov_data.initiatingDeviceIdentifier = Device_Object_Instance_Number();
+        cov_data.monitoredObjectIdentifier = local->monitoredObjectIdentifier;
+        cov_data.timeRemaining = 0;
+        cov_data.listOfValues = &value_list[0];
+        head = COV_Local_Notification_Head.next;
+        while (head) {
+            if (head->callback) {
+                head->callback(&cov_data);
+            }
+            head = head->next;
+        }
+    }
 }
 
 static bool cov_list_subscribe(BACNET_ADDRESS *src,
@@ -372,6 +603,15 @@ static bool cov_list_subscribe(BACNET_ADDRESS *src,
                     cov_data->monitoredObjectIdentifier.instance) &&
                 (COV_Subscriptions[index].subscriberProcessIdentifier ==
                     cov_data->subscriberProcessIdentifier) &&
+                (COV_Subscriptions[index].flag.property ==
+                    cov_data->covSubscribeToProperty) &&
+                (!cov_data->covSubscribeToProperty ||
+                    ((COV_Subscriptions[index]
+                             .monitoredProperty.propertyIdentifier ==
+                         cov_data->monitoredProperty.propertyIdentifier) &&
+                        (COV_Subscriptions[index]
+                                .monitoredProperty.propertyArrayIndex ==
+                            cov_data->monitoredProperty.propertyArrayIndex))) &&
                 address_match) {
                 existing_entry = true;
                 if (cov_data->cancellationRequest) {
@@ -384,6 +624,10 @@ static bool cov_list_subscribe(BACNET_ADDRESS *src,
                     COV_Subscriptions[index].flag.issueConfirmedNotifications =
                         cov_data->issueConfirmedNotifications;
                     COV_Subscriptions[index].lifetime = cov_data->lifetime;
+                    COV_Subscriptions[index].flag.covIncrementPresent =
+                        cov_data->covIncrementPresent;
+                    COV_Subscriptions[index].covIncrement =
+                        cov_data->covIncrement;
                     COV_Subscriptions[index].flag.send_requested = true;
                 }
                 if (COV_Subscriptions[index].invokeID) {
@@ -414,6 +658,12 @@ static bool cov_list_subscribe(BACNET_ADDRESS *src,
             cov_data->issueConfirmedNotifications;
         COV_Subscriptions[index].invokeID = 0;
         COV_Subscriptions[index].lifetime = cov_data->lifetime;
+        COV_Subscriptions[index].flag.property =
+            cov_data->covSubscribeToProperty;
+        COV_Subscriptions[index].monitoredProperty = cov_data->monitoredProperty;
+        COV_Subscriptions[index].flag.covIncrementPresent =
+            cov_data->covIncrementPresent;
+        COV_Subscriptions[index].covIncrement = cov_data->covIncrement;
         COV_Subscriptions[index].flag.send_requested = true;
     } else if (!existing_entry) {
         if (first_invalid_index < 0) {
@@ -434,8 +684,67 @@ static bool cov_list_subscribe(BACNET_ADDRESS *src,
     return found;
 }
 
-static bool cov_send_request(BACNET_COV_SUBSCRIPTION *cov_subscription,
-    BACNET_PROPERTY_VALUE *value_list)
+/**
+ * Forgets the encoded listOfValues of every object, so the next
+ * notification of each object reads its values again.
+ */
+static void cov_value_cache_clear(void)
+{
+    unsigned index = 0;
+
+    for (index = 0; index < MAX_COV_VALUE_CACHE; index++) {
+        COV_Value_Cache[index].valid = false;
+    }
+}
+
+/**
+ * Gets the encoded listOfValues of an object, reading and encoding
+ * its values only if they are not already encoded in this pass.
+ *
+ * @param object_type - type of the monitored object
+ * @param object_instance - instance of the monitored object
+ * @return the encoded listOfValues, or NULL if the values could not
+ *  be read or do not fit in an APDU
+ */
+static BACNET_COV_VALUE_CACHE *cov_value_cache_encode(
+    BACNET_OBJECT_TYPE object_type, uint32_t object_instance)
+{
+    BACNET_PROPERTY_VALUE value_list[MAX_COV_PROPERTIES];
+    BACNET_COV_VALUE_CACHE *cache = NULL;
+    unsigned index = 0;
+    int len = 0;
+
+    for (index = 0; index < MAX_COV_VALUE_CACHE; index++) {
+        cache = &COV_Value_Cache[index];
+        if (cache->valid &&
+            (cache->monitoredObjectIdentifier.type == object_type) &&
+            (cache->monitoredObjectIdentifier.instance == object_instance)) {
+            return cache;
+        }
+    }
+    /* configure the linked list for the two properties */
+    bacapp_property_value_list_init(&value_list[0], MAX_COV_PROPERTIES);
+    if (!Device_Encode_Value_List(
+            object_type, object_instance, &value_list[0])) {
+        return NULL;
+    }
+    len = cov_notify_value_list_encode(NULL, &value_list[0]);
+    if ((len <= 0) || (len > MAX_APDU)) {
+        return NULL;
+    }
+    cache = &COV_Value_Cache[COV_Value_Cache_Next];
+    COV_Value_Cache_Next = (COV_Value_Cache_Next + 1) % MAX_COV_VALUE_CACHE;
+    cache->monitoredObjectIdentifier.type = object_type;
+    cache->monitoredObjectIdentifier.instance = object_instance;
+    cache->values_len =
+        (unsigned)cov_notify_value_list_encode(&cache->values[0], &value_list[0]);
+    cache->valid = true;
+
+    return cache;
+}
+
+static bool cov_send_request(
+    BACNET_COV_SUBSCRIPTION *cov_subscription, BACNET_COV_VALUE_CACHE *cache)
 {
     int len = 0;
     int pdu_len = 0;
@@ -453,7 +762,7 @@ static bool cov_send_request(BACNET_COV_SUBSCRIPTION *cov_subscription,
 #if PRINT_ENABLED
     fprintf(stderr, "COVnotification: requested\n");
 #endif
-    if (!cov_subscription) {
+    if (!cov_subscription || !cache) {
         return status;
     }
     dest = cov_address_get(cov_subscription->dest_index);
@@ -476,21 +785,23 @@ static bool cov_send_request(BACNET_COV_SUBSCRIPTION *cov_subscription,
     cov_data.monitoredObjectIdentifier.instance =
         cov_subscription->monitoredObjectIdentifier.instance;
     cov_data.timeRemaining = cov_subscription->lifetime;
-    cov_data.listOfValues = value_list;
+    cov_data.listOfValues = NULL;
     if (cov_subscription->flag.issueConfirmedNotifications) {
         npdu_data.data_expecting_reply = true;
         invoke_id = tsm_next_free_invokeID();
         if (invoke_id) {
             cov_subscription->invokeID = invoke_id;
-            len = ccov_notify_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            len = ccov_notify_encode_apdu_values(
+                &Handler_Transmit_Buffer[pdu_len],
                 sizeof(Handler_Transmit_Buffer) - pdu_len, invoke_id,
-                &cov_data);
+                &cov_data, &cache->values[0], cache->values_len);
         } else {
             goto COV_FAILED;
         }
     } else {
-        len = ucov_notify_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
-            sizeof(Handler_Transmit_Buffer) - pdu_len, &cov_data);
+        len = ucov_notify_encode_apdu_values(&Handler_Transmit_Buffer[pdu_len],
+            sizeof(Handler_Transmit_Buffer) - pdu_len, &cov_data,
+            &cache->values[0], cache->values_len);
     }
     pdu_len += len;
     if (cov_subscription->flag.issueConfirmedNotifications) {
@@ -511,6 +822,293 @@ COV_FAILED:
     return status;
 }
 
+/**
+ * Hashes encoded values with 32-bit FNV-1a
+ *
+ * @param hash - hash of the values before these
+ * @param data - the encoded values
+ * @param data_len - number of bytes of values
+ * @return the hash including these values
+ */
+static uint32_t cov_property_hash(uint32_t hash, uint8_t *data, int data_len)
+{
+    int i;
+
+    for (i = 0; i < data_len; i++) {
+        hash ^= data[i];
+        hash *= 16777619UL;
+    }
+
+    return hash;
+}
+
+/**
+ * Encodes one property of the monitored object as a BACnetPropertyValue
+ *
+ * @param apdu - buffer for the encoding
+ * @param apdu_size - number of bytes in the buffer
+ * @param object - the monitored object
+ * @param property - property and array index to encode
+ * @param rpdata - filled with the application data of the value, or
+ *  the error if it could not be read
+ * @return bytes encoded, or zero if the property could not be read
+ */
+static int cov_property_value_encode(uint8_t *apdu,
+    int apdu_size,
+    BACNET_OBJECT_ID *object,
+    BACNET_PROPERTY_REFERENCE *property,
+    BACNET_READ_PROPERTY_DATA *rpdata)
+{
+    int len = 0;
+    int apdu_len = 0;
+
+    /* propertyIdentifier, propertyArrayIndex, opening and closing tags */
+    if (apdu_size < 16) {
+        return 0;
+    }
+    len = encode_context_enumerated(&apdu[apdu_len], 0,
+        property->propertyIdentifier);
+    apdu_len += len;
+    if (property->propertyArrayIndex != BACNET_ARRAY_ALL) {
+        len = encode_context_unsigned(
+            &apdu[apdu_len], 1, property->propertyArrayIndex);
+        apdu_len += len;
+    }
+    len = encode_opening_tag(&apdu[apdu_len], 2);
+    apdu_len += len;
+    rpdata->object_type = (BACNET_OBJECT_TYPE)object->type;
+    rpdata->object_instance = object->instance;
+    rpdata->object_property = property->propertyIdentifier;
+    rpdata->array_index = property->propertyArrayIndex;
+    rpdata->application_data = &apdu[apdu_len];
+    /* leave room for the closing tag */
+    rpdata->application_data_len = apdu_size - apdu_len - 1;
+    len = Device_Read_Property(rpdata);
+    if (len < 0) {
+        return 0;
+    }
+    rpdata->application_data_len = len;
+    apdu_len += len;
+    len = encode_closing_tag(&apdu[apdu_len], 2);
+    apdu_len += len;
+
+    return apdu_len;
+}
+
+/**
+ * Encodes the listOfValues of a property subscription - the monitored
+ * property and the Status_Flags of the object, if it has them - into
+ * COV_Property_Value.
+ *
+ * @param cov_subscription - the property subscription
+ * @param hash - filled with a hash of the Status_Flags, and of the
+ *  value if it is not a REAL
+ * @param real_value - filled with the value if it is a REAL
+ * @param real_present - filled with true if the value is a REAL
+ * @param error_class - filled with the error class if not encoded
+ * @param error_code - filled with the error code if not encoded
+ * @return true if the monitored property was read and encoded
+ */
+static bool cov_property_encode(BACNET_COV_SUBSCRIPTION *cov_subscription,
+    uint32_t *hash,
+    float *real_value,
+    bool *real_present,
+    BACNET_ERROR_CLASS *error_class,
+    BACNET_ERROR_CODE *error_code)
+{
+    BACNET_READ_PROPERTY_DATA rpdata = { 0 };
+    BACNET_PROPERTY_REFERENCE status_flags = { 0 };
+    BACNET_COV_VALUE_CACHE *cache = &COV_Property_Value;
+    uint8_t *apdu = &cache->values[0];
+    uint8_t tag_number = 0;
+    uint32_t len_value = 0;
+    int apdu_len = 0;
+    int len = 0;
+
+    *hash = 2166136261UL;
+    *real_present = false;
+    cache->valid = false;
+    len = encode_opening_tag(&apdu[apdu_len], 4);
+    apdu_len += len;
+    len = cov_property_value_encode(&apdu[apdu_len],
+        MAX_APDU - apdu_len - 1, &cov_subscription->monitoredObjectIdentifier,
+        &cov_subscription->monitoredProperty, &rpdata);
+    if (len <= 0) {
+        if (error_class) {
+            *error_class = rpdata.error_class;
+        }
+        if (error_code) {
+            *error_code = rpdata.error_code;
+        }
+        return false;
+    }
+    apdu_len += len;
+    if (rpdata.application_data_len == 5) {
+        len = decode_tag_number_and_value(
+            rpdata.application_data, &tag_number, &len_value);
+        if (!IS_CONTEXT_SPECIFIC(rpdata.application_data[0]) &&
+            (tag_number == BACNET_APPLICATION_TAG_REAL) && (len_value == 4)) {
+            (void)decode_real(&rpdata.application_data[len], real_value);
+            *real_present = true;
+        }
+    }
+    if (!*real_present) {
+        *hash = cov_property_hash(
+            *hash, rpdata.application_data, rpdata.application_data_len);
+    }
+    if (cov_subscription->monitoredProperty.propertyIdentifier !=
+        PROP_STATUS_FLAGS) {
+        status_flags.propertyIdentifier = PROP_STATUS_FLAGS;
+        status_flags.propertyArrayIndex = BACNET_ARRAY_ALL;
+        len = cov_property_value_encode(&apdu[apdu_len],
+            MAX_APDU - apdu_len - 1,
+            &cov_subscription->monitoredObjectIdentifier, &status_flags,
+            &rpdata);
+        if (len > 0) {
+            *hash = cov_property_hash(
+                *hash, rpdata.application_data, rpdata.application_data_len);
+            apdu_len += len;
+        }
+    }
+    len = encode_closing_tag(&apdu[apdu_len], 4);
+    apdu_len += len;
+    cache->monitoredObjectIdentifier =
+        cov_subscription->monitoredObjectIdentifier;
+    cache->values_len = (unsigned)apdu_len;
+    cache->valid = true;
+
+    return true;
+}
+
+/**
+ * Gets the increment that a REAL property must change by to be
+ * notified: the increment of the subscription, or else the
+ * COV_Increment of the object for its Present_Value, or else any change.
+ *
+ * @param cov_subscription - the property subscription
+ * @return the increment
+ */
+static float cov_property_increment(BACNET_COV_SUBSCRIPTION *cov_subscription)
+{
+    BACNET_READ_PROPERTY_DATA rpdata = { 0 };
+    uint8_t apdu[16] = { 0 };
+    uint8_t tag_number = 0;
+    uint32_t len_value = 0;
+    float increment = 0.0f;
+    int len = 0;
+
+    if (cov_subscription->flag.covIncrementPresent) {
+        return cov_subscription->covIncrement;
+    }
+    if (cov_subscription->monitoredProperty.propertyIdentifier ==
+        PROP_PRESENT_VALUE) {
+        rpdata.object_type = (BACNET_OBJECT_TYPE)
+                                 cov_subscription->monitoredObjectIdentifier.type;
+        rpdata.object_instance =
+            cov_subscription->monitoredObjectIdentifier.instance;
+        rpdata.object_property = PROP_COV_INCREMENT;
+        rpdata.array_index = BACNET_ARRAY_ALL;
+        rpdata.application_data = &apdu[0];
+        rpdata.application_data_len = sizeof(apdu);
+        if (Device_Read_Property(&rpdata) == 5) {
+            len = decode_tag_number_and_value(
+                &apdu[0], &tag_number, &len_value);
+            if (tag_number == BACNET_APPLICATION_TAG_REAL) {
+                (void)decode_real(&apdu[len], &increment);
+            }
+        }
+    }
+
+    return increment;
+}
+
+/**
+ * Determines if the monitored property of a property subscription
+ * has changed by the increment of that subscription, or its
+ * Status_Flags have changed, since it was last notified.
+ *
+ * @param cov_subscription - the property subscription
+ * @param readable - filled with false if the monitored property can
+ *  no longer be read
+ * @return true if a notification is to be sent
+ */
+static bool cov_property_changed(
+    BACNET_COV_SUBSCRIPTION *cov_subscription, bool *readable)
+{
+    uint32_t hash = 0;
+    float value = 0.0f;
+    float delta = 0.0f;
+    bool real_present = false;
+
+    *readable = cov_property_encode(
+        cov_subscription, &hash, &value, &real_present, NULL, NULL);
+    if (!*readable) {
+        return false;
+    }
+    if (hash != cov_subscription->lastHash) {
+        return true;
+    }
+    if (real_present) {
+        delta = value - cov_subscription->lastValue;
+        if (delta < 0.0f) {
+            delta = -delta;
+        }
+        if ((delta > 0.0f) &&
+            (delta >= cov_property_increment(cov_subscription))) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Sends the notification of a property subscription, and keeps the
+ * value notified to detect the next change.
+ *
+ * @param cov_subscription - the property subscription
+ * @return true if the notification was sent
+ */
+static bool cov_property_send(BACNET_COV_SUBSCRIPTION *cov_subscription)
+{
+    uint32_t hash = 0;
+    float value = 0.0f;
+    bool real_present = false;
+    bool status = false;
+
+    if (!cov_property_encode(
+            cov_subscription, &hash, &value, &real_present, NULL, NULL)) {
+        return false;
+    }
+    status = cov_send_request(cov_subscription, &COV_Property_Value);
+    if (status) {
+        cov_subscription->lastHash = hash;
+        cov_subscription->lastValue = value;
+    }
+
+    return status;
+}
+
+/**
+ * Removes a subscription from the list, freeing its address and the
+ * transaction of a confirmed notification in progress.
+ *
+ * @param index - offset of the subscription in the list
+ */
+static void cov_subscription_remove(unsigned index)
+{
+    /* initialize with invalid COV address */
+    COV_Subscriptions[index].flag.valid = false;
+    COV_Subscriptions[index].dest_index = MAX_COV_ADDRESSES;
+    cov_address_remove_unused();
+    if (COV_Subscriptions[index].flag.issueConfirmedNotifications) {
+        if (COV_Subscriptions[index].invokeID) {
+            tsm_free_invoke_id(COV_Subscriptions[index].invokeID);
+            COV_Subscriptions[index].invokeID = 0;
+        }
+    }
+}
+
 static void cov_lifetime_expiration_handler(
     unsigned index, uint32_t elapsed_seconds, uint32_t lifetime_seconds)
 {
@@ -538,16 +1136,7 @@ static void cov_lifetime_expiration_handler(
                 COV_Subscriptions[index].lifetime);
             fprintf(stderr, "\n");
 #endif
-            /* initialize with invalid COV address */
-            COV_Subscriptions[index].flag.valid = false;
-            COV_Subscriptions[index].dest_index = MAX_COV_ADDRESSES;
-            cov_address_remove_unused();
-            if (COV_Subscriptions[index].flag.issueConfirmedNotifications) {
-                if (COV_Subscriptions[index].invokeID) {
-                    tsm_free_invoke_id(COV_Subscriptions[index].invokeID);
-                    COV_Subscriptions[index].invokeID = 0;
-                }
-            }
+            cov_subscription_remove(index);
         }
     }
 }
@@ -600,7 +1189,7 @@ bool handler_cov_fsm(void)
     uint32_t object_instance = 0;
     bool status = false;
     bool send = false;
-    BACNET_PROPERTY_VALUE value_list[MAX_COV_PROPERTIES];
+    bool readable = true;
     /* states for transmitting */
     static enum {
         COV_STATE_IDLE = 0,
@@ -616,13 +1205,28 @@ bool handler_cov_fsm(void)
             cov_task_state = COV_STATE_MARK;
             break;
         case COV_STATE_MARK:
+            if (index == 0) {
+                cov_local_mark();
+            }
             /* mark any subscriptions where the value has changed */
             if (COV_Subscriptions[index].flag.valid) {
                 object_type = (BACNET_OBJECT_TYPE)COV_Subscriptions[index]
                                   .monitoredObjectIdentifier.type;
                 object_instance =
                     COV_Subscriptions[index].monitoredObjectIdentifier.instance;
-                status = Device_COV(object_type, object_instance);
+                if (COV_Subscriptions[index].flag.property) {
+                    /* each subscriber has its own increment */
+                    status = cov_property_changed(
+                        &COV_Subscriptions[index], &readable);
+                    if (!readable) {
+                        /* the property, or its object, is gone: it will
+                           not be notified again, so end the subscription
+                           rather than wait for its lifetime */
+                        cov_subscription_remove(index);
+                    }
+                } else {
+                    status = Device_COV(object_type, object_instance);
+                }
                 if (status) {
                     COV_Subscriptions[index].flag.send_requested = true;
 #if PRINT_ENABLED
@@ -637,9 +1241,13 @@ bool handler_cov_fsm(void)
             }
             break;
         case COV_STATE_CLEAR:
+            if (index == 0) {
+                cov_local_clear();
+            }
             /* clear the COV flag after checking all subscriptions */
             if ((COV_Subscriptions[index].flag.valid) &&
-                (COV_Subscriptions[index].flag.send_requested)) {
+                (COV_Subscriptions[index].flag.send_requested) &&
+                (!COV_Subscriptions[index].flag.property)) {
                 object_type = (BACNET_OBJECT_TYPE)COV_Subscriptions[index]
                                   .monitoredObjectIdentifier.type;
                 object_instance =
@@ -672,6 +1280,10 @@ bool handler_cov_fsm(void)
             }
             break;
         case COV_STATE_SEND:
+            if (index == 0) {
+                cov_local_send();
+                cov_value_cache_clear();
+            }
             /* send any COVs that are requested */
             if ((COV_Subscriptions[index].flag.valid) &&
                 (COV_Subscriptions[index].flag.send_requested)) {
@@ -694,14 +1306,12 @@ bool handler_cov_fsm(void)
 #if PRINT_ENABLED
                     fprintf(stderr, "COVtask: Sending...\n");
 #endif
-                    /* configure the linked list for the two properties */
-                    bacapp_property_value_list_init(
-                        &value_list[0], MAX_COV_PROPERTIES);
-                    status = Device_Encode_Value_List(
-                        object_type, object_instance, &value_list[0]);
-                    if (status) {
-                        status = cov_send_request(
-                            &COV_Subscriptions[index], &value_list[0]);
+                    if (COV_Subscriptions[index].flag.property) {
+                        status = cov_property_send(&COV_Subscriptions[index]);
+                    } else {
+                        status = cov_send_request(&COV_Subscriptions[index],
+                            cov_value_cache_encode(
+                                object_type, object_instance));
                     }
                     if (status) {
                         COV_Subscriptions[index].flag.send_requested = false;
@@ -735,11 +1345,27 @@ static bool cov_subscribe(BACNET_ADDRESS *src,
     bool status = false; /* return value */
     BACNET_OBJECT_TYPE object_type = MAX_BACNET_OBJECT_TYPE;
     uint32_t object_instance = 0;
+    BACNET_COV_SUBSCRIPTION cov_subscription = { 0 };
+    uint32_t hash = 0;
+    float value = 0.0f;
+    bool real_present = false;
 
     object_type = (BACNET_OBJECT_TYPE)cov_data->monitoredObjectIdentifier.type;
     object_instance = cov_data->monitoredObjectIdentifier.instance;
     status = Device_Valid_Object_Id(object_type, object_instance);
-    if (status) {
+    if (status && cov_data->covSubscribeToProperty) {
+        if (!cov_data->cancellationRequest) {
+            /* any property that can be read can be monitored */
+            cov_subscription.monitoredObjectIdentifier =
+                cov_data->monitoredObjectIdentifier;
+            cov_subscription.monitoredProperty = cov_data->monitoredProperty;
+            status = cov_property_encode(&cov_subscription, &hash, &value,
+                &real_present, error_class, error_code);
+        }
+        if (status) {
+            status = cov_list_subscribe(src, cov_data, error_class, error_code);
+        }
+    } else if (status) {
         status = Device_Value_List_Supported(object_type);
         if (status) {
             status = cov_list_subscribe(src, cov_data, error_class, error_code);
@@ -755,14 +1381,12 @@ static bool cov_subscribe(BACNET_ADDRESS *src,
     return status;
 }
 
-/** Handler for a COV Subscribe Service request.
- * @ingroup DSCOV
- * This handler will be invoked by apdu_handler() if it has been enabled
- * by a call to apdu_set_confirmed_handler().
- * This handler builds a response packet, which is
+/**
+ * Handles a SubscribeCOV or SubscribeCOVProperty request.
+ * This builds a response packet, which is
  * - an Abort if
  *   - the message is segmented
- *   - if decoding fails
+ * - a Reject if decoding fails
  * - an ACK, if cov_subscribe() succeeds
  * - an Error if cov_subscribe() fails
  *
@@ -771,11 +1395,14 @@ static bool cov_subscribe(BACNET_ADDRESS *src,
  * @param src [in] BACNET_ADDRESS of the source of the message
  * @param service_data [in] The BACNET_CONFIRMED_SERVICE_DATA information
  *                          decoded from the APDU header of this message.
+ * @param service_choice [in] SERVICE_CONFIRMED_SUBSCRIBE_COV or
+ *                            SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY
  */
-void handler_cov_subscribe(uint8_t *service_request,
+static void cov_subscribe_handler(uint8_t *service_request,
     uint16_t service_len,
     BACNET_ADDRESS *src,
-    BACNET_CONFIRMED_SERVICE_DATA *service_data)
+    BACNET_CONFIRMED_SERVICE_DATA *service_data,
+    BACNET_CONFIRMED_SERVICE service_choice)
 {
     BACNET_SUBSCRIBE_COV_DATA cov_data;
     int len = 0;
@@ -803,12 +1430,25 @@ void handler_cov_subscribe(uint8_t *service_request,
 #endif
         error = true;
     } else {
-        len = cov_subscribe_decode_service_request(
-            service_request, service_len, &cov_data);
+        if (service_choice == SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY) {
+            cov_data.covSubscribeToProperty = true;
+            len = cov_subscribe_property_decode_service_request(
+                service_request, service_len, &cov_data);
+        } else {
+            cov_data.covSubscribeToProperty = false;
+            cov_data.covIncrementPresent = false;
+            cov_data.covIncrement = 0.0f;
+            len = cov_subscribe_decode_service_request(
+                service_request, service_len, &cov_data);
+        }
 #if PRINT_ENABLED
         if (len <= 0)
             fprintf(stderr, "SubscribeCOV: Unable to decode Request!\n");
 #endif
+        if (len == 0) {
+            cov_data.error_code = ERROR_CODE_REJECT_MISSING_REQUIRED_PARAMETER;
+            len = BACNET_STATUS_REJECT;
+        }
         if (len < 0) {
             error = true;
         } else {
@@ -818,7 +1458,7 @@ void handler_cov_subscribe(uint8_t *service_request,
                 src, &cov_data, &cov_data.error_class, &cov_data.error_code);
             if (success) {
                 apdu_len = encode_simple_ack(&Handler_Transmit_Buffer[npdu_len],
-                    service_data->invoke_id, SERVICE_CONFIRMED_SUBSCRIBE_COV);
+                    service_data->invoke_id, service_choice);
 #if PRINT_ENABLED
                 fprintf(stderr, "SubscribeCOV: Sending Simple Ack!\n");
 #endif
@@ -843,7 +1483,7 @@ void handler_cov_subscribe(uint8_t *service_request,
 #endif
         } else if (len == BACNET_STATUS_ERROR) {
             apdu_len = bacerror_encode_apdu(&Handler_Transmit_Buffer[npdu_len],
-                service_data->invoke_id, SERVICE_CONFIRMED_SUBSCRIBE_COV,
+                service_data->invoke_id, service_choice,
                 cov_data.error_class, cov_data.error_code);
 #if PRINT_ENABLED
             fprintf(stderr, "SubscribeCOV: Sending Error!\n");
@@ -858,7 +1498,7 @@ void handler_cov_subscribe(uint8_t *service_request,
         }
     }
     pdu_len = npdu_len + apdu_len;
-    bytes_sent = datalink_send_pdu(
+    bytes_sent = apdu_send_reply(
         src, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
     if (bytes_sent <= 0) {
 #if PRINT_ENABLED
@@ -869,3 +1509,52 @@ void handler_cov_subscribe(uint8_t *service_request,
 
     return;
 }
+
+/** Handler for a COV Subscribe Service request.
+ * @ingroup DSCOV
+ * This handler will be invoked by apdu_handler() if it has been enabled
+ * by a call to apdu_set_confirmed_handler().
+ * This handler builds a response packet, which is
+ * - an Abort if
+ *   - the message is segmented
+ *   - if decoding fails
+ * - an ACK, if cov_subscribe() succeeds
+ * - an Error if cov_subscribe() fails
+ *
+ * @param service_request [in] The contents of the service request.
+ * @param service_len [in] The length of the service_request.
+ * @param src [in] BACNET_ADDRESS of the source of the message
+ * @param service_data [in] The BACNET_CONFIRMED_SERVICE_DATA information
+ *                          decoded from the APDU header of this message.
+ */
+void handler_cov_subscribe(uint8_t *service_request,
+    uint16_t service_len,
+    BACNET_ADDRESS *src,
+    BACNET_CONFIRMED_SERVICE_DATA *service_data)
+{
+    cov_subscribe_handler(service_request, service_len, src, service_data,
+        SERVICE_CONFIRMED_SUBSCRIBE_COV);
+}
+
+/** Handler for a COV Subscribe Property Service request.
+ * @ingroup DSCOV
+ * The subscription monitors one property of the object, which is
+ * notified with the Status_Flags of the object when it changes by the
+ * COV increment of the subscription, or, if the subscription has none,
+ * by the COV_Increment of the object for its Present_Value, or else
+ * by any change.
+ *
+ * @param service_request [in] The contents of the service request.
+ * @param service_len [in] The length of the service_request.
+ * @param src [in] BACNET_ADDRESS of the source of the message
+ * @param service_data [in] The BACNET_CONFIRMED_SERVICE_DATA information
+ *                          decoded from the APDU header of this message.
+ */
+void handler_cov_subscribe_property(uint8_t *service_request,
+    uint16_t service_len,
+    BACNET_ADDRESS *src,
+    BACNET_CONFIRMED_SERVICE_DATA *service_data)
+{
+    cov_subscribe_handler(service_request, service_len, src, service_data,
+        SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY);
+}
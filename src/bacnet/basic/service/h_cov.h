@@ -36,6 +36,7 @@
 #include "bacnet/bacdef.h"
 #include "bacnet/bacenum.h"
 #include "bacnet/apdu.h"
+#include "bacnet/cov.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -48,6 +49,12 @@ extern "C" {
         BACNET_ADDRESS * src,
         BACNET_CONFIRMED_SERVICE_DATA * service_data);
     BACNET_STACK_EXPORT
+    void handler_cov_subscribe_property(
+        uint8_t * service_request,
+        uint16_t service_len,
+        BACNET_ADDRESS * src,
+        BACNET_CONFIRMED_SERVICE_DATA * service_data);
+    BACNET_STACK_EXPORT
     bool handler_cov_fsm(
         void);
     BACNET_STACK_EXPORT
@@ -60,6 +67,14 @@ extern "C" {
     void handler_cov_init(
         void);
     BACNET_STACK_EXPORT
+    bool handler_cov_local_subscribe(
+        BACNET_OBJECT_TYPE object_type,
+        uint32_t object_instance,
+        bool subscribe);
+    BACNET_STACK_EXPORT
+    void handler_cov_local_notification_add(
+        BACNET_COV_NOTIFICATION * cb);
+    BACNET_STACK_EXPORT
     int handler_cov_encode_subscriptions(
         uint8_t * apdu,
         int max_apdu);
@@ -112,7 +112,7 @@ void handler_create_object(uint8_t *service_request,
     if (len > 0) {
         /* Send PDU */
         pdu_len += len;
-        bytes_sent = datalink_send_pdu(
+        bytes_sent = apdu_send_reply(
             src, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
     }
     if (bytes_sent <= 0) {
@@ -198,7 +198,7 @@ void handler_device_communication_control(uint8_t *service_request,
     }
 DCC_ABORT:
     pdu_len += len;
-    len = datalink_send_pdu(
+    len = apdu_send_reply(
         src, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
     if (len <= 0) {
 #if PRINT_ENABLED
@@ -137,7 +137,7 @@ GET_ALARM_SUMMARY_ERROR:
 
 GET_ALARM_SUMMARY_ABORT:
     pdu_len += apdu_len;
-    bytes_sent = datalink_send_pdu(
+    bytes_sent = apdu_send_reply(
         src, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
 #if PRINT_ENABLED
     if (bytes_sent <= 0) {
@@ -109,7 +109,7 @@ void handler_add_list_element(uint8_t *service_request,
     }
     /* Send PDU */
     pdu_len += len;
-    bytes_sent = datalink_send_pdu(
+    bytes_sent = apdu_send_reply(
         src, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
     if (bytes_sent <= 0) {
         debug_perror(
@@ -200,7 +200,7 @@ void handler_remove_list_element(uint8_t *service_request,
     }
     /* Send PDU */
     pdu_len += len;
-    bytes_sent = datalink_send_pdu(
+    bytes_sent = apdu_send_reply(
         src, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
     if (bytes_sent <= 0) {
         debug_perror(
@@ -149,7 +149,7 @@ void handler_reinitialize_device(uint8_t *service_request,
     }
 RD_ABORT:
     pdu_len += len;
-    len = datalink_send_pdu(
+    len = apdu_send_reply(
         src, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
     if (len <= 0) {
 #if PRINT_ENABLED
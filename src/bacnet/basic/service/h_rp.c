@@ -214,7 +214,7 @@ void handler_read_property(uint8_t *service_request,
     }
 
     pdu_len = npdu_len + apdu_len;
-    bytes_sent = datalink_send_pdu(
+    bytes_sent = apdu_send_reply(
         src, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
     if (bytes_sent <= 0) {
 #if PRINT_ENABLED
@@ -25,16 +25,20 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include "bacnet/config.h"
 #include "bacnet/datetime.h"
 #include "bacnet/bacdef.h"
 #include "bacnet/bacdcode.h"
 #include "bacnet/timesync.h"
 #include "bacnet/bacaddr.h"
+#include "bacnet/dcc.h"
 #include "bacnet/npdu.h"
+#include "bacnet/rp.h"
 #include "bacnet/basic/object/device.h"
 #include "bacnet/basic/services.h"
 #include "bacnet/basic/tsm/tsm.h"
+#include "bacnet/datalink/datalink.h"
 
 /** @file h_ts.c  Handles TimeSync requests. */
 
@@ -47,6 +51,34 @@ BACNET_RECIPIENT_LIST Time_Sync_Recipients[MAX_TIME_SYNC_RECIPIENTS];
 /* variable used for controlling when to
    automatically send a TimeSynchronization request */
 static BACNET_DATE_TIME Next_Sync_Time;
+/* a recipient whose predicted clock offset is within this many
+   milliseconds of ours is left alone at the next sync interval */
+#ifndef BACNET_TIME_SYNC_DRIFT_THRESHOLD_MS
+#define BACNET_TIME_SYNC_DRIFT_THRESHOLD_MS 500
+#endif
+/* number of recipients needing a correction on one network
+   before a single broadcast replaces the unicast messages */
+#ifndef BACNET_TIME_SYNC_BROADCAST_MIN
+#define BACNET_TIME_SYNC_BROADCAST_MIN 4
+#endif
+/* number of sync intervals between Local_Time samples of a recipient */
+#ifndef BACNET_TIME_SYNC_SAMPLE_INTERVALS
+#define BACNET_TIME_SYNC_SAMPLE_INTERVALS 4
+#endif
+/* clock estimate for each recipient, same index as Time_Sync_Recipients */
+typedef struct time_sync_peer {
+    bool offset_valid : 1;
+    bool drift_valid : 1;
+    /* remote clock minus our clock at sample_time */
+    int32_t offset_ms;
+    /* rate of change of offset_ms */
+    int32_t drift_ms_per_hour;
+    /* our clock when offset_ms was last measured or corrected */
+    bacnet_time_t sample_time;
+    /* sync intervals since the last Local_Time sample was requested */
+    uint8_t intervals;
+} TIME_SYNC_PEER;
+static TIME_SYNC_PEER Time_Sync_Peers[MAX_TIME_SYNC_RECIPIENTS];
 #endif
 
 #if PRINT_ENABLED
@@ -152,14 +184,335 @@ bool handler_timesync_recipient_write(BACNET_WRITE_PROPERTY_DATA *wp_data)
 #endif
 
 #if defined(BACNET_TIME_MASTER)
+/**
+ * @brief Find the recipient index of an address
+ * @param src - address to find
+ * @return index of the recipient, or MAX_TIME_SYNC_RECIPIENTS if not found
+ */
+static unsigned handler_timesync_recipient_index(BACNET_ADDRESS *src)
+{
+    unsigned index = 0;
+
+    for (index = 0; index < MAX_TIME_SYNC_RECIPIENTS; index++) {
+        if ((Time_Sync_Recipients[index].tag == 1) &&
+            bacnet_address_same(
+                &Time_Sync_Recipients[index].type.address, src)) {
+            break;
+        }
+    }
+
+    return index;
+}
+
+/**
+ * @brief Predict the clock offset of a recipient from its last sample
+ *  and its estimated drift
+ * @param peer - clock estimate of the recipient
+ * @param now - our current time, in seconds since epoch
+ * @return predicted offset in milliseconds
+ */
+static int32_t handler_timesync_predicted_offset(
+    TIME_SYNC_PEER *peer, bacnet_time_t now)
+{
+    int32_t offset_ms = peer->offset_ms;
+    uint32_t elapsed_seconds = 0;
+
+    if (peer->drift_valid && (now > peer->sample_time)) {
+        elapsed_seconds = (uint32_t)(now - peer->sample_time);
+        offset_ms += (int32_t)(((int64_t)peer->drift_ms_per_hour *
+                                   (int64_t)elapsed_seconds) / 3600L);
+    }
+
+    return offset_ms;
+}
+
+/**
+ * @brief Record a clock sample from a time sync recipient
+ *
+ * Updates the offset of the recipient clock relative to ours, and
+ * the drift rate estimated from consecutive offsets.
+ *
+ * @param src - address of the device that reported its time
+ * @param remote_time - Local_Time reported by the device, corrected for
+ *  the time the report took to arrive
+ * @param local_time - our date and time when the report arrived
+ * @return true if the device is a time sync recipient
+ */
+bool handler_timesync_drift_sample(BACNET_ADDRESS *src,
+    BACNET_TIME *remote_time,
+    BACNET_DATE_TIME *local_time)
+{
+    const int32_t day_ms = 86400L * 1000L;
+    TIME_SYNC_PEER *peer = NULL;
+    bacnet_time_t now = 0;
+    int32_t offset_ms = 0;
+    int32_t drift_ms_per_hour = 0;
+    uint32_t elapsed_seconds = 0;
+    unsigned index = 0;
+
+    if (!src || !remote_time || !local_time) {
+        return false;
+    }
+    if (!datetime_time_is_valid(remote_time)) {
+        return false;
+    }
+    index = handler_timesync_recipient_index(src);
+    if (index >= MAX_TIME_SYNC_RECIPIENTS) {
+        return false;
+    }
+    peer = &Time_Sync_Peers[index];
+    offset_ms =
+        (int32_t)datetime_seconds_since_midnight(remote_time) * 1000L +
+        (int32_t)remote_time->hundredths * 10L;
+    offset_ms -=
+        (int32_t)datetime_seconds_since_midnight(&local_time->time) * 1000L +
+        (int32_t)local_time->time.hundredths * 10L;
+    /* Local_Time has no date: take the shortest way around the clock */
+    if (offset_ms > (day_ms / 2)) {
+        offset_ms -= day_ms;
+    } else if (offset_ms < -(day_ms / 2)) {
+        offset_ms += day_ms;
+    }
+    now = datetime_seconds_since_epoch(local_time);
+    if (peer->offset_valid && (now > peer->sample_time)) {
+        elapsed_seconds = (uint32_t)(now - peer->sample_time);
+        drift_ms_per_hour = (int32_t)(((int64_t)(offset_ms - peer->offset_ms) *
+                                          3600L) / (int64_t)elapsed_seconds);
+        if (peer->drift_valid) {
+            /* smooth the estimate - weight 1/4 for a new sample */
+            peer->drift_ms_per_hour +=
+                (drift_ms_per_hour - peer->drift_ms_per_hour) / 4;
+        } else {
+            peer->drift_ms_per_hour = drift_ms_per_hour;
+            peer->drift_valid = true;
+        }
+    }
+    peer->offset_ms = offset_ms;
+    peer->offset_valid = true;
+    peer->sample_time = now;
+
+    return true;
+}
+
+/**
+ * @brief Get the clock estimate of a time sync recipient
+ * @param index - recipient index
+ * @param offset_ms - [out] last measured or corrected clock offset
+ * @param drift_ms_per_hour - [out] estimated drift, or 0 if unknown
+ * @return true if an offset has been measured for the recipient
+ */
+bool handler_timesync_drift(
+    unsigned index, int32_t *offset_ms, int32_t *drift_ms_per_hour)
+{
+    TIME_SYNC_PEER *peer = NULL;
+
+    if (index >= MAX_TIME_SYNC_RECIPIENTS) {
+        return false;
+    }
+    peer = &Time_Sync_Peers[index];
+    if (offset_ms) {
+        *offset_ms = peer->offset_ms;
+    }
+    if (drift_ms_per_hour) {
+        *drift_ms_per_hour = peer->drift_valid ? peer->drift_ms_per_hour : 0;
+    }
+
+    return peer->offset_valid;
+}
+
+/**
+ * @brief Add milliseconds to a time of day, wrapping at midnight
+ * @param btime - time to change
+ * @param milliseconds - milliseconds to add
+ */
+static void handler_timesync_time_add_milliseconds(
+    BACNET_TIME *btime, uint32_t milliseconds)
+{
+    uint32_t time_ms = 0;
+
+    time_ms = datetime_seconds_since_midnight(btime) * 1000UL +
+        btime->hundredths * 10UL + milliseconds;
+    time_ms %= 86400UL * 1000UL;
+    datetime_seconds_since_midnight_into_time(time_ms / 1000UL, btime);
+    btime->hundredths = (uint8_t)((time_ms % 1000UL) / 10UL);
+}
+
+/**
+ * @brief Completes a Local_Time read of a time sync recipient, and uses
+ *  the ReadProperty-ACK as a clock sample of the recipient.
+ *
+ *  The recipient read its clock about half a round trip before the
+ *  reply arrived, so its Local_Time is advanced by half the smoothed
+ *  round trip time that the TSM measures for it.
+ * @param completion - the reply, or the timeout
+ * @param context - not used
+ */
+static void handler_timesync_local_time_complete(
+    BACNET_TSM_COMPLETION *completion, void *context)
+{
+    BACNET_READ_PROPERTY_DATA data = { 0 };
+    BACNET_DATE_TIME local_time = { 0 };
+    BACNET_TIME remote_time = { 0 };
+    uint16_t srtt = 0;
+    int len = 0;
+
+    (void)context;
+    if ((completion->result != TSM_RESULT_ACK) ||
+        (completion->service_choice != SERVICE_CONFIRMED_READ_PROPERTY) ||
+        (!completion->service_data)) {
+        return;
+    }
+    len = rp_ack_decode_service_request(
+        completion->service_data, completion->service_data_len, &data);
+    if ((len > 0) && (data.object_type == OBJECT_DEVICE) &&
+        (data.object_property == PROP_LOCAL_TIME)) {
+        len = bacnet_time_application_decode(data.application_data,
+            (uint32_t)data.application_data_len, &remote_time);
+        if (len > 0) {
+            if (tsm_peer_rtt(completion->src, &srtt, NULL, NULL)) {
+                handler_timesync_time_add_milliseconds(
+                    &remote_time, srtt / 2U);
+            }
+            Device_getCurrentDateTime(&local_time);
+            handler_timesync_drift_sample(
+                completion->src, &remote_time, &local_time);
+        }
+    }
+}
+
+/**
+ * @brief Read the Local_Time of a time sync recipient.  The reply goes
+ *  to its own transaction, and not to the ReadProperty-ACK handler.
+ * @param dest - address of the recipient
+ * @return true if the request was sent
+ */
+static bool handler_timesync_local_time_request(BACNET_ADDRESS *dest)
+{
+    BACNET_READ_PROPERTY_DATA data = { 0 };
+    BACNET_ADDRESS my_address;
+    BACNET_NPDU_DATA npdu_data;
+    uint8_t invoke_id = 0;
+    int len = 0;
+    int pdu_len = 0;
+
+    if (!dcc_communication_enabled()) {
+        return false;
+    }
+    invoke_id = tsm_next_free_invokeID_async(
+        dest, handler_timesync_local_time_complete, NULL);
+    if (invoke_id == 0) {
+        return false;
+    }
+    data.object_type = OBJECT_DEVICE;
+    data.object_instance = BACNET_MAX_INSTANCE;
+    data.object_property = PROP_LOCAL_TIME;
+    data.array_index = BACNET_ARRAY_ALL;
+    datalink_get_my_address(&my_address);
+    npdu_encode_npdu_data(&npdu_data, true, MESSAGE_PRIORITY_NORMAL);
+    pdu_len = npdu_encode_pdu(
+        &Handler_Transmit_Buffer[0], dest, &my_address, &npdu_data);
+    len = rp_encode_apdu(&Handler_Transmit_Buffer[pdu_len], invoke_id, &data);
+    pdu_len += len;
+    if ((len <= 0) || ((unsigned)pdu_len >= MAX_APDU)) {
+        /* will not fit in the destination */
+        tsm_cancel_invoke_id(invoke_id, dest, NULL);
+        return false;
+    }
+    tsm_set_confirmed_unsegmented_transaction(invoke_id, dest, &npdu_data,
+        &Handler_Transmit_Buffer[0], (uint16_t)pdu_len);
+    (void)datalink_send_pdu(
+        dest, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
+
+    return true;
+}
+
+/**
+ * @brief Send TimeSynchronization to recipients whose clocks are
+ *  predicted to be off, and request fresh Local_Time samples.
+ *
+ *  Recipients without an estimate are always synchronized. When
+ *  several recipients on the same network need a correction, one
+ *  broadcast to that network is sent instead of a unicast to each.
+ *
+ * @param current_date_time - our date and time
+ */
 static void handler_timesync_send(BACNET_DATE_TIME *current_date_time)
 {
+    bool correct[MAX_TIME_SYNC_RECIPIENTS] = { false };
+    BACNET_ADDRESS dest = { 0 };
+    BACNET_ADDRESS *address = NULL;
+    TIME_SYNC_PEER *peer = NULL;
+    bacnet_time_t now = 0;
+    int32_t offset_ms = 0;
     unsigned index = 0;
+    unsigned other = 0;
+    unsigned count = 0;
 
+    now = datetime_seconds_since_epoch(current_date_time);
     for (index = 0; index < MAX_TIME_SYNC_RECIPIENTS; index++) {
-        if (Time_Sync_Recipients[index].tag == 1) {
-            Send_TimeSync_Remote(&Time_Sync_Recipients[index].type.address,
-                &current_date_time->date, &current_date_time->time);
+        if (Time_Sync_Recipients[index].tag != 1) {
+            continue;
+        }
+        peer = &Time_Sync_Peers[index];
+        if (peer->offset_valid) {
+            offset_ms = handler_timesync_predicted_offset(peer, now);
+            if ((offset_ms > BACNET_TIME_SYNC_DRIFT_THRESHOLD_MS) ||
+                (offset_ms < -BACNET_TIME_SYNC_DRIFT_THRESHOLD_MS)) {
+                correct[index] = true;
+            }
+        } else {
+            correct[index] = true;
+        }
+    }
+    for (index = 0; index < MAX_TIME_SYNC_RECIPIENTS; index++) {
+        if (!correct[index]) {
+            continue;
+        }
+        address = &Time_Sync_Recipients[index].type.address;
+        count = 0;
+        for (other = index; other < MAX_TIME_SYNC_RECIPIENTS; other++) {
+            if (correct[other] &&
+                (Time_Sync_Recipients[other].type.address.net ==
+                    address->net)) {
+                count++;
+            }
+        }
+        if (count >= BACNET_TIME_SYNC_BROADCAST_MIN) {
+            datalink_get_broadcast_address(&dest);
+            /* a local broadcast for recipients on our own network */
+            dest.net = address->net;
+            Send_TimeSync_Remote(
+                &dest, &current_date_time->date, &current_date_time->time);
+            /* the broadcast reached every recipient on that network */
+            for (other = 0; other < MAX_TIME_SYNC_RECIPIENTS; other++) {
+                if ((Time_Sync_Recipients[other].tag == 1) &&
+                    (Time_Sync_Recipients[other].type.address.net ==
+                        address->net)) {
+                    correct[other] = false;
+                    Time_Sync_Peers[other].offset_ms = 0;
+                    Time_Sync_Peers[other].sample_time = now;
+                }
+            }
+        } else {
+            Send_TimeSync_Remote(
+                address, &current_date_time->date, &current_date_time->time);
+            correct[index] = false;
+            Time_Sync_Peers[index].offset_ms = 0;
+            Time_Sync_Peers[index].sample_time = now;
+        }
+    }
+    /* a fresh Local_Time sample of each recipient every
+       BACNET_TIME_SYNC_SAMPLE_INTERVALS sync intervals */
+    for (index = 0; index < MAX_TIME_SYNC_RECIPIENTS; index++) {
+        if (Time_Sync_Recipients[index].tag != 1) {
+            continue;
+        }
+        peer = &Time_Sync_Peers[index];
+        if (peer->intervals) {
+            peer->intervals--;
+        } else if (handler_timesync_local_time_request(
+                       &Time_Sync_Recipients[index].type.address)) {
+            peer->intervals = BACNET_TIME_SYNC_SAMPLE_INTERVALS - 1;
         }
     }
 }
@@ -233,6 +586,7 @@ bool handler_timesync_recipient_address_set(
     if (address && (index < MAX_TIME_SYNC_RECIPIENTS)) {
         Time_Sync_Recipients[index].tag = 1;
         bacnet_address_copy(&Time_Sync_Recipients[index].type.address, address);
+        memset(&Time_Sync_Peers[index], 0, sizeof(Time_Sync_Peers[index]));
         status = true;
     }
 
@@ -273,5 +627,6 @@ void handler_timesync_init(void)
     for (i = 0; i < MAX_TIME_SYNC_RECIPIENTS; i++) {
         Time_Sync_Recipients[i].tag = 0xFF;
     }
+    memset(Time_Sync_Peers, 0, sizeof(Time_Sync_Peers));
 }
 #endif
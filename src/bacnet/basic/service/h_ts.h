@@ -81,6 +81,16 @@ extern "C" {
     bool handler_timesync_recipient_address_set(
         unsigned index,
         BACNET_ADDRESS * address);
+    BACNET_STACK_EXPORT
+    bool handler_timesync_drift_sample(
+        BACNET_ADDRESS * src,
+        BACNET_TIME * remote_time,
+        BACNET_DATE_TIME * local_time);
+    BACNET_STACK_EXPORT
+    bool handler_timesync_drift(
+        unsigned index,
+        int32_t * offset_ms,
+        int32_t * drift_ms_per_hour);
 
 #ifdef __cplusplus
 }
@@ -192,7 +192,7 @@ void handler_write_property_multiple(uint8_t *service_request,
         }
     }
     pdu_len = npdu_len + apdu_len;
-    bytes_sent = datalink_send_pdu(
+    bytes_sent = apdu_send_reply(
         src, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
     if (bytes_sent <= 0) {
         PRINTF("Failed to send PDU (%s)!\n", strerror(errno));
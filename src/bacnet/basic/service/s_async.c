@@ -0,0 +1,348 @@
+/**
+ * @file
+ * @brief Send confirmed requests whose replies go to a callback
+ *
+ * @section DESCRIPTION
+ *
+ * A request record, taken from a free list, holds the device, the
+ * callback and the context of each request in flight, and is given to
+ * the transaction state machine as the context of its completion.
+ * There is a record for every transaction, so the records never run
+ * out before the transactions do.
+ *
+ * @section LICENSE
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "bacnet/config.h"
+#include "bacnet/bacdef.h"
+#include "bacnet/npdu.h"
+#include "bacnet/apdu.h"
+#include "bacnet/dcc.h"
+#include "bacnet/readrange.h"
+#include "bacnet/rp.h"
+#include "bacnet/wp.h"
+#include "bacnet/datalink/datalink.h"
+#include "bacnet/basic/binding/address.h"
+#include "bacnet/basic/tsm/tsm.h"
+#include "bacnet/basic/service/s_async.h"
+
+#if (MAX_TSM_TRANSACTIONS)
+typedef struct bacnet_async_request {
+    uint32_t device_id;
+    bacnet_rp_async_callback rp_callback;
+    bacnet_wp_async_callback wp_callback;
+    bacnet_rr_async_callback rr_callback;
+    void *context;
+    /* next free record */
+    struct bacnet_async_request *next;
+} BACNET_ASYNC_REQUEST;
+
+static BACNET_ASYNC_REQUEST Async_Request[MAX_TSM_TRANSACTIONS];
+static BACNET_ASYNC_REQUEST *Async_Free;
+static bool Async_Initialized;
+
+/**
+ * Takes a request record from the free list
+ *
+ * @return the request record, or NULL if none are free
+ */
+static BACNET_ASYNC_REQUEST *bacnet_async_request_alloc(void)
+{
+    BACNET_ASYNC_REQUEST *request;
+    unsigned i;
+
+    if (!Async_Initialized) {
+        Async_Free = NULL;
+        for (i = MAX_TSM_TRANSACTIONS; i > 0; i--) {
+            Async_Request[i - 1].next = Async_Free;
+            Async_Free = &Async_Request[i - 1];
+        }
+        Async_Initialized = true;
+    }
+    request = Async_Free;
+    if (request) {
+        Async_Free = request->next;
+        request->next = NULL;
+    }
+
+    return request;
+}
+
+/**
+ * Returns a request record to the free list
+ *
+ * @param request - the request record
+ */
+static void bacnet_async_request_free(BACNET_ASYNC_REQUEST *request)
+{
+    if (request) {
+        request->rp_callback = NULL;
+        request->wp_callback = NULL;
+        request->rr_callback = NULL;
+        request->context = NULL;
+        request->next = Async_Free;
+        Async_Free = request;
+    }
+}
+
+/**
+ * Completion of a request, called by the transaction state machine
+ *
+ * @param completion - how the request ended, and the reply
+ * @param context - the request record
+ */
+static void bacnet_async_complete(
+    BACNET_TSM_COMPLETION *completion, void *context)
+{
+    BACNET_ASYNC_REQUEST request = *(BACNET_ASYNC_REQUEST *)context;
+    BACNET_READ_PROPERTY_DATA rp_data = { 0 };
+    BACNET_READ_PROPERTY_DATA *pData = NULL;
+    BACNET_READ_RANGE_DATA rr_data = { 0 };
+    BACNET_READ_RANGE_DATA *pRange = NULL;
+    int len;
+
+    /* free first, so the callback can send another request */
+    bacnet_async_request_free(context);
+    if (request.rp_callback) {
+        if ((completion->result == TSM_RESULT_ACK) &&
+            (completion->service_choice == SERVICE_CONFIRMED_READ_PROPERTY) &&
+            completion->service_data) {
+            len = rp_ack_decode_service_request(completion->service_data,
+                completion->service_data_len, &rp_data);
+            if (len > 0) {
+                pData = &rp_data;
+            }
+        }
+        request.rp_callback(
+            request.context, request.device_id, completion, pData);
+    } else if (request.wp_callback) {
+        request.wp_callback(request.context, request.device_id, completion);
+    } else if (request.rr_callback) {
+        if ((completion->result == TSM_RESULT_ACK) &&
+            (completion->service_choice == SERVICE_CONFIRMED_READ_RANGE) &&
+            completion->service_data) {
+            len = rr_ack_decode_service_request(completion->service_data,
+                completion->service_data_len, &rr_data);
+            if (len > 0) {
+                pRange = &rr_data;
+            }
+        }
+        request.rr_callback(
+            request.context, request.device_id, completion, pRange);
+    }
+}
+
+/**
+ * Encodes and sends a confirmed request
+ *
+ * @param request - the request record
+ * @param service - SERVICE_CONFIRMED_READ_PROPERTY, _WRITE_PROPERTY
+ *  or _READ_RANGE
+ * @param data - the request data of that service
+ * @return invoke id of the request, or 0 if not sent
+ */
+static uint8_t bacnet_async_send(
+    BACNET_ASYNC_REQUEST *request, uint8_t service, void *data)
+{
+    BACNET_ADDRESS dest = { 0 };
+    BACNET_ADDRESS my_address;
+    BACNET_NPDU_DATA npdu_data;
+    unsigned max_apdu = 0;
+    uint8_t invoke_id = 0;
+    int len = 0;
+    int pdu_len = 0;
+
+    if (!dcc_communication_enabled()) {
+        return 0;
+    }
+    /* is the device bound? */
+    if (!address_get_by_device(request->device_id, &max_apdu, &dest)) {
+        return 0;
+    }
+    invoke_id =
+        tsm_next_free_invokeID_async(&dest, bacnet_async_complete, request);
+    if (invoke_id == 0) {
+        return 0;
+    }
+    datalink_get_my_address(&my_address);
+    npdu_encode_npdu_data(&npdu_data, true, MESSAGE_PRIORITY_NORMAL);
+    pdu_len = npdu_encode_pdu(
+        &Handler_Transmit_Buffer[0], &dest, &my_address, &npdu_data);
+    switch (service) {
+        case SERVICE_CONFIRMED_READ_PROPERTY:
+            len = rp_encode_apdu(
+                &Handler_Transmit_Buffer[pdu_len], invoke_id, data);
+            break;
+        case SERVICE_CONFIRMED_WRITE_PROPERTY:
+            len = wp_encode_apdu(
+                &Handler_Transmit_Buffer[pdu_len], invoke_id, data);
+            break;
+        case SERVICE_CONFIRMED_READ_RANGE:
+            len = rr_encode_apdu(
+                &Handler_Transmit_Buffer[pdu_len], invoke_id, data);
+            break;
+        default:
+            break;
+    }
+    pdu_len += len;
+    if ((len <= 0) || ((unsigned)pdu_len >= max_apdu)) {
+        /* will not fit in the destination */
+        tsm_cancel_invoke_id(invoke_id, &dest, NULL);
+        return 0;
+    }
+    tsm_set_confirmed_unsegmented_transaction(invoke_id, &dest, &npdu_data,
+        &Handler_Transmit_Buffer[0], (uint16_t)pdu_len);
+    (void)datalink_send_pdu(
+        &dest, &npdu_data, &Handler_Transmit_Buffer[0], pdu_len);
+
+    return invoke_id;
+}
+
+/**
+ * Sends a ReadProperty request whose reply goes to a callback
+ *
+ * @param device_id [in] ID of the destination device, which is bound
+ * @param object_type [in] Type of the object whose property is read
+ * @param object_instance [in] Instance # of the object to be read
+ * @param object_property [in] Property to be read
+ * @param array_index [in] array index, or BACNET_ARRAY_ALL
+ * @param callback [in] called once with the reply or timeout
+ * @param context [in] given to the callback
+ * @return invoke id of the request, or 0 if the device is not bound,
+ *  or no transaction is available
+ */
+uint8_t bacnet_rp_async(uint32_t device_id,
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    BACNET_PROPERTY_ID object_property,
+    BACNET_ARRAY_INDEX array_index,
+    bacnet_rp_async_callback callback,
+    void *context)
+{
+    BACNET_READ_PROPERTY_DATA rp_data = { 0 };
+    BACNET_ASYNC_REQUEST *request;
+    uint8_t invoke_id = 0;
+
+    if (!callback) {
+        return 0;
+    }
+    request = bacnet_async_request_alloc();
+    if (request) {
+        request->device_id = device_id;
+        request->rp_callback = callback;
+        request->context = context;
+        rp_data.object_type = object_type;
+        rp_data.object_instance = object_instance;
+        rp_data.object_property = object_property;
+        rp_data.array_index = array_index;
+        invoke_id = bacnet_async_send(
+            request, SERVICE_CONFIRMED_READ_PROPERTY, &rp_data);
+        if (invoke_id == 0) {
+            bacnet_async_request_free(request);
+        }
+    }
+
+    return invoke_id;
+}
+
+/**
+ * Sends a WriteProperty request whose reply goes to a callback
+ *
+ * @param device_id [in] ID of the destination device, which is bound
+ * @param wp_data [in] the WriteProperty request
+ * @param callback [in] called once with the reply or timeout
+ * @param context [in] given to the callback
+ * @return invoke id of the request, or 0 if the device is not bound,
+ *  or no transaction is available
+ */
+uint8_t bacnet_wp_async(uint32_t device_id,
+    BACNET_WRITE_PROPERTY_DATA *wp_data,
+    bacnet_wp_async_callback callback,
+    void *context)
+{
+    BACNET_ASYNC_REQUEST *request;
+    uint8_t invoke_id = 0;
+
+    if (!callback || !wp_data) {
+        return 0;
+    }
+    request = bacnet_async_request_alloc();
+    if (request) {
+        request->device_id = device_id;
+        request->wp_callback = callback;
+        request->context = context;
+        invoke_id = bacnet_async_send(
+            request, SERVICE_CONFIRMED_WRITE_PROPERTY, wp_data);
+        if (invoke_id == 0) {
+            bacnet_async_request_free(request);
+        }
+    }
+
+    return invoke_id;
+}
+
+/**
+ * Sends a ReadRange request whose reply goes to a callback
+ *
+ * @param device_id [in] ID of the destination device, which is bound
+ * @param rr_data [in] the ReadRange request
+ * @param callback [in] called once with the reply or timeout
+ * @param context [in] given to the callback
+ * @return invoke id of the request, or 0 if the device is not bound,
+ *  or no transaction is available
+ */
+uint8_t bacnet_rr_async(uint32_t device_id,
+    BACNET_READ_RANGE_DATA *rr_data,
+    bacnet_rr_async_callback callback,
+    void *context)
+{
+    BACNET_ASYNC_REQUEST *request;
+    uint8_t invoke_id = 0;
+
+    if (!callback || !rr_data) {
+        return 0;
+    }
+    request = bacnet_async_request_alloc();
+    if (request) {
+        request->device_id = device_id;
+        request->rr_callback = callback;
+        request->context = context;
+        invoke_id = bacnet_async_send(
+            request, SERVICE_CONFIRMED_READ_RANGE, rr_data);
+        if (invoke_id == 0) {
+            bacnet_async_request_free(request);
+        }
+    }
+
+    return invoke_id;
+}
+
+/**
+ * Cancels a request in flight.  The callback is not called, and a
+ * late reply is handled like any reply without a transaction.
+ *
+ * @param device_id [in] ID of the device the request was sent to
+ * @param invoke_id [in] invoke id of the request
+ * @return true if the request was canceled
+ */
+bool bacnet_async_cancel(uint32_t device_id, uint8_t invoke_id)
+{
+    BACNET_ADDRESS dest = { 0 };
+    unsigned max_apdu = 0;
+    void *context = NULL;
+
+    if (!address_get_by_device(device_id, &max_apdu, &dest)) {
+        return false;
+    }
+    if (!tsm_cancel_invoke_id(invoke_id, &dest, &context)) {
+        return false;
+    }
+    bacnet_async_request_free(context);
+
+    return true;
+}
+#endif
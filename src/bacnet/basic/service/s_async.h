@@ -0,0 +1,101 @@
+/**
+ * @file
+ * @brief Send confirmed requests whose replies go to a callback
+ *
+ * Each request keeps its own callback and context in the transaction
+ * state machine, which calls it once with the ack, error, reject,
+ * abort or timeout for that request.  Invoke IDs are scoped to the
+ * destination device, so many requests may be in flight at once -
+ * up to MAX_TSM_TRANSACTIONS in all, and up to 255 to each device.
+ *
+ * @section LICENSE
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef SEND_ASYNC_H
+#define SEND_ASYNC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "bacnet/bacnet_stack_exports.h"
+#include "bacnet/bacdef.h"
+#include "bacnet/bacenum.h"
+#include "bacnet/readrange.h"
+#include "bacnet/rp.h"
+#include "bacnet/wp.h"
+#include "bacnet/basic/tsm/tsm.h"
+
+/**
+ * Called once with the reply to a ReadProperty request
+ *
+ * @param context [in] context given with the request
+ * @param device_id [in] device the request was sent to
+ * @param completion [in] how the request ended, and the reply
+ * @param rp_data [in] the decoded ReadProperty-ACK, or NULL if the
+ *  request did not end with an ack that could be decoded
+ */
+typedef void (*bacnet_rp_async_callback)(void *context,
+    uint32_t device_id,
+    BACNET_TSM_COMPLETION *completion,
+    BACNET_READ_PROPERTY_DATA *rp_data);
+
+/**
+ * Called once with the reply to a WriteProperty request
+ *
+ * @param context [in] context given with the request
+ * @param device_id [in] device the request was sent to
+ * @param completion [in] how the request ended, and the reply
+ */
+typedef void (*bacnet_wp_async_callback)(void *context,
+    uint32_t device_id,
+    BACNET_TSM_COMPLETION *completion);
+
+/**
+ * Called once with the reply to a ReadRange request
+ *
+ * @param context [in] context given with the request
+ * @param device_id [in] device the request was sent to
+ * @param completion [in] how the request ended, and the reply
+ * @param rr_data [in] the decoded ReadRange-ACK, or NULL if the
+ *  request did not end with an ack that could be decoded
+ */
+typedef void (*bacnet_rr_async_callback)(void *context,
+    uint32_t device_id,
+    BACNET_TSM_COMPLETION *completion,
+    BACNET_READ_RANGE_DATA *rr_data);
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    BACNET_STACK_EXPORT
+    uint8_t bacnet_rp_async(
+        uint32_t device_id,
+        BACNET_OBJECT_TYPE object_type,
+        uint32_t object_instance,
+        BACNET_PROPERTY_ID object_property,
+        BACNET_ARRAY_INDEX array_index,
+        bacnet_rp_async_callback callback,
+        void *context);
+    BACNET_STACK_EXPORT
+    uint8_t bacnet_wp_async(
+        uint32_t device_id,
+        BACNET_WRITE_PROPERTY_DATA * wp_data,
+        bacnet_wp_async_callback callback,
+        void *context);
+    BACNET_STACK_EXPORT
+    uint8_t bacnet_rr_async(
+        uint32_t device_id,
+        BACNET_READ_RANGE_DATA * rr_data,
+        bacnet_rr_async_callback callback,
+        void *context);
+    BACNET_STACK_EXPORT
+    bool bacnet_async_cancel(
+        uint32_t device_id,
+        uint8_t invoke_id);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif
@@ -138,3 +138,414 @@ uint8_t Send_CEvent_Notify(
 
     return invoke_id;
 }
+
+/* A confirmed notification waiting in the outbound queue.
+   Entries for the same recipient are sent one at a time in
+   order of arrival, so a recipient never sees transitions
+   out of order. */
+typedef struct cevent_queue_entry {
+    bool in_use : 1;
+    /* non-zero while the notification is waiting for a confirmation */
+    uint8_t invoke_id;
+    /* attempts that were sent and not acknowledged */
+    uint8_t retry_count;
+    /* Who-Is sent to find a recipient that is not bound */
+    uint8_t bind_count;
+    uint32_t device_id;
+    uint32_t sequence;
+    uint32_t process_id;
+    BACNET_OBJECT_ID event_object;
+    /* time remaining before the next attempt is allowed */
+    uint32_t backoff_ms;
+    uint32_t age_ms;
+    uint16_t service_len;
+    uint8_t service_data[BACNET_CEVENT_QUEUE_DATA_SIZE];
+} CEVENT_QUEUE_ENTRY;
+
+static CEVENT_QUEUE_ENTRY CEvent_Queue[BACNET_CEVENT_QUEUE_SIZE];
+static uint32_t CEvent_Queue_Sequence;
+static BACNET_CEVENT_QUEUE_METRICS CEvent_Queue_Counters;
+
+/**
+ * @brief Determine if an entry is the oldest queued for its recipient
+ * @param entry [in] queue entry to check
+ * @return true if no earlier entry for the same recipient is queued
+ */
+static bool cevent_queue_entry_is_head(const CEVENT_QUEUE_ENTRY *entry)
+{
+    unsigned i;
+    const CEVENT_QUEUE_ENTRY *other;
+
+    for (i = 0; i < BACNET_CEVENT_QUEUE_SIZE; i++) {
+        other = &CEvent_Queue[i];
+        if ((other == entry) || (!other->in_use) ||
+            (other->device_id != entry->device_id)) {
+            continue;
+        }
+        if ((int32_t)(other->sequence - entry->sequence) < 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Release a queue entry
+ * @param entry [in] queue entry to release
+ */
+static void cevent_queue_entry_free(CEVENT_QUEUE_ENTRY *entry)
+{
+    entry->in_use = false;
+    entry->invoke_id = 0;
+    entry->service_len = 0;
+}
+
+/**
+ * @brief Get the delay before the next attempt, doubled for each attempt
+ * @param count [in] number of attempts so far, starting at 1
+ * @return delay in milliseconds
+ */
+static uint32_t cevent_queue_backoff(uint8_t count)
+{
+    uint32_t backoff_ms = BACNET_CEVENT_QUEUE_BACKOFF_MS;
+    unsigned i;
+
+    for (i = 1; i < count; i++) {
+        backoff_ms *= 2;
+        if (backoff_ms >= BACNET_CEVENT_QUEUE_BACKOFF_MAX_MS) {
+            break;
+        }
+    }
+    if (backoff_ms > BACNET_CEVENT_QUEUE_BACKOFF_MAX_MS) {
+        backoff_ms = BACNET_CEVENT_QUEUE_BACKOFF_MAX_MS;
+    }
+
+    return backoff_ms;
+}
+
+/**
+ * @brief Count an attempt that was sent and not acknowledged, and
+ *  either schedule the next attempt with exponential backoff or drop
+ *  the notification once the retry limit is reached
+ * @param entry [in] queue entry that failed
+ */
+static void cevent_queue_entry_retry(CEVENT_QUEUE_ENTRY *entry)
+{
+    entry->retry_count++;
+    if (entry->retry_count > BACNET_CEVENT_QUEUE_RETRY_LIMIT) {
+        CEvent_Queue_Counters.dropped++;
+        cevent_queue_entry_free(entry);
+        return;
+    }
+    CEvent_Queue_Counters.retries++;
+    entry->backoff_ms = cevent_queue_backoff(entry->retry_count);
+}
+
+/**
+ * @brief Completes the TSM transaction of a queued notification.
+ *  A SimpleACK confirms it; a timeout, Error, Reject or Abort is retried.
+ * @param completion [in] the reply, or the timeout
+ * @param context [in] queue entry of the notification
+ */
+static void cevent_queue_entry_complete(
+    BACNET_TSM_COMPLETION *completion, void *context)
+{
+    CEVENT_QUEUE_ENTRY *entry = (CEVENT_QUEUE_ENTRY *)context;
+
+    if ((!entry) || (!entry->in_use) ||
+        (entry->invoke_id != completion->invoke_id)) {
+        /* the queue was initialized while the request was in flight */
+        return;
+    }
+    entry->invoke_id = 0;
+    if (completion->result == TSM_RESULT_ACK) {
+        CEvent_Queue_Counters.confirmed++;
+        cevent_queue_entry_free(entry);
+        return;
+    }
+    if (completion->result != TSM_RESULT_TIMEOUT) {
+        CEvent_Queue_Counters.refused++;
+#if PRINT_ENABLED
+        fprintf(stderr,
+            "ConfirmedEventNotification to %lu refused - retrying!\n",
+            (unsigned long)entry->device_id);
+#endif
+    }
+    cevent_queue_entry_retry(entry);
+}
+
+/**
+ * @brief Send a queued notification using a new TSM transaction.
+ *
+ * Nothing is sent, and no attempt is counted, while communication is
+ * disabled or no TSM slot is available.  A Who-Is is sent to find a
+ * recipient that is not bound, and the notification is dropped when
+ * the recipient is still not found after BACNET_CEVENT_QUEUE_BIND_LIMIT
+ * tries, or when it does not fit in the APDU of the recipient.
+ *
+ * @param entry [in] queue entry to send; its invoke_id is set when sent
+ */
+static void cevent_queue_entry_send(CEVENT_QUEUE_ENTRY *entry)
+{
+    BACNET_ADDRESS dest = { 0 };
+    BACNET_ADDRESS my_address;
+    BACNET_NPDU_DATA npdu_data;
+    unsigned max_apdu = 0;
+    uint8_t *pdu = &Handler_Transmit_Buffer[0];
+    uint8_t invoke_id = 0;
+    int pdu_len = 0;
+
+    if (!dcc_communication_enabled()) {
+        return;
+    }
+    if (!address_bind_request(entry->device_id, &max_apdu, &dest)) {
+        entry->bind_count++;
+        if (entry->bind_count > BACNET_CEVENT_QUEUE_BIND_LIMIT) {
+            CEvent_Queue_Counters.dropped++;
+            cevent_queue_entry_free(entry);
+            return;
+        }
+        Send_WhoIs(entry->device_id, entry->device_id);
+        entry->backoff_ms = cevent_queue_backoff(entry->bind_count);
+        return;
+    }
+    entry->bind_count = 0;
+    if (sizeof(Handler_Transmit_Buffer) < max_apdu) {
+        max_apdu = sizeof(Handler_Transmit_Buffer);
+    }
+    invoke_id = tsm_next_free_invokeID_async(
+        &dest, cevent_queue_entry_complete, entry);
+    if (invoke_id == 0) {
+        return;
+    }
+    datalink_get_my_address(&my_address);
+    npdu_encode_npdu_data(&npdu_data, true, MESSAGE_PRIORITY_NORMAL);
+    pdu_len = npdu_encode_pdu(pdu, &dest, &my_address, &npdu_data);
+    pdu[pdu_len++] = PDU_TYPE_CONFIRMED_SERVICE_REQUEST;
+    pdu[pdu_len++] = encode_max_segs_max_apdu(0, MAX_APDU);
+    pdu[pdu_len++] = invoke_id;
+    pdu[pdu_len++] = SERVICE_CONFIRMED_EVENT_NOTIFICATION;
+    if ((unsigned)(pdu_len + entry->service_len) <= max_apdu) {
+        memcpy(&pdu[pdu_len], entry->service_data, entry->service_len);
+        pdu_len += entry->service_len;
+        tsm_set_confirmed_unsegmented_transaction(
+            invoke_id, &dest, &npdu_data, pdu, (uint16_t)pdu_len);
+        entry->invoke_id = invoke_id;
+        datalink_send_pdu(&dest, &npdu_data, pdu, pdu_len);
+    } else {
+        /* will never fit in the recipient */
+        tsm_cancel_invoke_id(invoke_id, &dest, NULL);
+        CEvent_Queue_Counters.dropped++;
+        cevent_queue_entry_free(entry);
+#if PRINT_ENABLED
+        fprintf(stderr,
+            "ConfirmedEventNotification to %lu dropped "
+            "(exceeds destination maximum APDU)!\n",
+            (unsigned long)entry->device_id);
+#endif
+    }
+}
+
+/**
+ * @brief Initialize the confirmed event notification queue
+ */
+void Send_CEvent_Queue_Init(void)
+{
+    memset(CEvent_Queue, 0, sizeof(CEvent_Queue));
+    memset(&CEvent_Queue_Counters, 0, sizeof(CEvent_Queue_Counters));
+    CEvent_Queue_Sequence = 0;
+}
+
+/** Queues a Confirmed Alarm/Event Notification for a recipient.
+ * @ingroup EVNOTFCN
+ *
+ * The notification is sent immediately when a TSM slot is available
+ * and no earlier notification to the same recipient is outstanding.
+ * Otherwise it is held until Send_CEvent_Queue_Task() can send it.
+ * A pending notification for the same event object and process
+ * identifier that has not yet been sent is replaced by this one.
+ *
+ * @param device_id [in] ID of the destination device
+ * @param data [in] The information about the Event to be sent.
+ * @return true if the notification was queued or sent,
+ *  false if the queue is full or the notification is too large.
+ */
+bool Send_CEvent_Notify_Queue(
+    uint32_t device_id, BACNET_EVENT_NOTIFICATION_DATA *data)
+{
+    uint8_t service_data[MAX_APDU] = { 0 };
+    CEVENT_QUEUE_ENTRY *entry = NULL;
+    CEVENT_QUEUE_ENTRY *free_entry = NULL;
+    unsigned depth = 0;
+    unsigned i;
+    int len;
+
+    if (!data) {
+        return false;
+    }
+    len = event_notify_encode_service_request(service_data, data);
+    if ((len <= 0) || (len > BACNET_CEVENT_QUEUE_DATA_SIZE)) {
+        CEvent_Queue_Counters.dropped++;
+        return false;
+    }
+    for (i = 0; i < BACNET_CEVENT_QUEUE_SIZE; i++) {
+        if (!CEvent_Queue[i].in_use) {
+            if (!free_entry) {
+                free_entry = &CEvent_Queue[i];
+            }
+            continue;
+        }
+        depth++;
+        if ((!entry) && (CEvent_Queue[i].invoke_id == 0) &&
+            (CEvent_Queue[i].device_id == device_id) &&
+            (CEvent_Queue[i].process_id == data->processIdentifier) &&
+            (CEvent_Queue[i].event_object.type ==
+                data->eventObjectIdentifier.type) &&
+            (CEvent_Queue[i].event_object.instance ==
+                data->eventObjectIdentifier.instance)) {
+            entry = &CEvent_Queue[i];
+        }
+    }
+    if (entry) {
+        /* superseded transition - keep its place in line */
+        CEvent_Queue_Counters.merged++;
+    } else if (free_entry) {
+        entry = free_entry;
+        entry->in_use = true;
+        entry->invoke_id = 0;
+        entry->retry_count = 0;
+        entry->bind_count = 0;
+        entry->backoff_ms = 0;
+        entry->age_ms = 0;
+        entry->device_id = device_id;
+        entry->sequence = CEvent_Queue_Sequence++;
+        entry->process_id = data->processIdentifier;
+        entry->event_object = data->eventObjectIdentifier;
+        depth++;
+        if (depth > CEvent_Queue_Counters.depth_max) {
+            CEvent_Queue_Counters.depth_max = depth;
+        }
+    } else {
+        CEvent_Queue_Counters.dropped++;
+#if PRINT_ENABLED
+        fprintf(stderr,
+            "ConfirmedEventNotification queue full: "
+            "notification to %lu dropped!\n",
+            (unsigned long)device_id);
+#endif
+        return false;
+    }
+    memcpy(entry->service_data, service_data, (size_t)len);
+    entry->service_len = (uint16_t)len;
+    CEvent_Queue_Counters.enqueued++;
+    /* send right away if the TSM and recipient allow it */
+    Send_CEvent_Queue_Task(0);
+
+    return true;
+}
+
+/** Services the confirmed event notification queue.
+ * @ingroup EVNOTFCN
+ *
+ * Counts down the backoff of entries waiting to be retried, and sends
+ * the oldest pending entry of each idle recipient while TSM slots are
+ * available.  Entries in flight are completed by the TSM.
+ *
+ * @param milliseconds [in] Count of milliseconds passed since the last call
+ */
+void Send_CEvent_Queue_Task(uint32_t milliseconds)
+{
+    CEVENT_QUEUE_ENTRY *entry;
+    unsigned i, j;
+    bool busy;
+
+    for (i = 0; i < BACNET_CEVENT_QUEUE_SIZE; i++) {
+        entry = &CEvent_Queue[i];
+        if (!entry->in_use) {
+            continue;
+        }
+        entry->age_ms += milliseconds;
+        if (entry->invoke_id) {
+            continue;
+        } else if (entry->backoff_ms > milliseconds) {
+            entry->backoff_ms -= milliseconds;
+        } else {
+            entry->backoff_ms = 0;
+        }
+    }
+    for (i = 0; i < BACNET_CEVENT_QUEUE_SIZE; i++) {
+        entry = &CEvent_Queue[i];
+        if ((!entry->in_use) || (entry->invoke_id) || (entry->backoff_ms)) {
+            continue;
+        }
+        if (!tsm_transaction_available()) {
+            /* backpressure: hold everything until a slot frees up */
+            break;
+        }
+        if (!cevent_queue_entry_is_head(entry)) {
+            continue;
+        }
+        busy = false;
+        for (j = 0; j < BACNET_CEVENT_QUEUE_SIZE; j++) {
+            if (CEvent_Queue[j].in_use && CEvent_Queue[j].invoke_id &&
+                (CEvent_Queue[j].device_id == entry->device_id)) {
+                busy = true;
+                break;
+            }
+        }
+        if (!busy) {
+            cevent_queue_entry_send(entry);
+            if (entry->in_use && entry->invoke_id) {
+                CEvent_Queue_Counters.sent++;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Get the number of notifications in the queue
+ * @return number of queued notifications, including those in flight
+ */
+unsigned Send_CEvent_Queue_Depth(void)
+{
+    unsigned depth = 0;
+    unsigned i;
+
+    for (i = 0; i < BACNET_CEVENT_QUEUE_SIZE; i++) {
+        if (CEvent_Queue[i].in_use) {
+            depth++;
+        }
+    }
+
+    return depth;
+}
+
+/**
+ * @brief Get the confirmed event notification queue metrics
+ * @param metrics [out] copy of the queue depth, age, and counters
+ */
+void Send_CEvent_Queue_Metrics(BACNET_CEVENT_QUEUE_METRICS *metrics)
+{
+    unsigned i;
+
+    if (!metrics) {
+        return;
+    }
+    *metrics = CEvent_Queue_Counters;
+    metrics->depth = 0;
+    metrics->in_flight = 0;
+    metrics->oldest_age_ms = 0;
+    for (i = 0; i < BACNET_CEVENT_QUEUE_SIZE; i++) {
+        if (!CEvent_Queue[i].in_use) {
+            continue;
+        }
+        metrics->depth++;
+        if (CEvent_Queue[i].invoke_id) {
+            metrics->in_flight++;
+        }
+        if (CEvent_Queue[i].age_ms > metrics->oldest_age_ms) {
+            metrics->oldest_age_ms = CEvent_Queue[i].age_ms;
+        }
+    }
+}
@@ -39,6 +39,54 @@
 #include "bacnet/apdu.h"
 #include "bacnet/event.h"
 
+/* number of confirmed notifications that can be held while waiting
+   for a TSM slot, an address binding, or a retry */
+#ifndef BACNET_CEVENT_QUEUE_SIZE
+#define BACNET_CEVENT_QUEUE_SIZE 16
+#endif
+/* largest encoded notification service request held in the queue */
+#ifndef BACNET_CEVENT_QUEUE_DATA_SIZE
+#define BACNET_CEVENT_QUEUE_DATA_SIZE (MAX_APDU - 4)
+#endif
+/* first retry delay after the TSM gives up; doubles for each retry */
+#ifndef BACNET_CEVENT_QUEUE_BACKOFF_MS
+#define BACNET_CEVENT_QUEUE_BACKOFF_MS 1000UL
+#endif
+#ifndef BACNET_CEVENT_QUEUE_BACKOFF_MAX_MS
+#define BACNET_CEVENT_QUEUE_BACKOFF_MAX_MS 60000UL
+#endif
+/* number of attempts that were sent and not acknowledged - timeouts,
+   or Error, Reject or Abort replies - before a notification is dropped */
+#ifndef BACNET_CEVENT_QUEUE_RETRY_LIMIT
+#define BACNET_CEVENT_QUEUE_RETRY_LIMIT 8
+#endif
+/* number of Who-Is sent to find a recipient that is not bound
+   before its notification is dropped */
+#ifndef BACNET_CEVENT_QUEUE_BIND_LIMIT
+#define BACNET_CEVENT_QUEUE_BIND_LIMIT 16
+#endif
+
+typedef struct BACnet_CEvent_Queue_Metrics {
+    /* notifications currently queued, including those in flight */
+    unsigned depth;
+    /* high water mark of depth since init */
+    unsigned depth_max;
+    /* notifications currently waiting for a confirmation */
+    unsigned in_flight;
+    /* age of the oldest queued notification */
+    uint32_t oldest_age_ms;
+    uint32_t enqueued;
+    /* pending notifications replaced by a newer transition */
+    uint32_t merged;
+    uint32_t sent;
+    uint32_t confirmed;
+    uint32_t retries;
+    /* Error, Reject or Abort replies, which are retried */
+    uint32_t refused;
+    /* notifications lost to a full queue or to the retry limit */
+    uint32_t dropped;
+} BACNET_CEVENT_QUEUE_METRICS;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -50,6 +98,18 @@ BACNET_STACK_EXPORT
 uint8_t Send_CEvent_Notify_Address(uint8_t *pdu, uint16_t pdu_size,
     BACNET_EVENT_NOTIFICATION_DATA *data, BACNET_ADDRESS *dest);
 
+BACNET_STACK_EXPORT
+void Send_CEvent_Queue_Init(void);
+BACNET_STACK_EXPORT
+bool Send_CEvent_Notify_Queue(uint32_t device_id,
+    BACNET_EVENT_NOTIFICATION_DATA *data);
+BACNET_STACK_EXPORT
+void Send_CEvent_Queue_Task(uint32_t milliseconds);
+BACNET_STACK_EXPORT
+unsigned Send_CEvent_Queue_Depth(void);
+BACNET_STACK_EXPORT
+void Send_CEvent_Queue_Metrics(BACNET_CEVENT_QUEUE_METRICS *metrics);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
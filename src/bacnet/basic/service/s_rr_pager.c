@@ -0,0 +1,282 @@
+/**
+ * @file
+ * @brief Read a Trend Log buffer by sequence number, page after page
+ *
+ * @section DESCRIPTION
+ *
+ * Pages are requested with consecutive sequence numbers.  A reply
+ * that holds the last record, or no records, ends the reading once the
+ * pages before it have arrived.  Pages requested past the end come back
+ * empty.
+ *
+ * @section LICENSE
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "bacnet/config.h"
+#include "bacnet/bacdef.h"
+#include "bacnet/bacstr.h"
+#include "bacnet/readrange.h"
+#include "bacnet/basic/tsm/tsm.h"
+#include "bacnet/basic/service/s_async.h"
+#include "bacnet/basic/service/s_rr_pager.h"
+
+#if (MAX_TSM_TRANSACTIONS)
+static void rr_pager_reply(void *context,
+    uint32_t device_id,
+    BACNET_TSM_COMPLETION *completion,
+    BACNET_READ_RANGE_DATA *rr_data);
+
+/**
+ * Ends the reading, keeping the first result
+ *
+ * @param pager - the pager
+ * @param result - how the reading ended
+ */
+static void rr_pager_end(RR_PAGER *pager, BACNET_TSM_RESULT result)
+{
+    if (!pager->done) {
+        pager->done = true;
+        pager->result = result;
+    }
+}
+
+/**
+ * Notes a page that was requested but not read, so that the reading
+ * resumes from the lowest such page.
+ *
+ * @param pager - the pager
+ * @param sequence - first record requested in the page
+ */
+static void rr_pager_missed(RR_PAGER *pager, uint32_t sequence)
+{
+    if (!pager->missed ||
+        ((pager->missed_sequence - sequence) < 0x80000000UL)) {
+        pager->missed = true;
+        pager->missed_sequence = sequence;
+    }
+}
+
+/**
+ * Calls the done callback when no pages are left in flight
+ *
+ * @param pager - the pager
+ */
+static void rr_pager_finish(RR_PAGER *pager)
+{
+    uint32_t next_sequence = pager->end_sequence;
+
+    if (pager->done && (pager->in_flight == 0) && pager->done_callback) {
+        /* the pages after one that was not read may have arrived,
+           but the reading resumes where the records stop being
+           contiguous */
+        if (pager->missed &&
+            ((next_sequence - pager->missed_sequence) < 0x80000000UL)) {
+            next_sequence = pager->missed_sequence;
+        }
+        pager->done_callback(
+            pager->context, pager->device_id, pager->result, next_sequence);
+    }
+}
+
+/**
+ * Sends requests for the next pages until the window is full
+ *
+ * @param pager - the pager
+ */
+static void rr_pager_send(RR_PAGER *pager)
+{
+    BACNET_READ_RANGE_DATA rr_data = { 0 };
+    uint8_t invoke_id;
+    unsigned slot;
+
+    while (!pager->done && (pager->in_flight < pager->window)) {
+        for (slot = 0; slot < RR_PAGER_WINDOW_MAX; slot++) {
+            if (pager->invoke_id[slot] == 0) {
+                break;
+            }
+        }
+        if (slot >= RR_PAGER_WINDOW_MAX) {
+            break;
+        }
+        rr_data.object_type = pager->object_type;
+        rr_data.object_instance = pager->object_instance;
+        rr_data.object_property = PROP_LOG_BUFFER;
+        rr_data.array_index = BACNET_ARRAY_ALL;
+        rr_data.RequestType = RR_BY_SEQUENCE;
+        rr_data.Range.RefSeqNum = pager->next_sequence;
+        rr_data.Count = pager->page_records;
+        invoke_id =
+            bacnet_rr_async(pager->device_id, &rr_data, rr_pager_reply, pager);
+        if (invoke_id == 0) {
+            if (pager->in_flight == 0) {
+                /* nothing in flight will send it later */
+                rr_pager_end(pager, TSM_RESULT_ABORT);
+            }
+            break;
+        }
+        pager->invoke_id[slot] = invoke_id;
+        pager->page_sequence[slot] = pager->next_sequence;
+        pager->in_flight++;
+        pager->next_sequence += pager->page_records;
+    }
+}
+
+/**
+ * Cancels the pages in flight
+ *
+ * @param pager - the pager
+ */
+static void rr_pager_cancel(RR_PAGER *pager)
+{
+    unsigned slot;
+
+    for (slot = 0; slot < RR_PAGER_WINDOW_MAX; slot++) {
+        if (pager->invoke_id[slot]) {
+            if (bacnet_async_cancel(
+                    pager->device_id, pager->invoke_id[slot])) {
+                pager->in_flight--;
+            }
+            pager->invoke_id[slot] = 0;
+            rr_pager_missed(pager, pager->page_sequence[slot]);
+        }
+    }
+}
+
+/**
+ * Decodes the records of a page into the columns
+ *
+ * @param pager - the pager
+ * @param rr_data - the ReadRange-ACK
+ * @return true if the records were decoded
+ */
+static bool rr_pager_decode(RR_PAGER *pager, BACNET_READ_RANGE_DATA *rr_data)
+{
+    BACNET_LOG_RECORD_COLUMNS *columns = pager->columns;
+    uint32_t sequence = rr_data->FirstSequence;
+    uint8_t *apdu = rr_data->application_data;
+    int apdu_len = rr_data->application_data_len;
+    int len;
+
+    if (!columns || (columns->size == 0)) {
+        return false;
+    }
+    while (apdu_len > 0) {
+        columns->count = 0;
+        len = rr_log_records_decode(apdu, apdu_len, columns);
+        if ((len <= 0) || (columns->count == 0)) {
+            return false;
+        }
+        if (pager->records_callback) {
+            pager->records_callback(
+                pager->context, pager->device_id, sequence, columns);
+        }
+        sequence += columns->count;
+        apdu += len;
+        apdu_len -= len;
+    }
+    if ((sequence - pager->end_sequence) < 0x80000000UL) {
+        pager->end_sequence = sequence;
+    }
+
+    return true;
+}
+
+/**
+ * Handles the reply to a page request
+ *
+ * @param context - the pager
+ * @param device_id - device the request was sent to
+ * @param completion - how the request ended
+ * @param rr_data - the decoded ReadRange-ACK, or NULL
+ */
+static void rr_pager_reply(void *context,
+    uint32_t device_id,
+    BACNET_TSM_COMPLETION *completion,
+    BACNET_READ_RANGE_DATA *rr_data)
+{
+    RR_PAGER *pager = context;
+    uint32_t sequence = pager->end_sequence;
+    unsigned slot;
+
+    (void)device_id;
+    for (slot = 0; slot < RR_PAGER_WINDOW_MAX; slot++) {
+        if (pager->invoke_id[slot] == completion->invoke_id) {
+            pager->invoke_id[slot] = 0;
+            pager->in_flight--;
+            sequence = pager->page_sequence[slot];
+            break;
+        }
+    }
+    if (!rr_data) {
+        rr_pager_missed(pager, sequence);
+        rr_pager_end(pager, (completion->result == TSM_RESULT_ACK)
+                ? TSM_RESULT_ABORT
+                : completion->result);
+        rr_pager_cancel(pager);
+    } else {
+        if ((rr_data->ItemCount == 0) ||
+            bitstring_bit(&rr_data->ResultFlags, RESULT_FLAG_LAST_ITEM)) {
+            rr_pager_end(pager, TSM_RESULT_ACK);
+        }
+        /* the next page is on its way while this one is decoded */
+        rr_pager_send(pager);
+        if ((rr_data->ItemCount > 0) && !rr_pager_decode(pager, rr_data)) {
+            rr_pager_missed(pager, sequence);
+            rr_pager_end(pager, TSM_RESULT_ABORT);
+            rr_pager_cancel(pager);
+        }
+    }
+    rr_pager_finish(pager);
+}
+
+/**
+ * Starts reading the Log_Buffer of a Trend Log from next_sequence
+ * until the last record, with window pages in flight.
+ *
+ * @param pager [in] the pager, which stays valid until done
+ * @return true if the first page was requested
+ */
+bool rr_pager_start(RR_PAGER *pager)
+{
+    unsigned slot;
+
+    if (!pager || !pager->columns || (pager->page_records == 0) ||
+        (pager->window == 0) || (pager->window > RR_PAGER_WINDOW_MAX)) {
+        return false;
+    }
+    for (slot = 0; slot < RR_PAGER_WINDOW_MAX; slot++) {
+        pager->invoke_id[slot] = 0;
+    }
+    pager->in_flight = 0;
+    pager->done = false;
+    pager->result = TSM_RESULT_ACK;
+    pager->end_sequence = pager->next_sequence;
+    pager->missed = false;
+    pager->missed_sequence = pager->next_sequence;
+    rr_pager_send(pager);
+    if (pager->in_flight == 0) {
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Stops reading: the pages in flight are canceled, and the done
+ * callback is called with TSM_RESULT_ABORT.
+ *
+ * @param pager [in] the pager
+ */
+void rr_pager_stop(RR_PAGER *pager)
+{
+    if (pager && !pager->done) {
+        rr_pager_end(pager, TSM_RESULT_ABORT);
+        rr_pager_cancel(pager);
+        rr_pager_finish(pager);
+    }
+}
+#endif
@@ -0,0 +1,107 @@
+/**
+ * @file
+ * @brief Read a Trend Log buffer by sequence number, page after page
+ *
+ * The pager keeps a window of ReadRange by-sequence requests in flight
+ * to one device, and sends the request for the next page before the
+ * records of a reply are decoded.  The records are decoded into the
+ * columns given by the caller and handed to a callback; nothing is
+ * allocated.  Pages may complete out of order, so each part of a page
+ * comes with the sequence number of its first record.
+ *
+ * @section LICENSE
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef SEND_RR_PAGER_H
+#define SEND_RR_PAGER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "bacnet/bacnet_stack_exports.h"
+#include "bacnet/bacdef.h"
+#include "bacnet/bacenum.h"
+#include "bacnet/readrange.h"
+#include "bacnet/basic/tsm/tsm.h"
+
+/* number of pages that may be in flight at once */
+#ifndef RR_PAGER_WINDOW_MAX
+#define RR_PAGER_WINDOW_MAX 4
+#endif
+
+/**
+ * Called with decoded log records.  The columns are reused when the
+ * callback returns.
+ *
+ * @param context [in] context given with the pager
+ * @param device_id [in] device the records were read from
+ * @param first_sequence [in] sequence number of the first record
+ * @param columns [in] the records
+ */
+typedef void (*rr_pager_records_callback)(void *context,
+    uint32_t device_id,
+    uint32_t first_sequence,
+    BACNET_LOG_RECORD_COLUMNS *columns);
+
+/**
+ * Called once when no pages are left in flight.
+ *
+ * @param context [in] context given with the pager
+ * @param device_id [in] device the records were read from
+ * @param result [in] TSM_RESULT_ACK when the last record was read,
+ *  or how the request that failed ended.  TSM_RESULT_ABORT is also
+ *  given when a request could not be sent or a reply was malformed.
+ * @param next_sequence [in] sequence number to resume reading from:
+ *  after the last record read when every page before it arrived, or
+ *  else the first record of the lowest page that was not read.  The
+ *  records of later pages that did arrive are read again on resume.
+ */
+typedef void (*rr_pager_done_callback)(void *context,
+    uint32_t device_id,
+    BACNET_TSM_RESULT result,
+    uint32_t next_sequence);
+
+typedef struct rr_pager {
+    /* set by the caller before the pager is started */
+    uint32_t device_id;
+    BACNET_OBJECT_TYPE object_type;
+    uint32_t object_instance;
+    /* first record to read; the pager advances it as pages are sent */
+    uint32_t next_sequence;
+    /* records requested in each page */
+    uint16_t page_records;
+    /* pages in flight, up to RR_PAGER_WINDOW_MAX */
+    uint8_t window;
+    BACNET_LOG_RECORD_COLUMNS *columns;
+    rr_pager_records_callback records_callback;
+    rr_pager_done_callback done_callback;
+    void *context;
+    /* state of the pager */
+    uint8_t invoke_id[RR_PAGER_WINDOW_MAX];
+    uint32_t page_sequence[RR_PAGER_WINDOW_MAX];
+    uint8_t in_flight;
+    bool done;
+    BACNET_TSM_RESULT result;
+    /* after the last record read */
+    uint32_t end_sequence;
+    /* first record of the lowest page that was not read */
+    bool missed;
+    uint32_t missed_sequence;
+} RR_PAGER;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    BACNET_STACK_EXPORT
+    bool rr_pager_start(
+        RR_PAGER * pager);
+    BACNET_STACK_EXPORT
+    void rr_pager_stop(
+        RR_PAGER * pager);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif
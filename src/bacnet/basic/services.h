@@ -72,6 +72,7 @@
 #include "bacnet/basic/service/s_abort.h"
 #include "bacnet/basic/service/s_ack_alarm.h"
 #include "bacnet/basic/service/s_arfs.h"
+#include "bacnet/basic/service/s_async.h"
 #include "bacnet/basic/service/s_awfs.h"
 #include "bacnet/basic/service/s_cevent.h"
 #include "bacnet/basic/service/s_cov.h"
@@ -90,6 +91,7 @@
 #include "bacnet/basic/service/s_readrange.h"
 #include "bacnet/basic/service/s_rp.h"
 #include "bacnet/basic/service/s_rpm.h"
+#include "bacnet/basic/service/s_rr_pager.h"
 #include "bacnet/basic/service/s_ts.h"
 #include "bacnet/basic/service/s_uevent.h"
 #include "bacnet/basic/service/s_upt.h"
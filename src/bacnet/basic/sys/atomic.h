@@ -0,0 +1,66 @@
+/**
+ * @file
+ * @brief Atomic index abstraction for the lock-free FIFO, ring buffer,
+ *  and process image
+ *
+ * @section DESCRIPTION
+ *
+ * Uses C11 atomics when the compiler provides them, the GCC atomic
+ * builtins when compiling to an older standard, and plain volatile
+ * access otherwise.  The volatile fallback is only safe when producer
+ * and consumer run on one core (for example, an ISR and a main loop).
+ *
+ * @section LICENSE
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef BACNET_SYS_ATOMIC_H
+#define BACNET_SYS_ATOMIC_H
+
+#if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) && \
+    !defined(__STDC_NO_ATOMICS__) && !defined(__cplusplus)
+#include <stdatomic.h>
+#define BACNET_ATOMIC_LOCK_FREE 1
+typedef atomic_uint BACNET_ATOMIC_UINT;
+#define BACNET_ATOMIC_INIT(p, v) atomic_init((p), (v))
+#define BACNET_ATOMIC_LOAD(p) atomic_load_explicit((p), memory_order_relaxed)
+#define BACNET_ATOMIC_LOAD_ACQUIRE(p) \
+    atomic_load_explicit((p), memory_order_acquire)
+#define BACNET_ATOMIC_STORE(p, v) \
+    atomic_store_explicit((p), (v), memory_order_relaxed)
+#define BACNET_ATOMIC_STORE_RELEASE(p, v) \
+    atomic_store_explicit((p), (v), memory_order_release)
+#define BACNET_ATOMIC_CAS(p, expected, desired)                      \
+    atomic_compare_exchange_weak_explicit((p), (expected), (desired), \
+        memory_order_relaxed, memory_order_relaxed)
+#define BACNET_ATOMIC_FENCE_ACQUIRE() atomic_thread_fence(memory_order_acquire)
+#define BACNET_ATOMIC_FENCE_RELEASE() atomic_thread_fence(memory_order_release)
+#elif defined(__GNUC__)
+#define BACNET_ATOMIC_LOCK_FREE 1
+typedef unsigned BACNET_ATOMIC_UINT;
+#define BACNET_ATOMIC_INIT(p, v) (*(p) = (v))
+#define BACNET_ATOMIC_LOAD(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define BACNET_ATOMIC_LOAD_ACQUIRE(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define BACNET_ATOMIC_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define BACNET_ATOMIC_STORE_RELEASE(p, v) \
+    __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define BACNET_ATOMIC_CAS(p, expected, desired)                 \
+    __atomic_compare_exchange_n((p), (expected), (desired), 1, \
+        __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#define BACNET_ATOMIC_FENCE_ACQUIRE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define BACNET_ATOMIC_FENCE_RELEASE() __atomic_thread_fence(__ATOMIC_RELEASE)
+#else
+#define BACNET_ATOMIC_LOCK_FREE 0
+typedef volatile unsigned BACNET_ATOMIC_UINT;
+#define BACNET_ATOMIC_INIT(p, v) (*(p) = (v))
+#define BACNET_ATOMIC_LOAD(p) (*(p))
+#define BACNET_ATOMIC_LOAD_ACQUIRE(p) (*(p))
+#define BACNET_ATOMIC_STORE(p, v) (*(p) = (v))
+#define BACNET_ATOMIC_STORE_RELEASE(p, v) (*(p) = (v))
+#define BACNET_ATOMIC_CAS(p, expected, desired) \
+    ((*(p) == *(expected)) ? (*(p) = (desired), 1) : (*(expected) = *(p), 0))
+#define BACNET_ATOMIC_FENCE_ACQUIRE()
+#define BACNET_ATOMIC_FENCE_RELEASE()
+#endif
+
+#endif
@@ -171,6 +171,370 @@ void color_rgb_from_xy(uint8_t *red,
     }
 }
 
+/* sRGB 0..255 to linear light, 0..65535 for 0.0..1.0 */
+static const uint16_t Color_Gamma_Linear[256] = {
+    0, 20, 40, 60, 80, 99, 119, 139,
+    159, 179, 199, 219, 241, 264, 288, 313,
+    340, 367, 396, 427, 458, 491, 526, 562,
+    599, 637, 677, 718, 761, 805, 851, 898,
+    947, 997, 1048, 1101, 1156, 1212, 1270, 1330,
+    1391, 1453, 1517, 1583, 1651, 1720, 1790, 1863,
+    1937, 2013, 2090, 2170, 2250, 2333, 2418, 2504,
+    2592, 2681, 2773, 2866, 2961, 3058, 3157, 3258,
+    3360, 3464, 3570, 3678, 3788, 3900, 4014, 4129,
+    4247, 4366, 4488, 4611, 4736, 4864, 4993, 5124,
+    5257, 5392, 5530, 5669, 5810, 5953, 6099, 6246,
+    6395, 6547, 6700, 6856, 7014, 7174, 7335, 7500,
+    7666, 7834, 8004, 8177, 8352, 8528, 8708, 8889,
+    9072, 9258, 9445, 9635, 9828, 10022, 10219, 10417,
+    10619, 10822, 11028, 11235, 11446, 11658, 11873, 12090,
+    12309, 12530, 12754, 12980, 13209, 13440, 13673, 13909,
+    14146, 14387, 14629, 14874, 15122, 15371, 15623, 15878,
+    16135, 16394, 16656, 16920, 17187, 17456, 17727, 18001,
+    18277, 18556, 18837, 19121, 19407, 19696, 19987, 20281,
+    20577, 20876, 21177, 21481, 21787, 22096, 22407, 22721,
+    23038, 23357, 23678, 24002, 24329, 24658, 24990, 25325,
+    25662, 26001, 26344, 26688, 27036, 27386, 27739, 28094,
+    28452, 28813, 29176, 29542, 29911, 30282, 30656, 31033,
+    31412, 31794, 32179, 32567, 32957, 33350, 33745, 34143,
+    34544, 34948, 35355, 35764, 36176, 36591, 37008, 37429,
+    37852, 38278, 38706, 39138, 39572, 40009, 40449, 40891,
+    41337, 41785, 42236, 42690, 43147, 43606, 44069, 44534,
+    45002, 45473, 45947, 46423, 46903, 47385, 47871, 48359,
+    48850, 49344, 49841, 50341, 50844, 51349, 51858, 52369,
+    52884, 53401, 53921, 54445, 54971, 55500, 56032, 56567,
+    57105, 57646, 58190, 58737, 59287, 59840, 60396, 60955,
+    61517, 62082, 62650, 63221, 63795, 64372, 64952, 65535
+};
+
+/* largest sRGB whose linear light is not greater than each 128 steps of
+   linear light, where the search in Color_Gamma_Linear starts */
+static const uint8_t Color_Gamma_Start[512] = {
+    0, 6, 12, 17, 21, 25, 28, 30, 33, 35, 38, 40, 42, 44, 46, 47,
+    49, 51, 52, 54, 55, 57, 58, 59, 61, 62, 63, 64, 66, 67, 68, 69,
+    70, 71, 72, 73, 74, 76, 77, 77, 78, 79, 80, 81, 82, 83, 84, 85,
+    86, 87, 88, 88, 89, 90, 91, 92, 92, 93, 94, 95, 96, 96, 97, 98,
+    99, 99, 100, 101, 101, 102, 103, 104, 104, 105, 106, 106, 107, 108, 108, 109,
+    110, 110, 111, 112, 112, 113, 113, 114, 115, 115, 116, 116, 117, 118, 118, 119,
+    119, 120, 121, 121, 122, 122, 123, 123, 124, 125, 125, 126, 126, 127, 127, 128,
+    128, 129, 129, 130, 130, 131, 131, 132, 132, 133, 133, 134, 134, 135, 135, 136,
+    136, 137, 137, 138, 138, 139, 139, 140, 140, 141, 141, 142, 142, 143, 143, 144,
+    144, 145, 145, 145, 146, 146, 147, 147, 148, 148, 149, 149, 149, 150, 150, 151,
+    151, 152, 152, 152, 153, 153, 154, 154, 155, 155, 155, 156, 156, 157, 157, 157,
+    158, 158, 159, 159, 160, 160, 160, 161, 161, 162, 162, 162, 163, 163, 163, 164,
+    164, 165, 165, 165, 166, 166, 167, 167, 167, 168, 168, 168, 169, 169, 170, 170,
+    170, 171, 171, 171, 172, 172, 173, 173, 173, 174, 174, 174, 175, 175, 175, 176,
+    176, 176, 177, 177, 178, 178, 178, 179, 179, 179, 180, 180, 180, 181, 181, 181,
+    182, 182, 182, 183, 183, 183, 184, 184, 184, 185, 185, 185, 186, 186, 186, 187,
+    187, 187, 188, 188, 188, 189, 189, 189, 190, 190, 190, 191, 191, 191, 192, 192,
+    192, 192, 193, 193, 193, 194, 194, 194, 195, 195, 195, 196, 196, 196, 197, 197,
+    197, 197, 198, 198, 198, 199, 199, 199, 200, 200, 200, 200, 201, 201, 201, 202,
+    202, 202, 203, 203, 203, 203, 204, 204, 204, 205, 205, 205, 205, 206, 206, 206,
+    207, 207, 207, 208, 208, 208, 208, 209, 209, 209, 210, 210, 210, 210, 211, 211,
+    211, 211, 212, 212, 212, 213, 213, 213, 213, 214, 214, 214, 215, 215, 215, 215,
+    216, 216, 216, 216, 217, 217, 217, 218, 218, 218, 218, 219, 219, 219, 219, 220,
+    220, 220, 220, 221, 221, 221, 222, 222, 222, 222, 223, 223, 223, 223, 224, 224,
+    224, 224, 225, 225, 225, 225, 226, 226, 226, 226, 227, 227, 227, 227, 228, 228,
+    228, 228, 229, 229, 229, 229, 230, 230, 230, 230, 231, 231, 231, 231, 232, 232,
+    232, 232, 233, 233, 233, 233, 234, 234, 234, 234, 235, 235, 235, 235, 236, 236,
+    236, 236, 237, 237, 237, 237, 238, 238, 238, 238, 239, 239, 239, 239, 239, 240,
+    240, 240, 240, 241, 241, 241, 241, 242, 242, 242, 242, 243, 243, 243, 243, 243,
+    244, 244, 244, 244, 245, 245, 245, 245, 246, 246, 246, 246, 246, 247, 247, 247,
+    247, 248, 248, 248, 248, 248, 249, 249, 249, 249, 250, 250, 250, 250, 251, 251,
+    251, 251, 251, 252, 252, 252, 252, 253, 253, 253, 253, 253, 254, 254, 254, 254
+};
+
+/* Wide RGB D65 linear RGB to XYZ, 16384 for 1.0; the Y row sums to 1.0 */
+static const uint16_t Color_RGB_XYZ[3][3] = {
+    { 10648, 1695, 3229 },
+    { 3839, 12175, 370 },
+    { 0, 870, 16970 }
+};
+
+/* XYZ to linear RGB, 4096 for 1.0 */
+static const int16_t Color_XYZ_RGB[3][3] = {
+    { 5992, -754, -1124 },
+    { -2137, 5928, 277 },
+    { 143, -397, 5277 }
+};
+
+/* largest XYZ given to the fixed point matrix, in 65536 for 1.0 */
+#define COLOR_XYZ_MAX 1073741824.0
+
+/* sRGB of color temperatures 1000K..40000K in 100K steps */
+static const uint8_t Color_Temperature_RGB[391][3] = {
+    { 255, 67, 0 }, { 255, 77, 0 }, { 255, 86, 0 }, { 255, 94, 0 },
+    { 255, 101, 0 }, { 255, 108, 0 }, { 255, 114, 0 }, { 255, 120, 0 },
+    { 255, 126, 0 }, { 255, 131, 0 }, { 255, 136, 13 }, { 255, 141, 27 },
+    { 255, 146, 39 }, { 255, 150, 50 }, { 255, 155, 60 }, { 255, 159, 70 },
+    { 255, 162, 79 }, { 255, 166, 87 }, { 255, 170, 95 }, { 255, 173, 102 },
+    { 255, 177, 109 }, { 255, 180, 116 }, { 255, 183, 123 }, { 255, 186, 129 },
+    { 255, 189, 135 }, { 255, 192, 140 }, { 255, 195, 146 }, { 255, 198, 151 },
+    { 255, 200, 156 }, { 255, 203, 161 }, { 255, 205, 166 }, { 255, 208, 170 },
+    { 255, 210, 175 }, { 255, 213, 179 }, { 255, 215, 183 }, { 255, 217, 187 },
+    { 255, 219, 191 }, { 255, 221, 195 }, { 255, 223, 198 }, { 255, 226, 202 },
+    { 255, 228, 205 }, { 255, 229, 209 }, { 255, 231, 212 }, { 255, 233, 215 },
+    { 255, 235, 219 }, { 255, 237, 222 }, { 255, 239, 225 }, { 255, 241, 228 },
+    { 255, 242, 231 }, { 255, 244, 234 }, { 255, 246, 236 }, { 255, 247, 239 },
+    { 255, 249, 242 }, { 255, 251, 244 }, { 255, 252, 247 }, { 255, 254, 250 },
+    { 255, 255, 255 }, { 254, 248, 255 }, { 249, 246, 255 }, { 246, 244, 255 },
+    { 242, 242, 255 }, { 239, 240, 255 }, { 236, 238, 255 }, { 234, 237, 255 },
+    { 231, 236, 255 }, { 229, 234, 255 }, { 227, 233, 255 }, { 226, 232, 255 },
+    { 224, 231, 255 }, { 222, 230, 255 }, { 221, 229, 255 }, { 219, 228, 255 },
+    { 218, 228, 255 }, { 217, 227, 255 }, { 215, 226, 255 }, { 214, 225, 255 },
+    { 213, 225, 255 }, { 212, 224, 255 }, { 211, 224, 255 }, { 210, 223, 255 },
+    { 209, 222, 255 }, { 208, 222, 255 }, { 207, 221, 255 }, { 206, 221, 255 },
+    { 206, 220, 255 }, { 205, 220, 255 }, { 204, 219, 255 }, { 203, 219, 255 },
+    { 203, 218, 255 }, { 202, 218, 255 }, { 201, 218, 255 }, { 201, 217, 255 },
+    { 200, 217, 255 }, { 199, 216, 255 }, { 199, 216, 255 }, { 198, 216, 255 },
+    { 197, 215, 255 }, { 197, 215, 255 }, { 196, 215, 255 }, { 196, 214, 255 },
+    { 195, 214, 255 }, { 195, 214, 255 }, { 194, 213, 255 }, { 194, 213, 255 },
+    { 193, 213, 255 }, { 193, 212, 255 }, { 192, 212, 255 }, { 192, 212, 255 },
+    { 191, 212, 255 }, { 191, 211, 255 }, { 191, 211, 255 }, { 190, 211, 255 },
+    { 190, 210, 255 }, { 189, 210, 255 }, { 189, 210, 255 }, { 189, 210, 255 },
+    { 188, 209, 255 }, { 188, 209, 255 }, { 187, 209, 255 }, { 187, 209, 255 },
+    { 187, 209, 255 }, { 186, 208, 255 }, { 186, 208, 255 }, { 186, 208, 255 },
+    { 185, 208, 255 }, { 185, 207, 255 }, { 185, 207, 255 }, { 184, 207, 255 },
+    { 184, 207, 255 }, { 184, 207, 255 }, { 183, 206, 255 }, { 183, 206, 255 },
+    { 183, 206, 255 }, { 183, 206, 255 }, { 182, 206, 255 }, { 182, 206, 255 },
+    { 182, 205, 255 }, { 181, 205, 255 }, { 181, 205, 255 }, { 181, 205, 255 },
+    { 181, 205, 255 }, { 180, 204, 255 }, { 180, 204, 255 }, { 180, 204, 255 },
+    { 180, 204, 255 }, { 179, 204, 255 }, { 179, 204, 255 }, { 179, 203, 255 },
+    { 179, 203, 255 }, { 178, 203, 255 }, { 178, 203, 255 }, { 178, 203, 255 },
+    { 178, 203, 255 }, { 177, 203, 255 }, { 177, 202, 255 }, { 177, 202, 255 },
+    { 177, 202, 255 }, { 176, 202, 255 }, { 176, 202, 255 }, { 176, 202, 255 },
+    { 176, 202, 255 }, { 176, 201, 255 }, { 175, 201, 255 }, { 175, 201, 255 },
+    { 175, 201, 255 }, { 175, 201, 255 }, { 175, 201, 255 }, { 174, 201, 255 },
+    { 174, 200, 255 }, { 174, 200, 255 }, { 174, 200, 255 }, { 174, 200, 255 },
+    { 173, 200, 255 }, { 173, 200, 255 }, { 173, 200, 255 }, { 173, 200, 255 },
+    { 173, 199, 255 }, { 172, 199, 255 }, { 172, 199, 255 }, { 172, 199, 255 },
+    { 172, 199, 255 }, { 172, 199, 255 }, { 172, 199, 255 }, { 171, 199, 255 },
+    { 171, 199, 255 }, { 171, 198, 255 }, { 171, 198, 255 }, { 171, 198, 255 },
+    { 171, 198, 255 }, { 170, 198, 255 }, { 170, 198, 255 }, { 170, 198, 255 },
+    { 170, 198, 255 }, { 170, 198, 255 }, { 170, 197, 255 }, { 169, 197, 255 },
+    { 169, 197, 255 }, { 169, 197, 255 }, { 169, 197, 255 }, { 169, 197, 255 },
+    { 169, 197, 255 }, { 168, 197, 255 }, { 168, 197, 255 }, { 168, 197, 255 },
+    { 168, 196, 255 }, { 168, 196, 255 }, { 168, 196, 255 }, { 168, 196, 255 },
+    { 167, 196, 255 }, { 167, 196, 255 }, { 167, 196, 255 }, { 167, 196, 255 },
+    { 167, 196, 255 }, { 167, 196, 255 }, { 167, 196, 255 }, { 167, 195, 255 },
+    { 166, 195, 255 }, { 166, 195, 255 }, { 166, 195, 255 }, { 166, 195, 255 },
+    { 166, 195, 255 }, { 166, 195, 255 }, { 166, 195, 255 }, { 165, 195, 255 },
+    { 165, 195, 255 }, { 165, 195, 255 }, { 165, 194, 255 }, { 165, 194, 255 },
+    { 165, 194, 255 }, { 165, 194, 255 }, { 165, 194, 255 }, { 164, 194, 255 },
+    { 164, 194, 255 }, { 164, 194, 255 }, { 164, 194, 255 }, { 164, 194, 255 },
+    { 164, 194, 255 }, { 164, 194, 255 }, { 164, 194, 255 }, { 164, 193, 255 },
+    { 163, 193, 255 }, { 163, 193, 255 }, { 163, 193, 255 }, { 163, 193, 255 },
+    { 163, 193, 255 }, { 163, 193, 255 }, { 163, 193, 255 }, { 163, 193, 255 },
+    { 163, 193, 255 }, { 162, 193, 255 }, { 162, 193, 255 }, { 162, 193, 255 },
+    { 162, 192, 255 }, { 162, 192, 255 }, { 162, 192, 255 }, { 162, 192, 255 },
+    { 162, 192, 255 }, { 162, 192, 255 }, { 161, 192, 255 }, { 161, 192, 255 },
+    { 161, 192, 255 }, { 161, 192, 255 }, { 161, 192, 255 }, { 161, 192, 255 },
+    { 161, 192, 255 }, { 161, 192, 255 }, { 161, 191, 255 }, { 161, 191, 255 },
+    { 160, 191, 255 }, { 160, 191, 255 }, { 160, 191, 255 }, { 160, 191, 255 },
+    { 160, 191, 255 }, { 160, 191, 255 }, { 160, 191, 255 }, { 160, 191, 255 },
+    { 160, 191, 255 }, { 160, 191, 255 }, { 159, 191, 255 }, { 159, 191, 255 },
+    { 159, 191, 255 }, { 159, 191, 255 }, { 159, 190, 255 }, { 159, 190, 255 },
+    { 159, 190, 255 }, { 159, 190, 255 }, { 159, 190, 255 }, { 159, 190, 255 },
+    { 159, 190, 255 }, { 158, 190, 255 }, { 158, 190, 255 }, { 158, 190, 255 },
+    { 158, 190, 255 }, { 158, 190, 255 }, { 158, 190, 255 }, { 158, 190, 255 },
+    { 158, 190, 255 }, { 158, 190, 255 }, { 158, 190, 255 }, { 158, 189, 255 },
+    { 158, 189, 255 }, { 157, 189, 255 }, { 157, 189, 255 }, { 157, 189, 255 },
+    { 157, 189, 255 }, { 157, 189, 255 }, { 157, 189, 255 }, { 157, 189, 255 },
+    { 157, 189, 255 }, { 157, 189, 255 }, { 157, 189, 255 }, { 157, 189, 255 },
+    { 157, 189, 255 }, { 156, 189, 255 }, { 156, 189, 255 }, { 156, 189, 255 },
+    { 156, 189, 255 }, { 156, 188, 255 }, { 156, 188, 255 }, { 156, 188, 255 },
+    { 156, 188, 255 }, { 156, 188, 255 }, { 156, 188, 255 }, { 156, 188, 255 },
+    { 156, 188, 255 }, { 156, 188, 255 }, { 155, 188, 255 }, { 155, 188, 255 },
+    { 155, 188, 255 }, { 155, 188, 255 }, { 155, 188, 255 }, { 155, 188, 255 },
+    { 155, 188, 255 }, { 155, 188, 255 }, { 155, 188, 255 }, { 155, 188, 255 },
+    { 155, 187, 255 }, { 155, 187, 255 }, { 155, 187, 255 }, { 154, 187, 255 },
+    { 154, 187, 255 }, { 154, 187, 255 }, { 154, 187, 255 }, { 154, 187, 255 },
+    { 154, 187, 255 }, { 154, 187, 255 }, { 154, 187, 255 }, { 154, 187, 255 },
+    { 154, 187, 255 }, { 154, 187, 255 }, { 154, 187, 255 }, { 154, 187, 255 },
+    { 154, 187, 255 }, { 154, 187, 255 }, { 153, 187, 255 }, { 153, 187, 255 },
+    { 153, 187, 255 }, { 153, 186, 255 }, { 153, 186, 255 }, { 153, 186, 255 },
+    { 153, 186, 255 }, { 153, 186, 255 }, { 153, 186, 255 }, { 153, 186, 255 },
+    { 153, 186, 255 }, { 153, 186, 255 }, { 153, 186, 255 }, { 153, 186, 255 },
+    { 153, 186, 255 }, { 152, 186, 255 }, { 152, 186, 255 }, { 152, 186, 255 },
+    { 152, 186, 255 }, { 152, 186, 255 }, { 152, 186, 255 }, { 152, 186, 255 },
+    { 152, 186, 255 }, { 152, 186, 255 }, { 152, 186, 255 }, { 152, 185, 255 },
+    { 152, 185, 255 }, { 152, 185, 255 }, { 152, 185, 255 }, { 152, 185, 255 },
+    { 152, 185, 255 }, { 151, 185, 255 }, { 151, 185, 255 }, { 151, 185, 255 },
+    { 151, 185, 255 }, { 151, 185, 255 }, { 151, 185, 255 }
+};
+
+/**
+ * @brief Apply the sRGB gamma to linear light using the gamma table
+ * @param linear - linear light 0..65535 for 0.0..1.0
+ * @return sRGB 0..255, the largest value whose linear light is not
+ *  greater than the given linear light
+ */
+static uint8_t color_rgb_gamma(int32_t linear)
+{
+    unsigned code;
+
+    if (linear <= 0) {
+        return 0;
+    }
+    if (linear >= 65535) {
+        return 255;
+    }
+    code = Color_Gamma_Start[linear >> 7];
+    while ((code < 255) && (Color_Gamma_Linear[code + 1] <= linear)) {
+        code++;
+    }
+
+    return (uint8_t)code;
+}
+
+/**
+ * @brief Convert sRGB to CIE xy using the gamma table and fixed point
+ *  math.  Same as color_rgb_to_xy() within rounding.
+ * @param r - R value of sRGB 0..255
+ * @param g - G value of sRGB 0..255
+ * @param b - B value of sRGB 0..255
+ * @param x_coordinate - return x of CIE xy 0.0..1.0
+ * @param y_coordinate - return y of CIE xy 0.0..1.0
+ * @param brightness - return brightness of the CIE xy color 0..255
+ */
+void color_rgb_to_xy_fast(uint8_t r,
+    uint8_t g,
+    uint8_t b,
+    float *x_coordinate,
+    float *y_coordinate,
+    uint8_t *brightness)
+{
+    uint32_t red = Color_Gamma_Linear[r];
+    uint32_t green = Color_Gamma_Linear[g];
+    uint32_t blue = Color_Gamma_Linear[b];
+    uint32_t X, Y, Z, sum;
+    float x = 0.0f, y = 0.0f;
+
+    /* 65536 x 16384 for 1.0 */
+    X = red * Color_RGB_XYZ[0][0] + green * Color_RGB_XYZ[0][1] +
+        blue * Color_RGB_XYZ[0][2];
+    Y = red * Color_RGB_XYZ[1][0] + green * Color_RGB_XYZ[1][1] +
+        blue * Color_RGB_XYZ[1][2];
+    Z = red * Color_RGB_XYZ[2][0] + green * Color_RGB_XYZ[2][1] +
+        blue * Color_RGB_XYZ[2][2];
+    sum = X + Y + Z;
+    if (sum) {
+        x = (float)X / (float)sum;
+        y = (float)Y / (float)sum;
+    }
+    if (x_coordinate) {
+        *x_coordinate = x;
+    }
+    if (y_coordinate) {
+        *y_coordinate = y;
+    }
+    if (brightness) {
+        *brightness = (uint8_t)(((Y >> 14) * 255UL) / 65535UL);
+    }
+}
+
+/**
+ * @brief Convert sRGB from CIE xy and brightness using fixed point
+ *  math and the gamma table.  Same as color_rgb_from_xy() within
+ *  rounding.
+ * @param red - return R value of sRGB
+ * @param green - return G value of sRGB
+ * @param blue - return B value of sRGB
+ * @param x_coordinate - x of CIE xy
+ * @param y_coordinate - y of CIE xy
+ * @param brightness - brightness of the CIE xy color
+ */
+void color_rgb_from_xy_fast(uint8_t *red,
+    uint8_t *green,
+    uint8_t *blue,
+    float x_coordinate,
+    float y_coordinate,
+    uint8_t brightness)
+{
+    int32_t XYZ[3] = { 0, 0, 0 };
+    int32_t rgb[3] = { 0, 0, 0 };
+    int64_t linear;
+    float scale;
+    unsigned i;
+
+    if ((y_coordinate > 0.0f) && brightness) {
+        /* 65536 for 1.0 */
+        scale = ((float)brightness * 257.0f) / y_coordinate;
+        XYZ[0] = (int32_t)clamp(
+            x_coordinate * scale, -COLOR_XYZ_MAX, COLOR_XYZ_MAX);
+        XYZ[1] = (int32_t)brightness * 257L;
+        XYZ[2] = (int32_t)clamp((1.0f - x_coordinate - y_coordinate) * scale,
+            -COLOR_XYZ_MAX, COLOR_XYZ_MAX);
+        for (i = 0; i < 3; i++) {
+            linear = (int64_t)XYZ[0] * Color_XYZ_RGB[i][0] +
+                (int64_t)XYZ[1] * Color_XYZ_RGB[i][1] +
+                (int64_t)XYZ[2] * Color_XYZ_RGB[i][2];
+            linear /= 4096;
+            if (linear > 65535) {
+                linear = 65535;
+            }
+            rgb[i] = (int32_t)linear;
+        }
+    }
+    if (red) {
+        *red = color_rgb_gamma(rgb[0]);
+    }
+    if (green) {
+        *green = color_rgb_gamma(rgb[1]);
+    }
+    if (blue) {
+        *blue = color_rgb_gamma(rgb[2]);
+    }
+}
+
+/**
+ * @brief Convert arrays of sRGB to CIE xy and brightness
+ * @param rgb - sRGB colors, three octets R, G, B for each color
+ * @param x_coordinate - return x of CIE xy for each color, or NULL
+ * @param y_coordinate - return y of CIE xy for each color, or NULL
+ * @param brightness - return brightness for each color, or NULL
+ * @param count - number of colors
+ */
+void color_rgb_to_xy_batch(const uint8_t *rgb,
+    float *x_coordinate,
+    float *y_coordinate,
+    uint8_t *brightness,
+    unsigned count)
+{
+    unsigned i;
+
+    for (i = 0; i < count; i++) {
+        color_rgb_to_xy_fast(rgb[0], rgb[1], rgb[2],
+            x_coordinate ? &x_coordinate[i] : NULL,
+            y_coordinate ? &y_coordinate[i] : NULL,
+            brightness ? &brightness[i] : NULL);
+        rgb += 3;
+    }
+}
+
+/**
+ * @brief Convert arrays of CIE xy and brightness to sRGB
+ * @param rgb - return sRGB colors, three octets R, G, B for each color
+ * @param x_coordinate - x of CIE xy for each color
+ * @param y_coordinate - y of CIE xy for each color
+ * @param brightness - brightness for each color
+ * @param count - number of colors
+ */
+void color_rgb_from_xy_batch(uint8_t *rgb,
+    const float *x_coordinate,
+    const float *y_coordinate,
+    const uint8_t *brightness,
+    unsigned count)
+{
+    unsigned i;
+
+    for (i = 0; i < count; i++) {
+        color_rgb_from_xy_fast(&rgb[0], &rgb[1], &rgb[2], x_coordinate[i],
+            y_coordinate[i], brightness[i]);
+        rgb += 3;
+    }
+}
+
 /* table for converting RGB to and from ASCII color names */
 struct css_color_rgb {
     const char *name;
@@ -420,3 +784,51 @@ void color_rgb_from_temperature(
         *b = (uint8_t)blue;
     }
 }
+
+/**
+ * @brief Return an RGB color from a color temperature in Kelvin using
+ *  a table of color_rgb_from_temperature() at each 100K.
+ * @param temperature_kelvin - color temperature 1000..40000K
+ * @param r - return R value of sRGB
+ * @param g - return G value of sRGB
+ * @param b - return B value of sRGB
+ */
+void color_rgb_from_temperature_fast(
+    uint16_t temperature_kelvin, uint8_t *r, uint8_t *g, uint8_t *b)
+{
+    const uint8_t *rgb;
+
+    if (temperature_kelvin < 1000) {
+        temperature_kelvin = 1000;
+    } else if (temperature_kelvin > 40000) {
+        temperature_kelvin = 40000;
+    }
+    rgb = Color_Temperature_RGB[(temperature_kelvin / 100) - 10];
+    if (r) {
+        *r = rgb[0];
+    }
+    if (g) {
+        *g = rgb[1];
+    }
+    if (b) {
+        *b = rgb[2];
+    }
+}
+
+/**
+ * @brief Convert an array of color temperatures to sRGB
+ * @param rgb - return sRGB colors, three octets R, G, B for each color
+ * @param temperature_kelvin - color temperature for each color
+ * @param count - number of colors
+ */
+void color_rgb_from_temperature_batch(
+    uint8_t *rgb, const uint16_t *temperature_kelvin, unsigned count)
+{
+    unsigned i;
+
+    for (i = 0; i < count; i++) {
+        color_rgb_from_temperature_fast(
+            temperature_kelvin[i], &rgb[0], &rgb[1], &rgb[2]);
+        rgb += 3;
+    }
+}
@@ -22,6 +22,21 @@ BACNET_STACK_EXPORT
 void color_rgb_from_xy(uint8_t *red, uint8_t *green, uint8_t *blue,
     float x_coordinate, float y_coordinate, uint8_t brightness);
 
+BACNET_STACK_EXPORT
+void color_rgb_to_xy_fast(uint8_t r, uint8_t g, uint8_t b,
+    float *x_coordinate, float *y_coordinate, uint8_t *brightness);
+BACNET_STACK_EXPORT
+void color_rgb_from_xy_fast(uint8_t *red, uint8_t *green, uint8_t *blue,
+    float x_coordinate, float y_coordinate, uint8_t brightness);
+BACNET_STACK_EXPORT
+void color_rgb_to_xy_batch(const uint8_t *rgb,
+    float *x_coordinate, float *y_coordinate, uint8_t *brightness,
+    unsigned count);
+BACNET_STACK_EXPORT
+void color_rgb_from_xy_batch(uint8_t *rgb,
+    const float *x_coordinate, const float *y_coordinate,
+    const uint8_t *brightness, unsigned count);
+
 BACNET_STACK_EXPORT
 const char * color_rgb_to_ascii(uint8_t red, uint8_t green, uint8_t blue);
 BACNET_STACK_EXPORT
@@ -37,6 +52,13 @@ BACNET_STACK_EXPORT
 void color_rgb_from_temperature(
     uint16_t temperature_kelvin,
     uint8_t *r, uint8_t *g, uint8_t *b);
+BACNET_STACK_EXPORT
+void color_rgb_from_temperature_fast(
+    uint16_t temperature_kelvin,
+    uint8_t *r, uint8_t *g, uint8_t *b);
+BACNET_STACK_EXPORT
+void color_rgb_from_temperature_batch(uint8_t *rgb,
+    const uint16_t *temperature_kelvin, unsigned count);
 
 #ifdef __cplusplus
 }
@@ -93,13 +93,17 @@ static int CheckArraySize(OS_Keylist list)
         return FALSE;
     }
 
-    /* indicates the need for more memory allocation */
+    /* indicates the need for more memory allocation - grow by half,
+       so a list built one node at a time is copied O(log N) times */
     if (list->count == list->size) {
-        new_size = list->size + chunk;
+        new_size = list->size + chunk + (list->size / 2);
 
-        /* allow for shrinking memory */
-    } else if ((list->size > chunk) && (list->count < (list->size - chunk))) {
-        new_size = list->size - chunk;
+        /* allow for shrinking memory, leaving room to grow again */
+    } else if ((list->size > chunk) && (list->count < (list->size / 4))) {
+        new_size = list->size / 2;
+        if (new_size < chunk) {
+            new_size = chunk;
+        }
     }
     if (new_size > 0) {
         /* Allocate more room for node pointer array */
@@ -209,7 +213,10 @@ int Keylist_Data_Add(OS_Keylist list, KEY key, void *data)
 
     if (list && CheckArraySize(list)) {
         /* figure out where to put the new node */
-        if (list->count) {
+        if (list->count && (list->array[list->count - 1]->key < key)) {
+            /* keys added in order go on the end - no search or shift */
+            index = list->count;
+        } else if (list->count) {
             (void)FindIndex(list, key, &index);
             if (index < 0) {
                 /* Add to the beginning of the list */
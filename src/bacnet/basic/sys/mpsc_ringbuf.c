@@ -0,0 +1,346 @@
+/**
+ * @file
+ * @brief Lock-free multiple producer, single consumer ring buffer
+ *
+ * @section DESCRIPTION
+ *
+ * Each element has a sequence number.  An element at position pos is
+ * free when its sequence equals pos, and committed when it equals pos+1.
+ * Producers claim positions by compare-and-swap on the head index, fill
+ * the element in place, and then publish it by storing its sequence
+ * with release ordering.  The consumer reads committed elements in
+ * order and frees them by advancing the sequence by element_count.
+ * A producer that is slow to commit only delays the consumer; it never
+ * blocks other producers from reserving.
+ *
+ * To use this library, declare the element store and sequence store,
+ * where count is a power of 2:
+ * {@code
+ * static struct my_packet Packet_Store[8];
+ * static MPSC_RINGBUF_SEQUENCE_STORE(Packet_Sequence, 8);
+ * static MPSC_RING_BUFFER Packet_Queue;
+ *
+ * MPSC_Ringbuf_Init(&Packet_Queue, (uint8_t *)Packet_Store,
+ *     Packet_Sequence, sizeof(struct my_packet), 8);
+ * }
+ *
+ * @section LICENSE
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "bacnet/basic/sys/mpsc_ringbuf.h"
+
+/**
+ * Returns the element at a free running position
+ *
+ * @param b - pointer to MPSC_RING_BUFFER structure
+ * @param pos - position of the element
+ * @return pointer to the element data
+ */
+static uint8_t *mpsc_ringbuf_element(MPSC_RING_BUFFER const *b, unsigned pos)
+{
+    return &b->buffer[(pos & (b->element_count - 1)) * b->element_size];
+}
+
+/**
+ * Returns the sequence for a free running position
+ *
+ * @param b - pointer to MPSC_RING_BUFFER structure
+ * @param pos - position of the element
+ * @return pointer to the sequence number
+ */
+static BACNET_ATOMIC_UINT *mpsc_ringbuf_sequence(
+    MPSC_RING_BUFFER const *b, unsigned pos)
+{
+    return &b->sequence[pos & (b->element_count - 1)];
+}
+
+/**
+ * Claims count consecutive free positions for a producer
+ *
+ * @param b - pointer to MPSC_RING_BUFFER structure
+ * @param count - number of positions to claim
+ * @param pos [out] - first claimed position
+ * @return true if the positions were claimed
+ */
+static bool mpsc_ringbuf_claim(
+    MPSC_RING_BUFFER *b, unsigned count, unsigned *pos)
+{
+    unsigned head, last, sequence;
+    int diff;
+
+    head = BACNET_ATOMIC_LOAD(&b->head);
+    for (;;) {
+        /* the consumer frees in order, so checking the last is enough */
+        last = head + count - 1;
+        sequence = BACNET_ATOMIC_LOAD_ACQUIRE(mpsc_ringbuf_sequence(b, last));
+        diff = (int)(sequence - last);
+        if (diff == 0) {
+            if (BACNET_ATOMIC_CAS(&b->head, &head, head + count)) {
+                *pos = head;
+                return true;
+            }
+        } else if (diff < 0) {
+            /* not yet freed by the consumer - full */
+            return false;
+        } else {
+            /* another producer claimed it - try again */
+            head = BACNET_ATOMIC_LOAD(&b->head);
+        }
+    }
+}
+
+/**
+ * Returns the number of committed and reserved elements
+ *
+ * @param b - pointer to MPSC_RING_BUFFER structure
+ * @return number of elements in use
+ */
+unsigned MPSC_Ringbuf_Count(MPSC_RING_BUFFER const *b)
+{
+    unsigned head, tail;
+
+    if (b) {
+        tail = BACNET_ATOMIC_LOAD_ACQUIRE(&b->tail);
+        head = BACNET_ATOMIC_LOAD_ACQUIRE(&b->head);
+        return head - tail;
+    }
+
+    return 0;
+}
+
+/**
+ * Returns the capacity of the ring buffer
+ *
+ * @param b - pointer to MPSC_RING_BUFFER structure
+ * @return number of elements the ring buffer holds
+ */
+unsigned MPSC_Ringbuf_Size(MPSC_RING_BUFFER const *b)
+{
+    return (b ? b->element_count : 0);
+}
+
+/**
+ * Returns the empty status of the ring buffer
+ *
+ * @param b - pointer to MPSC_RING_BUFFER structure
+ * @return true if no element is committed at the tail
+ */
+bool MPSC_Ringbuf_Empty(MPSC_RING_BUFFER const *b)
+{
+    return (MPSC_Ringbuf_Peek(b) == NULL);
+}
+
+/**
+ * Reserves an element for a producer to fill in place.
+ * The element must be committed with MPSC_Ringbuf_Data_Commit().
+ *
+ * @param b - pointer to MPSC_RING_BUFFER structure
+ * @param ticket [out] - identifies the element for the commit
+ * @return pointer to the element data, or NULL if full
+ */
+void *MPSC_Ringbuf_Data_Reserve(MPSC_RING_BUFFER *b, unsigned *ticket)
+{
+    unsigned pos = 0;
+
+    if (!b || !ticket || !mpsc_ringbuf_claim(b, 1, &pos)) {
+        return NULL;
+    }
+    *ticket = pos;
+
+    return mpsc_ringbuf_element(b, pos);
+}
+
+/**
+ * Commits a reserved element so the consumer can read it
+ *
+ * @param b - pointer to MPSC_RING_BUFFER structure
+ * @param ticket - from MPSC_Ringbuf_Data_Reserve()
+ */
+void MPSC_Ringbuf_Data_Commit(MPSC_RING_BUFFER *b, unsigned ticket)
+{
+    if (b) {
+        BACNET_ATOMIC_STORE_RELEASE(
+            mpsc_ringbuf_sequence(b, ticket), ticket + 1);
+        if (b->notify) {
+            b->notify(b->context);
+        }
+    }
+}
+
+/**
+ * Copies an element into the ring buffer
+ *
+ * @param b - pointer to MPSC_RING_BUFFER structure
+ * @param data_element - element_size bytes to copy
+ * @return true if the element was added
+ */
+bool MPSC_Ringbuf_Put(MPSC_RING_BUFFER *b, const uint8_t *data_element)
+{
+    return (MPSC_Ringbuf_Put_Bulk(b, data_element, 1) == 1);
+}
+
+/**
+ * Copies consecutive elements into the ring buffer, all or nothing,
+ * with a single reservation and a single notify
+ *
+ * @param b - pointer to MPSC_RING_BUFFER structure
+ * @param data_elements - count * element_size bytes to copy
+ * @param count - number of elements
+ * @return number of elements added - count or zero
+ */
+unsigned MPSC_Ringbuf_Put_Bulk(
+    MPSC_RING_BUFFER *b, const uint8_t *data_elements, unsigned count)
+{
+    unsigned pos = 0;
+    unsigned i;
+
+    if (!b || !data_elements || (count == 0) || (count > b->element_count)) {
+        return 0;
+    }
+    if (!mpsc_ringbuf_claim(b, count, &pos)) {
+        return 0;
+    }
+    for (i = 0; i < count; i++) {
+        memcpy(mpsc_ringbuf_element(b, pos + i),
+            &data_elements[i * b->element_size], b->element_size);
+        BACNET_ATOMIC_STORE_RELEASE(
+            mpsc_ringbuf_sequence(b, pos + i), pos + i + 1);
+    }
+    if (b->notify) {
+        b->notify(b->context);
+    }
+
+    return count;
+}
+
+/**
+ * Looks at the oldest committed element without removing it.
+ * Consumer only.
+ *
+ * @param b - pointer to MPSC_RING_BUFFER structure
+ * @return pointer to the element data, or NULL if none is committed
+ */
+void *MPSC_Ringbuf_Peek(MPSC_RING_BUFFER const *b)
+{
+    unsigned tail;
+
+    if (!b) {
+        return NULL;
+    }
+    tail = BACNET_ATOMIC_LOAD(&b->tail);
+    if (BACNET_ATOMIC_LOAD_ACQUIRE(mpsc_ringbuf_sequence(b, tail)) !=
+        (tail + 1)) {
+        return NULL;
+    }
+
+    return mpsc_ringbuf_element(b, tail);
+}
+
+/**
+ * Removes the oldest committed element.  Consumer only.
+ *
+ * @param b - pointer to MPSC_RING_BUFFER structure
+ * @param data_element - element_size bytes to copy into, or NULL
+ * @return true if an element was removed
+ */
+bool MPSC_Ringbuf_Pop(MPSC_RING_BUFFER *b, uint8_t *data_element)
+{
+    return (MPSC_Ringbuf_Pop_Bulk(b, data_element, 1) == 1);
+}
+
+/**
+ * Removes up to count committed elements in order.  Consumer only.
+ *
+ * @param b - pointer to MPSC_RING_BUFFER structure
+ * @param data_elements - count * element_size bytes to copy into, or NULL
+ * @param count - maximum number of elements to remove
+ * @return number of elements removed
+ */
+unsigned MPSC_Ringbuf_Pop_Bulk(
+    MPSC_RING_BUFFER *b, uint8_t *data_elements, unsigned count)
+{
+    unsigned tail;
+    unsigned i;
+
+    if (!b) {
+        return 0;
+    }
+    tail = BACNET_ATOMIC_LOAD(&b->tail);
+    for (i = 0; i < count; i++) {
+        if (BACNET_ATOMIC_LOAD_ACQUIRE(mpsc_ringbuf_sequence(b, tail)) !=
+            (tail + 1)) {
+            break;
+        }
+        if (data_elements) {
+            memcpy(&data_elements[i * b->element_size],
+                mpsc_ringbuf_element(b, tail), b->element_size);
+        }
+        /* free the element for the producer one lap later */
+        BACNET_ATOMIC_STORE_RELEASE(
+            mpsc_ringbuf_sequence(b, tail), tail + b->element_count);
+        tail++;
+    }
+    BACNET_ATOMIC_STORE_RELEASE(&b->tail, tail);
+
+    return i;
+}
+
+/**
+ * Sets the function called after a producer commits elements
+ *
+ * @param b - pointer to MPSC_RING_BUFFER structure
+ * @param notify - function to wake the consumer, or NULL
+ * @param context - passed to the notify function
+ */
+void MPSC_Ringbuf_Notify_Set(
+    MPSC_RING_BUFFER *b, mpsc_ringbuf_notify_function notify, void *context)
+{
+    if (b) {
+        b->notify = notify;
+        b->context = context;
+    }
+}
+
+/**
+ * Initializes the ring buffer
+ *
+ * @param b - pointer to MPSC_RING_BUFFER structure
+ * @param buffer - element_size * element_count bytes of data store
+ * @param sequence - element_count sequence numbers
+ * @param element_size - size of each element in bytes
+ * @param element_count - number of elements - must be a power of 2
+ * @return true if initialized
+ */
+bool MPSC_Ringbuf_Init(MPSC_RING_BUFFER *b,
+    uint8_t *buffer,
+    BACNET_ATOMIC_UINT *sequence,
+    unsigned element_size,
+    unsigned element_count)
+{
+    unsigned i;
+
+    if (!b || !buffer || !sequence || !element_size || !element_count) {
+        return false;
+    }
+    if (element_count & (element_count - 1)) {
+        return false;
+    }
+    b->buffer = buffer;
+    b->sequence = sequence;
+    b->element_size = element_size;
+    b->element_count = element_count;
+    for (i = 0; i < element_count; i++) {
+        BACNET_ATOMIC_INIT(&sequence[i], i);
+    }
+    BACNET_ATOMIC_INIT(&b->head, 0);
+    BACNET_ATOMIC_INIT(&b->tail, 0);
+    b->notify = NULL;
+    b->context = NULL;
+
+    return true;
+}
@@ -0,0 +1,109 @@
+/**
+ * @file
+ * @brief Lock-free multiple producer, single consumer ring buffer
+ *
+ * Fixed size elements, such as whole packets, are reserved and committed
+ * in place by any number of producers and consumed in order by one
+ * consumer.  See the unit tests for usage examples.
+ *
+ * @section LICENSE
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef MPSC_RINGBUF_H
+#define MPSC_RINGBUF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "bacnet/bacnet_stack_exports.h"
+#include "bacnet/basic/sys/atomic.h"
+
+/**
+ * Called by a producer after elements are committed, to wake a waiting
+ * consumer (for example with a futex, eventfd, or RTOS semaphore)
+ */
+typedef void (*mpsc_ringbuf_notify_function)(void *context);
+
+/**
+ * MPSC ring buffer sequence store - one per element
+ *
+ * @{
+ */
+#define MPSC_RINGBUF_SEQUENCE_STORE(b, c) BACNET_ATOMIC_UINT b[c]
+/** @} */
+
+/**
+ * MPSC ring buffer data structure
+ *
+ * @{
+ */
+struct mpsc_ringbuf_t {
+    /** block of memory or array of data */
+    uint8_t *buffer;
+    /** per element sequence number - marks free and committed elements */
+    BACNET_ATOMIC_UINT *sequence;
+    /** how many bytes for each element */
+    unsigned element_size;
+    /** number of elements - power of two */
+    unsigned element_count;
+    /** next element reserved by a producer */
+    BACNET_ATOMIC_UINT head;
+    /** next element read by the consumer */
+    BACNET_ATOMIC_UINT tail;
+    /** optional consumer wake-up hook */
+    mpsc_ringbuf_notify_function notify;
+    void *context;
+};
+typedef struct mpsc_ringbuf_t MPSC_RING_BUFFER;
+/** @} */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    BACNET_STACK_EXPORT
+    unsigned MPSC_Ringbuf_Count(MPSC_RING_BUFFER const *b);
+    BACNET_STACK_EXPORT
+    unsigned MPSC_Ringbuf_Size(MPSC_RING_BUFFER const *b);
+    BACNET_STACK_EXPORT
+    bool MPSC_Ringbuf_Empty(MPSC_RING_BUFFER const *b);
+    /* producers */
+    BACNET_STACK_EXPORT
+    void *MPSC_Ringbuf_Data_Reserve(MPSC_RING_BUFFER * b,
+        unsigned *ticket);
+    BACNET_STACK_EXPORT
+    void MPSC_Ringbuf_Data_Commit(MPSC_RING_BUFFER * b,
+        unsigned ticket);
+    BACNET_STACK_EXPORT
+    bool MPSC_Ringbuf_Put(MPSC_RING_BUFFER * b,
+        const uint8_t * data_element);
+    BACNET_STACK_EXPORT
+    unsigned MPSC_Ringbuf_Put_Bulk(MPSC_RING_BUFFER * b,
+        const uint8_t * data_elements,
+        unsigned count);
+    /* consumer */
+    BACNET_STACK_EXPORT
+    void *MPSC_Ringbuf_Peek(MPSC_RING_BUFFER const *b);
+    BACNET_STACK_EXPORT
+    bool MPSC_Ringbuf_Pop(MPSC_RING_BUFFER * b,
+        uint8_t * data_element);
+    BACNET_STACK_EXPORT
+    unsigned MPSC_Ringbuf_Pop_Bulk(MPSC_RING_BUFFER * b,
+        uint8_t * data_elements,
+        unsigned count);
+    BACNET_STACK_EXPORT
+    void MPSC_Ringbuf_Notify_Set(MPSC_RING_BUFFER * b,
+        mpsc_ringbuf_notify_function notify,
+        void *context);
+    /* Note: element_count must be a power of two */
+    BACNET_STACK_EXPORT
+    bool MPSC_Ringbuf_Init(MPSC_RING_BUFFER * b,
+        uint8_t * buffer,
+        BACNET_ATOMIC_UINT * sequence,
+        unsigned element_size,
+        unsigned element_count);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif
@@ -0,0 +1,838 @@
+/**
+ * @file
+ * @brief Persistent store of written property values
+ *
+ * @section DESCRIPTION
+ *
+ * Each value is a record of a fixed header and the data, padded to
+ * 32 bits.  The records live one after the other in a RAM store that
+ * is laid out exactly like the snapshot file, so start up is one read
+ * of the snapshot followed by a replay of the journal.
+ *
+ * A changed record is marked dirty in RAM.  Persist_Task() appends the
+ * dirty records to the journal, and syncs it, once the oldest change is
+ * PERSIST_FLUSH_MS old.  When the journal grows past PERSIST_JOURNAL_MAX
+ * the live records are written to a new snapshot which replaces the old
+ * one, and the journal is emptied.  A check value on every record
+ * finds a journal record torn by a power loss, which ends the replay.
+ * A record torn by a failed write is cut off the journal, and written
+ * again by the next flush.
+ *
+ * @section LICENSE
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+#include "bacnet/basic/sys/mstimer.h"
+#include "bacnet/basic/sys/persist.h"
+
+/* "BPDB" - identifies a snapshot file */
+#define PERSIST_MAGIC 0x42504442UL
+#define PERSIST_VERSION 1
+/* longest pathname of the snapshot and journal files */
+#ifndef PERSIST_PATHNAME_MAX
+#define PERSIST_PATHNAME_MAX 256
+#endif
+
+/* record flags, in RAM only */
+#define PERSIST_FLAG_DIRTY 0x01
+#define PERSIST_FLAG_DELETED 0x02
+
+typedef struct persist_record {
+    uint32_t object_id;
+    uint32_t object_property;
+    uint32_t array_index;
+    uint8_t priority;
+    uint8_t flags;
+    uint16_t length;
+    /* check value of the rest of the header and the data */
+    uint32_t check;
+} PERSIST_RECORD;
+
+typedef struct persist_file_header {
+    uint32_t magic;
+    uint32_t version;
+    /* octets of records that follow */
+    uint32_t size;
+    uint32_t check;
+} PERSIST_FILE_HEADER;
+
+typedef struct persist_property {
+    BACNET_OBJECT_TYPE object_type;
+    BACNET_PROPERTY_ID object_property;
+} PERSIST_PROPERTY;
+
+/* store of records, aligned for the record header */
+static uint32_t Store[PERSIST_STORE_SIZE / sizeof(uint32_t)];
+static size_t Store_Used;
+static unsigned Store_Dirty;
+static bool Store_Restoring;
+static PERSIST_PROPERTY Property_List[PERSIST_PROPERTY_MAX];
+static unsigned Property_Count;
+static char Snapshot_Pathname[PERSIST_PATHNAME_MAX];
+static char Journal_Pathname[PERSIST_PATHNAME_MAX];
+static FILE *Journal_File;
+static long Journal_Size;
+static struct mstimer Flush_Timer;
+
+/**
+ * Returns the size of a record with its data, padded to 32 bits
+ *
+ * @param length - number of data octets
+ * @return size in octets
+ */
+static size_t persist_record_size(uint16_t length)
+{
+    return sizeof(PERSIST_RECORD) + ((length + 3U) & ~3U);
+}
+
+/**
+ * Returns the record at an offset in the store
+ *
+ * @param offset - octet offset of the record
+ * @return pointer to the record
+ */
+static PERSIST_RECORD *persist_record(size_t offset)
+{
+    return (PERSIST_RECORD *)((uint8_t *)Store + offset);
+}
+
+/**
+ * Returns the data of a record
+ *
+ * @param record - record in the store
+ * @return pointer to the data that follows the header
+ */
+static uint8_t *persist_record_data(PERSIST_RECORD *record)
+{
+    return (uint8_t *)record + sizeof(PERSIST_RECORD);
+}
+
+/**
+ * Computes the FNV-1a check value of some octets
+ *
+ * @param check - check value so far
+ * @param octets - octets to add
+ * @param length - number of octets
+ * @return check value
+ */
+static uint32_t persist_check_octets(
+    uint32_t check, const uint8_t *octets, size_t length)
+{
+    size_t i;
+
+    for (i = 0; i < length; i++) {
+        check ^= octets[i];
+        check *= 16777619UL;
+    }
+
+    return check;
+}
+
+/**
+ * Computes the check value of a record header and its data, as written
+ * to a file
+ *
+ * @param header - record header
+ * @param data - record data
+ * @return check value
+ */
+static uint32_t persist_record_check(
+    const PERSIST_RECORD *header, const uint8_t *data)
+{
+    return persist_check_octets(
+        persist_check_octets(2166136261UL, (const uint8_t *)header,
+            offsetof(PERSIST_RECORD, check)),
+        data, header->length);
+}
+
+/**
+ * Compares a record with a key
+ *
+ * @param record - record in the store
+ * @param key - property and priority
+ * @return true if the record holds the value for the key
+ */
+static bool persist_record_match(PERSIST_RECORD *record, const PERSIST_KEY *key)
+{
+    return (record->object_id ==
+               BACNET_ID_VALUE(key->object_instance, key->object_type)) &&
+        (record->object_property == (uint32_t)key->object_property) &&
+        (record->array_index == key->array_index) &&
+        (record->priority == key->priority);
+}
+
+/**
+ * Finds the live record for a key
+ *
+ * @param key - property and priority
+ * @return offset of the record, or Store_Used if not found
+ */
+static size_t persist_find(const PERSIST_KEY *key)
+{
+    PERSIST_RECORD *record;
+    size_t offset = 0;
+
+    while (offset < Store_Used) {
+        record = persist_record(offset);
+        if (!(record->flags & PERSIST_FLAG_DELETED) &&
+            persist_record_match(record, key)) {
+            break;
+        }
+        offset += persist_record_size(record->length);
+    }
+
+    return offset;
+}
+
+/**
+ * Removes deleted records from the store.  Records deleted but not yet
+ * journaled are kept, so the deletion reaches the journal.
+ */
+static void persist_store_pack(void)
+{
+    PERSIST_RECORD *record;
+    size_t offset = 0, packed = 0, size;
+
+    while (offset < Store_Used) {
+        record = persist_record(offset);
+        size = persist_record_size(record->length);
+        if ((record->flags & PERSIST_FLAG_DELETED) &&
+            !(record->flags & PERSIST_FLAG_DIRTY)) {
+            offset += size;
+            continue;
+        }
+        if (packed != offset) {
+            memmove(persist_record(packed), record, size);
+        }
+        packed += size;
+        offset += size;
+    }
+    Store_Used = packed;
+}
+
+/**
+ * Marks a record changed, and starts the flush timer for the first change
+ *
+ * @param record - record in the store
+ */
+static void persist_record_dirty(PERSIST_RECORD *record)
+{
+    if (!(record->flags & PERSIST_FLAG_DIRTY)) {
+        record->flags |= PERSIST_FLAG_DIRTY;
+        if (Store_Dirty == 0) {
+            mstimer_set(&Flush_Timer, PERSIST_FLUSH_MS);
+        }
+        Store_Dirty++;
+    }
+}
+
+/**
+ * Writes a file to its storage device
+ *
+ * @param file - open file
+ * @return true if the file was written
+ */
+static bool persist_file_sync(FILE *file)
+{
+    if (fflush(file) != 0) {
+        return false;
+    }
+#if defined(__unix__) || defined(__APPLE__)
+    if (fsync(fileno(file)) != 0) {
+        return false;
+    }
+#endif
+
+    return true;
+}
+
+/**
+ * Applies one journal record to the store
+ *
+ * @param header - record header from the journal
+ * @param data - record data from the journal
+ */
+static void persist_journal_apply(PERSIST_RECORD *header, const uint8_t *data)
+{
+    PERSIST_RECORD *record;
+    PERSIST_KEY key;
+    size_t offset;
+
+    key.object_type = (BACNET_OBJECT_TYPE)BACNET_TYPE(header->object_id);
+    key.object_instance = BACNET_INSTANCE(header->object_id);
+    key.object_property = (BACNET_PROPERTY_ID)header->object_property;
+    key.array_index = header->array_index;
+    key.priority = header->priority;
+    if (header->flags & PERSIST_FLAG_DELETED) {
+        offset = persist_find(&key);
+        if (offset < Store_Used) {
+            record = persist_record(offset);
+            record->flags = PERSIST_FLAG_DELETED;
+        }
+    } else {
+        Persist_Value_Set(&key, data, header->length);
+    }
+}
+
+/**
+ * Reads the snapshot file into the store
+ *
+ * @return true if a valid snapshot was read
+ */
+static bool persist_snapshot_read(void)
+{
+    PERSIST_FILE_HEADER header = { 0 };
+    PERSIST_RECORD *record;
+    size_t offset = 0;
+    FILE *file;
+    bool status = false;
+
+    file = fopen(Snapshot_Pathname, "rb");
+    if (!file) {
+        return false;
+    }
+    if ((fread(&header, sizeof(header), 1, file) == 1) &&
+        (header.magic == PERSIST_MAGIC) &&
+        (header.version == PERSIST_VERSION) &&
+        (header.size <= sizeof(Store)) &&
+        (fread(Store, 1, header.size, file) == header.size) &&
+        (persist_check_octets(2166136261UL, (uint8_t *)Store, header.size) ==
+            header.check)) {
+        status = true;
+        /* the records are checked as a whole - just walk them */
+        while (offset < header.size) {
+            record = persist_record(offset);
+            record->flags = 0;
+            offset += persist_record_size(record->length);
+        }
+        Store_Used = (offset == header.size) ? header.size : 0;
+    }
+    fclose(file);
+
+    return status;
+}
+
+/**
+ * Replays the journal file into the store, up to the first torn record
+ *
+ * @return number of records replayed
+ */
+static unsigned persist_journal_read(void)
+{
+    static uint8_t data[PERSIST_VALUE_MAX + 4];
+    PERSIST_RECORD header;
+    size_t size;
+    unsigned count = 0;
+    FILE *file;
+
+    file = fopen(Journal_Pathname, "rb");
+    if (!file) {
+        return 0;
+    }
+    while (fread(&header, sizeof(header), 1, file) == 1) {
+        size = persist_record_size(header.length) - sizeof(header);
+        if ((size > sizeof(data)) || (fread(data, 1, size, file) != size)) {
+            break;
+        }
+        if (persist_record_check(&header, data) != header.check) {
+            break;
+        }
+        persist_journal_apply(&header, data);
+        count++;
+    }
+    fclose(file);
+
+    return count;
+}
+
+/**
+ * Opens the persistent store: restores the snapshot and replays the
+ * journal into RAM, then compacts them into a new snapshot
+ *
+ * @param pathname - base pathname of the snapshot (.snp) and journal (.jnl)
+ * @return true if the store files can be written
+ */
+bool Persist_Init(const char *pathname)
+{
+    bool status;
+
+    Persist_Cleanup();
+    Store_Used = 0;
+    Store_Dirty = 0;
+    if (!pathname ||
+        (strlen(pathname) + 5 > sizeof(Snapshot_Pathname))) {
+        return false;
+    }
+    snprintf(Snapshot_Pathname, sizeof(Snapshot_Pathname), "%s.snp",
+        pathname);
+    snprintf(Journal_Pathname, sizeof(Journal_Pathname), "%s.jnl", pathname);
+    persist_snapshot_read();
+    Store_Restoring = true;
+    persist_journal_read();
+    Store_Restoring = false;
+    /* also drops any torn record at the end of the journal */
+    status = Persist_Compact();
+
+    return status;
+}
+
+/**
+ * Writes any changed values, and closes the journal
+ */
+void Persist_Cleanup(void)
+{
+    if (Journal_File) {
+        Persist_Flush();
+        fclose(Journal_File);
+        Journal_File = NULL;
+    }
+}
+
+/**
+ * Registers a property whose written values are stored
+ *
+ * @param object_type - object type, or MAX_BACNET_OBJECT_TYPE for any type
+ * @param object_property - property
+ * @return true if registered
+ */
+bool Persist_Property_Register(
+    BACNET_OBJECT_TYPE object_type, BACNET_PROPERTY_ID object_property)
+{
+    if (Persist_Property_Enabled(object_type, object_property)) {
+        return true;
+    }
+    if (Property_Count >= PERSIST_PROPERTY_MAX) {
+        return false;
+    }
+    Property_List[Property_Count].object_type = object_type;
+    Property_List[Property_Count].object_property = object_property;
+    Property_Count++;
+
+    return true;
+}
+
+/**
+ * Determines if the written values of a property are stored
+ *
+ * @param object_type - object type
+ * @param object_property - property
+ * @return true if the property is registered for the object type
+ */
+bool Persist_Property_Enabled(
+    BACNET_OBJECT_TYPE object_type, BACNET_PROPERTY_ID object_property)
+{
+    unsigned i;
+
+    for (i = 0; i < Property_Count; i++) {
+        if ((Property_List[i].object_property == object_property) &&
+            ((Property_List[i].object_type == object_type) ||
+                (Property_List[i].object_type == MAX_BACNET_OBJECT_TYPE))) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Stores a value.  Values set while restoring are not journaled again.
+ *
+ * @param key - property and priority
+ * @param data - value, usually BACnet application encoded
+ * @param length - number of octets of data
+ * @return true if the value was stored
+ */
+bool Persist_Value_Set(
+    const PERSIST_KEY *key, const uint8_t *data, uint16_t length)
+{
+    PERSIST_RECORD *record = NULL;
+    size_t offset, size;
+
+    if (!key || (!data && length) || (length > PERSIST_VALUE_MAX)) {
+        return false;
+    }
+    offset = persist_find(key);
+    if (offset < Store_Used) {
+        record = persist_record(offset);
+        if ((record->length == length) &&
+            (memcmp(persist_record_data(record), data, length) == 0)) {
+            return true;
+        }
+        if (record->length != length) {
+            /* replaced by a new record at the end */
+            record->flags |= PERSIST_FLAG_DELETED;
+            record = NULL;
+        }
+    }
+    if (!record) {
+        size = persist_record_size(length);
+        if ((Store_Used + size) > sizeof(Store)) {
+            persist_store_pack();
+        }
+        if ((Store_Used + size) > sizeof(Store)) {
+            return false;
+        }
+        record = persist_record(Store_Used);
+        memset(record, 0, size);
+        record->object_id =
+            BACNET_ID_VALUE(key->object_instance, key->object_type);
+        record->object_property = key->object_property;
+        record->array_index = key->array_index;
+        record->priority = key->priority;
+        record->length = length;
+        Store_Used += size;
+    }
+    if (length) {
+        memcpy(persist_record_data(record), data, length);
+    }
+    if (!Store_Restoring) {
+        persist_record_dirty(record);
+    }
+
+    return true;
+}
+
+/**
+ * Gets a stored value
+ *
+ * @param key - property and priority
+ * @param data - buffer for the value
+ * @param data_size - size of the buffer
+ * @return number of octets of the value, or -1 if not found or too big
+ */
+int Persist_Value_Get(const PERSIST_KEY *key, uint8_t *data, uint16_t data_size)
+{
+    PERSIST_RECORD *record;
+    size_t offset;
+
+    if (!key) {
+        return -1;
+    }
+    offset = persist_find(key);
+    if (offset >= Store_Used) {
+        return -1;
+    }
+    record = persist_record(offset);
+    if (record->length > data_size) {
+        return -1;
+    }
+    if (data && record->length) {
+        memcpy(data, persist_record_data(record), record->length);
+    }
+
+    return record->length;
+}
+
+/**
+ * Deletes a stored value
+ *
+ * @param key - property and priority
+ * @return true if the value was found and deleted
+ */
+bool Persist_Value_Delete(const PERSIST_KEY *key)
+{
+    PERSIST_RECORD *record;
+    size_t offset;
+
+    if (!key) {
+        return false;
+    }
+    offset = persist_find(key);
+    if (offset >= Store_Used) {
+        return false;
+    }
+    record = persist_record(offset);
+    record->flags |= PERSIST_FLAG_DELETED;
+    persist_record_dirty(record);
+
+    return true;
+}
+
+/**
+ * Returns the number of stored values
+ *
+ * @return number of values
+ */
+unsigned Persist_Count(void)
+{
+    PERSIST_RECORD *record;
+    size_t offset = 0;
+    unsigned count = 0;
+
+    while (offset < Store_Used) {
+        record = persist_record(offset);
+        if (!(record->flags & PERSIST_FLAG_DELETED)) {
+            count++;
+        }
+        offset += persist_record_size(record->length);
+    }
+
+    return count;
+}
+
+/**
+ * Passes each stored value to a callback, for example to write it back
+ * to its object.  Values stored by the callback are not journaled again.
+ *
+ * @param callback - function called with each value
+ * @param context - passed to the callback
+ * @return number of values
+ */
+unsigned Persist_Restore(persist_restore_function callback, void *context)
+{
+    PERSIST_RECORD *record;
+    PERSIST_KEY key;
+    size_t offset = 0, used;
+    unsigned count = 0;
+
+    if (!callback) {
+        return 0;
+    }
+    Store_Restoring = true;
+    /* values stored by the callback are appended - don't visit them */
+    used = Store_Used;
+    while (offset < used) {
+        record = persist_record(offset);
+        if (!(record->flags & PERSIST_FLAG_DELETED)) {
+            key.object_type =
+                (BACNET_OBJECT_TYPE)BACNET_TYPE(record->object_id);
+            key.object_instance = BACNET_INSTANCE(record->object_id);
+            key.object_property =
+                (BACNET_PROPERTY_ID)record->object_property;
+            key.array_index = record->array_index;
+            key.priority = record->priority;
+            callback(&key, persist_record_data(record), record->length,
+                context);
+            count++;
+        }
+        offset += persist_record_size(record->length);
+    }
+    Store_Restoring = false;
+
+    return count;
+}
+
+/**
+ * Drops whatever a failed write left after the last whole record of the
+ * journal, so that the next records follow it and are replayed.  If the
+ * journal cannot be reopened, journaling stops until Persist_Task()
+ * compacts the store into a new snapshot and journal.
+ */
+static void persist_journal_rewind(void)
+{
+    bool status = false;
+
+    /* closing also drops the stream buffer, which may hold a part record */
+    fclose(Journal_File);
+    Journal_File = fopen(Journal_Pathname, "r+b");
+    if (Journal_File) {
+        status = true;
+#if defined(__unix__) || defined(__APPLE__)
+        if (ftruncate(fileno(Journal_File), (off_t)Journal_Size) != 0) {
+            status = false;
+        }
+#endif
+        if (fseek(Journal_File, Journal_Size, SEEK_SET) != 0) {
+            status = false;
+        }
+    }
+    if (!status && Journal_File) {
+        fclose(Journal_File);
+        Journal_File = NULL;
+    }
+}
+
+/**
+ * Appends the changed values to the journal, and syncs it.  If a write
+ * fails, the journal is cut back to its last whole record and the values
+ * stay changed, to be written by the next flush.
+ *
+ * @return true if the changed values were written
+ */
+bool Persist_Flush(void)
+{
+    PERSIST_RECORD *record;
+    PERSIST_RECORD header;
+    size_t offset = 0, size;
+    long journal_size = Journal_Size;
+    bool status = true;
+
+    if (Store_Dirty == 0) {
+        return true;
+    }
+    if (!Journal_File) {
+        return false;
+    }
+    while (status && (offset < Store_Used)) {
+        record = persist_record(offset);
+        size = persist_record_size(record->length);
+        if (record->flags & PERSIST_FLAG_DIRTY) {
+            header = *record;
+            /* only the deletion is kept in the journal */
+            header.flags &= PERSIST_FLAG_DELETED;
+            header.check =
+                persist_record_check(&header, persist_record_data(record));
+            status = (fwrite(&header, sizeof(header), 1, Journal_File) ==
+                         1) &&
+                (fwrite(persist_record_data(record), 1,
+                     size - sizeof(header),
+                     Journal_File) == (size - sizeof(header)));
+            journal_size += (long)size;
+        }
+        offset += size;
+    }
+    if (status) {
+        status = persist_file_sync(Journal_File);
+    }
+    if (!status) {
+        persist_journal_rewind();
+        return false;
+    }
+    offset = 0;
+    while (offset < Store_Used) {
+        record = persist_record(offset);
+        record->flags &= ~PERSIST_FLAG_DIRTY;
+        offset += persist_record_size(record->length);
+    }
+    Journal_Size = journal_size;
+    Store_Dirty = 0;
+
+    return true;
+}
+
+/**
+ * Writes the stored values to a new snapshot, replaces the old snapshot,
+ * and empties the journal
+ *
+ * @return true if the snapshot was written
+ */
+bool Persist_Compact(void)
+{
+    char pathname[PERSIST_PATHNAME_MAX + 4];
+    PERSIST_FILE_HEADER header = { 0 };
+    PERSIST_RECORD *record;
+    PERSIST_RECORD record_header;
+    size_t offset = 0, size;
+    FILE *file;
+    bool status = true;
+
+    if (Snapshot_Pathname[0] == 0) {
+        return false;
+    }
+    snprintf(pathname, sizeof(pathname), "%s.tmp", Snapshot_Pathname);
+    file = fopen(pathname, "wb");
+    if (!file) {
+        return false;
+    }
+    /* the header is rewritten once the size and check are known */
+    header.magic = PERSIST_MAGIC;
+    header.version = PERSIST_VERSION;
+    header.check = 2166136261UL;
+    status = (fwrite(&header, sizeof(header), 1, file) == 1);
+    while (status && (offset < Store_Used)) {
+        record = persist_record(offset);
+        size = persist_record_size(record->length);
+        if (!(record->flags & PERSIST_FLAG_DELETED)) {
+            record_header = *record;
+            record_header.flags = 0;
+            header.check = persist_check_octets(header.check,
+                (uint8_t *)&record_header, sizeof(record_header));
+            header.check = persist_check_octets(header.check,
+                persist_record_data(record), size - sizeof(record_header));
+            header.size += (uint32_t)size;
+            status =
+                (fwrite(&record_header, sizeof(record_header), 1, file) ==
+                    1) &&
+                (fwrite(persist_record_data(record), 1,
+                     size - sizeof(record_header),
+                     file) == (size - sizeof(record_header)));
+        }
+        offset += size;
+    }
+    if (status) {
+        status = (fseek(file, 0L, SEEK_SET) == 0) &&
+            (fwrite(&header, sizeof(header), 1, file) == 1) &&
+            persist_file_sync(file);
+    }
+    fclose(file);
+#if defined(_WIN32)
+    if (status) {
+        remove(Snapshot_Pathname);
+    }
+#endif
+    if (!status || (rename(pathname, Snapshot_Pathname) != 0)) {
+        remove(pathname);
+        return false;
+    }
+    /* the snapshot holds everything - nothing is left to journal */
+    offset = 0;
+    while (offset < Store_Used) {
+        record = persist_record(offset);
+        record->flags &= ~PERSIST_FLAG_DIRTY;
+        offset += persist_record_size(record->length);
+    }
+    Store_Dirty = 0;
+    persist_store_pack();
+    if (Journal_File) {
+        fclose(Journal_File);
+    }
+    Journal_File = fopen(Journal_Pathname, "wb");
+    Journal_Size = 0;
+
+    return (Journal_File != NULL);
+}
+
+/**
+ * Gets the time until Persist_Task() writes the changed values, so that
+ * a main loop can sleep until then.
+ *
+ * @return milliseconds until the changed values are written, or
+ *  ULONG_MAX if no value has changed
+ */
+unsigned long Persist_Task_Remaining(void)
+{
+    if (Store_Dirty == 0) {
+        return ULONG_MAX;
+    }
+    if (mstimer_expired(&Flush_Timer)) {
+        return 0;
+    }
+
+    return mstimer_remaining(&Flush_Timer);
+}
+
+/**
+ * Writes changed values to the journal once the oldest change is
+ * PERSIST_FLUSH_MS old, and compacts a large journal.  Call this often,
+ * for example each time through the main loop.
+ */
+void Persist_Task(void)
+{
+    bool status = true;
+
+    if ((Store_Dirty > 0) && mstimer_expired(&Flush_Timer)) {
+        if (Journal_File) {
+            status = Persist_Flush();
+        } else {
+            /* journaling stopped after a failed write */
+            status = Persist_Compact();
+        }
+        if (!status) {
+            /* try again after another flush time */
+            mstimer_restart(&Flush_Timer);
+        }
+    }
+    if (Journal_Size > PERSIST_JOURNAL_MAX) {
+        Persist_Compact();
+    }
+}
@@ -0,0 +1,127 @@
+/**
+ * @file
+ * @brief Persistent store of written property values
+ *
+ * Values are kept in RAM, appended to a journal file by a write-behind
+ * task with bounded latency, and periodically compacted into a binary
+ * snapshot file that is restored with a single read at start up.
+ * See the unit tests for usage examples.
+ *
+ * @section LICENSE
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef PERSIST_H
+#define PERSIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "bacnet/bacnet_stack_exports.h"
+#include "bacnet/bacdef.h"
+#include "bacnet/bacenum.h"
+
+/* size of the RAM store of values, in octets */
+#ifndef PERSIST_STORE_SIZE
+#define PERSIST_STORE_SIZE 16384
+#endif
+/* largest value, in octets */
+#ifndef PERSIST_VALUE_MAX
+#define PERSIST_VALUE_MAX MAX_APDU
+#endif
+/* number of registered persistent properties */
+#ifndef PERSIST_PROPERTY_MAX
+#define PERSIST_PROPERTY_MAX 32
+#endif
+/* longest time a changed value waits in RAM before the journal */
+#ifndef PERSIST_FLUSH_MS
+#define PERSIST_FLUSH_MS 250
+#endif
+/* journal size that triggers compaction into the snapshot */
+#ifndef PERSIST_JOURNAL_MAX
+#define PERSIST_JOURNAL_MAX 65536L
+#endif
+
+/**
+ * Identifies a stored value: the property and priority it was written to
+ *
+ * @{
+ */
+typedef struct persist_key {
+    BACNET_OBJECT_TYPE object_type;
+    uint32_t object_instance;
+    BACNET_PROPERTY_ID object_property;
+    /* BACNET_ARRAY_ALL when not an array element */
+    BACNET_ARRAY_INDEX array_index;
+    /* BACNET_NO_PRIORITY when not commanded */
+    uint8_t priority;
+} PERSIST_KEY;
+/** @} */
+
+/**
+ * Called for each stored value by Persist_Restore()
+ */
+typedef void (*persist_restore_function)(const PERSIST_KEY *key,
+    const uint8_t *data,
+    uint16_t length,
+    void *context);
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    BACNET_STACK_EXPORT
+    bool Persist_Init(
+        const char *pathname);
+    BACNET_STACK_EXPORT
+    void Persist_Cleanup(
+        void);
+
+    BACNET_STACK_EXPORT
+    bool Persist_Property_Register(
+        BACNET_OBJECT_TYPE object_type,
+        BACNET_PROPERTY_ID object_property);
+    BACNET_STACK_EXPORT
+    bool Persist_Property_Enabled(
+        BACNET_OBJECT_TYPE object_type,
+        BACNET_PROPERTY_ID object_property);
+
+    BACNET_STACK_EXPORT
+    bool Persist_Value_Set(
+        const PERSIST_KEY * key,
+        const uint8_t * data,
+        uint16_t length);
+    BACNET_STACK_EXPORT
+    int Persist_Value_Get(
+        const PERSIST_KEY * key,
+        uint8_t * data,
+        uint16_t data_size);
+    BACNET_STACK_EXPORT
+    bool Persist_Value_Delete(
+        const PERSIST_KEY * key);
+    BACNET_STACK_EXPORT
+    unsigned Persist_Count(
+        void);
+
+    BACNET_STACK_EXPORT
+    unsigned Persist_Restore(
+        persist_restore_function callback,
+        void *context);
+
+    BACNET_STACK_EXPORT
+    void Persist_Task(
+        void);
+    BACNET_STACK_EXPORT
+    unsigned long Persist_Task_Remaining(
+        void);
+    BACNET_STACK_EXPORT
+    bool Persist_Flush(
+        void);
+    BACNET_STACK_EXPORT
+    bool Persist_Compact(
+        void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif
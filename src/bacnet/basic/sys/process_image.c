@@ -0,0 +1,457 @@
+/**
+ * @file
+ * @brief Shared memory process image of object values
+ *
+ * @section DESCRIPTION
+ *
+ * Each point record is protected by a sequence lock: the writer makes
+ * the sequence odd, stores the datum and flags, and makes it even again.
+ * A reader copies the record and retries if the sequence was odd or
+ * changed while copying.  After a write, the writer sets the bit for the
+ * point in the change bitmap.  The reader clears a whole bitmap word at
+ * once and then reads the records of the bits that were set, so a write
+ * that races with the clear is seen on the next pass and never lost.
+ *
+ * Points are added by the process that formats the image, normally
+ * before the drivers attach.  Each point is expected to have a single
+ * writer.
+ *
+ * To use this library in one process, without shared memory:
+ * {@code
+ * static uint8_t Image_Store[1024];
+ * static PROCESS_IMAGE Image;
+ *
+ * Process_Image_Format(&Image, Image_Store, sizeof(Image_Store), 16);
+ * }
+ *
+ * @section LICENSE
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "bacnet/bacdef.h"
+#include "bacnet/basic/sys/process_image.h"
+
+/* number of bits in each word of the change bitmap */
+#define PROCESS_IMAGE_WORD_BITS 32
+/* number of times a reader retries a record that is being written */
+#ifndef PROCESS_IMAGE_READ_RETRY
+#define PROCESS_IMAGE_READ_RETRY 1000
+#endif
+
+/**
+ * Returns the number of change bitmap words for a number of points
+ *
+ * @param point_max - number of point records
+ * @return number of words
+ */
+static unsigned process_image_changed_words(unsigned point_max)
+{
+    return (point_max + PROCESS_IMAGE_WORD_BITS - 1) / PROCESS_IMAGE_WORD_BITS;
+}
+
+/**
+ * Returns the number of hash table slots for a number of points,
+ * which keeps the table at most half full
+ *
+ * @param point_max - number of point records
+ * @return number of slots - a power of two
+ */
+static unsigned process_image_hash_size(unsigned point_max)
+{
+    unsigned hash_size = 2;
+
+    while (hash_size < (point_max * 2)) {
+        hash_size <<= 1;
+    }
+
+    return hash_size;
+}
+
+/**
+ * Returns the first hash table slot to probe for an object identifier
+ *
+ * @param image - process image
+ * @param object_id - packed object type and instance
+ * @return slot
+ */
+static unsigned process_image_hash(PROCESS_IMAGE const *image,
+    uint32_t object_id)
+{
+    uint32_t hash = object_id * (uint32_t)2654435761U;
+
+    return (unsigned)(hash >> 7) & (image->header->hash_size - 1);
+}
+
+/**
+ * Sets the section pointers of the handle from a header
+ *
+ * @param image - process image handle
+ * @param memory - start of the process image
+ */
+static void process_image_layout(PROCESS_IMAGE *image, void *memory)
+{
+    uint8_t *octets = memory;
+    size_t offset = sizeof(PROCESS_IMAGE_HEADER);
+
+    image->header = memory;
+    image->changed = (BACNET_ATOMIC_UINT *)&octets[offset];
+    offset += sizeof(BACNET_ATOMIC_UINT) *
+        process_image_changed_words(image->header->point_max);
+    image->hash = (BACNET_ATOMIC_UINT *)&octets[offset];
+    offset += sizeof(BACNET_ATOMIC_UINT) * image->header->hash_size;
+    image->records = (PROCESS_IMAGE_RECORD *)&octets[offset];
+}
+
+/**
+ * Returns the number of octets needed for a process image
+ *
+ * @param point_max - number of point records
+ * @return size in octets
+ */
+size_t Process_Image_Size(unsigned point_max)
+{
+    return sizeof(PROCESS_IMAGE_HEADER) +
+        (sizeof(BACNET_ATOMIC_UINT) * process_image_changed_words(point_max)) +
+        (sizeof(BACNET_ATOMIC_UINT) * process_image_hash_size(point_max)) +
+        (sizeof(PROCESS_IMAGE_RECORD) * point_max);
+}
+
+/**
+ * Formats a block of memory as an empty process image
+ *
+ * @param image - process image handle
+ * @param memory - block of memory, aligned for 32 bit access
+ * @param size - size of the block of memory in octets
+ * @param point_max - number of point records
+ * @return true if formatted
+ */
+bool Process_Image_Format(
+    PROCESS_IMAGE *image, void *memory, size_t size, unsigned point_max)
+{
+    PROCESS_IMAGE_HEADER *header = memory;
+    size_t image_size;
+    unsigned i;
+
+    if (!image || !memory || (point_max == 0)) {
+        return false;
+    }
+    image_size = Process_Image_Size(point_max);
+    if ((image_size > size) || (image_size > UINT32_MAX)) {
+        return false;
+    }
+    memset(memory, 0, image_size);
+    header->size = (uint32_t)image_size;
+    header->point_max = point_max;
+    header->hash_size = process_image_hash_size(point_max);
+    BACNET_ATOMIC_INIT(&header->point_count, 0);
+    process_image_layout(image, memory);
+    for (i = 0; i < process_image_changed_words(point_max); i++) {
+        BACNET_ATOMIC_INIT(&image->changed[i], 0);
+    }
+    for (i = 0; i < header->hash_size; i++) {
+        BACNET_ATOMIC_INIT(&image->hash[i], 0);
+    }
+    BACNET_ATOMIC_FENCE_RELEASE();
+    header->magic = PROCESS_IMAGE_MAGIC;
+
+    return true;
+}
+
+/**
+ * Attaches a handle to a process image formatted by another process
+ *
+ * @param image - process image handle
+ * @param memory - start of the process image
+ * @param size - size of the block of memory in octets
+ * @return true if the memory holds a valid process image
+ */
+bool Process_Image_Attach(PROCESS_IMAGE *image, void *memory, size_t size)
+{
+    PROCESS_IMAGE_HEADER *header = memory;
+
+    if (!image || !memory || (size < sizeof(PROCESS_IMAGE_HEADER))) {
+        return false;
+    }
+    if (header->magic != PROCESS_IMAGE_MAGIC) {
+        return false;
+    }
+    BACNET_ATOMIC_FENCE_ACQUIRE();
+    if ((header->size > size) ||
+        (header->size != Process_Image_Size(header->point_max)) ||
+        (header->hash_size != process_image_hash_size(header->point_max))) {
+        return false;
+    }
+    process_image_layout(image, memory);
+
+    return true;
+}
+
+/**
+ * Returns the number of points in the process image
+ *
+ * @param image - process image handle
+ * @return number of points
+ */
+unsigned Process_Image_Point_Count(PROCESS_IMAGE const *image)
+{
+    if (image && image->header) {
+        return BACNET_ATOMIC_LOAD_ACQUIRE(&image->header->point_count);
+    }
+
+    return 0;
+}
+
+/**
+ * Finds the record index of a point
+ *
+ * @param image - process image handle
+ * @param object_type - BACnet object type of the point
+ * @param object_instance - BACnet object instance of the point
+ * @return record index, or -1 if the point is not found
+ */
+int Process_Image_Point_Index(PROCESS_IMAGE const *image,
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    uint32_t object_id;
+    unsigned slot, probe, index;
+
+    if (!image || !image->header) {
+        return -1;
+    }
+    object_id = BACNET_ID_VALUE(object_instance, object_type);
+    slot = process_image_hash(image, object_id);
+    for (probe = 0; probe < image->header->hash_size; probe++) {
+        index = BACNET_ATOMIC_LOAD_ACQUIRE(&image->hash[slot]);
+        if (index == 0) {
+            break;
+        }
+        if (image->records[index - 1].object_id == object_id) {
+            return (int)(index - 1);
+        }
+        slot = (slot + 1) & (image->header->hash_size - 1);
+    }
+
+    return -1;
+}
+
+/**
+ * Adds a point to the process image.  Only the process that formatted
+ * the image may add points.
+ *
+ * @param image - process image handle
+ * @param object_type - BACnet object type of the point
+ * @param object_instance - BACnet object instance of the point
+ * @return record index of the point, or -1 if the image is full
+ */
+int Process_Image_Point_Add(PROCESS_IMAGE *image,
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    PROCESS_IMAGE_RECORD *record;
+    uint32_t object_id;
+    unsigned slot, index;
+    int found;
+
+    found = Process_Image_Point_Index(image, object_type, object_instance);
+    if (found >= 0) {
+        return found;
+    }
+    if (!image || !image->header ||
+        (object_type > BACNET_MAX_OBJECT) ||
+        (object_instance > BACNET_MAX_INSTANCE)) {
+        return -1;
+    }
+    index = BACNET_ATOMIC_LOAD(&image->header->point_count);
+    if (index >= image->header->point_max) {
+        return -1;
+    }
+    object_id = BACNET_ID_VALUE(object_instance, object_type);
+    record = &image->records[index];
+    record->object_id = object_id;
+    BACNET_ATOMIC_INIT(&record->sequence, 0);
+    BACNET_ATOMIC_INIT(&record->datum, 0);
+    BACNET_ATOMIC_INIT(&record->flags, 0);
+    slot = process_image_hash(image, object_id);
+    while (BACNET_ATOMIC_LOAD(&image->hash[slot]) != 0) {
+        slot = (slot + 1) & (image->header->hash_size - 1);
+    }
+    BACNET_ATOMIC_STORE_RELEASE(&image->hash[slot], index + 1);
+    BACNET_ATOMIC_STORE_RELEASE(&image->header->point_count, index + 1);
+
+    return (int)index;
+}
+
+/**
+ * Updates the value and status flags of a point, and marks it changed
+ *
+ * @param image - process image handle
+ * @param index - record index of the point
+ * @param value - value and status flags; the object type and instance
+ *  are not used
+ * @return true if the point was updated
+ */
+bool Process_Image_Write(
+    PROCESS_IMAGE *image, int index, const PROCESS_IMAGE_VALUE *value)
+{
+    PROCESS_IMAGE_RECORD *record;
+    BACNET_ATOMIC_UINT *word;
+    unsigned sequence, bits, bit;
+    uint32_t datum = 0;
+
+    if (!image || !value || (index < 0) ||
+        ((unsigned)index >= Process_Image_Point_Count(image))) {
+        return false;
+    }
+    switch (value->tag) {
+        case BACNET_APPLICATION_TAG_BOOLEAN:
+            datum = value->type.Boolean ? 1 : 0;
+            break;
+        case BACNET_APPLICATION_TAG_SIGNED_INT:
+            datum = (uint32_t)value->type.Signed_Int;
+            break;
+        case BACNET_APPLICATION_TAG_REAL:
+            memcpy(&datum, &value->type.Real, sizeof(datum));
+            break;
+        case BACNET_APPLICATION_TAG_UNSIGNED_INT:
+        case BACNET_APPLICATION_TAG_ENUMERATED:
+            datum = value->type.Unsigned_Int;
+            break;
+        case BACNET_APPLICATION_TAG_NULL:
+            break;
+        default:
+            return false;
+    }
+    record = &image->records[index];
+    /* an odd sequence left by a writer that died is simply reused */
+    sequence = BACNET_ATOMIC_LOAD(&record->sequence) | 1;
+    BACNET_ATOMIC_STORE(&record->sequence, sequence);
+    BACNET_ATOMIC_FENCE_RELEASE();
+    BACNET_ATOMIC_STORE(&record->datum, datum);
+    BACNET_ATOMIC_STORE(&record->flags,
+        ((unsigned)value->tag << 8) | (value->status_flags & 0x0F));
+    BACNET_ATOMIC_STORE_RELEASE(&record->sequence, sequence + 1);
+    /* mark the point changed, after the record */
+    BACNET_ATOMIC_FENCE_RELEASE();
+    word = &image->changed[(unsigned)index / PROCESS_IMAGE_WORD_BITS];
+    bit = 1U << ((unsigned)index % PROCESS_IMAGE_WORD_BITS);
+    bits = BACNET_ATOMIC_LOAD(word);
+    while (!(bits & bit)) {
+        if (BACNET_ATOMIC_CAS(word, &bits, bits | bit)) {
+            break;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Copies the value and status flags of a point
+ *
+ * @param image - process image handle
+ * @param index - record index of the point
+ * @param value [out] - value, status flags, object type and instance
+ * @return true if a consistent copy was read
+ */
+bool Process_Image_Read(
+    PROCESS_IMAGE const *image, int index, PROCESS_IMAGE_VALUE *value)
+{
+    PROCESS_IMAGE_RECORD *record;
+    unsigned sequence, flags = 0, retry;
+    uint32_t datum = 0;
+    bool status = false;
+
+    if (!image || !value || (index < 0) ||
+        ((unsigned)index >= Process_Image_Point_Count(image))) {
+        return false;
+    }
+    record = &image->records[index];
+    for (retry = 0; retry < PROCESS_IMAGE_READ_RETRY; retry++) {
+        sequence = BACNET_ATOMIC_LOAD_ACQUIRE(&record->sequence);
+        if (sequence & 1) {
+            continue;
+        }
+        datum = BACNET_ATOMIC_LOAD(&record->datum);
+        flags = BACNET_ATOMIC_LOAD(&record->flags);
+        BACNET_ATOMIC_FENCE_ACQUIRE();
+        if (BACNET_ATOMIC_LOAD(&record->sequence) == sequence) {
+            status = true;
+            break;
+        }
+    }
+    if (!status) {
+        return false;
+    }
+    value->object_type = (BACNET_OBJECT_TYPE)BACNET_TYPE(record->object_id);
+    value->object_instance = BACNET_INSTANCE(record->object_id);
+    value->tag = (uint8_t)(flags >> 8);
+    value->status_flags = (uint8_t)(flags & 0x0F);
+    switch (value->tag) {
+        case BACNET_APPLICATION_TAG_BOOLEAN:
+            value->type.Boolean = (datum != 0);
+            break;
+        case BACNET_APPLICATION_TAG_SIGNED_INT:
+            value->type.Signed_Int = (int32_t)datum;
+            break;
+        case BACNET_APPLICATION_TAG_REAL:
+            memcpy(&value->type.Real, &datum, sizeof(datum));
+            break;
+        default:
+            value->type.Unsigned_Int = datum;
+            break;
+    }
+
+    return true;
+}
+
+/**
+ * Takes the points changed since the last call, and passes the value
+ * of each to a callback.  Only one process may take the changes.
+ *
+ * @param image - process image handle
+ * @param callback - function called for each changed point, or NULL
+ * @param context - passed to the callback
+ * @return number of changed points
+ */
+unsigned Process_Image_Changes(PROCESS_IMAGE *image,
+    process_image_change_function callback,
+    void *context)
+{
+    PROCESS_IMAGE_VALUE value;
+    unsigned words, word, bits, bit;
+    unsigned count = 0;
+
+    if (!image || !image->header) {
+        return 0;
+    }
+    words = process_image_changed_words(image->header->point_max);
+    for (word = 0; word < words; word++) {
+        bits = BACNET_ATOMIC_LOAD(&image->changed[word]);
+        if (bits == 0) {
+            continue;
+        }
+        while (!BACNET_ATOMIC_CAS(&image->changed[word], &bits, 0)) {
+            /* a writer set another bit - try again */
+        }
+        /* pairs with the fence before a writer sets a bit */
+        BACNET_ATOMIC_FENCE_ACQUIRE();
+        for (bit = 0; bits; bit++, bits >>= 1) {
+            if (!(bits & 1)) {
+                continue;
+            }
+            if (Process_Image_Read(image,
+                    (int)((word * PROCESS_IMAGE_WORD_BITS) + bit), &value)) {
+                count++;
+                if (callback) {
+                    callback(&value, context);
+                }
+            }
+        }
+    }
+
+    return count;
+}
@@ -0,0 +1,167 @@
+/**
+ * @file
+ * @brief Shared memory process image of object values
+ *
+ * A process image is a table of point records, keyed by object type and
+ * instance, in a block of memory that can be shared with other processes
+ * (for example, a Modbus or OPC driver) through a memory mapped file.
+ * Writers update a record under a sequence lock and then set the bit
+ * for the record in a change bitmap; the BACnet server takes the changed
+ * bits and reads only those records.  Neither side ever blocks.
+ * See the unit tests for usage examples.
+ *
+ * @section LICENSE
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef PROCESS_IMAGE_H
+#define PROCESS_IMAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "bacnet/bacnet_stack_exports.h"
+#include "bacnet/bacenum.h"
+#include "bacnet/basic/sys/atomic.h"
+
+/* "BPI1" - identifies a formatted process image */
+#define PROCESS_IMAGE_MAGIC 0x42504931UL
+
+/**
+ * Process image layout in shared memory, followed by the change bitmap,
+ * the hash table of object identifiers, and the point records
+ *
+ * @{
+ */
+typedef struct process_image_header {
+    uint32_t magic;
+    /** size of the whole process image in octets */
+    uint32_t size;
+    /** number of point records */
+    uint32_t point_max;
+    /** number of hash table slots - power of two */
+    uint32_t hash_size;
+    /** number of points added */
+    BACNET_ATOMIC_UINT point_count;
+} PROCESS_IMAGE_HEADER;
+
+typedef struct process_image_record {
+    /** odd while a writer is updating the record */
+    BACNET_ATOMIC_UINT sequence;
+    /** 32 bit datum of the value */
+    BACNET_ATOMIC_UINT datum;
+    /** application tag in bits 8-15, status flags in bits 0-3 */
+    BACNET_ATOMIC_UINT flags;
+    /** object type and instance - written once when the point is added */
+    uint32_t object_id;
+} PROCESS_IMAGE_RECORD;
+/** @} */
+
+/**
+ * Process image handle, local to each process
+ *
+ * @{
+ */
+typedef struct process_image {
+    PROCESS_IMAGE_HEADER *header;
+    BACNET_ATOMIC_UINT *changed;
+    BACNET_ATOMIC_UINT *hash;
+    PROCESS_IMAGE_RECORD *records;
+} PROCESS_IMAGE;
+/** @} */
+
+/**
+ * Value of a point, copied out of or into the process image
+ *
+ * @{
+ */
+typedef struct process_image_value {
+    BACNET_OBJECT_TYPE object_type;
+    uint32_t object_instance;
+    /** BACNET_APPLICATION_TAG of the value */
+    uint8_t tag;
+    /** bit STATUS_FLAG_IN_ALARM .. STATUS_FLAG_OUT_OF_SERVICE set */
+    uint8_t status_flags;
+    union {
+        bool Boolean;
+        uint32_t Unsigned_Int;
+        int32_t Signed_Int;
+        float Real;
+        uint32_t Enumerated;
+    } type;
+} PROCESS_IMAGE_VALUE;
+/** @} */
+
+/**
+ * Called for each changed point by Process_Image_Changes()
+ */
+typedef void (*process_image_change_function)(
+    const PROCESS_IMAGE_VALUE *value, void *context);
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    BACNET_STACK_EXPORT
+    size_t Process_Image_Size(
+        unsigned point_max);
+    BACNET_STACK_EXPORT
+    bool Process_Image_Format(
+        PROCESS_IMAGE * image,
+        void *memory,
+        size_t size,
+        unsigned point_max);
+    BACNET_STACK_EXPORT
+    bool Process_Image_Attach(
+        PROCESS_IMAGE * image,
+        void *memory,
+        size_t size);
+
+    BACNET_STACK_EXPORT
+    int Process_Image_Point_Add(
+        PROCESS_IMAGE * image,
+        BACNET_OBJECT_TYPE object_type,
+        uint32_t object_instance);
+    BACNET_STACK_EXPORT
+    int Process_Image_Point_Index(
+        PROCESS_IMAGE const *image,
+        BACNET_OBJECT_TYPE object_type,
+        uint32_t object_instance);
+    BACNET_STACK_EXPORT
+    unsigned Process_Image_Point_Count(
+        PROCESS_IMAGE const *image);
+
+    /* writer */
+    BACNET_STACK_EXPORT
+    bool Process_Image_Write(
+        PROCESS_IMAGE * image,
+        int index,
+        const PROCESS_IMAGE_VALUE * value);
+
+    /* reader */
+    BACNET_STACK_EXPORT
+    bool Process_Image_Read(
+        PROCESS_IMAGE const *image,
+        int index,
+        PROCESS_IMAGE_VALUE * value);
+    BACNET_STACK_EXPORT
+    unsigned Process_Image_Changes(
+        PROCESS_IMAGE * image,
+        process_image_change_function callback,
+        void *context);
+
+    /* shared memory - provided by the port */
+    BACNET_STACK_EXPORT
+    void *Process_Image_Map(
+        const char *name,
+        size_t *size,
+        bool create);
+    BACNET_STACK_EXPORT
+    void Process_Image_Unmap(
+        void *memory,
+        size_t size);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif
@@ -0,0 +1,358 @@
+/**
+ * @file
+ * @brief Lock-free single producer, single consumer FIFO of bytes
+ *
+ * @section DESCRIPTION
+ *
+ * The head index is written only by the producer and the tail index
+ * only by the consumer, so one producer thread (or ISR) and one consumer
+ * thread can share the FIFO without a mutex.  Each side publishes its
+ * index with release ordering after copying the bytes, and loads the
+ * other side's index with acquire ordering before copying.  Bulk
+ * operations copy a span with at most two memcpy calls and publish it
+ * with a single index update.
+ *
+ * Packets are framed with a two octet length so that a whole frame is
+ * added or pulled in one operation.  Byte and packet operations should
+ * not be mixed on the same FIFO.
+ *
+ * To use this library, declare a data store sized for a power of 2 and
+ * initialize the FIFO with it:
+ * {@code
+ * static uint8_t data_store[1024];
+ * static SPSC_FIFO queue;
+ *
+ * SPSC_FIFO_Init(&queue, data_store, sizeof(data_store));
+ * }
+ *
+ * @section LICENSE
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "bacnet/basic/sys/spsc_fifo.h"
+
+/* octets used to frame each packet */
+#define SPSC_FIFO_PACKET_HEADER 2
+
+/**
+ * Copies bytes into the data store, wrapping at the end
+ *
+ * @param b - pointer to SPSC_FIFO structure
+ * @param index - free running index of the first byte
+ * @param data - bytes to copy
+ * @param count - number of bytes to copy
+ */
+static void spsc_fifo_copy_in(
+    SPSC_FIFO *b, unsigned index, const uint8_t *data, unsigned count)
+{
+    unsigned offset = index & (b->buffer_len - 1);
+    unsigned first = b->buffer_len - offset;
+
+    if (first > count) {
+        first = count;
+    }
+    memcpy(&b->buffer[offset], data, first);
+    if (count > first) {
+        memcpy(&b->buffer[0], &data[first], count - first);
+    }
+}
+
+/**
+ * Copies bytes out of the data store, wrapping at the end
+ *
+ * @param b - pointer to SPSC_FIFO structure
+ * @param index - free running index of the first byte
+ * @param data - buffer for the bytes
+ * @param count - number of bytes to copy
+ */
+static void spsc_fifo_copy_out(
+    SPSC_FIFO const *b, unsigned index, uint8_t *data, unsigned count)
+{
+    unsigned offset = index & (b->buffer_len - 1);
+    unsigned first = b->buffer_len - offset;
+
+    if (first > count) {
+        first = count;
+    }
+    memcpy(data, &b->buffer[offset], first);
+    if (count > first) {
+        memcpy(&data[first], &b->buffer[0], count - first);
+    }
+}
+
+/**
+ * Returns the number of bytes in the FIFO
+ *
+ * @param b - pointer to SPSC_FIFO structure
+ *
+ * @return Number of bytes in the FIFO
+ */
+unsigned SPSC_FIFO_Count(SPSC_FIFO const *b)
+{
+    unsigned head, tail;
+
+    if (b) {
+        tail = BACNET_ATOMIC_LOAD_ACQUIRE(&b->tail);
+        head = BACNET_ATOMIC_LOAD_ACQUIRE(&b->head);
+        return head - tail;
+    }
+
+    return 0;
+}
+
+/**
+ * Returns the full status of the FIFO
+ *
+ * @param b - pointer to SPSC_FIFO structure
+ *
+ * @return true if the FIFO is full, false if it is not.
+ */
+bool SPSC_FIFO_Full(SPSC_FIFO const *b)
+{
+    return (b ? (SPSC_FIFO_Count(b) >= b->buffer_len) : true);
+}
+
+/**
+ * Tests to see if space is available in the FIFO
+ *
+ * @param b - pointer to SPSC_FIFO structure
+ * @param count [in] - number of bytes tested for availability
+ *
+ * @return true if the number of bytes sought is available
+ */
+bool SPSC_FIFO_Available(SPSC_FIFO const *b, unsigned count)
+{
+    return (b ? (count <= (b->buffer_len - SPSC_FIFO_Count(b))) : false);
+}
+
+/**
+ * Returns the empty status of the FIFO
+ *
+ * @param b - pointer to SPSC_FIFO structure
+ *
+ * @return true if the FIFO is empty, false if it is not.
+ */
+bool SPSC_FIFO_Empty(SPSC_FIFO const *b)
+{
+    return (b ? (SPSC_FIFO_Count(b) == 0) : true);
+}
+
+/**
+ * Adds a byte of data to the FIFO.  Producer only.
+ *
+ * @param b - pointer to SPSC_FIFO structure
+ * @param data_byte [in] - data to put into the FIFO
+ *
+ * @return true on successful add, false if not added
+ */
+bool SPSC_FIFO_Put(SPSC_FIFO *b, uint8_t data_byte)
+{
+    return SPSC_FIFO_Add(b, &data_byte, 1);
+}
+
+/**
+ * Adds a span of bytes to the FIFO, all or nothing.  Producer only.
+ *
+ * @param b - pointer to SPSC_FIFO structure
+ * @param data_bytes [in] - data bytes to add to the FIFO
+ * @param count [in] - number of bytes to add to the FIFO
+ *
+ * @return true if space available and added, false if not added
+ */
+bool SPSC_FIFO_Add(SPSC_FIFO *b, const uint8_t *data_bytes, unsigned count)
+{
+    unsigned head, tail;
+
+    if (!b || !data_bytes || (count == 0)) {
+        return false;
+    }
+    head = BACNET_ATOMIC_LOAD(&b->head);
+    tail = BACNET_ATOMIC_LOAD_ACQUIRE(&b->tail);
+    if (count > (b->buffer_len - (head - tail))) {
+        return false;
+    }
+    spsc_fifo_copy_in(b, head, data_bytes, count);
+    BACNET_ATOMIC_STORE_RELEASE(&b->head, head + count);
+    if (b->notify) {
+        b->notify(b->context);
+    }
+
+    return true;
+}
+
+/**
+ * Adds a whole packet to the FIFO, all or nothing.  Producer only.
+ *
+ * @param b - pointer to SPSC_FIFO structure
+ * @param packet [in] - packet to add to the FIFO
+ * @param length [in] - number of bytes in the packet, not zero
+ *
+ * @return true if space available and added, false if not added
+ */
+bool SPSC_FIFO_Packet_Add(SPSC_FIFO *b, const uint8_t *packet, uint16_t length)
+{
+    unsigned head, tail;
+    uint8_t header[SPSC_FIFO_PACKET_HEADER];
+
+    if (!b || !packet || (length == 0)) {
+        return false;
+    }
+    head = BACNET_ATOMIC_LOAD(&b->head);
+    tail = BACNET_ATOMIC_LOAD_ACQUIRE(&b->tail);
+    if ((SPSC_FIFO_PACKET_HEADER + (unsigned)length) >
+        (b->buffer_len - (head - tail))) {
+        return false;
+    }
+    header[0] = (uint8_t)(length >> 8);
+    header[1] = (uint8_t)(length & 0xFF);
+    spsc_fifo_copy_in(b, head, header, SPSC_FIFO_PACKET_HEADER);
+    spsc_fifo_copy_in(b, head + SPSC_FIFO_PACKET_HEADER, packet, length);
+    BACNET_ATOMIC_STORE_RELEASE(
+        &b->head, head + SPSC_FIFO_PACKET_HEADER + length);
+    if (b->notify) {
+        b->notify(b->context);
+    }
+
+    return true;
+}
+
+/**
+ * Gets a byte from the front of the FIFO, and removes it.  Consumer only.
+ *
+ * @param b - pointer to SPSC_FIFO structure
+ *
+ * @return the data, or zero if the FIFO is empty
+ */
+uint8_t SPSC_FIFO_Get(SPSC_FIFO *b)
+{
+    uint8_t data_byte = 0;
+
+    (void)SPSC_FIFO_Pull(b, &data_byte, 1);
+
+    return data_byte;
+}
+
+/**
+ * Pulls up to length bytes from the front of the FIFO.  Consumer only.
+ *
+ * @param b - pointer to SPSC_FIFO structure
+ * @param data_bytes [out] - buffer to hold the pulled bytes, or NULL
+ *  to discard them
+ * @param length [in] - number of bytes to pull from the FIFO
+ *
+ * @return the number of bytes actually pulled from the FIFO
+ */
+unsigned SPSC_FIFO_Pull(SPSC_FIFO *b, uint8_t *data_bytes, unsigned length)
+{
+    unsigned head, tail, count;
+
+    if (!b) {
+        return 0;
+    }
+    tail = BACNET_ATOMIC_LOAD(&b->tail);
+    head = BACNET_ATOMIC_LOAD_ACQUIRE(&b->head);
+    count = head - tail;
+    if (count > length) {
+        count = length;
+    }
+    if (count) {
+        if (data_bytes) {
+            spsc_fifo_copy_out(b, tail, data_bytes, count);
+        }
+        BACNET_ATOMIC_STORE_RELEASE(&b->tail, tail + count);
+    }
+
+    return count;
+}
+
+/**
+ * Pulls the next whole packet from the FIFO.  Consumer only.
+ * A packet larger than packet_size is discarded.
+ *
+ * @param b - pointer to SPSC_FIFO structure
+ * @param packet [out] - buffer to hold the packet
+ * @param packet_size [in] - size of the packet buffer
+ *
+ * @return number of bytes in the packet, or zero if none was pulled
+ */
+uint16_t SPSC_FIFO_Packet_Pull(
+    SPSC_FIFO *b, uint8_t *packet, uint16_t packet_size)
+{
+    unsigned head, tail;
+    uint16_t length, packet_length;
+    uint8_t header[SPSC_FIFO_PACKET_HEADER];
+
+    if (!b) {
+        return 0;
+    }
+    tail = BACNET_ATOMIC_LOAD(&b->tail);
+    head = BACNET_ATOMIC_LOAD_ACQUIRE(&b->head);
+    if ((head - tail) < SPSC_FIFO_PACKET_HEADER) {
+        return 0;
+    }
+    spsc_fifo_copy_out(b, tail, header, SPSC_FIFO_PACKET_HEADER);
+    packet_length = ((uint16_t)header[0] << 8) | header[1];
+    if (packet && (packet_length <= packet_size)) {
+        spsc_fifo_copy_out(
+            b, tail + SPSC_FIFO_PACKET_HEADER, packet, packet_length);
+        length = packet_length;
+    } else {
+        length = 0;
+    }
+    BACNET_ATOMIC_STORE_RELEASE(
+        &b->tail, tail + SPSC_FIFO_PACKET_HEADER + packet_length);
+
+    return length;
+}
+
+/**
+ * Flushes any data in the FIFO.  Consumer only.
+ *
+ * @param b - pointer to SPSC_FIFO structure
+ */
+void SPSC_FIFO_Flush(SPSC_FIFO *b)
+{
+    if (b) {
+        BACNET_ATOMIC_STORE_RELEASE(
+            &b->tail, BACNET_ATOMIC_LOAD_ACQUIRE(&b->head));
+    }
+}
+
+/**
+ * Sets the function called after the producer adds data
+ *
+ * @param b - pointer to SPSC_FIFO structure
+ * @param notify - function to wake the consumer, or NULL
+ * @param context - passed to the notify function
+ */
+void SPSC_FIFO_Notify_Set(
+    SPSC_FIFO *b, spsc_fifo_notify_function notify, void *context)
+{
+    if (b) {
+        b->notify = notify;
+        b->context = context;
+    }
+}
+
+/**
+ * Initializes the FIFO with a data store
+ *
+ * @param b - pointer to SPSC_FIFO structure
+ * @param buffer [in] - data bytes used to store bytes used by the FIFO
+ * @param buffer_len [in] - size of the buffer in bytes - must be power of 2.
+ */
+void SPSC_FIFO_Init(SPSC_FIFO *b, uint8_t *buffer, unsigned buffer_len)
+{
+    if (b && buffer && buffer_len) {
+        BACNET_ATOMIC_INIT(&b->head, 0);
+        BACNET_ATOMIC_INIT(&b->tail, 0);
+        b->buffer = buffer;
+        b->buffer_len = buffer_len;
+        b->notify = NULL;
+        b->context = NULL;
+    }
+}
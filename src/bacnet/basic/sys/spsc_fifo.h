@@ -0,0 +1,124 @@
+/**
+ * @file
+ * @brief Lock-free single producer, single consumer FIFO of bytes
+ *
+ * Same usage as the FIFO library, with bulk byte span and whole packet
+ * operations and a notify hook for a waiting consumer.
+ * See the unit tests for usage examples.
+ *
+ * @section LICENSE
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef SPSC_FIFO_H
+#define SPSC_FIFO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "bacnet/bacnet_stack_exports.h"
+#include "bacnet/basic/sys/atomic.h"
+
+/**
+ * Called by the producer after data is added, to wake a waiting consumer
+ * (for example with a futex, eventfd, or RTOS semaphore)
+ */
+typedef void (*spsc_fifo_notify_function)(void *context);
+
+/**
+ * SPSC FIFO data structure
+ *
+ * @{
+ */
+struct spsc_fifo_t {
+    /** next byte written - only changed by the producer */
+    BACNET_ATOMIC_UINT head;
+    /** next byte read - only changed by the consumer */
+    BACNET_ATOMIC_UINT tail;
+    /** block of memory or array of data */
+    uint8_t *buffer;
+    /** length of the data - power of two */
+    unsigned buffer_len;
+    /** optional consumer wake-up hook */
+    spsc_fifo_notify_function notify;
+    void *context;
+};
+typedef struct spsc_fifo_t SPSC_FIFO;
+/** @} */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    BACNET_STACK_EXPORT
+    unsigned SPSC_FIFO_Count(
+        SPSC_FIFO const *b);
+
+    BACNET_STACK_EXPORT
+    bool SPSC_FIFO_Full(
+        SPSC_FIFO const *b);
+
+    BACNET_STACK_EXPORT
+    bool SPSC_FIFO_Available(
+        SPSC_FIFO const *b,
+        unsigned count);
+
+    BACNET_STACK_EXPORT
+    bool SPSC_FIFO_Empty(
+        SPSC_FIFO const *b);
+
+    /* producer */
+    BACNET_STACK_EXPORT
+    bool SPSC_FIFO_Put(
+        SPSC_FIFO * b,
+        uint8_t data_byte);
+
+    BACNET_STACK_EXPORT
+    bool SPSC_FIFO_Add(
+        SPSC_FIFO * b,
+        const uint8_t * data_bytes,
+        unsigned count);
+
+    BACNET_STACK_EXPORT
+    bool SPSC_FIFO_Packet_Add(
+        SPSC_FIFO * b,
+        const uint8_t * packet,
+        uint16_t length);
+
+    /* consumer */
+    BACNET_STACK_EXPORT
+    uint8_t SPSC_FIFO_Get(
+        SPSC_FIFO * b);
+
+    BACNET_STACK_EXPORT
+    unsigned SPSC_FIFO_Pull(
+        SPSC_FIFO * b,
+        uint8_t * data_bytes,
+        unsigned length);
+
+    BACNET_STACK_EXPORT
+    uint16_t SPSC_FIFO_Packet_Pull(
+        SPSC_FIFO * b,
+        uint8_t * packet,
+        uint16_t packet_size);
+
+    BACNET_STACK_EXPORT
+    void SPSC_FIFO_Flush(
+        SPSC_FIFO * b);
+
+    BACNET_STACK_EXPORT
+    void SPSC_FIFO_Notify_Set(
+        SPSC_FIFO * b,
+        spsc_fifo_notify_function notify,
+        void *context);
+
+/* note: buffer_len must be a power of two */
+    BACNET_STACK_EXPORT
+    void SPSC_FIFO_Init(
+        SPSC_FIFO * b,
+        uint8_t * buffer,
+        unsigned buffer_len);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif
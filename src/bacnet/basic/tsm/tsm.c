@@ -63,11 +63,36 @@ uint8_t Handler_Transmit_Buffer[MAX_PDU];
 /* table rules: an Invoke ID = 0 is an unused spot in the table */
 static BACNET_TSM_DATA TSM_List[MAX_TSM_TRANSACTIONS];
 
+/* first transaction holding each invoke ID, as index + 1, chained
+   through Next, so a reply finds its transaction without a table scan */
+static unsigned TSM_Invoke_Head[256];
+
 /* invoke ID for incrementing between subsequent calls. */
 static uint8_t Current_Invoke_ID = 1;
 
 static tsm_timeout_function Timeout_Function;
 
+/* round trip time estimates of a peer, in milliseconds */
+typedef struct tsm_peer {
+    BACNET_ADDRESS dest;
+    /* smoothed round trip time */
+    uint16_t SRTT;
+    /* round trip time variation */
+    uint16_t RTTVAR;
+    /* timeout of the next request */
+    uint16_t RTO;
+    /* stamp of the last use, to replace the least recently used peer */
+    uint32_t Used;
+    bool InUse;
+} TSM_PEER;
+
+static TSM_PEER TSM_Peer[MAX_TSM_PEERS];
+static uint32_t TSM_Peer_Stamp;
+
+/* milliseconds of the last timer step.  A reply is only seen to take
+   whole steps, so a request timeout is at least two of them. */
+static uint16_t TSM_Timer_Step;
+
 void tsm_set_timeout_handler(tsm_timeout_function pFunction)
 {
     Timeout_Function = pFunction;
@@ -76,26 +101,248 @@ void tsm_set_timeout_handler(tsm_timeout_function pFunction)
 /** Find the given Invoke-Id in the list and
  *  return the index.
  *
+ *  An invoke ID from tsm_next_free_invokeID() is unique in the table.
+ *  An invoke ID from tsm_next_free_invokeID_async() is unique for its
+ *  peer, and is only found when the peer is given.
+ *
  * @param invokeID  Invoke Id
+ * @param peer  Address the request was sent to, or NULL
  *
  * @return Index of the id or MAX_TSM_TRANSACTIONS
  *         if not found
  */
-static uint8_t tsm_find_invokeID_index(uint8_t invokeID)
+static unsigned tsm_find_index(uint8_t invokeID, BACNET_ADDRESS *peer)
 {
-    unsigned i = 0; /* counter */
-    uint8_t index = MAX_TSM_TRANSACTIONS; /* return value */
+    unsigned link;
+    BACNET_TSM_DATA *plist;
 
-    const BACNET_TSM_DATA *plist = TSM_List;
+    if (invokeID == 0) {
+        return MAX_TSM_TRANSACTIONS;
+    }
+    for (link = TSM_Invoke_Head[invokeID]; link != 0; link = plist->Next) {
+        plist = &TSM_List[link - 1];
+        if (!plist->Complete) {
+            return link - 1;
+        }
+        if (peer && bacnet_address_same(&plist->dest, peer)) {
+            return link - 1;
+        }
+    }
 
-    for (i = 0; i < MAX_TSM_TRANSACTIONS; i++, plist++) {
-        if (plist->InvokeID == invokeID) {
-            index = (uint8_t)i;
-            break;
+    return MAX_TSM_TRANSACTIONS;
+}
+
+/** Find the given Invoke-Id in the list and
+ *  return the index.
+ *
+ * @param invokeID  Invoke Id
+ *
+ * @return Index of the id or MAX_TSM_TRANSACTIONS
+ *         if not found
+ */
+static unsigned tsm_find_invokeID_index(uint8_t invokeID)
+{
+    return tsm_find_index(invokeID, NULL);
+}
+
+/** Finds the round trip time estimates of a peer.
+ *
+ * @param dest  Address of the peer
+ *
+ * @return the estimates, or NULL if the peer has none
+ */
+static TSM_PEER *tsm_peer_find(BACNET_ADDRESS *dest)
+{
+    unsigned i;
+
+    if (dest) {
+        for (i = 0; i < MAX_TSM_PEERS; i++) {
+            if (TSM_Peer[i].InUse &&
+                bacnet_address_same(&TSM_Peer[i].dest, dest)) {
+                return &TSM_Peer[i];
+            }
         }
     }
 
-    return index;
+    return NULL;
+}
+
+/** Bounds a request timeout.
+ *
+ * @param milliseconds  Request timeout
+ *
+ * @return the request timeout within TSM_RTO_MIN, two timer steps,
+ *  and TSM_RTO_MAX
+ */
+static uint16_t tsm_rto_bound(uint32_t milliseconds)
+{
+    uint32_t minimum = TSM_RTO_MIN;
+
+    if (minimum < (2UL * TSM_Timer_Step)) {
+        minimum = 2UL * TSM_Timer_Step;
+    }
+    if (milliseconds < minimum) {
+        milliseconds = minimum;
+    }
+    if (milliseconds > TSM_RTO_MAX) {
+        milliseconds = TSM_RTO_MAX;
+    }
+
+    return (uint16_t)milliseconds;
+}
+
+/** Adds a round trip time sample to the estimates of a peer, and
+ *  computes its request timeout, as in RFC 6298.
+ *
+ * @param dest  Address of the peer
+ * @param rtt  Round trip time, in milliseconds
+ */
+static void tsm_peer_sample(BACNET_ADDRESS *dest, uint16_t rtt)
+{
+    TSM_PEER *peer;
+    uint16_t delta;
+    unsigned i;
+
+    peer = tsm_peer_find(dest);
+    if (peer) {
+        if (peer->SRTT > rtt) {
+            delta = peer->SRTT - rtt;
+        } else {
+            delta = rtt - peer->SRTT;
+        }
+        peer->RTTVAR = (uint16_t)((3UL * peer->RTTVAR + delta) / 4);
+        peer->SRTT = (uint16_t)((7UL * peer->SRTT + rtt) / 8);
+    } else {
+        /* a free entry, or else the least recently used one */
+        peer = &TSM_Peer[0];
+        for (i = 0; i < MAX_TSM_PEERS; i++) {
+            if (!TSM_Peer[i].InUse) {
+                peer = &TSM_Peer[i];
+                break;
+            }
+            if ((TSM_Peer_Stamp - TSM_Peer[i].Used) >
+                (TSM_Peer_Stamp - peer->Used)) {
+                peer = &TSM_Peer[i];
+            }
+        }
+        bacnet_address_copy(&peer->dest, dest);
+        peer->InUse = true;
+        peer->SRTT = rtt;
+        peer->RTTVAR = rtt / 2;
+    }
+    peer->RTO = tsm_rto_bound((uint32_t)peer->SRTT + 4UL * peer->RTTVAR);
+    peer->Used = ++TSM_Peer_Stamp;
+}
+
+/** Doubles the request timeout of a peer whose request timed out.
+ *
+ * @param dest  Address of the peer
+ */
+static void tsm_peer_backoff(BACNET_ADDRESS *dest)
+{
+    TSM_PEER *peer;
+
+    peer = tsm_peer_find(dest);
+    if (peer) {
+        peer->RTO = tsm_rto_bound(2UL * peer->RTO);
+    }
+}
+
+/** Takes a round trip time sample from a transaction that got its
+ *  reply.  A request that was sent again gives no sample (Karn),
+ *  since the reply may be to any of its copies.
+ *
+ * @param index  Index of the transaction
+ */
+static void tsm_transaction_sample(unsigned index)
+{
+    BACNET_TSM_DATA *plist = &TSM_List[index];
+
+    if ((plist->state == TSM_STATE_AWAIT_CONFIRMATION) &&
+        (plist->RetryCount == 0)) {
+        tsm_peer_sample(
+            &plist->dest, plist->RequestTimeout - plist->RequestTimer);
+    }
+}
+
+/** Gets the timeout of the next request to a peer.
+ *
+ * @param dest  Address of the peer
+ *
+ * @return request timeout in milliseconds, from the round trip times
+ *  of the peer, or the APDU timeout if there are none
+ */
+uint16_t tsm_peer_timeout(BACNET_ADDRESS *dest)
+{
+    TSM_PEER *peer;
+
+    peer = tsm_peer_find(dest);
+    if (peer) {
+        peer->Used = ++TSM_Peer_Stamp;
+        return peer->RTO;
+    }
+
+    return apdu_timeout();
+}
+
+/** Limits the timeout of a try of a request to its share of the time
+ *  left, so that all the tries of a request take no longer than
+ *  APDU_Timeout x (Number_Of_APDU_Retries + 1).
+ *
+ * @param plist  Transaction of the request
+ * @param milliseconds  Timeout wanted for the try
+ *
+ * @return timeout of the try, in milliseconds
+ */
+static uint16_t tsm_request_timeout(
+    BACNET_TSM_DATA *plist, uint32_t milliseconds)
+{
+    uint32_t share;
+
+    /* this try, and the retries after it */
+    share = plist->RequestTimeLeft /
+        ((uint32_t)apdu_retries() - plist->RetryCount + 1UL);
+    if (milliseconds > share) {
+        milliseconds = share;
+    }
+    if (milliseconds > UINT16_MAX) {
+        milliseconds = UINT16_MAX;
+    }
+
+    return (uint16_t)milliseconds;
+}
+
+/** Gets the round trip time estimates of a peer, for diagnostics.
+ *
+ * @param dest  Address of the peer
+ * @param srtt  Filled with the smoothed round trip time, if not NULL
+ * @param rttvar  Filled with the round trip time variation, if not NULL
+ * @param rto  Filled with the timeout of the next request, if not NULL
+ *
+ * @return true if the peer has estimates, all in milliseconds
+ */
+bool tsm_peer_rtt(BACNET_ADDRESS *dest,
+    uint16_t *srtt,
+    uint16_t *rttvar,
+    uint16_t *rto)
+{
+    TSM_PEER *peer;
+
+    peer = tsm_peer_find(dest);
+    if (!peer) {
+        return false;
+    }
+    if (srtt) {
+        *srtt = peer->SRTT;
+    }
+    if (rttvar) {
+        *rttvar = peer->RTTVAR;
+    }
+    if (rto) {
+        *rto = peer->RTO;
+    }
+
+    return true;
 }
 
 /** Find the first free index in the TSM table.
@@ -103,16 +350,16 @@ static uint8_t tsm_find_invokeID_index(uint8_t invokeID)
  * @return Index of the id or MAX_TSM_TRANSACTIONS
  *         if no entry is free.
  */
-static uint8_t tsm_find_first_free_index(void)
+static unsigned tsm_find_first_free_index(void)
 {
     unsigned i = 0; /* counter */
-    uint8_t index = MAX_TSM_TRANSACTIONS; /* return value */
+    unsigned index = MAX_TSM_TRANSACTIONS; /* return value */
 
     const BACNET_TSM_DATA *plist = TSM_List;
 
     for (i = 0; i < MAX_TSM_TRANSACTIONS; i++, plist++) {
         if (plist->InvokeID == 0) {
-            index = (uint8_t)i;
+            index = i;
             break;
         }
     }
@@ -120,6 +367,56 @@ static uint8_t tsm_find_first_free_index(void)
     return index;
 }
 
+/** Gives a transaction its invoke ID.
+ *
+ * @param index  Index of the transaction
+ * @param invokeID  Invoke Id, not zero
+ */
+static void tsm_invoke_id_link(unsigned index, uint8_t invokeID)
+{
+    BACNET_TSM_DATA *plist = &TSM_List[index];
+
+    plist->InvokeID = invokeID;
+    plist->Next = TSM_Invoke_Head[invokeID];
+    TSM_Invoke_Head[invokeID] = index + 1;
+}
+
+/** Frees a transaction and its invoke ID.
+ *
+ * @param index  Index of the transaction
+ */
+static void tsm_invoke_id_unlink(unsigned index)
+{
+    BACNET_TSM_DATA *plist = &TSM_List[index];
+    unsigned *link;
+
+    if (plist->InvokeID != 0) {
+        link = &TSM_Invoke_Head[plist->InvokeID];
+        while (*link != 0) {
+            if (*link == (index + 1)) {
+                *link = plist->Next;
+                break;
+            }
+            link = &TSM_List[*link - 1].Next;
+        }
+    }
+    plist->state = TSM_STATE_IDLE;
+    plist->InvokeID = 0;
+    plist->Next = 0;
+    plist->Complete = NULL;
+    plist->Context = NULL;
+}
+
+/** Advances the invoke ID for the next call or check. */
+static void tsm_invoke_id_advance(void)
+{
+    Current_Invoke_ID++;
+    /* skip zero - we treat that internally as invalid or no free */
+    if (Current_Invoke_ID == 0) {
+        Current_Invoke_ID = 1;
+    }
+}
+
 /** Check if space for transactions is available.
  *
  * @return true/false
@@ -156,7 +453,9 @@ uint8_t tsm_transaction_idle_count(void)
     for (i = 0; i < MAX_TSM_TRANSACTIONS; i++, plist++) {
         if ((plist->InvokeID == 0) && (plist->state == TSM_STATE_IDLE)) {
             /* one is available! */
-            count++;
+            if (count < UINT8_MAX) {
+                count++;
+            }
         }
     }
 
@@ -180,52 +479,163 @@ void tsm_invokeID_set(uint8_t invokeID)
  * and reserves a spot in the table
  * returns 0 if none are available.
  *
+ * The invoke ID is not used by any other transaction, whatever its peer.
+ *
  * @return free invoke ID
  */
 uint8_t tsm_next_free_invokeID(void)
 {
-    uint8_t index = 0;
+    unsigned index = 0;
+    unsigned tries = 0;
     uint8_t invokeID = 0;
-    bool found = false;
-    BACNET_TSM_DATA *plist = NULL;
 
     /* Is there even space available? */
-    if (tsm_transaction_available()) {
-        while (!found) {
-            index = tsm_find_invokeID_index(Current_Invoke_ID);
-            if (index == MAX_TSM_TRANSACTIONS) {
+    index = tsm_find_first_free_index();
+    if (index != MAX_TSM_TRANSACTIONS) {
+        for (tries = 0; tries < UINT8_MAX; tries++) {
+            if (TSM_Invoke_Head[Current_Invoke_ID] == 0) {
                 /* Not found, so this invokeID is not used */
-                found = true;
-                /* set this id into the table */
-                index = tsm_find_first_free_index();
-                if (index != MAX_TSM_TRANSACTIONS) {
-                    plist = &TSM_List[index];
-                    plist->InvokeID = invokeID = Current_Invoke_ID;
-                    plist->state = TSM_STATE_IDLE;
-                    plist->RequestTimer = apdu_timeout();
-                    /* update for the next call or check */
-                    Current_Invoke_ID++;
-                    /* skip zero - we treat that internally as invalid or no
-                     * free */
-                    if (Current_Invoke_ID == 0) {
-                        Current_Invoke_ID = 1;
-                    }
-                }
-            } else {
-                /* found! This invokeID is already used */
-                /* try next one */
-                Current_Invoke_ID++;
-                /* skip zero - we treat that internally as invalid or no free */
-                if (Current_Invoke_ID == 0) {
-                    Current_Invoke_ID = 1;
-                }
+                invokeID = Current_Invoke_ID;
+                tsm_invoke_id_link(index, invokeID);
+                TSM_List[index].state = TSM_STATE_IDLE;
+                TSM_List[index].RequestTimeout = apdu_timeout();
+                TSM_List[index].RequestTimer = apdu_timeout();
+                /* update for the next call or check */
+                tsm_invoke_id_advance();
+                break;
+            }
+            /* found! This invokeID is already used - try next one */
+            tsm_invoke_id_advance();
+        }
+    }
+
+    return invokeID;
+}
+
+/** Gets the next invokeID that is free for a peer,
+ * and reserves a spot in the table for a request to that peer
+ * whose reply or timeout is given to a completion function.
+ * Since BACnet scopes invoke IDs to the pair of devices, up to
+ * 255 requests may be in flight to each peer, up to the size of
+ * the table, MAX_TSM_TRANSACTIONS.
+ *
+ * @param dest  Address the request will be sent to
+ * @param pFunction  Called once with the reply or timeout, after the
+ *  invoke ID has been freed
+ * @param context  Given to the completion function
+ *
+ * @return free invoke ID, or 0 if none are available.
+ */
+uint8_t tsm_next_free_invokeID_async(
+    BACNET_ADDRESS *dest, tsm_complete_function pFunction, void *context)
+{
+    unsigned index = 0;
+    unsigned tries = 0;
+    unsigned link;
+    uint8_t invokeID = 0;
+    BACNET_TSM_DATA *plist;
+    bool used;
+
+    if (!dest || !pFunction) {
+        return 0;
+    }
+    index = tsm_find_first_free_index();
+    if (index == MAX_TSM_TRANSACTIONS) {
+        return 0;
+    }
+    for (tries = 0; tries < UINT8_MAX; tries++) {
+        /* an invoke ID that is unique in the table is in use for
+           every peer, since its destination is not yet known */
+        used = false;
+        for (link = TSM_Invoke_Head[Current_Invoke_ID]; link != 0;
+             link = plist->Next) {
+            plist = &TSM_List[link - 1];
+            if (!plist->Complete || bacnet_address_same(&plist->dest, dest)) {
+                used = true;
+                break;
             }
         }
+        if (!used) {
+            invokeID = Current_Invoke_ID;
+            plist = &TSM_List[index];
+            bacnet_address_copy(&plist->dest, dest);
+            plist->Complete = pFunction;
+            plist->Context = context;
+            tsm_invoke_id_link(index, invokeID);
+            plist->state = TSM_STATE_IDLE;
+            plist->RequestTimeout = apdu_timeout();
+            plist->RequestTimer = apdu_timeout();
+            tsm_invoke_id_advance();
+            break;
+        }
+        tsm_invoke_id_advance();
     }
 
     return invokeID;
 }
 
+/** Gives a reply to the completion function of its request,
+ *  and frees the invoke ID.
+ *
+ * @param completion  The reply; src and invoke_id identify the request
+ *
+ * @return true if the reply was for a request with a completion
+ *  function, which was called.
+ */
+bool tsm_complete(BACNET_TSM_COMPLETION *completion)
+{
+    unsigned index;
+    tsm_complete_function pFunction;
+    void *context;
+
+    if (!completion || !completion->src) {
+        return false;
+    }
+    index = tsm_find_index(completion->invoke_id, completion->src);
+    if ((index == MAX_TSM_TRANSACTIONS) || !TSM_List[index].Complete) {
+        return false;
+    }
+    pFunction = TSM_List[index].Complete;
+    context = TSM_List[index].Context;
+    tsm_transaction_sample(index);
+    /* free first, so the completion function can send another request */
+    tsm_invoke_id_unlink(index);
+    pFunction(completion, context);
+
+    return true;
+}
+
+/** Cancels a request that has a completion function,
+ *  without calling the completion function.  A late reply to it
+ *  goes to the global confirmed-ACK, Error, Reject and Abort handlers,
+ *  like any reply without a transaction.
+ *
+ * @param invokeID  Invoke-ID of the request
+ * @param dest  Address the request was sent to
+ * @param context  Filled with the context of the request, if not NULL
+ *
+ * @return true if the request was found and canceled.
+ */
+bool tsm_cancel_invoke_id(
+    uint8_t invokeID, BACNET_ADDRESS *dest, void **context)
+{
+    unsigned index;
+
+    if (!dest) {
+        return false;
+    }
+    index = tsm_find_index(invokeID, dest);
+    if ((index == MAX_TSM_TRANSACTIONS) || !TSM_List[index].Complete) {
+        return false;
+    }
+    if (context) {
+        *context = TSM_List[index].Context;
+    }
+    tsm_invoke_id_unlink(index);
+
+    return true;
+}
+
 /** Set for an unsegmented transaction
  *  the state to await confirmation.
  *
@@ -242,18 +652,22 @@ void tsm_set_confirmed_unsegmented_transaction(uint8_t invokeID,
     uint16_t apdu_len)
 {
     uint16_t j = 0;
-    uint8_t index;
+    unsigned index;
     BACNET_TSM_DATA *plist;
 
     if (invokeID && ndpu_data && apdu && (apdu_len > 0)) {
-        index = tsm_find_invokeID_index(invokeID);
+        index = tsm_find_index(invokeID, dest);
         if (index < MAX_TSM_TRANSACTIONS) {
             plist = &TSM_List[index];
             /* SendConfirmedUnsegmented */
             plist->state = TSM_STATE_AWAIT_CONFIRMATION;
             plist->RetryCount = 0;
-            /* start the timer */
-            plist->RequestTimer = apdu_timeout();
+            /* start the timer with the timeout of the peer */
+            plist->RequestTimeLeft =
+                (uint32_t)apdu_timeout() * (apdu_retries() + 1UL);
+            plist->RequestTimeout =
+                tsm_request_timeout(plist, tsm_peer_timeout(dest));
+            plist->RequestTimer = plist->RequestTimeout;
             /* copy the data */
             for (j = 0; j < apdu_len; j++) {
                 plist->apdu[j] = apdu[j];
@@ -286,7 +700,7 @@ bool tsm_get_transaction_pdu(uint8_t invokeID,
     uint16_t *apdu_len)
 {
     uint16_t j = 0;
-    uint8_t index;
+    unsigned index;
     bool found = false;
     BACNET_TSM_DATA *plist;
 
@@ -314,6 +728,28 @@ bool tsm_get_transaction_pdu(uint8_t invokeID,
     return found;
 }
 
+/** Gives a timeout to the completion function of a request,
+ *  and frees the invoke ID.
+ *
+ * @param index  Index of the transaction
+ */
+static void tsm_timeout_complete(unsigned index)
+{
+    BACNET_TSM_COMPLETION completion = { 0 };
+    BACNET_ADDRESS dest;
+    tsm_complete_function pFunction;
+    void *context;
+
+    pFunction = TSM_List[index].Complete;
+    context = TSM_List[index].Context;
+    bacnet_address_copy(&dest, &TSM_List[index].dest);
+    completion.result = TSM_RESULT_TIMEOUT;
+    completion.invoke_id = TSM_List[index].InvokeID;
+    completion.src = &dest;
+    tsm_invoke_id_unlink(index);
+    pFunction(&completion, context);
+}
+
 /** Called once a millisecond or slower.
  *  This function calls the handler for a
  *  timeout 'Timeout_Function', if necessary.
@@ -326,6 +762,9 @@ void tsm_timer_milliseconds(uint16_t milliseconds)
 
     BACNET_TSM_DATA *plist = &TSM_List[0];
 
+    if (milliseconds) {
+        TSM_Timer_Step = milliseconds;
+    }
     for (i = 0; i < MAX_TSM_TRANSACTIONS; i++, plist++) {
         if (plist->state == TSM_STATE_AWAIT_CONFIRMATION) {
             if (plist->RequestTimer > milliseconds) {
@@ -333,11 +772,24 @@ void tsm_timer_milliseconds(uint16_t milliseconds)
             } else {
                 plist->RequestTimer = 0;
             }
+            if (plist->RequestTimeLeft > milliseconds) {
+                plist->RequestTimeLeft -= milliseconds;
+            } else {
+                plist->RequestTimeLeft = 0;
+            }
             /* AWAIT_CONFIRMATION */
             if (plist->RequestTimer == 0) {
                 if (plist->RetryCount < apdu_retries()) {
-                    plist->RequestTimer = apdu_timeout();
                     plist->RetryCount++;
+                    if (tsm_peer_find(&plist->dest)) {
+                        /* back off: each retry waits twice as long,
+                           within the time left for the request */
+                        plist->RequestTimeout = tsm_request_timeout(plist,
+                            tsm_rto_bound(2UL * plist->RequestTimeout));
+                    } else {
+                        plist->RequestTimeout = apdu_timeout();
+                    }
+                    plist->RequestTimer = plist->RequestTimeout;
                     datalink_send_pdu(&plist->dest, &plist->npdu_data,
                         &plist->apdu[0], plist->apdu_len);
                 } else {
@@ -345,7 +797,10 @@ void tsm_timer_milliseconds(uint16_t milliseconds)
                        and this indicates a failed message:
                        IDLE and a valid invoke id */
                     plist->state = TSM_STATE_IDLE;
-                    if (plist->InvokeID != 0) {
+                    tsm_peer_backoff(&plist->dest);
+                    if (plist->Complete) {
+                        tsm_timeout_complete(i);
+                    } else if (plist->InvokeID != 0) {
                         if (Timeout_Function) {
                             Timeout_Function(plist->InvokeID);
                         }
@@ -356,20 +811,40 @@ void tsm_timer_milliseconds(uint16_t milliseconds)
     }
 }
 
+/** Gets the time until the next transaction timer expires, so that a
+ *  caller can wait exactly that long before calling
+ *  tsm_timer_milliseconds() again.
+ *
+ * @return milliseconds until the next retry or timeout, or UINT16_MAX
+ *  if no transaction is waiting for a confirmation
+ */
+uint16_t tsm_timer_milliseconds_remaining(void)
+{
+    uint16_t milliseconds = UINT16_MAX;
+    unsigned i = 0; /* counter */
+
+    for (i = 0; i < MAX_TSM_TRANSACTIONS; i++) {
+        if ((TSM_List[i].state == TSM_STATE_AWAIT_CONFIRMATION) &&
+            (TSM_List[i].RequestTimer < milliseconds)) {
+            milliseconds = TSM_List[i].RequestTimer;
+        }
+    }
+
+    return milliseconds;
+}
+
 /** Frees the invokeID and sets its state to IDLE
  *
  * @param invokeID  Invoke-ID
  */
 void tsm_free_invoke_id(uint8_t invokeID)
 {
-    uint8_t index;
-    BACNET_TSM_DATA *plist;
+    unsigned index;
 
     index = tsm_find_invokeID_index(invokeID);
     if (index < MAX_TSM_TRANSACTIONS) {
-        plist = &TSM_List[index];
-        plist->state = TSM_STATE_IDLE;
-        plist->InvokeID = 0;
+        tsm_transaction_sample(index);
+        tsm_invoke_id_unlink(index);
     }
 }
 
@@ -381,7 +856,7 @@ void tsm_free_invoke_id(uint8_t invokeID)
 bool tsm_invoke_id_free(uint8_t invokeID)
 {
     bool status = true;
-    uint8_t index;
+    unsigned index;
 
     index = tsm_find_invokeID_index(invokeID);
     if (index < MAX_TSM_TRANSACTIONS) {
@@ -401,7 +876,7 @@ bool tsm_invoke_id_free(uint8_t invokeID)
 bool tsm_invoke_id_failed(uint8_t invokeID)
 {
     bool status = false;
-    uint8_t index;
+    unsigned index;
 
     index = tsm_find_invokeID_index(invokeID);
     if (index < MAX_TSM_TRANSACTIONS) {
@@ -47,10 +47,55 @@ extern "C" {
 }
 #endif /* __cplusplus */
 
+/* how a confirmed request with a completion function ended */
+typedef enum {
+    TSM_RESULT_ACK,
+    TSM_RESULT_ERROR,
+    TSM_RESULT_REJECT,
+    TSM_RESULT_ABORT,
+    TSM_RESULT_TIMEOUT
+} BACNET_TSM_RESULT;
+
+/* the reply delivered to a completion function */
+typedef struct BACnet_TSM_Completion {
+    BACNET_TSM_RESULT result;
+    uint8_t invoke_id;
+    /* the peer that the request was sent to */
+    BACNET_ADDRESS *src;
+    /* service of an ack or error */
+    uint8_t service_choice;
+    /* service ack parameters of a complex ack, or the error parameters
+       of a complex error; NULL otherwise */
+    uint8_t *service_data;
+    uint16_t service_data_len;
+    /* error */
+    BACNET_ERROR_CLASS error_class;
+    BACNET_ERROR_CODE error_code;
+    /* reject or abort reason */
+    uint8_t reason;
+} BACNET_TSM_COMPLETION;
+
+typedef void (
+    *tsm_complete_function) (
+    BACNET_TSM_COMPLETION * completion,
+    void *context);
 
 #if (!MAX_TSM_TRANSACTIONS)
 #define tsm_free_invoke_id(x) (void)x;
+#define tsm_complete(x) ((void)(x), false)
 #else
+/* peers whose round trip times are estimated for their request timeout */
+#ifndef MAX_TSM_PEERS
+#define MAX_TSM_PEERS 16
+#endif
+/* bounds of the request timeout of a peer, in milliseconds */
+#ifndef TSM_RTO_MIN
+#define TSM_RTO_MIN 1000
+#endif
+#ifndef TSM_RTO_MAX
+#define TSM_RTO_MAX 60000
+#endif
+
 typedef enum {
     TSM_STATE_IDLE,
     TSM_STATE_AWAIT_CONFIRMATION,
@@ -83,6 +128,10 @@ typedef struct BACnet_TSM_Data {
     /* used to perform timeout on Confirmed Requests */
     /* in milliseconds */
     uint16_t RequestTimer;
+    /* value the RequestTimer was started with, in milliseconds */
+    uint16_t RequestTimeout;
+    /* time left for all the tries of the request, in milliseconds */
+    uint32_t RequestTimeLeft;
     /* unique id */
     uint8_t InvokeID;
     /* state that the TSM is in */
@@ -94,6 +143,11 @@ typedef struct BACnet_TSM_Data {
     /* copy of the APDU, should we need to send it again */
     uint8_t apdu[MAX_PDU];
     unsigned apdu_len;
+    /* called with the reply, when the invoke ID is scoped to the peer */
+    tsm_complete_function Complete;
+    void *Context;
+    /* next transaction with the same invoke ID, as index + 1 */
+    unsigned Next;
 } BACNET_TSM_DATA;
 
 typedef void (
@@ -118,6 +172,9 @@ extern "C" {
     BACNET_STACK_EXPORT
     void tsm_timer_milliseconds(
         uint16_t milliseconds);
+    BACNET_STACK_EXPORT
+    uint16_t tsm_timer_milliseconds_remaining(
+        void);
 /* free the invoke ID when the reply comes back */
     BACNET_STACK_EXPORT
     void tsm_free_invoke_id(
@@ -146,6 +203,32 @@ extern "C" {
         uint8_t * apdu,
         uint16_t * apdu_len);
 
+/* invoke IDs that are unique per peer, for many requests in flight */
+    BACNET_STACK_EXPORT
+    uint8_t tsm_next_free_invokeID_async(
+        BACNET_ADDRESS * dest,
+        tsm_complete_function pFunction,
+        void *context);
+    BACNET_STACK_EXPORT
+    bool tsm_complete(
+        BACNET_TSM_COMPLETION * completion);
+    BACNET_STACK_EXPORT
+    bool tsm_cancel_invoke_id(
+        uint8_t invokeID,
+        BACNET_ADDRESS * dest,
+        void **context);
+
+/* round trip time estimates of a peer, and its request timeout */
+    BACNET_STACK_EXPORT
+    uint16_t tsm_peer_timeout(
+        BACNET_ADDRESS * dest);
+    BACNET_STACK_EXPORT
+    bool tsm_peer_rtt(
+        BACNET_ADDRESS * dest,
+        uint16_t * srtt,
+        uint16_t * rttvar,
+        uint16_t * rto);
+
     BACNET_STACK_EXPORT
     bool tsm_invoke_id_free(
         uint8_t invokeID);
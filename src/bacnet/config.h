@@ -114,6 +114,19 @@
 #if !defined(MAX_TSM_TRANSACTIONS)
 #define MAX_TSM_TRANSACTIONS 255
 #endif
+/* Replies to confirmed requests are kept for a while, so that */
+/* a client that sends a request again after losing our reply */
+/* gets the same reply, without the service being run again. */
+/* Each reply takes MAX_PDU bytes: configure to zero to save RAM. */
+#if !defined(MAX_APDU_REPLY_CACHE)
+#define MAX_APDU_REPLY_CACHE 4
+#endif
+/* Confirmed requests may be limited for each source, so that */
+/* one client cannot take all of the time of the device. */
+/* This is the number of sources whose requests are counted. */
+#if !defined(MAX_APDU_ADMISSION_SOURCES)
+#define MAX_APDU_ADMISSION_SOURCES 16
+#endif
 /* The address cache is used for binding to BACnet devices */
 /* The number of entries corresponds to the number of */
 /* devices that might respond to an I-Am on the network. */
@@ -32,6 +32,7 @@
  -------------------------------------------
 ####COPYRIGHTEND####*/
 #include <stdint.h>
+#include <string.h>
 #include "bacnet/bacenum.h"
 #include "bacnet/bacdcode.h"
 #include "bacnet/bacdef.h"
@@ -50,64 +51,97 @@ Unconfirmed COV Notification
 */
 
 /**
- * @brief Encode APDU for COV Notification.
+ * @brief Encode the part of a COV Notification that is particular to
+ *  a subscription: the subscriber, device, object and time remaining.
  * @param apdu  Pointer to the buffer, or NULL for length
  * @param data  Pointer to the data to encode.
- * @return bytes encoded or zero on error.
+ * @return bytes encoded
  */
-int cov_notify_encode_apdu(uint8_t *apdu, BACNET_COV_DATA *data)
+int cov_notify_header_encode(uint8_t *apdu, BACNET_COV_DATA *data)
+{
+    int len = 0; /* length of each encoding */
+    int apdu_len = 0; /* total length of the apdu, return value */
+
+    /* tag 0 - subscriberProcessIdentifier */
+    len = encode_context_unsigned(apdu, 0, data->subscriberProcessIdentifier);
+    apdu_len += len;
+    if (apdu) {
+        apdu += len;
+    }
+    /* tag 1 - initiatingDeviceIdentifier */
+    len = encode_context_object_id(
+        apdu, 1, OBJECT_DEVICE, data->initiatingDeviceIdentifier);
+    apdu_len += len;
+    if (apdu) {
+        apdu += len;
+    }
+    /* tag 2 - monitoredObjectIdentifier */
+    len = encode_context_object_id(apdu, 2,
+        data->monitoredObjectIdentifier.type,
+        data->monitoredObjectIdentifier.instance);
+    apdu_len += len;
+    if (apdu) {
+        apdu += len;
+    }
+    /* tag 3 - timeRemaining */
+    len = encode_context_unsigned(apdu, 3, data->timeRemaining);
+    apdu_len += len;
+
+    return apdu_len;
+}
+
+/**
+ * @brief Encode the listOfValues of a COV Notification, which is the
+ *  same for every subscription to an object.
+ * @param apdu  Pointer to the buffer, or NULL for length
+ * @param value_list  first value of the list, linked to the next
+ * @return bytes encoded
+ */
+int cov_notify_value_list_encode(
+    uint8_t *apdu, BACNET_PROPERTY_VALUE *value_list)
 {
     int len = 0; /* length of each encoding */
     int apdu_len = 0; /* total length of the apdu, return value */
     BACNET_PROPERTY_VALUE *value = NULL; /* value in list */
 
+    /* tag 4 - listOfValues */
+    len = encode_opening_tag(apdu, 4);
+    apdu_len += len;
     if (apdu) {
-        /* tag 0 - subscriberProcessIdentifier */
-        len =
-            encode_context_unsigned(apdu, 0, data->subscriberProcessIdentifier);
-        apdu_len += len;
-        if (apdu) {
-            apdu += len;
-        }
-        /* tag 1 - initiatingDeviceIdentifier */
-        len = encode_context_object_id(
-            apdu, 1, OBJECT_DEVICE, data->initiatingDeviceIdentifier);
-        apdu_len += len;
-        if (apdu) {
-            apdu += len;
-        }
-        /* tag 2 - monitoredObjectIdentifier */
-        len = encode_context_object_id(apdu, 2,
-            data->monitoredObjectIdentifier.type,
-            data->monitoredObjectIdentifier.instance);
-        apdu_len += len;
-        if (apdu) {
-            apdu += len;
-        }
-        /* tag 3 - timeRemaining */
-        len = encode_context_unsigned(apdu, 3, data->timeRemaining);
+        apdu += len;
+    }
+    /* the first value includes a pointer to the next value, etc */
+    value = value_list;
+    while (value != NULL) {
+        len = bacapp_property_value_encode(apdu, value);
         apdu_len += len;
         if (apdu) {
             apdu += len;
         }
-        /* tag 4 - listOfValues */
-        len = encode_opening_tag(apdu, 4);
+        /* is there another one to encode? */
+        value = value->next;
+    }
+    len = encode_closing_tag(apdu, 4);
+    apdu_len += len;
+
+    return apdu_len;
+}
+
+/**
+ * @brief Encode APDU for COV Notification.
+ * @param apdu  Pointer to the buffer, or NULL for length
+ * @param data  Pointer to the data to encode.
+ * @return bytes encoded or zero on error.
+ */
+int cov_notify_encode_apdu(uint8_t *apdu, BACNET_COV_DATA *data)
+{
+    int len = 0; /* length of each encoding */
+    int apdu_len = 0; /* total length of the apdu, return value */
+
+    if (apdu) {
+        len = cov_notify_header_encode(apdu, data);
         apdu_len += len;
-        if (apdu) {
-            apdu += len;
-        }
-        /* the first value includes a pointer to the next value, etc */
-        value = data->listOfValues;
-        while (value != NULL) {
-            len = bacapp_property_value_encode(apdu, value);
-            apdu_len += len;
-            if (apdu) {
-                apdu += len;
-            }
-            /* is there another one to encode? */
-            value = value->next;
-        }
-        len = encode_closing_tag(apdu, 4);
+        len = cov_notify_value_list_encode(&apdu[apdu_len], data->listOfValues);
         apdu_len += len;
     }
 
@@ -207,6 +241,121 @@ int ucov_notify_encode_apdu(
     return apdu_len;
 }
 
+/**
+ * Encode the service request of a notification from a listOfValues
+ * that is already encoded.
+ *
+ * @param apdu  Pointer to the buffer.
+ * @param apdu_size  Buffer size.
+ * @param data  Pointer to the data to encode, whose listOfValues is
+ *  not used.
+ * @param values  listOfValues from cov_notify_value_list_encode()
+ * @param values_len  number of bytes in values
+ *
+ * @return bytes encoded or zero if they do not fit.
+ */
+static int notify_encode_apdu_values(uint8_t *apdu,
+    unsigned apdu_size,
+    BACNET_COV_DATA *data,
+    uint8_t *values,
+    unsigned values_len)
+{
+    int apdu_len = 0; /* total length of the apdu, return value */
+
+    apdu_len = cov_notify_header_encode(NULL, data);
+    if ((apdu_len + values_len) > apdu_size) {
+        apdu_len = 0;
+    } else {
+        apdu_len = cov_notify_header_encode(apdu, data);
+        memcpy(&apdu[apdu_len], values, values_len);
+        apdu_len += values_len;
+    }
+
+    return apdu_len;
+}
+
+/**
+ * Encode APDU for confirmed notification from a listOfValues that is
+ * already encoded, so that it is encoded once for all subscriptions.
+ *
+ * @param apdu  Pointer to the buffer.
+ * @param max_apdu_len  Buffer size.
+ * @param invoke_id  ID to invoke for notification
+ * @param data  Pointer to the data to encode, whose listOfValues is
+ *  not used.
+ * @param values  listOfValues from cov_notify_value_list_encode()
+ * @param values_len  number of bytes in values
+ *
+ * @return bytes encoded or zero on error.
+ */
+int ccov_notify_encode_apdu_values(uint8_t *apdu,
+    unsigned max_apdu_len,
+    uint8_t invoke_id,
+    BACNET_COV_DATA *data,
+    uint8_t *values,
+    unsigned values_len)
+{
+    int len = 0; /* length of each encoding */
+    int apdu_len = BACNET_STATUS_ERROR; /* return value */
+
+    if (apdu && data && values && memcopylen(0, max_apdu_len, 4)) {
+        apdu[0] = PDU_TYPE_CONFIRMED_SERVICE_REQUEST;
+        apdu[1] = encode_max_segs_max_apdu(0, MAX_APDU);
+        apdu[2] = invoke_id;
+        apdu[3] = SERVICE_CONFIRMED_COV_NOTIFICATION;
+        apdu_len = 4;
+        len = notify_encode_apdu_values(&apdu[apdu_len],
+            max_apdu_len - apdu_len, data, values, values_len);
+        if (len <= 0) {
+            /* return the error */
+            apdu_len = len;
+        } else {
+            apdu_len += len;
+        }
+    }
+
+    return apdu_len;
+}
+
+/**
+ * Encode APDU for unconfirmed notification from a listOfValues that
+ * is already encoded, so that it is encoded once for all subscriptions.
+ *
+ * @param apdu  Pointer to the buffer.
+ * @param max_apdu_len  Buffer size.
+ * @param data  Pointer to the data to encode, whose listOfValues is
+ *  not used.
+ * @param values  listOfValues from cov_notify_value_list_encode()
+ * @param values_len  number of bytes in values
+ *
+ * @return bytes encoded or zero on error.
+ */
+int ucov_notify_encode_apdu_values(uint8_t *apdu,
+    unsigned max_apdu_len,
+    BACNET_COV_DATA *data,
+    uint8_t *values,
+    unsigned values_len)
+{
+    int len = 0; /* length of each encoding */
+    int apdu_len = BACNET_STATUS_ERROR; /* return value */
+
+    if (apdu && data && values && memcopylen(0, max_apdu_len, 2)) {
+        apdu[0] = PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST;
+        apdu[1] = SERVICE_UNCONFIRMED_COV_NOTIFICATION; /* service choice */
+        apdu_len = 2;
+        len = notify_encode_apdu_values(&apdu[apdu_len],
+            max_apdu_len - apdu_len, data, values, values_len);
+        if (len <= 0) {
+            /* return the error */
+            apdu_len = len;
+        } else {
+            apdu_len += len;
+        }
+    }
+
+    return apdu_len;
+}
+
 /**
  * @brief Decode the COV-service request only.
  *
@@ -761,6 +910,37 @@ void cov_data_value_list_link(
     }
 }
 
+/**
+ * @brief Initialize the Status_Flags bit string of a COV value list
+ * @param bit_string - the bit string
+ * @param in_alarm - IN_ALARM flag
+ * @param fault - FAULT flag
+ * @param overridden - OVERRIDDEN flag
+ * @param out_of_service - OUT_OF_SERVICE flag
+ */
+static void cov_status_flags_init(BACNET_BIT_STRING *bit_string,
+    bool in_alarm,
+    bool fault,
+    bool overridden,
+    bool out_of_service)
+{
+    uint32_t bits = 0;
+
+    if (in_alarm) {
+        bits |= 1UL << STATUS_FLAG_IN_ALARM;
+    }
+    if (fault) {
+        bits |= 1UL << STATUS_FLAG_FAULT;
+    }
+    if (overridden) {
+        bits |= 1UL << STATUS_FLAG_OVERRIDDEN;
+    }
+    if (out_of_service) {
+        bits |= 1UL << STATUS_FLAG_OUT_OF_SERVICE;
+    }
+    bitstring_init_bits32(bit_string, 4, bits);
+}
+
 /**
  * @brief Encode the Value List for REAL Present-Value and Status-Flags
  * @param value_list - #BACNET_PROPERTY_VALUE with at least 2 entries
@@ -796,15 +976,8 @@ bool cov_value_list_encode_real(BACNET_PROPERTY_VALUE *value_list,
         value_list->propertyArrayIndex = BACNET_ARRAY_ALL;
         value_list->value.context_specific = false;
         value_list->value.tag = BACNET_APPLICATION_TAG_BIT_STRING;
-        bitstring_init(&value_list->value.type.Bit_String);
-        bitstring_set_bit(
-            &value_list->value.type.Bit_String, STATUS_FLAG_IN_ALARM, in_alarm);
-        bitstring_set_bit(
-            &value_list->value.type.Bit_String, STATUS_FLAG_FAULT, fault);
-        bitstring_set_bit(&value_list->value.type.Bit_String,
-            STATUS_FLAG_OVERRIDDEN, overridden);
-        bitstring_set_bit(&value_list->value.type.Bit_String,
-            STATUS_FLAG_OUT_OF_SERVICE, out_of_service);
+        cov_status_flags_init(&value_list->value.type.Bit_String, in_alarm,
+            fault, overridden, out_of_service);
         value_list->value.next = NULL;
         value_list->priority = BACNET_NO_PRIORITY;
         value_list->next = NULL;
@@ -849,15 +1022,8 @@ bool cov_value_list_encode_enumerated(BACNET_PROPERTY_VALUE *value_list,
         value_list->propertyArrayIndex = BACNET_ARRAY_ALL;
         value_list->value.context_specific = false;
         value_list->value.tag = BACNET_APPLICATION_TAG_BIT_STRING;
-        bitstring_init(&value_list->value.type.Bit_String);
-        bitstring_set_bit(
-            &value_list->value.type.Bit_String, STATUS_FLAG_IN_ALARM, in_alarm);
-        bitstring_set_bit(
-            &value_list->value.type.Bit_String, STATUS_FLAG_FAULT, fault);
-        bitstring_set_bit(&value_list->value.type.Bit_String,
-            STATUS_FLAG_OVERRIDDEN, overridden);
-        bitstring_set_bit(&value_list->value.type.Bit_String,
-            STATUS_FLAG_OUT_OF_SERVICE, out_of_service);
+        cov_status_flags_init(&value_list->value.type.Bit_String, in_alarm,
+            fault, overridden, out_of_service);
         value_list->value.next = NULL;
         value_list->priority = BACNET_NO_PRIORITY;
         value_list->next = NULL;
@@ -902,15 +1068,8 @@ bool cov_value_list_encode_unsigned(BACNET_PROPERTY_VALUE *value_list,
         value_list->propertyArrayIndex = BACNET_ARRAY_ALL;
         value_list->value.context_specific = false;
         value_list->value.tag = BACNET_APPLICATION_TAG_BIT_STRING;
-        bitstring_init(&value_list->value.type.Bit_String);
-        bitstring_set_bit(
-            &value_list->value.type.Bit_String, STATUS_FLAG_IN_ALARM, in_alarm);
-        bitstring_set_bit(
-            &value_list->value.type.Bit_String, STATUS_FLAG_FAULT, fault);
-        bitstring_set_bit(&value_list->value.type.Bit_String,
-            STATUS_FLAG_OVERRIDDEN, overridden);
-        bitstring_set_bit(&value_list->value.type.Bit_String,
-            STATUS_FLAG_OUT_OF_SERVICE, out_of_service);
+        cov_status_flags_init(&value_list->value.type.Bit_String, in_alarm,
+            fault, overridden, out_of_service);
         value_list->value.next = NULL;
         value_list->priority = BACNET_NO_PRIORITY;
         value_list->next = NULL;
@@ -957,15 +1116,8 @@ bool cov_value_list_encode_character_string(BACNET_PROPERTY_VALUE *value_list,
         value_list->propertyArrayIndex = BACNET_ARRAY_ALL;
         value_list->value.context_specific = false;
         value_list->value.tag = BACNET_APPLICATION_TAG_BIT_STRING;
-        bitstring_init(&value_list->value.type.Bit_String);
-        bitstring_set_bit(
-            &value_list->value.type.Bit_String, STATUS_FLAG_IN_ALARM, in_alarm);
-        bitstring_set_bit(
-            &value_list->value.type.Bit_String, STATUS_FLAG_FAULT, fault);
-        bitstring_set_bit(&value_list->value.type.Bit_String,
-            STATUS_FLAG_OVERRIDDEN, overridden);
-        bitstring_set_bit(&value_list->value.type.Bit_String,
-            STATUS_FLAG_OUT_OF_SERVICE, out_of_service);
+        cov_status_flags_init(&value_list->value.type.Bit_String, in_alarm,
+            fault, overridden, out_of_service);
         value_list->value.next = NULL;
         value_list->priority = BACNET_NO_PRIORITY;
         value_list->next = NULL;
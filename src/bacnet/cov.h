@@ -70,6 +70,12 @@ extern "C" {
     BACNET_STACK_EXPORT
     int cov_notify_encode_apdu(
         uint8_t *apdu, BACNET_COV_DATA *data);
+    BACNET_STACK_EXPORT
+    int cov_notify_header_encode(
+        uint8_t *apdu, BACNET_COV_DATA *data);
+    BACNET_STACK_EXPORT
+    int cov_notify_value_list_encode(
+        uint8_t *apdu, BACNET_PROPERTY_VALUE *value_list);
 
     BACNET_STACK_EXPORT
     int ucov_notify_encode_apdu(
@@ -95,6 +101,21 @@ extern "C" {
         unsigned max_apdu_len,
         uint8_t invoke_id,
         BACNET_COV_DATA * data);
+    BACNET_STACK_EXPORT
+    int ccov_notify_encode_apdu_values(
+        uint8_t * apdu,
+        unsigned max_apdu_len,
+        uint8_t invoke_id,
+        BACNET_COV_DATA * data,
+        uint8_t * values,
+        unsigned values_len);
+    BACNET_STACK_EXPORT
+    int ucov_notify_encode_apdu_values(
+        uint8_t * apdu,
+        unsigned max_apdu_len,
+        BACNET_COV_DATA * data,
+        uint8_t * values,
+        unsigned values_len);
 
     BACNET_STACK_EXPORT
     int ccov_notify_decode_apdu(
@@ -72,6 +72,13 @@ extern "C" {
     BACNET_STACK_EXPORT
     int bip_send_mpdu(BACNET_IP_ADDRESS *dest, uint8_t *mtu, uint16_t mtu_len);
 
+    BACNET_STACK_EXPORT
+    int bip_send_mpdu_iov(BACNET_IP_ADDRESS *dest,
+        uint8_t *header,
+        uint16_t header_len,
+        uint8_t *npdu,
+        uint16_t npdu_len);
+
     BACNET_STACK_EXPORT
     uint16_t bip_receive(BACNET_ADDRESS *src,
         uint8_t *pdu,
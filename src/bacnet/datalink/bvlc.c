@@ -1009,6 +1009,37 @@ int bvlc_encode_forwarded_npdu(uint8_t *pdu,
     return bytes_encoded;
 }
 
+/**
+ * @brief Encode only the BVLC header of a Forwarded-NPDU, so that
+ *  the NPDU can be sent from its own buffer
+ *
+ * @param pdu - buffer to store the encoding
+ * @param pdu_size - size of the buffer to store encoding
+ * @param bip_address - Original-Source-B/IPv4-Address
+ * @param npdu_len - size of the BACnet NPDU that follows the header
+ *
+ * @return number of bytes encoded
+ */
+int bvlc_encode_forwarded_npdu_header(uint8_t *pdu,
+    uint16_t pdu_size,
+    BACNET_IP_ADDRESS *bip_address,
+    uint16_t npdu_len)
+{
+    int bytes_encoded = 0;
+    uint16_t length = 1 + 1 + 2 + BIP_ADDRESS_MAX;
+
+    if (pdu && (pdu_size >= length) && (npdu_len <= (UINT16_MAX - length))) {
+        bytes_encoded = bvlc_encode_header(pdu, pdu_size,
+            BVLC_FORWARDED_NPDU, (uint16_t)(length + npdu_len));
+        if (bytes_encoded == 4) {
+            bvlc_encode_address(&pdu[4], pdu_size - 4, bip_address);
+            bytes_encoded = (int)length;
+        }
+    }
+
+    return bytes_encoded;
+}
+
 /**
  * @brief Decode the BVLC Forwarded-NPDU message, after decoded header
  *
@@ -1633,6 +1664,29 @@ int bvlc_encode_distribute_broadcast_to_network(
     return bytes_encoded;
 }
 
+/**
+ * @brief Encode only the BVLC header of a Distribute-Broadcast-To-Network, so that
+ *  the NPDU can be sent from its own buffer
+ *
+ * @param pdu - buffer to store the encoding
+ * @param pdu_size - size of the buffer to store encoding
+ * @param npdu_len - size of the BACnet NPDU that follows the header
+ *
+ * @return number of bytes encoded
+ */
+int bvlc_encode_distribute_broadcast_to_network_header(
+    uint8_t *pdu, uint16_t pdu_size, uint16_t npdu_len)
+{
+    int bytes_encoded = 0;
+
+    if ((pdu_size >= 4) && (npdu_len <= (UINT16_MAX - 4))) {
+        bytes_encoded = bvlc_encode_header(pdu, pdu_size,
+            BVLC_DISTRIBUTE_BROADCAST_TO_NETWORK, (uint16_t)(4 + npdu_len));
+    }
+
+    return bytes_encoded;
+}
+
 /**
  * @brief Decode the BVLC Original-Broadcast-NPDU message
  *
@@ -1708,6 +1762,29 @@ int bvlc_encode_original_unicast(
     return bytes_encoded;
 }
 
+/**
+ * @brief Encode only the BVLC header of an Original-Unicast-NPDU, so that
+ *  the NPDU can be sent from its own buffer
+ *
+ * @param pdu - buffer to store the encoding
+ * @param pdu_size - size of the buffer to store encoding
+ * @param npdu_len - size of the BACnet NPDU that follows the header
+ *
+ * @return number of bytes encoded
+ */
+int bvlc_encode_original_unicast_header(
+    uint8_t *pdu, uint16_t pdu_size, uint16_t npdu_len)
+{
+    int bytes_encoded = 0;
+
+    if ((pdu_size >= 4) && (npdu_len <= (UINT16_MAX - 4))) {
+        bytes_encoded = bvlc_encode_header(pdu, pdu_size,
+            BVLC_ORIGINAL_UNICAST_NPDU, (uint16_t)(4 + npdu_len));
+    }
+
+    return bytes_encoded;
+}
+
 /**
  * @brief Decode the BVLC Original-Unicast-NPDU message, after decoding header
  *
@@ -1783,6 +1860,29 @@ int bvlc_encode_original_broadcast(
     return bytes_encoded;
 }
 
+/**
+ * @brief Encode only the BVLC header of an Original-Broadcast-NPDU, so that
+ *  the NPDU can be sent from its own buffer
+ *
+ * @param pdu - buffer to store the encoding
+ * @param pdu_size - size of the buffer to store encoding
+ * @param npdu_len - size of the BACnet NPDU that follows the header
+ *
+ * @return number of bytes encoded
+ */
+int bvlc_encode_original_broadcast_header(
+    uint8_t *pdu, uint16_t pdu_size, uint16_t npdu_len)
+{
+    int bytes_encoded = 0;
+
+    if ((pdu_size >= 4) && (npdu_len <= (UINT16_MAX - 4))) {
+        bytes_encoded = bvlc_encode_header(pdu, pdu_size,
+            BVLC_ORIGINAL_BROADCAST_NPDU, (uint16_t)(4 + npdu_len));
+    }
+
+    return bytes_encoded;
+}
+
 /**
  * @brief Decode the BVLC Original-Broadcast-NPDU message
  *
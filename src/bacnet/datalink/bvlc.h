@@ -89,6 +89,8 @@ typedef struct BACnet_IP_Address {
 } BACNET_IP_ADDRESS;
 /* number of bytes in the B/IPv4 address */
 #define BIP_ADDRESS_MAX 6
+/* largest BVLC header in front of an NPDU, that of a Forwarded-NPDU */
+#define BVLC_NPDU_HEADER_MAX (1 + 1 + 2 + BIP_ADDRESS_MAX)
 
 /**
  * BACnet IPv4 Broadcast Distribution Mask
@@ -436,6 +438,9 @@ extern "C" {
     BACNET_STACK_EXPORT
     int bvlc_encode_original_unicast(
         uint8_t *pdu, uint16_t pdu_size, uint8_t *npdu, uint16_t npdu_len);
+    BACNET_STACK_EXPORT
+    int bvlc_encode_original_unicast_header(
+        uint8_t *pdu, uint16_t pdu_size, uint16_t npdu_len);
 
     BACNET_STACK_EXPORT
     int bvlc_decode_original_unicast(uint8_t *pdu,
@@ -447,6 +452,9 @@ extern "C" {
     BACNET_STACK_EXPORT
     int bvlc_encode_original_broadcast(
         uint8_t *pdu, uint16_t pdu_size, uint8_t *npdu, uint16_t npdu_len);
+    BACNET_STACK_EXPORT
+    int bvlc_encode_original_broadcast_header(
+        uint8_t *pdu, uint16_t pdu_size, uint16_t npdu_len);
 
     BACNET_STACK_EXPORT
     int bvlc_decode_original_broadcast(uint8_t *pdu,
@@ -461,6 +469,11 @@ extern "C" {
         BACNET_IP_ADDRESS *address,
         uint8_t *npdu,
         uint16_t npdu_len);
+    BACNET_STACK_EXPORT
+    int bvlc_encode_forwarded_npdu_header(uint8_t *pdu,
+        uint16_t pdu_size,
+        BACNET_IP_ADDRESS *address,
+        uint16_t npdu_len);
 
     BACNET_STACK_EXPORT
     int bvlc_decode_forwarded_npdu(uint8_t *pdu,
@@ -500,6 +513,9 @@ extern "C" {
     BACNET_STACK_EXPORT
     int bvlc_encode_distribute_broadcast_to_network(
         uint8_t *pdu, uint16_t pdu_size, uint8_t *npdu, uint16_t npdu_len);
+    BACNET_STACK_EXPORT
+    int bvlc_encode_distribute_broadcast_to_network_header(
+        uint8_t *pdu, uint16_t pdu_size, uint16_t npdu_len);
 
     BACNET_STACK_EXPORT
     int bvlc_decode_distribute_broadcast_to_network(uint8_t *pdu,
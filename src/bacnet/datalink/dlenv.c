@@ -503,6 +503,12 @@ void dlenv_maintenance_timer(uint16_t elapsed_seconds)
  *     waits for a response from a BACnet device.
  *   - BACNET_APDU_RETRIES - indicate the maximum number of times that
  *     an APDU shall be retransmitted.
+ *   - BACNET_APDU_SOURCE_RATE - confirmed requests per second that
+ *     are run for each source; more are answered with an Abort.
+ *   - BACNET_APDU_SOURCE_BURST - confirmed requests from each source
+ *     that may come at once.  Default is one second of requests.
+ *   - BACNET_APDU_REQUEST_RATE - confirmed requests per second that
+ *     are run for all sources; more are dropped.
  *   - BACNET_IFACE - set this value to dotted IP address (Windows) of
  *     the interface (see ipconfig command on Windows) for which you
  *     want to bind.  On Linux, set this to the /dev interface
@@ -524,6 +530,8 @@ void dlenv_maintenance_timer(uint16_t elapsed_seconds)
  *   - BACNET_BDT_MASK_1 - dotted IPv4 mask of the BBMD table
  *       entry 1..128 (optional)
  *   - BACNET_IP_NAT_ADDR - dotted IPv4 address of the public facing router
+ *   - BACNET_IP_MULTICAST - dotted IPv4 multicast group to send B/IP
+ *       broadcasts to instead of the local broadcast address (Annex J.8)
  * - BACDL_MSTP: (BACnet MS/TP)
  *   - BACNET_MAX_INFO_FRAMES
  *   - BACNET_MAX_MASTER
@@ -537,6 +545,8 @@ void dlenv_maintenance_timer(uint16_t elapsed_seconds)
 void dlenv_init(void)
 {
     char *pEnv = NULL;
+    uint16_t rate = 0;
+    uint16_t burst = 0;
 
 #if defined(BACDL_ALL)
     pEnv = getenv("BACNET_DATALINK");
@@ -603,6 +613,15 @@ void dlenv_init(void)
             bvlc_set_global_address_for_nat(&addr);
         }
     }
+    pEnv = getenv("BACNET_IP_MULTICAST");
+    if (pEnv) {
+        if (bip_get_addr_by_name(pEnv, &addr)) {
+            if (!bip_set_broadcast_addr(&addr)) {
+                fprintf(stderr, "Failed to set BACNET_IP_MULTICAST %s!\n",
+                    pEnv);
+            }
+        }
+    }
 #elif defined(BACDL_MSTP)
     pEnv = getenv("BACNET_MAX_INFO_FRAMES");
     if (pEnv) {
@@ -641,6 +660,19 @@ void dlenv_init(void)
     if (pEnv) {
         apdu_retries_set((uint8_t)strtol(pEnv, NULL, 0));
     }
+    pEnv = getenv("BACNET_APDU_SOURCE_RATE");
+    if (pEnv) {
+        rate = (uint16_t)strtol(pEnv, NULL, 0);
+        pEnv = getenv("BACNET_APDU_SOURCE_BURST");
+        if (pEnv) {
+            burst = (uint16_t)strtol(pEnv, NULL, 0);
+        }
+        apdu_source_limit_set(rate, burst);
+    }
+    pEnv = getenv("BACNET_APDU_REQUEST_RATE");
+    if (pEnv) {
+        apdu_request_limit_set((uint16_t)strtol(pEnv, NULL, 0));
+    }
     /* === Initialize the Datalink Here === */
     if (!datalink_init(getenv("BACNET_IFACE"))) {
         exit(1);
@@ -35,6 +35,23 @@
 #define ETHERNET_HEADER_MAX (6+6+2+1+1+1)
 #define ETHERNET_MPDU_MAX (ETHERNET_HEADER_MAX+MAX_PDU)
 
+/* interface counters */
+typedef struct ethernet_statistics {
+    uint32_t rx_frames;
+    uint32_t rx_bytes;
+    /* frames that failed the BACnet or destination checks */
+    uint32_t rx_discarded;
+    /* frames the kernel dropped because the receive ring was full */
+    uint32_t rx_dropped;
+    /* receive ring blocks handed over by the kernel */
+    uint32_t rx_blocks;
+    uint32_t tx_frames;
+    uint32_t tx_bytes;
+    uint32_t tx_errors;
+    /* frames not sent because the transmit ring was full */
+    uint32_t tx_ring_full;
+} ETHERNET_STATISTICS;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -86,6 +103,9 @@ extern "C" {
     int ethernet_send(
         uint8_t * mtu,
         int mtu_len);
+    BACNET_STACK_EXPORT
+    void ethernet_statistics(
+        ETHERNET_STATISTICS * stats);
 
 #ifdef __cplusplus
 }
@@ -34,6 +34,9 @@
 #include <stdint.h>
 #include "bacnet/bacenum.h"
 #include "bacnet/bacdcode.h"
+#include "bacnet/bacreal.h"
+#include "bacnet/bacstr.h"
+#include "bacnet/datetime.h"
 #include "bacnet/bacdef.h"
 #include "bacnet/readrange.h"
 
@@ -541,4 +544,287 @@ int rr_ack_decode_service_request(uint8_t *apdu,
     return len;
 }
 
-/* FIXME: Currently does not have test framework */
+/**
+ * Skips the tags of constructed data up to and including the closing
+ * tag that matches an opening tag already decoded.
+ *
+ *  @param apdu  Pointer to the first tag after the opening tag.
+ *  @param apdu_len  Bytes valid in the APDU buffer.
+ *
+ *  @return Bytes skipped, or -1 if the closing tag is missing.
+ */
+static int rr_constructed_skip(uint8_t *apdu, int apdu_len)
+{
+    int len = 0;
+    int tag_len;
+    unsigned depth = 1;
+    uint8_t tag_number = 0;
+    uint32_t len_value_type = 0;
+
+    while (len < apdu_len) {
+        tag_len = bacnet_tag_number_and_value_decode(&apdu[len],
+            (uint32_t)(apdu_len - len), &tag_number, &len_value_type);
+        if (tag_len <= 0) {
+            return -1;
+        }
+        if (IS_CONTEXT_SPECIFIC(apdu[len]) && IS_OPENING_TAG(apdu[len])) {
+            depth++;
+        } else if (IS_CONTEXT_SPECIFIC(apdu[len]) &&
+            IS_CLOSING_TAG(apdu[len])) {
+            depth--;
+            if (depth == 0) {
+                return len + tag_len;
+            }
+        } else if (IS_CONTEXT_SPECIFIC(apdu[len]) ||
+            (tag_number != BACNET_APPLICATION_TAG_BOOLEAN)) {
+            /* application booleans have their value in the tag */
+            tag_len += (int)len_value_type;
+        }
+        len += tag_len;
+    }
+
+    return -1;
+}
+
+/**
+ * Decodes an application tagged enumerated value
+ *
+ *  @param apdu  Pointer to the tag.
+ *  @param apdu_len  Bytes valid in the APDU buffer.
+ *  @param value  Decoded value.
+ *
+ *  @return Bytes decoded, or -1 if malformed.
+ */
+static int rr_enumerated_decode(uint8_t *apdu, int apdu_len, uint32_t *value)
+{
+    int len;
+    int value_len;
+    uint8_t tag_number = 0;
+    uint32_t len_value_type = 0;
+
+    len = bacnet_tag_number_and_value_decode(
+        apdu, (uint32_t)apdu_len, &tag_number, &len_value_type);
+    if ((len <= 0) || IS_CONTEXT_SPECIFIC(apdu[0]) ||
+        (tag_number != BACNET_APPLICATION_TAG_ENUMERATED)) {
+        return -1;
+    }
+    value_len = bacnet_enumerated_decode(&apdu[len],
+        (uint16_t)(apdu_len - len), len_value_type, value);
+    if (value_len <= 0) {
+        return -1;
+    }
+
+    return len + value_len;
+}
+
+/**
+ * Decodes the logDatum of a BACnetLogRecord
+ *
+ *  @param apdu  Pointer to the context tag of the logDatum choice.
+ *  @param apdu_len  Bytes valid in the APDU buffer.
+ *  @param datum_type  Choice of the logDatum.
+ *  @param value  The logDatum as a number.
+ *
+ *  @return Bytes decoded, or -1 if malformed.
+ */
+static int rr_log_datum_decode(
+    uint8_t *apdu, int apdu_len, uint8_t *datum_type, double *value)
+{
+    int len;
+    int value_len = 0;
+    uint8_t tag_number = 0;
+    uint32_t len_value_type = 0;
+    uint32_t enum_value = 0;
+    BACNET_UNSIGNED_INTEGER unsigned_value = 0;
+    int32_t signed_value = 0;
+    float real_value = 0.0f;
+    BACNET_BIT_STRING bit_string;
+    uint8_t i;
+
+    len = bacnet_tag_number_and_value_decode(
+        apdu, (uint32_t)apdu_len, &tag_number, &len_value_type);
+    if ((len <= 0) || !IS_CONTEXT_SPECIFIC(apdu[0])) {
+        return -1;
+    }
+    *datum_type = tag_number;
+    *value = 0.0;
+    if (IS_OPENING_TAG(apdu[0])) {
+        if (tag_number == 8) {
+            /* failure: error class, then error code */
+            value_len = rr_enumerated_decode(&apdu[len], apdu_len - len,
+                &enum_value);
+            if (value_len <= 0) {
+                return -1;
+            }
+            len += value_len;
+            value_len = rr_enumerated_decode(&apdu[len], apdu_len - len,
+                &enum_value);
+            if (value_len <= 0) {
+                return -1;
+            }
+            len += value_len;
+            *value = enum_value;
+        }
+        value_len = rr_constructed_skip(&apdu[len], apdu_len - len);
+        if (value_len <= 0) {
+            return -1;
+        }
+        return len + value_len;
+    }
+    if (IS_CLOSING_TAG(apdu[0]) ||
+        (len_value_type > (uint32_t)(apdu_len - len))) {
+        return -1;
+    }
+    switch (tag_number) {
+        case 0:
+        case 6:
+            /* log-status and bitstring: the octets, up to 32 bits */
+            value_len =
+                decode_bitstring(&apdu[len], len_value_type, &bit_string);
+            enum_value = 0;
+            for (i = bitstring_bytes_used(&bit_string); i > 0; i--) {
+                if (i <= 4) {
+                    enum_value = (enum_value << 8) |
+                        bitstring_octet(&bit_string, i - 1);
+                }
+            }
+            *value = enum_value;
+            break;
+        case 1:
+            if (len_value_type != 1) {
+                return -1;
+            }
+            value_len = 1;
+            *value = apdu[len] ? 1.0 : 0.0;
+            break;
+        case 2:
+        case 9:
+            value_len = decode_real_safe(&apdu[len], len_value_type,
+                &real_value);
+            *value = real_value;
+            break;
+        case 3:
+            value_len =
+                decode_enumerated(&apdu[len], len_value_type, &enum_value);
+            *value = enum_value;
+            break;
+        case 4:
+            value_len =
+                decode_unsigned(&apdu[len], len_value_type, &unsigned_value);
+            *value = (double)unsigned_value;
+            break;
+        case 5:
+            value_len =
+                decode_signed(&apdu[len], len_value_type, &signed_value);
+            *value = signed_value;
+            break;
+        case 7:
+            value_len = 0;
+            break;
+        default:
+            return -1;
+    }
+    if (value_len < 0) {
+        return -1;
+    }
+
+    return len + (int)len_value_type;
+}
+
+/**
+ * Decodes a sequence of BACnetLogRecord, such as the itemData of a
+ * ReadRange-ACK of a Log_Buffer, into columns without allocating.
+ * Decoding stops when the columns are full, so a large sequence can be
+ * decoded in parts: empty the columns and call again with the rest of
+ * the data.
+ *
+ *  @param apdu  Pointer to the first log record.
+ *  @param apdu_len  Bytes valid in the APDU buffer.
+ *  @param columns  Columns to which the records are appended.
+ *
+ *  @return Bytes of the records decoded, or -1 if malformed.
+ */
+int rr_log_records_decode(
+    uint8_t *apdu, int apdu_len, BACNET_LOG_RECORD_COLUMNS *columns)
+{
+    int len = 0;
+    int rec_len;
+    int tag_len = 0;
+    int value_len;
+    BACNET_DATE_TIME timestamp;
+    BACNET_BIT_STRING bit_string;
+    uint8_t tag_number = 0;
+    uint32_t len_value_type = 0;
+    uint8_t datum_type = 0;
+    uint8_t status_flags = 0;
+    double value = 0.0;
+
+    if (!apdu || !columns) {
+        return -1;
+    }
+    while ((len < apdu_len) && (columns->count < columns->size)) {
+        rec_len = len;
+        /* timestamp [0] BACnetDateTime: opening tag, application date,
+           application time, closing tag */
+        if ((apdu_len - rec_len) < 12) {
+            return -1;
+        }
+        value_len =
+            bacapp_decode_context_datetime(&apdu[rec_len], 0, &timestamp);
+        if (value_len <= 0) {
+            return -1;
+        }
+        rec_len += value_len;
+        /* logDatum [1] */
+        if (!bacnet_is_opening_tag_number(&apdu[rec_len],
+                (uint32_t)(apdu_len - rec_len), 1, &tag_len)) {
+            return -1;
+        }
+        rec_len += tag_len;
+        value_len = rr_log_datum_decode(
+            &apdu[rec_len], apdu_len - rec_len, &datum_type, &value);
+        if (value_len <= 0) {
+            return -1;
+        }
+        rec_len += value_len;
+        if (!bacnet_is_closing_tag_number(&apdu[rec_len],
+                (uint32_t)(apdu_len - rec_len), 1, &tag_len)) {
+            return -1;
+        }
+        rec_len += tag_len;
+        /* statusFlags [2] BACnetStatusFlags OPTIONAL */
+        status_flags = 0;
+        if ((rec_len < apdu_len) &&
+            decode_is_context_tag(&apdu[rec_len], 2) &&
+            !decode_is_closing_tag(&apdu[rec_len])) {
+            tag_len = bacnet_tag_number_and_value_decode(&apdu[rec_len],
+                (uint32_t)(apdu_len - rec_len), &tag_number, &len_value_type);
+            if ((tag_len <= 0) ||
+                (len_value_type > (uint32_t)(apdu_len - rec_len - tag_len))) {
+                return -1;
+            }
+            rec_len += tag_len;
+            rec_len += decode_bitstring(
+                &apdu[rec_len], len_value_type, &bit_string);
+            status_flags = 0x80 | (bitstring_octet(&bit_string, 0) & 0x0F);
+        }
+        if (columns->timestamp) {
+            columns->timestamp[columns->count] =
+                datetime_seconds_since_epoch(&timestamp);
+        }
+        if (columns->type) {
+            columns->type[columns->count] = datum_type;
+        }
+        if (columns->value) {
+            columns->value[columns->count] = value;
+        }
+        if (columns->status_flags) {
+            columns->status_flags[columns->count] = status_flags;
+        }
+        columns->count++;
+        len = rec_len;
+    }
+
+    return len;
+}
+
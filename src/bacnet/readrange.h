@@ -100,6 +100,28 @@ extern "C" {
 #define RR_1ST_SEQ_OVERHEAD 5
 #define RR_INDEX_OVERHEAD   3   /* or 5 if paranoid */
 
+/** Columns of decoded BACnetLogRecord items from a ReadRange-ACK.
+ * The caller owns the arrays, which each hold size items.  A column
+ * pointer that is NULL is skipped by the decoder.
+ *
+ * - timestamp: seconds since the epoch of the record time stamp
+ * - type: choice of the logDatum, the context tag 0=log-status,
+ *   1=boolean, 2=real, 3=enumerated, 4=unsigned, 5=signed, 6=bitstring,
+ *   7=null, 8=failure, 9=time-change, 10=any
+ * - value: the logDatum as a number: booleans as 0 or 1, bitstrings
+ *   (up to 32 bits) and log-status as their octets, failures as the
+ *   error code, null and any as 0
+ * - status_flags: bit 7 is set when the record has status flags,
+ *   which are in bits 0 to 3 */
+    typedef struct BACnet_Log_Record_Columns {
+        uint32_t size;
+        uint32_t count;
+        bacnet_time_t *timestamp;
+        uint8_t *type;
+        double *value;
+        uint8_t *status_flags;
+    } BACNET_LOG_RECORD_COLUMNS;
+
 /** Define pointer to function type for handling ReadRange request.
    This function will take the following parameters:
   - 1. A pointer to a buffer of at least MAX_APDU bytes to build the response in.
@@ -156,6 +178,12 @@ extern "C" {
         int apdu_len,   /* total length of the apdu */
         BACNET_READ_RANGE_DATA * rrdata);
 
+    BACNET_STACK_EXPORT
+    int rr_log_records_decode(
+        uint8_t * apdu,
+        int apdu_len,
+        BACNET_LOG_RECORD_COLUMNS * columns);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -732,6 +732,46 @@ static void testBACDCodeBitString(void)
     }
 }
 
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(bacdcode_tests, testBACDCodeStatusFlags)
+#else
+static void testBACDCodeStatusFlags(void)
+#endif
+{
+    BACNET_BIT_STRING bit_string;
+    uint8_t apdu[MAX_APDU] = { 0 };
+    uint8_t test_apdu[MAX_APDU] = { 0 };
+    unsigned flags, octet;
+    int len, test_len;
+
+    /* the same encoding as a bit string of four status flags */
+    for (flags = 0; flags < 16; flags++) {
+        bitstring_init(&bit_string);
+        bitstring_set_bit(&bit_string, STATUS_FLAG_IN_ALARM, flags & 1);
+        bitstring_set_bit(&bit_string, STATUS_FLAG_FAULT, flags & 2);
+        bitstring_set_bit(&bit_string, STATUS_FLAG_OVERRIDDEN, flags & 4);
+        bitstring_set_bit(&bit_string, STATUS_FLAG_OUT_OF_SERVICE, flags & 8);
+        len = encode_application_bitstring(apdu, &bit_string);
+        test_len = encode_application_status_flags(test_apdu, flags & 1,
+            flags & 2, flags & 4, flags & 8);
+        zassert_equal(len, test_len, NULL);
+        zassert_mem_equal(apdu, test_apdu, len, NULL);
+        test_len =
+            encode_application_status_flags(NULL, false, false, false, false);
+        zassert_equal(len, test_len, NULL);
+    }
+    /* every octet value survives the bit order reversal */
+    for (octet = 0; octet < 256; octet++) {
+        zassert_true(bitstring_init_bits32(&bit_string, 8, octet), NULL);
+        len = encode_bitstring(apdu, &bit_string);
+        zassert_equal(len, 2, NULL);
+        zassert_equal(apdu[1] & 0x80, (octet & 1) ? 0x80 : 0, NULL);
+        test_len = decode_bitstring(apdu, (uint32_t)len, &bit_string);
+        zassert_equal(test_len, len, NULL);
+        zassert_equal(bitstring_bits32(&bit_string), octet, NULL);
+    }
+}
+
 #if defined(CONFIG_ZTEST_NEW_API)
 ZTEST(bacdcode_tests, testUnsignedContextDecodes)
 #else
@@ -1501,6 +1541,7 @@ void test_main(void)
      ztest_unit_test(testBACDCodeObject),
      ztest_unit_test(testBACDCodeMaxSegsApdu),
      ztest_unit_test(testBACDCodeBitString),
+     ztest_unit_test(testBACDCodeStatusFlags),
      ztest_unit_test(testUnsignedContextDecodes),
      ztest_unit_test(testSignedContextDecodes),
      ztest_unit_test(testEnumeratedContextDecodes),
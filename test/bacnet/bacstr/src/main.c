@@ -82,6 +82,30 @@ static void testBitString(void)
     zassert_false(status, NULL);
     zassert_equal(bitstring_bits_capacity(&bit_string),
         (MAX_BITSTRING_BYTES * 8), NULL);
+    /* a whole byte used compares only the used bytes */
+    bitstring_init(&bit_string);
+    bitstring_init(&bit_string2);
+    bitstring_set_octet(&bit_string, 0, 0xA5);
+    bitstring_set_octet(&bit_string2, 0, 0xA5);
+    bitstring_set_octet(&bit_string2, 1, 0xFF);
+    bitstring_set_bits_used(&bit_string, 1, 0);
+    bitstring_set_bits_used(&bit_string2, 1, 0);
+    zassert_true(bitstring_same(&bit_string, &bit_string2), NULL);
+    /* words of bits */
+    zassert_true(bitstring_init_bits32(&bit_string, 4, 0xFA), NULL);
+    zassert_equal(bitstring_bits_used(&bit_string), 4, NULL);
+    zassert_equal(bitstring_bits32(&bit_string), 0x0A, NULL);
+    zassert_false(bitstring_bit(&bit_string, 0), NULL);
+    zassert_true(bitstring_bit(&bit_string, 1), NULL);
+    zassert_true(bitstring_bit(&bit_string, 3), NULL);
+    zassert_false(bitstring_bit(&bit_string, 4), NULL);
+    zassert_true(bitstring_init_bits32(&bit_string, 32, 0x80000001UL), NULL);
+    zassert_equal(bitstring_bytes_used(&bit_string), 4, NULL);
+    zassert_true(bitstring_bit(&bit_string, 31), NULL);
+    zassert_equal(bitstring_bits32(&bit_string), 0x80000001UL, NULL);
+    zassert_false(bitstring_init_bits32(&bit_string, 33, 0), NULL);
+    zassert_false(bitstring_init_bits32(NULL, 4, 0), NULL);
+    zassert_equal(bitstring_bits32(NULL), 0, NULL);
 }
 
 /**
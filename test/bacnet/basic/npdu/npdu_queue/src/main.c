@@ -0,0 +1,204 @@
+/*
+ * SPDX-License-Identifier: MIT
+ */
+
+/* @file
+ * @brief test inbound queue of NPDU served by network priority
+ */
+
+#include <stdio.h>
+#include <zephyr/ztest.h>
+#include <bacnet/bacdef.h>
+#include <bacnet/bacenum.h>
+#include <bacnet/basic/sys/mstimer.h>
+#include <bacnet/basic/npdu/h_npdu.h>
+#include <bacnet/basic/npdu/h_npdu_queue.h>
+
+/**
+ * @addtogroup bacnet_tests
+ * @{
+ */
+
+#define TEST_HANDLED_MAX 64
+
+static unsigned long Milliseconds;
+/* sequence number of each packet handled, in the order handled */
+static uint8_t Handled[TEST_HANDLED_MAX];
+static unsigned Handled_Count;
+
+unsigned long mstimer_now(void)
+{
+    return Milliseconds;
+}
+
+void npdu_handler(BACNET_ADDRESS *src, uint8_t *pdu, uint16_t pdu_len)
+{
+    (void)src;
+    zassert_equal(pdu_len, 3, NULL);
+    if (Handled_Count < TEST_HANDLED_MAX) {
+        Handled[Handled_Count] = pdu[2];
+        Handled_Count++;
+    }
+}
+
+/**
+ * Queues a packet of a network priority
+ *
+ * @param priority - network priority of the packet
+ * @param sequence - number recorded when the packet is handled
+ */
+static bool test_packet_add(BACNET_MESSAGE_PRIORITY priority, uint8_t sequence)
+{
+    BACNET_ADDRESS src = { 0 };
+    uint8_t pdu[3];
+
+    pdu[0] = BACNET_PROTOCOL_VERSION;
+    pdu[1] = (uint8_t)priority;
+    pdu[2] = sequence;
+
+    return npdu_queue_add(&src, pdu, sizeof(pdu));
+}
+
+static void test_setup(void)
+{
+    unsigned priority;
+
+    while (npdu_queue_task()) {
+    }
+    for (priority = 0; priority < 4; priority++) {
+        npdu_queue_quantum_set(priority, NPDU_QUEUE_QUANTUM);
+    }
+    npdu_queue_stats_reset();
+    Handled_Count = 0;
+    Milliseconds = 0;
+}
+
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(npdu_queue_tests, testPriorityOrder)
+#else
+static void testPriorityOrder(void)
+#endif
+{
+    test_setup();
+    zassert_true(npdu_queue_empty(), NULL);
+    zassert_true(test_packet_add(MESSAGE_PRIORITY_NORMAL, 1), NULL);
+    zassert_true(test_packet_add(MESSAGE_PRIORITY_URGENT, 2), NULL);
+    zassert_true(test_packet_add(MESSAGE_PRIORITY_LIFE_SAFETY, 3), NULL);
+    zassert_true(test_packet_add(MESSAGE_PRIORITY_CRITICAL_EQUIPMENT, 4), NULL);
+    zassert_true(test_packet_add(MESSAGE_PRIORITY_NORMAL, 5), NULL);
+    zassert_false(npdu_queue_empty(), NULL);
+    zassert_equal(npdu_queue_task(), 5, NULL);
+    zassert_true(npdu_queue_empty(), NULL);
+    zassert_equal(Handled_Count, 5, NULL);
+    zassert_equal(Handled[0], 3, NULL);
+    zassert_equal(Handled[1], 4, NULL);
+    zassert_equal(Handled[2], 2, NULL);
+    zassert_equal(Handled[3], 1, NULL);
+    zassert_equal(Handled[4], 5, NULL);
+    /* not a BACnet NPDU, or nothing at all */
+    zassert_false(npdu_queue_add(NULL, Handled, 1), NULL);
+    zassert_equal(npdu_queue_task(), 0, NULL);
+}
+
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(npdu_queue_tests, testQuantum)
+#else
+static void testQuantum(void)
+#endif
+{
+    uint8_t i;
+
+    test_setup();
+    npdu_queue_quantum_set(MESSAGE_PRIORITY_LIFE_SAFETY, 2);
+    for (i = 0; i < 4; i++) {
+        zassert_true(test_packet_add(MESSAGE_PRIORITY_LIFE_SAFETY, i), NULL);
+    }
+    zassert_true(test_packet_add(MESSAGE_PRIORITY_NORMAL, 10), NULL);
+    /* normal traffic is served in the first pass, behind a quantum
+       of the life-safety traffic */
+    zassert_equal(npdu_queue_task(), 3, NULL);
+    zassert_equal(Handled[0], 0, NULL);
+    zassert_equal(Handled[1], 1, NULL);
+    zassert_equal(Handled[2], 10, NULL);
+    zassert_equal(npdu_queue_task(), 2, NULL);
+    zassert_equal(Handled[3], 2, NULL);
+    zassert_equal(Handled[4], 3, NULL);
+    zassert_true(npdu_queue_empty(), NULL);
+}
+
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(npdu_queue_tests, testFullPriority)
+#else
+static void testFullPriority(void)
+#endif
+{
+    uint8_t i;
+
+    test_setup();
+    for (i = 0; i < NPDU_QUEUE_SIZE; i++) {
+        zassert_true(test_packet_add(MESSAGE_PRIORITY_URGENT, i), NULL);
+    }
+    zassert_equal(Handled_Count, 0, NULL);
+    /* the oldest packet is handled to make room */
+    zassert_true(test_packet_add(MESSAGE_PRIORITY_URGENT, i), NULL);
+    zassert_equal(Handled_Count, 1, NULL);
+    zassert_equal(Handled[0], 0, NULL);
+    while (npdu_queue_task()) {
+    }
+    zassert_equal(Handled_Count, NPDU_QUEUE_SIZE + 1, NULL);
+    for (i = 0; i <= NPDU_QUEUE_SIZE; i++) {
+        zassert_equal(Handled[i], i, NULL);
+    }
+}
+
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(npdu_queue_tests, testQueueDelay)
+#else
+static void testQueueDelay(void)
+#endif
+{
+    NPDU_QUEUE_STATS stats = { 0 };
+
+    test_setup();
+    Milliseconds = 100;
+    zassert_true(test_packet_add(MESSAGE_PRIORITY_NORMAL, 1), NULL);
+    Milliseconds = 110;
+    zassert_true(test_packet_add(MESSAGE_PRIORITY_NORMAL, 2), NULL);
+    zassert_true(test_packet_add(MESSAGE_PRIORITY_CRITICAL_EQUIPMENT, 3), NULL);
+    Milliseconds = 130;
+    zassert_equal(npdu_queue_task(), 3, NULL);
+    zassert_true(npdu_queue_stats(MESSAGE_PRIORITY_NORMAL, &stats), NULL);
+    zassert_equal(stats.count, 2, NULL);
+    zassert_equal(stats.delay_total, 30 + 20, NULL);
+    zassert_equal(stats.delay_max, 30, NULL);
+    zassert_true(
+        npdu_queue_stats(MESSAGE_PRIORITY_CRITICAL_EQUIPMENT, &stats), NULL);
+    zassert_equal(stats.count, 1, NULL);
+    zassert_equal(stats.delay_total, 20, NULL);
+    zassert_equal(stats.delay_max, 20, NULL);
+    zassert_true(npdu_queue_stats(MESSAGE_PRIORITY_URGENT, &stats), NULL);
+    zassert_equal(stats.count, 0, NULL);
+    zassert_false(npdu_queue_stats(4, &stats), NULL);
+    npdu_queue_stats_reset();
+    zassert_true(npdu_queue_stats(MESSAGE_PRIORITY_NORMAL, &stats), NULL);
+    zassert_equal(stats.count, 0, NULL);
+}
+/**
+ * @}
+ */
+
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST_SUITE(npdu_queue_tests, NULL, NULL, NULL, NULL, NULL);
+#else
+void test_main(void)
+{
+    ztest_test_suite(npdu_queue_tests,
+     ztest_unit_test(testPriorityOrder),
+     ztest_unit_test(testQuantum),
+     ztest_unit_test(testFullPriority),
+     ztest_unit_test(testQueueDelay)
+     );
+
+    ztest_run_test_suite(npdu_queue_tests);
+}
+#endif
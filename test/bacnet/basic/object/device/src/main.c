@@ -8,8 +8,13 @@
  * @brief test BACnet integer encode/decode APIs
  */
 
+#include <string.h>
 #include <zephyr/ztest.h>
 #include <bacnet/basic/object/device.h>
+#include <bacnet/basic/object/ai.h>
+#include <bacnet/basic/object/ao.h>
+#include <bacnet/basic/object/bo.h>
+#include <bacnet/basic/object/provision.h>
 
 /**
  * @addtogroup bacnet_tests
@@ -53,6 +58,108 @@ static void testDevice(void)
 
     return;
 }
+
+static bool test_object_name(
+    BACNET_OBJECT_TYPE object_type, uint32_t object_instance, const char *name)
+{
+    BACNET_CHARACTER_STRING object_name;
+
+    if (!Device_Object_Name_Copy(object_type, object_instance, &object_name)) {
+        return false;
+    }
+
+    return (characterstring_length(&object_name) == strlen(name)) &&
+        (memcmp(characterstring_value(&object_name), name, strlen(name)) ==
+            0);
+}
+
+/**
+ * @brief Test bulk provisioning from a point list
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(device_tests, testProvision)
+#else
+static void testProvision(void)
+#endif
+{
+    static char csv_list[] = "# point list\r\n"
+                             "type,instance,name,units,cov_increment,notes,"
+                             "description\r\n"
+                             "analog-output,3,\"AHU-1 \"\"Damper\"\"\","
+                             "percent,0.5,spare,Outside air\r\n"
+                             "\r\n"
+                             "analog-output,1,AHU-1 Valve,98\r\n"
+                             "binary-output, 7 ,Fan Start\r\n"
+                             "analog-input,1,,,2.5\r\n";
+    static char json_list[] = "[\n"
+                              " {\"type\": \"analog-output\", \"instance\": 4,\n"
+                              "  \"name\": \"Supply \\u00b0C\", \"units\": 62,\n"
+                              "  \"cov_increment\": 0.25, \"description\": null},\n"
+                              " {\"type\": \"analog-output\", \"instance\": 3,\n"
+                              "  \"name\": \"AHU-1 Damper\"}\n"
+                              "]\n";
+    char duplicate_name[] = "[{\"type\":\"analog-output\",\"instance\":10,"
+                            "\"name\":\"Fan Start\"}]";
+    char duplicate_id[] = "analog-output,10,A\n"
+                          "analog-output,11,B\n"
+                          "analog-output,10,C\n";
+    char unsupported[] = "analog-input,1,AI One\n";
+    char missing[] = "analog-output,10,A\nanalog-output\n";
+    char malformed[] = "[\n{\"type\": \"analog-output\" \"instance\": 10}]";
+    BACNET_CHARACTER_STRING object_name;
+    BACNET_OBJECT_TYPE object_type = OBJECT_NONE;
+    uint32_t object_instance = 0;
+    uint32_t revision;
+    unsigned line = 0;
+
+    Device_Init(NULL);
+    revision = Device_Database_Revision();
+    zassert_equal(Provision_Load(csv_list, &line), 4, NULL);
+    zassert_equal(line, 0, NULL);
+    /* one change of database revision for the whole point list */
+    zassert_equal(Device_Database_Revision(), revision + 1, NULL);
+    zassert_true(Analog_Output_Valid_Instance(1), NULL);
+    zassert_true(Analog_Output_Valid_Instance(3), NULL);
+    zassert_true(test_object_name(OBJECT_ANALOG_OUTPUT, 3,
+                     "AHU-1 \"Damper\""), NULL);
+    zassert_equal(Analog_Output_Units(3), UNITS_PERCENT, NULL);
+    zassert_equal(Analog_Output_Units(1), UNITS_PERCENT, NULL);
+    zassert_true(Analog_Output_COV_Increment(3) == 0.5f, NULL);
+    zassert_true(test_object_name(OBJECT_BINARY_OUTPUT, 7, "Fan Start"), NULL);
+    zassert_true(Analog_Input_COV_Increment(1) == 2.5f, NULL);
+    /* names are found by the device again after the load */
+    characterstring_init_ansi(&object_name, "Fan Start");
+    zassert_true(Device_Valid_Object_Name(
+                     &object_name, &object_type, &object_instance), NULL);
+    zassert_equal(object_type, OBJECT_BINARY_OUTPUT, NULL);
+    zassert_equal(object_instance, 7, NULL);
+    /* a point list with an error changes nothing */
+    revision = Device_Database_Revision();
+    zassert_equal(Provision_Load(duplicate_name, &line), -1, NULL);
+    zassert_equal(line, 1, NULL);
+    zassert_equal(Provision_Load(duplicate_id, &line), -1, NULL);
+    zassert_equal(line, 3, NULL);
+    zassert_equal(Provision_Load(unsupported, &line), -1, NULL);
+    zassert_equal(line, 1, NULL);
+    zassert_equal(Provision_Load(missing, &line), -1, NULL);
+    zassert_equal(line, 2, NULL);
+    zassert_equal(Provision_Load(malformed, &line), -1, NULL);
+    zassert_equal(line, 2, NULL);
+    zassert_equal(Provision_Load(NULL, &line), -1, NULL);
+    zassert_false(Analog_Output_Valid_Instance(10), NULL);
+    zassert_false(Analog_Output_Valid_Instance(11), NULL);
+    zassert_equal(Device_Database_Revision(), revision, NULL);
+    /* renaming an object */
+    zassert_equal(Provision_Load(json_list, &line), 2, NULL);
+    zassert_equal(line, 0, NULL);
+    zassert_equal(Device_Database_Revision(), revision + 1, NULL);
+    zassert_true(
+        test_object_name(OBJECT_ANALOG_OUTPUT, 4, "Supply \xc2\xb0" "C"),
+        NULL);
+    zassert_equal(Analog_Output_Units(4), UNITS_DEGREES_CELSIUS, NULL);
+    zassert_true(test_object_name(OBJECT_ANALOG_OUTPUT, 3, "AHU-1 Damper"),
+        NULL);
+}
 /**
  * @}
  */
@@ -64,7 +171,8 @@ ZTEST_SUITE(device_tests, NULL, NULL, NULL, NULL, NULL);
 void test_main(void)
 {
     ztest_test_suite(device_tests,
-     ztest_unit_test(testDevice)
+     ztest_unit_test(testDevice),
+     ztest_unit_test(testProvision)
      );
 
     ztest_run_test_suite(device_tests);
@@ -30,6 +30,9 @@
 #include "bacnet/datetime.h"
 #include "bacnet/bacdef.h"
 #include "bacnet/npdu.h"
+#include "bacnet/cov.h"
+#include "bacnet/basic/sys/mstimer.h"
+#include "bacnet/datalink/bvlc.h"
 
 void datetime_init(void)
 {
@@ -56,3 +59,28 @@ int bip_send_pdu(
 {
     return 0;
 }
+
+void handler_ucov_notification_add(BACNET_COV_NOTIFICATION * cb)
+{
+}
+
+void Send_WhoIs(int32_t low_limit, int32_t high_limit)
+{
+}
+
+uint8_t Send_COV_Subscribe(
+    uint32_t device_id,
+    BACNET_SUBSCRIBE_COV_DATA * cov_data)
+{
+    return 0;
+}
+
+unsigned long mstimer_now(void)
+{
+    return 0;
+}
+
+BACNET_IP_FOREIGN_DEVICE_TABLE_ENTRY *bvlc_fdt_list(void)
+{
+    return NULL;
+}
@@ -35,6 +35,14 @@ uint8_t Send_CEvent_Notify(
     return 0;
 }
 
+bool Send_CEvent_Notify_Queue(
+    uint32_t device_id, BACNET_EVENT_NOTIFICATION_DATA *data)
+{
+    (void)device_id;
+    (void)data;
+    return true;
+}
+
 void Send_WhoIs(int32_t low_limit, int32_t high_limit)
 {
     (void)low_limit;
@@ -0,0 +1,15 @@
+/*
+ * SPDX-License-Identifier: MIT
+ */
+
+/* @file
+ * @brief stubs for the BBMD used by the Network Port object
+ */
+
+#include <stddef.h>
+#include "bacnet/datalink/bvlc.h"
+
+BACNET_IP_FOREIGN_DEVICE_TABLE_ENTRY *bvlc_fdt_list(void)
+{
+    return NULL;
+}
@@ -0,0 +1,547 @@
+/*
+ * SPDX-License-Identifier: MIT
+ */
+
+/* @file
+ * @brief test the Trend Log object: its logging types and COV logging
+ */
+
+#include <zephyr/ztest.h>
+#include <bacnet/bacapp.h>
+#include <bacnet/bacdcode.h>
+#include <bacnet/bacdevobjpropref.h>
+#include <bacnet/cov.h>
+#include <bacnet/rp.h>
+#include <bacnet/wp.h>
+#include <bacnet/basic/object/trendlog.h>
+
+/**
+ * @addtogroup bacnet_tests
+ * @{
+ */
+
+extern float Test_Present_Value;
+extern bool Test_Device_Bound;
+extern BACNET_COV_NOTIFICATION *Test_Local_Notification;
+extern BACNET_COV_NOTIFICATION *Test_Remote_Notification;
+extern unsigned Test_Local_Subscribe_Count;
+extern bool Test_Local_Subscribed;
+extern unsigned Test_Subscribe_Count;
+extern BACNET_SUBSCRIBE_COV_DATA Test_Subscribe_Data;
+extern unsigned Test_WhoIs_Count;
+
+/**
+ * Writes an application encoded value to a Trend Log property
+ *
+ * @param instance - Trend Log instance
+ * @param property - property written
+ * @param value - the value
+ * @param error_code - filled with the error code if the write fails
+ * @return true if the write succeeded
+ */
+static bool test_write(uint32_t instance,
+    BACNET_PROPERTY_ID property,
+    BACNET_APPLICATION_DATA_VALUE *value,
+    BACNET_ERROR_CODE *error_code)
+{
+    BACNET_WRITE_PROPERTY_DATA wp_data = { 0 };
+    bool status;
+
+    wp_data.object_type = OBJECT_TRENDLOG;
+    wp_data.object_instance = instance;
+    wp_data.object_property = property;
+    wp_data.array_index = BACNET_ARRAY_ALL;
+    wp_data.priority = BACNET_NO_PRIORITY;
+    wp_data.application_data_len =
+        bacapp_encode_application_data(wp_data.application_data, value);
+    status = Trend_Log_Write_Property(&wp_data);
+    if (error_code) {
+        *error_code = wp_data.error_code;
+    }
+
+    return status;
+}
+
+static bool test_write_unsigned(uint32_t instance,
+    BACNET_PROPERTY_ID property,
+    BACNET_UNSIGNED_INTEGER unsigned_value,
+    BACNET_ERROR_CODE *error_code)
+{
+    BACNET_APPLICATION_DATA_VALUE value = { 0 };
+
+    value.tag = BACNET_APPLICATION_TAG_UNSIGNED_INT;
+    value.type.Unsigned_Int = unsigned_value;
+
+    return test_write(instance, property, &value, error_code);
+}
+
+static bool test_write_enumerated(uint32_t instance,
+    BACNET_PROPERTY_ID property,
+    uint32_t enumerated_value,
+    BACNET_ERROR_CODE *error_code)
+{
+    BACNET_APPLICATION_DATA_VALUE value = { 0 };
+
+    value.tag = BACNET_APPLICATION_TAG_ENUMERATED;
+    value.type.Enumerated = enumerated_value;
+
+    return test_write(instance, property, &value, error_code);
+}
+
+static bool test_write_boolean(
+    uint32_t instance, BACNET_PROPERTY_ID property, bool boolean_value)
+{
+    BACNET_APPLICATION_DATA_VALUE value = { 0 };
+
+    value.tag = BACNET_APPLICATION_TAG_BOOLEAN;
+    value.type.Boolean = boolean_value;
+
+    return test_write(instance, property, &value, NULL);
+}
+
+/**
+ * Writes the Log_DeviceObjectProperty of a Trend Log
+ *
+ * @param instance - Trend Log instance
+ * @param device_instance - device of the logged object
+ * @param object_instance - the logged Analog Input
+ * @param property - the logged property
+ * @return true if the write succeeded
+ */
+static bool test_write_source_property(uint32_t instance,
+    uint32_t device_instance,
+    uint32_t object_instance,
+    BACNET_PROPERTY_ID property)
+{
+    BACNET_WRITE_PROPERTY_DATA wp_data = { 0 };
+    BACNET_DEVICE_OBJECT_PROPERTY_REFERENCE source = { 0 };
+
+    source.objectIdentifier.type = OBJECT_ANALOG_INPUT;
+    source.objectIdentifier.instance = object_instance;
+    source.propertyIdentifier = property;
+    source.arrayIndex = BACNET_ARRAY_ALL;
+    source.deviceIdentifier.type = OBJECT_DEVICE;
+    source.deviceIdentifier.instance = device_instance;
+    wp_data.object_type = OBJECT_TRENDLOG;
+    wp_data.object_instance = instance;
+    wp_data.object_property = PROP_LOG_DEVICE_OBJECT_PROPERTY;
+    wp_data.array_index = BACNET_ARRAY_ALL;
+    wp_data.priority = BACNET_NO_PRIORITY;
+    wp_data.application_data_len = bacapp_encode_device_obj_property_ref(
+        wp_data.application_data, &source);
+
+    return Trend_Log_Write_Property(&wp_data);
+}
+
+/**
+ * Writes the Log_DeviceObjectProperty of a Trend Log of a Present_Value
+ *
+ * @param instance - Trend Log instance
+ * @param device_instance - device of the logged object
+ * @param object_instance - the logged Analog Input
+ * @return true if the write succeeded
+ */
+static bool test_write_source(
+    uint32_t instance, uint32_t device_instance, uint32_t object_instance)
+{
+    return test_write_source_property(
+        instance, device_instance, object_instance, PROP_PRESENT_VALUE);
+}
+
+/**
+ * Reads an unsigned or enumerated Trend Log property
+ *
+ * @param instance - Trend Log instance
+ * @param property - property read
+ * @return the value
+ */
+static uint32_t test_read(uint32_t instance, BACNET_PROPERTY_ID property)
+{
+    BACNET_READ_PROPERTY_DATA rpdata = { 0 };
+    BACNET_APPLICATION_DATA_VALUE value = { 0 };
+    uint8_t apdu[MAX_APDU] = { 0 };
+    int len;
+
+    rpdata.object_type = OBJECT_TRENDLOG;
+    rpdata.object_instance = instance;
+    rpdata.object_property = property;
+    rpdata.array_index = BACNET_ARRAY_ALL;
+    rpdata.application_data = &apdu[0];
+    rpdata.application_data_len = sizeof(apdu);
+    len = Trend_Log_Read_Property(&rpdata);
+    zassert_true(len > 0, NULL);
+    len = bacapp_decode_application_data(apdu, (unsigned)len, &value);
+    zassert_true(len > 0, NULL);
+    if (value.tag == BACNET_APPLICATION_TAG_ENUMERATED) {
+        return value.type.Enumerated;
+    }
+    zassert_equal(value.tag, BACNET_APPLICATION_TAG_UNSIGNED_INT, NULL);
+
+    return (uint32_t)value.type.Unsigned_Int;
+}
+
+/**
+ * Delivers a COV notification of an Analog Input to a Trend Log callback
+ *
+ * @param notification - the local or the remote callback
+ * @param device_instance - the initiating device
+ * @param pid - the subscriber process identifier
+ * @param object_instance - the Analog Input
+ * @param property - the property notified
+ * @param real_value - its value
+ */
+static void test_notify(BACNET_COV_NOTIFICATION *notification,
+    uint32_t device_instance,
+    uint32_t pid,
+    uint32_t object_instance,
+    BACNET_PROPERTY_ID property,
+    float real_value)
+{
+    BACNET_COV_DATA cov_data = { 0 };
+    BACNET_PROPERTY_VALUE value_list[2];
+
+    bacapp_property_value_list_init(&value_list[0], 2);
+    value_list[0].propertyIdentifier = property;
+    value_list[0].value.tag = BACNET_APPLICATION_TAG_REAL;
+    value_list[0].value.type.Real = real_value;
+    value_list[1].propertyIdentifier = PROP_STATUS_FLAGS;
+    value_list[1].value.tag = BACNET_APPLICATION_TAG_BIT_STRING;
+    bitstring_init(&value_list[1].value.type.Bit_String);
+    bitstring_set_bit(&value_list[1].value.type.Bit_String, 0, false);
+    cov_data.subscriberProcessIdentifier = pid;
+    cov_data.initiatingDeviceIdentifier = device_instance;
+    cov_data.monitoredObjectIdentifier.type = OBJECT_ANALOG_INPUT;
+    cov_data.monitoredObjectIdentifier.instance = object_instance;
+    cov_data.listOfValues = &value_list[0];
+    zassert_not_null(notification, NULL);
+    notification->callback(&cov_data);
+}
+
+/**
+ * @brief Unit Test for writing Log_Interval, which switches only
+ *  between polled and COV logging
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(trendlog_tests, testTrendLogLogInterval)
+#else
+static void testTrendLogLogInterval(void)
+#endif
+{
+    BACNET_ERROR_CODE error_code = ERROR_CODE_SUCCESS;
+    const uint32_t instance = 2;
+    bool status;
+
+    Trend_Log_Init();
+    zassert_equal(
+        test_read(instance, PROP_LOGGING_TYPE), LOGGING_TYPE_POLLED, NULL);
+    /* clearing the interval of a polled log switches it to COV */
+    status = test_write_unsigned(instance, PROP_LOG_INTERVAL, 0, NULL);
+    zassert_true(status, NULL);
+    zassert_equal(
+        test_read(instance, PROP_LOGGING_TYPE), LOGGING_TYPE_COV, NULL);
+    zassert_equal(test_read(instance, PROP_LOG_INTERVAL), 0, NULL);
+    /* and setting it switches a COV log back to polled */
+    status = test_write_unsigned(instance, PROP_LOG_INTERVAL, 6000, NULL);
+    zassert_true(status, NULL);
+    zassert_equal(
+        test_read(instance, PROP_LOGGING_TYPE), LOGGING_TYPE_POLLED, NULL);
+    zassert_equal(test_read(instance, PROP_LOG_INTERVAL), 6000, NULL);
+    /* a triggered log keeps its logging type */
+    status = test_write_enumerated(
+        instance, PROP_LOGGING_TYPE, LOGGING_TYPE_TRIGGERED, NULL);
+    zassert_true(status, NULL);
+    zassert_equal(test_read(instance, PROP_LOG_INTERVAL), 0, NULL);
+    status = test_write_unsigned(instance, PROP_LOG_INTERVAL, 0, &error_code);
+    zassert_false(status, NULL);
+    zassert_equal(error_code, ERROR_CODE_WRITE_ACCESS_DENIED, NULL);
+    zassert_equal(
+        test_read(instance, PROP_LOGGING_TYPE), LOGGING_TYPE_TRIGGERED, NULL);
+    status =
+        test_write_unsigned(instance, PROP_LOG_INTERVAL, 6000, &error_code);
+    zassert_false(status, NULL);
+    zassert_equal(error_code, ERROR_CODE_WRITE_ACCESS_DENIED, NULL);
+    zassert_equal(
+        test_read(instance, PROP_LOGGING_TYPE), LOGGING_TYPE_TRIGGERED, NULL);
+    status = test_write_enumerated(
+        instance, PROP_LOGGING_TYPE, LOGGING_TYPE_POLLED, NULL);
+    zassert_true(status, NULL);
+    zassert_equal(test_read(instance, PROP_LOG_INTERVAL), 900 * 100, NULL);
+}
+
+/**
+ * @brief Unit Test for COV logging of an object in this device
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(trendlog_tests, testTrendLogCOVLocal)
+#else
+static void testTrendLogCOVLocal(void)
+#endif
+{
+    const uint32_t instance = 0;
+    uint32_t total;
+    bool status;
+
+    Trend_Log_Init();
+    status = test_write_enumerated(
+        instance, PROP_LOGGING_TYPE, LOGGING_TYPE_COV, NULL);
+    zassert_true(status, NULL);
+    zassert_equal(test_read(instance, PROP_LOG_INTERVAL), 0, NULL);
+    /* the timer subscribes, and logs the current value */
+    total = test_read(instance, PROP_TOTAL_RECORD_COUNT);
+    Test_Local_Subscribe_Count = 0;
+    Test_Present_Value = 21.5f;
+    trend_log_timer(1);
+    zassert_equal(Test_Local_Subscribe_Count, 1, NULL);
+    zassert_true(Test_Local_Subscribed, NULL);
+    total++;
+    zassert_equal(test_read(instance, PROP_TOTAL_RECORD_COUNT), total, NULL);
+    trend_log_timer(1);
+    zassert_equal(Test_Local_Subscribe_Count, 1, NULL);
+    zassert_equal(test_read(instance, PROP_TOTAL_RECORD_COUNT), total, NULL);
+    /* each notification of the logged property is a record */
+    test_notify(Test_Local_Notification, 1234, 0, 0, PROP_PRESENT_VALUE,
+        22.5f);
+    total++;
+    zassert_equal(test_read(instance, PROP_TOTAL_RECORD_COUNT), total, NULL);
+    /* but not of another object, property, or device */
+    test_notify(Test_Local_Notification, 1234, 0, 0, PROP_COV_INCREMENT,
+        1.0f);
+    test_notify(Test_Local_Notification, 1234, 0, 5, PROP_PRESENT_VALUE,
+        1.0f);
+    test_notify(Test_Remote_Notification, 99, 0, 0, PROP_PRESENT_VALUE,
+        1.0f);
+    zassert_equal(test_read(instance, PROP_TOTAL_RECORD_COUNT), total, NULL);
+    /* a disabled log does not record, and drops its subscription */
+    status = test_write_boolean(instance, PROP_ENABLE, false);
+    zassert_true(status, NULL);
+    total = test_read(instance, PROP_TOTAL_RECORD_COUNT);
+    test_notify(Test_Local_Notification, 1234, 0, 0, PROP_PRESENT_VALUE,
+        23.5f);
+    zassert_equal(test_read(instance, PROP_TOTAL_RECORD_COUNT), total, NULL);
+    trend_log_timer(1);
+    zassert_equal(Test_Local_Subscribe_Count, 2, NULL);
+    zassert_false(Test_Local_Subscribed, NULL);
+    status = test_write_boolean(instance, PROP_ENABLE, true);
+    zassert_true(status, NULL);
+    /* polling again drops the subscription too */
+    trend_log_timer(1);
+    zassert_true(Test_Local_Subscribed, NULL);
+    status = test_write_unsigned(instance, PROP_LOG_INTERVAL, 6000, NULL);
+    zassert_true(status, NULL);
+    trend_log_timer(1);
+    zassert_false(Test_Local_Subscribed, NULL);
+    total = test_read(instance, PROP_TOTAL_RECORD_COUNT);
+    test_notify(Test_Local_Notification, 1234, 0, 0, PROP_PRESENT_VALUE,
+        24.5f);
+    zassert_equal(test_read(instance, PROP_TOTAL_RECORD_COUNT), total, NULL);
+}
+
+/**
+ * @brief Unit Test for a local property that the COV change path of the
+ *  object does not report: COV logging is refused, and polled instead
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(trendlog_tests, testTrendLogCOVLocalProperty)
+#else
+static void testTrendLogCOVLocalProperty(void)
+#endif
+{
+    BACNET_ERROR_CODE error_code = ERROR_CODE_SUCCESS;
+    const uint32_t instance = 4;
+    unsigned subscribe_count;
+    bool status;
+
+    Trend_Log_Init();
+    status = test_write_source_property(
+        instance, 1234, 4, PROP_COV_INCREMENT);
+    zassert_true(status, NULL);
+    /* a polled log is not switched to COV */
+    status = test_write_enumerated(
+        instance, PROP_LOGGING_TYPE, LOGGING_TYPE_COV, &error_code);
+    zassert_false(status, NULL);
+    zassert_equal(
+        error_code, ERROR_CODE_OPTIONAL_FUNCTIONALITY_NOT_SUPPORTED, NULL);
+    status = test_write_unsigned(instance, PROP_LOG_INTERVAL, 0, &error_code);
+    zassert_false(status, NULL);
+    zassert_equal(
+        error_code, ERROR_CODE_OPTIONAL_FUNCTIONALITY_NOT_SUPPORTED, NULL);
+    zassert_equal(
+        test_read(instance, PROP_LOGGING_TYPE), LOGGING_TYPE_POLLED, NULL);
+    /* and a COV log of such a property falls back to polling */
+    status = test_write_source(instance, 1234, 4);
+    zassert_true(status, NULL);
+    status = test_write_enumerated(
+        instance, PROP_LOGGING_TYPE, LOGGING_TYPE_COV, NULL);
+    zassert_true(status, NULL);
+    status = test_write_source_property(
+        instance, 1234, 4, PROP_COV_INCREMENT);
+    zassert_true(status, NULL);
+    subscribe_count = Test_Local_Subscribe_Count;
+    trend_log_timer(1);
+    zassert_equal(Test_Local_Subscribe_Count, subscribe_count, NULL);
+    zassert_equal(
+        test_read(instance, PROP_LOGGING_TYPE), LOGGING_TYPE_POLLED, NULL);
+    zassert_equal(test_read(instance, PROP_LOG_INTERVAL), 900 * 100, NULL);
+}
+
+/**
+ * @brief Unit Test for COV logging of an object in another device
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(trendlog_tests, testTrendLogCOVRemote)
+#else
+static void testTrendLogCOVRemote(void)
+#endif
+{
+    BACNET_ERROR_CODE error_code = ERROR_CODE_SUCCESS;
+    const uint32_t instance = 1;
+    uint32_t total;
+    bool status;
+
+    Trend_Log_Init();
+    /* remote sources are only logged by COV */
+    status = test_write_source(instance, 5678, 7);
+    zassert_false(status, NULL);
+    status = test_write_enumerated(
+        instance, PROP_LOGGING_TYPE, LOGGING_TYPE_COV, NULL);
+    zassert_true(status, NULL);
+    status = test_write_source(instance, 5678, 7);
+    zassert_true(status, NULL);
+    status =
+        test_write_unsigned(instance, PROP_LOG_INTERVAL, 6000, &error_code);
+    zassert_false(status, NULL);
+    zassert_equal(
+        error_code, ERROR_CODE_OPTIONAL_FUNCTIONALITY_NOT_SUPPORTED, NULL);
+    status = test_write_enumerated(
+        instance, PROP_LOGGING_TYPE, LOGGING_TYPE_POLLED, &error_code);
+    zassert_false(status, NULL);
+    zassert_equal(
+        test_read(instance, PROP_LOGGING_TYPE), LOGGING_TYPE_COV, NULL);
+    /* an unbound device is looked for, and the subscription retried */
+    Test_Device_Bound = false;
+    Test_WhoIs_Count = 0;
+    Test_Subscribe_Count = 0;
+    trend_log_timer(1);
+    zassert_equal(Test_WhoIs_Count, 1, NULL);
+    zassert_equal(Test_Subscribe_Count, 0, NULL);
+    Test_Device_Bound = true;
+    trend_log_timer(1);
+    zassert_equal(Test_Subscribe_Count, 0, NULL);
+    trend_log_timer(10);
+    zassert_equal(Test_Subscribe_Count, 1, NULL);
+    zassert_equal(Test_Subscribe_Data.subscriberProcessIdentifier, instance,
+        NULL);
+    zassert_equal(Test_Subscribe_Data.monitoredObjectIdentifier.type,
+        OBJECT_ANALOG_INPUT, NULL);
+    zassert_equal(
+        Test_Subscribe_Data.monitoredObjectIdentifier.instance, 7, NULL);
+    zassert_false(Test_Subscribe_Data.cancellationRequest, NULL);
+    zassert_false(Test_Subscribe_Data.covSubscribeToProperty, NULL);
+    zassert_equal(Test_Subscribe_Data.lifetime,
+        2 * test_read(instance, PROP_COV_RESUBSCRIPTION_INTERVAL), NULL);
+    /* notifications to this log, from that device, are recorded */
+    total = test_read(instance, PROP_TOTAL_RECORD_COUNT);
+    test_notify(Test_Remote_Notification, 5678, instance, 7,
+        PROP_PRESENT_VALUE, 3.0f);
+    total++;
+    zassert_equal(test_read(instance, PROP_TOTAL_RECORD_COUNT), total, NULL);
+    test_notify(Test_Remote_Notification, 5678, instance + 1, 7,
+        PROP_PRESENT_VALUE, 3.0f);
+    test_notify(Test_Remote_Notification, 99, instance, 7,
+        PROP_PRESENT_VALUE, 3.0f);
+    test_notify(Test_Local_Notification, 1234, 0, 7, PROP_PRESENT_VALUE,
+        3.0f);
+    zassert_equal(test_read(instance, PROP_TOTAL_RECORD_COUNT), total, NULL);
+    /* the subscription is renewed at the resubscription interval */
+    trend_log_timer(
+        (uint16_t)test_read(instance, PROP_COV_RESUBSCRIPTION_INTERVAL) - 1);
+    zassert_equal(Test_Subscribe_Count, 1, NULL);
+    trend_log_timer(1);
+    zassert_equal(Test_Subscribe_Count, 2, NULL);
+    zassert_false(Test_Subscribe_Data.cancellationRequest, NULL);
+    /* and cancelled when the log is disabled */
+    status = test_write_boolean(instance, PROP_ENABLE, false);
+    zassert_true(status, NULL);
+    trend_log_timer(1);
+    zassert_equal(Test_Subscribe_Count, 3, NULL);
+    zassert_true(Test_Subscribe_Data.cancellationRequest, NULL);
+    total = test_read(instance, PROP_TOTAL_RECORD_COUNT);
+    test_notify(Test_Remote_Notification, 5678, instance, 7,
+        PROP_PRESENT_VALUE, 4.0f);
+    zassert_equal(test_read(instance, PROP_TOTAL_RECORD_COUNT), total, NULL);
+}
+/**
+ * @brief Unit Test for the Buffer_Size, which the Record_Count of a
+ *  steadily sampled value reaches
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(trendlog_tests, testTrendLogBufferSize)
+#else
+static void testTrendLogBufferSize(void)
+#endif
+{
+    const uint32_t instance = 3;
+    uint32_t total;
+    uint32_t count;
+    bool status;
+
+    Trend_Log_Init();
+    zassert_equal(test_read(instance, PROP_BUFFER_SIZE), TL_MAX_ENTRIES, NULL);
+    zassert_equal(TL_MAX_ENTRIES, TL_MAX_BLOCKS * TL_BLOCK_RECORDS, NULL);
+    /* the demo records do not compress as well, and fill fewer */
+    zassert_true(
+        test_read(instance, PROP_RECORD_COUNT) <= TL_MAX_ENTRIES, NULL);
+    status = test_write_enumerated(
+        instance, PROP_LOGGING_TYPE, LOGGING_TYPE_COV, NULL);
+    zassert_true(status, NULL);
+    /* a cleared log starts again from the status record */
+    status = test_write_unsigned(instance, PROP_RECORD_COUNT, 0, NULL);
+    zassert_true(status, NULL);
+    zassert_equal(test_read(instance, PROP_RECORD_COUNT), 1, NULL);
+    /* the timer subscribes, and a steady value fills the buffer */
+    Test_Present_Value = 20.0f;
+    trend_log_timer(1);
+    zassert_equal(test_read(instance, PROP_RECORD_COUNT), 2, NULL);
+    for (count = 2; count < TL_MAX_ENTRIES; count++) {
+        test_notify(Test_Local_Notification, 1234, 0, instance,
+            PROP_PRESENT_VALUE, 20.0f);
+    }
+    zassert_equal(test_read(instance, PROP_RECORD_COUNT), TL_MAX_ENTRIES, NULL);
+    /* the next record drops the oldest block */
+    total = test_read(instance, PROP_TOTAL_RECORD_COUNT);
+    test_notify(Test_Local_Notification, 1234, 0, instance,
+        PROP_PRESENT_VALUE, 20.0f);
+    zassert_equal(
+        test_read(instance, PROP_TOTAL_RECORD_COUNT), total + 1, NULL);
+    zassert_equal(test_read(instance, PROP_RECORD_COUNT),
+        TL_MAX_ENTRIES - TL_BLOCK_RECORDS + 1, NULL);
+    /* and the log fills up to the buffer size again */
+    for (count = 1; count < TL_BLOCK_RECORDS; count++) {
+        test_notify(Test_Local_Notification, 1234, 0, instance,
+            PROP_PRESENT_VALUE, 20.0f);
+    }
+    zassert_equal(test_read(instance, PROP_RECORD_COUNT), TL_MAX_ENTRIES, NULL);
+    status = test_write_unsigned(instance, PROP_RECORD_COUNT, 0, NULL);
+    zassert_true(status, NULL);
+    zassert_equal(test_read(instance, PROP_RECORD_COUNT), 1, NULL);
+}
+/**
+ * @}
+ */
+
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST_SUITE(trendlog_tests, NULL, NULL, NULL, NULL, NULL);
+#else
+void test_main(void)
+{
+    ztest_test_suite(trendlog_tests,
+     ztest_unit_test(testTrendLogLogInterval),
+     ztest_unit_test(testTrendLogCOVLocal),
+     ztest_unit_test(testTrendLogCOVLocalProperty),
+     ztest_unit_test(testTrendLogCOVRemote),
+     ztest_unit_test(testTrendLogBufferSize)
+     );
+
+    ztest_run_test_suite(trendlog_tests);
+}
+#endif
@@ -0,0 +1,127 @@
+/*
+ * SPDX-License-Identifier: MIT
+ */
+
+/* @file
+ * @brief stubs for the device, the COV services and the address binding
+ *  used by the Trend Log object
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "bacnet/bacdef.h"
+#include "bacnet/bacdcode.h"
+#include "bacnet/cov.h"
+#include "bacnet/datetime.h"
+#include "bacnet/rp.h"
+#include "bacnet/basic/binding/address.h"
+#include "bacnet/basic/object/device.h"
+#include "bacnet/basic/service/h_cov.h"
+#include "bacnet/basic/service/h_ucov.h"
+#include "bacnet/basic/service/s_cov.h"
+#include "bacnet/basic/service/s_whois.h"
+
+/* the Present_Value of every Analog Input in this device */
+float Test_Present_Value;
+/* the remote device is bound */
+bool Test_Device_Bound;
+/* the notification callbacks of the Trend Log */
+BACNET_COV_NOTIFICATION *Test_Local_Notification;
+BACNET_COV_NOTIFICATION *Test_Remote_Notification;
+/* the last local subscription */
+unsigned Test_Local_Subscribe_Count;
+bool Test_Local_Subscribed;
+/* the last SubscribeCOV request */
+unsigned Test_Subscribe_Count;
+BACNET_SUBSCRIBE_COV_DATA Test_Subscribe_Data;
+unsigned Test_WhoIs_Count;
+
+uint32_t Device_Object_Instance_Number(void)
+{
+    return 1234;
+}
+
+void Device_getCurrentDateTime(BACNET_DATE_TIME *DateTime)
+{
+    datetime_set_values(DateTime, 2015, 6, 1, 12, 0, 0, 0);
+}
+
+int Device_Read_Property(BACNET_READ_PROPERTY_DATA *rpdata)
+{
+    BACNET_BIT_STRING bit_string;
+    uint8_t *apdu = rpdata->application_data;
+
+    if (rpdata->object_type != OBJECT_ANALOG_INPUT) {
+        rpdata->error_class = ERROR_CLASS_OBJECT;
+        rpdata->error_code = ERROR_CODE_UNKNOWN_OBJECT;
+        return BACNET_STATUS_ERROR;
+    }
+    switch (rpdata->object_property) {
+        case PROP_PRESENT_VALUE:
+            return encode_application_real(apdu, Test_Present_Value);
+        case PROP_STATUS_FLAGS:
+            bitstring_init(&bit_string);
+            bitstring_set_bit(&bit_string, STATUS_FLAG_IN_ALARM, false);
+            bitstring_set_bit(&bit_string, STATUS_FLAG_FAULT, false);
+            bitstring_set_bit(&bit_string, STATUS_FLAG_OVERRIDDEN, false);
+            bitstring_set_bit(&bit_string, STATUS_FLAG_OUT_OF_SERVICE, false);
+            return encode_application_bitstring(apdu, &bit_string);
+        default:
+            break;
+    }
+    rpdata->error_class = ERROR_CLASS_PROPERTY;
+    rpdata->error_code = ERROR_CODE_UNKNOWN_PROPERTY;
+
+    return BACNET_STATUS_ERROR;
+}
+
+bool handler_cov_local_subscribe(
+    BACNET_OBJECT_TYPE object_type, uint32_t object_instance, bool subscribe)
+{
+    (void)object_type;
+    (void)object_instance;
+    Test_Local_Subscribe_Count++;
+    Test_Local_Subscribed = subscribe;
+
+    return true;
+}
+
+void handler_cov_local_notification_add(BACNET_COV_NOTIFICATION *cb)
+{
+    Test_Local_Notification = cb;
+}
+
+void handler_ucov_notification_add(BACNET_COV_NOTIFICATION *callback)
+{
+    Test_Remote_Notification = callback;
+}
+
+bool address_bind_request(
+    uint32_t device_id, unsigned *max_apdu, BACNET_ADDRESS *src)
+{
+    (void)device_id;
+    if (Test_Device_Bound) {
+        *max_apdu = MAX_APDU;
+        memset(src, 0, sizeof(*src));
+    }
+
+    return Test_Device_Bound;
+}
+
+void Send_WhoIs(int32_t low_limit, int32_t high_limit)
+{
+    (void)low_limit;
+    (void)high_limit;
+    Test_WhoIs_Count++;
+}
+
+uint8_t Send_COV_Subscribe(
+    uint32_t device_id, BACNET_SUBSCRIBE_COV_DATA *cov_data)
+{
+    (void)device_id;
+    Test_Subscribe_Count++;
+    Test_Subscribe_Data = *cov_data;
+
+    return 1;
+}
@@ -0,0 +1,228 @@
+/*
+ * SPDX-License-Identifier: MIT
+ */
+
+/* @file
+ * @brief test compressed block encoding of Trend Log records
+ */
+
+#include <zephyr/ztest.h>
+#include <bacnet/basic/object/trendlog_block.h>
+
+/**
+ * @addtogroup bacnet_tests
+ * @{
+ */
+
+#define TEST_BLOCK_SIZE 256
+
+static void test_record_same(TL_DATA_REC *expected, TL_DATA_REC *actual)
+{
+    uint8_t ucCount;
+
+    zassert_true(expected->tTimeStamp == actual->tTimeStamp, NULL);
+    zassert_equal(expected->ucRecType, actual->ucRecType, NULL);
+    zassert_equal(expected->ucStatus, actual->ucStatus, NULL);
+    switch (expected->ucRecType) {
+        case TL_TYPE_STATUS:
+            zassert_equal(
+                expected->Datum.ucLogStatus, actual->Datum.ucLogStatus, NULL);
+            break;
+        case TL_TYPE_BOOL:
+            zassert_equal(
+                expected->Datum.ucBoolean, actual->Datum.ucBoolean, NULL);
+            break;
+        case TL_TYPE_REAL:
+            zassert_true(expected->Datum.fReal == actual->Datum.fReal, NULL);
+            break;
+        case TL_TYPE_ENUM:
+            zassert_equal(expected->Datum.ulEnum, actual->Datum.ulEnum, NULL);
+            break;
+        case TL_TYPE_UNSIGN:
+            zassert_equal(
+                expected->Datum.ulUValue, actual->Datum.ulUValue, NULL);
+            break;
+        case TL_TYPE_SIGN:
+            zassert_equal(expected->Datum.lSValue, actual->Datum.lSValue, NULL);
+            break;
+        case TL_TYPE_BITS:
+            zassert_equal(
+                expected->Datum.Bits.ucLen, actual->Datum.Bits.ucLen, NULL);
+            for (ucCount = 0; ucCount < (expected->Datum.Bits.ucLen >> 4);
+                 ucCount++) {
+                zassert_equal(expected->Datum.Bits.ucStore[ucCount],
+                    actual->Datum.Bits.ucStore[ucCount], NULL);
+            }
+            break;
+        case TL_TYPE_ERROR:
+            zassert_equal(expected->Datum.Error.usClass,
+                actual->Datum.Error.usClass, NULL);
+            zassert_equal(
+                expected->Datum.Error.usCode, actual->Datum.Error.usCode, NULL);
+            break;
+        case TL_TYPE_DELTA:
+            zassert_true(expected->Datum.fTime == actual->Datum.fTime, NULL);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Test a steadily sampled REAL compresses and decodes
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(trendlog_block_tests, testTrendLogBlockReal)
+#else
+static void testTrendLogBlockReal(void)
+#endif
+{
+    uint8_t block[TEST_BLOCK_SIZE] = { 0 };
+    TL_BLOCK_STATE encoder = { 0 };
+    TL_BLOCK_STATE decoder = { 0 };
+    TL_BLOCK_STATE saved = { 0 };
+    TL_DATA_REC rec = { 0 };
+    TL_DATA_REC test_rec = { 0 };
+    bacnet_time_t tStart = 1234567890;
+    unsigned count = 0;
+    unsigned index = 0;
+
+    TL_Block_Start(&encoder, tStart);
+    for (;;) {
+        rec.tTimeStamp = tStart + (count * 60);
+        /* a little jitter now and then */
+        if ((count % 10) == 3) {
+            rec.tTimeStamp += 1;
+        }
+        rec.ucRecType = TL_TYPE_REAL;
+        rec.ucStatus = 128;
+        rec.Datum.fReal = 20.0f + (float)(count % 8) * 0.5f;
+        saved = encoder;
+        if (!TL_Block_Encode(block, sizeof(block), &encoder, &rec)) {
+            /* state is unchanged when the block is full */
+            zassert_mem_equal(&saved, &encoder, sizeof(saved), NULL);
+            break;
+        }
+        count++;
+    }
+    /* 16 octets or more per record uncompressed */
+    zassert_true(count >= ((sizeof(block) * 10) / sizeof(TL_DATA_REC)), NULL);
+    TL_Block_Start(&decoder, tStart);
+    for (index = 0; index < count; index++) {
+        zassert_true(
+            TL_Block_Decode(block, sizeof(block), &decoder, &test_rec), NULL);
+        rec.tTimeStamp = tStart + (index * 60);
+        if ((index % 10) == 3) {
+            rec.tTimeStamp += 1;
+        }
+        rec.Datum.fReal = 20.0f + (float)(index % 8) * 0.5f;
+        test_record_same(&rec, &test_rec);
+    }
+    zassert_equal(decoder.usBit, encoder.usBit, NULL);
+}
+
+/**
+ * @brief Test each record type round trips
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(trendlog_block_tests, testTrendLogBlockTypes)
+#else
+static void testTrendLogBlockTypes(void)
+#endif
+{
+    uint8_t block[TEST_BLOCK_SIZE] = { 0 };
+    TL_BLOCK_STATE encoder = { 0 };
+    TL_BLOCK_STATE decoder = { 0 };
+    TL_DATA_REC rec[12] = { 0 };
+    TL_DATA_REC test_rec = { 0 };
+    bacnet_time_t tStart = 1000;
+    unsigned index = 0;
+
+    rec[0].ucRecType = TL_TYPE_STATUS;
+    rec[0].Datum.ucLogStatus = 1 << LOG_STATUS_BUFFER_PURGED;
+    rec[1].ucRecType = TL_TYPE_BOOL;
+    rec[1].Datum.ucBoolean = 1;
+    rec[2].ucRecType = TL_TYPE_REAL;
+    rec[2].ucStatus = 128 | 2;
+    rec[2].Datum.fReal = -3.25f;
+    rec[3].ucRecType = TL_TYPE_REAL;
+    rec[3].ucStatus = 128 | 2;
+    rec[3].Datum.fReal = 1.0e10f;
+    rec[4].ucRecType = TL_TYPE_ENUM;
+    rec[4].Datum.ulEnum = 3;
+    rec[5].ucRecType = TL_TYPE_UNSIGN;
+    rec[5].Datum.ulUValue = 0xFFFFFFFFUL;
+    rec[6].ucRecType = TL_TYPE_SIGN;
+    rec[6].Datum.lSValue = -123456;
+    rec[7].ucRecType = TL_TYPE_BITS;
+    rec[7].Datum.Bits.ucLen = (3 << 4) | 5;
+    rec[7].Datum.Bits.ucStore[0] = 0xA5;
+    rec[7].Datum.Bits.ucStore[1] = 0x5A;
+    rec[7].Datum.Bits.ucStore[2] = 0xE0;
+    rec[8].ucRecType = TL_TYPE_NULL;
+    rec[9].ucRecType = TL_TYPE_ERROR;
+    rec[9].Datum.Error.usClass = ERROR_CLASS_PROPERTY;
+    rec[9].Datum.Error.usCode = ERROR_CODE_UNKNOWN_PROPERTY;
+    rec[10].ucRecType = TL_TYPE_DELTA;
+    rec[10].Datum.fTime = 0.5f;
+    rec[11].ucRecType = TL_TYPE_SIGN;
+    rec[11].Datum.lSValue = -123457;
+    /* intervals that need each size of delta-of-delta, forward and back */
+    rec[0].tTimeStamp = tStart;
+    rec[1].tTimeStamp = tStart + 1;
+    rec[2].tTimeStamp = rec[1].tTimeStamp + 60;
+    rec[3].tTimeStamp = rec[2].tTimeStamp + 300;
+    rec[4].tTimeStamp = rec[3].tTimeStamp + 2000;
+    rec[5].tTimeStamp = rec[4].tTimeStamp + 86400;
+    rec[6].tTimeStamp = rec[5].tTimeStamp - 100;
+    rec[7].tTimeStamp = rec[6].tTimeStamp - 100;
+    rec[8].tTimeStamp = rec[7].tTimeStamp;
+    rec[9].tTimeStamp = rec[8].tTimeStamp + 15;
+    rec[10].tTimeStamp = rec[9].tTimeStamp + 30;
+    rec[11].tTimeStamp = rec[10].tTimeStamp + 45;
+    TL_Block_Start(&encoder, tStart);
+    for (index = 0; index < 12; index++) {
+        zassert_true(
+            TL_Block_Encode(block, sizeof(block), &encoder, &rec[index]), NULL);
+    }
+    TL_Block_Start(&decoder, tStart);
+    for (index = 0; index < 12; index++) {
+        zassert_true(
+            TL_Block_Decode(block, sizeof(block), &decoder, &test_rec), NULL);
+        test_record_same(&rec[index], &test_rec);
+    }
+    /* an interval too long for one block */
+    rec[0].tTimeStamp = rec[11].tTimeStamp + 0x40000000UL;
+    zassert_false(
+        TL_Block_Encode(block, sizeof(block), &encoder, &rec[0]), NULL);
+    /* a record type we do not store */
+    rec[0].tTimeStamp = rec[11].tTimeStamp;
+    rec[0].ucRecType = TL_TYPE_ANY + 1;
+    zassert_false(
+        TL_Block_Encode(block, sizeof(block), &encoder, &rec[0]), NULL);
+    /* the worst case record fits the limit */
+    TL_Block_Start(&encoder, tStart);
+    rec[0].tTimeStamp = tStart + 0x3FFFFFFFUL;
+    rec[0].ucRecType = TL_TYPE_REAL;
+    rec[0].ucStatus = 0xFF;
+    rec[0].Datum.fReal = -1.0e-38f;
+    zassert_true(TL_Block_Encode(block, TL_BLOCK_RECORD_MAX, &encoder, &rec[0]),
+        NULL);
+}
+/**
+ * @}
+ */
+
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST_SUITE(trendlog_block_tests, NULL, NULL, NULL, NULL, NULL);
+#else
+void test_main(void)
+{
+    ztest_test_suite(trendlog_block_tests,
+     ztest_unit_test(testTrendLogBlockReal),
+     ztest_unit_test(testTrendLogBlockTypes)
+     );
+
+    ztest_run_test_suite(trendlog_block_tests);
+}
+#endif
@@ -0,0 +1,382 @@
+/*
+ * SPDX-License-Identifier: MIT
+ */
+
+/* @file
+ * @brief test the APDU handler: the replies kept for retransmitted
+ *  confirmed requests, and the limits of confirmed requests
+ */
+
+#include <zephyr/ztest.h>
+#include <bacnet/apdu.h>
+#include <bacnet/bacapp.h>
+#include <bacnet/bacdcode.h>
+#include <bacnet/bacerror.h>
+#include <bacnet/npdu.h>
+#include <bacnet/readrange.h>
+#include <bacnet/rp.h>
+#include <bacnet/wp.h>
+#include <bacnet/datalink/datalink.h>
+#include <bacnet/basic/object/diagnostic.h>
+#include <bacnet/basic/service/h_apdu.h>
+#include <bacnet/basic/tsm/tsm.h>
+
+/**
+ * @addtogroup bacnet_tests
+ * @{
+ */
+
+extern unsigned Datalink_Send_Count;
+extern uint8_t Datalink_Send_PDU[MAX_PDU];
+extern unsigned Datalink_Send_PDU_Len;
+
+static unsigned Test_Service_Count;
+
+static void test_address(BACNET_ADDRESS *address, uint8_t mac)
+{
+    memset(address, 0, sizeof(*address));
+    address->mac_len = 1;
+    address->mac[0] = mac;
+}
+
+/* a confirmed service that is not safe to run twice: each request
+   gets an ack holding a count of the requests that were run */
+static void test_service_handler(uint8_t *service_request,
+    uint16_t service_len,
+    BACNET_ADDRESS *src,
+    BACNET_CONFIRMED_SERVICE_DATA *service_data)
+{
+    BACNET_ADDRESS my_address;
+    BACNET_NPDU_DATA npdu_data;
+    int pdu_len;
+
+    (void)service_request;
+    (void)service_len;
+    Test_Service_Count++;
+    datalink_get_my_address(&my_address);
+    npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
+    pdu_len = npdu_encode_pdu(
+        &Handler_Transmit_Buffer[0], src, &my_address, &npdu_data);
+    if (service_data->invoke_id & 1) {
+        pdu_len += bacerror_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+            service_data->invoke_id, SERVICE_CONFIRMED_WRITE_PROPERTY,
+            ERROR_CLASS_PROPERTY, ERROR_CODE_WRITE_ACCESS_DENIED);
+    } else {
+        pdu_len += encode_simple_ack(&Handler_Transmit_Buffer[pdu_len],
+            service_data->invoke_id, SERVICE_CONFIRMED_WRITE_PROPERTY);
+        /* the count makes each ack different */
+        Handler_Transmit_Buffer[pdu_len++] = (uint8_t)Test_Service_Count;
+    }
+    (void)apdu_send_reply(src, &npdu_data, &Handler_Transmit_Buffer[0],
+        (unsigned)pdu_len);
+}
+
+/**
+ * Encodes a WriteProperty request
+ *
+ * @param request - buffer for the request
+ * @param invoke_id - invoke ID of the request
+ * @param priority - priority written, which makes requests different
+ * @return number of bytes encoded
+ */
+static int test_wp_request(
+    uint8_t *request, uint8_t invoke_id, uint8_t priority)
+{
+    BACNET_WRITE_PROPERTY_DATA wp_data = { 0 };
+
+    wp_data.object_type = OBJECT_ANALOG_OUTPUT;
+    wp_data.object_instance = 1;
+    wp_data.object_property = PROP_PRESENT_VALUE;
+    wp_data.array_index = BACNET_ARRAY_ALL;
+    wp_data.priority = priority;
+    wp_data.application_data_len =
+        encode_application_real(wp_data.application_data, 1.0f);
+
+    return wp_encode_apdu(request, invoke_id, &wp_data);
+}
+
+/**
+ * @brief Unit Test for the replies kept for retransmitted requests
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(h_apdu_tests, testReplyCache)
+#else
+static void testReplyCache(void)
+#endif
+{
+    BACNET_ADDRESS address_a, address_b;
+    uint8_t request[MAX_APDU];
+    uint8_t reply[MAX_PDU];
+    uint32_t lifetime;
+    unsigned reply_len;
+    unsigned sent;
+    int len;
+
+    test_address(&address_a, 10);
+    test_address(&address_b, 20);
+    apdu_set_confirmed_handler(
+        SERVICE_CONFIRMED_WRITE_PROPERTY, test_service_handler);
+    lifetime = (uint32_t)apdu_timeout() * (apdu_retries() + 1UL);
+    len = test_wp_request(request, 2, 8);
+    zassert_true(len > 0, NULL);
+    /* the first request runs the service */
+    Test_Service_Count = 0;
+    apdu_reply_cache_timer(0);
+    sent = Datalink_Send_Count;
+    apdu_handler(&address_a, request, (uint16_t)len);
+    zassert_equal(Test_Service_Count, 1, NULL);
+    zassert_equal(Datalink_Send_Count - sent, 1, NULL);
+    reply_len = Datalink_Send_PDU_Len;
+    memcpy(reply, Datalink_Send_PDU, reply_len);
+    /* a copy of it, while the client may retry, gets the same reply */
+    apdu_reply_cache_timer(apdu_timeout());
+    apdu_handler(&address_a, request, (uint16_t)len);
+    zassert_equal(Test_Service_Count, 1, NULL);
+    zassert_equal(Datalink_Send_Count - sent, 2, NULL);
+    zassert_equal(Datalink_Send_PDU_Len, reply_len, NULL);
+    zassert_mem_equal(Datalink_Send_PDU, reply, reply_len, NULL);
+    /* the same request from another client runs the service */
+    apdu_handler(&address_b, request, (uint16_t)len);
+    zassert_equal(Test_Service_Count, 2, NULL);
+    /* the copies do not keep the reply any longer */
+    apdu_reply_cache_timer((uint16_t)(lifetime - apdu_timeout() - 1));
+    apdu_handler(&address_a, request, (uint16_t)len);
+    zassert_equal(Test_Service_Count, 2, NULL);
+    zassert_mem_equal(Datalink_Send_PDU, reply, reply_len, NULL);
+    apdu_reply_cache_timer(1);
+    apdu_handler(&address_a, request, (uint16_t)len);
+    zassert_equal(Test_Service_Count, 3, NULL);
+    /* another request with the same invoke ID runs the service, and
+       the reply to the earlier request is dropped */
+    len = test_wp_request(request, 2, 9);
+    apdu_handler(&address_a, request, (uint16_t)len);
+    zassert_equal(Test_Service_Count, 4, NULL);
+    len = test_wp_request(request, 2, 8);
+    apdu_handler(&address_a, request, (uint16_t)len);
+    zassert_equal(Test_Service_Count, 5, NULL);
+    /* errors are not kept: the service may succeed when run again */
+    len = test_wp_request(request, 3, 8);
+    apdu_handler(&address_a, request, (uint16_t)len);
+    apdu_handler(&address_a, request, (uint16_t)len);
+    zassert_equal(Test_Service_Count, 7, NULL);
+    apdu_set_confirmed_handler(SERVICE_CONFIRMED_WRITE_PROPERTY, NULL);
+}
+
+/**
+ * @brief Unit Test for the services whose replies are not kept
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(h_apdu_tests, testReplyCacheRead)
+#else
+static void testReplyCacheRead(void)
+#endif
+{
+    BACNET_ADDRESS address;
+    BACNET_READ_PROPERTY_DATA rp_data = { 0 };
+    uint8_t request[MAX_APDU];
+    int len;
+
+    test_address(&address, 30);
+    apdu_set_confirmed_handler(
+        SERVICE_CONFIRMED_READ_PROPERTY, test_service_handler);
+    rp_data.object_type = OBJECT_ANALOG_INPUT;
+    rp_data.object_instance = 1;
+    rp_data.object_property = PROP_PRESENT_VALUE;
+    rp_data.array_index = BACNET_ARRAY_ALL;
+    len = rp_encode_apdu(request, 4, &rp_data);
+    zassert_true(len > 0, NULL);
+    /* a client that polls with the same invoke ID reads each time */
+    Test_Service_Count = 0;
+    apdu_reply_cache_timer(0);
+    apdu_handler(&address, request, (uint16_t)len);
+    apdu_handler(&address, request, (uint16_t)len);
+    apdu_handler(&address, request, (uint16_t)len);
+    zassert_equal(Test_Service_Count, 3, NULL);
+    apdu_set_confirmed_handler(SERVICE_CONFIRMED_READ_PROPERTY, NULL);
+}
+
+/**
+ * @brief Unit Test for the limits of confirmed requests
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(h_apdu_tests, testAdmission)
+#else
+static void testAdmission(void)
+#endif
+{
+    BACNET_ADDRESS address_a, address_b;
+    BACNET_NPDU_DATA npdu_data = { 0 };
+    BACNET_WRITE_PROPERTY_DATA wp_data = { 0 };
+    uint8_t request[MAX_APDU];
+    uint32_t admitted = 0, aborted = 0, dropped = 0;
+    uint32_t admitted_start = 0, aborted_start = 0, dropped_start = 0;
+    uint8_t invoke_id = 100;
+    unsigned sent;
+    int len;
+
+    test_address(&address_a, 10);
+    test_address(&address_b, 20);
+    apdu_set_confirmed_handler(
+        SERVICE_CONFIRMED_WRITE_PROPERTY, test_service_handler);
+    wp_data.object_type = OBJECT_ANALOG_OUTPUT;
+    wp_data.object_instance = 2;
+    wp_data.object_property = PROP_PRESENT_VALUE;
+    wp_data.array_index = BACNET_ARRAY_ALL;
+    wp_data.priority = 8;
+    wp_data.application_data_len =
+        encode_application_real(wp_data.application_data, 2.0f);
+    apdu_admission_counters(&admitted_start, &aborted_start, &dropped_start);
+    apdu_source_limit_set(2, 0);
+    apdu_request_limit_set(3);
+    Test_Service_Count = 0;
+    /* each source may send its burst of requests */
+    len = wp_encode_apdu(request, invoke_id, &wp_data);
+    apdu_handler(&address_a, request, (uint16_t)len);
+    invoke_id += 2;
+    len = wp_encode_apdu(request, invoke_id, &wp_data);
+    apdu_handler(&address_a, request, (uint16_t)len);
+    zassert_equal(Test_Service_Count, 2, NULL);
+    /* a request over the limit of its source is aborted */
+    invoke_id += 2;
+    len = wp_encode_apdu(request, invoke_id, &wp_data);
+    sent = Datalink_Send_Count;
+    apdu_handler(&address_a, request, (uint16_t)len);
+    zassert_equal(Test_Service_Count, 2, NULL);
+    zassert_equal(Datalink_Send_Count - sent, 1, NULL);
+    len = bacnet_npdu_decode(Datalink_Send_PDU,
+        (uint16_t)Datalink_Send_PDU_Len, NULL, NULL, &npdu_data);
+    zassert_true(len > 0, NULL);
+    zassert_equal(Datalink_Send_PDU[len], PDU_TYPE_ABORT | 1, NULL);
+    zassert_equal(Datalink_Send_PDU[len + 1], invoke_id, NULL);
+    zassert_equal(
+        Datalink_Send_PDU[len + 2], ABORT_REASON_OUT_OF_RESOURCES, NULL);
+    /* a request over the limit of all sources is dropped */
+    invoke_id += 2;
+    len = wp_encode_apdu(request, invoke_id, &wp_data);
+    apdu_handler(&address_b, request, (uint16_t)len);
+    zassert_equal(Test_Service_Count, 3, NULL);
+    invoke_id += 2;
+    len = wp_encode_apdu(request, invoke_id, &wp_data);
+    sent = Datalink_Send_Count;
+    apdu_handler(&address_b, request, (uint16_t)len);
+    zassert_equal(Test_Service_Count, 3, NULL);
+    zassert_equal(Datalink_Send_Count - sent, 0, NULL);
+    apdu_admission_counters(&admitted, &aborted, &dropped);
+    zassert_equal(admitted - admitted_start, 3, NULL);
+    zassert_equal(aborted - aborted_start, 1, NULL);
+    zassert_equal(dropped - dropped_start, 1, NULL);
+    /* the buckets refill at their rates */
+    apdu_admission_timer(500);
+    invoke_id += 2;
+    len = wp_encode_apdu(request, invoke_id, &wp_data);
+    apdu_handler(&address_a, request, (uint16_t)len);
+    zassert_equal(Test_Service_Count, 4, NULL);
+    invoke_id += 2;
+    len = wp_encode_apdu(request, invoke_id, &wp_data);
+    apdu_handler(&address_a, request, (uint16_t)len);
+    zassert_equal(Test_Service_Count, 4, NULL);
+    /* without limits, every request is run */
+    apdu_source_limit_set(0, 0);
+    apdu_request_limit_set(0);
+    invoke_id += 2;
+    len = wp_encode_apdu(request, invoke_id, &wp_data);
+    apdu_handler(&address_a, request, (uint16_t)len);
+    zassert_equal(Test_Service_Count, 5, NULL);
+    apdu_set_confirmed_handler(SERVICE_CONFIRMED_WRITE_PROPERTY, NULL);
+}
+
+/**
+ * Reads an unsigned property of the Diagnostic object
+ *
+ * @param object_property - property to read
+ * @return value of the property
+ */
+static uint32_t test_diagnostic_read(BACNET_PROPERTY_ID object_property)
+{
+    BACNET_READ_PROPERTY_DATA rpdata = { 0 };
+    BACNET_APPLICATION_DATA_VALUE value = { 0 };
+    uint8_t apdu[MAX_APDU];
+    int len;
+
+    rpdata.object_type = OBJECT_DIAGNOSTIC;
+    rpdata.object_instance = Diagnostic_Index_To_Instance(0);
+    rpdata.object_property = object_property;
+    rpdata.array_index = BACNET_ARRAY_ALL;
+    rpdata.application_data = apdu;
+    rpdata.application_data_len = sizeof(apdu);
+    len = Diagnostic_Read_Property(&rpdata);
+    zassert_true(len > 0, NULL);
+    len = bacapp_decode_application_data(apdu, (unsigned)len, &value);
+    zassert_true(len > 0, NULL);
+    zassert_equal(value.tag, BACNET_APPLICATION_TAG_UNSIGNED_INT, NULL);
+
+    return (uint32_t)value.type.Unsigned_Int;
+}
+
+/**
+ * @brief Unit Test for the Diagnostic object properties that count
+ *  the admitted, aborted and dropped requests
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(h_apdu_tests, testAdmissionDiagnostic)
+#else
+static void testAdmissionDiagnostic(void)
+#endif
+{
+    BACNET_ADDRESS address_a, address_b;
+    uint8_t request[MAX_APDU];
+    uint32_t admitted, aborted, dropped;
+    int len;
+
+    test_address(&address_a, 50);
+    test_address(&address_b, 60);
+    apdu_set_confirmed_handler(
+        SERVICE_CONFIRMED_WRITE_PROPERTY, test_service_handler);
+    apdu_admission_counters(&admitted, &aborted, &dropped);
+    zassert_equal(
+        test_diagnostic_read(PROP_DIAGNOSTIC_REQUESTS_ADMITTED), admitted,
+        NULL);
+    zassert_equal(
+        test_diagnostic_read(PROP_DIAGNOSTIC_REQUESTS_ABORTED), aborted, NULL);
+    zassert_equal(
+        test_diagnostic_read(PROP_DIAGNOSTIC_REQUESTS_DROPPED), dropped, NULL);
+    /* one request of each source, and two of all sources, at once */
+    apdu_source_limit_set(1, 0);
+    apdu_request_limit_set(2);
+    len = test_wp_request(request, 20, 8);
+    apdu_handler(&address_a, request, (uint16_t)len);
+    len = test_wp_request(request, 22, 8);
+    apdu_handler(&address_a, request, (uint16_t)len);
+    len = test_wp_request(request, 24, 8);
+    apdu_handler(&address_b, request, (uint16_t)len);
+    len = test_wp_request(request, 26, 8);
+    apdu_handler(&address_b, request, (uint16_t)len);
+    zassert_equal(test_diagnostic_read(PROP_DIAGNOSTIC_REQUESTS_ADMITTED),
+        admitted + 2, NULL);
+    zassert_equal(test_diagnostic_read(PROP_DIAGNOSTIC_REQUESTS_ABORTED),
+        aborted + 1, NULL);
+    zassert_equal(test_diagnostic_read(PROP_DIAGNOSTIC_REQUESTS_DROPPED),
+        dropped + 1, NULL);
+    apdu_source_limit_set(0, 0);
+    apdu_request_limit_set(0);
+    apdu_set_confirmed_handler(SERVICE_CONFIRMED_WRITE_PROPERTY, NULL);
+}
+/**
+ * @}
+ */
+
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST_SUITE(h_apdu_tests, NULL, NULL, NULL, NULL, NULL);
+#else
+void test_main(void)
+{
+    ztest_test_suite(h_apdu_tests,
+     ztest_unit_test(testReplyCache),
+     ztest_unit_test(testReplyCacheRead),
+     ztest_unit_test(testAdmission),
+     ztest_unit_test(testAdmissionDiagnostic)
+     );
+
+    ztest_run_test_suite(h_apdu_tests);
+}
+#endif
@@ -0,0 +1,378 @@
+/*
+ * SPDX-License-Identifier: MIT
+ */
+
+/* @file
+ * @brief test the COV handler: SubscribeCOVProperty subscriptions and
+ *  their notifications
+ */
+
+#include <zephyr/ztest.h>
+#include <bacnet/apdu.h>
+#include <bacnet/bacapp.h>
+#include <bacnet/bacdcode.h>
+#include <bacnet/bacerror.h>
+#include <bacnet/cov.h>
+#include <bacnet/npdu.h>
+#include <bacnet/basic/service/h_cov.h>
+
+/**
+ * @addtogroup bacnet_tests
+ * @{
+ */
+
+extern unsigned Datalink_Send_Count;
+extern uint8_t Datalink_Send_PDU[MAX_PDU];
+extern unsigned Datalink_Send_PDU_Len;
+
+extern float Test_Present_Value;
+extern float Test_COV_Increment;
+extern bool Test_In_Alarm;
+extern bool Test_Out_Of_Service;
+extern bool Test_Object_Readable;
+
+static uint8_t Test_Invoke_ID;
+
+static void test_address(BACNET_ADDRESS *address, uint8_t mac)
+{
+    memset(address, 0, sizeof(*address));
+    address->mac_len = 1;
+    address->mac[0] = mac;
+}
+
+/**
+ * Gets the APDU of the last PDU sent
+ *
+ * @param apdu_len - filled with the length of the APDU
+ * @return the APDU
+ */
+static uint8_t *test_sent_apdu(unsigned *apdu_len)
+{
+    BACNET_ADDRESS dest, src;
+    BACNET_NPDU_DATA npdu_data;
+    int len;
+
+    len = bacnet_npdu_decode(&Datalink_Send_PDU[0],
+        (uint16_t)Datalink_Send_PDU_Len, &dest, &src, &npdu_data);
+    zassert_true(len > 0, NULL);
+    *apdu_len = Datalink_Send_PDU_Len - (unsigned)len;
+
+    return &Datalink_Send_PDU[len];
+}
+
+/**
+ * Sends a SubscribeCOVProperty request to the handler, for the
+ * Analog Input of the stubs
+ *
+ * @param pid - subscriber process identifier
+ * @param property - monitored property
+ * @param array_index - array index of the monitored property
+ * @param increment - COV increment, or a negative value if none
+ * @param cancel - true for a cancellation
+ * @param error_code - filled with the error code of an Error reply
+ * @return the PDU type of the reply
+ */
+static uint8_t test_subscribe(uint32_t pid,
+    BACNET_PROPERTY_ID property,
+    BACNET_ARRAY_INDEX array_index,
+    float increment,
+    bool cancel,
+    BACNET_ERROR_CODE *error_code)
+{
+    BACNET_SUBSCRIBE_COV_DATA cov_data = { 0 };
+    BACNET_CONFIRMED_SERVICE_DATA service_data = { 0 };
+    BACNET_ADDRESS src;
+    uint8_t request[MAX_APDU];
+    uint8_t *apdu;
+    unsigned apdu_len = 0;
+    int len;
+
+    test_address(&src, 20);
+    cov_data.subscriberProcessIdentifier = pid;
+    cov_data.monitoredObjectIdentifier.type = OBJECT_ANALOG_INPUT;
+    cov_data.monitoredObjectIdentifier.instance = 1;
+    cov_data.cancellationRequest = cancel;
+    cov_data.issueConfirmedNotifications = false;
+    cov_data.lifetime = 300;
+    cov_data.monitoredProperty.propertyIdentifier = property;
+    cov_data.monitoredProperty.propertyArrayIndex = array_index;
+    if (increment >= 0.0f) {
+        cov_data.covIncrementPresent = true;
+        cov_data.covIncrement = increment;
+    }
+    service_data.invoke_id = ++Test_Invoke_ID;
+    len = cov_subscribe_property_encode_apdu(
+        request, sizeof(request), service_data.invoke_id, &cov_data);
+    zassert_true(len > 4, NULL);
+    handler_cov_subscribe_property(
+        &request[4], (uint16_t)(len - 4), &src, &service_data);
+    apdu = test_sent_apdu(&apdu_len);
+    zassert_true(apdu_len > 0, NULL);
+    if ((apdu[0] == PDU_TYPE_ERROR) && error_code) {
+        len = bacerror_decode_service_request(
+            &apdu[1], apdu_len - 1, NULL, NULL, NULL, error_code);
+        zassert_true(len > 0, NULL);
+    }
+
+    return apdu[0];
+}
+
+/**
+ * Runs the COV handler through one pass of its subscriptions
+ *
+ * @return number of notifications sent
+ */
+static unsigned test_cov_pass(void)
+{
+    unsigned sent = Datalink_Send_Count;
+
+    while (!handler_cov_fsm()) {
+        /* next state */
+    }
+
+    return Datalink_Send_Count - sent;
+}
+
+/**
+ * Decodes the last notification sent
+ *
+ * @param cov_data - filled with the notification
+ * @param value_list - list of two values, filled with its values
+ */
+static void test_notification(
+    BACNET_COV_DATA *cov_data, BACNET_PROPERTY_VALUE *value_list)
+{
+    uint8_t *apdu;
+    unsigned apdu_len = 0;
+    int len;
+
+    apdu = test_sent_apdu(&apdu_len);
+    zassert_equal(apdu[0], PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST, NULL);
+    zassert_equal(apdu[1], SERVICE_UNCONFIRMED_COV_NOTIFICATION, NULL);
+    bacapp_property_value_list_init(value_list, 2);
+    cov_data->listOfValues = value_list;
+    len = cov_notify_decode_service_request(&apdu[2], apdu_len - 2, cov_data);
+    zassert_true(len > 0, NULL);
+}
+
+static void test_object_init(void)
+{
+    handler_cov_init();
+    Test_Present_Value = 10.0f;
+    Test_COV_Increment = 5.0f;
+    Test_In_Alarm = false;
+    Test_Out_Of_Service = false;
+    Test_Object_Readable = true;
+}
+
+/**
+ * @brief Unit Test for the increment of each property subscription
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(h_cov_tests, testCOVPropertyIncrement)
+#else
+static void testCOVPropertyIncrement(void)
+#endif
+{
+    BACNET_COV_DATA cov_data = { 0 };
+    BACNET_PROPERTY_VALUE value_list[2];
+    uint8_t pdu_type;
+
+    test_object_init();
+    /* one with its own increment, one with the COV_Increment */
+    pdu_type = test_subscribe(
+        1, PROP_PRESENT_VALUE, BACNET_ARRAY_ALL, 2.0f, false, NULL);
+    zassert_equal(pdu_type, PDU_TYPE_SIMPLE_ACK, NULL);
+    pdu_type = test_subscribe(
+        2, PROP_PRESENT_VALUE, BACNET_ARRAY_ALL, -1.0f, false, NULL);
+    zassert_equal(pdu_type, PDU_TYPE_SIMPLE_ACK, NULL);
+    /* a new subscription is notified at once */
+    zassert_equal(test_cov_pass(), 2, NULL);
+    test_notification(&cov_data, &value_list[0]);
+    zassert_equal(cov_data.subscriberProcessIdentifier, 2, NULL);
+    zassert_equal(cov_data.initiatingDeviceIdentifier, 1234, NULL);
+    zassert_equal(cov_data.monitoredObjectIdentifier.type,
+        OBJECT_ANALOG_INPUT, NULL);
+    zassert_equal(value_list[0].propertyIdentifier, PROP_PRESENT_VALUE, NULL);
+    zassert_equal(value_list[0].value.tag, BACNET_APPLICATION_TAG_REAL, NULL);
+    zassert_equal(value_list[0].value.type.Real, 10.0f, NULL);
+    zassert_equal(value_list[1].propertyIdentifier, PROP_STATUS_FLAGS, NULL);
+    zassert_equal(
+        value_list[1].value.tag, BACNET_APPLICATION_TAG_BIT_STRING, NULL);
+    zassert_equal(test_cov_pass(), 0, NULL);
+    /* less than either increment */
+    Test_Present_Value = 11.0f;
+    zassert_equal(test_cov_pass(), 0, NULL);
+    /* the increment of the first, from the value last notified */
+    Test_Present_Value = 12.5f;
+    zassert_equal(test_cov_pass(), 1, NULL);
+    test_notification(&cov_data, &value_list[0]);
+    zassert_equal(cov_data.subscriberProcessIdentifier, 1, NULL);
+    zassert_equal(value_list[0].value.type.Real, 12.5f, NULL);
+    Test_Present_Value = 14.0f;
+    zassert_equal(test_cov_pass(), 0, NULL);
+    /* the COV_Increment of the object, for the second */
+    Test_Present_Value = 15.5f;
+    zassert_equal(test_cov_pass(), 2, NULL);
+    /* a decrease is a change too */
+    Test_Present_Value = 13.0f;
+    zassert_equal(test_cov_pass(), 1, NULL);
+    test_notification(&cov_data, &value_list[0]);
+    zassert_equal(cov_data.subscriberProcessIdentifier, 1, NULL);
+    /* a Status_Flags change is notified whatever the increment */
+    Test_In_Alarm = true;
+    zassert_equal(test_cov_pass(), 2, NULL);
+    zassert_equal(test_cov_pass(), 0, NULL);
+}
+
+/**
+ * @brief Unit Test for the properties notified on any change
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(h_cov_tests, testCOVPropertyAnyChange)
+#else
+static void testCOVPropertyAnyChange(void)
+#endif
+{
+    BACNET_COV_DATA cov_data = { 0 };
+    BACNET_PROPERTY_VALUE value_list[2];
+    uint8_t pdu_type;
+
+    test_object_init();
+    /* a property that is not a REAL ignores the increment */
+    pdu_type = test_subscribe(
+        3, PROP_OUT_OF_SERVICE, BACNET_ARRAY_ALL, 100.0f, false, NULL);
+    zassert_equal(pdu_type, PDU_TYPE_SIMPLE_ACK, NULL);
+    zassert_equal(test_cov_pass(), 1, NULL);
+    Test_Present_Value = 1000.0f;
+    zassert_equal(test_cov_pass(), 0, NULL);
+    Test_Out_Of_Service = true;
+    zassert_equal(test_cov_pass(), 1, NULL);
+    test_notification(&cov_data, &value_list[0]);
+    zassert_equal(cov_data.subscriberProcessIdentifier, 3, NULL);
+    zassert_equal(value_list[0].propertyIdentifier, PROP_OUT_OF_SERVICE, NULL);
+    zassert_equal(
+        value_list[0].value.tag, BACNET_APPLICATION_TAG_BOOLEAN, NULL);
+    zassert_true(value_list[0].value.type.Boolean, NULL);
+    /* a REAL without any increment is notified on any change */
+    Test_COV_Increment = 0.0f;
+    pdu_type = test_subscribe(
+        4, PROP_PRESENT_VALUE, BACNET_ARRAY_ALL, -1.0f, false, NULL);
+    zassert_equal(pdu_type, PDU_TYPE_SIMPLE_ACK, NULL);
+    zassert_equal(test_cov_pass(), 1, NULL);
+    Test_Present_Value = 1000.25f;
+    zassert_equal(test_cov_pass(), 1, NULL);
+    test_notification(&cov_data, &value_list[0]);
+    zassert_equal(cov_data.subscriberProcessIdentifier, 4, NULL);
+    zassert_equal(value_list[0].value.type.Real, 1000.25f, NULL);
+}
+
+/**
+ * @brief Unit Test for cancellations, which match the property and
+ *  array index of the subscription
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(h_cov_tests, testCOVPropertyCancel)
+#else
+static void testCOVPropertyCancel(void)
+#endif
+{
+    BACNET_COV_DATA cov_data = { 0 };
+    BACNET_PROPERTY_VALUE value_list[2];
+    uint8_t pdu_type;
+
+    test_object_init();
+    /* one process subscribes to two properties */
+    pdu_type = test_subscribe(
+        5, PROP_PRESENT_VALUE, BACNET_ARRAY_ALL, 1.0f, false, NULL);
+    zassert_equal(pdu_type, PDU_TYPE_SIMPLE_ACK, NULL);
+    pdu_type = test_subscribe(
+        5, PROP_OUT_OF_SERVICE, BACNET_ARRAY_ALL, -1.0f, false, NULL);
+    zassert_equal(pdu_type, PDU_TYPE_SIMPLE_ACK, NULL);
+    zassert_equal(test_cov_pass(), 2, NULL);
+    /* subscribing again renews the subscription */
+    pdu_type = test_subscribe(
+        5, PROP_PRESENT_VALUE, BACNET_ARRAY_ALL, 1.0f, false, NULL);
+    zassert_equal(pdu_type, PDU_TYPE_SIMPLE_ACK, NULL);
+    zassert_equal(test_cov_pass(), 1, NULL);
+    /* a cancellation of another array index succeeds, and cancels none */
+    pdu_type = test_subscribe(5, PROP_PRESENT_VALUE, 1, -1.0f, true, NULL);
+    zassert_equal(pdu_type, PDU_TYPE_SIMPLE_ACK, NULL);
+    Test_In_Alarm = true;
+    zassert_equal(test_cov_pass(), 2, NULL);
+    /* a cancellation of one property leaves the other */
+    pdu_type = test_subscribe(
+        5, PROP_OUT_OF_SERVICE, BACNET_ARRAY_ALL, -1.0f, true, NULL);
+    zassert_equal(pdu_type, PDU_TYPE_SIMPLE_ACK, NULL);
+    Test_In_Alarm = false;
+    zassert_equal(test_cov_pass(), 1, NULL);
+    test_notification(&cov_data, &value_list[0]);
+    zassert_equal(value_list[0].propertyIdentifier, PROP_PRESENT_VALUE, NULL);
+    pdu_type = test_subscribe(
+        5, PROP_PRESENT_VALUE, BACNET_ARRAY_ALL, -1.0f, true, NULL);
+    zassert_equal(pdu_type, PDU_TYPE_SIMPLE_ACK, NULL);
+    Test_In_Alarm = true;
+    zassert_equal(test_cov_pass(), 0, NULL);
+}
+
+/**
+ * @brief Unit Test for the errors of subscriptions to properties that
+ *  cannot be read, and for properties that can no longer be read
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(h_cov_tests, testCOVPropertyUnreadable)
+#else
+static void testCOVPropertyUnreadable(void)
+#endif
+{
+    BACNET_ERROR_CODE error_code = ERROR_CODE_SUCCESS;
+    uint8_t apdu[MAX_APDU];
+    uint8_t pdu_type;
+
+    test_object_init();
+    /* the subscription gets the error of reading the property */
+    pdu_type = test_subscribe(
+        6, PROP_DESCRIPTION, BACNET_ARRAY_ALL, -1.0f, false, &error_code);
+    zassert_equal(pdu_type, PDU_TYPE_ERROR, NULL);
+    zassert_equal(error_code, ERROR_CODE_UNKNOWN_PROPERTY, NULL);
+    pdu_type =
+        test_subscribe(6, PROP_PRESENT_VALUE, 1, -1.0f, false, &error_code);
+    zassert_equal(pdu_type, PDU_TYPE_ERROR, NULL);
+    zassert_equal(error_code, ERROR_CODE_PROPERTY_IS_NOT_AN_ARRAY, NULL);
+    zassert_equal(test_cov_pass(), 0, NULL);
+    zassert_equal(handler_cov_encode_subscriptions(apdu, sizeof(apdu)), 0,
+        NULL);
+    /* a property that can no longer be read ends its subscription */
+    pdu_type = test_subscribe(
+        6, PROP_PRESENT_VALUE, BACNET_ARRAY_ALL, -1.0f, false, NULL);
+    zassert_equal(pdu_type, PDU_TYPE_SIMPLE_ACK, NULL);
+    zassert_equal(test_cov_pass(), 1, NULL);
+    zassert_true(handler_cov_encode_subscriptions(apdu, sizeof(apdu)) > 0,
+        NULL);
+    Test_Object_Readable = false;
+    zassert_equal(test_cov_pass(), 0, NULL);
+    zassert_equal(handler_cov_encode_subscriptions(apdu, sizeof(apdu)), 0,
+        NULL);
+    Test_Object_Readable = true;
+    Test_Present_Value = 100.0f;
+    zassert_equal(test_cov_pass(), 0, NULL);
+}
+/**
+ * @}
+ */
+
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST_SUITE(h_cov_tests, NULL, NULL, NULL, NULL, NULL);
+#else
+void test_main(void)
+{
+    ztest_test_suite(h_cov_tests,
+     ztest_unit_test(testCOVPropertyIncrement),
+     ztest_unit_test(testCOVPropertyAnyChange),
+     ztest_unit_test(testCOVPropertyCancel),
+     ztest_unit_test(testCOVPropertyUnreadable)
+     );
+
+    ztest_run_test_suite(h_cov_tests);
+}
+#endif
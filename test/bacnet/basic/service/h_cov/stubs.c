@@ -0,0 +1,144 @@
+/*
+ * SPDX-License-Identifier: MIT
+ */
+
+/* @file
+ * @brief stubs for the datalink and the device used by the COV handler:
+ *  one Analog Input object whose properties the tests change
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "bacnet/bacdef.h"
+#include "bacnet/bacdcode.h"
+#include "bacnet/npdu.h"
+#include "bacnet/rp.h"
+#include "bacnet/datalink/datalink.h"
+#include "bacnet/basic/object/device.h"
+
+unsigned Datalink_Send_Count;
+uint8_t Datalink_Send_PDU[MAX_PDU];
+unsigned Datalink_Send_PDU_Len;
+
+/* the Analog Input object */
+float Test_Present_Value;
+float Test_COV_Increment;
+bool Test_In_Alarm;
+bool Test_Out_Of_Service;
+bool Test_Object_Readable = true;
+
+int datalink_send_pdu(BACNET_ADDRESS *dest,
+    BACNET_NPDU_DATA *npdu_data,
+    uint8_t *pdu,
+    unsigned pdu_len)
+{
+    unsigned i;
+
+    (void)dest;
+    (void)npdu_data;
+    Datalink_Send_Count++;
+    Datalink_Send_PDU_Len = 0;
+    for (i = 0; (i < pdu_len) && (i < MAX_PDU); i++) {
+        Datalink_Send_PDU[i] = pdu[i];
+        Datalink_Send_PDU_Len++;
+    }
+
+    return (int)pdu_len;
+}
+
+void datalink_get_my_address(BACNET_ADDRESS *my_address)
+{
+    unsigned i;
+
+    my_address->mac_len = 1;
+    my_address->mac[0] = 1;
+    my_address->net = 0;
+    my_address->len = 0;
+    for (i = 0; i < MAX_MAC_LEN; i++) {
+        my_address->adr[i] = 0;
+    }
+}
+
+uint32_t Device_Object_Instance_Number(void)
+{
+    return 1234;
+}
+
+bool Device_Valid_Object_Id(
+    BACNET_OBJECT_TYPE object_type, uint32_t object_instance)
+{
+    return (object_type == OBJECT_ANALOG_INPUT) &&
+        (object_instance == 1);
+}
+
+bool Device_Value_List_Supported(BACNET_OBJECT_TYPE object_type)
+{
+    return (object_type == OBJECT_ANALOG_INPUT);
+}
+
+bool Device_Encode_Value_List(BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    BACNET_PROPERTY_VALUE *value_list)
+{
+    (void)object_type;
+    (void)object_instance;
+    (void)value_list;
+
+    return false;
+}
+
+bool Device_COV(BACNET_OBJECT_TYPE object_type, uint32_t object_instance)
+{
+    (void)object_type;
+    (void)object_instance;
+
+    return false;
+}
+
+void Device_COV_Clear(BACNET_OBJECT_TYPE object_type, uint32_t object_instance)
+{
+    (void)object_type;
+    (void)object_instance;
+}
+
+int Device_Read_Property(BACNET_READ_PROPERTY_DATA *rpdata)
+{
+    BACNET_BIT_STRING bit_string;
+    uint8_t *apdu = rpdata->application_data;
+
+    if (!Test_Object_Readable ||
+        !Device_Valid_Object_Id(
+            rpdata->object_type, rpdata->object_instance)) {
+        rpdata->error_class = ERROR_CLASS_OBJECT;
+        rpdata->error_code = ERROR_CODE_UNKNOWN_OBJECT;
+        return BACNET_STATUS_ERROR;
+    }
+    if (rpdata->array_index != BACNET_ARRAY_ALL) {
+        rpdata->error_class = ERROR_CLASS_PROPERTY;
+        rpdata->error_code = ERROR_CODE_PROPERTY_IS_NOT_AN_ARRAY;
+        return BACNET_STATUS_ERROR;
+    }
+    switch (rpdata->object_property) {
+        case PROP_PRESENT_VALUE:
+            return encode_application_real(apdu, Test_Present_Value);
+        case PROP_COV_INCREMENT:
+            return encode_application_real(apdu, Test_COV_Increment);
+        case PROP_OUT_OF_SERVICE:
+            return encode_application_boolean(apdu, Test_Out_Of_Service);
+        case PROP_STATUS_FLAGS:
+            bitstring_init(&bit_string);
+            bitstring_set_bit(
+                &bit_string, STATUS_FLAG_IN_ALARM, Test_In_Alarm);
+            bitstring_set_bit(&bit_string, STATUS_FLAG_FAULT, false);
+            bitstring_set_bit(&bit_string, STATUS_FLAG_OVERRIDDEN, false);
+            bitstring_set_bit(
+                &bit_string, STATUS_FLAG_OUT_OF_SERVICE, Test_Out_Of_Service);
+            return encode_application_bitstring(apdu, &bit_string);
+        default:
+            break;
+    }
+    rpdata->error_class = ERROR_CLASS_PROPERTY;
+    rpdata->error_code = ERROR_CODE_UNKNOWN_PROPERTY;
+
+    return BACNET_STATUS_ERROR;
+}
@@ -0,0 +1,325 @@
+/*
+ * SPDX-License-Identifier: MIT
+ */
+
+/* @file
+ * @brief test the clock offset and drift estimates of the
+ *  TimeSynchronization recipients
+ */
+
+#include <zephyr/ztest.h>
+#include <bacnet/apdu.h>
+#include <bacnet/bacdcode.h>
+#include <bacnet/datetime.h>
+#include <bacnet/npdu.h>
+#include <bacnet/rp.h>
+#include <bacnet/basic/service/h_apdu.h>
+#include <bacnet/basic/service/h_ts.h>
+#include <bacnet/basic/tsm/tsm.h>
+
+/**
+ * @addtogroup bacnet_tests
+ * @{
+ */
+
+extern unsigned Datalink_Send_Count;
+extern uint8_t Datalink_Send_PDU[MAX_PDU];
+extern unsigned Datalink_Send_PDU_Len;
+extern BACNET_DATE_TIME Test_Local_Time;
+extern uint32_t Test_Time_Sync_Interval;
+extern unsigned Test_TimeSync_Count;
+extern BACNET_ADDRESS Test_TimeSync_Dest;
+
+static void test_address(BACNET_ADDRESS *address, uint8_t mac)
+{
+    memset(address, 0, sizeof(*address));
+    address->mac_len = 1;
+    address->mac[0] = mac;
+}
+
+/**
+ * @brief Unit Test for the clock offset of a recipient
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(h_ts_tests, testTimeSyncOffset)
+#else
+static void testTimeSyncOffset(void)
+#endif
+{
+    BACNET_ADDRESS src;
+    BACNET_DATE_TIME local_time;
+    BACNET_TIME remote_time;
+    int32_t offset_ms = 0;
+    int32_t drift_ms_per_hour = 0;
+
+    handler_timesync_init();
+    test_address(&src, 10);
+    zassert_true(handler_timesync_recipient_address_set(0, &src), NULL);
+    zassert_false(
+        handler_timesync_drift(0, &offset_ms, &drift_ms_per_hour), NULL);
+    /* the remote clock is ahead, to the hundredth */
+    datetime_set_values(&local_time, 2015, 6, 1, 12, 0, 0, 0);
+    datetime_set_time(&remote_time, 12, 0, 1, 50);
+    zassert_true(
+        handler_timesync_drift_sample(&src, &remote_time, &local_time), NULL);
+    zassert_true(
+        handler_timesync_drift(0, &offset_ms, &drift_ms_per_hour), NULL);
+    zassert_equal(offset_ms, 1500, NULL);
+    zassert_equal(drift_ms_per_hour, 0, NULL);
+    /* and behind */
+    datetime_set_time(&remote_time, 11, 59, 58, 75);
+    zassert_true(
+        handler_timesync_drift_sample(&src, &remote_time, &local_time), NULL);
+    zassert_true(handler_timesync_drift(0, &offset_ms, NULL), NULL);
+    zassert_equal(offset_ms, -1250, NULL);
+    /* Local_Time has no date: the shortest way around midnight */
+    handler_timesync_recipient_address_set(0, &src);
+    datetime_set_values(&local_time, 2015, 6, 1, 23, 59, 59, 90);
+    datetime_set_time(&remote_time, 0, 0, 0, 10);
+    zassert_true(
+        handler_timesync_drift_sample(&src, &remote_time, &local_time), NULL);
+    zassert_true(handler_timesync_drift(0, &offset_ms, NULL), NULL);
+    zassert_equal(offset_ms, 200, NULL);
+    handler_timesync_recipient_address_set(0, &src);
+    datetime_set_values(&local_time, 2015, 6, 2, 0, 0, 0, 10);
+    datetime_set_time(&remote_time, 23, 59, 59, 90);
+    zassert_true(
+        handler_timesync_drift_sample(&src, &remote_time, &local_time), NULL);
+    zassert_true(handler_timesync_drift(0, &offset_ms, NULL), NULL);
+    zassert_equal(offset_ms, -200, NULL);
+    /* not a recipient, or not a time */
+    test_address(&src, 11);
+    zassert_false(
+        handler_timesync_drift_sample(&src, &remote_time, &local_time), NULL);
+    test_address(&src, 10);
+    remote_time.hour = 24;
+    zassert_false(
+        handler_timesync_drift_sample(&src, &remote_time, &local_time), NULL);
+    zassert_false(handler_timesync_drift(1, &offset_ms, NULL), NULL);
+}
+
+/**
+ * @brief Unit Test for the drift rate of a recipient, estimated from
+ *  consecutive offsets and smoothed
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(h_ts_tests, testTimeSyncDrift)
+#else
+static void testTimeSyncDrift(void)
+#endif
+{
+    BACNET_ADDRESS src;
+    BACNET_DATE_TIME local_time;
+    BACNET_TIME remote_time;
+    int32_t offset_ms = 0;
+    int32_t drift_ms_per_hour = 0;
+
+    handler_timesync_init();
+    test_address(&src, 10);
+    handler_timesync_recipient_address_set(0, &src);
+    /* one sample gives no rate */
+    datetime_set_values(&local_time, 2015, 6, 1, 12, 0, 0, 0);
+    datetime_set_time(&remote_time, 12, 0, 0, 0);
+    zassert_true(
+        handler_timesync_drift_sample(&src, &remote_time, &local_time), NULL);
+    handler_timesync_drift(0, &offset_ms, &drift_ms_per_hour);
+    zassert_equal(offset_ms, 0, NULL);
+    zassert_equal(drift_ms_per_hour, 0, NULL);
+    /* the second gives the rate between them */
+    datetime_set_values(&local_time, 2015, 6, 1, 13, 0, 0, 0);
+    datetime_set_time(&remote_time, 13, 0, 0, 36);
+    zassert_true(
+        handler_timesync_drift_sample(&src, &remote_time, &local_time), NULL);
+    handler_timesync_drift(0, &offset_ms, &drift_ms_per_hour);
+    zassert_equal(offset_ms, 360, NULL);
+    zassert_equal(drift_ms_per_hour, 360, NULL);
+    /* over half an hour, in milliseconds per hour */
+    datetime_set_values(&local_time, 2015, 6, 1, 13, 30, 0, 0);
+    datetime_set_time(&remote_time, 13, 30, 0, 54);
+    zassert_true(
+        handler_timesync_drift_sample(&src, &remote_time, &local_time), NULL);
+    handler_timesync_drift(0, &offset_ms, &drift_ms_per_hour);
+    zassert_equal(offset_ms, 540, NULL);
+    zassert_equal(drift_ms_per_hour, 360, NULL);
+    /* a new rate moves the estimate a quarter of the way */
+    datetime_set_values(&local_time, 2015, 6, 1, 14, 30, 0, 0);
+    datetime_set_time(&remote_time, 14, 30, 1, 30);
+    zassert_true(
+        handler_timesync_drift_sample(&src, &remote_time, &local_time), NULL);
+    handler_timesync_drift(0, &offset_ms, &drift_ms_per_hour);
+    zassert_equal(offset_ms, 1300, NULL);
+    zassert_equal(drift_ms_per_hour, 360 + (760 - 360) / 4, NULL);
+    /* a clock that loses time */
+    handler_timesync_recipient_address_set(0, &src);
+    datetime_set_values(&local_time, 2015, 6, 1, 12, 0, 0, 0);
+    datetime_set_time(&remote_time, 12, 0, 0, 0);
+    handler_timesync_drift_sample(&src, &remote_time, &local_time);
+    datetime_set_values(&local_time, 2015, 6, 1, 14, 0, 0, 0);
+    datetime_set_time(&remote_time, 13, 59, 59, 0);
+    handler_timesync_drift_sample(&src, &remote_time, &local_time);
+    handler_timesync_drift(0, &offset_ms, &drift_ms_per_hour);
+    zassert_equal(offset_ms, -1000, NULL);
+    zassert_equal(drift_ms_per_hour, -500, NULL);
+    /* a sample at the same time gives no rate */
+    datetime_set_time(&remote_time, 13, 59, 58, 0);
+    handler_timesync_drift_sample(&src, &remote_time, &local_time);
+    handler_timesync_drift(0, &offset_ms, &drift_ms_per_hour);
+    zassert_equal(offset_ms, -2000, NULL);
+    zassert_equal(drift_ms_per_hour, -500, NULL);
+}
+
+/**
+ * Sends the ReadProperty-ACK of a Local_Time request
+ *
+ * @param src - address of the recipient that answers
+ * @param invoke_id - invoke ID of the request
+ * @param remote_time - Local_Time of the recipient
+ */
+static void test_local_time_ack(
+    BACNET_ADDRESS *src, uint8_t invoke_id, BACNET_TIME *remote_time)
+{
+    BACNET_READ_PROPERTY_DATA data = { 0 };
+    uint8_t value[16] = { 0 };
+    uint8_t apdu[MAX_APDU] = { 0 };
+    int len;
+
+    data.object_type = OBJECT_DEVICE;
+    data.object_instance = 1234;
+    data.object_property = PROP_LOCAL_TIME;
+    data.array_index = BACNET_ARRAY_ALL;
+    data.application_data = value;
+    data.application_data_len = encode_application_time(value, remote_time);
+    len = rp_ack_encode_apdu(apdu, invoke_id, &data);
+    zassert_true(len > 0, NULL);
+    apdu_handler(src, apdu, (uint16_t)len);
+}
+
+/**
+ * @brief Unit Test for the Local_Time reads: the ACK completes the
+ *  request that was sent, and no other ReadProperty-ACK is a sample
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(h_ts_tests, testTimeSyncLocalTimeRequest)
+#else
+static void testTimeSyncLocalTimeRequest(void)
+#endif
+{
+    BACNET_ADDRESS src, dest, npdu_src;
+    BACNET_NPDU_DATA npdu_data;
+    BACNET_READ_PROPERTY_DATA data = { 0 };
+    BACNET_TIME remote_time;
+    int32_t offset_ms = 0;
+    uint8_t invoke_id;
+    unsigned sent;
+    int offset;
+    int len;
+
+    handler_timesync_init();
+    test_address(&src, 10);
+    handler_timesync_recipient_address_set(0, &src);
+    Test_Time_Sync_Interval = 60;
+    datetime_set_values(&Test_Local_Time, 2015, 6, 1, 12, 0, 0, 0);
+    /* a recipient without an estimate is synchronized and read */
+    Test_TimeSync_Count = 0;
+    sent = Datalink_Send_Count;
+    handler_timesync_task(&Test_Local_Time);
+    zassert_equal(Test_TimeSync_Count, 1, NULL);
+    zassert_equal(Datalink_Send_Count - sent, 1, NULL);
+    offset = bacnet_npdu_decode(Datalink_Send_PDU,
+        (uint16_t)Datalink_Send_PDU_Len, &dest, &npdu_src, &npdu_data);
+    zassert_true(offset > 0, NULL);
+    zassert_true(npdu_data.data_expecting_reply, NULL);
+    zassert_equal(
+        Datalink_Send_PDU[offset], PDU_TYPE_CONFIRMED_SERVICE_REQUEST, NULL);
+    zassert_equal(
+        Datalink_Send_PDU[offset + 3], SERVICE_CONFIRMED_READ_PROPERTY, NULL);
+    invoke_id = Datalink_Send_PDU[offset + 2];
+    zassert_not_equal(invoke_id, 0, NULL);
+    len = rp_decode_service_request(&Datalink_Send_PDU[offset + 4],
+        Datalink_Send_PDU_Len - offset - 4, &data);
+    zassert_true(len > 0, NULL);
+    zassert_equal(data.object_type, OBJECT_DEVICE, NULL);
+    zassert_equal(data.object_property, PROP_LOCAL_TIME, NULL);
+    zassert_false(handler_timesync_drift(0, &offset_ms, NULL), NULL);
+    /* an answer from another device does not complete it */
+    test_address(&npdu_src, 11);
+    datetime_set_time(&remote_time, 12, 0, 2, 0);
+    test_local_time_ack(&npdu_src, invoke_id, &remote_time);
+    zassert_false(handler_timesync_drift(0, &offset_ms, NULL), NULL);
+    /* the answer of the recipient is a sample, taken half
+       a round trip before it arrived */
+    tsm_timer_milliseconds(400);
+    datetime_set_time(&remote_time, 12, 0, 1, 0);
+    test_local_time_ack(&src, invoke_id, &remote_time);
+    zassert_true(handler_timesync_drift(0, &offset_ms, NULL), NULL);
+    zassert_equal(offset_ms, 1200, NULL);
+    zassert_true(tsm_invoke_id_free(invoke_id), NULL);
+    /* a later ReadProperty-ACK is not a sample */
+    datetime_set_time(&remote_time, 12, 0, 3, 0);
+    test_local_time_ack(&src, invoke_id, &remote_time);
+    zassert_true(handler_timesync_drift(0, &offset_ms, NULL), NULL);
+    zassert_equal(offset_ms, 1200, NULL);
+}
+
+/**
+ * @brief Unit Test for the broadcast that replaces the unicasts to
+ *  several recipients on one network
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(h_ts_tests, testTimeSyncBroadcast)
+#else
+static void testTimeSyncBroadcast(void)
+#endif
+{
+    BACNET_DATE_TIME sync_time;
+    BACNET_ADDRESS src;
+    unsigned i;
+
+    /* recipients on our own network get a local broadcast */
+    handler_timesync_init();
+    for (i = 0; i < 4; i++) {
+        test_address(&src, (uint8_t)(20 + i));
+        handler_timesync_recipient_address_set(i, &src);
+    }
+    Test_Time_Sync_Interval = 60;
+    datetime_set_values(&sync_time, 2015, 6, 2, 12, 0, 0, 0);
+    Test_TimeSync_Count = 0;
+    handler_timesync_task(&sync_time);
+    zassert_equal(Test_TimeSync_Count, 1, NULL);
+    zassert_equal(Test_TimeSync_Dest.net, 0, NULL);
+    zassert_equal(Test_TimeSync_Dest.mac_len, 1, NULL);
+    zassert_equal(Test_TimeSync_Dest.mac[0], 0xFF, NULL);
+    /* and on a remote network, a broadcast on that network */
+    handler_timesync_init();
+    for (i = 0; i < 4; i++) {
+        test_address(&src, (uint8_t)(20 + i));
+        src.net = 5;
+        src.len = 1;
+        src.adr[0] = (uint8_t)(20 + i);
+        handler_timesync_recipient_address_set(i, &src);
+    }
+    datetime_set_values(&sync_time, 2015, 6, 3, 12, 0, 0, 0);
+    Test_TimeSync_Count = 0;
+    handler_timesync_task(&sync_time);
+    zassert_equal(Test_TimeSync_Count, 1, NULL);
+    zassert_equal(Test_TimeSync_Dest.net, 5, NULL);
+}
+/**
+ * @}
+ */
+
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST_SUITE(h_ts_tests, NULL, NULL, NULL, NULL, NULL);
+#else
+void test_main(void)
+{
+    ztest_test_suite(h_ts_tests,
+     ztest_unit_test(testTimeSyncOffset),
+     ztest_unit_test(testTimeSyncDrift),
+     ztest_unit_test(testTimeSyncLocalTimeRequest),
+     ztest_unit_test(testTimeSyncBroadcast)
+     );
+
+    ztest_run_test_suite(h_ts_tests);
+}
+#endif
@@ -0,0 +1,102 @@
+/*
+ * SPDX-License-Identifier: MIT
+ */
+
+/* @file
+ * @brief stubs for the datalink, the device clock and the
+ *  TimeSynchronization service used by the time sync handler
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "bacnet/bacdef.h"
+#include "bacnet/datetime.h"
+#include "bacnet/npdu.h"
+#include "bacnet/datalink/datalink.h"
+#include "bacnet/basic/object/device.h"
+#include "bacnet/basic/service/s_ts.h"
+
+unsigned Datalink_Send_Count;
+uint8_t Datalink_Send_PDU[MAX_PDU];
+unsigned Datalink_Send_PDU_Len;
+
+/* the clock of this device */
+BACNET_DATE_TIME Test_Local_Time;
+uint32_t Test_Time_Sync_Interval;
+/* the TimeSynchronization requests sent */
+unsigned Test_TimeSync_Count;
+BACNET_ADDRESS Test_TimeSync_Dest;
+
+int datalink_send_pdu(BACNET_ADDRESS *dest,
+    BACNET_NPDU_DATA *npdu_data,
+    uint8_t *pdu,
+    unsigned pdu_len)
+{
+    unsigned i;
+
+    (void)dest;
+    (void)npdu_data;
+    Datalink_Send_Count++;
+    Datalink_Send_PDU_Len = 0;
+    for (i = 0; (i < pdu_len) && (i < MAX_PDU); i++) {
+        Datalink_Send_PDU[i] = pdu[i];
+        Datalink_Send_PDU_Len++;
+    }
+
+    return (int)pdu_len;
+}
+
+void datalink_get_my_address(BACNET_ADDRESS *my_address)
+{
+    unsigned i;
+
+    my_address->mac_len = 1;
+    my_address->mac[0] = 1;
+    my_address->net = 0;
+    my_address->len = 0;
+    for (i = 0; i < MAX_MAC_LEN; i++) {
+        my_address->adr[i] = 0;
+    }
+}
+
+void datalink_get_broadcast_address(BACNET_ADDRESS *dest)
+{
+    unsigned i;
+
+    dest->mac_len = 1;
+    dest->mac[0] = 0xFF;
+    dest->net = BACNET_BROADCAST_NETWORK;
+    dest->len = 0;
+    for (i = 0; i < MAX_MAC_LEN; i++) {
+        dest->adr[i] = 0;
+    }
+}
+
+void Device_getCurrentDateTime(BACNET_DATE_TIME *DateTime)
+{
+    datetime_copy(DateTime, &Test_Local_Time);
+}
+
+uint32_t Device_Time_Sync_Interval(void)
+{
+    return Test_Time_Sync_Interval;
+}
+
+bool Device_Align_Intervals(void)
+{
+    return false;
+}
+
+uint32_t Device_Interval_Offset(void)
+{
+    return 0;
+}
+
+void Send_TimeSync_Remote(
+    BACNET_ADDRESS *dest, BACNET_DATE *bdate, BACNET_TIME *btime)
+{
+    (void)bdate;
+    (void)btime;
+    Test_TimeSync_Count++;
+    Test_TimeSync_Dest = *dest;
+}
@@ -0,0 +1,425 @@
+/*
+ * SPDX-License-Identifier: MIT
+ */
+
+/* @file
+ * @brief test the queue of ConfirmedEventNotification requests
+ */
+
+#include <zephyr/ztest.h>
+#include <bacnet/apdu.h>
+#include <bacnet/bacdcode.h>
+#include <bacnet/dcc.h>
+#include <bacnet/event.h>
+#include <bacnet/npdu.h>
+#include <bacnet/basic/binding/address.h>
+#include <bacnet/basic/service/h_apdu.h>
+#include <bacnet/basic/service/s_cevent.h>
+#include <bacnet/basic/tsm/tsm.h>
+
+/**
+ * @addtogroup bacnet_tests
+ * @{
+ */
+
+extern unsigned Datalink_Send_Count;
+extern uint8_t Datalink_Send_PDU[MAX_PDU];
+extern unsigned Datalink_Send_PDU_Len;
+extern unsigned Test_WhoIs_Count;
+extern int32_t Test_WhoIs_Low_Limit;
+
+static void test_address(BACNET_ADDRESS *address, uint8_t mac)
+{
+    memset(address, 0, sizeof(*address));
+    address->mac_len = 1;
+    address->mac[0] = mac;
+}
+
+/**
+ * Fills in an acknowledgment notification of a Binary Input
+ *
+ * @param data - notification to fill in
+ * @param object_instance - instance of the event object
+ */
+static void test_notification(
+    BACNET_EVENT_NOTIFICATION_DATA *data, uint32_t object_instance)
+{
+    memset(data, 0, sizeof(*data));
+    data->processIdentifier = 1;
+    data->initiatingObjectIdentifier.type = OBJECT_DEVICE;
+    data->initiatingObjectIdentifier.instance = 1234;
+    data->eventObjectIdentifier.type = OBJECT_BINARY_INPUT;
+    data->eventObjectIdentifier.instance = object_instance;
+    data->timeStamp.tag = TIME_STAMP_SEQUENCE;
+    data->timeStamp.value.sequenceNum = 1;
+    data->notificationClass = 1;
+    data->priority = 100;
+    data->eventType = EVENT_CHANGE_OF_STATE;
+    data->notifyType = NOTIFY_ACK_NOTIFICATION;
+    data->toState = EVENT_STATE_NORMAL;
+}
+
+/**
+ * Gets the invoke ID of the last confirmed request sent
+ *
+ * @return invoke ID, or 0 if the last message was not a confirmed request
+ */
+static uint8_t test_sent_invoke_id(void)
+{
+    BACNET_ADDRESS dest, src;
+    BACNET_NPDU_DATA npdu_data;
+    int offset;
+
+    offset = bacnet_npdu_decode(Datalink_Send_PDU,
+        (uint16_t)Datalink_Send_PDU_Len, &dest, &src, &npdu_data);
+    if ((offset <= 0) || ((unsigned)(offset + 4) > Datalink_Send_PDU_Len) ||
+        (Datalink_Send_PDU[offset] != PDU_TYPE_CONFIRMED_SERVICE_REQUEST) ||
+        (Datalink_Send_PDU[offset + 3] !=
+            SERVICE_CONFIRMED_EVENT_NOTIFICATION)) {
+        return 0;
+    }
+
+    return Datalink_Send_PDU[offset + 2];
+}
+
+/**
+ * Sends a reply of the recipient to a notification
+ *
+ * @param src - address of the recipient
+ * @param pdu_type - SimpleACK, Error, Reject or Abort
+ * @param invoke_id - invoke ID of the notification
+ */
+static void test_reply(BACNET_ADDRESS *src, uint8_t pdu_type, uint8_t invoke_id)
+{
+    uint8_t apdu[8] = { 0 };
+    uint16_t apdu_len = 0;
+
+    apdu[apdu_len++] = pdu_type;
+    apdu[apdu_len++] = invoke_id;
+    if (pdu_type == PDU_TYPE_REJECT) {
+        apdu[apdu_len++] = REJECT_REASON_INVALID_TAG;
+    } else if (pdu_type == PDU_TYPE_ABORT) {
+        apdu[0] |= 1;
+        apdu[apdu_len++] = ABORT_REASON_OTHER;
+    } else {
+        apdu[apdu_len++] = SERVICE_CONFIRMED_EVENT_NOTIFICATION;
+    }
+    if (pdu_type == PDU_TYPE_ERROR) {
+        apdu_len += encode_application_enumerated(
+            &apdu[apdu_len], ERROR_CLASS_SERVICES);
+        apdu_len += encode_application_enumerated(
+            &apdu[apdu_len], ERROR_CODE_OTHER);
+    }
+    apdu_handler(src, apdu, apdu_len);
+}
+
+/**
+ * @brief Unit Test for notifications to a bound recipient: sent one at
+ *  a time, merged while waiting, and retried when the TSM gives up
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(s_cevent_tests, testCEventQueueSend)
+#else
+static void testCEventQueueSend(void)
+#endif
+{
+    BACNET_EVENT_NOTIFICATION_DATA data;
+    BACNET_CEVENT_QUEUE_METRICS metrics;
+    BACNET_ADDRESS dest;
+    uint8_t invoke_id;
+    unsigned sent;
+    unsigned i;
+
+    Send_CEvent_Queue_Init();
+    address_init();
+    test_address(&dest, 100);
+    address_add(100, MAX_APDU, &dest);
+    /* the first notification is sent right away */
+    sent = Datalink_Send_Count;
+    test_notification(&data, 1);
+    zassert_true(Send_CEvent_Notify_Queue(100, &data), NULL);
+    zassert_equal(Datalink_Send_Count - sent, 1, NULL);
+    invoke_id = test_sent_invoke_id();
+    zassert_not_equal(invoke_id, 0, NULL);
+    /* the next waits for the recipient to answer */
+    test_notification(&data, 2);
+    zassert_true(Send_CEvent_Notify_Queue(100, &data), NULL);
+    zassert_true(Send_CEvent_Notify_Queue(100, &data), NULL);
+    zassert_equal(Datalink_Send_Count - sent, 1, NULL);
+    Send_CEvent_Queue_Metrics(&metrics);
+    zassert_equal(metrics.depth, 2, NULL);
+    zassert_equal(metrics.in_flight, 1, NULL);
+    zassert_equal(metrics.enqueued, 3, NULL);
+    zassert_equal(metrics.merged, 1, NULL);
+    zassert_equal(metrics.sent, 1, NULL);
+    /* the answer confirms it, and the next is sent */
+    test_reply(&dest, PDU_TYPE_SIMPLE_ACK, invoke_id);
+    Send_CEvent_Queue_Task(0);
+    zassert_equal(Datalink_Send_Count - sent, 2, NULL);
+    invoke_id = test_sent_invoke_id();
+    zassert_not_equal(invoke_id, 0, NULL);
+    Send_CEvent_Queue_Metrics(&metrics);
+    zassert_equal(metrics.depth, 1, NULL);
+    zassert_equal(metrics.confirmed, 1, NULL);
+    zassert_equal(metrics.sent, 2, NULL);
+    /* a transaction that fails is sent again after a backoff */
+    for (i = 0; i <= apdu_retries(); i++) {
+        tsm_timer_milliseconds(apdu_timeout());
+    }
+    Send_CEvent_Queue_Task(0);
+    Send_CEvent_Queue_Metrics(&metrics);
+    zassert_equal(metrics.depth, 1, NULL);
+    zassert_equal(metrics.in_flight, 0, NULL);
+    zassert_equal(metrics.retries, 1, NULL);
+    sent = Datalink_Send_Count;
+    Send_CEvent_Queue_Task(BACNET_CEVENT_QUEUE_BACKOFF_MS - 1);
+    zassert_equal(Datalink_Send_Count, sent, NULL);
+    Send_CEvent_Queue_Task(1);
+    zassert_equal(Datalink_Send_Count - sent, 1, NULL);
+    zassert_not_equal(test_sent_invoke_id(), 0, NULL);
+    Send_CEvent_Queue_Metrics(&metrics);
+    zassert_equal(metrics.in_flight, 1, NULL);
+    zassert_equal(metrics.sent, 3, NULL);
+    test_reply(&dest, PDU_TYPE_SIMPLE_ACK, test_sent_invoke_id());
+    zassert_equal(Send_CEvent_Queue_Depth(), 0, NULL);
+    Send_CEvent_Queue_Metrics(&metrics);
+    zassert_equal(metrics.confirmed, 2, NULL);
+    zassert_equal(metrics.refused, 0, NULL);
+}
+
+/**
+ * @brief Unit Test for notifications that the recipient refuses with
+ *  an Error, Reject or Abort: not confirmed, but retried
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(s_cevent_tests, testCEventQueueRefused)
+#else
+static void testCEventQueueRefused(void)
+#endif
+{
+    const uint8_t pdu_type[] = { PDU_TYPE_ERROR, PDU_TYPE_REJECT,
+        PDU_TYPE_ABORT };
+    BACNET_EVENT_NOTIFICATION_DATA data;
+    BACNET_CEVENT_QUEUE_METRICS metrics;
+    BACNET_ADDRESS dest;
+    unsigned i;
+
+    Send_CEvent_Queue_Init();
+    address_init();
+    test_address(&dest, 100);
+    address_add(100, MAX_APDU, &dest);
+    test_notification(&data, 1);
+    zassert_true(Send_CEvent_Notify_Queue(100, &data), NULL);
+    for (i = 0; i < sizeof(pdu_type); i++) {
+        test_reply(&dest, pdu_type[i], test_sent_invoke_id());
+        Send_CEvent_Queue_Metrics(&metrics);
+        zassert_equal(metrics.confirmed, 0, NULL);
+        zassert_equal(metrics.refused, i + 1, NULL);
+        zassert_equal(metrics.retries, i + 1, NULL);
+        zassert_equal(metrics.in_flight, 0, NULL);
+        zassert_equal(metrics.depth, 1, NULL);
+        Send_CEvent_Queue_Task(BACNET_CEVENT_QUEUE_BACKOFF_MAX_MS);
+    }
+    test_reply(&dest, PDU_TYPE_SIMPLE_ACK, test_sent_invoke_id());
+    Send_CEvent_Queue_Metrics(&metrics);
+    zassert_equal(metrics.confirmed, 1, NULL);
+    zassert_equal(metrics.sent, 4, NULL);
+    zassert_equal(metrics.depth, 0, NULL);
+}
+
+/**
+ * @brief Unit Test for notifications that cannot be sent for a while:
+ *  held without using up their retries
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(s_cevent_tests, testCEventQueueHeld)
+#else
+static void testCEventQueueHeld(void)
+#endif
+{
+    BACNET_EVENT_NOTIFICATION_DATA data;
+    BACNET_CEVENT_QUEUE_METRICS metrics;
+    BACNET_ADDRESS dest;
+    unsigned sent;
+    unsigned i;
+
+    Send_CEvent_Queue_Init();
+    address_init();
+    test_address(&dest, 100);
+    address_add(100, MAX_APDU, &dest);
+    zassert_true(dcc_set_status_duration(COMMUNICATION_DISABLE, 0), NULL);
+    sent = Datalink_Send_Count;
+    test_notification(&data, 1);
+    zassert_true(Send_CEvent_Notify_Queue(100, &data), NULL);
+    for (i = 0; i < 2 * BACNET_CEVENT_QUEUE_RETRY_LIMIT; i++) {
+        Send_CEvent_Queue_Task(BACNET_CEVENT_QUEUE_BACKOFF_MAX_MS);
+    }
+    zassert_equal(Datalink_Send_Count, sent, NULL);
+    Send_CEvent_Queue_Metrics(&metrics);
+    zassert_equal(metrics.depth, 1, NULL);
+    zassert_equal(metrics.retries, 0, NULL);
+    zassert_equal(metrics.dropped, 0, NULL);
+    zassert_true(dcc_set_status_duration(COMMUNICATION_ENABLE, 0), NULL);
+    Send_CEvent_Queue_Task(0);
+    zassert_equal(Datalink_Send_Count - sent, 1, NULL);
+    test_reply(&dest, PDU_TYPE_SIMPLE_ACK, test_sent_invoke_id());
+    zassert_equal(Send_CEvent_Queue_Depth(), 0, NULL);
+}
+
+/**
+ * @brief Unit Test for a notification that exactly fills the APDU of
+ *  the recipient, and one that does not fit
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(s_cevent_tests, testCEventQueueFit)
+#else
+static void testCEventQueueFit(void)
+#endif
+{
+    BACNET_EVENT_NOTIFICATION_DATA data;
+    BACNET_CEVENT_QUEUE_METRICS metrics;
+    BACNET_ADDRESS dest;
+    uint8_t service_data[MAX_APDU];
+    unsigned max_apdu;
+    unsigned sent;
+
+    test_notification(&data, 1);
+    /* NPDU header and the confirmed request header */
+    max_apdu = 2 + 4 + event_notify_encode_service_request(service_data, &data);
+    Send_CEvent_Queue_Init();
+    address_init();
+    test_address(&dest, 100);
+    address_add(100, max_apdu, &dest);
+    sent = Datalink_Send_Count;
+    zassert_true(Send_CEvent_Notify_Queue(100, &data), NULL);
+    zassert_equal(Datalink_Send_Count - sent, 1, NULL);
+    zassert_equal(Datalink_Send_PDU_Len, max_apdu, NULL);
+    test_reply(&dest, PDU_TYPE_SIMPLE_ACK, test_sent_invoke_id());
+    zassert_equal(Send_CEvent_Queue_Depth(), 0, NULL);
+    /* one byte less will never fit */
+    address_init();
+    address_add(100, max_apdu - 1, &dest);
+    zassert_true(Send_CEvent_Notify_Queue(100, &data), NULL);
+    zassert_equal(Datalink_Send_Count - sent, 1, NULL);
+    zassert_equal(Send_CEvent_Queue_Depth(), 0, NULL);
+    Send_CEvent_Queue_Metrics(&metrics);
+    zassert_equal(metrics.dropped, 1, NULL);
+}
+
+/**
+ * @brief Unit Test for notifications to a recipient that is not bound:
+ *  a Who-Is finds it, and a recipient that is never found is dropped
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(s_cevent_tests, testCEventQueueUnbound)
+#else
+static void testCEventQueueUnbound(void)
+#endif
+{
+    BACNET_EVENT_NOTIFICATION_DATA data;
+    BACNET_CEVENT_QUEUE_METRICS metrics;
+    BACNET_ADDRESS dest;
+    unsigned sent;
+    unsigned i;
+
+    Send_CEvent_Queue_Init();
+    address_init();
+    /* the recipient is looked for */
+    Test_WhoIs_Count = 0;
+    sent = Datalink_Send_Count;
+    test_notification(&data, 1);
+    zassert_true(Send_CEvent_Notify_Queue(200, &data), NULL);
+    zassert_equal(Test_WhoIs_Count, 1, NULL);
+    zassert_equal(Test_WhoIs_Low_Limit, 200, NULL);
+    zassert_equal(Datalink_Send_Count, sent, NULL);
+    /* again after a backoff */
+    Send_CEvent_Queue_Task(BACNET_CEVENT_QUEUE_BACKOFF_MS - 1);
+    zassert_equal(Test_WhoIs_Count, 1, NULL);
+    Send_CEvent_Queue_Task(1);
+    zassert_equal(Test_WhoIs_Count, 2, NULL);
+    /* and the notification is sent once it is found */
+    test_address(&dest, 200);
+    address_add_binding(200, MAX_APDU, &dest);
+    Send_CEvent_Queue_Task(2 * BACNET_CEVENT_QUEUE_BACKOFF_MS);
+    zassert_equal(Test_WhoIs_Count, 2, NULL);
+    zassert_equal(Datalink_Send_Count - sent, 1, NULL);
+    zassert_not_equal(test_sent_invoke_id(), 0, NULL);
+    Send_CEvent_Queue_Metrics(&metrics);
+    zassert_equal(metrics.sent, 1, NULL);
+    zassert_equal(metrics.in_flight, 1, NULL);
+    zassert_equal(metrics.retries, 0, NULL);
+    test_reply(&dest, PDU_TYPE_SIMPLE_ACK, test_sent_invoke_id());
+    /* a recipient that is never found does not hold the queue */
+    Test_WhoIs_Count = 0;
+    zassert_true(Send_CEvent_Notify_Queue(300, &data), NULL);
+    zassert_equal(Send_CEvent_Queue_Depth(), 1, NULL);
+    for (i = 0; i < BACNET_CEVENT_QUEUE_BIND_LIMIT; i++) {
+        Send_CEvent_Queue_Task(BACNET_CEVENT_QUEUE_BACKOFF_MAX_MS);
+    }
+    zassert_equal(Test_WhoIs_Count, BACNET_CEVENT_QUEUE_BIND_LIMIT, NULL);
+    zassert_equal(Send_CEvent_Queue_Depth(), 0, NULL);
+    Send_CEvent_Queue_Metrics(&metrics);
+    zassert_equal(metrics.dropped, 1, NULL);
+    zassert_equal(metrics.retries, 0, NULL);
+    zassert_equal(metrics.confirmed, 1, NULL);
+}
+
+/**
+ * @brief Unit Test for a full queue
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(s_cevent_tests, testCEventQueueFull)
+#else
+static void testCEventQueueFull(void)
+#endif
+{
+    BACNET_EVENT_NOTIFICATION_DATA data;
+    BACNET_CEVENT_QUEUE_METRICS metrics;
+    BACNET_ADDRESS dest;
+    unsigned i;
+
+    Send_CEvent_Queue_Init();
+    address_init();
+    test_address(&dest, 100);
+    address_add(100, MAX_APDU, &dest);
+    for (i = 0; i < BACNET_CEVENT_QUEUE_SIZE; i++) {
+        test_notification(&data, i);
+        zassert_true(Send_CEvent_Notify_Queue(100, &data), NULL);
+    }
+    test_notification(&data, i);
+    zassert_false(Send_CEvent_Notify_Queue(100, &data), NULL);
+    Send_CEvent_Queue_Metrics(&metrics);
+    zassert_equal(metrics.depth, BACNET_CEVENT_QUEUE_SIZE, NULL);
+    zassert_equal(metrics.depth_max, BACNET_CEVENT_QUEUE_SIZE, NULL);
+    zassert_equal(metrics.in_flight, 1, NULL);
+    zassert_equal(metrics.dropped, 1, NULL);
+    /* the answers empty the queue in order */
+    for (i = 0; i < BACNET_CEVENT_QUEUE_SIZE; i++) {
+        test_reply(&dest, PDU_TYPE_SIMPLE_ACK, test_sent_invoke_id());
+        Send_CEvent_Queue_Task(0);
+    }
+    zassert_equal(Send_CEvent_Queue_Depth(), 0, NULL);
+    Send_CEvent_Queue_Metrics(&metrics);
+    zassert_equal(metrics.confirmed, BACNET_CEVENT_QUEUE_SIZE, NULL);
+}
+/**
+ * @}
+ */
+
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST_SUITE(s_cevent_tests, NULL, NULL, NULL, NULL, NULL);
+#else
+void test_main(void)
+{
+    ztest_test_suite(s_cevent_tests,
+     ztest_unit_test(testCEventQueueSend),
+     ztest_unit_test(testCEventQueueRefused),
+     ztest_unit_test(testCEventQueueHeld),
+     ztest_unit_test(testCEventQueueFit),
+     ztest_unit_test(testCEventQueueUnbound),
+     ztest_unit_test(testCEventQueueFull)
+     );
+
+    ztest_run_test_suite(s_cevent_tests);
+}
+#endif
@@ -0,0 +1,62 @@
+/*
+ * SPDX-License-Identifier: MIT
+ */
+
+/* @file
+ * @brief stubs for the datalink and the Who-Is used by the
+ *  ConfirmedEventNotification queue
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "bacnet/bacdef.h"
+#include "bacnet/npdu.h"
+#include "bacnet/datalink/datalink.h"
+#include "bacnet/basic/service/s_whois.h"
+
+unsigned Datalink_Send_Count;
+uint8_t Datalink_Send_PDU[MAX_PDU];
+unsigned Datalink_Send_PDU_Len;
+
+/* the Who-Is requests sent to find a device */
+unsigned Test_WhoIs_Count;
+int32_t Test_WhoIs_Low_Limit;
+
+int datalink_send_pdu(BACNET_ADDRESS *dest,
+    BACNET_NPDU_DATA *npdu_data,
+    uint8_t *pdu,
+    unsigned pdu_len)
+{
+    unsigned i;
+
+    (void)dest;
+    (void)npdu_data;
+    Datalink_Send_Count++;
+    Datalink_Send_PDU_Len = 0;
+    for (i = 0; (i < pdu_len) && (i < MAX_PDU); i++) {
+        Datalink_Send_PDU[i] = pdu[i];
+        Datalink_Send_PDU_Len++;
+    }
+
+    return (int)pdu_len;
+}
+
+void datalink_get_my_address(BACNET_ADDRESS *my_address)
+{
+    unsigned i;
+
+    my_address->mac_len = 1;
+    my_address->mac[0] = 1;
+    my_address->net = 0;
+    my_address->len = 0;
+    for (i = 0; i < MAX_MAC_LEN; i++) {
+        my_address->adr[i] = 0;
+    }
+}
+
+void Send_WhoIs(int32_t low_limit, int32_t high_limit)
+{
+    (void)high_limit;
+    Test_WhoIs_Count++;
+    Test_WhoIs_Low_Limit = low_limit;
+}
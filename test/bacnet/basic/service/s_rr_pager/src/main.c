@@ -0,0 +1,248 @@
+/*
+ * SPDX-License-Identifier: MIT
+ */
+
+/* @file
+ * @brief test reading a Trend Log buffer by sequence number with the pager
+ */
+
+#include <zephyr/ztest.h>
+#include <bacnet/apdu.h>
+#include <bacnet/bacdcode.h>
+#include <bacnet/datetime.h>
+#include <bacnet/readrange.h>
+#include <bacnet/basic/binding/address.h>
+#include <bacnet/basic/service/h_apdu.h>
+#include <bacnet/basic/service/s_rr_pager.h>
+#include <bacnet/basic/tsm/tsm.h>
+
+/**
+ * @addtogroup bacnet_tests
+ * @{
+ */
+
+#define TEST_DEVICE_A 1234
+
+extern unsigned Datalink_Send_Count;
+
+static void test_address(BACNET_ADDRESS *address, uint8_t mac)
+{
+    memset(address, 0, sizeof(*address));
+    address->mac_len = 1;
+    address->mac[0] = mac;
+}
+
+struct test_pager {
+    unsigned records;
+    uint32_t first_sequence[8];
+    unsigned parts;
+    unsigned done;
+    BACNET_TSM_RESULT result;
+    uint32_t next_sequence;
+};
+
+static void test_pager_records(void *context,
+    uint32_t device_id,
+    uint32_t first_sequence,
+    BACNET_LOG_RECORD_COLUMNS *columns)
+{
+    struct test_pager *test = context;
+
+    zassert_equal(device_id, TEST_DEVICE_A, NULL);
+    if (test->parts < 8) {
+        test->first_sequence[test->parts] = first_sequence;
+    }
+    test->parts++;
+    test->records += columns->count;
+}
+
+static void test_pager_done(void *context,
+    uint32_t device_id,
+    BACNET_TSM_RESULT result,
+    uint32_t next_sequence)
+{
+    struct test_pager *test = context;
+
+    zassert_equal(device_id, TEST_DEVICE_A, NULL);
+    test->done++;
+    test->result = result;
+    test->next_sequence = next_sequence;
+}
+
+/* replies to a page request with records first..first+count-1 */
+static void test_pager_reply(BACNET_ADDRESS *src,
+    uint8_t invoke_id,
+    uint32_t first,
+    uint32_t count,
+    bool last)
+{
+    uint8_t records[MAX_APDU] = { 0 };
+    uint8_t apdu[MAX_APDU] = { 0 };
+    BACNET_READ_RANGE_DATA rr_data = { 0 };
+    BACNET_DATE_TIME timestamp;
+    uint32_t i;
+    int len = 0;
+
+    datetime_set_values(&timestamp, 2023, 6, 1, 12, 0, 0, 0);
+    for (i = 0; i < count; i++) {
+        timestamp.time.min = (uint8_t)(first + i);
+        len += bacapp_encode_context_datetime(&records[len], 0, &timestamp);
+        len += encode_opening_tag(&records[len], 1);
+        len += encode_context_real(&records[len], 2, (float)(first + i));
+        len += encode_closing_tag(&records[len], 1);
+    }
+    rr_data.object_type = OBJECT_TRENDLOG;
+    rr_data.object_instance = 1;
+    rr_data.object_property = PROP_LOG_BUFFER;
+    rr_data.array_index = BACNET_ARRAY_ALL;
+    rr_data.RequestType = RR_BY_SEQUENCE;
+    rr_data.ItemCount = count;
+    rr_data.FirstSequence = first;
+    bitstring_init(&rr_data.ResultFlags);
+    bitstring_set_bit(&rr_data.ResultFlags, RESULT_FLAG_LAST_ITEM, last);
+    rr_data.application_data = records;
+    rr_data.application_data_len = len;
+    len = rr_ack_encode_apdu(apdu, invoke_id, &rr_data);
+    apdu_handler(src, apdu, (uint16_t)len);
+}
+
+/**
+ * @brief Unit Test for the ReadRange pager
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(rr_pager_tests, testReadRangePager)
+#else
+static void testReadRangePager(void)
+#endif
+{
+    struct test_pager test = { 0 };
+    RR_PAGER pager = { 0 };
+    BACNET_LOG_RECORD_COLUMNS columns = { 0 };
+    double value[3];
+    BACNET_ADDRESS address_a;
+    uint8_t invoke_id[2];
+    unsigned sent;
+
+    address_init();
+    test_address(&address_a, 10);
+    address_add(TEST_DEVICE_A, MAX_APDU, &address_a);
+    columns.size = 3;
+    columns.value = value;
+    pager.device_id = TEST_DEVICE_A;
+    pager.object_type = OBJECT_TRENDLOG;
+    pager.object_instance = 1;
+    pager.next_sequence = 1;
+    pager.page_records = 4;
+    pager.window = 2;
+    pager.columns = &columns;
+    pager.records_callback = test_pager_records;
+    pager.done_callback = test_pager_done;
+    pager.context = &test;
+    sent = Datalink_Send_Count;
+    zassert_true(rr_pager_start(&pager), NULL);
+    zassert_equal(Datalink_Send_Count - sent, 2, NULL);
+    zassert_equal(pager.next_sequence, 9, NULL);
+    invoke_id[0] = pager.invoke_id[0];
+    invoke_id[1] = pager.invoke_id[1];
+    /* the second page arrives first; the next page is sent at once,
+       and the records come in parts that fit the columns */
+    test_pager_reply(&address_a, invoke_id[1], 5, 4, false);
+    zassert_equal(Datalink_Send_Count - sent, 3, NULL);
+    zassert_equal(test.records, 4, NULL);
+    zassert_equal(test.parts, 2, NULL);
+    zassert_equal(test.first_sequence[0], 5, NULL);
+    zassert_equal(test.first_sequence[1], 8, NULL);
+    zassert_true(value[0] == 8.0, NULL);
+    /* the page from 9 holds the last record */
+    zassert_not_equal(pager.invoke_id[1], 0, NULL);
+    test_pager_reply(&address_a, pager.invoke_id[1], 9, 2, true);
+    zassert_equal(Datalink_Send_Count - sent, 3, NULL);
+    zassert_equal(test.done, 0, NULL);
+    /* the reading ends when the first page arrives */
+    test_pager_reply(&address_a, invoke_id[0], 1, 4, false);
+    zassert_equal(Datalink_Send_Count - sent, 3, NULL);
+    zassert_equal(test.records, 10, NULL);
+    zassert_equal(test.done, 1, NULL);
+    zassert_equal(test.result, TSM_RESULT_ACK, NULL);
+    zassert_equal(test.next_sequence, 11, NULL);
+    zassert_equal(pager.in_flight, 0, NULL);
+    /* a stopped pager cancels its pages */
+    memset(&test, 0, sizeof(test));
+    pager.next_sequence = 11;
+    zassert_true(rr_pager_start(&pager), NULL);
+    zassert_equal(pager.in_flight, 2, NULL);
+    invoke_id[0] = pager.invoke_id[0];
+    rr_pager_stop(&pager);
+    zassert_equal(test.done, 1, NULL);
+    zassert_equal(test.result, TSM_RESULT_ABORT, NULL);
+    zassert_equal(test.next_sequence, 11, NULL);
+    test_pager_reply(&address_a, invoke_id[0], 11, 4, false);
+    zassert_equal(test.records, 0, NULL);
+    zassert_true(tsm_transaction_available(), NULL);
+}
+
+/**
+ * @brief Unit Test for the ReadRange pager when an earlier page fails
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(rr_pager_tests, testReadRangePagerTimeout)
+#else
+static void testReadRangePagerTimeout(void)
+#endif
+{
+    struct test_pager test = { 0 };
+    RR_PAGER pager = { 0 };
+    BACNET_LOG_RECORD_COLUMNS columns = { 0 };
+    double value[4];
+    BACNET_ADDRESS address_a;
+    uint32_t elapsed = 0;
+
+    address_init();
+    test_address(&address_a, 10);
+    address_add(TEST_DEVICE_A, MAX_APDU, &address_a);
+    columns.size = 4;
+    columns.value = value;
+    pager.device_id = TEST_DEVICE_A;
+    pager.object_type = OBJECT_TRENDLOG;
+    pager.object_instance = 1;
+    pager.next_sequence = 1;
+    pager.page_records = 4;
+    pager.window = 2;
+    pager.columns = &columns;
+    pager.records_callback = test_pager_records;
+    pager.done_callback = test_pager_done;
+    pager.context = &test;
+    zassert_true(rr_pager_start(&pager), NULL);
+    /* the second page arrives while the first is lost */
+    test_pager_reply(&address_a, pager.invoke_id[1], 5, 4, false);
+    zassert_equal(test.records, 4, NULL);
+    zassert_equal(pager.in_flight, 2, NULL);
+    while ((test.done == 0) &&
+        (elapsed <= (uint32_t)apdu_timeout() * (apdu_retries() + 1UL))) {
+        tsm_timer_milliseconds(50);
+        elapsed += 50;
+    }
+    /* the reading resumes from the page that was lost */
+    zassert_equal(test.done, 1, NULL);
+    zassert_equal(test.result, TSM_RESULT_TIMEOUT, NULL);
+    zassert_equal(test.next_sequence, 1, NULL);
+    zassert_equal(pager.in_flight, 0, NULL);
+    zassert_true(tsm_transaction_available(), NULL);
+}
+/**
+ * @}
+ */
+
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST_SUITE(rr_pager_tests, NULL, NULL, NULL, NULL, NULL);
+#else
+void test_main(void)
+{
+    ztest_test_suite(rr_pager_tests,
+     ztest_unit_test(testReadRangePager),
+     ztest_unit_test(testReadRangePagerTimeout)
+     );
+
+    ztest_run_test_suite(rr_pager_tests);
+}
+#endif
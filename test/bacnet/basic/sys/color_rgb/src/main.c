@@ -96,6 +96,87 @@ static void test_color_rgb_ascii(void)
     }
 }
 
+/**
+ * Unit Test for the table driven and fixed point conversions
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(color_rgb_tests, test_color_rgb_fast)
+#else
+static void test_color_rgb_fast(void)
+#endif
+{
+    float x_coordinate, y_coordinate, test_x_coordinate, test_y_coordinate;
+    uint8_t brightness, test_brightness;
+    uint8_t red, green, blue, test_red, test_green, test_blue;
+    uint8_t rgb[3 * 3] = { 255, 255, 255, 0, 0, 255, 0, 0, 0 };
+    float x_batch[3], y_batch[3];
+    uint8_t brightness_batch[3];
+    uint8_t rgb_batch[3 * 3];
+    uint16_t kelvin_batch[3] = { 1000, 2700, 40000 };
+    unsigned r, g, b, kelvin;
+    float x, y;
+
+    /* sRGB to xy matches the reference */
+    for (r = 0; r < 256; r += 15) {
+        for (g = 0; g < 256; g += 15) {
+            for (b = 0; b < 256; b += 15) {
+                color_rgb_to_xy(r, g, b, &x_coordinate, &y_coordinate,
+                    &brightness);
+                color_rgb_to_xy_fast(r, g, b, &test_x_coordinate,
+                    &test_y_coordinate, &test_brightness);
+                zassert_within(x_coordinate, test_x_coordinate, 0.002f, NULL);
+                zassert_within(y_coordinate, test_y_coordinate, 0.002f, NULL);
+                zassert_within(brightness, test_brightness, 1, NULL);
+            }
+        }
+    }
+    /* xy to sRGB matches the reference */
+    for (x = 0.15f; x < 0.6f; x += 0.05f) {
+        for (y = 0.15f; y < 0.6f; y += 0.05f) {
+            for (brightness = 5; brightness < 250; brightness += 35) {
+                color_rgb_from_xy(&red, &green, &blue, x, y, brightness);
+                color_rgb_from_xy_fast(&test_red, &test_green, &test_blue, x,
+                    y, brightness);
+                zassert_within(red, test_red, 2, NULL);
+                zassert_within(green, test_green, 2, NULL);
+                zassert_within(blue, test_blue, 2, NULL);
+            }
+        }
+    }
+    color_rgb_from_xy_fast(&test_red, &test_green, &test_blue, 0.3f, 0.0f,
+        255);
+    zassert_equal(test_red + test_green + test_blue, 0, NULL);
+    /* color temperature matches the reference */
+    for (kelvin = 0; kelvin <= 65535; kelvin += 50) {
+        color_rgb_from_temperature(kelvin, &red, &green, &blue);
+        color_rgb_from_temperature_fast(
+            kelvin, &test_red, &test_green, &test_blue);
+        zassert_within(red, test_red, 1, NULL);
+        zassert_within(green, test_green, 1, NULL);
+        zassert_within(blue, test_blue, 1, NULL);
+    }
+    /* arrays of colors */
+    color_rgb_to_xy_batch(rgb, x_batch, y_batch, brightness_batch, 3);
+    zassert_equal(brightness_batch[0], 255, NULL);
+    color_rgb_to_xy(0, 0, 255, &x_coordinate, &y_coordinate, &brightness);
+    zassert_within(x_batch[1], x_coordinate, 0.002f, NULL);
+    zassert_within(y_batch[1], y_coordinate, 0.002f, NULL);
+    zassert_equal(brightness_batch[1], brightness, NULL);
+    zassert_equal(brightness_batch[2], 0, NULL);
+    color_rgb_from_xy_batch(rgb_batch, x_batch, y_batch, brightness_batch, 3);
+    color_rgb_from_xy(&red, &green, &blue, x_batch[1], y_batch[1],
+        brightness_batch[1]);
+    zassert_within(rgb_batch[3], red, 2, NULL);
+    zassert_within(rgb_batch[4], green, 2, NULL);
+    zassert_within(rgb_batch[5], blue, 2, NULL);
+    zassert_equal(rgb_batch[6] + rgb_batch[7] + rgb_batch[8], 0, NULL);
+    color_rgb_from_temperature_batch(rgb_batch, kelvin_batch, 3);
+    color_rgb_from_temperature(2700, &red, &green, &blue);
+    zassert_equal(rgb_batch[3], red, NULL);
+    zassert_equal(rgb_batch[4], green, NULL);
+    zassert_equal(rgb_batch[5], blue, NULL);
+}
+
 /**
  * @}
  */
@@ -108,7 +189,8 @@ void test_main(void)
 {
     ztest_test_suite(color_rgb_tests,
      ztest_unit_test(test_color_rgb_ascii),
-     ztest_unit_test(test_color_rgb_xy)
+     ztest_unit_test(test_color_rgb_xy),
+     ztest_unit_test(test_color_rgb_fast)
      );
 
     ztest_run_test_suite(color_rgb_tests);
@@ -0,0 +1,137 @@
+/*
+ * SPDX-License-Identifier: MIT
+ */
+
+/* @file
+ * @brief test lock-free multiple producer, single consumer ring buffer
+ */
+
+#include <zephyr/ztest.h>
+#include <bacnet/basic/sys/mpsc_ringbuf.h>
+
+/**
+ * @addtogroup bacnet_tests
+ * @{
+ */
+
+#define TEST_ELEMENT_SIZE 5
+#define TEST_ELEMENT_COUNT 8
+
+static unsigned Notify_Count;
+
+static void test_notify(void *context)
+{
+    zassert_equal(context, &Notify_Count, NULL);
+    Notify_Count++;
+}
+
+/**
+ * @brief Unit Test for the MPSC ring buffer
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(mpsc_ringbuf_tests, testMPSCRingBuffer)
+#else
+static void testMPSCRingBuffer(void)
+#endif
+{
+    MPSC_RING_BUFFER test_buffer = { 0 };
+    uint8_t data_store[TEST_ELEMENT_SIZE * TEST_ELEMENT_COUNT] = { 0 };
+    MPSC_RINGBUF_SEQUENCE_STORE(sequence_store, TEST_ELEMENT_COUNT);
+    uint8_t data_element[TEST_ELEMENT_SIZE] = { 0 };
+    uint8_t bulk_data[TEST_ELEMENT_SIZE * 3] = { 0 };
+    uint8_t *element = NULL;
+    unsigned ticket[TEST_ELEMENT_COUNT] = { 0 };
+    unsigned index = 0;
+    unsigned count = 0;
+    bool status = false;
+
+    status = MPSC_Ringbuf_Init(&test_buffer, data_store, sequence_store,
+        TEST_ELEMENT_SIZE, TEST_ELEMENT_COUNT - 1);
+    zassert_false(status, NULL);
+    status = MPSC_Ringbuf_Init(&test_buffer, data_store, sequence_store,
+        TEST_ELEMENT_SIZE, TEST_ELEMENT_COUNT);
+    zassert_true(status, NULL);
+    zassert_true(MPSC_Ringbuf_Empty(&test_buffer), NULL);
+    zassert_equal(MPSC_Ringbuf_Size(&test_buffer), TEST_ELEMENT_COUNT, NULL);
+    zassert_is_null(MPSC_Ringbuf_Peek(&test_buffer), NULL);
+    /* fill with copies */
+    for (index = 0; index < TEST_ELEMENT_COUNT; index++) {
+        memset(data_element, index, sizeof(data_element));
+        status = MPSC_Ringbuf_Put(&test_buffer, data_element);
+        zassert_true(status, NULL);
+        zassert_equal(MPSC_Ringbuf_Count(&test_buffer), index + 1, NULL);
+    }
+    status = MPSC_Ringbuf_Put(&test_buffer, data_element);
+    zassert_false(status, NULL);
+    for (index = 0; index < TEST_ELEMENT_COUNT; index++) {
+        element = MPSC_Ringbuf_Peek(&test_buffer);
+        zassert_not_null(element, NULL);
+        zassert_equal(element[0], index, NULL);
+        status = MPSC_Ringbuf_Pop(&test_buffer, data_element);
+        zassert_true(status, NULL);
+        zassert_equal(data_element[TEST_ELEMENT_SIZE - 1], index, NULL);
+    }
+    zassert_true(MPSC_Ringbuf_Empty(&test_buffer), NULL);
+    zassert_false(MPSC_Ringbuf_Pop(&test_buffer, NULL), NULL);
+    /* reserve in place, commit out of order: the consumer waits for
+       the oldest reservation */
+    for (index = 0; index < 3; index++) {
+        element = MPSC_Ringbuf_Data_Reserve(&test_buffer, &ticket[index]);
+        zassert_not_null(element, NULL);
+        memset(element, 0x10 + index, TEST_ELEMENT_SIZE);
+    }
+    MPSC_Ringbuf_Data_Commit(&test_buffer, ticket[2]);
+    MPSC_Ringbuf_Data_Commit(&test_buffer, ticket[1]);
+    zassert_true(MPSC_Ringbuf_Empty(&test_buffer), NULL);
+    zassert_equal(MPSC_Ringbuf_Count(&test_buffer), 3, NULL);
+    MPSC_Ringbuf_Data_Commit(&test_buffer, ticket[0]);
+    for (index = 0; index < 3; index++) {
+        status = MPSC_Ringbuf_Pop(&test_buffer, data_element);
+        zassert_true(status, NULL);
+        zassert_equal(data_element[0], 0x10 + index, NULL);
+    }
+    zassert_true(MPSC_Ringbuf_Empty(&test_buffer), NULL);
+    /* bulk put and pop across the end of the data store */
+    Notify_Count = 0;
+    MPSC_Ringbuf_Notify_Set(&test_buffer, test_notify, &Notify_Count);
+    for (index = 0; index < (TEST_ELEMENT_COUNT * 2); index++) {
+        memset(bulk_data, index, sizeof(bulk_data));
+        bulk_data[TEST_ELEMENT_SIZE] = 0xAA;
+        count = MPSC_Ringbuf_Put_Bulk(&test_buffer, bulk_data, 3);
+        zassert_equal(count, 3, NULL);
+        zassert_equal(Notify_Count, index + 1, NULL);
+        memset(bulk_data, 0, sizeof(bulk_data));
+        count = MPSC_Ringbuf_Pop_Bulk(&test_buffer, bulk_data, 8);
+        zassert_equal(count, 3, NULL);
+        zassert_equal(bulk_data[0], index, NULL);
+        zassert_equal(bulk_data[TEST_ELEMENT_SIZE], 0xAA, NULL);
+        zassert_equal(bulk_data[(TEST_ELEMENT_SIZE * 3) - 1], index, NULL);
+    }
+    /* bulk put is all or nothing */
+    for (index = 0; index < (TEST_ELEMENT_COUNT - 2); index++) {
+        zassert_true(MPSC_Ringbuf_Put(&test_buffer, data_element), NULL);
+    }
+    count = MPSC_Ringbuf_Put_Bulk(&test_buffer, bulk_data, 3);
+    zassert_equal(count, 0, NULL);
+    count = MPSC_Ringbuf_Put_Bulk(&test_buffer, bulk_data, 2);
+    zassert_equal(count, 2, NULL);
+    count = MPSC_Ringbuf_Pop_Bulk(&test_buffer, NULL, TEST_ELEMENT_COUNT * 2);
+    zassert_equal(count, TEST_ELEMENT_COUNT, NULL);
+    zassert_true(MPSC_Ringbuf_Empty(&test_buffer), NULL);
+}
+/**
+ * @}
+ */
+
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST_SUITE(mpsc_ringbuf_tests, NULL, NULL, NULL, NULL, NULL);
+#else
+void test_main(void)
+{
+    ztest_test_suite(mpsc_ringbuf_tests,
+     ztest_unit_test(testMPSCRingBuffer)
+     );
+
+    ztest_run_test_suite(mpsc_ringbuf_tests);
+}
+#endif
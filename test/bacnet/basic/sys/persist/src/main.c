@@ -0,0 +1,262 @@
+/*
+ * SPDX-License-Identifier: MIT
+ */
+
+/* @file
+ * @brief test persistent store of written property values
+ */
+
+#include <limits.h>
+#include <stdio.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <signal.h>
+#include <sys/resource.h>
+#endif
+#include <zephyr/ztest.h>
+#include <bacnet/basic/sys/mstimer.h>
+#include <bacnet/basic/sys/persist.h>
+
+/**
+ * @addtogroup bacnet_tests
+ * @{
+ */
+
+#define TEST_PATHNAME "test_persist"
+
+static unsigned long Milliseconds;
+
+unsigned long mstimer_now(void)
+{
+    return Milliseconds;
+}
+
+static unsigned Restore_Count;
+
+static void test_restore(
+    const PERSIST_KEY *key, const uint8_t *data, uint16_t length, void *context)
+{
+    PERSIST_KEY new_key = *key;
+
+    zassert_equal(context, &Restore_Count, NULL);
+    zassert_equal(key->object_type, OBJECT_ANALOG_OUTPUT, NULL);
+    zassert_true(length > 0, NULL);
+    /* a restored value that is stored again is not visited twice */
+    new_key.object_instance += 100;
+    zassert_true(Persist_Value_Set(&new_key, data, length), NULL);
+    Restore_Count++;
+}
+
+static long test_file_size(const char *pathname)
+{
+    FILE *file;
+    long size = -1;
+
+    file = fopen(pathname, "rb");
+    if (file) {
+        fseek(file, 0L, SEEK_END);
+        size = ftell(file);
+        fclose(file);
+    }
+
+    return size;
+}
+
+/**
+ * @brief Unit Test for the persistent store
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(persist_tests, testPersist)
+#else
+static void testPersist(void)
+#endif
+{
+    PERSIST_KEY key = { 0 };
+    uint8_t name[] = { 0x75, 0x06, 0x00, 'R', 'o', 'o', 'm', '1' };
+    uint8_t value[] = { 0x44, 0x42, 0x28, 0x00, 0x00 };
+    uint8_t data[16] = { 0 };
+    FILE *file;
+    unsigned i;
+    int len;
+
+    remove(TEST_PATHNAME ".snp");
+    remove(TEST_PATHNAME ".jnl");
+    /* properties */
+    zassert_false(
+        Persist_Property_Enabled(OBJECT_ANALOG_OUTPUT, PROP_PRESENT_VALUE),
+        NULL);
+    zassert_true(
+        Persist_Property_Register(OBJECT_ANALOG_OUTPUT, PROP_PRESENT_VALUE),
+        NULL);
+    zassert_true(
+        Persist_Property_Register(MAX_BACNET_OBJECT_TYPE, PROP_OBJECT_NAME),
+        NULL);
+    zassert_true(
+        Persist_Property_Enabled(OBJECT_ANALOG_OUTPUT, PROP_PRESENT_VALUE),
+        NULL);
+    zassert_false(
+        Persist_Property_Enabled(OBJECT_BINARY_OUTPUT, PROP_PRESENT_VALUE),
+        NULL);
+    zassert_true(
+        Persist_Property_Enabled(OBJECT_BINARY_OUTPUT, PROP_OBJECT_NAME), NULL);
+    /* an empty store */
+    zassert_true(Persist_Init(TEST_PATHNAME), NULL);
+    zassert_equal(Persist_Count(), 0, NULL);
+    zassert_true(test_file_size(TEST_PATHNAME ".snp") > 0, NULL);
+    /* values for each priority */
+    key.object_type = OBJECT_ANALOG_OUTPUT;
+    key.object_instance = 1;
+    key.object_property = PROP_PRESENT_VALUE;
+    key.array_index = BACNET_ARRAY_ALL;
+    for (i = 1; i <= BACNET_MAX_PRIORITY; i++) {
+        key.priority = (uint8_t)i;
+        value[1] = (uint8_t)i;
+        zassert_true(Persist_Value_Set(&key, value, sizeof(value)), NULL);
+    }
+    key.object_property = PROP_OBJECT_NAME;
+    key.priority = BACNET_NO_PRIORITY;
+    zassert_true(Persist_Value_Set(&key, name, sizeof(name)), NULL);
+    /* a longer value replaces the record */
+    name[1] = 0x07;
+    zassert_true(Persist_Value_Set(&key, name, sizeof(name)), NULL);
+    zassert_equal(Persist_Count(), BACNET_MAX_PRIORITY + 1, NULL);
+    len = Persist_Value_Get(&key, data, sizeof(data));
+    zassert_equal(len, sizeof(name), NULL);
+    zassert_mem_equal(data, name, sizeof(name), NULL);
+    zassert_equal(Persist_Value_Get(&key, data, 2), -1, NULL);
+    key.priority = 8;
+    key.object_property = PROP_PRESENT_VALUE;
+    zassert_true(Persist_Value_Delete(&key), NULL);
+    zassert_false(Persist_Value_Delete(&key), NULL);
+    zassert_equal(Persist_Value_Get(&key, data, sizeof(data)), -1, NULL);
+    zassert_equal(Persist_Count(), BACNET_MAX_PRIORITY, NULL);
+    /* write behind: nothing reaches the journal until the flush time */
+    Persist_Task();
+    zassert_equal(test_file_size(TEST_PATHNAME ".jnl"), 0, NULL);
+    zassert_true(Persist_Task_Remaining() <= PERSIST_FLUSH_MS, NULL);
+    Milliseconds += PERSIST_FLUSH_MS;
+    zassert_equal(Persist_Task_Remaining(), 0, NULL);
+    Persist_Task();
+    zassert_true(test_file_size(TEST_PATHNAME ".jnl") > 0, NULL);
+    zassert_equal(Persist_Task_Remaining(), ULONG_MAX, NULL);
+    /* restart: the journal is replayed over the snapshot */
+    Persist_Cleanup();
+    zassert_true(Persist_Init(TEST_PATHNAME), NULL);
+    zassert_equal(Persist_Count(), BACNET_MAX_PRIORITY, NULL);
+    zassert_equal(test_file_size(TEST_PATHNAME ".jnl"), 0, NULL);
+    key.priority = 16;
+    len = Persist_Value_Get(&key, data, sizeof(data));
+    zassert_equal(len, sizeof(value), NULL);
+    zassert_equal(data[1], 16, NULL);
+    zassert_equal(Persist_Value_Get(&key, NULL, 0), -1, NULL);
+    key.priority = 8;
+    zassert_equal(Persist_Value_Get(&key, data, sizeof(data)), -1, NULL);
+    /* restart after a power loss that tore the last journal record */
+    key.priority = 1;
+    value[1] = 0x55;
+    zassert_true(Persist_Value_Set(&key, value, sizeof(value)), NULL);
+    zassert_true(Persist_Flush(), NULL);
+    file = fopen(TEST_PATHNAME ".jnl", "ab");
+    zassert_not_null(file, NULL);
+    fwrite(name, 1, sizeof(name), file);
+    fclose(file);
+    zassert_true(Persist_Init(TEST_PATHNAME), NULL);
+    zassert_equal(Persist_Count(), BACNET_MAX_PRIORITY, NULL);
+    len = Persist_Value_Get(&key, data, sizeof(data));
+    zassert_equal(len, sizeof(value), NULL);
+    zassert_equal(data[1], 0x55, NULL);
+    /* restore visits each stored value once */
+    Restore_Count = 0;
+    zassert_equal(Persist_Restore(test_restore, &Restore_Count),
+        BACNET_MAX_PRIORITY, NULL);
+    zassert_equal(Restore_Count, BACNET_MAX_PRIORITY, NULL);
+    Persist_Cleanup();
+    remove(TEST_PATHNAME ".snp");
+    remove(TEST_PATHNAME ".jnl");
+}
+
+/**
+ * @brief Unit Test for a journal write cut short, here by a file size
+ *  limit: the torn record is dropped and written again by the next flush
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(persist_tests, testPersistShortWrite)
+#else
+static void testPersistShortWrite(void)
+#endif
+{
+#if defined(__unix__) || defined(__APPLE__)
+    PERSIST_KEY key = { 0 };
+    uint8_t value[] = { 0x44, 0x42, 0x28, 0x00, 0x00 };
+    uint8_t data[16] = { 0 };
+    struct rlimit limit, saved;
+    long size;
+    int len;
+
+    remove(TEST_PATHNAME ".snp");
+    remove(TEST_PATHNAME ".jnl");
+    zassert_true(
+        Persist_Property_Register(OBJECT_ANALOG_OUTPUT, PROP_PRESENT_VALUE),
+        NULL);
+    zassert_true(Persist_Init(TEST_PATHNAME), NULL);
+    key.object_type = OBJECT_ANALOG_OUTPUT;
+    key.object_instance = 1;
+    key.object_property = PROP_PRESENT_VALUE;
+    key.array_index = BACNET_ARRAY_ALL;
+    key.priority = 1;
+    value[1] = 1;
+    zassert_true(Persist_Value_Set(&key, value, sizeof(value)), NULL);
+    zassert_true(Persist_Flush(), NULL);
+    size = test_file_size(TEST_PATHNAME ".jnl");
+    zassert_true(size > 0, NULL);
+    /* the next record only partly fits */
+    signal(SIGXFSZ, SIG_IGN);
+    zassert_equal(getrlimit(RLIMIT_FSIZE, &saved), 0, NULL);
+    limit = saved;
+    limit.rlim_cur = (rlim_t)size + 8;
+    zassert_equal(setrlimit(RLIMIT_FSIZE, &limit), 0, NULL);
+    key.priority = 2;
+    value[1] = 2;
+    zassert_true(Persist_Value_Set(&key, value, sizeof(value)), NULL);
+    zassert_false(Persist_Flush(), NULL);
+    zassert_equal(setrlimit(RLIMIT_FSIZE, &saved), 0, NULL);
+    signal(SIGXFSZ, SIG_DFL);
+    zassert_equal(test_file_size(TEST_PATHNAME ".jnl"), size, NULL);
+    zassert_not_equal(Persist_Task_Remaining(), ULONG_MAX, NULL);
+    /* the next flush writes both values after the last whole record */
+    key.priority = 3;
+    value[1] = 3;
+    zassert_true(Persist_Value_Set(&key, value, sizeof(value)), NULL);
+    zassert_true(Persist_Flush(), NULL);
+    zassert_equal(Persist_Task_Remaining(), ULONG_MAX, NULL);
+    /* and the journal replays all of them */
+    Persist_Cleanup();
+    remove(TEST_PATHNAME ".snp");
+    zassert_true(Persist_Init(TEST_PATHNAME), NULL);
+    zassert_equal(Persist_Count(), 3, NULL);
+    for (key.priority = 1; key.priority <= 3; key.priority++) {
+        len = Persist_Value_Get(&key, data, sizeof(data));
+        zassert_equal(len, sizeof(value), NULL);
+        zassert_equal(data[1], key.priority, NULL);
+    }
+    Persist_Cleanup();
+    remove(TEST_PATHNAME ".snp");
+    remove(TEST_PATHNAME ".jnl");
+#endif
+}
+/**
+ * @}
+ */
+
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST_SUITE(persist_tests, NULL, NULL, NULL, NULL, NULL);
+#else
+void test_main(void)
+{
+    ztest_test_suite(persist_tests,
+     ztest_unit_test(testPersist),
+     ztest_unit_test(testPersistShortWrite)
+     );
+
+    ztest_run_test_suite(persist_tests);
+}
+#endif
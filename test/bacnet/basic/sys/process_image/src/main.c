@@ -0,0 +1,147 @@
+/*
+ * SPDX-License-Identifier: MIT
+ */
+
+/* @file
+ * @brief test shared memory process image
+ */
+
+#include <zephyr/ztest.h>
+#include <bacnet/basic/sys/process_image.h>
+
+/**
+ * @addtogroup bacnet_tests
+ * @{
+ */
+
+#define TEST_POINT_MAX 40
+
+static unsigned Change_Count;
+static PROCESS_IMAGE_VALUE Change_Value[TEST_POINT_MAX];
+
+static void test_change(const PROCESS_IMAGE_VALUE *value, void *context)
+{
+    zassert_equal(context, &Change_Count, NULL);
+    zassert_true(Change_Count < TEST_POINT_MAX, NULL);
+    Change_Value[Change_Count] = *value;
+    Change_Count++;
+}
+
+/**
+ * @brief Unit Test for the process image
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(process_image_tests, testProcessImage)
+#else
+static void testProcessImage(void)
+#endif
+{
+    static uint32_t memory[512];
+    PROCESS_IMAGE image = { 0 };
+    PROCESS_IMAGE attached = { 0 };
+    PROCESS_IMAGE_VALUE value = { 0 };
+    PROCESS_IMAGE_VALUE test_value = { 0 };
+    size_t size = 0;
+    unsigned count = 0;
+    int index = 0;
+    bool status = false;
+
+    size = Process_Image_Size(TEST_POINT_MAX);
+    zassert_true(size <= sizeof(memory), NULL);
+    status = Process_Image_Attach(&attached, memory, sizeof(memory));
+    zassert_false(status, NULL);
+    status = Process_Image_Format(&image, memory, size - 1, TEST_POINT_MAX);
+    zassert_false(status, NULL);
+    status = Process_Image_Format(&image, memory, size, TEST_POINT_MAX);
+    zassert_true(status, NULL);
+    zassert_equal(Process_Image_Point_Count(&image), 0, NULL);
+    /* points */
+    for (index = 0; index < TEST_POINT_MAX; index++) {
+        zassert_equal(Process_Image_Point_Add(&image, OBJECT_ANALOG_INPUT,
+                          (uint32_t)index * 1000),
+            index, NULL);
+    }
+    zassert_equal(
+        Process_Image_Point_Add(&image, OBJECT_ANALOG_INPUT, 5000), 5, NULL);
+    zassert_equal(
+        Process_Image_Point_Add(&image, OBJECT_BINARY_INPUT, 1), -1, NULL);
+    zassert_equal(Process_Image_Point_Count(&image), TEST_POINT_MAX, NULL);
+    zassert_equal(
+        Process_Image_Point_Index(&image, OBJECT_ANALOG_INPUT, 39000), 39,
+        NULL);
+    zassert_equal(
+        Process_Image_Point_Index(&image, OBJECT_ANALOG_VALUE, 39000), -1,
+        NULL);
+    /* another process attaches the same memory */
+    status = Process_Image_Attach(&attached, memory, size - 1);
+    zassert_false(status, NULL);
+    status = Process_Image_Attach(&attached, memory, size);
+    zassert_true(status, NULL);
+    index = Process_Image_Point_Index(&attached, OBJECT_ANALOG_INPUT, 33000);
+    zassert_equal(index, 33, NULL);
+    /* nothing changed yet */
+    Change_Count = 0;
+    count = Process_Image_Changes(&image, test_change, &Change_Count);
+    zassert_equal(count, 0, NULL);
+    /* writer updates through its handle */
+    value.tag = BACNET_APPLICATION_TAG_REAL;
+    value.status_flags = 1 << STATUS_FLAG_FAULT;
+    value.type.Real = 3.14159f;
+    zassert_true(Process_Image_Write(&attached, index, &value), NULL);
+    zassert_false(Process_Image_Write(&attached, TEST_POINT_MAX, &value), NULL);
+    value.tag = BACNET_APPLICATION_TAG_SIGNED_INT;
+    value.type.Signed_Int = -42;
+    zassert_true(Process_Image_Write(&attached, 2, &value), NULL);
+    value.tag = BACNET_APPLICATION_TAG_BOOLEAN;
+    value.status_flags = 0;
+    value.type.Boolean = true;
+    zassert_true(Process_Image_Write(&attached, 0, &value), NULL);
+    zassert_true(Process_Image_Write(&attached, 0, &value), NULL);
+    value.tag = BACNET_APPLICATION_TAG_OCTET_STRING;
+    zassert_false(Process_Image_Write(&attached, 1, &value), NULL);
+    /* reader sees each changed point once, in index order */
+    count = Process_Image_Changes(&image, test_change, &Change_Count);
+    zassert_equal(count, 3, NULL);
+    zassert_equal(Change_Count, 3, NULL);
+    zassert_equal(Change_Value[0].object_type, OBJECT_ANALOG_INPUT, NULL);
+    zassert_equal(Change_Value[0].object_instance, 0, NULL);
+    zassert_equal(Change_Value[0].tag, BACNET_APPLICATION_TAG_BOOLEAN, NULL);
+    zassert_true(Change_Value[0].type.Boolean, NULL);
+    zassert_equal(Change_Value[1].object_instance, 2000, NULL);
+    zassert_equal(Change_Value[1].type.Signed_Int, -42, NULL);
+    zassert_equal(Change_Value[2].object_instance, 33000, NULL);
+    zassert_equal(
+        Change_Value[2].status_flags, 1 << STATUS_FLAG_FAULT, NULL);
+    zassert_true(Change_Value[2].type.Real == 3.14159f, NULL);
+    count = Process_Image_Changes(&image, test_change, &Change_Count);
+    zassert_equal(count, 0, NULL);
+    /* the value stays readable without a change */
+    zassert_true(Process_Image_Read(&image, 33, &test_value), NULL);
+    zassert_true(test_value.type.Real == 3.14159f, NULL);
+    zassert_false(Process_Image_Read(&image, -1, &test_value), NULL);
+    /* a writer that died during an update does not block the next one */
+    memory[(size - sizeof(PROCESS_IMAGE_RECORD) * TEST_POINT_MAX) /
+        sizeof(uint32_t)] |= 1;
+    zassert_false(Process_Image_Read(&image, 0, &test_value), NULL);
+    value.tag = BACNET_APPLICATION_TAG_UNSIGNED_INT;
+    value.type.Unsigned_Int = 7;
+    zassert_true(Process_Image_Write(&attached, 0, &value), NULL);
+    zassert_true(Process_Image_Read(&image, 0, &test_value), NULL);
+    zassert_equal(test_value.type.Unsigned_Int, 7, NULL);
+}
+/**
+ * @}
+ */
+
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST_SUITE(process_image_tests, NULL, NULL, NULL, NULL, NULL);
+#else
+void test_main(void)
+{
+    ztest_test_suite(process_image_tests,
+     ztest_unit_test(testProcessImage)
+     );
+
+    ztest_run_test_suite(process_image_tests);
+}
+#endif
@@ -0,0 +1,178 @@
+/*
+ * SPDX-License-Identifier: MIT
+ */
+
+/* @file
+ * @brief test lock-free single producer, single consumer FIFO
+ */
+
+#include <zephyr/ztest.h>
+#include <bacnet/basic/sys/spsc_fifo.h>
+
+/**
+ * @addtogroup bacnet_tests
+ * @{
+ */
+
+static unsigned Notify_Count;
+
+static void test_notify(void *context)
+{
+    zassert_equal(context, &Notify_Count, NULL);
+    Notify_Count++;
+}
+
+/**
+ * @brief Unit Test for the byte operations of the SPSC FIFO
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(spsc_fifo_tests, testSPSCFIFOBytes)
+#else
+static void testSPSCFIFOBytes(void)
+#endif
+{
+    SPSC_FIFO test_buffer = { 0 };
+    uint8_t data_store[64] = { 0 };
+    uint8_t add_data[40] = { "RoseSteveLouPatRachelJessicaDaniAmyHerb" };
+    uint8_t test_add_data[40] = { 0 };
+    uint8_t test_data = 0;
+    unsigned index = 0;
+    unsigned count = 0;
+    bool status = false;
+
+    SPSC_FIFO_Init(&test_buffer, data_store, sizeof(data_store));
+    zassert_true(SPSC_FIFO_Empty(&test_buffer), NULL);
+    /* load the buffer */
+    for (test_data = 0; test_data < sizeof(data_store); test_data++) {
+        zassert_false(SPSC_FIFO_Full(&test_buffer), NULL);
+        zassert_true(SPSC_FIFO_Available(&test_buffer, 1), NULL);
+        status = SPSC_FIFO_Put(&test_buffer, test_data);
+        zassert_true(status, NULL);
+        zassert_false(SPSC_FIFO_Empty(&test_buffer), NULL);
+    }
+    zassert_true(SPSC_FIFO_Full(&test_buffer), NULL);
+    status = SPSC_FIFO_Put(&test_buffer, 42);
+    zassert_false(status, NULL);
+    /* unload the buffer */
+    for (index = 0; index < sizeof(data_store); index++) {
+        test_data = SPSC_FIFO_Get(&test_buffer);
+        zassert_equal(test_data, index, NULL);
+    }
+    zassert_true(SPSC_FIFO_Empty(&test_buffer), NULL);
+    zassert_equal(SPSC_FIFO_Get(&test_buffer), 0, NULL);
+    /* bulk add and pull across the end of the data store */
+    for (index = 0; index < sizeof(data_store); index++) {
+        status = SPSC_FIFO_Add(&test_buffer, add_data, sizeof(add_data));
+        zassert_true(status, NULL);
+        zassert_false(
+            SPSC_FIFO_Add(&test_buffer, add_data, sizeof(add_data)), NULL);
+        count = SPSC_FIFO_Count(&test_buffer);
+        zassert_equal(count, sizeof(add_data), NULL);
+        memset(test_add_data, 0, sizeof(test_add_data));
+        count = SPSC_FIFO_Pull(
+            &test_buffer, test_add_data, sizeof(test_add_data));
+        zassert_equal(count, sizeof(test_add_data), NULL);
+        zassert_mem_equal(test_add_data, add_data, sizeof(add_data), NULL);
+        zassert_true(SPSC_FIFO_Empty(&test_buffer), NULL);
+        /* move the indexes so the next span wraps differently */
+        zassert_true(SPSC_FIFO_Put(&test_buffer, 1), NULL);
+        zassert_equal(SPSC_FIFO_Pull(&test_buffer, NULL, 1), 1, NULL);
+    }
+    /* partial pull */
+    status = SPSC_FIFO_Add(&test_buffer, add_data, 4);
+    zassert_true(status, NULL);
+    count = SPSC_FIFO_Pull(&test_buffer, test_add_data, sizeof(test_add_data));
+    zassert_equal(count, 4, NULL);
+    /* flush */
+    status = SPSC_FIFO_Add(&test_buffer, add_data, sizeof(add_data));
+    zassert_true(status, NULL);
+    SPSC_FIFO_Flush(&test_buffer);
+    zassert_true(SPSC_FIFO_Empty(&test_buffer), NULL);
+    /* notify hook */
+    Notify_Count = 0;
+    SPSC_FIFO_Notify_Set(&test_buffer, test_notify, &Notify_Count);
+    status = SPSC_FIFO_Add(&test_buffer, add_data, sizeof(add_data));
+    zassert_true(status, NULL);
+    status = SPSC_FIFO_Put(&test_buffer, 1);
+    zassert_true(status, NULL);
+    zassert_equal(Notify_Count, 2, NULL);
+    status = SPSC_FIFO_Add(&test_buffer, add_data, sizeof(add_data));
+    zassert_false(status, NULL);
+    zassert_equal(Notify_Count, 2, NULL);
+}
+
+/**
+ * @brief Unit Test for the packet operations of the SPSC FIFO
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(spsc_fifo_tests, testSPSCFIFOPackets)
+#else
+static void testSPSCFIFOPackets(void)
+#endif
+{
+    SPSC_FIFO test_buffer = { 0 };
+    uint8_t data_store[64] = { 0 };
+    uint8_t packet[30] = { "RoseSteveLouPatRachelJessica" };
+    uint8_t test_packet[30] = { 0 };
+    uint16_t length = 0;
+    unsigned index = 0;
+    bool status = false;
+
+    SPSC_FIFO_Init(&test_buffer, data_store, sizeof(data_store));
+    /* two packets and their headers fit, a third does not */
+    status = SPSC_FIFO_Packet_Add(&test_buffer, packet, sizeof(packet));
+    zassert_true(status, NULL);
+    status = SPSC_FIFO_Packet_Add(&test_buffer, packet, 10);
+    zassert_true(status, NULL);
+    status = SPSC_FIFO_Packet_Add(&test_buffer, packet, sizeof(packet));
+    zassert_false(status, NULL);
+    status = SPSC_FIFO_Packet_Add(&test_buffer, packet, 0);
+    zassert_false(status, NULL);
+    length =
+        SPSC_FIFO_Packet_Pull(&test_buffer, test_packet, sizeof(test_packet));
+    zassert_equal(length, sizeof(packet), NULL);
+    zassert_mem_equal(test_packet, packet, sizeof(packet), NULL);
+    length =
+        SPSC_FIFO_Packet_Pull(&test_buffer, test_packet, sizeof(test_packet));
+    zassert_equal(length, 10, NULL);
+    zassert_mem_equal(test_packet, packet, 10, NULL);
+    length =
+        SPSC_FIFO_Packet_Pull(&test_buffer, test_packet, sizeof(test_packet));
+    zassert_equal(length, 0, NULL);
+    /* packets that wrap around the data store */
+    for (index = 0; index < sizeof(data_store); index++) {
+        status = SPSC_FIFO_Packet_Add(&test_buffer, packet, 1 + (index % 29));
+        zassert_true(status, NULL);
+        length = SPSC_FIFO_Packet_Pull(
+            &test_buffer, test_packet, sizeof(test_packet));
+        zassert_equal(length, 1 + (index % 29), NULL);
+        zassert_mem_equal(test_packet, packet, length, NULL);
+    }
+    /* a packet too big for the buffer is discarded */
+    status = SPSC_FIFO_Packet_Add(&test_buffer, packet, sizeof(packet));
+    zassert_true(status, NULL);
+    status = SPSC_FIFO_Packet_Add(&test_buffer, packet, 5);
+    zassert_true(status, NULL);
+    length = SPSC_FIFO_Packet_Pull(&test_buffer, test_packet, 10);
+    zassert_equal(length, 0, NULL);
+    length = SPSC_FIFO_Packet_Pull(&test_buffer, test_packet, 10);
+    zassert_equal(length, 5, NULL);
+    zassert_true(SPSC_FIFO_Empty(&test_buffer), NULL);
+}
+/**
+ * @}
+ */
+
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST_SUITE(spsc_fifo_tests, NULL, NULL, NULL, NULL, NULL);
+#else
+void test_main(void)
+{
+    ztest_test_suite(spsc_fifo_tests,
+     ztest_unit_test(testSPSCFIFOBytes),
+     ztest_unit_test(testSPSCFIFOPackets)
+     );
+
+    ztest_run_test_suite(spsc_fifo_tests);
+}
+#endif
@@ -0,0 +1,381 @@
+/*
+ * SPDX-License-Identifier: MIT
+ */
+
+/* @file
+ * @brief test transaction state machine requests with completion callbacks
+ */
+
+#include <zephyr/ztest.h>
+#include <bacnet/abort.h>
+#include <bacnet/apdu.h>
+#include <bacnet/bacdcode.h>
+#include <bacnet/bacreal.h>
+#include <bacnet/bacerror.h>
+#include <bacnet/reject.h>
+#include <bacnet/datalink/datalink.h>
+#include <bacnet/basic/binding/address.h>
+#include <bacnet/basic/service/h_apdu.h>
+#include <bacnet/basic/service/s_async.h>
+#include <bacnet/basic/tsm/tsm.h>
+
+/**
+ * @addtogroup bacnet_tests
+ * @{
+ */
+
+#define TEST_DEVICE_A 1234
+#define TEST_DEVICE_B 5678
+
+extern unsigned Datalink_Send_Count;
+extern uint8_t Datalink_Send_PDU[MAX_PDU];
+extern unsigned Datalink_Send_PDU_Len;
+
+struct test_reply {
+    unsigned count;
+    uint32_t device_id;
+    BACNET_TSM_RESULT result;
+    uint8_t invoke_id;
+    BACNET_ERROR_CLASS error_class;
+    BACNET_ERROR_CODE error_code;
+    uint8_t reason;
+    bool decoded;
+    BACNET_READ_PROPERTY_DATA rp_data;
+};
+
+static void test_rp_callback(void *context,
+    uint32_t device_id,
+    BACNET_TSM_COMPLETION *completion,
+    BACNET_READ_PROPERTY_DATA *rp_data)
+{
+    struct test_reply *reply = context;
+
+    reply->count++;
+    reply->device_id = device_id;
+    reply->result = completion->result;
+    reply->invoke_id = completion->invoke_id;
+    reply->reason = completion->reason;
+    reply->decoded = false;
+    if (rp_data) {
+        reply->decoded = true;
+        reply->rp_data = *rp_data;
+    }
+}
+
+static void test_wp_callback(
+    void *context, uint32_t device_id, BACNET_TSM_COMPLETION *completion)
+{
+    struct test_reply *reply = context;
+
+    reply->count++;
+    reply->device_id = device_id;
+    reply->result = completion->result;
+    reply->invoke_id = completion->invoke_id;
+    reply->error_class = completion->error_class;
+    reply->error_code = completion->error_code;
+}
+
+static void test_address(BACNET_ADDRESS *address, uint8_t mac)
+{
+    memset(address, 0, sizeof(*address));
+    address->mac_len = 1;
+    address->mac[0] = mac;
+}
+
+/**
+ * @brief Unit Test for requests with completion callbacks
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(tsm_tests, testAsyncRequests)
+#else
+static void testAsyncRequests(void)
+#endif
+{
+    static struct test_reply replies[MAX_TSM_TRANSACTIONS];
+    struct test_reply reply = { 0 };
+    BACNET_ADDRESS address_a, address_b;
+    BACNET_READ_PROPERTY_DATA rp_data = { 0 };
+    BACNET_WRITE_PROPERTY_DATA wp_data = { 0 };
+    uint8_t apdu[MAX_APDU];
+    uint8_t invoke_id, invoke_id_b, legacy_id;
+    unsigned i, count;
+    int len;
+
+    address_init();
+    test_address(&address_a, 10);
+    test_address(&address_b, 20);
+    /* requests need a bound device */
+    invoke_id = bacnet_rp_async(TEST_DEVICE_A, OBJECT_ANALOG_INPUT, 1,
+        PROP_PRESENT_VALUE, BACNET_ARRAY_ALL, test_rp_callback, &reply);
+    zassert_equal(invoke_id, 0, NULL);
+    address_add(TEST_DEVICE_A, MAX_APDU, &address_a);
+    address_add(TEST_DEVICE_B, MAX_APDU, &address_b);
+    /* ReadProperty-ACK goes to the callback of its request */
+    invoke_id = bacnet_rp_async(TEST_DEVICE_A, OBJECT_ANALOG_INPUT, 1,
+        PROP_PRESENT_VALUE, BACNET_ARRAY_ALL, test_rp_callback, &reply);
+    zassert_not_equal(invoke_id, 0, NULL);
+    zassert_equal(Datalink_Send_Count, 1, NULL);
+    rp_data.object_type = OBJECT_ANALOG_INPUT;
+    rp_data.object_instance = 1;
+    rp_data.object_property = PROP_PRESENT_VALUE;
+    rp_data.array_index = BACNET_ARRAY_ALL;
+    rp_data.application_data = apdu;
+    rp_data.application_data_len = encode_application_real(apdu, 21.5f);
+    {
+        uint8_t ack[MAX_APDU];
+
+        len = rp_ack_encode_apdu(ack, invoke_id, &rp_data);
+        /* a reply from another device is not for this request */
+        apdu_handler(&address_b, ack, (uint16_t)len);
+        zassert_equal(reply.count, 0, NULL);
+        apdu_handler(&address_a, ack, (uint16_t)len);
+        zassert_equal(reply.count, 1, NULL);
+        /* a second copy of the reply finds no request */
+        apdu_handler(&address_a, ack, (uint16_t)len);
+        zassert_equal(reply.count, 1, NULL);
+    }
+    zassert_equal(reply.device_id, TEST_DEVICE_A, NULL);
+    zassert_equal(reply.result, TSM_RESULT_ACK, NULL);
+    zassert_equal(reply.invoke_id, invoke_id, NULL);
+    zassert_true(reply.decoded, NULL);
+    zassert_equal(reply.rp_data.object_type, OBJECT_ANALOG_INPUT, NULL);
+    zassert_equal(reply.rp_data.object_property, PROP_PRESENT_VALUE, NULL);
+    zassert_true(tsm_invoke_id_free(invoke_id), NULL);
+    /* WriteProperty Error */
+    memset(&reply, 0, sizeof(reply));
+    wp_data.object_type = OBJECT_ANALOG_OUTPUT;
+    wp_data.object_instance = 1;
+    wp_data.object_property = PROP_PRESENT_VALUE;
+    wp_data.array_index = BACNET_ARRAY_ALL;
+    wp_data.priority = 8;
+    wp_data.application_data_len =
+        encode_application_real(wp_data.application_data, 1.0f);
+    invoke_id = bacnet_wp_async(TEST_DEVICE_B, &wp_data, test_wp_callback,
+        &reply);
+    zassert_not_equal(invoke_id, 0, NULL);
+    len = bacerror_encode_apdu(apdu, invoke_id,
+        SERVICE_CONFIRMED_WRITE_PROPERTY, ERROR_CLASS_PROPERTY,
+        ERROR_CODE_WRITE_ACCESS_DENIED);
+    apdu_handler(&address_b, apdu, (uint16_t)len);
+    zassert_equal(reply.count, 1, NULL);
+    zassert_equal(reply.device_id, TEST_DEVICE_B, NULL);
+    zassert_equal(reply.result, TSM_RESULT_ERROR, NULL);
+    zassert_equal(reply.error_class, ERROR_CLASS_PROPERTY, NULL);
+    zassert_equal(reply.error_code, ERROR_CODE_WRITE_ACCESS_DENIED, NULL);
+    /* a segmented ComplexACK aborts the request, and the server too */
+    memset(&reply, 0, sizeof(reply));
+    invoke_id = bacnet_rp_async(TEST_DEVICE_A, OBJECT_ANALOG_INPUT, 1,
+        PROP_PRESENT_VALUE, BACNET_ARRAY_ALL, test_rp_callback, &reply);
+    zassert_not_equal(invoke_id, 0, NULL);
+    len = 0;
+    apdu[len++] = PDU_TYPE_COMPLEX_ACK | BIT(3) | BIT(2);
+    apdu[len++] = invoke_id;
+    apdu[len++] = 0;
+    apdu[len++] = 1;
+    apdu[len++] = SERVICE_CONFIRMED_READ_PROPERTY;
+    len += encode_context_object_id(
+        &apdu[len], 0, OBJECT_ANALOG_INPUT, 1);
+    count = Datalink_Send_Count;
+    apdu_handler(&address_a, apdu, (uint16_t)len);
+    zassert_equal(reply.count, 1, NULL);
+    zassert_equal(reply.result, TSM_RESULT_ABORT, NULL);
+    zassert_equal(reply.reason, ABORT_REASON_SEGMENTATION_NOT_SUPPORTED, NULL);
+    zassert_false(reply.decoded, NULL);
+    zassert_true(tsm_invoke_id_free(invoke_id), NULL);
+    zassert_equal(Datalink_Send_Count, count + 1, NULL);
+    len = Datalink_Send_PDU_Len;
+    zassert_equal(Datalink_Send_PDU[len - 3], PDU_TYPE_ABORT, NULL);
+    zassert_equal(Datalink_Send_PDU[len - 2], invoke_id, NULL);
+    zassert_equal(Datalink_Send_PDU[len - 1],
+        ABORT_REASON_SEGMENTATION_NOT_SUPPORTED, NULL);
+    /* invoke IDs are scoped to the peer: 255 requests to each device */
+    count = 0;
+    for (i = 0; i < MAX_TSM_TRANSACTIONS; i++) {
+        memset(&replies[i], 0, sizeof(replies[i]));
+        invoke_id = bacnet_rp_async((i & 1) ? TEST_DEVICE_B : TEST_DEVICE_A,
+            OBJECT_ANALOG_INPUT, i, PROP_PRESENT_VALUE, BACNET_ARRAY_ALL,
+            test_rp_callback, &replies[i]);
+        if (invoke_id) {
+            replies[i].invoke_id = invoke_id;
+            count++;
+        }
+    }
+    zassert_equal(count, 2 * 255, NULL);
+    /* the same invoke ID is in flight to both devices */
+    invoke_id = replies[0].invoke_id;
+    for (i = 1; i < count; i += 2) {
+        if (replies[i].invoke_id == invoke_id) {
+            break;
+        }
+    }
+    zassert_true(i < count, NULL);
+    len = reject_encode_apdu(apdu, invoke_id, REJECT_REASON_OTHER);
+    apdu_handler(&address_b, apdu, (uint16_t)len);
+    zassert_equal(replies[i].count, 1, NULL);
+    zassert_equal(replies[i].result, TSM_RESULT_REJECT, NULL);
+    zassert_equal(replies[i].reason, REJECT_REASON_OTHER, NULL);
+    zassert_equal(replies[0].count, 0, NULL);
+    len = abort_encode_apdu(
+        apdu, invoke_id, ABORT_REASON_OUT_OF_RESOURCES, true);
+    apdu_handler(&address_a, apdu, (uint16_t)len);
+    zassert_equal(replies[0].count, 1, NULL);
+    zassert_equal(replies[0].result, TSM_RESULT_ABORT, NULL);
+    zassert_equal(replies[0].reason, ABORT_REASON_OUT_OF_RESOURCES, NULL);
+    /* a legacy invoke ID is unique among all the transactions */
+    legacy_id = tsm_next_free_invokeID();
+    zassert_equal(legacy_id, invoke_id, NULL);
+    tsm_free_invoke_id(legacy_id);
+    /* cancel: the callback is not called */
+    invoke_id_b = replies[3].invoke_id;
+    zassert_true(bacnet_async_cancel(TEST_DEVICE_B, invoke_id_b), NULL);
+    zassert_false(bacnet_async_cancel(TEST_DEVICE_B, invoke_id_b), NULL);
+    len = reject_encode_apdu(apdu, invoke_id_b, REJECT_REASON_OTHER);
+    apdu_handler(&address_b, apdu, (uint16_t)len);
+    zassert_equal(replies[3].count, 0, NULL);
+    /* the next retry is due after the request timeout of the peer,
+       which its quick replies brought down to the minimum */
+    zassert_equal(tsm_peer_timeout(&address_a), TSM_RTO_MIN, NULL);
+    zassert_equal(tsm_timer_milliseconds_remaining(), TSM_RTO_MIN, NULL);
+    tsm_timer_milliseconds(100);
+    zassert_equal(
+        tsm_timer_milliseconds_remaining(), TSM_RTO_MIN - 100, NULL);
+    tsm_timer_milliseconds(TSM_RTO_MIN - 100);
+    /* each retry waits twice as long */
+    zassert_equal(tsm_timer_milliseconds_remaining(), 2 * TSM_RTO_MIN, NULL);
+    /* the rest time out after the retries */
+    for (i = 0; i < apdu_retries(); i++) {
+        tsm_timer_milliseconds(UINT16_MAX);
+    }
+    zassert_equal(tsm_timer_milliseconds_remaining(), UINT16_MAX, NULL);
+    for (i = 0; i < MAX_TSM_TRANSACTIONS; i++) {
+        if ((i == 0) || (i == 3) || (replies[i].invoke_id == 0)) {
+            continue;
+        }
+        if (replies[i].invoke_id == invoke_id && (i & 1)) {
+            zassert_equal(replies[i].result, TSM_RESULT_REJECT, NULL);
+            continue;
+        }
+        zassert_equal(replies[i].count, 1, NULL);
+        zassert_equal(replies[i].result, TSM_RESULT_TIMEOUT, NULL);
+    }
+    zassert_equal(tsm_transaction_idle_count(), UINT8_MAX, NULL);
+    zassert_true(tsm_transaction_available(), NULL);
+}
+
+/**
+ * @brief Unit Test for the request timeout of each peer
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(tsm_tests, testPeerRoundTripTime)
+#else
+static void testPeerRoundTripTime(void)
+#endif
+{
+    BACNET_ADDRESS address_c, address_d;
+    BACNET_NPDU_DATA npdu_data;
+    uint8_t pdu[8] = { 0 };
+    uint16_t srtt = 0, rttvar = 0, rto = 0;
+    uint8_t invoke_id;
+    uint32_t elapsed;
+    unsigned sent;
+
+    test_address(&address_c, 30);
+    npdu_encode_npdu_data(&npdu_data, true, MESSAGE_PRIORITY_NORMAL);
+    tsm_timer_milliseconds(10);
+    /* a peer without replies uses the APDU timeout */
+    zassert_false(tsm_peer_rtt(&address_c, NULL, NULL, NULL), NULL);
+    zassert_equal(tsm_peer_timeout(&address_c), apdu_timeout(), NULL);
+    /* the first reply, after 400ms */
+    invoke_id = tsm_next_free_invokeID();
+    zassert_not_equal(invoke_id, 0, NULL);
+    tsm_set_confirmed_unsegmented_transaction(
+        invoke_id, &address_c, &npdu_data, pdu, sizeof(pdu));
+    zassert_equal(tsm_timer_milliseconds_remaining(), apdu_timeout(), NULL);
+    tsm_timer_milliseconds(400);
+    tsm_free_invoke_id(invoke_id);
+    zassert_true(tsm_peer_rtt(&address_c, &srtt, &rttvar, &rto), NULL);
+    zassert_equal(srtt, 400, NULL);
+    zassert_equal(rttvar, 200, NULL);
+    zassert_equal(rto, 400 + 4 * 200, NULL);
+    zassert_equal(tsm_peer_timeout(&address_c), rto, NULL);
+    /* the next reply, after 800ms, is smoothed into the estimates */
+    invoke_id = tsm_next_free_invokeID();
+    tsm_set_confirmed_unsegmented_transaction(
+        invoke_id, &address_c, &npdu_data, pdu, sizeof(pdu));
+    zassert_equal(tsm_timer_milliseconds_remaining(), 1200, NULL);
+    tsm_timer_milliseconds(400);
+    tsm_timer_milliseconds(400);
+    tsm_free_invoke_id(invoke_id);
+    zassert_true(tsm_peer_rtt(&address_c, &srtt, &rttvar, &rto), NULL);
+    zassert_equal(srtt, (7 * 400 + 800) / 8, NULL);
+    zassert_equal(rttvar, (3 * 200 + 400) / 4, NULL);
+    zassert_equal(rto, 450 + 4 * 250, NULL);
+    /* a reply to a request that was sent again is not a sample */
+    invoke_id = tsm_next_free_invokeID();
+    tsm_set_confirmed_unsegmented_transaction(
+        invoke_id, &address_c, &npdu_data, pdu, sizeof(pdu));
+    sent = Datalink_Send_Count;
+    while (Datalink_Send_Count == sent) {
+        tsm_timer_milliseconds(250);
+    }
+    zassert_equal(tsm_timer_milliseconds_remaining(), 2 * 1450, NULL);
+    tsm_free_invoke_id(invoke_id);
+    zassert_true(tsm_peer_rtt(&address_c, &srtt, NULL, &rto), NULL);
+    zassert_equal(srtt, 450, NULL);
+    zassert_equal(rto, 1450, NULL);
+    /* a request that times out doubles the timeout of the peer, and
+       all its tries take no longer than with the APDU timeout */
+    invoke_id = tsm_next_free_invokeID();
+    tsm_set_confirmed_unsegmented_transaction(
+        invoke_id, &address_c, &npdu_data, pdu, sizeof(pdu));
+    sent = Datalink_Send_Count;
+    elapsed = 0;
+    while (!tsm_invoke_id_failed(invoke_id)) {
+        tsm_timer_milliseconds(50);
+        elapsed += 50;
+    }
+    zassert_equal(Datalink_Send_Count - sent, apdu_retries(), NULL);
+    zassert_true(
+        elapsed <= (uint32_t)apdu_timeout() * (apdu_retries() + 1UL), NULL);
+    tsm_free_invoke_id(invoke_id);
+    zassert_true(tsm_peer_rtt(&address_c, &srtt, NULL, &rto), NULL);
+    zassert_equal(srtt, 450, NULL);
+    zassert_equal(rto, 2 * 1450, NULL);
+    zassert_equal(tsm_timer_milliseconds_remaining(), UINT16_MAX, NULL);
+    /* a peer without replies is retried every APDU timeout */
+    test_address(&address_d, 40);
+    invoke_id = tsm_next_free_invokeID();
+    tsm_set_confirmed_unsegmented_transaction(
+        invoke_id, &address_d, &npdu_data, pdu, sizeof(pdu));
+    sent = Datalink_Send_Count;
+    elapsed = 0;
+    while (!tsm_invoke_id_failed(invoke_id)) {
+        zassert_equal(tsm_timer_milliseconds_remaining(),
+            apdu_timeout() - (elapsed % apdu_timeout()), NULL);
+        tsm_timer_milliseconds(50);
+        elapsed += 50;
+    }
+    zassert_equal(Datalink_Send_Count - sent, apdu_retries(), NULL);
+    zassert_equal(
+        elapsed, (uint32_t)apdu_timeout() * (apdu_retries() + 1UL), NULL);
+    tsm_free_invoke_id(invoke_id);
+    zassert_false(tsm_peer_rtt(&address_d, NULL, NULL, NULL), NULL);
+}
+
+/**
+ * @}
+ */
+
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST_SUITE(tsm_tests, NULL, NULL, NULL, NULL, NULL);
+#else
+void test_main(void)
+{
+    ztest_test_suite(tsm_tests,
+     ztest_unit_test(testAsyncRequests),
+     ztest_unit_test(testPeerRoundTripTime)
+     );
+
+    ztest_run_test_suite(tsm_tests);
+}
+#endif
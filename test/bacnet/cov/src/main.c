@@ -8,6 +8,7 @@
  * @brief test BACnet integer encode/decode APIs
  */
 
+#include <string.h>
 #include <zephyr/ztest.h>
 // #include <bacnet/bacapp.h>
 #include <bacnet/cov.h>
@@ -236,6 +237,64 @@ static void testCOVNotify(void)
     testCCOVNotifyData(invoke_id, &data);
 }
 
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(cov_tests, testCOVNotifyValues)
+#else
+static void testCOVNotifyValues(void)
+#endif
+{
+    uint8_t invoke_id = 12;
+    uint8_t apdu[480] = { 0 };
+    uint8_t test_apdu[480] = { 0 };
+    uint8_t values[480] = { 0 };
+    int values_len = 0;
+    int len = 0;
+    int test_len = 0;
+    BACNET_COV_DATA data;
+    BACNET_PROPERTY_VALUE value_list[2] = { { 0 } };
+
+    data.subscriberProcessIdentifier = 1;
+    data.initiatingDeviceIdentifier = 123;
+    data.monitoredObjectIdentifier.type = OBJECT_ANALOG_INPUT;
+    data.monitoredObjectIdentifier.instance = 321;
+    data.timeRemaining = 456;
+    cov_data_value_list_link(&data, &value_list[0], 2);
+    value_list[0].propertyIdentifier = PROP_PRESENT_VALUE;
+    value_list[0].propertyArrayIndex = BACNET_ARRAY_ALL;
+    bacapp_parse_application_data(
+        BACNET_APPLICATION_TAG_REAL, "21.0", &value_list[0].value);
+    value_list[1].propertyIdentifier = PROP_STATUS_FLAGS;
+    value_list[1].propertyArrayIndex = BACNET_ARRAY_ALL;
+    bacapp_parse_application_data(
+        BACNET_APPLICATION_TAG_BIT_STRING, "0000", &value_list[1].value);
+    values_len = cov_notify_value_list_encode(NULL, &value_list[0]);
+    zassert_true(values_len > 0, NULL);
+    zassert_equal(
+        cov_notify_value_list_encode(&values[0], &value_list[0]), values_len,
+        NULL);
+    /* the same list is shared by subscriptions that differ in header */
+    for (data.subscriberProcessIdentifier = 1;
+         data.subscriberProcessIdentifier < 1000;
+         data.subscriberProcessIdentifier *= 7) {
+        len = ucov_notify_encode_apdu(&apdu[0], sizeof(apdu), &data);
+        test_len = ucov_notify_encode_apdu_values(&test_apdu[0],
+            sizeof(test_apdu), &data, &values[0], values_len);
+        zassert_true(len > 0, NULL);
+        zassert_equal(len, test_len, NULL);
+        zassert_equal(memcmp(apdu, test_apdu, len), 0, NULL);
+        len = ccov_notify_encode_apdu(&apdu[0], sizeof(apdu), invoke_id, &data);
+        test_len = ccov_notify_encode_apdu_values(&test_apdu[0],
+            sizeof(test_apdu), invoke_id, &data, &values[0], values_len);
+        zassert_true(len > 0, NULL);
+        zassert_equal(len, test_len, NULL);
+        zassert_equal(memcmp(apdu, test_apdu, len), 0, NULL);
+    }
+    /* too small for the list */
+    test_len = ucov_notify_encode_apdu_values(
+        &test_apdu[0], values_len, &data, &values[0], values_len);
+    zassert_equal(test_len, 0, NULL);
+}
+
 static void testCOVSubscribeData(
     BACNET_SUBSCRIBE_COV_DATA *data, BACNET_SUBSCRIBE_COV_DATA *test_data)
 {
@@ -373,6 +432,7 @@ ZTEST_SUITE(cov_tests, NULL, NULL, NULL, NULL, NULL);
 void test_main(void)
 {
     ztest_test_suite(cov_tests, ztest_unit_test(testCOVNotify),
+        ztest_unit_test(testCOVNotifyValues),
         ztest_unit_test(testCOVSubscribe),
         ztest_unit_test(testCOVSubscribeProperty));
 
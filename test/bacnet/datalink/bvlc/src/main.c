@@ -137,10 +137,16 @@ static void test_BVLC_Original_Unicast_NPDU_Message(
     uint16_t length = 0;
     int len = 0, msg_len = 0, test_len = 0;
     uint16_t i = 0;
+    uint8_t header[BVLC_NPDU_HEADER_MAX] = { 0 };
 
     len = bvlc_encode_original_unicast(pdu, sizeof(pdu), npdu, npdu_len);
     msg_len = 4 + npdu_len;
     zassert_equal(len, msg_len, NULL);
+    /* the header alone matches the front of the whole message */
+    test_len = bvlc_encode_original_unicast_header(
+        header, sizeof(header), npdu_len);
+    zassert_equal(test_len, 4, NULL);
+    zassert_mem_equal(header, pdu, test_len, NULL);
     test_len = test_BVLC_Header(pdu, len, &message_type, &length);
     zassert_equal(test_len, 4, NULL);
     zassert_equal(message_type, BVLC_ORIGINAL_UNICAST_NPDU, NULL);
@@ -184,10 +190,16 @@ static void test_BVLC_Original_Broadcast_NPDU_Message(
     uint16_t length = 0;
     int len = 0, msg_len = 0, test_len = 0;
     uint16_t i = 0;
+    uint8_t header[BVLC_NPDU_HEADER_MAX] = { 0 };
 
     len = bvlc_encode_original_broadcast(pdu, sizeof(pdu), npdu, npdu_len);
     msg_len = 4 + npdu_len;
     zassert_equal(len, msg_len, NULL);
+    /* the header alone matches the front of the whole message */
+    test_len = bvlc_encode_original_broadcast_header(
+        header, sizeof(header), npdu_len);
+    zassert_equal(test_len, 4, NULL);
+    zassert_mem_equal(header, pdu, test_len, NULL);
     test_len = test_BVLC_Header(pdu, len, &message_type, &length);
     zassert_equal(test_len, 4, NULL);
     zassert_equal(message_type, BVLC_ORIGINAL_BROADCAST_NPDU, NULL);
@@ -234,11 +246,17 @@ static void test_BVLC_Forwarded_NPDU_Message(
     uint16_t length = 0;
     int len = 0, msg_len = 0, test_len = 0;
     uint16_t i = 0;
+    uint8_t header[BVLC_NPDU_HEADER_MAX] = { 0 };
 
     len = bvlc_encode_forwarded_npdu(
         pdu, sizeof(pdu), bip_address, npdu, npdu_len);
     msg_len = 1 + 1 + 2 + BIP_ADDRESS_MAX + npdu_len;
     zassert_equal(len, msg_len, NULL);
+    /* the header alone matches the front of the whole message */
+    test_len = bvlc_encode_forwarded_npdu_header(
+        header, sizeof(header), bip_address, npdu_len);
+    zassert_equal(test_len, BVLC_NPDU_HEADER_MAX, NULL);
+    zassert_mem_equal(header, pdu, test_len, NULL);
     test_len = test_BVLC_Header(pdu, len, &message_type, &length);
     zassert_equal(test_len, 4, NULL);
     zassert_equal(message_type, BVLC_FORWARDED_NPDU, NULL);
@@ -441,11 +459,17 @@ static void test_BVLC_Distribute_Broadcast_To_Network_Message(
     uint16_t length = 0;
     int len = 0, msg_len = 0, test_len = 0;
     uint16_t i = 0;
+    uint8_t header[BVLC_NPDU_HEADER_MAX] = { 0 };
 
     len = bvlc_encode_distribute_broadcast_to_network(
         pdu, sizeof(pdu), npdu, npdu_len);
     msg_len = 4 + npdu_len;
     zassert_equal(len, msg_len, NULL);
+    /* the header alone matches the front of the whole message */
+    test_len = bvlc_encode_distribute_broadcast_to_network_header(
+        header, sizeof(header), npdu_len);
+    zassert_equal(test_len, 4, NULL);
+    zassert_mem_equal(header, pdu, test_len, NULL);
     test_len = test_BVLC_Header(pdu, len, &message_type, &length);
     zassert_equal(test_len, 4, NULL);
     zassert_equal(message_type, BVLC_DISTRIBUTE_BROADCAST_TO_NETWORK, NULL);
@@ -62,6 +62,18 @@ int bip_send_mpdu(BACNET_IP_ADDRESS *dest, uint8_t *mtu, uint16_t mtu_len)
     return ztest_get_return_value();
 }
 
+int bip_send_mpdu_iov(BACNET_IP_ADDRESS *dest,
+    uint8_t *header,
+    uint16_t header_len,
+    uint8_t *npdu,
+    uint16_t npdu_len)
+{
+    ztest_check_expected_value(dest);
+    ztest_check_expected_data(header, header_len);
+    ztest_check_expected_data(npdu, npdu_len);
+    return ztest_get_return_value();
+}
+
 uint16_t bip_receive(BACNET_ADDRESS *src, uint8_t *pdu, uint16_t max_pdu,
         unsigned timeout)
 {
@@ -39,3 +39,11 @@ int bip_send_pdu(
 {
     return 0;
 }
+
+void bip_get_my_address(
+    BACNET_ADDRESS * my_address)
+{
+    my_address->mac_len = 0;
+    my_address->net = 0;
+    my_address->len = 0;
+}
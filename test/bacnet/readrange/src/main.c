@@ -0,0 +1,174 @@
+/*
+ * SPDX-License-Identifier: MIT
+ */
+
+/* @file
+ * @brief test ReadRange encoding and decoding of log records
+ */
+
+#include <zephyr/ztest.h>
+#include <bacnet/bacdcode.h>
+#include <bacnet/bacreal.h>
+#include <bacnet/datetime.h>
+#include <bacnet/readrange.h>
+
+/**
+ * @addtogroup bacnet_tests
+ * @{
+ */
+
+/* encodes a BACnetLogRecord with a REAL or ENUMERATED logDatum */
+static int test_log_record_encode(uint8_t *apdu,
+    BACNET_DATE_TIME *timestamp,
+    uint8_t datum_type,
+    uint32_t datum,
+    int status_flags)
+{
+    BACNET_BIT_STRING bit_string;
+    int len = 0;
+
+    len += bacapp_encode_context_datetime(&apdu[len], 0, timestamp);
+    len += encode_opening_tag(&apdu[len], 1);
+    switch (datum_type) {
+        case 2:
+            len += encode_context_real(&apdu[len], 2, (float)datum);
+            break;
+        case 3:
+            len += encode_context_enumerated(&apdu[len], 3, datum);
+            break;
+        case 7:
+            len += encode_context_null(&apdu[len], 7);
+            break;
+        case 8:
+            len += encode_opening_tag(&apdu[len], 8);
+            len += encode_application_enumerated(&apdu[len], 2);
+            len += encode_application_enumerated(&apdu[len], datum);
+            len += encode_closing_tag(&apdu[len], 8);
+            break;
+        default:
+            break;
+    }
+    len += encode_closing_tag(&apdu[len], 1);
+    if (status_flags >= 0) {
+        bitstring_init(&bit_string);
+        bitstring_set_bits_used(&bit_string, 1, 4);
+        bitstring_set_octet(&bit_string, 0, (uint8_t)status_flags);
+        len += encode_context_bitstring(&apdu[len], 2, &bit_string);
+    }
+
+    return len;
+}
+
+/**
+ * @brief Unit Test for the columnar decoding of log records
+ */
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST(readrange_tests, testLogRecordsDecode)
+#else
+static void testLogRecordsDecode(void)
+#endif
+{
+    uint8_t apdu[MAX_APDU] = { 0 };
+    uint8_t ack[MAX_APDU + 32] = { 0 };
+    BACNET_READ_RANGE_DATA rr_data = { 0 };
+    BACNET_READ_RANGE_DATA rr_ack = { 0 };
+    BACNET_DATE_TIME timestamp;
+    BACNET_LOG_RECORD_COLUMNS columns = { 0 };
+    bacnet_time_t seconds[4];
+    uint8_t type[4];
+    double value[4];
+    uint8_t status_flags[4];
+    int len = 0, test_len = 0, ack_len = 0;
+    bacnet_time_t epoch;
+
+    datetime_set_values(&timestamp, 2023, 6, 1, 12, 0, 0, 0);
+    epoch = datetime_seconds_since_epoch(&timestamp);
+    len += test_log_record_encode(&apdu[len], &timestamp, 2, 21, -1);
+    timestamp.time.min = 15;
+    len += test_log_record_encode(&apdu[len], &timestamp, 3, 7, 0x02);
+    timestamp.time.min = 30;
+    len += test_log_record_encode(&apdu[len], &timestamp, 8, 31, -1);
+    timestamp.time.min = 45;
+    len += test_log_record_encode(&apdu[len], &timestamp, 7, 0, 0x0F);
+    /* the records travel inside a ReadRange-ACK */
+    rr_data.object_type = OBJECT_TRENDLOG;
+    rr_data.object_instance = 1;
+    rr_data.object_property = PROP_LOG_BUFFER;
+    rr_data.array_index = BACNET_ARRAY_ALL;
+    rr_data.RequestType = RR_BY_SEQUENCE;
+    rr_data.ItemCount = 4;
+    rr_data.FirstSequence = 100;
+    bitstring_init(&rr_data.ResultFlags);
+    bitstring_set_bit(&rr_data.ResultFlags, RESULT_FLAG_LAST_ITEM, true);
+    rr_data.application_data = apdu;
+    rr_data.application_data_len = len;
+    ack_len = rr_ack_encode_apdu(ack, 1, &rr_data);
+    zassert_true(ack_len > 3, NULL);
+    test_len = rr_ack_decode_service_request(&ack[3], ack_len - 3, &rr_ack);
+    zassert_equal(test_len, ack_len - 3, NULL);
+    zassert_equal(rr_ack.ItemCount, 4, NULL);
+    zassert_equal(rr_ack.FirstSequence, 100, NULL);
+    zassert_equal(rr_ack.application_data_len, len, NULL);
+    /* all of the columns */
+    columns.size = 4;
+    columns.timestamp = seconds;
+    columns.type = type;
+    columns.value = value;
+    columns.status_flags = status_flags;
+    test_len = rr_log_records_decode(
+        rr_ack.application_data, rr_ack.application_data_len, &columns);
+    zassert_equal(test_len, len, NULL);
+    zassert_equal(columns.count, 4, NULL);
+    zassert_equal(seconds[0], epoch, NULL);
+    zassert_equal(seconds[3], epoch + 45 * 60, NULL);
+    zassert_equal(type[0], 2, NULL);
+    zassert_equal(type[1], 3, NULL);
+    zassert_equal(type[2], 8, NULL);
+    zassert_equal(type[3], 7, NULL);
+    zassert_true(value[0] == 21.0, NULL);
+    zassert_true(value[1] == 7.0, NULL);
+    zassert_true(value[2] == 31.0, NULL);
+    zassert_true(value[3] == 0.0, NULL);
+    zassert_equal(status_flags[0], 0, NULL);
+    zassert_equal(status_flags[1], 0x82, NULL);
+    zassert_equal(status_flags[3], 0x8F, NULL);
+    /* only some columns, and a part of the records at a time */
+    columns.count = 0;
+    columns.size = 3;
+    columns.timestamp = NULL;
+    columns.status_flags = NULL;
+    test_len = rr_log_records_decode(apdu, len, &columns);
+    zassert_true(test_len > 0, NULL);
+    zassert_true(test_len < len, NULL);
+    zassert_equal(columns.count, 3, NULL);
+    columns.count = 0;
+    test_len += rr_log_records_decode(&apdu[test_len], len - test_len,
+        &columns);
+    zassert_equal(test_len, len, NULL);
+    zassert_equal(columns.count, 1, NULL);
+    zassert_equal(type[0], 7, NULL);
+    /* truncated records are malformed */
+    columns.count = 0;
+    columns.size = 4;
+    test_len = rr_log_records_decode(apdu, len - 1, &columns);
+    zassert_equal(test_len, -1, NULL);
+    test_len = rr_log_records_decode(apdu, 11, &columns);
+    zassert_equal(test_len, -1, NULL);
+    zassert_equal(rr_log_records_decode(NULL, len, &columns), -1, NULL);
+}
+/**
+ * @}
+ */
+
+#if defined(CONFIG_ZTEST_NEW_API)
+ZTEST_SUITE(readrange_tests, NULL, NULL, NULL, NULL, NULL);
+#else
+void test_main(void)
+{
+    ztest_test_suite(readrange_tests,
+     ztest_unit_test(testLogRecordsDecode)
+     );
+
+    ztest_run_test_suite(readrange_tests);
+}
+#endif